@@ -0,0 +1,117 @@
+// Copyright Vampire Game Project. All Rights Reserved.
+// Custom scripting system for secure modding support.
+
+#include "ScriptBatchCompiler.h"
+#include "ScriptLexer.h"
+#include "ScriptParser.h"
+#include "ScriptCompiler.h"
+#include "ScriptLinker.h"
+#include "Async/ParallelFor.h"
+#include <atomic>
+
+FScriptBatchCompiler::FScriptBatchCompiler()
+    : ModuleCache(nullptr)
+    , NumWorkers(0)
+    , bInliningEnabled(true)
+    , bOptimizationEnabled(false)
+    , bRegisterCodeEnabled(false)
+{
+}
+
+int32 FScriptBatchCompiler::GetNumWorkers() const
+{
+    return NumWorkers > 0 ? NumWorkers : FPlatformMisc::NumberOfCoresIncludingHyperthreads();
+}
+
+int32 FScriptBatchCompiler::Compile(TArray<FScriptBatchJob>& Jobs) const
+{
+    // Jobs vary a lot in size, so workers pull them one at a time rather than take a
+    // fixed share each
+    const int32 Workers = FMath::Clamp(GetNumWorkers(), 1, FMath::Max(Jobs.Num(), 1));
+    std::atomic<int32> NextJob(0);
+    ParallelFor(Workers, [&](int32 /*Worker*/) {
+        for (int32 Index = NextJob++; Index < Jobs.Num(); Index = NextJob++)
+        {
+            CompileJob(Jobs[Index]);
+        }
+    });
+
+    int32 NumFailed = 0;
+    for (const FScriptBatchJob& Job : Jobs)
+    {
+        if (!Job.Bytecode.IsValid())
+        {
+            NumFailed++;
+        }
+    }
+    return NumFailed;
+}
+
+void FScriptBatchCompiler::CompileJob(FScriptBatchJob& Job) const
+{
+    Job.Bytecode = nullptr;
+    Job.Errors.Reset();
+    Job.Imports.Reset();
+
+    FScriptLexer Lexer(Job.Source);
+    FScriptParser Parser(Lexer);
+    TSharedPtr<FScriptProgram> Program = Parser.Parse();
+
+    // Lexer errors first: parser errors after them are usually their echo
+    if (Lexer.HasErrors())
+    {
+        for (const FString& Error : Lexer.GetErrors())
+        {
+            Job.Errors.Add(FString::Printf(TEXT("Lexer Error: %s"), *Error));
+        }
+        return;
+    }
+    if (!Program.IsValid() || Parser.HasErrors())
+    {
+        for (const FString& Error : Parser.GetErrors())
+        {
+            Job.Errors.Add(FString::Printf(TEXT("Parser Error: %s"), *Error));
+        }
+        if (Job.Errors.Num() == 0)
+        {
+            Job.Errors.Add(TEXT("Parser failed to produce program"));
+        }
+        return;
+    }
+
+    FScriptCompiler Compiler;
+    Compiler.SetModuleCache(ModuleCache);
+    Compiler.SetInliningEnabled(bInliningEnabled);
+    Compiler.SetOptimizationEnabled(bOptimizationEnabled);
+    Compiler.SetRegisterCodeEnabled(bRegisterCodeEnabled);
+    TSharedPtr<FBytecodeChunk> Bytecode = Compiler.Compile(Program);
+    if (!Bytecode.IsValid() || Compiler.HasErrors())
+    {
+        for (const FString& Error : Compiler.GetErrors())
+        {
+            Job.Errors.Add(FString::Printf(TEXT("Compiler Error: %s"), *Error));
+        }
+        if (Job.Errors.Num() == 0)
+        {
+            Job.Errors.Add(TEXT("Compiler failed"));
+        }
+        return;
+    }
+    Job.Imports = Compiler.GetImportedSourceFiles();
+
+    if (ModuleCache)
+    {
+        TArray<FString> LinkErrors;
+        Bytecode = FScriptLinker::Link(*Bytecode, *ModuleCache, LinkErrors);
+        if (!Bytecode.IsValid())
+        {
+            for (const FString& Error : LinkErrors)
+            {
+                Job.Errors.Add(FString::Printf(TEXT("Linker Error: %s"), *Error));
+            }
+            return;
+        }
+    }
+
+    Job.Bytecode = Bytecode;
+}
@@ -2,6 +2,7 @@
 // Custom scripting system for secure modding support.
 
 #include "ScriptBytecode.h"
+#include "ScriptBytecodeFile.h"
 #include "Misc/SecureHash.h"
 #include "Compression/OodleDataCompression.h"
 #include "Serialization/MemoryWriter.h"
@@ -34,9 +35,17 @@ FString FBytecodeChunk::Disassemble() const
         
         // Add line number if available
         #if !UE_BUILD_SHIPPING
-        if (DebugInfo.IsValidIndex(Offset))
+        if (const FLineTable::FRun* Run = LineTable.Find(Offset))
         {
-            Result += FString::Printf(TEXT("[Line %d] "), DebugInfo[Offset].Line);
+            const FString& SourceFile = LineTable.Files[Run->File];
+            if (!SourceFile.IsEmpty())
+            {
+                Result += FString::Printf(TEXT("[%s:%d] "), *SourceFile, Run->Line);
+            }
+            else
+            {
+                Result += FString::Printf(TEXT("[Line %d] "), Run->Line);
+            }
         }
         #endif
         
@@ -177,14 +186,24 @@ FString FBytecodeChunk::Disassemble() const
                 Result += FString::Printf(TEXT("OP_CALL (args: %d, func: %d)\n"), ArgCount, FuncIndex);
                 break;
             }
+            case EOpCode::OP_TAIL_CALL:
+            {
+                uint8 ArgCount = Code[Offset++];
+                uint8 FuncIdxHigh = Code[Offset++];
+                uint8 FuncIdxLow = Code[Offset++];
+                int32 FuncIndex = (FuncIdxHigh << 8) | FuncIdxLow;
+                Result += FString::Printf(TEXT("OP_TAIL_CALL (args: %d, func: %d)\n"), ArgCount, FuncIndex);
+                break;
+            }
             case EOpCode::OP_CALL_NATIVE:
             {
                 uint8 ArgCount = Code[Offset++];
                 uint8 NameIdxHigh = Code[Offset++];
                 uint8 NameIdxLow = Code[Offset++];
                 int32 NameIndex = (NameIdxHigh << 8) | NameIdxLow;
-                Result += FString::Printf(TEXT("OP_CALL_NATIVE (args: %d, name: %s)\n"), 
-                    ArgCount, *Constants[NameIndex].ToString());
+                Result += FString::Printf(TEXT("OP_CALL_NATIVE (args: %d, name: %s%s)\n"), 
+                    ArgCount & NATIVE_CALL_ARGC_MASK, *Constants[NameIndex].ToString(),
+                    (ArgCount & NATIVE_CALL_ARGS_CHECKED) ? TEXT(", checked") : TEXT(""));
                 break;
             }
             case EOpCode::OP_RETURN:
@@ -247,18 +266,1002 @@ FString FBytecodeChunk::Disassemble() const
                 Result += TEXT("OP_HALT\n");
                 break;
                 
+            case EOpCode::OP_FOR_PREP:
+            case EOpCode::OP_FOR_LOOP:
+            {
+                uint8 Slot = Code[Offset++];
+                uint8 Flags = Code[Offset++];
+                uint8 High = Code[Offset++];
+                uint8 Low = Code[Offset++];
+                int32 Jump = (High << 8) | Low;
+                const bool bPrep = Op == EOpCode::OP_FOR_PREP;
+                Result += FString::Printf(TEXT("%s %d%s %d -> %d\n"),
+                    bPrep ? TEXT("OP_FOR_PREP") : TEXT("OP_FOR_LOOP"), Slot,
+                    (Flags & FOR_LOOP_INCLUSIVE) ? TEXT(" (inclusive)") : TEXT(""),
+                    Jump, bPrep ? Offset + Jump : Offset - Jump);
+                break;
+            }
+            case EOpCode::OP_FOREACH:
+            {
+                uint8 Slot = Code[Offset++];
+                uint8 High = Code[Offset++];
+                uint8 Low = Code[Offset++];
+                int32 Jump = (High << 8) | Low;
+                Result += FString::Printf(TEXT("OP_FOREACH %d %d -> %d\n"), Slot, Jump, Offset + Jump);
+                break;
+            }
+            
+            case EOpCode::OP_SWITCH_TABLE:
+            case EOpCode::OP_SWITCH_LOOKUP:
+            {
+                // One line for the instruction, one per case
+                const bool bTable = Op == EOpCode::OP_SWITCH_TABLE;
+                int32 Low = 0;
+                int32 KeysIndex = 0;
+                if (bTable)
+                {
+                    Low = (int32)(((uint32)Code[Offset] << 24) | ((uint32)Code[Offset + 1] << 16) | ((uint32)Code[Offset + 2] << 8) | Code[Offset + 3]);
+                    Offset += 4;
+                }
+                else
+                {
+                    KeysIndex = (Code[Offset] << 8) | Code[Offset + 1];
+                    Offset += 2;
+                }
+                const int32 Count = (Code[Offset] << 8) | Code[Offset + 1];
+                const int32 Default = (Code[Offset + 2] << 8) | Code[Offset + 3];
+                const int32 Cases = Offset + 4;
+                const int32 Next = Cases + Count * 2;
+                Result += FString::Printf(TEXT("%s (%d cases, default -> %d)\n"),
+                    bTable ? TEXT("OP_SWITCH_TABLE") : TEXT("OP_SWITCH_LOOKUP"), Count, Next + Default);
+                
+                const TArray<FScriptValue>* Keys = (!bTable && Constants.IsValidIndex(KeysIndex)) ? &Constants[KeysIndex].AsArray() : nullptr;
+                for (int32 i = 0; i < Count; ++i)
+                {
+                    const int32 Jump = (Code[Cases + i * 2] << 8) | Code[Cases + i * 2 + 1];
+                    if (bTable && Jump == Default)
+                    {
+                        continue;
+                    }
+                    const FString Key = bTable ? FString::Printf(TEXT("%d"), Low + i)
+                        : (Keys && Keys->IsValidIndex(i)) ? (*Keys)[i].ToString() : FString(TEXT("?"));
+                    Result += FString::Printf(TEXT("            case %s -> %d\n"), *Key, Next + Jump);
+                }
+                Offset = Next;
+                break;
+            }
+            
+            case EOpCode::OP_CONSTANT_WIDE:
+            case EOpCode::OP_DEFINE_GLOBAL_WIDE:
+            case EOpCode::OP_GET_GLOBAL_WIDE:
+            case EOpCode::OP_SET_GLOBAL_WIDE:
+            {
+                const TCHAR* Name = Op == EOpCode::OP_CONSTANT_WIDE ? TEXT("OP_CONSTANT_WIDE")
+                    : Op == EOpCode::OP_DEFINE_GLOBAL_WIDE ? TEXT("OP_DEFINE_GLOBAL_WIDE")
+                    : Op == EOpCode::OP_GET_GLOBAL_WIDE ? TEXT("OP_GET_GLOBAL_WIDE") : TEXT("OP_SET_GLOBAL_WIDE");
+                int32 ConstIndex = (Code[Offset] << 16) | (Code[Offset + 1] << 8) | Code[Offset + 2];
+                Offset += 3;
+                Result += FString::Printf(TEXT("%s %d (%s)\n"), Name, ConstIndex,
+                    Constants.IsValidIndex(ConstIndex) ? *Constants[ConstIndex].ToString() : TEXT("?"));
+                break;
+            }
+            
+            case EOpCode::OP_GET_LOCAL_WIDE:
+            case EOpCode::OP_SET_LOCAL_WIDE:
+            {
+                int32 Slot = (Code[Offset] << 8) | Code[Offset + 1];
+                Offset += 2;
+                Result += FString::Printf(TEXT("%s %d\n"),
+                    Op == EOpCode::OP_GET_LOCAL_WIDE ? TEXT("OP_GET_LOCAL_WIDE") : TEXT("OP_SET_LOCAL_WIDE"), Slot);
+                break;
+            }
+            
+            case EOpCode::OP_JUMP_WIDE:
+            case EOpCode::OP_JUMP_IF_FALSE_WIDE:
+            case EOpCode::OP_LOOP_WIDE:
+            {
+                int32 Jump = (int32)(((uint32)Code[Offset] << 24) | (Code[Offset + 1] << 16) | (Code[Offset + 2] << 8) | Code[Offset + 3]);
+                Offset += 4;
+                const TCHAR* Name = Op == EOpCode::OP_JUMP_WIDE ? TEXT("OP_JUMP_WIDE")
+                    : Op == EOpCode::OP_JUMP_IF_FALSE_WIDE ? TEXT("OP_JUMP_IF_FALSE_WIDE") : TEXT("OP_LOOP_WIDE");
+                Result += FString::Printf(TEXT("%s %d -> %d\n"), Name, Jump,
+                    Op == EOpCode::OP_LOOP_WIDE ? Offset - Jump : Offset + Jump);
+                break;
+            }
+            
+            case EOpCode::OP_FOREACH_WIDE:
+            {
+                int32 Slot = (Code[Offset] << 8) | Code[Offset + 1];
+                int32 Jump = (int32)(((uint32)Code[Offset + 2] << 24) | (Code[Offset + 3] << 16) | (Code[Offset + 4] << 8) | Code[Offset + 5]);
+                Offset += 6;
+                Result += FString::Printf(TEXT("OP_FOREACH_WIDE %d %d -> %d\n"), Slot, Jump, Offset + Jump);
+                break;
+            }
+            
+            case EOpCode::OP_ADD_NUMBER:
+                Result += TEXT("OP_ADD_NUMBER\n");
+                break;
+            case EOpCode::OP_SUBTRACT_NUMBER:
+                Result += TEXT("OP_SUBTRACT_NUMBER\n");
+                break;
+            case EOpCode::OP_MULTIPLY_NUMBER:
+                Result += TEXT("OP_MULTIPLY_NUMBER\n");
+                break;
+            case EOpCode::OP_LESS_NUMBER:
+                Result += TEXT("OP_LESS_NUMBER\n");
+                break;
+            case EOpCode::OP_GREATER_NUMBER:
+                Result += TEXT("OP_GREATER_NUMBER\n");
+                break;
+            case EOpCode::OP_NOT_LESS_NUMBER:
+                Result += TEXT("OP_NOT_LESS_NUMBER\n");
+                break;
+            case EOpCode::OP_NOT_GREATER_NUMBER:
+                Result += TEXT("OP_NOT_GREATER_NUMBER\n");
+                break;
+                
             default:
                 Result += FString::Printf(TEXT("UNKNOWN_OP %d\n"), static_cast<int32>(Op));
                 break;
         }
     }
     
+    if (RegisterCode.Num() > 0)
+    {
+        Result += FString::Printf(TEXT("\nRegister Code: %d bytes\n"), RegisterCode.Num());
+        Result += DisassembleRegisterCode();
+    }
+    
+    return Result;
+}
+
+EOpCode GetWideOpCode(EOpCode OpCode)
+{
+    switch (OpCode)
+    {
+        case EOpCode::OP_CONSTANT:      return EOpCode::OP_CONSTANT_WIDE;
+        case EOpCode::OP_DEFINE_GLOBAL: return EOpCode::OP_DEFINE_GLOBAL_WIDE;
+        case EOpCode::OP_GET_GLOBAL:    return EOpCode::OP_GET_GLOBAL_WIDE;
+        case EOpCode::OP_SET_GLOBAL:    return EOpCode::OP_SET_GLOBAL_WIDE;
+        case EOpCode::OP_GET_LOCAL:     return EOpCode::OP_GET_LOCAL_WIDE;
+        case EOpCode::OP_SET_LOCAL:     return EOpCode::OP_SET_LOCAL_WIDE;
+        case EOpCode::OP_JUMP:          return EOpCode::OP_JUMP_WIDE;
+        case EOpCode::OP_JUMP_IF_FALSE: return EOpCode::OP_JUMP_IF_FALSE_WIDE;
+        case EOpCode::OP_LOOP:          return EOpCode::OP_LOOP_WIDE;
+        case EOpCode::OP_FOREACH:       return EOpCode::OP_FOREACH_WIDE;
+        default:                        return OpCode;
+    }
+}
+
+EOpCode GetNumberOpCode(EOpCode OpCode)
+{
+    switch (OpCode)
+    {
+        case EOpCode::OP_ADD:      return EOpCode::OP_ADD_NUMBER;
+        case EOpCode::OP_SUBTRACT: return EOpCode::OP_SUBTRACT_NUMBER;
+        case EOpCode::OP_MULTIPLY: return EOpCode::OP_MULTIPLY_NUMBER;
+        case EOpCode::OP_LESS:     return EOpCode::OP_LESS_NUMBER;
+        case EOpCode::OP_GREATER:  return EOpCode::OP_GREATER_NUMBER;
+        default:                   return OpCode;
+    }
+}
+
+EOpCode GetGenericOpCode(EOpCode OpCode)
+{
+    switch (OpCode)
+    {
+        case EOpCode::OP_ADD_NUMBER:           return EOpCode::OP_ADD;
+        case EOpCode::OP_SUBTRACT_NUMBER:      return EOpCode::OP_SUBTRACT;
+        case EOpCode::OP_MULTIPLY_NUMBER:      return EOpCode::OP_MULTIPLY;
+        case EOpCode::OP_LESS_NUMBER:
+        case EOpCode::OP_NOT_LESS_NUMBER:      return EOpCode::OP_LESS;
+        case EOpCode::OP_GREATER_NUMBER:
+        case EOpCode::OP_NOT_GREATER_NUMBER:   return EOpCode::OP_GREATER;
+        default:                               return OpCode;
+    }
+}
+
+//=============================================================================
+// Constant pool
+//=============================================================================
+
+// Murmur3 finalizer: buckets are picked by the low bits, which are mostly zero in
+// the IEEE bits of small integral numbers
+static uint32 MixConstantHash(uint32 Hash)
+{
+    Hash ^= Hash >> 16;
+    Hash *= 0x85ebca6bu;
+    Hash ^= Hash >> 13;
+    Hash *= 0xc2b2ae35u;
+    Hash ^= Hash >> 16;
+    return Hash;
+}
+
+uint32 FConstantPoolIndex::HashConstant(const FScriptValue& Value)
+{
+    // FNV-1a, seeded with the type so e.g. nil, false and 0 land apart
+    uint32 Hash = 2166136261u ^ static_cast<uint32>(Value.Type);
+    switch (Value.Type)
+    {
+        case EValueType::NIL:
+            break;
+            
+        case EValueType::BOOL:
+            Hash = (Hash ^ (Value.BoolValue ? 1u : 0u)) * 16777619u;
+            break;
+            
+        case EValueType::NUMBER:
+        {
+            uint64 NumberBits = 0;
+            FMemory::Memcpy(&NumberBits, &Value.NumberValue, sizeof(NumberBits));
+            Hash = (Hash ^ static_cast<uint32>(NumberBits)) * 16777619u;
+            Hash = (Hash ^ static_cast<uint32>(NumberBits >> 32)) * 16777619u;
+            break;
+        }
+            
+        case EValueType::STRING:
+            for (int32 i = 0; i < Value.StringValue.Len(); ++i)
+            {
+                Hash = (Hash ^ static_cast<uint32>(Value.StringValue[i])) * 16777619u;
+            }
+            break;
+            
+        case EValueType::ARRAY:
+            Hash = (Hash ^ static_cast<uint32>(Value.ArrayValue.Num())) * 16777619u;
+            for (const FScriptValue& Element : Value.ArrayValue)
+            {
+                Hash = (Hash ^ HashConstant(Element)) * 16777619u;
+            }
+            break;
+    }
+    return MixConstantHash(Hash);
+}
+
+bool FConstantPoolIndex::IsSameConstant(const FScriptValue& A, const FScriptValue& B)
+{
+    if (A.Type != B.Type)
+    {
+        return false;
+    }
+    switch (A.Type)
+    {
+        case EValueType::NIL:
+            return true;
+        case EValueType::BOOL:
+            return A.BoolValue == B.BoolValue;
+        case EValueType::NUMBER:
+        {
+            // Bitwise, so -0 keeps its own constant (1 / -0 is -inf)
+            uint64 BitsA = 0;
+            uint64 BitsB = 0;
+            FMemory::Memcpy(&BitsA, &A.NumberValue, sizeof(BitsA));
+            FMemory::Memcpy(&BitsB, &B.NumberValue, sizeof(BitsB));
+            return BitsA == BitsB;
+        }
+        case EValueType::STRING:
+            return A.StringValue.Equals(B.StringValue, ESearchCase::CaseSensitive);
+        case EValueType::ARRAY:
+            if (A.ArrayValue.Num() != B.ArrayValue.Num())
+            {
+                return false;
+            }
+            for (int32 i = 0; i < A.ArrayValue.Num(); ++i)
+            {
+                if (!IsSameConstant(A.ArrayValue[i], B.ArrayValue[i]))
+                {
+                    return false;
+                }
+            }
+            return true;
+    }
+    return false;
+}
+
+int32 FConstantPoolIndex::Find(const TArray<FScriptValue>& Constants, const FScriptValue& Value) const
+{
+    if (Buckets.Num() == 0)
+    {
+        return INDEX_NONE;
+    }
+    const uint32 Mask = static_cast<uint32>(Buckets.Num() - 1);
+    for (int32 Index = Buckets[HashConstant(Value) & Mask]; Index != INDEX_NONE; Index = Next[Index])
+    {
+        if (IsSameConstant(Constants[Index], Value))
+        {
+            return Index;
+        }
+    }
+    return INDEX_NONE;
+}
+
+void FConstantPoolIndex::Add(const TArray<FScriptValue>& Constants)
+{
+    // Keep the load at or under one constant per two buckets. A pool that was
+    // appended to behind the index's back is picked up by the rehash.
+    if (Next.Num() != Constants.Num() - 1 || Constants.Num() * 2 > Buckets.Num())
+    {
+        int32 NumBuckets = FMath::Max(Buckets.Num(), 64);
+        while (Constants.Num() * 2 > NumBuckets)
+        {
+            NumBuckets *= 2;
+        }
+        Rehash(Constants, NumBuckets);
+        return;
+    }
+    
+    const int32 Index = Constants.Num() - 1;
+    const int32 Bucket = static_cast<int32>(HashConstant(Constants[Index]) & static_cast<uint32>(Buckets.Num() - 1));
+    Next.Add(Buckets[Bucket]);
+    Buckets[Bucket] = Index;
+}
+
+void FConstantPoolIndex::Truncate(const TArray<FScriptValue>& Constants, int32 NewNum)
+{
+    if (Next.Num() != Constants.Num())
+    {
+        Buckets.Empty();
+        Next.Empty();
+        return;  // Out of step already; the next Add rebuilds it
+    }
+    
+    // Newest first: each removed constant is at the head of its bucket when reached
+    const uint32 Mask = static_cast<uint32>(Buckets.Num() - 1);
+    for (int32 Index = Constants.Num() - 1; Index >= NewNum; --Index)
+    {
+        Buckets[HashConstant(Constants[Index]) & Mask] = Next[Index];
+    }
+    Next.SetNum(NewNum);
+}
+
+void FConstantPoolIndex::Rehash(const TArray<FScriptValue>& Constants, int32 NumBuckets)
+{
+    Buckets.Init(INDEX_NONE, NumBuckets);
+    Next.SetNum(Constants.Num());
+    const uint32 Mask = static_cast<uint32>(NumBuckets - 1);
+    for (int32 Index = 0; Index < Constants.Num(); ++Index)
+    {
+        const int32 Bucket = static_cast<int32>(HashConstant(Constants[Index]) & Mask);
+        Next[Index] = Buckets[Bucket];
+        Buckets[Bucket] = Index;
+    }
+}
+
+int32 FBytecodeChunk::AddConstant(const FScriptValue& Value)
+{
+    if (ConstantIndex.IsValid())
+    {
+        const int32 Existing = ConstantIndex->Find(Constants, Value);
+        if (Existing != INDEX_NONE)
+        {
+            return Existing;
+        }
+        Constants.Add(Value);
+        ConstantIndex->Add(Constants);
+        return Constants.Num() - 1;
+    }
+    
+    // No index outside compilation: a linear scan, same equality
+    for (int32 i = 0; i < Constants.Num(); ++i)
+    {
+        if (FConstantPoolIndex::IsSameConstant(Constants[i], Value))
+        {
+            return i;
+        }
+    }
+    Constants.Add(Value);
+    return Constants.Num() - 1;
+}
+
+void FBytecodeChunk::TruncateConstants(int32 NewNum)
+{
+    if (NewNum >= Constants.Num())
+    {
+        return;
+    }
+    if (ConstantIndex.IsValid())
+    {
+        ConstantIndex->Truncate(Constants, NewNum);
+    }
+    Constants.SetNum(NewNum);
+}
+
+//=============================================================================
+// Register code
+//=============================================================================
+
+namespace
+{
+    struct FRegisterOpInfo
+    {
+        const TCHAR* Name;
+        const TCHAR* Operands;
+    };
+
+    // Indexed by ERegOpCode
+    const FRegisterOpInfo RegisterOps[] =
+    {
+        { TEXT("LOAD_CONSTANT"), TEXT("RK") },
+        { TEXT("LOAD_NIL"), TEXT("R") },
+        { TEXT("LOAD_TRUE"), TEXT("R") },
+        { TEXT("LOAD_FALSE"), TEXT("R") },
+        { TEXT("MOVE"), TEXT("RR") },
+        { TEXT("ADD"), TEXT("RRR") },
+        { TEXT("SUBTRACT"), TEXT("RRR") },
+        { TEXT("MULTIPLY"), TEXT("RRR") },
+        { TEXT("DIVIDE"), TEXT("RRR") },
+        { TEXT("MODULO"), TEXT("RRR") },
+        { TEXT("NEGATE"), TEXT("RR") },
+        { TEXT("EQUAL"), TEXT("RRR") },
+        { TEXT("GREATER"), TEXT("RRR") },
+        { TEXT("LESS"), TEXT("RRR") },
+        { TEXT("NOT"), TEXT("RR") },
+        { TEXT("AND"), TEXT("RRR") },
+        { TEXT("OR"), TEXT("RRR") },
+        { TEXT("BIT_AND"), TEXT("RRR") },
+        { TEXT("BIT_OR"), TEXT("RRR") },
+        { TEXT("BIT_XOR"), TEXT("RRR") },
+        { TEXT("BIT_NOT"), TEXT("RR") },
+        { TEXT("CAST_INT"), TEXT("RR") },
+        { TEXT("CAST_FLOAT"), TEXT("RR") },
+        { TEXT("CAST_STRING"), TEXT("RR") },
+        { TEXT("GET_GLOBAL"), TEXT("RK") },
+        { TEXT("SET_GLOBAL"), TEXT("RK") },
+        { TEXT("JUMP"), TEXT("J") },
+        { TEXT("JUMP_IF_FALSE"), TEXT("RJ") },
+        { TEXT("JUMP_IF_TRUE"), TEXT("RJ") },
+        { TEXT("JUMP_IF_EQUAL"), TEXT("RRJ") },
+        { TEXT("JUMP_IF_NOT_EQUAL"), TEXT("RRJ") },
+        { TEXT("JUMP_IF_LESS"), TEXT("RRJ") },
+        { TEXT("JUMP_IF_NOT_LESS"), TEXT("RRJ") },
+        { TEXT("JUMP_IF_GREATER"), TEXT("RRJ") },
+        { TEXT("JUMP_IF_NOT_GREATER"), TEXT("RRJ") },
+        { TEXT("FOR_PREP"), TEXT("RBJ") },
+        { TEXT("FOR_LOOP"), TEXT("RBJ") },
+        { TEXT("FOREACH"), TEXT("RJ") },
+        { TEXT("CALL"), TEXT("RFN") },
+        { TEXT("TAIL_CALL"), TEXT("FN") },
+        { TEXT("CALL_NATIVE"), TEXT("RBKN") },
+        { TEXT("RETURN"), TEXT("R") },
+        { TEXT("CREATE_ARRAY"), TEXT("RN") },
+        { TEXT("GET_ELEMENT"), TEXT("RRR") },
+        { TEXT("SET_ELEMENT"), TEXT("RRRR") },
+        { TEXT("GET_FIELD"), TEXT("RRK") },
+        { TEXT("SET_FIELD"), TEXT("RRRK") },
+    };
+    static_assert(UE_ARRAY_COUNT(RegisterOps) == (int32)ERegOpCode::REG_OPCODE_COUNT, "RegisterOps must list every ERegOpCode");
+}
+
+const TCHAR* GetRegisterOperands(ERegOpCode OpCode)
+{
+    return (int32)OpCode < UE_ARRAY_COUNT(RegisterOps) ? RegisterOps[(int32)OpCode].Operands : nullptr;
+}
+
+int32 GetRegisterInstructionSize(const TArray<uint8>& Code, int32 Offset, int32 End)
+{
+    const TCHAR* Operands = (Offset >= 0 && Offset < End) ? GetRegisterOperands((ERegOpCode)Code[Offset]) : nullptr;
+    if (!Operands)
+    {
+        return 0;
+    }
+
+    int32 Size = 1;
+    for (const TCHAR* Kind = Operands; *Kind; ++Kind)
+    {
+        if (*Kind == 'N')
+        {
+            Size += (Offset + Size < End) ? 1 + Code[Offset + Size] : 1;
+        }
+        else
+        {
+            Size += (*Kind == 'K' || *Kind == 'F' || *Kind == 'J') ? 2 : 1;
+        }
+    }
+    return Offset + Size <= End ? Size : 0;
+}
+
+FString FBytecodeChunk::DisassembleRegisterCode() const
+{
+    // Function entries, to label the listing
+    TMap<int32, FString> Entries;
+    for (const FFunctionInfo& Func : Functions)
+    {
+        if (Func.RegisterAddress != INDEX_NONE)
+        {
+            Entries.Add(Func.RegisterAddress, FString::Printf(TEXT("%s (%d registers)"), *Func.Name, Func.NumRegisters));
+        }
+    }
+
+    FString Result;
+    int32 Offset = 0;
+    while (Offset < RegisterCode.Num())
+    {
+        if (const FString* Entry = Entries.Find(Offset))
+        {
+            Result += FString::Printf(TEXT("%s:\n"), **Entry);
+        }
+
+        const int32 Start = Offset;
+        const uint8 Op = RegisterCode[Offset++];
+        const TCHAR* Operands = GetRegisterOperands((ERegOpCode)Op);
+        if (!Operands)
+        {
+            Result += FString::Printf(TEXT("%04d  UNKNOWN_OP %d\n"), Start, Op);
+            break;
+        }
+
+        FString Line = FString::Printf(TEXT("%04d  %s"), Start, RegisterOps[Op].Name);
+        for (const TCHAR* Kind = Operands; *Kind && Offset < RegisterCode.Num(); ++Kind)
+        {
+            switch (*Kind)
+            {
+                case 'R':
+                    Line += FString::Printf(TEXT(" r%d"), RegisterCode[Offset++]);
+                    break;
+                case 'B':
+                    Line += FString::Printf(TEXT(" %d"), RegisterCode[Offset++]);
+                    break;
+                case 'N':
+                {
+                    const int32 Count = RegisterCode[Offset++];
+                    Line += TEXT(" (");
+                    for (int32 i = 0; i < Count && Offset < RegisterCode.Num(); ++i)
+                    {
+                        Line += FString::Printf(i > 0 ? TEXT(", r%d") : TEXT("r%d"), RegisterCode[Offset++]);
+                    }
+                    Line += TEXT(")");
+                    break;
+                }
+                default:
+                {
+                    if (Offset + 1 >= RegisterCode.Num())
+                    {
+                        Offset = RegisterCode.Num();
+                        break;
+                    }
+                    const int32 Value = (RegisterCode[Offset] << 8) | RegisterCode[Offset + 1];
+                    Offset += 2;
+                    if (*Kind == 'J')
+                    {
+                        Line += FString::Printf(TEXT(" -> %d"), Offset + (int16)Value);
+                    }
+                    else if (*Kind == 'F')
+                    {
+                        Line += Functions.IsValidIndex(Value) ? FString::Printf(TEXT(" %s"), *Functions[Value].Name) : FString::Printf(TEXT(" f%d"), Value);
+                    }
+                    else
+                    {
+                        Line += Constants.IsValidIndex(Value) ? FString::Printf(TEXT(" (%s)"), *Constants[Value].ToString()) : FString::Printf(TEXT(" k%d"), Value);
+                    }
+                    break;
+                }
+            }
+        }
+        Result += Line + TEXT("\n");
+    }
     return Result;
 }
 
+// Value encoding shared by VM snapshots: [type:u8] followed by the payload
+// NUMBER = 8 bytes (IEEE bits, little endian), STRING = [len:i32][utf8], ARRAY = [count:i32][values...]
+static const int32 MAX_VALUE_NESTING = 64;
+
+void FScriptValue::SerializeTo(TArray<uint8>& OutData) const
+{
+    OutData.Add(static_cast<uint8>(Type));
+    
+    switch (Type)
+    {
+        case EValueType::NIL:
+            break;
+            
+        case EValueType::BOOL:
+            OutData.Add(BoolValue ? 1 : 0);
+            break;
+            
+        case EValueType::NUMBER:
+        {
+            uint64 NumberBits = 0;
+            FMemory::Memcpy(&NumberBits, &NumberValue, sizeof(NumberBits));
+            for (int32 i = 0; i < 8; ++i)
+            {
+                OutData.Add((NumberBits >> (i * 8)) & 0xFF);
+            }
+            break;
+        }
+            
+        case EValueType::STRING:
+        {
+            FTCHARToUTF8 Converter(*StringValue);
+            int32 Length = Converter.Length();
+            for (int32 i = 0; i < 4; ++i)
+            {
+                OutData.Add((Length >> (i * 8)) & 0xFF);
+            }
+            OutData.Append(reinterpret_cast<const uint8*>(Converter.Get()), Length);
+            break;
+        }
+            
+        case EValueType::ARRAY:
+        {
+            int32 Count = ArrayValue.Num();
+            for (int32 i = 0; i < 4; ++i)
+            {
+                OutData.Add((Count >> (i * 8)) & 0xFF);
+            }
+            for (const FScriptValue& Element : ArrayValue)
+            {
+                Element.SerializeTo(OutData);
+            }
+            break;
+        }
+    }
+}
+
+static bool DeserializeValue(const TArray<uint8>& InData, int32& Offset, FScriptValue& OutValue, int32 Depth)
+{
+    if (Depth > MAX_VALUE_NESTING || Offset >= InData.Num())
+    {
+        return false;
+    }
+    
+    auto ReadInt32 = [&InData, &Offset](int32& OutInt) -> bool {
+        if (Offset + 4 > InData.Num()) return false;
+        OutInt = 0;
+        for (int32 i = 0; i < 4; ++i)
+        {
+            OutInt |= static_cast<int32>(InData[Offset++]) << (i * 8);
+        }
+        return true;
+    };
+    
+    OutValue = FScriptValue();
+    OutValue.Type = static_cast<EValueType>(InData[Offset++]);
+    
+    switch (OutValue.Type)
+    {
+        case EValueType::NIL:
+            return true;
+            
+        case EValueType::BOOL:
+            if (Offset >= InData.Num()) return false;
+            OutValue.BoolValue = (InData[Offset++] != 0);
+            return true;
+            
+        case EValueType::NUMBER:
+        {
+            if (Offset + 8 > InData.Num()) return false;
+            uint64 NumberBits = 0;
+            for (int32 i = 0; i < 8; ++i)
+            {
+                NumberBits |= static_cast<uint64>(InData[Offset++]) << (i * 8);
+            }
+            FMemory::Memcpy(&OutValue.NumberValue, &NumberBits, sizeof(NumberBits));
+            return true;
+        }
+            
+        case EValueType::STRING:
+        {
+            int32 Length = 0;
+            if (!ReadInt32(Length) || Length < 0 || Offset + Length > InData.Num()) return false;
+            
+            TArray<ANSICHAR> UTF8Data;
+            UTF8Data.SetNum(Length + 1);
+            for (int32 i = 0; i < Length; ++i)
+            {
+                UTF8Data[i] = InData[Offset++];
+            }
+            UTF8Data[Length] = 0;
+            OutValue.StringValue = FString(UTF8_TO_TCHAR(UTF8Data.GetData()));
+            return true;
+        }
+            
+        case EValueType::ARRAY:
+        {
+            int32 Count = 0;
+            // Every element takes at least one byte, which bounds Count for corrupt input
+            if (!ReadInt32(Count) || Count < 0 || Offset + Count > InData.Num()) return false;
+            
+            OutValue.ArrayValue.SetNum(Count);
+            for (int32 i = 0; i < Count; ++i)
+            {
+                if (!DeserializeValue(InData, Offset, OutValue.ArrayValue[i], Depth + 1))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+    
+    return false; // Unknown type tag
+}
+
+bool FScriptValue::DeserializeFrom(const TArray<uint8>& InData, int32& Offset)
+{
+    return DeserializeValue(InData, Offset, *this, 0);
+}
+
+//=============================================================================
+// FLineTable
+//=============================================================================
+
+// Unsigned LEB128: seven bits a byte, low bits first
+static void WriteVarint(TArray<uint8>& OutData, uint64 Value)
+{
+    while (Value >= 0x80)
+    {
+        OutData.Add(static_cast<uint8>(Value | 0x80));
+        Value >>= 7;
+    }
+    OutData.Add(static_cast<uint8>(Value));
+}
+
+static bool ReadVarint(const TArray<uint8>& InData, int32& Offset, uint64& OutValue)
+{
+    OutValue = 0;
+    for (int32 Shift = 0; Shift < 64; Shift += 7)
+    {
+        if (Offset >= InData.Num())
+        {
+            return false;
+        }
+        const uint8 Byte = InData[Offset++];
+        OutValue |= static_cast<uint64>(Byte & 0x7F) << Shift;
+        if ((Byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FLineTable::Add(int32 Line, const FString& SourceFile, int32 Count)
+{
+    if (Count <= 0)
+    {
+        return;
+    }
+    
+    // Nearly every byte continues the run of the byte before it
+    if (Runs.Num() > 0 && Runs.Last().Line == Line && Files[Runs.Last().File] == SourceFile)
+    {
+        NumBytes += Count;
+        return;
+    }
+    
+    FRun Run;
+    Run.Offset = NumBytes;
+    Run.Line = Line;
+    Run.File = FindOrAddFile(SourceFile);
+    Runs.Add(Run);
+    NumBytes += Count;
+}
+
+void FLineTable::Append(const FLineTable& Other)
+{
+    for (int32 i = 0; i < Other.Runs.Num(); ++i)
+    {
+        const FRun& Run = Other.Runs[i];
+        const int32 End = (i + 1 < Other.Runs.Num()) ? Other.Runs[i + 1].Offset : Other.NumBytes;
+        Add(Run.Line, Other.Files[Run.File], End - Run.Offset);
+    }
+}
+
+void FLineTable::Truncate(int32 NewNum)
+{
+    if (NewNum >= NumBytes)
+    {
+        return;
+    }
+    NewNum = FMath::Max(NewNum, 0);
+    while (Runs.Num() > 0 && Runs.Last().Offset >= NewNum)
+    {
+        Runs.Pop();
+    }
+    NumBytes = NewNum;
+}
+
+void FLineTable::Empty()
+{
+    Files.Empty();
+    Runs.Empty();
+    NumBytes = 0;
+}
+
+const FLineTable::FRun* FLineTable::Find(int32 Offset) const
+{
+    if (Offset < 0 || Offset >= NumBytes || Runs.Num() == 0)
+    {
+        return nullptr;
+    }
+    
+    // Last run starting at or before Offset
+    int32 Low = 0;
+    int32 High = Runs.Num() - 1;
+    while (Low < High)
+    {
+        const int32 Mid = (Low + High + 1) / 2;
+        if (Runs[Mid].Offset <= Offset)
+        {
+            Low = Mid;
+        }
+        else
+        {
+            High = Mid - 1;
+        }
+    }
+    return &Runs[Low];
+}
+
+int32 FLineTable::GetLine(int32 Offset) const
+{
+    const FRun* Run = Find(Offset);
+    return Run ? Run->Line : 0;
+}
+
+const FString& FLineTable::GetFile(int32 Offset) const
+{
+    static const FString NoFile;
+    const FRun* Run = Find(Offset);
+    return Run ? Files[Run->File] : NoFile;
+}
+
+SIZE_T FLineTable::GetAllocatedSize() const
+{
+    SIZE_T Size = Runs.Num() * sizeof(FRun) + Files.Num() * sizeof(FString);
+    for (const FString& File : Files)
+    {
+        Size += File.Len() * sizeof(TCHAR);
+    }
+    return Size;
+}
+
+int32 FLineTable::FindOrAddFile(const FString& SourceFile)
+{
+    // A chunk has code from a handful of files at most
+    for (int32 i = 0; i < Files.Num(); ++i)
+    {
+        if (Files[i] == SourceFile)
+        {
+            return i;
+        }
+    }
+    Files.Add(SourceFile);
+    return Files.Num() - 1;
+}
+
+void FLineTable::SerializeTo(TArray<uint8>& OutData) const
+{
+    WriteVarint(OutData, Files.Num());
+    for (const FString& File : Files)
+    {
+        FTCHARToUTF8 Converter(*File);
+        WriteVarint(OutData, Converter.Length());
+        OutData.Append(reinterpret_cast<const uint8*>(Converter.Get()), Converter.Length());
+    }
+    
+    // Per run: offset delta, then the line delta zigzagged with the lowest bit set when
+    // the file index follows
+    WriteVarint(OutData, NumBytes);
+    WriteVarint(OutData, Runs.Num());
+    FRun Previous = { 0, 0, 0 };
+    for (const FRun& Run : Runs)
+    {
+        const int64 LineDelta = static_cast<int64>(Run.Line) - Previous.Line;
+        const uint64 ZigZag = (static_cast<uint64>(LineDelta) << 1) ^ static_cast<uint64>(LineDelta >> 63);
+        const bool bNewFile = Run.File != Previous.File;
+        WriteVarint(OutData, static_cast<uint64>(Run.Offset - Previous.Offset));
+        WriteVarint(OutData, (ZigZag << 1) | (bNewFile ? 1 : 0));
+        if (bNewFile)
+        {
+            WriteVarint(OutData, Run.File);
+        }
+        Previous = Run;
+    }
+}
+
+bool FLineTable::DeserializeFrom(const TArray<uint8>& InData, int32& Offset)
+{
+    Empty();
+    
+    // Counts are bounded by the bytes left, so corrupt input cannot ask for a huge allocation
+    auto ReadCount = [&InData, &Offset](int32& OutCount) -> bool {
+        uint64 Value = 0;
+        if (!ReadVarint(InData, Offset, Value) || Value > static_cast<uint64>(InData.Num() - Offset))
+        {
+            return false;
+        }
+        OutCount = static_cast<int32>(Value);
+        return true;
+    };
+    
+    auto Fail = [this]() {
+        Empty();
+        return false;
+    };
+    
+    int32 NumFiles = 0;
+    if (!ReadCount(NumFiles))
+    {
+        return Fail();
+    }
+    for (int32 i = 0; i < NumFiles; ++i)
+    {
+        int32 Length = 0;
+        if (!ReadCount(Length))
+        {
+            return Fail();
+        }
+        TArray<ANSICHAR> UTF8Data;
+        UTF8Data.SetNum(Length + 1);
+        for (int32 j = 0; j < Length; ++j)
+        {
+            UTF8Data[j] = InData[Offset++];
+        }
+        UTF8Data[Length] = 0;
+        Files.Add(FString(UTF8_TO_TCHAR(UTF8Data.GetData())));
+    }
+    
+    uint64 Bytes = 0;
+    int32 NumRuns = 0;
+    if (!ReadVarint(InData, Offset, Bytes) || Bytes > static_cast<uint64>(MAX_int32) || !ReadCount(NumRuns) ||
+        (Bytes > 0) != (NumRuns > 0))
+    {
+        return Fail();
+    }
+    NumBytes = static_cast<int32>(Bytes);
+    
+    Runs.Reserve(NumRuns);
+    FRun Previous = { 0, 0, 0 };
+    for (int32 i = 0; i < NumRuns; ++i)
+    {
+        uint64 OffsetDelta = 0;
+        uint64 LineBits = 0;
+        if (!ReadVarint(InData, Offset, OffsetDelta) || !ReadVarint(InData, Offset, LineBits))
+        {
+            return Fail();
+        }
+        
+        // Runs are in order, each at least a byte long, the first at 0
+        if ((i == 0) != (OffsetDelta == 0) || OffsetDelta >= static_cast<uint64>(NumBytes - Previous.Offset))
+        {
+            return Fail();
+        }
+        
+        const uint64 ZigZag = LineBits >> 1;
+        const int64 Line = Previous.Line + static_cast<int64>((ZigZag >> 1) ^ (0 - (ZigZag & 1)));
+        if (Line < MIN_int32 || Line > MAX_int32)
+        {
+            return Fail();
+        }
+        
+        FRun Run;
+        Run.Offset = Previous.Offset + static_cast<int32>(OffsetDelta);
+        Run.Line = static_cast<int32>(Line);
+        Run.File = Previous.File;
+        if (LineBits & 1)
+        {
+            uint64 File = 0;
+            if (!ReadVarint(InData, Offset, File) || File >= static_cast<uint64>(NumFiles))
+            {
+                return Fail();
+            }
+            Run.File = static_cast<int32>(File);
+        }
+        else if (Run.File >= NumFiles)
+        {
+            return Fail();
+        }
+        Runs.Add(Run);
+        Previous = Run;
+    }
+    return true;
+}
+
 // Magic number for bytecode files: "SBC1" (Script Bytecode v1)
 static const uint32 BYTECODE_MAGIC = 0x31434253;
 static const uint32 COMPRESSED_FLAG = 0x01;
+static const uint32 REGISTER_CODE_FLAG = 0x02;   // Header carries the register code version, payload ends with the register section
 
 // SHA256 hash calculator
 FString FBytecodeChunk::CalculateSHA256(const TArray<uint8>& Data)
@@ -289,6 +1292,7 @@ FString FBytecodeChunk::GenerateSignature() const
     
     // Include bytecode hash
     SignatureData.Append(Code);
+    SignatureData.Append(RegisterCode);
     
     // Generate SHA256 hash
     return CalculateSHA256(SignatureData);
@@ -426,6 +1430,19 @@ bool FBytecodeChunk::Serialize(TArray<uint8>& OutData, bool bCompress) const
         WriteInt32Temp(Func.Arity);
     }
     
+    // Register section: the code, then each function's entry and frame size
+    const bool bHasRegisterCode = RegisterCode.Num() > 0;
+    if (bHasRegisterCode)
+    {
+        WriteInt32Temp(RegisterCode.Num());
+        UncompressedData.Append(RegisterCode);
+        for (const FFunctionInfo& Func : Functions)
+        {
+            WriteInt32Temp(Func.RegisterAddress);
+            WriteInt32Temp(Func.NumRegisters);
+        }
+    }
+    
     // Now write the final output with header
     // Write magic number
     WriteInt32(BYTECODE_MAGIC);
@@ -434,8 +1451,12 @@ bool FBytecodeChunk::Serialize(TArray<uint8>& OutData, bool bCompress) const
     WriteInt32(Version);
     
     // Write flags (compressed or not)
-    uint32 Flags = bCompress ? COMPRESSED_FLAG : 0;
+    uint32 Flags = (bCompress ? COMPRESSED_FLAG : 0) | (bHasRegisterCode ? REGISTER_CODE_FLAG : 0);
     WriteInt32(Flags);
+    if (bHasRegisterCode)
+    {
+        WriteInt32(REGISTER_CODE_VERSION);
+    }
     
     // Write signature
     WriteString(const_cast<FBytecodeChunk*>(this)->GenerateSignature());
@@ -515,6 +1536,14 @@ bool FBytecodeChunk::Deserialize(const TArray<uint8>& InData)
         return FString(UTF8_TO_TCHAR(UTF8Data.GetData()));
     };
     
+    // v3 is read in place, then copied out
+    if (FScriptBytecodeFile::IsBytecodeFile(InData.GetData(), InData.Num()))
+    {
+        FString Error;
+        TSharedPtr<FScriptBytecodeFile> File = FScriptBytecodeFile::FromView(InData.GetData(), InData.Num(), Error);
+        return File.IsValid() && File->ToChunk(*this, Error);
+    }
+    
     Clear();
     
     // Read and verify magic number
@@ -530,6 +1559,8 @@ bool FBytecodeChunk::Deserialize(const TArray<uint8>& InData)
     // Read flags
     uint32 Flags = ReadInt32();
     bool bIsCompressed = (Flags & COMPRESSED_FLAG) != 0;
+    const bool bHasRegisterCode = (Flags & REGISTER_CODE_FLAG) != 0;
+    const int32 RegisterVersion = bHasRegisterCode ? ReadInt32() : 0;
     
     // Read signature
     Signature = ReadString();
@@ -694,6 +1725,20 @@ bool FBytecodeChunk::Deserialize(const TArray<uint8>& InData)
         Functions.Add(Func);
     }
     
+    // Read register section
+    if (bHasRegisterCode)
+    {
+        int32 RegisterCodeSize = ReadInt32Data();
+        if (RegisterCodeSize < 0 || DataOffset + RegisterCodeSize > UncompressedData.Num()) return false;
+        RegisterCode.Append(&UncompressedData[DataOffset], RegisterCodeSize);
+        DataOffset += RegisterCodeSize;
+        for (FFunctionInfo& Func : Functions)
+        {
+            Func.RegisterAddress = ReadInt32Data();
+            Func.NumRegisters = ReadInt32Data();
+        }
+    }
+    
     // Verify signature
     if (!VerifySignature(Signature))
     {
@@ -701,6 +1746,19 @@ bool FBytecodeChunk::Deserialize(const TArray<uint8>& InData)
         // Continue anyway for now, but log the warning
     }
     
+    // Register code from another layout version is dropped - the stack code runs everywhere
+    if (bHasRegisterCode && RegisterVersion != REGISTER_CODE_VERSION)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Bytecode register code is version %d, this build runs version %d - using the stack code"),
+            RegisterVersion, REGISTER_CODE_VERSION);
+        RegisterCode.Empty();
+        for (FFunctionInfo& Func : Functions)
+        {
+            Func.RegisterAddress = INDEX_NONE;
+            Func.NumRegisters = 0;
+        }
+    }
+    
     return true;
 }
 
@@ -835,12 +1893,8 @@ bool FBytecodeChunk::ValidateSecurity(FString& OutReason) const
         return false;
     }
     
-    // Check security verification flag
-    if (!EnumHasAnyFlags(Metadata.CompilerFlags, EScriptCompilerFlags::SecurityVerified))
-    {
-        OutReason = TEXT("Bytecode has not passed security verification");
-        return false;
-    }
+    // The SecurityVerified flag is only the compiler vouching for itself - the code is
+    // checked for real by FScriptBytecodeVerifier when the program image is built
     
     // Check engine version compatibility (optional - could be more strict)
     if (!Metadata.EngineVersion.Contains(TEXT("5.6")))
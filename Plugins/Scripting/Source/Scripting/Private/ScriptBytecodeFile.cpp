@@ -0,0 +1,893 @@
+// Copyright Vampire Game Project. All Rights Reserved.
+// Custom scripting system for secure modding support.
+
+#include "ScriptBytecodeFile.h"
+#include "Misc/FileHelper.h"
+#include "HAL/PlatformFileManager.h"
+#include "Async/MappedFileHandle.h"
+
+//=============================================================================
+// Layout
+//=============================================================================
+
+namespace
+{
+    // Magic number for mappable bytecode files: "SBC3" (after SBC1, FBytecodeChunk::Serialize's)
+    const uint32 BYTECODE_FILE_MAGIC = 0x33434253;
+    const uint32 SECTION_ALIGNMENT = 16;
+    const int32 MAX_CONSTANT_NESTING = 64;
+
+    enum ESection
+    {
+        Section_Strings,
+        Section_Metadata,
+        Section_Code,
+        Section_RegisterCode,
+        Section_Constants,
+        Section_Functions,
+        Section_LineTable,
+        Section_Count
+    };
+
+    struct FSection
+    {
+        uint32 Offset;              // From the start of the file, a multiple of SECTION_ALIGNMENT
+        uint32 Size;
+    };
+
+    struct FFileHeader
+    {
+        uint32 Magic;
+        int32 ChunkVersion;         // FBytecodeChunk::Version
+        int32 RegisterCodeVersion;  // REGISTER_CODE_VERSION of the register code, 0 without
+        uint32 FileSize;
+        FSection Sections[Section_Count];
+    };
+
+    // A string of the Strings section: Length bytes at Offset, then a NUL
+    struct FStringRef
+    {
+        uint32 Offset;
+        uint32 Length;
+    };
+
+    struct FMetadataRecord
+    {
+        int64 CompilationTicks;
+        uint32 CompilerFlags;
+        uint32 SourceFileSize;
+        uint8 CompilerType;
+        uint8 bIsMission;
+        uint8 Reserved[6];
+        FStringRef CompilerName;
+        FStringRef CompilerVersion;
+        FStringRef EngineVersion;
+        FStringRef GameName;
+        FStringRef GameVersion;
+        FStringRef AuthorName;
+        FStringRef OperatingSystem;
+        FStringRef MachineName;
+        FStringRef SourceFileName;
+        FStringRef SourceChecksum;
+        FStringRef Signature;
+        FStringRef SourceHash;
+    };
+
+    // Constants section: this, then NumRecords records, the first NumConstants of them the pool
+    struct FConstantTable
+    {
+        uint32 NumConstants;
+        uint32 NumRecords;
+        uint32 Reserved[2];
+    };
+
+    struct FConstantRecord
+    {
+        uint8 Type;                 // EValueType
+        uint8 BoolValue;
+        uint16 Reserved;
+        uint32 Num;                 // STRING: bytes, ARRAY: elements
+        uint64 Payload;             // NUMBER: the bits, STRING: offset in Strings, ARRAY: record of the first element (after this one)
+    };
+
+    struct FFunctionRecord
+    {
+        FStringRef Name;
+        FStringRef Module;
+        int32 Address;
+        int32 Arity;
+        int32 RegisterAddress;
+        int32 NumRegisters;
+    };
+
+    // LineTable section: this, then NumFiles string refs, then NumRuns FLineTable::FRun
+    struct FLineTableHeader
+    {
+        uint32 NumFiles;
+        uint32 NumRuns;
+        int32 NumBytes;
+        uint32 Reserved;
+    };
+
+    // Written and read as they are in memory: no padding, nothing wider than its alignment
+    static_assert(sizeof(FFileHeader) == 72, "FFileHeader layout");
+    static_assert(sizeof(FMetadataRecord) == 120, "FMetadataRecord layout");
+    static_assert(sizeof(FConstantTable) == 16, "FConstantTable layout");
+    static_assert(sizeof(FConstantRecord) == 16, "FConstantRecord layout");
+    static_assert(sizeof(FFunctionRecord) == 32, "FFunctionRecord layout");
+    static_assert(sizeof(FLineTableHeader) == 16, "FLineTableHeader layout");
+    static_assert(sizeof(FLineTable::FRun) == 12, "FLineTable::FRun layout");
+
+    uint32 AlignSection(uint32 Offset)
+    {
+        return (Offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+    }
+
+    template<typename RecordType>
+    void AppendRecord(TArray<uint8>& OutData, const RecordType& Record)
+    {
+        OutData.Append(reinterpret_cast<const uint8*>(&Record), sizeof(RecordType));
+    }
+
+    // Strings section being written, each string kept once
+    struct FStringBlobWriter
+    {
+        TArray<uint8> Blob;
+        TMap<FString, uint32> Offsets;
+
+        FStringRef Add(const FString& String)
+        {
+            FTCHARToUTF8 Converter(*String);
+            FStringRef Ref;
+            Ref.Length = Converter.Length();
+            if (const uint32* Existing = Offsets.Find(String))
+            {
+                Ref.Offset = *Existing;
+                return Ref;
+            }
+            Ref.Offset = Blob.Num();
+            Blob.Append(reinterpret_cast<const uint8*>(Converter.Get()), Ref.Length);
+            Blob.Add(0);
+            Offsets.Add(String, Ref.Offset);
+            return Ref;
+        }
+    };
+}
+
+//=============================================================================
+// Writing
+//=============================================================================
+
+void FScriptBytecodeFile::Write(const FBytecodeChunk& Chunk, TArray<uint8>& OutData)
+{
+    FStringBlobWriter Strings;
+
+    FMetadataRecord Metadata = {};
+    Metadata.CompilationTicks = Chunk.Metadata.CompilationTime.GetTicks();
+    Metadata.CompilerFlags = static_cast<uint32>(Chunk.Metadata.CompilerFlags);
+    Metadata.SourceFileSize = Chunk.Metadata.SourceFileSize;
+    Metadata.CompilerType = static_cast<uint8>(Chunk.Metadata.CompilerType);
+    Metadata.bIsMission = Chunk.Metadata.bIsMission ? 1 : 0;
+    Metadata.CompilerName = Strings.Add(Chunk.Metadata.CompilerName);
+    Metadata.CompilerVersion = Strings.Add(Chunk.Metadata.CompilerVersion);
+    Metadata.EngineVersion = Strings.Add(Chunk.Metadata.EngineVersion);
+    Metadata.GameName = Strings.Add(Chunk.Metadata.GameName);
+    Metadata.GameVersion = Strings.Add(Chunk.Metadata.GameVersion);
+    Metadata.AuthorName = Strings.Add(Chunk.Metadata.AuthorName);
+    Metadata.OperatingSystem = Strings.Add(Chunk.Metadata.OperatingSystem);
+    Metadata.MachineName = Strings.Add(Chunk.Metadata.MachineName);
+    Metadata.SourceFileName = Strings.Add(Chunk.Metadata.SourceFileName);
+    Metadata.SourceChecksum = Strings.Add(Chunk.Metadata.SourceChecksum);
+    Metadata.Signature = Strings.Add(Chunk.GenerateSignature());
+    Metadata.SourceHash = Strings.Add(Chunk.SourceHash);
+    TArray<uint8> MetadataData;
+    AppendRecord(MetadataData, Metadata);
+
+    // The pool, then the elements of its arrays breadth first: each array's elements
+    // are consecutive records, after the array's own
+    TArray<const FScriptValue*> Values;
+    Values.Reserve(Chunk.Constants.Num());
+    for (const FScriptValue& Constant : Chunk.Constants)
+    {
+        Values.Add(&Constant);
+    }
+    TArray<uint8> ConstantData;
+    ConstantData.Reserve(sizeof(FConstantTable) + Values.Num() * sizeof(FConstantRecord));
+    ConstantData.SetNum(sizeof(FConstantTable));
+    for (int32 i = 0; i < Values.Num(); ++i)
+    {
+        const FScriptValue& Value = *Values[i];
+        FConstantRecord Record = {};
+        Record.Type = static_cast<uint8>(Value.Type);
+        switch (Value.Type)
+        {
+            case EValueType::NIL:
+                break;
+
+            case EValueType::BOOL:
+                Record.BoolValue = Value.BoolValue ? 1 : 0;
+                break;
+
+            case EValueType::NUMBER:
+                FMemory::Memcpy(&Record.Payload, &Value.NumberValue, sizeof(Record.Payload));
+                break;
+
+            case EValueType::STRING:
+            {
+                const FStringRef Ref = Strings.Add(Value.StringValue);
+                Record.Num = Ref.Length;
+                Record.Payload = Ref.Offset;
+                break;
+            }
+
+            case EValueType::ARRAY:
+                Record.Num = Value.ArrayValue.Num();
+                Record.Payload = Values.Num();
+                for (const FScriptValue& Element : Value.ArrayValue)
+                {
+                    Values.Add(&Element);
+                }
+                break;
+        }
+        AppendRecord(ConstantData, Record);
+    }
+    FConstantTable Table = {};
+    Table.NumConstants = Chunk.Constants.Num();
+    Table.NumRecords = Values.Num();
+    const uint8* TableBytes = reinterpret_cast<const uint8*>(&Table);
+    for (int32 i = 0; i < (int32)sizeof(FConstantTable); ++i)
+    {
+        ConstantData[i] = TableBytes[i];
+    }
+
+    TArray<uint8> FunctionData;
+    FunctionData.Reserve(Chunk.Functions.Num() * sizeof(FFunctionRecord));
+    for (const FFunctionInfo& Func : Chunk.Functions)
+    {
+        FFunctionRecord Record = {};
+        Record.Name = Strings.Add(Func.Name);
+        Record.Module = Strings.Add(Func.Module);
+        Record.Address = Func.Address;
+        Record.Arity = Func.Arity;
+        Record.RegisterAddress = Func.RegisterAddress;
+        Record.NumRegisters = Func.NumRegisters;
+        AppendRecord(FunctionData, Record);
+    }
+
+    // None at all in shipping builds
+    TArray<uint8> LineData;
+    if (Chunk.LineTable.Runs.Num() > 0)
+    {
+        FLineTableHeader LineHeader = {};
+        LineHeader.NumFiles = Chunk.LineTable.Files.Num();
+        LineHeader.NumRuns = Chunk.LineTable.Runs.Num();
+        LineHeader.NumBytes = Chunk.LineTable.Num();
+        AppendRecord(LineData, LineHeader);
+        for (const FString& File : Chunk.LineTable.Files)
+        {
+            AppendRecord(LineData, Strings.Add(File));
+        }
+        LineData.Append(reinterpret_cast<const uint8*>(Chunk.LineTable.Runs.GetData()), Chunk.LineTable.Runs.Num() * sizeof(FLineTable::FRun));
+    }
+
+    // Strings last: the other sections add theirs as they are written
+    const TArray<uint8>* Sections[Section_Count] = {
+        &Strings.Blob, &MetadataData, &Chunk.Code, &Chunk.RegisterCode, &ConstantData, &FunctionData, &LineData };
+
+    FFileHeader Header = {};
+    Header.Magic = BYTECODE_FILE_MAGIC;
+    Header.ChunkVersion = Chunk.Version;
+    Header.RegisterCodeVersion = Chunk.RegisterCode.Num() > 0 ? REGISTER_CODE_VERSION : 0;
+    uint32 Offset = AlignSection(sizeof(FFileHeader));
+    for (int32 i = 0; i < Section_Count; ++i)
+    {
+        Header.Sections[i].Offset = Offset;
+        Header.Sections[i].Size = Sections[i]->Num();
+        Offset = AlignSection(Offset + Sections[i]->Num());
+    }
+    Header.FileSize = Offset;
+
+    OutData.Empty();
+    OutData.Reserve(Header.FileSize);
+    AppendRecord(OutData, Header);
+    for (int32 i = 0; i < Section_Count; ++i)
+    {
+        while ((uint32)OutData.Num() < Header.Sections[i].Offset)
+        {
+            OutData.Add(0);
+        }
+        OutData.Append(*Sections[i]);
+    }
+    while ((uint32)OutData.Num() < Header.FileSize)
+    {
+        OutData.Add(0);
+    }
+}
+
+//=============================================================================
+// Opening
+//=============================================================================
+
+FScriptBytecodeFile::FScriptBytecodeFile()
+    : Data(nullptr)
+    , Size(0)
+    , Strings(nullptr)
+    , StringsSize(0)
+    , Metadata(nullptr)
+    , Code(nullptr)
+    , CodeSize(0)
+    , RegisterCode(nullptr)
+    , RegisterCodeSize(0)
+    , ConstantRecords(nullptr)
+    , NumConstants(0)
+    , NumConstantRecords(0)
+    , FunctionRecords(nullptr)
+    , NumFunctions(0)
+    , LineFiles(nullptr)
+    , NumLineFiles(0)
+    , LineRuns(nullptr)
+    , NumLineRuns(0)
+    , NumLineBytes(0)
+{
+}
+
+FScriptBytecodeFile::~FScriptBytecodeFile()
+{
+}
+
+bool FScriptBytecodeFile::IsBytecodeFile(const uint8* Data, int64 Size)
+{
+    if (!Data || Size < 4)
+    {
+        return false;
+    }
+    uint32 Magic;
+    FMemory::Memcpy(&Magic, Data, sizeof(Magic));
+    return Magic == BYTECODE_FILE_MAGIC;
+}
+
+TSharedPtr<FScriptBytecodeFile> FScriptBytecodeFile::MapFile(const FString& FileName, FString& OutError)
+{
+    TSharedPtr<FScriptBytecodeFile> File = MakeShareable(new FScriptBytecodeFile());
+
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    FOpenMappedResult Mapped = PlatformFile.OpenMappedEx(*FileName);
+    if (Mapped.HasValue())
+    {
+        File->MappedFile = Mapped.StealValue();
+        File->MappedRegion.Reset(File->MappedFile->MapRegion(0, File->MappedFile->GetFileSize()));
+    }
+    if (File->MappedRegion.IsValid())
+    {
+        File->Data = File->MappedRegion->GetMappedPtr();
+        File->Size = File->MappedRegion->GetMappedSize();
+        return File;
+    }
+
+    // Not every platform maps files, and none maps an empty one
+    File->MappedFile.Reset();
+    if (!FFileHelper::LoadFileToArray(File->OwnedData, *FileName))
+    {
+        OutError = FString::Printf(TEXT("Failed to read bytecode file: %s"), *FileName);
+        return nullptr;
+    }
+    File->Data = File->OwnedData.GetData();
+    File->Size = File->OwnedData.Num();
+    return File;
+}
+
+TSharedPtr<FScriptBytecodeFile> FScriptBytecodeFile::Open(const FString& FileName, FString& OutError)
+{
+    TSharedPtr<FScriptBytecodeFile> File = MapFile(FileName, OutError);
+    if (!File.IsValid())
+    {
+        return nullptr;
+    }
+    if (!File->Init(OutError))
+    {
+        OutError = FString::Printf(TEXT("%s: %s"), *FileName, *OutError);
+        return nullptr;
+    }
+    return File;
+}
+
+TSharedPtr<FScriptBytecodeFile> FScriptBytecodeFile::FromMemory(TArray<uint8>&& InData, FString& OutError)
+{
+    TSharedPtr<FScriptBytecodeFile> File = MakeShareable(new FScriptBytecodeFile());
+    File->OwnedData = MoveTemp(InData);
+    File->Data = File->OwnedData.GetData();
+    File->Size = File->OwnedData.Num();
+    return File->Init(OutError) ? File : nullptr;
+}
+
+TSharedPtr<FScriptBytecodeFile> FScriptBytecodeFile::FromView(const uint8* InData, int64 InSize, FString& OutError)
+{
+    TSharedPtr<FScriptBytecodeFile> File = MakeShareable(new FScriptBytecodeFile());
+    File->Data = InData;
+    File->Size = InSize;
+    return File->Init(OutError) ? File : nullptr;
+}
+
+TSharedPtr<FBytecodeChunk> FScriptBytecodeFile::LoadChunk(const FString& FileName, FString& OutError)
+{
+    TSharedPtr<FScriptBytecodeFile> File = MapFile(FileName, OutError);
+    if (!File.IsValid())
+    {
+        return nullptr;
+    }
+
+    if (IsBytecodeFile(File->Data, File->Size))
+    {
+        if (!File->Init(OutError))
+        {
+            OutError = FString::Printf(TEXT("%s: %s"), *FileName, *OutError);
+            return nullptr;
+        }
+        TSharedPtr<FBytecodeChunk> Chunk = File->ToChunk(OutError);
+        if (!Chunk.IsValid())
+        {
+            OutError = FString::Printf(TEXT("%s: %s"), *FileName, *OutError);
+        }
+        return Chunk;
+    }
+
+    // SBC1 is parsed from an array
+    TArray<uint8> MappedData;
+    if (File->IsMapped())
+    {
+        MappedData.Append(File->Data, (int32)File->Size);
+    }
+    TSharedPtr<FBytecodeChunk> Chunk = MakeShared<FBytecodeChunk>();
+    if (!Chunk->Deserialize(File->IsMapped() ? MappedData : File->OwnedData))
+    {
+        OutError = FString::Printf(TEXT("Failed to deserialize bytecode: %s"), *FileName);
+        return nullptr;
+    }
+    return Chunk;
+}
+
+bool FScriptBytecodeFile::Init(FString& OutError)
+{
+    if (!IsBytecodeFile(Data, Size) || Size < (int64)sizeof(FFileHeader))
+    {
+        OutError = TEXT("Not a v3 bytecode file");
+        return false;
+    }
+    // Records are read in place
+    if ((reinterpret_cast<UPTRINT>(Data) & 7) != 0)
+    {
+        OutError = TEXT("Bytecode file is not 8-byte aligned in memory");
+        return false;
+    }
+
+    const FFileHeader& Header = *reinterpret_cast<const FFileHeader*>(Data);
+    if ((int64)Header.FileSize != Size)
+    {
+        OutError = FString::Printf(TEXT("Bytecode file is %lld bytes, its header says %u"), (long long)Size, Header.FileSize);
+        return false;
+    }
+    for (int32 i = 0; i < Section_Count; ++i)
+    {
+        const FSection& Section = Header.Sections[i];
+        if (Section.Offset < sizeof(FFileHeader) || Section.Offset % SECTION_ALIGNMENT != 0 ||
+            (uint64)Section.Offset + Section.Size > Header.FileSize || Section.Size > (uint32)MAX_int32)
+        {
+            OutError = FString::Printf(TEXT("Bytecode file section %d is out of bounds"), i);
+            return false;
+        }
+    }
+    auto SectionData = [this, &Header](ESection Section) { return Data + Header.Sections[Section].Offset; };
+    auto SectionSize = [&Header](ESection Section) { return Header.Sections[Section].Size; };
+
+    Strings = SectionData(Section_Strings);
+    StringsSize = SectionSize(Section_Strings);
+
+    if (SectionSize(Section_Metadata) != sizeof(FMetadataRecord))
+    {
+        OutError = TEXT("Bytecode file metadata is malformed");
+        return false;
+    }
+    Metadata = SectionData(Section_Metadata);
+
+    Code = SectionData(Section_Code);
+    CodeSize = SectionSize(Section_Code);
+
+    // Register code from another layout version is dropped - the stack code runs everywhere
+    if (Header.RegisterCodeVersion == REGISTER_CODE_VERSION)
+    {
+        RegisterCode = SectionData(Section_RegisterCode);
+        RegisterCodeSize = SectionSize(Section_RegisterCode);
+    }
+    else if (SectionSize(Section_RegisterCode) > 0)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Bytecode register code is version %d, this build runs version %d - using the stack code"),
+            Header.RegisterCodeVersion, REGISTER_CODE_VERSION);
+    }
+
+    const FConstantTable* Table = reinterpret_cast<const FConstantTable*>(SectionData(Section_Constants));
+    if (SectionSize(Section_Constants) < sizeof(FConstantTable) ||
+        (uint64)Table->NumRecords * sizeof(FConstantRecord) != SectionSize(Section_Constants) - sizeof(FConstantTable) ||
+        Table->NumConstants > Table->NumRecords)
+    {
+        OutError = TEXT("Bytecode file constant table is malformed");
+        return false;
+    }
+    ConstantRecords = SectionData(Section_Constants) + sizeof(FConstantTable);
+    NumConstants = Table->NumConstants;
+    NumConstantRecords = Table->NumRecords;
+
+    if (SectionSize(Section_Functions) % sizeof(FFunctionRecord) != 0)
+    {
+        OutError = TEXT("Bytecode file function table is malformed");
+        return false;
+    }
+    FunctionRecords = SectionData(Section_Functions);
+    NumFunctions = SectionSize(Section_Functions) / sizeof(FFunctionRecord);
+
+    if (SectionSize(Section_LineTable) > 0)
+    {
+        const FLineTableHeader* LineHeader = reinterpret_cast<const FLineTableHeader*>(SectionData(Section_LineTable));
+        if (SectionSize(Section_LineTable) < sizeof(FLineTableHeader) ||
+            sizeof(FLineTableHeader) + (uint64)LineHeader->NumFiles * sizeof(FStringRef) + (uint64)LineHeader->NumRuns * sizeof(FLineTable::FRun)
+                != SectionSize(Section_LineTable) ||
+            LineHeader->NumBytes < 0)
+        {
+            OutError = TEXT("Bytecode file line table is malformed");
+            return false;
+        }
+        LineFiles = SectionData(Section_LineTable) + sizeof(FLineTableHeader);
+        NumLineFiles = LineHeader->NumFiles;
+        LineRuns = reinterpret_cast<const FLineTable::FRun*>(LineFiles + NumLineFiles * sizeof(FStringRef));
+        NumLineRuns = LineHeader->NumRuns;
+        NumLineBytes = LineHeader->NumBytes;
+    }
+    return true;
+}
+
+//=============================================================================
+// Reading in place
+//=============================================================================
+
+int32 FScriptBytecodeFile::GetVersion() const
+{
+    return reinterpret_cast<const FFileHeader*>(Data)->ChunkVersion;
+}
+
+bool FScriptBytecodeFile::ReadString(uint64 Offset, uint32 Length, FString& OutString) const
+{
+    // In the section, NUL included
+    if (Offset + Length >= StringsSize || Strings[Offset + Length] != 0)
+    {
+        OutString = FString();
+        return false;
+    }
+    OutString = FString(UTF8_TO_TCHAR(reinterpret_cast<const ANSICHAR*>(Strings + Offset)));
+    return true;
+}
+
+bool FScriptBytecodeFile::ReadMetadata(FBytecodeMetadata& OutMetadata) const
+{
+    const FMetadataRecord& Record = *reinterpret_cast<const FMetadataRecord*>(Metadata);
+    OutMetadata.CompilerType = static_cast<ECompilerType>(Record.CompilerType);
+    OutMetadata.CompilerFlags = static_cast<EScriptCompilerFlags>(Record.CompilerFlags);
+    OutMetadata.CompilationTime = FDateTime(Record.CompilationTicks);
+    OutMetadata.SourceFileSize = Record.SourceFileSize;
+    OutMetadata.bIsMission = Record.bIsMission != 0;
+
+    bool bValid = true;
+    auto Read = [this, &bValid](const FStringRef& Ref, FString& OutString) {
+        bValid = ReadString(Ref.Offset, Ref.Length, OutString) && bValid;
+    };
+    Read(Record.CompilerName, OutMetadata.CompilerName);
+    Read(Record.CompilerVersion, OutMetadata.CompilerVersion);
+    Read(Record.EngineVersion, OutMetadata.EngineVersion);
+    Read(Record.GameName, OutMetadata.GameName);
+    Read(Record.GameVersion, OutMetadata.GameVersion);
+    Read(Record.AuthorName, OutMetadata.AuthorName);
+    Read(Record.OperatingSystem, OutMetadata.OperatingSystem);
+    Read(Record.MachineName, OutMetadata.MachineName);
+    Read(Record.SourceFileName, OutMetadata.SourceFileName);
+    Read(Record.SourceChecksum, OutMetadata.SourceChecksum);
+    return bValid;
+}
+
+FBytecodeMetadata FScriptBytecodeFile::GetMetadata() const
+{
+    FBytecodeMetadata Result;
+    ReadMetadata(Result);
+    return Result;
+}
+
+bool FScriptBytecodeFile::IsMission() const
+{
+    return reinterpret_cast<const FMetadataRecord*>(Metadata)->bIsMission != 0;
+}
+
+FString FScriptBytecodeFile::GetSignature() const
+{
+    const FStringRef& Ref = reinterpret_cast<const FMetadataRecord*>(Metadata)->Signature;
+    FString Result;
+    ReadString(Ref.Offset, Ref.Length, Result);
+    return Result;
+}
+
+FString FScriptBytecodeFile::GetSourceHash() const
+{
+    const FStringRef& Ref = reinterpret_cast<const FMetadataRecord*>(Metadata)->SourceHash;
+    FString Result;
+    ReadString(Ref.Offset, Ref.Length, Result);
+    return Result;
+}
+
+bool FScriptBytecodeFile::ReadFunction(int32 Index, FFunctionInfo& OutFunction) const
+{
+    if (Index < 0 || Index >= NumFunctions)
+    {
+        return false;
+    }
+    const FFunctionRecord& Record = reinterpret_cast<const FFunctionRecord*>(FunctionRecords)[Index];
+    OutFunction.Address = Record.Address;
+    OutFunction.Arity = Record.Arity;
+    OutFunction.RegisterAddress = RegisterCodeSize > 0 ? Record.RegisterAddress : INDEX_NONE;
+    OutFunction.NumRegisters = RegisterCodeSize > 0 ? Record.NumRegisters : 0;
+    const bool bName = ReadString(Record.Name.Offset, Record.Name.Length, OutFunction.Name);
+    const bool bModule = ReadString(Record.Module.Offset, Record.Module.Length, OutFunction.Module);
+    return bName && bModule;
+}
+
+FFunctionInfo FScriptBytecodeFile::GetFunction(int32 Index) const
+{
+    FFunctionInfo Result;
+    ReadFunction(Index, Result);
+    return Result;
+}
+
+int32 FScriptBytecodeFile::FindFunction(const FString& Name) const
+{
+    FTCHARToUTF8 Converter(*Name);
+    const uint32 Length = Converter.Length();
+    const FFunctionRecord* Records = reinterpret_cast<const FFunctionRecord*>(FunctionRecords);
+    for (int32 i = 0; i < NumFunctions; ++i)
+    {
+        const FStringRef& Ref = Records[i].Name;
+        if (Ref.Length != Length || (uint64)Ref.Offset + Length >= StringsSize)
+        {
+            continue;
+        }
+        const uint8* Candidate = Strings + Ref.Offset;
+        uint32 Same = 0;
+        while (Same < Length && Candidate[Same] == static_cast<uint8>(Converter.Get()[Same]))
+        {
+            Same++;
+        }
+        if (Same == Length)
+        {
+            return i;
+        }
+    }
+    return INDEX_NONE;
+}
+
+int32 FScriptBytecodeFile::GetLine(int32 Offset) const
+{
+    if (Offset < 0 || Offset >= NumLineBytes || NumLineRuns == 0)
+    {
+        return 0;
+    }
+
+    // Last run starting at or before Offset, as FLineTable::Find
+    int32 Low = 0;
+    int32 High = NumLineRuns - 1;
+    while (Low < High)
+    {
+        const int32 Mid = (Low + High + 1) / 2;
+        if (LineRuns[Mid].Offset <= Offset)
+        {
+            Low = Mid;
+        }
+        else
+        {
+            High = Mid - 1;
+        }
+    }
+    return LineRuns[Low].Offset <= Offset ? LineRuns[Low].Line : 0;
+}
+
+FString FScriptBytecodeFile::GetFile(int32 Offset) const
+{
+    if (Offset < 0 || Offset >= NumLineBytes || NumLineRuns == 0)
+    {
+        return FString();
+    }
+
+    int32 Low = 0;
+    int32 High = NumLineRuns - 1;
+    while (Low < High)
+    {
+        const int32 Mid = (Low + High + 1) / 2;
+        if (LineRuns[Mid].Offset <= Offset)
+        {
+            Low = Mid;
+        }
+        else
+        {
+            High = Mid - 1;
+        }
+    }
+
+    FString Result;
+    const int32 File = LineRuns[Low].File;
+    if (LineRuns[Low].Offset <= Offset && File >= 0 && File < NumLineFiles)
+    {
+        const FStringRef& Ref = reinterpret_cast<const FStringRef*>(LineFiles)[File];
+        ReadString(Ref.Offset, Ref.Length, Result);
+    }
+    return Result;
+}
+
+//=============================================================================
+// Constants
+//=============================================================================
+
+bool FScriptBytecodeFile::ReadValue(uint32 Record, int32 Depth, int64& Budget, FScriptValue& OutValue) const
+{
+    OutValue = FScriptValue();
+    if (Record >= NumConstantRecords || Depth > MAX_CONSTANT_NESTING || --Budget < 0)
+    {
+        return false;
+    }
+
+    const FConstantRecord& Constant = reinterpret_cast<const FConstantRecord*>(ConstantRecords)[Record];
+    switch (static_cast<EValueType>(Constant.Type))
+    {
+        case EValueType::NIL:
+            return true;
+
+        case EValueType::BOOL:
+            OutValue = FScriptValue::Bool(Constant.BoolValue != 0);
+            return true;
+
+        case EValueType::NUMBER:
+        {
+            double Number = 0.0;
+            FMemory::Memcpy(&Number, &Constant.Payload, sizeof(Number));
+            OutValue = FScriptValue::Number(Number);
+            return true;
+        }
+
+        case EValueType::STRING:
+            OutValue.Type = EValueType::STRING;
+            return ReadString(Constant.Payload, Constant.Num, OutValue.StringValue);
+
+        case EValueType::ARRAY:
+        {
+            // Elements come after the array, which bounds the nesting to the records there are
+            if (Constant.Payload <= Record || Constant.Payload + Constant.Num > NumConstantRecords)
+            {
+                return false;
+            }
+            OutValue.Type = EValueType::ARRAY;
+            OutValue.ArrayValue.SetNum(Constant.Num);
+            for (uint32 i = 0; i < Constant.Num; ++i)
+            {
+                if (!ReadValue((uint32)Constant.Payload + i, Depth + 1, Budget, OutValue.ArrayValue[i]))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+const FScriptValue& FScriptBytecodeFile::GetConstant(int32 Index) const
+{
+    static const FScriptValue NilValue;
+    if (Index < 0 || Index >= NumConstants)
+    {
+        return NilValue;
+    }
+
+    // Sized on first use: a file some of whose constants are read pays for none of the others
+    if (Constants.Num() == 0)
+    {
+        Constants.SetNum(NumConstants);
+        ConstantsBuilt.Init(false, NumConstants);
+    }
+    if (!ConstantsBuilt[Index])
+    {
+        int64 Budget = NumConstantRecords;
+        FScriptValue Value;
+        if (ReadValue(Index, 0, Budget, Value))
+        {
+            Constants[Index] = MoveTemp(Value);
+        }
+        ConstantsBuilt[Index] = true;
+    }
+    return Constants[Index];
+}
+
+//=============================================================================
+// Chunk
+//=============================================================================
+
+bool FScriptBytecodeFile::ToChunk(FBytecodeChunk& OutChunk, FString& OutError) const
+{
+    OutChunk.Clear();
+    OutChunk.Functions.Empty();
+    OutChunk.Version = GetVersion();
+
+    const FMetadataRecord& Record = *reinterpret_cast<const FMetadataRecord*>(Metadata);
+    if (!ReadMetadata(OutChunk.Metadata) ||
+        !ReadString(Record.Signature.Offset, Record.Signature.Length, OutChunk.Signature) ||
+        !ReadString(Record.SourceHash.Offset, Record.SourceHash.Length, OutChunk.SourceHash))
+    {
+        OutError = TEXT("Bytecode file metadata is malformed");
+        return false;
+    }
+
+    OutChunk.Code.Append(Code, CodeSize);
+    OutChunk.RegisterCode.Append(RegisterCode, RegisterCodeSize);
+
+    // Each record of a well-formed file is read once, as the pool or as an element
+    int64 Budget = NumConstantRecords;
+    OutChunk.Constants.SetNum(NumConstants);
+    for (int32 i = 0; i < NumConstants; ++i)
+    {
+        if (!ReadValue(i, 0, Budget, OutChunk.Constants[i]))
+        {
+            OutError = FString::Printf(TEXT("Bytecode file constant %d is malformed"), i);
+            return false;
+        }
+    }
+
+    OutChunk.Functions.SetNum(NumFunctions);
+    for (int32 i = 0; i < NumFunctions; ++i)
+    {
+        if (!ReadFunction(i, OutChunk.Functions[i]))
+        {
+            OutError = FString::Printf(TEXT("Bytecode file function %d is malformed"), i);
+            return false;
+        }
+    }
+
+    if (NumLineRuns > 0)
+    {
+        TArray<FString> Files;
+        Files.SetNum(NumLineFiles);
+        const FStringRef* FileRefs = reinterpret_cast<const FStringRef*>(LineFiles);
+        for (int32 i = 0; i < NumLineFiles; ++i)
+        {
+            if (!ReadString(FileRefs[i].Offset, FileRefs[i].Length, Files[i]))
+            {
+                OutError = TEXT("Bytecode file line table is malformed");
+                return false;
+            }
+        }
+        for (int32 i = 0; i < NumLineRuns; ++i)
+        {
+            const FLineTable::FRun& Run = LineRuns[i];
+            const int32 End = (i + 1 < NumLineRuns) ? LineRuns[i + 1].Offset : NumLineBytes;
+            // From 0, by offset, none empty
+            if ((i == 0 && Run.Offset != 0) || End <= Run.Offset || Run.File < 0 || Run.File >= NumLineFiles)
+            {
+                OutError = TEXT("Bytecode file line table is malformed");
+                return false;
+            }
+            OutChunk.LineTable.Add(Run.Line, Files[Run.File], End - Run.Offset);
+        }
+    }
+
+    if (!OutChunk.VerifySignature(OutChunk.Signature))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Bytecode signature verification failed! File may be corrupted or tampered with."));
+    }
+    return true;
+}
+
+TSharedPtr<FBytecodeChunk> FScriptBytecodeFile::ToChunk(FString& OutError) const
+{
+    TSharedPtr<FBytecodeChunk> Chunk = MakeShared<FBytecodeChunk>();
+    return ToChunk(*Chunk, OutError) ? Chunk : nullptr;
+}
@@ -0,0 +1,846 @@
+// Copyright Vampire Game Project. All Rights Reserved.
+// Custom scripting system for secure modding support.
+
+#include "ScriptBytecodeVerifier.h"
+#include "ScriptLogger.h"
+
+namespace
+{
+    uint16 ReadShortAt(const TArray<uint8>& Code, int32 Offset)
+    {
+        return (uint16)((Code[Offset] << 8) | Code[Offset + 1]);
+    }
+
+    uint32 ReadLongAt(const TArray<uint8>& Code, int32 Offset)
+    {
+        return ((uint32)Code[Offset] << 24) | ((uint32)Code[Offset + 1] << 16) | ((uint32)Code[Offset + 2] << 8) | Code[Offset + 3];
+    }
+
+    bool IsWideJump(EOpCode OpCode)
+    {
+        return OpCode == EOpCode::OP_JUMP_WIDE || OpCode == EOpCode::OP_JUMP_IF_FALSE_WIDE || OpCode == EOpCode::OP_LOOP_WIDE ||
+            OpCode == EOpCode::OP_FOREACH_WIDE;
+    }
+
+    bool IsJump(EOpCode OpCode)
+    {
+        return OpCode == EOpCode::OP_JUMP || OpCode == EOpCode::OP_JUMP_IF_FALSE || OpCode == EOpCode::OP_LOOP ||
+            OpCode == EOpCode::OP_FOR_PREP || OpCode == EOpCode::OP_FOR_LOOP || OpCode == EOpCode::OP_FOREACH ||
+            IsWideJump(OpCode);
+    }
+
+    /**
+     * Absolute target of a jump instruction starting at Offset (may be negative or past the end)
+     * The offset is always the last operand, relative to the next instruction.
+     */
+    int32 GetJumpTarget(const TArray<uint8>& Code, int32 Offset, EOpCode OpCode)
+    {
+        const int32 Next = Offset + FScriptBytecodeVerifier::GetInstructionSize(OpCode);
+        const int64 Distance = IsWideJump(OpCode) ? (int64)ReadLongAt(Code, Next - 4) : (int64)ReadShortAt(Code, Next - 2);
+        const bool bBackward = OpCode == EOpCode::OP_LOOP || OpCode == EOpCode::OP_FOR_LOOP || OpCode == EOpCode::OP_LOOP_WIDE;
+        // Clamped: anything before the start is -1, anything past the end is treated as the end
+        return (int32)FMath::Clamp<int64>(bBackward ? Next - Distance : Next + Distance, -1, Code.Num());
+    }
+
+    /** Constant index (OP_CONSTANT, the global opcodes) or frame slot (locals, loops) of the instruction at Offset */
+    int32 GetIndexOperand(const TArray<uint8>& Code, int32 Offset)
+    {
+        switch (static_cast<EOpCode>(Code[Offset]))
+        {
+            case EOpCode::OP_CONSTANT_WIDE:
+            case EOpCode::OP_DEFINE_GLOBAL_WIDE:
+            case EOpCode::OP_GET_GLOBAL_WIDE:
+            case EOpCode::OP_SET_GLOBAL_WIDE:
+                return (Code[Offset + 1] << 16) | ReadShortAt(Code, Offset + 2);
+
+            case EOpCode::OP_GET_LOCAL_WIDE:
+            case EOpCode::OP_SET_LOCAL_WIDE:
+            case EOpCode::OP_FOREACH_WIDE:
+                return ReadShortAt(Code, Offset + 1);
+
+            default:
+                return Code[Offset + 1];
+        }
+    }
+
+    bool IsStringConstant(const FBytecodeChunk& Chunk, int32 Index)
+    {
+        return Chunk.Constants.IsValidIndex(Index) && Chunk.Constants[Index].IsString();
+    }
+
+    bool IsSwitch(EOpCode OpCode)
+    {
+        return OpCode == EOpCode::OP_SWITCH_TABLE || OpCode == EOpCode::OP_SWITCH_LOOKUP;
+    }
+
+    /** Absolute targets of the switch instruction at Offset, the default first */
+    void GetSwitchTargets(const TArray<uint8>& Code, int32 Offset, TArray<int32>& OutTargets)
+    {
+        const EOpCode OpCode = static_cast<EOpCode>(Code[Offset]);
+        const int32 Header = FScriptBytecodeVerifier::GetInstructionSize(OpCode);
+        const int32 Count = ReadShortAt(Code, Offset + Header - 4);
+        const int32 Next = Offset + Header + Count * 2;
+
+        OutTargets.Reset();
+        OutTargets.Add(Next + ReadShortAt(Code, Offset + Header - 2));
+        for (int32 i = 0; i < Count; ++i)
+        {
+            OutTargets.Add(Next + ReadShortAt(Code, Offset + Header + i * 2));
+        }
+    }
+
+    /** The keys of an OP_SWITCH_LOOKUP are Count integers or Count strings, strictly ascending */
+    bool IsValidSwitchKeys(const FBytecodeChunk& Chunk, int32 Index, int32 Count)
+    {
+        if (!Chunk.Constants.IsValidIndex(Index) || !Chunk.Constants[Index].IsArray())
+        {
+            return false;
+        }
+        const TArray<FScriptValue>& Keys = Chunk.Constants[Index].AsArray();
+        if (Keys.Num() != Count)
+        {
+            return false;
+        }
+        for (int32 i = 0; i < Keys.Num(); ++i)
+        {
+            const FScriptValue& Key = Keys[i];
+            if (Key.IsNumber())
+            {
+                if (Key.AsNumber() != FMath::RoundToDouble(Key.AsNumber()) || !Keys[0].IsNumber() ||
+                    (i > 0 && Keys[i - 1].AsNumber() >= Key.AsNumber()))
+                {
+                    return false;
+                }
+            }
+            else if (Key.IsString())
+            {
+                if (!Keys[0].IsString() || (i > 0 && Keys[i - 1].AsString().Compare(Key.AsString(), ESearchCase::CaseSensitive) >= 0))
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Check the register code of one function, [Start, End) of the chunk's RegisterCode
+     * The register loop has no checked variant, so everything it indexes is proven here.
+     */
+    void VerifyRegisterFunction(const FBytecodeChunk& Chunk, const FFunctionInfo& Function, int32 Start, int32 End, TArray<FString>& OutErrors)
+    {
+        const TArray<uint8>& Code = Chunk.RegisterCode;
+        const int32 NumRegisters = Function.NumRegisters;
+        const int32 NumErrors = OutErrors.Num();
+        auto AddError = [&](int32 Offset, const FString& Message)
+        {
+            OutErrors.Add(FString::Printf(TEXT("Register code of '%s', offset %d: %s"), *Function.Name, Offset, *Message));
+        };
+
+        if (NumRegisters < FMath::Max(Function.Arity, 1) || NumRegisters > 256)
+        {
+            AddError(Start, FString::Printf(TEXT("Invalid frame size %d"), NumRegisters));
+            return;
+        }
+
+        TArray<uint8> InstructionStart;
+        InstructionStart.Init(0, End - Start);
+        TArray<TPair<int32, int32>> Jumps;     // Instruction, target
+
+        int32 Offset = Start;
+        while (Offset < End && OutErrors.Num() == NumErrors)
+        {
+            const int32 Instruction = Offset;
+            const ERegOpCode OpCode = static_cast<ERegOpCode>(Code[Offset++]);
+            const TCHAR* Operands = GetRegisterOperands(OpCode);
+            if (!Operands)
+            {
+                AddError(Instruction, FString::Printf(TEXT("Unknown opcode %d"), (int32)OpCode));
+                return;
+            }
+            InstructionStart[Instruction - Start] = 1;
+
+            int32 FirstRegister = INDEX_NONE;
+            int32 Count = 0;
+            int32 Constant = INDEX_NONE;
+            int32 FuncIndex = INDEX_NONE;
+            for (const TCHAR* Kind = Operands; *Kind; ++Kind)
+            {
+                const int32 Size = (*Kind == 'K' || *Kind == 'F' || *Kind == 'J') ? 2 : 1;
+                if (Offset + Size > End)
+                {
+                    AddError(Instruction, TEXT("Instruction operands run past the end of the function"));
+                    return;
+                }
+                switch (*Kind)
+                {
+                    case 'R':
+                        if (Code[Offset] >= NumRegisters)
+                        {
+                            AddError(Instruction, FString::Printf(TEXT("Register %d out of range"), (int32)Code[Offset]));
+                        }
+                        FirstRegister = (FirstRegister == INDEX_NONE) ? Code[Offset] : FirstRegister;
+                        break;
+                    case 'N':
+                        Count = Code[Offset];
+                        if (Offset + 1 + Count > End)
+                        {
+                            AddError(Instruction, TEXT("Instruction operands run past the end of the function"));
+                            return;
+                        }
+                        for (int32 i = 1; i <= Count; ++i)
+                        {
+                            if (Code[Offset + i] >= NumRegisters)
+                            {
+                                AddError(Instruction, FString::Printf(TEXT("Register %d out of range"), (int32)Code[Offset + i]));
+                            }
+                        }
+                        Offset += Count;
+                        break;
+                    case 'K':
+                        Constant = ReadShortAt(Code, Offset);
+                        break;
+                    case 'F':
+                        FuncIndex = ReadShortAt(Code, Offset);
+                        break;
+                    case 'J':
+                        Jumps.Add(TPair<int32, int32>(Instruction, Offset + 2 + (int16)ReadShortAt(Code, Offset)));
+                        break;
+                    default:
+                        break;
+                }
+                Offset += Size;
+            }
+
+            switch (OpCode)
+            {
+                case ERegOpCode::REG_LOAD_CONSTANT:
+                    if (!Chunk.Constants.IsValidIndex(Constant))
+                    {
+                        AddError(Instruction, FString::Printf(TEXT("Constant index %d out of range"), Constant));
+                    }
+                    break;
+
+                case ERegOpCode::REG_GET_GLOBAL:
+                case ERegOpCode::REG_SET_GLOBAL:
+                case ERegOpCode::REG_GET_FIELD:
+                case ERegOpCode::REG_SET_FIELD:
+                case ERegOpCode::REG_CALL_NATIVE:
+                    if (!IsStringConstant(Chunk, Constant))
+                    {
+                        AddError(Instruction, FString::Printf(TEXT("Name constant %d is not a string"), Constant));
+                    }
+                    else if (OpCode == ERegOpCode::REG_CALL_NATIVE && Count > NATIVE_CALL_ARGC_MASK)
+                    {
+                        AddError(Instruction, FString::Printf(TEXT("Native call passes %d arguments"), Count));
+                    }
+                    break;
+
+                case ERegOpCode::REG_CALL:
+                case ERegOpCode::REG_TAIL_CALL:
+                    if (!Chunk.Functions.IsValidIndex(FuncIndex))
+                    {
+                        AddError(Instruction, FString::Printf(TEXT("Function index %d out of range"), FuncIndex));
+                    }
+                    else if (Chunk.Functions[FuncIndex].Arity != Count)
+                    {
+                        AddError(Instruction, FString::Printf(TEXT("Call to '%s' passes %d argument(s), function takes %d"),
+                            *Chunk.Functions[FuncIndex].Name, Count, Chunk.Functions[FuncIndex].Arity));
+                    }
+                    break;
+
+                case ERegOpCode::REG_FOR_PREP:
+                case ERegOpCode::REG_FOR_LOOP:
+                case ERegOpCode::REG_FOREACH:
+                    if (FirstRegister + 2 >= NumRegisters)
+                    {
+                        AddError(Instruction, FString::Printf(TEXT("Loop registers %d..%d out of range"), FirstRegister, FirstRegister + 2));
+                    }
+                    break;
+
+                default:
+                    break;
+            }
+
+            // Only a jump, return or tail call may end the function
+            const bool bFallsThrough = OpCode != ERegOpCode::REG_JUMP && OpCode != ERegOpCode::REG_RETURN && OpCode != ERegOpCode::REG_TAIL_CALL;
+            if (bFallsThrough && Offset >= End)
+            {
+                AddError(Instruction, TEXT("Execution runs past the end of the function"));
+            }
+        }
+
+        for (const TPair<int32, int32>& Jump : Jumps)
+        {
+            if (Jump.Value < Start || Jump.Value >= End || !InstructionStart[Jump.Value - Start])
+            {
+                AddError(Jump.Key, FString::Printf(TEXT("Jump target %d is not an instruction of the function"), Jump.Value));
+            }
+        }
+    }
+}
+
+int32 FScriptBytecodeVerifier::GetInstructionSize(EOpCode OpCode)
+{
+    switch (OpCode)
+    {
+        case EOpCode::OP_NIL:
+        case EOpCode::OP_TRUE:
+        case EOpCode::OP_FALSE:
+        case EOpCode::OP_ADD:
+        case EOpCode::OP_SUBTRACT:
+        case EOpCode::OP_MULTIPLY:
+        case EOpCode::OP_DIVIDE:
+        case EOpCode::OP_MODULO:
+        case EOpCode::OP_NEGATE:
+        case EOpCode::OP_EQUAL:
+        case EOpCode::OP_NOT_EQUAL:
+        case EOpCode::OP_GREATER:
+        case EOpCode::OP_GREATER_EQUAL:
+        case EOpCode::OP_LESS:
+        case EOpCode::OP_LESS_EQUAL:
+        case EOpCode::OP_NOT:
+        case EOpCode::OP_AND:
+        case EOpCode::OP_OR:
+        case EOpCode::OP_BIT_AND:
+        case EOpCode::OP_BIT_OR:
+        case EOpCode::OP_BIT_XOR:
+        case EOpCode::OP_BIT_NOT:
+        case EOpCode::OP_RETURN:
+        case EOpCode::OP_CAST_INT:
+        case EOpCode::OP_CAST_FLOAT:
+        case EOpCode::OP_CAST_STRING:
+        case EOpCode::OP_POP:
+        case EOpCode::OP_PRINT:
+        case EOpCode::OP_GET_ELEMENT:
+        case EOpCode::OP_SET_ELEMENT:
+        case EOpCode::OP_DUPLICATE:
+        case EOpCode::OP_HALT:
+        case EOpCode::OP_ADD_NUMBER:
+        case EOpCode::OP_SUBTRACT_NUMBER:
+        case EOpCode::OP_MULTIPLY_NUMBER:
+        case EOpCode::OP_LESS_NUMBER:
+        case EOpCode::OP_GREATER_NUMBER:
+        case EOpCode::OP_NOT_LESS_NUMBER:
+        case EOpCode::OP_NOT_GREATER_NUMBER:
+            return 1;
+
+        case EOpCode::OP_CONSTANT:
+        case EOpCode::OP_DEFINE_GLOBAL:
+        case EOpCode::OP_GET_GLOBAL:
+        case EOpCode::OP_SET_GLOBAL:
+        case EOpCode::OP_GET_LOCAL:
+        case EOpCode::OP_SET_LOCAL:
+        case EOpCode::OP_CREATE_ARRAY:
+            return 2;
+
+        case EOpCode::OP_JUMP:
+        case EOpCode::OP_JUMP_IF_FALSE:
+        case EOpCode::OP_LOOP:
+        case EOpCode::OP_GET_FIELD:
+        case EOpCode::OP_SET_FIELD:
+            return 3;
+
+        case EOpCode::OP_CALL:
+        case EOpCode::OP_CALL_NATIVE:
+        case EOpCode::OP_TAIL_CALL:
+        case EOpCode::OP_FOREACH:
+            return 4;
+
+        case EOpCode::OP_FOR_PREP:
+        case EOpCode::OP_FOR_LOOP:
+            return 5;
+
+        case EOpCode::OP_SWITCH_TABLE:
+            return SWITCH_TABLE_HEADER_SIZE;
+        case EOpCode::OP_SWITCH_LOOKUP:
+            return SWITCH_LOOKUP_HEADER_SIZE;
+
+        case EOpCode::OP_GET_LOCAL_WIDE:
+        case EOpCode::OP_SET_LOCAL_WIDE:
+            return 3;
+
+        case EOpCode::OP_CONSTANT_WIDE:
+        case EOpCode::OP_DEFINE_GLOBAL_WIDE:
+        case EOpCode::OP_GET_GLOBAL_WIDE:
+        case EOpCode::OP_SET_GLOBAL_WIDE:
+            return 4;
+
+        case EOpCode::OP_JUMP_WIDE:
+        case EOpCode::OP_JUMP_IF_FALSE_WIDE:
+        case EOpCode::OP_LOOP_WIDE:
+            return 5;
+
+        case EOpCode::OP_FOREACH_WIDE:
+            return 7;
+
+        default:
+            // OP_BREAK / OP_CONTINUE are reserved - the compiler lowers them to jumps
+            return 0;
+    }
+}
+
+int32 FScriptBytecodeVerifier::GetInstructionSize(const TArray<uint8>& Code, int32 Offset)
+{
+    const EOpCode OpCode = static_cast<EOpCode>(Code[Offset]);
+    const int32 Size = GetInstructionSize(OpCode);
+    if (!IsSwitch(OpCode))
+    {
+        return Size;
+    }
+    if (Offset + Size > Code.Num())
+    {
+        return 0;
+    }
+    // The case count sits just before the default offset
+    return Size + ReadShortAt(Code, Offset + Size - 4) * 2;
+}
+
+bool FScriptBytecodeVerifier::Verify(const FBytecodeChunk& Chunk, FBytecodeVerifyResult& OutResult)
+{
+    OutResult = FBytecodeVerifyResult();
+
+    const TArray<uint8>& Code = Chunk.Code;
+    const int32 CodeSize = Code.Num();
+    const TArray<FFunctionInfo>& Functions = Chunk.Functions;
+
+    auto AddError = [&OutResult](int32 Offset, const FString& Message)
+    {
+        OutResult.Errors.Add(FString::Printf(TEXT("Offset %d: %s"), Offset, *Message));
+    };
+
+    //=========================================================================
+    // Pass 1: decode linearly, check operands
+    //=========================================================================
+
+    TArray<uint8> InstructionStart;
+    InstructionStart.Init(0, CodeSize);
+
+    int32 Offset = 0;
+    while (Offset < CodeSize)
+    {
+        const EOpCode OpCode = static_cast<EOpCode>(Code[Offset]);
+        const int32 Size = GetInstructionSize(Code, Offset);
+        if (Size == 0)
+        {
+            // Cannot find the next instruction boundary - stop decoding
+            AddError(Offset, GetInstructionSize(OpCode) == 0 ? FString::Printf(TEXT("Unknown opcode %d"), (int32)Code[Offset])
+                : FString(TEXT("Instruction operands run past the end of the code")));
+            return false;
+        }
+        if (Offset + Size > CodeSize)
+        {
+            AddError(Offset, TEXT("Instruction operands run past the end of the code"));
+            return false;
+        }
+
+        InstructionStart[Offset] = 1;
+
+        switch (OpCode)
+        {
+            case EOpCode::OP_CONSTANT:
+            case EOpCode::OP_CONSTANT_WIDE:
+                if (GetIndexOperand(Code, Offset) >= Chunk.Constants.Num())
+                {
+                    AddError(Offset, FString::Printf(TEXT("Constant index %d out of range"), GetIndexOperand(Code, Offset)));
+                }
+                break;
+
+            case EOpCode::OP_DEFINE_GLOBAL:
+            case EOpCode::OP_GET_GLOBAL:
+            case EOpCode::OP_SET_GLOBAL:
+            case EOpCode::OP_DEFINE_GLOBAL_WIDE:
+            case EOpCode::OP_GET_GLOBAL_WIDE:
+            case EOpCode::OP_SET_GLOBAL_WIDE:
+                if (!IsStringConstant(Chunk, GetIndexOperand(Code, Offset)))
+                {
+                    AddError(Offset, FString::Printf(TEXT("Global name constant %d is not a string"), GetIndexOperand(Code, Offset)));
+                }
+                break;
+
+            case EOpCode::OP_GET_FIELD:
+            case EOpCode::OP_SET_FIELD:
+                if (!IsStringConstant(Chunk, ReadShortAt(Code, Offset + 1)))
+                {
+                    AddError(Offset, FString::Printf(TEXT("Field name constant %d is not a string"), (int32)ReadShortAt(Code, Offset + 1)));
+                }
+                break;
+
+            case EOpCode::OP_CALL_NATIVE:
+                if (!IsStringConstant(Chunk, ReadShortAt(Code, Offset + 2)))
+                {
+                    AddError(Offset, FString::Printf(TEXT("Native name constant %d is not a string"), (int32)ReadShortAt(Code, Offset + 2)));
+                }
+                break;
+
+            case EOpCode::OP_CALL:
+            case EOpCode::OP_TAIL_CALL:
+            {
+                const int32 ArgCount = Code[Offset + 1];
+                const int32 FuncIndex = ReadShortAt(Code, Offset + 2);
+                if (!Functions.IsValidIndex(FuncIndex))
+                {
+                    AddError(Offset, FString::Printf(TEXT("Function index %d out of range"), FuncIndex));
+                }
+                else if (Functions[FuncIndex].Arity != ArgCount)
+                {
+                    AddError(Offset, FString::Printf(TEXT("Call to '%s' passes %d argument(s), function takes %d"),
+                        *Functions[FuncIndex].Name, ArgCount, Functions[FuncIndex].Arity));
+                }
+                break;
+            }
+
+            case EOpCode::OP_LOOP:
+            case EOpCode::OP_FOR_LOOP:
+            case EOpCode::OP_LOOP_WIDE:
+                if (GetJumpTarget(Code, Offset, OpCode) < 0)
+                {
+                    AddError(Offset, TEXT("Loop target before the start of the code"));
+                }
+                break;
+
+            case EOpCode::OP_SWITCH_LOOKUP:
+                if (!IsValidSwitchKeys(Chunk, ReadShortAt(Code, Offset + 1), ReadShortAt(Code, Offset + 3)))
+                {
+                    AddError(Offset, FString::Printf(TEXT("Switch keys constant %d is not a sorted array of %d integers or strings"),
+                        (int32)ReadShortAt(Code, Offset + 1), (int32)ReadShortAt(Code, Offset + 3)));
+                }
+                break;
+
+            default:
+                break;
+        }
+
+        Offset += Size;
+    }
+
+    //=========================================================================
+    // Pass 2: control transfers land on instruction boundaries
+    //=========================================================================
+
+    TArray<int32> SwitchTargets;
+    for (Offset = 0; Offset < CodeSize; Offset += GetInstructionSize(Code, Offset))
+    {
+        const EOpCode OpCode = static_cast<EOpCode>(Code[Offset]);
+        if (IsSwitch(OpCode))
+        {
+            GetSwitchTargets(Code, Offset, SwitchTargets);
+            for (int32 Target : SwitchTargets)
+            {
+                if (Target < CodeSize && !InstructionStart[Target])
+                {
+                    AddError(Offset, FString::Printf(TEXT("Switch target %d is inside an instruction"), Target));
+                }
+            }
+            continue;
+        }
+        if (!IsJump(OpCode))
+        {
+            continue;
+        }
+
+        // Jumping at or past the end leaves the dispatch loop, like falling off the end
+        const int32 Target = GetJumpTarget(Code, Offset, OpCode);
+        if (Target >= 0 && Target < CodeSize && !InstructionStart[Target])
+        {
+            AddError(Offset, FString::Printf(TEXT("Jump target %d is inside an instruction"), Target));
+        }
+    }
+
+    for (const FFunctionInfo& Function : Functions)
+    {
+        if (Function.Arity < 0 || Function.Address < 0 || Function.Address > CodeSize ||
+            (Function.Address < CodeSize && !InstructionStart[Function.Address]))
+        {
+            OutResult.Errors.Add(FString::Printf(TEXT("Function '%s' has invalid address %d or arity %d"),
+                *Function.Name, Function.Address, Function.Arity));
+        }
+    }
+
+    // Register code: each function runs from its entry up to the next entry
+    if (Chunk.RegisterCode.Num() > 0)
+    {
+        // Only addresses inside the code bound the function before them
+        const int32 RegisterCodeSize = Chunk.RegisterCode.Num();
+        TArray<int32> Entries;
+        for (const FFunctionInfo& Function : Functions)
+        {
+            if (Function.RegisterAddress == INDEX_NONE)
+            {
+                continue;
+            }
+            if (Function.RegisterAddress < 0 || Function.RegisterAddress >= RegisterCodeSize)
+            {
+                OutResult.Errors.Add(FString::Printf(TEXT("Function '%s' has invalid register address %d"),
+                    *Function.Name, Function.RegisterAddress));
+                continue;
+            }
+            Entries.AddUnique(Function.RegisterAddress);
+        }
+        Entries.Sort();
+        for (const FFunctionInfo& Function : Functions)
+        {
+            const int32 Index = Entries.Find(Function.RegisterAddress);
+            if (Index == INDEX_NONE)
+            {
+                continue;
+            }
+            const int32 End = Entries.IsValidIndex(Index + 1) ? FMath::Min(Entries[Index + 1], RegisterCodeSize) : RegisterCodeSize;
+            VerifyRegisterFunction(Chunk, Function, Function.RegisterAddress, End, OutResult.Errors);
+        }
+    }
+    else
+    {
+        for (const FFunctionInfo& Function : Functions)
+        {
+            if (Function.RegisterAddress != INDEX_NONE)
+            {
+                OutResult.Errors.Add(FString::Printf(TEXT("Function '%s' has a register address but the chunk has no register code"),
+                    *Function.Name));
+            }
+        }
+    }
+
+    if (OutResult.Errors.Num() > 0)
+    {
+        return false;
+    }
+    OutResult.bValid = true;
+
+    //=========================================================================
+    // Pass 3: stack heights (relative to the frame base)
+    //=========================================================================
+
+    TArray<int32> Heights;
+    Heights.Init(INDEX_NONE, CodeSize);
+    TArray<int32> Worklist;
+
+    // Records the height a control transfer arrives with; false on a conflicting merge
+    auto Reach = [&](int32 From, int32 Target, int32 Height) -> bool
+    {
+        if (Target >= CodeSize)
+        {
+            return true;
+        }
+        if (Heights[Target] == INDEX_NONE)
+        {
+            Heights[Target] = Height;
+            Worklist.Add(Target);
+            return true;
+        }
+        if (Heights[Target] != Height)
+        {
+            OutResult.StackFailure = FString::Printf(TEXT("Offset %d: reached from %d with stack height %d, expected %d"),
+                Target, From, Height, Heights[Target]);
+            return false;
+        }
+        return true;
+    };
+
+    bool bConsistent = Reach(INDEX_NONE, 0, 0);
+    for (int32 i = 0; i < Functions.Num() && bConsistent; ++i)
+    {
+        bConsistent = Reach(INDEX_NONE, Functions[i].Address, Functions[i].Arity);
+    }
+
+    while (bConsistent && Worklist.Num() > 0)
+    {
+        Offset = Worklist.Pop();
+        const int32 Height = Heights[Offset];
+        const EOpCode OpCode = static_cast<EOpCode>(Code[Offset]);
+        const int32 Next = Offset + GetInstructionSize(Code, Offset);
+
+        // Values the instruction reads from the stack, and values it leaves in their place
+        int32 Pops = 0;
+        int32 Pushes = 0;
+        bool bFallsThrough = true;
+
+        switch (OpCode)
+        {
+            case EOpCode::OP_CONSTANT:
+            case EOpCode::OP_NIL:
+            case EOpCode::OP_TRUE:
+            case EOpCode::OP_FALSE:
+            case EOpCode::OP_GET_GLOBAL:
+            case EOpCode::OP_CONSTANT_WIDE:
+            case EOpCode::OP_GET_GLOBAL_WIDE:
+                Pushes = 1;
+                break;
+
+            case EOpCode::OP_ADD:
+            case EOpCode::OP_SUBTRACT:
+            case EOpCode::OP_MULTIPLY:
+            case EOpCode::OP_DIVIDE:
+            case EOpCode::OP_MODULO:
+            case EOpCode::OP_EQUAL:
+            case EOpCode::OP_NOT_EQUAL:
+            case EOpCode::OP_GREATER:
+            case EOpCode::OP_GREATER_EQUAL:
+            case EOpCode::OP_LESS:
+            case EOpCode::OP_LESS_EQUAL:
+            case EOpCode::OP_AND:
+            case EOpCode::OP_OR:
+            case EOpCode::OP_BIT_AND:
+            case EOpCode::OP_BIT_OR:
+            case EOpCode::OP_BIT_XOR:
+            case EOpCode::OP_GET_ELEMENT:
+            case EOpCode::OP_SET_FIELD:
+            case EOpCode::OP_ADD_NUMBER:
+            case EOpCode::OP_SUBTRACT_NUMBER:
+            case EOpCode::OP_MULTIPLY_NUMBER:
+            case EOpCode::OP_LESS_NUMBER:
+            case EOpCode::OP_GREATER_NUMBER:
+            case EOpCode::OP_NOT_LESS_NUMBER:
+            case EOpCode::OP_NOT_GREATER_NUMBER:
+                Pops = 2;
+                Pushes = 1;
+                break;
+
+            case EOpCode::OP_NEGATE:
+            case EOpCode::OP_NOT:
+            case EOpCode::OP_BIT_NOT:
+            case EOpCode::OP_CAST_INT:
+            case EOpCode::OP_CAST_FLOAT:
+            case EOpCode::OP_CAST_STRING:
+            case EOpCode::OP_GET_FIELD:
+            case EOpCode::OP_SET_GLOBAL:    // Peeks
+            case EOpCode::OP_SET_GLOBAL_WIDE:
+                Pops = 1;
+                Pushes = 1;
+                break;
+
+            case EOpCode::OP_DUPLICATE:
+                Pops = 1;
+                Pushes = 2;
+                break;
+
+            case EOpCode::OP_SET_ELEMENT:
+                Pops = 3;
+                Pushes = 1;
+                break;
+
+            case EOpCode::OP_DEFINE_GLOBAL:
+            case EOpCode::OP_DEFINE_GLOBAL_WIDE:
+            case EOpCode::OP_POP:
+            case EOpCode::OP_PRINT:
+                Pops = 1;
+                break;
+
+            case EOpCode::OP_GET_LOCAL:
+            case EOpCode::OP_SET_LOCAL:
+            case EOpCode::OP_GET_LOCAL_WIDE:
+            case EOpCode::OP_SET_LOCAL_WIDE:
+            {
+                const int32 Slot = GetIndexOperand(Code, Offset);
+                if (Slot >= Height)
+                {
+                    OutResult.StackFailure = FString::Printf(TEXT("Offset %d: local slot %d used with stack height %d"),
+                        Offset, Slot, Height);
+                    bConsistent = false;
+                }
+                // SET_LOCAL peeks the value it stores
+                Pops = (OpCode == EOpCode::OP_SET_LOCAL || OpCode == EOpCode::OP_SET_LOCAL_WIDE) ? 1 : 0;
+                Pushes = 1;
+                break;
+            }
+
+            case EOpCode::OP_CREATE_ARRAY:
+                Pops = Code[Offset + 1];
+                Pushes = 1;
+                break;
+
+            case EOpCode::OP_CALL:
+            case EOpCode::OP_TAIL_CALL:     // Falls through only at top level, where it is a plain call
+                Pops = Code[Offset + 1];
+                Pushes = 1;
+                break;
+
+            case EOpCode::OP_CALL_NATIVE:
+                Pops = Code[Offset + 1] & NATIVE_CALL_ARGC_MASK;
+                Pushes = 1;
+                break;
+
+            case EOpCode::OP_JUMP:
+            case EOpCode::OP_LOOP:
+            case EOpCode::OP_JUMP_WIDE:
+            case EOpCode::OP_LOOP_WIDE:
+                bFallsThrough = false;
+                bConsistent = Reach(Offset, GetJumpTarget(Code, Offset, OpCode), Height);
+                break;
+
+            case EOpCode::OP_JUMP_IF_FALSE:
+            case EOpCode::OP_JUMP_IF_FALSE_WIDE:
+                // Peeks the condition on both paths
+                Pops = 1;
+                Pushes = 1;
+                bConsistent = Height >= 1 && Reach(Offset, GetJumpTarget(Code, Offset, OpCode), Height);
+                break;
+
+            case EOpCode::OP_FOR_PREP:
+            case EOpCode::OP_FOR_LOOP:
+            case EOpCode::OP_FOREACH:
+            case EOpCode::OP_FOREACH_WIDE:
+            {
+                // Read and write three consecutive locals in place, no stack effect
+                const int32 Slot = GetIndexOperand(Code, Offset);
+                if (Slot + 2 >= Height)
+                {
+                    OutResult.StackFailure = FString::Printf(TEXT("Offset %d: loop slots %d..%d used with stack height %d"),
+                        Offset, Slot, Slot + 2, Height);
+                    bConsistent = false;
+                }
+                bConsistent = bConsistent && Reach(Offset, GetJumpTarget(Code, Offset, OpCode), Height);
+                break;
+            }
+
+            case EOpCode::OP_SWITCH_TABLE:
+            case EOpCode::OP_SWITCH_LOOKUP:
+                // Pops the value, then every case starts with the same height
+                Pops = 1;
+                bFallsThrough = false;
+                GetSwitchTargets(Code, Offset, SwitchTargets);
+                for (int32 i = 0; i < SwitchTargets.Num() && bConsistent && Height >= 1; ++i)
+                {
+                    bConsistent = Reach(Offset, SwitchTargets[i], Height - 1);
+                }
+                break;
+
+            case EOpCode::OP_RETURN:
+                Pops = 1;
+                bFallsThrough = false;
+                break;
+
+            case EOpCode::OP_HALT:
+                // The dispatch loop does not stop on HALT - it is only ever the last instruction
+                break;
+
+            default:
+                break;
+        }
+
+        if (Height < Pops)
+        {
+            if (OutResult.StackFailure.IsEmpty())
+            {
+                OutResult.StackFailure = FString::Printf(TEXT("Offset %d: needs %d stack value(s), height is %d"),
+                    Offset, Pops, Height);
+            }
+            bConsistent = false;
+        }
+
+        const int32 NewHeight = Height - Pops + Pushes;
+        OutResult.MaxStackHeight = FMath::Max(OutResult.MaxStackHeight, NewHeight);
+
+        if (bConsistent && bFallsThrough)
+        {
+            bConsistent = Reach(Offset, Next, NewHeight);
+        }
+    }
+
+    OutResult.bStackVerified = bConsistent;
+    return true;
+}
@@ -5,70 +5,26 @@
 #include "ScriptLogger.h"
 #include "ScriptLexer.h"
 #include "ScriptParser.h"
+#include "ScriptNativeRegistry.h"
+#include "ScriptIR.h"
+#include "ScriptLinker.h"
 #include "Misc/FileHelper.h"
 #include "Misc/Paths.h"
 
-// Initialize known native functions
-const TSet<FString> FScriptCompiler::NativeFunctions = {
-    // Utility
-    TEXT("Log"), TEXT("Print"), TEXT("Sleep"),
-    
-    // Script Management
-    TEXT("LoadScript"), TEXT("RunScript"), TEXT("DoesScriptExist"),
-    TEXT("IsScriptRunning"), TEXT("CanRunScript"), TEXT("IsMissionScript"),
-    
-    // Collections - List
-    TEXT("List_Create"), TEXT("List_Add"), TEXT("List_Get"), TEXT("List_Set"),
-    TEXT("List_RemoveAt"), TEXT("List_Count"), TEXT("List_Clear"), TEXT("List_Contains"),
-    
-    // Collections - Dictionary
-    TEXT("Dict_Create"), TEXT("Dict_Set"), TEXT("Dict_Get"), TEXT("Dict_Remove"),
-    TEXT("Dict_HasKey"), TEXT("Dict_Clear"), TEXT("Dict_Count"),
-    
-    // Math - Basic
-    TEXT("Add"), TEXT("Subtract"), TEXT("Multiply"), TEXT("Divide"), TEXT("Mod"), TEXT("Pow"),
-    
-    // Math - Trig
-    TEXT("Sin"), TEXT("Cos"), TEXT("Tan"), TEXT("Asin"), TEXT("Acos"), TEXT("Atan"), TEXT("Atan2"),
-    
-    // Math - Helpers
-    TEXT("Abs"), TEXT("Sqrt"), TEXT("Floor"), TEXT("Ceil"), TEXT("Round"), TEXT("Clamp"),
-    TEXT("Min"), TEXT("Max"), TEXT("DegreesToRadians"), TEXT("RadiansToDegrees"),
-    TEXT("Log"), TEXT("Exp"),
-    
-    // Math - Random
-    TEXT("RandomFloat"), TEXT("RandomRange"), TEXT("RandomBool"),
-    
-    // Math - Vector
-    TEXT("Vector"), // Constructor
-    TEXT("Vector_Add"), TEXT("Vector_Sub"), TEXT("Vector_Mul"), TEXT("Vector_Div"),
-    TEXT("Vector_Dot"), TEXT("Vector_Cross"), TEXT("Vector_Dist"), TEXT("Vector_DistSquared"),
-    TEXT("Vector_Normalize"), TEXT("Vector_Length"), TEXT("Vector_Lerp"),
-    
-    // String
-    TEXT("String_Len"), TEXT("String_Sub"), TEXT("String_Find"), TEXT("String_Upper"),
-    TEXT("String_Lower"), TEXT("String_Replace"), TEXT("String_Trim"), TEXT("String_Split"),
-    TEXT("String_Contains"), TEXT("String_FromChar"), TEXT("String_ToChar"),
-    
-    // UI
-    TEXT("UI_SwitchState"), TEXT("UI_ShowLoading"), TEXT("UI_UpdateLoading"),
-    
-    // Audio
-    TEXT("Audio_PlaySound"), TEXT("Audio_PlayMusic"), TEXT("Audio_StopMusic"),
-    TEXT("Music_Next"), TEXT("Music_Prev"), TEXT("Music_Pause"), TEXT("Music_Resume"),
-    TEXT("Music_SetVolume"), TEXT("Music_SetShuffle"),
-    TEXT("SFX_PlayLoop"), TEXT("SFX_StopLoop"),
-    
-    // Light
-    TEXT("Light_SetColor"), TEXT("Light_SetIntensity"), TEXT("Light_Toggle"),
-    
-    // Decal
-    TEXT("Decal_Spawn")
-};
-
 FScriptCompiler::FScriptCompiler()
-    : ScopeDepth(0)
+    : ModuleCache(nullptr)
+    , bCompilingModule(false)
+    , ScopeDepth(0)
     , bLastExpressionWasVoidCall(false)
+    , bInFunction(false)
+    , bInliningEnabled(true)
+    , bOptimizationEnabled(false)
+    , bRegisterCodeEnabled(false)
+    , bConstantIndexEnabled(true)
+    , LocalFloor(0)
+    , bWideJumps(false)
+    , bRecompileForWideJumps(false)
+    , CurrentLine(0)
 {
 }
 
@@ -80,17 +36,52 @@ TSharedPtr<FBytecodeChunk> FScriptCompiler::Compile(TSharedPtr<FScriptProgram> P
         return nullptr;
     }
     
-    Chunk = MakeShared<FBytecodeChunk>();
-    Errors.Empty();
-    Locals.Empty();
-    Functions.Empty();
-    ImportedFiles.Empty();
-    ScopeDepth = 0;
-    bLastExpressionWasVoidCall = false;
-    
     SCRIPT_LOG(TEXT("=== COMPILER PHASE ==="));
     
-    CompileProgram(Program.Get());
+    // A forward jump is emitted before its distance is known. When one does not fit in
+    // 16 bits, the function it is in (or the top-level code) is marked and the program
+    // compiled again with that unit's jumps in the _WIDE form; every pass marks at least
+    // one more unit, so this ends.
+    WideJumpUnits.Empty();
+    do
+    {
+        Chunk = MakeShared<FBytecodeChunk>();
+        if (bConstantIndexEnabled)
+        {
+            Chunk->ConstantIndex = MakeShared<FConstantPoolIndex>();
+        }
+        Errors.Empty();
+        Locals.Empty();
+        Functions.Empty();
+        LoopStack.Empty();
+        ImportedFiles.Empty();
+        ImportedPrograms.Empty();
+        ImportedModules.Empty();
+        ExternalFunctions.Empty();
+        ModuleImports.Empty();
+        InlineFrames.Empty();
+        ColdBranches.Empty();
+        ScopeDepth = 0;
+        bLastExpressionWasVoidCall = false;
+        bInFunction = false;
+        LocalFloor = 0;
+        CurrentLine = 0;
+        CurrentSourceFile = FString();
+        CurrentUnit = FString();
+        bWideJumps = WideJumpUnits.Contains(CurrentUnit);
+        bRecompileForWideJumps = false;
+        
+        CompileProgram(Program.Get());
+        
+        if (bRecompileForWideJumps)
+        {
+            SCRIPT_LOG(FString::Printf(TEXT("Recompiling with wide jumps in %d function(s)"), WideJumpUnits.Num()));
+        }
+    }
+    while (bRecompileForWideJumps);
+    
+    // The index only serves AddConstant; the finished chunk does not carry it
+    Chunk->ConstantIndex.Reset();
     
     if (HasErrors())
     {
@@ -107,6 +98,36 @@ TSharedPtr<FBytecodeChunk> FScriptCompiler::Compile(TSharedPtr<FScriptProgram> P
     return Chunk;
 }
 
+TSharedPtr<FScriptModule> FScriptCompiler::CompileModule(TSharedPtr<FScriptProgram> Program, const FString& InModulePath)
+{
+    bCompilingModule = true;
+    ModulePath = InModulePath;
+    TSharedPtr<FBytecodeChunk> ModuleChunk = Compile(Program);
+    bCompilingModule = false;
+    
+    if (!ModuleChunk.IsValid())
+    {
+        return nullptr;
+    }
+    
+    TSharedPtr<FScriptModule> Module = MakeShared<FScriptModule>();
+    Module->Path = InModulePath;
+    Module->Chunk = ModuleChunk;
+    Module->Program = Program;
+    Module->Imports = ModuleImports;
+    for (const FFunction& Function : Functions)
+    {
+        if (Function.Module.IsEmpty())
+        {
+            Module->Exports.Add(FScriptModuleExport(Function.Name, Function.Arity, Function.ReturnType));
+        }
+    }
+    
+    SCRIPT_LOG(FString::Printf(TEXT("Compiled module %s: %d function(s), %d import(s)"),
+        *InModulePath, Module->Exports.Num(), Module->Imports.Num()));
+    return Module;
+}
+
 void FScriptCompiler::ReportError(const FString& Message)
 {
     Errors.Add(Message);
@@ -136,7 +157,13 @@ void FScriptCompiler::EndScope()
 
 int32 FScriptCompiler::ResolveLocal(const FString& Name)
 {
-    for (int32 i = Locals.Num() - 1; i >= 0; --i)
+    // Parameters of an inlined body may read a caller slot in place
+    if (const FInlineBinding* Binding = FindInlineBinding(Name))
+    {
+        return Binding->Slot;
+    }
+    
+    for (int32 i = Locals.Num() - 1; i >= LocalFloor; --i)
     {
         if (Locals[i].Name == Name)
         {
@@ -166,6 +193,12 @@ int32 FScriptCompiler::AddLocal(const FString& Name, EScriptType Type)
         }
     }
     
+    if (Locals.Num() > MAX_WIDE_LOCAL_SLOT)
+    {
+        ReportError(FString::Printf(TEXT("Too many local variables in one function (max %d)"), MAX_WIDE_LOCAL_SLOT + 1));
+        return -1;
+    }
+    
     FLocal Local;
     Local.Name = Name;
     Local.Depth = ScopeDepth;
@@ -185,6 +218,13 @@ int32 FScriptCompiler::ResolveFunction(const FString& Name)
             return i;
         }
     }
+    
+    // A function of an imported module gets its entry when it is first called
+    if (const FFunction* External = ExternalFunctions.Find(Name))
+    {
+        Functions.Add(*External);
+        return Functions.Num() - 1;
+    }
     return -1;
 }
 
@@ -194,10 +234,34 @@ int32 FScriptCompiler::ResolveFunction(const FString& Name)
 
 void FScriptCompiler::CompileProgram(FScriptProgram* Program)
 {
+    if (bCompilingModule)
+    {
+        CompileModuleProgram(Program);
+        return;
+    }
+    
+    bool bHasImports = false;
+    for (const auto& Stmt : Program->Statements)
+    {
+        if (Stmt.IsValid() && Stmt->GetKind() == EScriptNodeKind::Import)
+        {
+            bHasImports = true;
+            break;
+        }
+    }
+    
+    // Emit a jump to skip over function definitions (will be patched later)
+    // Imported functions are compiled while processing the imports, so they need it too
+    int32 JumpOverFunctions = -1;
+    if (Program->Functions.Num() > 0 || bHasImports)
+    {
+        JumpOverFunctions = EmitJump(EOpCode::OP_JUMP);
+    }
+    
     // FIRST: Process all imports to load functions from headers
     for (const auto& Stmt : Program->Statements)
     {
-        if (Stmt.IsValid() && Stmt->GetNodeType() == TEXT("Import"))
+        if (Stmt.IsValid() && Stmt->GetKind() == EScriptNodeKind::Import)
         {
             CompileImport(static_cast<FImportStmt*>(Stmt.Get()));
         }
@@ -206,7 +270,7 @@ void FScriptCompiler::CompileProgram(FScriptProgram* Program)
     // Check for global variable THISISAMISSION = true
     for (const auto& Stmt : Program->Statements)
     {
-        if (Stmt.IsValid() && Stmt->GetNodeType() == TEXT("VarDecl"))
+        if (Stmt.IsValid() && Stmt->GetKind() == EScriptNodeKind::VarDecl)
         {
             FVarDeclStmt* VarDecl = static_cast<FVarDeclStmt*>(Stmt.Get());
             if (VarDecl->Name.Lexeme == TEXT("THISISAMISSION"))
@@ -214,7 +278,7 @@ void FScriptCompiler::CompileProgram(FScriptProgram* Program)
                 SCRIPT_LOG(TEXT("Compiler: Found THISISAMISSION variable."));
                 if (VarDecl->Initializer.IsValid())
                 {
-                    if (VarDecl->Initializer->GetNodeType() == TEXT("Literal"))
+                    if (VarDecl->Initializer->GetKind() == EScriptNodeKind::Literal)
                     {
                         FLiteralExpr* Literal = static_cast<FLiteralExpr*>(VarDecl->Initializer.Get());
                         if (Literal && Literal->Token.Type == ETokenType::KW_TRUE)
@@ -247,18 +311,11 @@ void FScriptCompiler::CompileProgram(FScriptProgram* Program)
             FuncInfo.Arity = Func->TypedParameters.Num() > 0 ? Func->TypedParameters.Num() : Func->Parameters.Num();
             FuncInfo.Address = -1; // Will be set during compilation
             FuncInfo.ReturnType = Func->ReturnType;  // Use the return type from function declaration
+            FuncInfo.Decl = Func.Get();
             Functions.Add(FuncInfo);
         }
     }
     
-    // Emit a jump to skip over function definitions (will be patched later)
-    // Only if we have functions to skip over
-    int32 JumpOverFunctions = -1;
-    if (Program->Functions.Num() > 0 || Functions.Num() > 0)
-    {
-        JumpOverFunctions = EmitJump(EOpCode::OP_JUMP);
-    }
-    
     // THIRD: Compile functions (local + imported, so they're at the beginning of bytecode)
     for (const auto& Func : Program->Functions)
     {
@@ -277,7 +334,7 @@ void FScriptCompiler::CompileProgram(FScriptProgram* Program)
     // FOURTH: Compile global statements (top-level code), skipping imports (already processed)
     for (const auto& Stmt : Program->Statements)
     {
-        if (Stmt.IsValid() && Stmt->GetNodeType() != TEXT("Import"))
+        if (Stmt.IsValid() && Stmt->GetKind() != EScriptNodeKind::Import)
         {
             CompileStatement(Stmt.Get());
         }
@@ -289,13 +346,63 @@ void FScriptCompiler::CompileProgram(FScriptProgram* Program)
         EmitByte((uint8)EOpCode::OP_HALT);
     }
     
+    EmitFunctionTable();
+}
+
+void FScriptCompiler::CompileModuleProgram(FScriptProgram* Program)
+{
+    // A module is only its functions: nothing runs it from the top, so no jump over them
+    for (const auto& Stmt : Program->Statements)
+    {
+        if (Stmt.IsValid() && Stmt->GetKind() == EScriptNodeKind::Import)
+        {
+            CompileImport(static_cast<FImportStmt*>(Stmt.Get()));
+        }
+    }
+    
+    for (const auto& Func : Program->Functions)
+    {
+        if (Func.IsValid())
+        {
+            FFunction FuncInfo;
+            FuncInfo.Name = Func->Name.Lexeme;
+            FuncInfo.Arity = Func->TypedParameters.Num() > 0 ? Func->TypedParameters.Num() : Func->Parameters.Num();
+            FuncInfo.ReturnType = Func->ReturnType;
+            FuncInfo.Decl = Func.Get();
+            FuncInfo.SourceFile = ModulePath;
+            Functions.Add(FuncInfo);
+        }
+    }
+    
+    CurrentSourceFile = ModulePath;
+    for (const auto& Func : Program->Functions)
+    {
+        if (Func.IsValid())
+        {
+            CompileFunction(Func.Get());
+        }
+    }
+    CurrentSourceFile = FString();
+    
+    EmitFunctionTable();
+}
+
+void FScriptCompiler::EmitFunctionTable()
+{
     // Add function table to bytecode for runtime lookup
     for (int32 i = 0; i < Functions.Num(); ++i)
     {
-        if (Functions[i].Address != -1) // Only if function was compiled
+        // Only if function was compiled, or is an external one the linker fills in
+        if (Functions[i].Address != -1 || !Functions[i].Module.IsEmpty())
         {
             // Add to bytecode function table
             FFunctionInfo FuncInfo(Functions[i].Name, Functions[i].Address, Functions[i].Arity);
+            if (Functions[i].RegisterAddress >= 0)
+            {
+                FuncInfo.RegisterAddress = Functions[i].RegisterAddress;
+                FuncInfo.NumRegisters = Functions[i].NumRegisters;
+            }
+            FuncInfo.Module = Functions[i].Module;
             Chunk->Functions.Add(FuncInfo);
             
             SCRIPT_LOG(FString::Printf(TEXT("Added function to table: %s (address=%d, arity=%d)"),
@@ -316,8 +423,24 @@ void FScriptCompiler::CompileFunction(FFunctionDecl* Function)
     SCRIPT_LOG(FString::Printf(TEXT("Compiling function '%s' at address %d"), 
         *Function->Name.Lexeme, Chunk->Code.Num()));
     
+    const FString SavedUnit = CurrentUnit;
+    const bool bSavedWideJumps = bWideJumps;
+    CurrentUnit = Function->Name.Lexeme;
+    bWideJumps = WideJumpUnits.Contains(CurrentUnit);
+    
+    // The IR lowering only emits compact jumps
+    if ((bOptimizationEnabled || bRegisterCodeEnabled) && FuncIndex >= 0 && !bWideJumps && CompileOptimizedFunction(Function, FuncIndex))
+    {
+        CurrentUnit = SavedUnit;
+        bWideJumps = bSavedWideJumps;
+        return;
+    }
+    
     BeginScope();
     
+    const bool bWasInFunction = bInFunction;
+    bInFunction = true;
+    
     // Add parameters as locals (prefer typed parameters)
     if (Function->TypedParameters.Num() > 0)
     {
@@ -360,6 +483,18 @@ void FScriptCompiler::CompileFunction(FFunctionDecl* Function)
     // For non-void functions, the explicit return in the function body handles it
     // If function is missing a return, that's a semantic error that should be caught earlier
     
+    // Else arms moved out of line go after the body; a non-void body that runs off
+    // its end must not run into them
+    if (ColdBranches.Num() > 0)
+    {
+        if (Functions[FuncIndex].ReturnType != EScriptType::VOID)
+        {
+            EmitByte((uint8)EOpCode::OP_NIL);
+            EmitReturn();
+        }
+        EmitColdBranches();
+    }
+    
     // NOTE: We don't call EndScope() here because OP_RETURN already handles cleanup
     // Calling EndScope() would emit dead POPs after the RETURN instruction
     // Instead, we manually clean up the locals tracking without emitting bytecode
@@ -368,6 +503,58 @@ void FScriptCompiler::CompileFunction(FFunctionDecl* Function)
         Locals.Pop();
     }
     ScopeDepth--;
+    
+    bInFunction = bWasInFunction;
+    CurrentUnit = SavedUnit;
+    bWideJumps = bSavedWideJumps;
+}
+
+bool FScriptCompiler::CompileOptimizedFunction(FFunctionDecl* Function, int32 FuncIndex)
+{
+    // Anything the IR cannot take - including code with errors - is compiled directly,
+    // so what the builder added to the chunk or reported meanwhile is rolled back
+    const int32 SavedErrors = Errors.Num();
+    const int32 SavedConstants = Chunk->Constants.Num();
+    
+    FScriptIRFunction IR;
+    FString Reason;
+    bool bLowered = FScriptIRBuilder::Build(*this, Function, FuncIndex, IR, Reason) && Errors.Num() == SavedErrors;
+    if (bLowered)
+    {
+        FScriptIROptimizer::Optimize(IR);
+        bLowered = FScriptIRLowering::Lower(IR, *Chunk, Reason);
+    }
+    
+    if (!bLowered)
+    {
+        Errors.SetNum(SavedErrors);
+        Chunk->TruncateConstants(SavedConstants);
+        SCRIPT_LOG(FString::Printf(TEXT("Function '%s' not optimized: %s"), *Function->Name.Lexeme,
+            Reason.IsEmpty() ? TEXT("it has errors") : *Reason));
+        return false;
+    }
+    
+    SCRIPT_LOG(FString::Printf(TEXT("Optimized function '%s': %d merged, %d hoisted, %d removed, %d dead stores, %d slots"),
+        *Function->Name.Lexeme, IR.NumMerged, IR.NumHoisted, IR.NumRemoved, IR.NumDeadStores, IR.NumSlots));
+    
+    // The register form is optional: the function still runs on its stack code without it
+    if (bRegisterCodeEnabled)
+    {
+        const int32 RegisterAddress = Chunk->RegisterCode.Num();
+        int32 NumRegisters = 0;
+        if (FScriptIRRegisterLowering::Lower(IR, *Chunk, NumRegisters, Reason))
+        {
+            Functions[FuncIndex].RegisterAddress = RegisterAddress;
+            Functions[FuncIndex].NumRegisters = NumRegisters;
+            SCRIPT_LOG(FString::Printf(TEXT("Register code for '%s': %d bytes, %d registers"), *Function->Name.Lexeme,
+                Chunk->RegisterCode.Num() - RegisterAddress, NumRegisters));
+        }
+        else
+        {
+            SCRIPT_LOG(FString::Printf(TEXT("Function '%s' has no register code: %s"), *Function->Name.Lexeme, *Reason));
+        }
+    }
+    return true;
 }
 
 //=============================================================================
@@ -382,55 +569,30 @@ void FScriptCompiler::CompileStatement(FScriptStatement* Statement)
         return;
     }
     
-    FString NodeType = Statement->GetNodeType();
+    const EScriptNodeKind Kind = Statement->GetKind();
     
-    if (NodeType == TEXT("ExprStmt"))
-    {
-        CompileExprStmt(static_cast<FExprStmt*>(Statement));
-    }
-    else if (NodeType == TEXT("VarDecl"))
-    {
-        CompileVarDecl(static_cast<FVarDeclStmt*>(Statement));
-    }
-    else if (NodeType == TEXT("Block"))
-    {
-        CompileBlock(static_cast<FBlockStmt*>(Statement));
-    }
-    else if (NodeType == TEXT("If"))
-    {
-        CompileIf(static_cast<FIfStmt*>(Statement));
-    }
-    else if (NodeType == TEXT("While"))
-    {
-        CompileWhile(static_cast<FWhileStmt*>(Statement));
-    }
-    else if (NodeType == TEXT("For"))
+    if (const int32 Line = GetSourceLine(Statement))
     {
-        CompileFor(static_cast<FForStmt*>(Statement));
+        CurrentLine = Line;
     }
-    else if (NodeType == TEXT("Break"))
-    {
-        CompileBreak(static_cast<FBreakStmt*>(Statement));
-    }
-    else if (NodeType == TEXT("Continue"))
-    {
-        CompileContinue(static_cast<FContinueStmt*>(Statement));
-    }
-    else if (NodeType == TEXT("Switch"))
-    {
-        CompileSwitch(static_cast<FSwitchStmt*>(Statement));
-    }
-    else if (NodeType == TEXT("Return"))
-    {
-        CompileReturn(static_cast<FReturnStmt*>(Statement));
-    }
-    else if (NodeType == TEXT("Import"))
-    {
-        CompileImport(static_cast<FImportStmt*>(Statement));
-    }
-    else
+    
+    switch (Kind)
     {
-        ReportError(FString::Printf(TEXT("Unknown statement type: %s"), *NodeType));
+        case EScriptNodeKind::ExprStmt: CompileExprStmt(static_cast<FExprStmt*>(Statement)); break;
+        case EScriptNodeKind::VarDecl: CompileVarDecl(static_cast<FVarDeclStmt*>(Statement)); break;
+        case EScriptNodeKind::Block: CompileBlock(static_cast<FBlockStmt*>(Statement)); break;
+        case EScriptNodeKind::If: CompileIf(static_cast<FIfStmt*>(Statement)); break;
+        case EScriptNodeKind::While: CompileWhile(static_cast<FWhileStmt*>(Statement)); break;
+        case EScriptNodeKind::For: CompileFor(static_cast<FForStmt*>(Statement)); break;
+        case EScriptNodeKind::ForEach: CompileForEach(static_cast<FForEachStmt*>(Statement)); break;
+        case EScriptNodeKind::Break: CompileBreak(static_cast<FBreakStmt*>(Statement)); break;
+        case EScriptNodeKind::Continue: CompileContinue(static_cast<FContinueStmt*>(Statement)); break;
+        case EScriptNodeKind::Switch: CompileSwitch(static_cast<FSwitchStmt*>(Statement)); break;
+        case EScriptNodeKind::Return: CompileReturn(static_cast<FReturnStmt*>(Statement)); break;
+        case EScriptNodeKind::Import: CompileImport(static_cast<FImportStmt*>(Statement)); break;
+        default:
+            ReportError(FString::Printf(TEXT("Unknown statement type: %s"), FScriptASTNode::GetKindName(Kind)));
+            break;
     }
 }
 
@@ -471,8 +633,7 @@ void FScriptCompiler::CompileVarDecl(FVarDeclStmt* Stmt)
     {
         // Global variable: emit OP_DEFINE_GLOBAL with variable name
         int32 NameConstant = Chunk->AddConstant(FScriptValue::String(Stmt->Name.Lexeme));
-        EmitByte((uint8)EOpCode::OP_DEFINE_GLOBAL);
-        EmitByte((uint8)NameConstant);
+        EmitConstantOp(EOpCode::OP_DEFINE_GLOBAL, NameConstant);
         
         SCRIPT_LOG(FString::Printf(TEXT("Compiled global variable: %s"), *Stmt->Name.Lexeme));
     }
@@ -510,13 +671,29 @@ void FScriptCompiler::CompileIf(FIfStmt* Stmt)
     // Compile condition
     CompileExpression(Stmt->Condition.Get());
     
-    // Jump to else branch if condition is false
+    // Jump to else branch if condition is false (the profile keys the branch by this line)
+    const int32 Line = CurrentLine;
     int32 ThenJump = EmitJump(EOpCode::OP_JUMP_IF_FALSE);
     EmitByte((uint8)EOpCode::OP_POP); // Pop condition
     
     // Compile then branch
     CompileStatement(Stmt->ThenBranch.Get());
     
+    // Then arm hot: the else arm is compiled after the function body and jumps back,
+    // so the hot path runs on into the code after the if without an OP_JUMP
+    if (IsColdElse(Stmt, Line))
+    {
+        FColdBranch Cold;
+        Cold.Body = Stmt->ElseBranch.Get();
+        Cold.EntryJump = ThenJump;
+        Cold.Resume = Chunk->Code.Num();
+        Cold.Line = Line;
+        Cold.Locals = Locals;
+        Cold.ScopeDepth = ScopeDepth;
+        ColdBranches.Add(MoveTemp(Cold));
+        return;
+    }
+    
     // Jump over else branch
     int32 ElseJump = EmitJump(EOpCode::OP_JUMP);
     
@@ -541,6 +718,8 @@ void FScriptCompiler::CompileWhile(FWhileStmt* Stmt)
     // Push loop context for break/continue
     FLoopContext LoopCtx;
     LoopCtx.Start = LoopStart;
+    LoopCtx.ContinueTarget = LoopStart;
+    LoopCtx.LocalCount = Locals.Num();
     LoopStack.Add(LoopCtx);
     
     // Compile condition
@@ -573,19 +752,27 @@ void FScriptCompiler::CompileWhile(FWhileStmt* Stmt)
 
 void FScriptCompiler::CompileFor(FForStmt* Stmt)
 {
-    // For loops desugar to while loops:
+    BeginScope();
+    
+    FCountedLoop Counted;
+    if (MatchCountedLoop(Stmt, Counted))
+    {
+        CompileCountedFor(Stmt, Counted);
+        EndScope();
+        return;
+    }
+    
+    // Other for loops desugar to while loops:
     // for (init; condition; increment) body
     // =>
     // {
     //     init;
     //     while (condition) {
     //         body;
-    //         increment;
+    //         increment;   <- 'continue' jumps here
     //     }
     // }
     
-    BeginScope();
-    
     // Compile initializer
     if (Stmt->Initializer.IsValid())
     {
@@ -597,6 +784,7 @@ void FScriptCompiler::CompileFor(FForStmt* Stmt)
     // Push loop context for break/continue
     FLoopContext LoopCtx;
     LoopCtx.Start = LoopStart;
+    LoopCtx.LocalCount = Locals.Num();
     LoopStack.Add(LoopCtx);
     
     // Compile condition (or default to true)
@@ -615,7 +803,10 @@ void FScriptCompiler::CompileFor(FForStmt* Stmt)
     }
     
     // Continue target: compile increment before looping
-    int32 ContinueTarget = Chunk->Code.Num();
+    for (int32 ContinueJump : LoopStack.Last().ContinueJumps)
+    {
+        PatchJump(ContinueJump);
+    }
     if (Stmt->Increment.IsValid())
     {
         CompileExpression(Stmt->Increment.Get());
@@ -645,96 +836,511 @@ void FScriptCompiler::CompileFor(FForStmt* Stmt)
     EndScope();
 }
 
-void FScriptCompiler::CompileBreak(FBreakStmt* Stmt)
+void FScriptCompiler::CompileCountedFor(FForStmt* Stmt, const FCountedLoop& Loop)
 {
-    if (LoopStack.Num() == 0)
-    {
-        ReportError(TEXT("'break' can only be used inside a loop"));
-        return;
-    }
+    // for (int i = a; i < b; i = i + s) body
+    // =>
+    //     i = a; $for_limit = b; $for_step = s;
+    //     OP_FOR_PREP i -> Exit     (skip the loop if the range is empty)
+    // Body:
+    //     body
+    // Continue:
+    //     OP_FOR_LOOP i -> Body     (i += s, jump back while in range)
+    // Exit:
     
-    // Jump to end of loop (will be patched later)
-    int32 BreakJump = EmitJump(EOpCode::OP_JUMP);
-    LoopStack.Last().BreakJumps.Add(BreakJump);
-}
-
-void FScriptCompiler::CompileContinue(FContinueStmt* Stmt)
-{
-    if (LoopStack.Num() == 0)
+    CompileStatement(Stmt->Initializer.Get());
+    const int32 Slot = Locals.Num() - 1;
+    
+    CompileExpression(Loop.Limit);
+    int32 LimitSlot = AddLocal(TEXT("$for_limit"), EScriptType::AUTO);
+    Locals[LimitSlot].bInitialized = true;
+    
+    EmitConstant(FScriptValue::Number(Loop.Step));
+    int32 StepSlot = AddLocal(TEXT("$for_step"), EScriptType::INT);
+    Locals[StepSlot].bInitialized = true;
+    
+    EmitByte((uint8)EOpCode::OP_FOR_PREP);
+    EmitBytes((uint8)Slot, Loop.Flags);
+    int32 ExitJump = EmitJumpOffset();
+    
+    int32 BodyStart = Chunk->Code.Num();
+    
+    FLoopContext LoopCtx;
+    LoopCtx.Start = BodyStart;
+    LoopCtx.LocalCount = Locals.Num();
+    LoopStack.Add(LoopCtx);
+    
+    if (Stmt->Body.IsValid())
     {
-        ReportError(TEXT("'continue' can only be used inside a loop"));
-        return;
+        CompileStatement(Stmt->Body.Get());
     }
     
-    // Jump back to loop start
-    EmitLoop(LoopStack.Last().Start);
-}
-
-void FScriptCompiler::CompileReturn(FReturnStmt* Stmt)
-{
-    if (Stmt->Value.IsValid())
+    for (int32 ContinueJump : LoopStack.Last().ContinueJumps)
     {
-        CompileExpression(Stmt->Value.Get());
+        PatchJump(ContinueJump);
     }
-    else
+    
+    EmitByte((uint8)EOpCode::OP_FOR_LOOP);
+    EmitBytes((uint8)Slot, Loop.Flags);
+    EmitLoopOffset(BodyStart);
+    
+    PatchJump(ExitJump);
+    for (int32 BreakJump : LoopStack.Last().BreakJumps)
     {
-        EmitByte((uint8)EOpCode::OP_NIL);
+        PatchJump(BreakJump);
     }
     
-    EmitByte((uint8)EOpCode::OP_RETURN);
+    LoopStack.Pop();
 }
 
-void FScriptCompiler::CompileImport(FImportStmt* Stmt)
+void FScriptCompiler::CompileForEach(FForEachStmt* Stmt)
 {
-    // Extract the import path (lexer already strips quotes from string tokens)
-    FString ImportPath = Stmt->Path.Lexeme;
+    // for (x in array) body
+    // =>
+    //     $foreach_array = array; $foreach_index = -1; x = nil;
+    // Next:                          <- 'continue' jumps here
+    //     OP_FOREACH $foreach_array -> Exit   (index++, x = array[index] or exit)
+    //     body
+    //     OP_LOOP -> Next
+    // Exit:
     
-    SCRIPT_LOG(FString::Printf(TEXT("  Processing import: %s"), *ImportPath));
+    BeginScope();
     
-    // Resolve full path - imports are relative to Scripts/ folder
-    FString ProjectDir = FPaths::ProjectDir();
-    FString ScriptsPath = FPaths::Combine(ProjectDir, TEXT("Scripts"));
-    FString FullImportPath = FPaths::Combine(ScriptsPath, ImportPath);
+    CompileExpression(Stmt->Iterable.Get());
+    const int32 Slot = AddLocal(TEXT("$foreach_array"), EScriptType::AUTO);
+    Locals[Slot].bInitialized = true;
     
-    // Normalize the path
-    FPaths::NormalizeFilename(FullImportPath);
+    EmitConstant(FScriptValue::Number(-1.0));
+    int32 IndexSlot = AddLocal(TEXT("$foreach_index"), EScriptType::INT);
+    Locals[IndexSlot].bInitialized = true;
     
-    // Check for circular imports
-    if (ImportedFiles.Contains(FullImportPath))
+    EmitByte((uint8)EOpCode::OP_NIL);
+    int32 VarSlot = AddLocal(Stmt->Name.Lexeme, Stmt->VarType);
+    if (VarSlot >= 0)
     {
-        SCRIPT_LOG(FString::Printf(TEXT("  Already imported: %s (skipping)"), *ImportPath));
-        return;
+        Locals[VarSlot].bInitialized = true;
     }
     
-    // Check if file exists
-    if (!FPaths::FileExists(FullImportPath))
+    // A slot past 255 needs OP_FOREACH_WIDE, whose exit offset is a wide jump too
+    if (Slot > MAX_COMPACT_OPERAND && !bWideJumps)
     {
-        ReportError(FString::Printf(TEXT("Import file not found: %s"), *FullImportPath));
-        return;
+        RequestWideJumps();
     }
     
-    // Mark as imported
-    ImportedFiles.Add(FullImportPath);
-    
-    // Load the header file
-    FString HeaderSource;
-    if (!FFileHelper::LoadFileToString(HeaderSource, *FullImportPath))
+    int32 LoopStart = Chunk->Code.Num();
+    if (bWideJumps)
     {
-        ReportError(FString::Printf(TEXT("Failed to read import file: %s"), *FullImportPath));
-        return;
+        EmitByte((uint8)EOpCode::OP_FOREACH_WIDE);
+        EmitBytes((uint8)(Slot >> 8), (uint8)(Slot & 0xFF));
+    }
+    else
+    {
+        EmitBytes((uint8)EOpCode::OP_FOREACH, (uint8)Slot);
     }
+    int32 ExitJump = EmitJumpOffset();
     
-    SCRIPT_LOG(FString::Printf(TEXT("  Loaded header: %s (%d bytes)"), *ImportPath, HeaderSource.Len()));
+    FLoopContext LoopCtx;
+    LoopCtx.Start = LoopStart;
+    LoopCtx.ContinueTarget = LoopStart;
+    LoopCtx.LocalCount = Locals.Num();
+    LoopStack.Add(LoopCtx);
     
-    // Parse the header file
-    FScriptLexer HeaderLexer(HeaderSource);
-    TArray<FScriptToken> HeaderTokens = HeaderLexer.ScanTokens();
+    if (Stmt->Body.IsValid())
+    {
+        CompileStatement(Stmt->Body.Get());
+    }
     
-    FScriptParser HeaderParser(HeaderTokens);
-    TSharedPtr<FScriptProgram> HeaderProgram = HeaderParser.Parse();
+    EmitLoop(LoopStart);
     
-    // Check for parse errors
-    if (HeaderParser.HasErrors())
+    PatchJump(ExitJump);
+    for (int32 BreakJump : LoopStack.Last().BreakJumps)
+    {
+        PatchJump(BreakJump);
+    }
+    
+    LoopStack.Pop();
+    
+    EndScope();
+}
+
+bool FScriptCompiler::MatchCountedLoop(FForStmt* Stmt, FCountedLoop& OutLoop) const
+{
+    // Matches: for (int i = <init>; i <op> <limit>; i = i +/- <integer literal>)
+    // where <limit> is a number literal or a local, and neither i nor the limit
+    // is assigned in the body. Everything else compiles as a while loop.
+    if (!Stmt->Initializer.IsValid() || !Stmt->Condition.IsValid() || !Stmt->Increment.IsValid() ||
+        Stmt->Initializer->GetKind() != EScriptNodeKind::VarDecl)
+    {
+        return false;
+    }
+    
+    // The counter and its two hidden locals must fit in one-byte slots, and
+    // OP_FOR_PREP / OP_FOR_LOOP have no wide jump form
+    if (Locals.Num() + 3 > MAX_COMPACT_OPERAND + 1 || bWideJumps)
+    {
+        return false;
+    }
+    
+    FVarDeclStmt* Init = static_cast<FVarDeclStmt*>(Stmt->Initializer.Get());
+    if (Init->VarType != EScriptType::INT || !Init->Initializer.IsValid())
+    {
+        return false;
+    }
+    const FString& Var = Init->Name.Lexeme;
+    
+    auto IsCounter = [&Var](const FScriptExpression* Expr)
+    {
+        return Expr && Expr->GetKind() == EScriptNodeKind::Identifier &&
+            static_cast<const FIdentifierExpr*>(Expr)->Name.Lexeme == Var;
+    };
+    auto IsNumberLiteral = [](const FScriptExpression* Expr)
+    {
+        return Expr && Expr->GetKind() == EScriptNodeKind::Literal &&
+            static_cast<const FLiteralExpr*>(Expr)->Token.Type == ETokenType::NUMBER;
+    };
+    
+    // Condition: i < limit, i <= limit, i > limit or i >= limit
+    if (Stmt->Condition->GetKind() != EScriptNodeKind::Binary)
+    {
+        return false;
+    }
+    FBinaryExpr* Condition = static_cast<FBinaryExpr*>(Stmt->Condition.Get());
+    const ETokenType Compare = Condition->Operator.Type;
+    const bool bCountsUp = Compare == ETokenType::LESS || Compare == ETokenType::LESS_EQUAL;
+    const bool bCountsDown = Compare == ETokenType::GREATER || Compare == ETokenType::GREATER_EQUAL;
+    if ((!bCountsUp && !bCountsDown) || !IsCounter(Condition->Left.Get()))
+    {
+        return false;
+    }
+    
+    FScriptExpression* Limit = Condition->Right.Get();
+    if (!IsNumberLiteral(Limit))
+    {
+        // A local limit is read once - it must not change while the loop runs.
+        // Globals are excluded: any call in the body could assign them.
+        if (!Limit || Limit->GetKind() != EScriptNodeKind::Identifier)
+        {
+            return false;
+        }
+        const FString& LimitName = static_cast<FIdentifierExpr*>(Limit)->Name.Lexeme;
+        bool bIsLocal = false;
+        for (const FLocal& Local : Locals)
+        {
+            bIsLocal |= Local.Name == LimitName && Local.bInitialized;
+        }
+        if (!bIsLocal || LimitName == Var ||
+            IsLocalAssigned(Stmt->Body.Get(), LimitName) || IsLocalAssigned(Stmt->Increment.Get(), LimitName))
+        {
+            return false;
+        }
+    }
+    
+    // Increment: i = i + n or i = i - n, n a non-zero integer
+    if (Stmt->Increment->GetKind() != EScriptNodeKind::Assign)
+    {
+        return false;
+    }
+    FAssignExpr* Increment = static_cast<FAssignExpr*>(Stmt->Increment.Get());
+    if (!IsCounter(Increment->Target.Get()) || !Increment->Value.IsValid() || Increment->Value->GetKind() != EScriptNodeKind::Binary)
+    {
+        return false;
+    }
+    FBinaryExpr* Step = static_cast<FBinaryExpr*>(Increment->Value.Get());
+    const bool bAdd = Step->Operator.Type == ETokenType::PLUS;
+    if ((!bAdd && Step->Operator.Type != ETokenType::MINUS) || !IsCounter(Step->Left.Get()) || !IsNumberLiteral(Step->Right.Get()))
+    {
+        return false;
+    }
+    double StepValue = FCString::Atod(*static_cast<FLiteralExpr*>(Step->Right.Get())->Token.Lexeme);
+    if (StepValue == 0.0 || StepValue != static_cast<double>(static_cast<int64>(StepValue)))
+    {
+        return false;
+    }
+    StepValue = bAdd ? StepValue : -StepValue;
+    
+    // A step away from the limit is an (almost) endless loop - leave it alone
+    if ((bCountsUp && StepValue < 0.0) || (bCountsDown && StepValue > 0.0))
+    {
+        return false;
+    }
+    
+    if (IsLocalAssigned(Stmt->Body.Get(), Var))
+    {
+        return false;
+    }
+    
+    OutLoop.Limit = Limit;
+    OutLoop.Step = StepValue;
+    OutLoop.Flags = (Compare == ETokenType::LESS_EQUAL || Compare == ETokenType::GREATER_EQUAL) ? FOR_LOOP_INCLUSIVE : 0;
+    return true;
+}
+
+bool FScriptCompiler::IsLocalAssigned(const FScriptASTNode* Node, const FString& Name)
+{
+    // Conservative: any node type not listed here counts as an assignment
+    if (!Node)
+    {
+        return false;
+    }
+    
+    auto Names = [&Name](const TSharedPtr<FScriptExpression>& Expr)
+    {
+        return Expr.IsValid() && Expr->GetKind() == EScriptNodeKind::Identifier &&
+            static_cast<const FIdentifierExpr*>(Expr.Get())->Name.Lexeme == Name;
+    };
+    
+    const EScriptNodeKind Kind = Node->GetKind();
+    
+    if (Kind == EScriptNodeKind::Literal || Kind == EScriptNodeKind::Identifier ||
+        Kind == EScriptNodeKind::Break || Kind == EScriptNodeKind::Continue)
+    {
+        return false;
+    }
+    if (Kind == EScriptNodeKind::Assign)
+    {
+        const FAssignExpr* Expr = static_cast<const FAssignExpr*>(Node);
+        return Names(Expr->Target) || IsLocalAssigned(Expr->Target.Get(), Name) || IsLocalAssigned(Expr->Value.Get(), Name);
+    }
+    if (Kind == EScriptNodeKind::ArrayAssign)
+    {
+        const FArrayAssignExpr* Expr = static_cast<const FArrayAssignExpr*>(Node);
+        return Names(Expr->Array) || IsLocalAssigned(Expr->Array.Get(), Name) ||
+            IsLocalAssigned(Expr->Index.Get(), Name) || IsLocalAssigned(Expr->Value.Get(), Name);
+    }
+    if (Kind == EScriptNodeKind::StructAssign)
+    {
+        const FStructAssignExpr* Expr = static_cast<const FStructAssignExpr*>(Node);
+        return Names(Expr->Object) || IsLocalAssigned(Expr->Object.Get(), Name) || IsLocalAssigned(Expr->Value.Get(), Name);
+    }
+    if (Kind == EScriptNodeKind::Binary)
+    {
+        const FBinaryExpr* Expr = static_cast<const FBinaryExpr*>(Node);
+        return IsLocalAssigned(Expr->Left.Get(), Name) || IsLocalAssigned(Expr->Right.Get(), Name);
+    }
+    if (Kind == EScriptNodeKind::Unary)
+    {
+        return IsLocalAssigned(static_cast<const FUnaryExpr*>(Node)->Right.Get(), Name);
+    }
+    if (Kind == EScriptNodeKind::TypeCast)
+    {
+        return IsLocalAssigned(static_cast<const FTypeCastExpr*>(Node)->Expression.Get(), Name);
+    }
+    if (Kind == EScriptNodeKind::ArrayAccess)
+    {
+        const FArrayAccessExpr* Expr = static_cast<const FArrayAccessExpr*>(Node);
+        return IsLocalAssigned(Expr->Array.Get(), Name) || IsLocalAssigned(Expr->Index.Get(), Name);
+    }
+    if (Kind == EScriptNodeKind::StructAccess)
+    {
+        return IsLocalAssigned(static_cast<const FStructAccessExpr*>(Node)->Object.Get(), Name);
+    }
+    if (Kind == EScriptNodeKind::Call)
+    {
+        const FCallExpr* Expr = static_cast<const FCallExpr*>(Node);
+        bool bAssigned = IsLocalAssigned(Expr->Callee.Get(), Name);
+        for (const TSharedPtr<FScriptExpression>& Argument : Expr->Arguments)
+        {
+            bAssigned |= IsLocalAssigned(Argument.Get(), Name);
+        }
+        return bAssigned;
+    }
+    if (Kind == EScriptNodeKind::ArrayLiteral)
+    {
+        bool bAssigned = false;
+        for (const TSharedPtr<FScriptExpression>& Element : static_cast<const FArrayLiteralExpr*>(Node)->Elements)
+        {
+            bAssigned |= IsLocalAssigned(Element.Get(), Name);
+        }
+        return bAssigned;
+    }
+    if (Kind == EScriptNodeKind::StructLiteral)
+    {
+        bool bAssigned = false;
+        for (const auto& Field : static_cast<const FStructLiteralExpr*>(Node)->Fields)
+        {
+            bAssigned |= IsLocalAssigned(Field.Value.Get(), Name);
+        }
+        return bAssigned;
+    }
+    if (Kind == EScriptNodeKind::ExprStmt)
+    {
+        return IsLocalAssigned(static_cast<const FExprStmt*>(Node)->Expression.Get(), Name);
+    }
+    if (Kind == EScriptNodeKind::VarDecl)
+    {
+        // A declaration of the same name shadows it - treated as an assignment
+        const FVarDeclStmt* Stmt = static_cast<const FVarDeclStmt*>(Node);
+        return Stmt->Name.Lexeme == Name || IsLocalAssigned(Stmt->Initializer.Get(), Name);
+    }
+    if (Kind == EScriptNodeKind::Block)
+    {
+        bool bAssigned = false;
+        for (const TSharedPtr<FScriptStatement>& Statement : static_cast<const FBlockStmt*>(Node)->Statements)
+        {
+            bAssigned |= IsLocalAssigned(Statement.Get(), Name);
+        }
+        return bAssigned;
+    }
+    if (Kind == EScriptNodeKind::If)
+    {
+        const FIfStmt* Stmt = static_cast<const FIfStmt*>(Node);
+        return IsLocalAssigned(Stmt->Condition.Get(), Name) || IsLocalAssigned(Stmt->ThenBranch.Get(), Name) ||
+            IsLocalAssigned(Stmt->ElseBranch.Get(), Name);
+    }
+    if (Kind == EScriptNodeKind::While)
+    {
+        const FWhileStmt* Stmt = static_cast<const FWhileStmt*>(Node);
+        return IsLocalAssigned(Stmt->Condition.Get(), Name) || IsLocalAssigned(Stmt->Body.Get(), Name);
+    }
+    if (Kind == EScriptNodeKind::For)
+    {
+        const FForStmt* Stmt = static_cast<const FForStmt*>(Node);
+        return IsLocalAssigned(Stmt->Initializer.Get(), Name) || IsLocalAssigned(Stmt->Condition.Get(), Name) ||
+            IsLocalAssigned(Stmt->Increment.Get(), Name) || IsLocalAssigned(Stmt->Body.Get(), Name);
+    }
+    if (Kind == EScriptNodeKind::ForEach)
+    {
+        const FForEachStmt* Stmt = static_cast<const FForEachStmt*>(Node);
+        return Stmt->Name.Lexeme == Name || IsLocalAssigned(Stmt->Iterable.Get(), Name) || IsLocalAssigned(Stmt->Body.Get(), Name);
+    }
+    if (Kind == EScriptNodeKind::Switch)
+    {
+        const FSwitchStmt* Stmt = static_cast<const FSwitchStmt*>(Node);
+        bool bAssigned = IsLocalAssigned(Stmt->Expression.Get(), Name) || IsLocalAssigned(Stmt->DefaultCase.Get(), Name);
+        for (const auto& Case : Stmt->Cases)
+        {
+            bAssigned |= IsLocalAssigned(Case.Key.Get(), Name) || IsLocalAssigned(Case.Value.Get(), Name);
+        }
+        return bAssigned;
+    }
+    if (Kind == EScriptNodeKind::Return)
+    {
+        return IsLocalAssigned(static_cast<const FReturnStmt*>(Node)->Value.Get(), Name);
+    }
+    
+    return true;
+}
+
+void FScriptCompiler::CompileBreak(FBreakStmt* Stmt)
+{
+    if (LoopStack.Num() == 0)
+    {
+        ReportError(TEXT("'break' can only be used inside a loop or switch"));
+        return;
+    }
+    
+    // Jump to end of loop or switch (will be patched later)
+    EmitLoopExitPops(LoopStack.Last());
+    int32 BreakJump = EmitJump(EOpCode::OP_JUMP);
+    LoopStack.Last().BreakJumps.Add(BreakJump);
+}
+
+void FScriptCompiler::CompileContinue(FContinueStmt* Stmt)
+{
+    // A switch in between is left like the loop body
+    int32 LoopIndex = LoopStack.Num() - 1;
+    while (LoopIndex >= 0 && LoopStack[LoopIndex].bSwitch)
+    {
+        LoopIndex--;
+    }
+    if (LoopIndex < 0)
+    {
+        ReportError(TEXT("'continue' can only be used inside a loop"));
+        return;
+    }
+    
+    FLoopContext& CurrentLoop = LoopStack[LoopIndex];
+    EmitLoopExitPops(CurrentLoop);
+    
+    if (CurrentLoop.ContinueTarget >= 0)
+    {
+        // Jump back to loop start
+        EmitLoop(CurrentLoop.ContinueTarget);
+    }
+    else
+    {
+        // Jump forward to the for-loop increment (patched later)
+        CurrentLoop.ContinueJumps.Add(EmitJump(EOpCode::OP_JUMP));
+    }
+}
+
+void FScriptCompiler::CompileReturn(FReturnStmt* Stmt)
+{
+    if (Stmt->Value.IsValid() && bInFunction && Stmt->Value->GetKind() == EScriptNodeKind::Call)
+    {
+        // 'return f(...)' - a script function callee reuses this frame (natives are unaffected)
+        CompileCall(static_cast<FCallExpr*>(Stmt->Value.Get()), true);
+    }
+    else if (Stmt->Value.IsValid())
+    {
+        CompileExpression(Stmt->Value.Get());
+    }
+    else
+    {
+        EmitByte((uint8)EOpCode::OP_NIL);
+    }
+    
+    EmitByte((uint8)EOpCode::OP_RETURN);
+}
+
+void FScriptCompiler::CompileImport(FImportStmt* Stmt)
+{
+    // Extract the import path (lexer already strips quotes from string tokens)
+    FString ImportPath = Stmt->Path.Lexeme;
+    
+    SCRIPT_LOG(FString::Printf(TEXT("  Processing import: %s"), *ImportPath));
+    
+    // Separate compilation: the header is compiled once as a module and linked in later
+    if (ModuleCache)
+    {
+        FPaths::NormalizeFilename(ImportPath);
+        ModuleImports.AddUnique(ImportPath);
+        ImportModule(ImportPath);
+        return;
+    }
+    
+    // Resolve full path - imports are relative to Scripts/ folder
+    FString ProjectDir = FPaths::ProjectDir();
+    FString ScriptsPath = FPaths::Combine(ProjectDir, TEXT("Scripts"));
+    FString FullImportPath = FPaths::Combine(ScriptsPath, ImportPath);
+    
+    // Normalize the path
+    FPaths::NormalizeFilename(FullImportPath);
+    
+    // Check for circular imports
+    if (ImportedFiles.Contains(FullImportPath))
+    {
+        SCRIPT_LOG(FString::Printf(TEXT("  Already imported: %s (skipping)"), *ImportPath));
+        return;
+    }
+    
+    // Check if file exists
+    if (!FPaths::FileExists(FullImportPath))
+    {
+        ReportError(FString::Printf(TEXT("Import file not found: %s"), *FullImportPath));
+        return;
+    }
+    
+    // Mark as imported
+    ImportedFiles.Add(FullImportPath);
+    
+    // Load the header file
+    FString HeaderSource;
+    if (!FFileHelper::LoadFileToString(HeaderSource, *FullImportPath))
+    {
+        ReportError(FString::Printf(TEXT("Failed to read import file: %s"), *FullImportPath));
+        return;
+    }
+    
+    SCRIPT_LOG(FString::Printf(TEXT("  Loaded header: %s (%d bytes)"), *ImportPath, HeaderSource.Len()));
+    
+    // Parse the header file
+    FScriptLexer HeaderLexer(HeaderSource);
+    FScriptParser HeaderParser(HeaderLexer);
+    TSharedPtr<FScriptProgram> HeaderProgram = HeaderParser.Parse();
+    
+    // Check for parse errors
+    if (HeaderParser.HasErrors())
     {
         ReportError(FString::Printf(TEXT("Parse errors in import file: %s"), *ImportPath));
         for (const FString& Error : HeaderParser.GetErrors())
@@ -747,14 +1353,18 @@ void FScriptCompiler::CompileImport(FImportStmt* Stmt)
     // Compile the header's functions
     if (HeaderProgram.IsValid())
     {
+        // Call sites in later code may inline these bodies, so the AST has to outlive this import
+        ImportedPrograms.Add(HeaderProgram);
+        
+
         // First, handle any imports in the header (recursive)
         for (const TSharedPtr<FScriptASTNode>& Statement : HeaderProgram->Statements)
         {
             if (!Statement.IsValid()) continue;
             
-            FString NodeType = Statement->GetNodeType();
+            const EScriptNodeKind Kind = Statement->GetKind();
             
-            if (NodeType == TEXT("Import"))
+            if (Kind == EScriptNodeKind::Import)
             {
                 CompileImport(static_cast<FImportStmt*>(Statement.Get()));
             }
@@ -770,11 +1380,15 @@ void FScriptCompiler::CompileImport(FImportStmt* Stmt)
                 FuncInfo.Arity = Func->TypedParameters.Num() > 0 ? Func->TypedParameters.Num() : Func->Parameters.Num();
                 FuncInfo.Address = -1; // Will be set during compilation
                 FuncInfo.ReturnType = Func->ReturnType;
+                FuncInfo.Decl = Func.Get();
+                FuncInfo.SourceFile = ImportPath;
                 Functions.Add(FuncInfo);
             }
         }
         
         // Then compile all function declarations from the header
+        const FString SavedSourceFile = CurrentSourceFile;
+        CurrentSourceFile = ImportPath;
         for (const auto& Func : HeaderProgram->Functions)
         {
             if (Func.IsValid())
@@ -782,11 +1396,71 @@ void FScriptCompiler::CompileImport(FImportStmt* Stmt)
                 CompileFunction(Func.Get());
             }
         }
+        CurrentSourceFile = SavedSourceFile;
         
         SCRIPT_LOG(FString::Printf(TEXT("  Import compiled: %s"), *ImportPath));
     }
 }
 
+void FScriptCompiler::ImportModule(const FString& Path)
+{
+    if (ImportedFiles.Contains(Path))
+    {
+        SCRIPT_LOG(FString::Printf(TEXT("  Already imported: %s (skipping)"), *Path));
+        return;
+    }
+    ImportedFiles.Add(Path);
+    
+    TArray<FString> ModuleErrors;
+    TSharedPtr<const FScriptModule> Module = ModuleCache->GetOrCompile(Path, ModuleErrors);
+    if (!Module.IsValid())
+    {
+        // No errors: the module is still being compiled further up a circular import
+        for (const FString& Error : ModuleErrors)
+        {
+            ReportError(Error);
+        }
+        return;
+    }
+    ImportedModules.Add(Module);
+    
+    // What a header imports is visible to its importer, as when headers are compiled in
+    for (const FString& Inner : Module->Imports)
+    {
+        ImportModule(Inner);
+    }
+    
+    for (const FScriptModuleExport& Export : Module->Exports)
+    {
+        if (ExternalFunctions.Contains(Export.Name))
+        {
+            continue;
+        }
+        
+        FFunction External;
+        External.Name = Export.Name;
+        External.Arity = Export.Arity;
+        External.ReturnType = Export.ReturnType;
+        External.Decl = Module->FindFunctionDecl(Export.Name);
+        External.SourceFile = Path;
+        External.Module = Path;
+        ExternalFunctions.Add(Export.Name, External);
+    }
+    
+    SCRIPT_LOG(FString::Printf(TEXT("  Import linked later: %s (%d function(s))"), *Path, Module->Exports.Num()));
+}
+
+TArray<FString> FScriptCompiler::GetImportedSourceFiles() const
+{
+    // Compiled in, imports are tracked by full path; through a module cache, by module path
+    TArray<FString> Files;
+    for (const FString& Imported : ImportedFiles)
+    {
+        Files.Add(ModuleCache ? ModuleCache->GetSourcePath(Imported) : Imported);
+    }
+    return Files;
+}
+
 //=============================================================================
 // Expression Compilation
 //=============================================================================
@@ -799,327 +1473,721 @@ void FScriptCompiler::CompileExpression(FScriptExpression* Expression)
         return;
     }
     
-    FString NodeType = Expression->GetNodeType();
+    const EScriptNodeKind Kind = Expression->GetKind();
     
-    if (NodeType == TEXT("Literal"))
+    if (const int32 Line = GetSourceLine(Expression))
     {
-        CompileLiteral(static_cast<FLiteralExpr*>(Expression));
+        CurrentLine = Line;
     }
-    else if (NodeType == TEXT("Binary"))
+    
+    switch (Kind)
     {
-        CompileBinary(static_cast<FBinaryExpr*>(Expression));
+        case EScriptNodeKind::Literal: CompileLiteral(static_cast<FLiteralExpr*>(Expression)); break;
+        case EScriptNodeKind::Binary: CompileBinary(static_cast<FBinaryExpr*>(Expression)); break;
+        case EScriptNodeKind::Unary: CompileUnary(static_cast<FUnaryExpr*>(Expression)); break;
+        case EScriptNodeKind::Identifier: CompileIdentifier(static_cast<FIdentifierExpr*>(Expression)); break;
+        case EScriptNodeKind::Assign: CompileAssign(static_cast<FAssignExpr*>(Expression)); break;
+        case EScriptNodeKind::Call: CompileCall(static_cast<FCallExpr*>(Expression)); break;
+        case EScriptNodeKind::ArrayLiteral: CompileArrayLiteral(static_cast<FArrayLiteralExpr*>(Expression)); break;
+        case EScriptNodeKind::ArrayAccess: CompileArrayAccess(static_cast<FArrayAccessExpr*>(Expression)); break;
+        case EScriptNodeKind::ArrayAssign: CompileArrayAssign(static_cast<FArrayAssignExpr*>(Expression)); break;
+        case EScriptNodeKind::StructAccess: CompileStructAccess(static_cast<FStructAccessExpr*>(Expression)); break;
+        case EScriptNodeKind::StructAssign: CompileStructAssign(static_cast<FStructAssignExpr*>(Expression)); break;
+        case EScriptNodeKind::TypeCast: CompileTypeCast(static_cast<FTypeCastExpr*>(Expression)); break;
+        default:
+            ReportError(FString::Printf(TEXT("Unknown expression type: %s"), FScriptASTNode::GetKindName(Kind)));
+            break;
     }
-    else if (NodeType == TEXT("Unary"))
+}
+
+void FScriptCompiler::CompileLiteral(FLiteralExpr* Expr)
+{
+    // Parse the literal value from token
+    FString Lexeme = Expr->Token.Lexeme;
+    
+    if (Expr->Token.Type == ETokenType::NUMBER)
     {
-        CompileUnary(static_cast<FUnaryExpr*>(Expression));
+        double Value = FCString::Atod(*Lexeme);
+        EmitConstant(FScriptValue::Number(Value));
     }
-    else if (NodeType == TEXT("Identifier"))
+    else if (Expr->Token.Type == ETokenType::STRING)
     {
-        CompileIdentifier(static_cast<FIdentifierExpr*>(Expression));
+        EmitConstant(FScriptValue::String(Lexeme));
+    }
+    else if (Expr->Token.Type == ETokenType::KW_TRUE)
+    {
+        EmitConstant(FScriptValue::Bool(true));
+    }
+    else if (Expr->Token.Type == ETokenType::KW_FALSE)
+    {
+        EmitConstant(FScriptValue::Bool(false));
+    }
+    else if (Expr->Token.Type == ETokenType::NIL)
+    {
+        EmitByte((uint8)EOpCode::OP_NIL);
+    }
+    else
+    {
+        ReportError(FString::Printf(TEXT("Unknown literal type: %s"), *Lexeme));
+    }
+}
+
+void FScriptCompiler::CompileBinary(FBinaryExpr* Expr)
+{
+    // Compile operands
+    CompileExpression(Expr->Left.Get());
+    CompileExpression(Expr->Right.Get());
+    
+    // Emit operator
+    switch (Expr->Operator.Type)
+    {
+        // Arithmetic
+        case ETokenType::PLUS:    EmitOperator(EOpCode::OP_ADD); break;
+        case ETokenType::MINUS:   EmitOperator(EOpCode::OP_SUBTRACT); break;
+        case ETokenType::STAR:    EmitOperator(EOpCode::OP_MULTIPLY); break;
+        case ETokenType::SLASH:   EmitByte((uint8)EOpCode::OP_DIVIDE); break;
+        case ETokenType::PERCENT: EmitByte((uint8)EOpCode::OP_MODULO); break;
+        
+        // Comparison
+        case ETokenType::EQUAL_EQUAL:   EmitByte((uint8)EOpCode::OP_EQUAL); break;
+        case ETokenType::BANG_EQUAL:    EmitBytes((uint8)EOpCode::OP_EQUAL, (uint8)EOpCode::OP_NOT); break;
+        case ETokenType::GREATER:       EmitOperator(EOpCode::OP_GREATER); break;
+        case ETokenType::GREATER_EQUAL: EmitOperator(EOpCode::OP_LESS, true); break;
+        case ETokenType::LESS:          EmitOperator(EOpCode::OP_LESS); break;
+        case ETokenType::LESS_EQUAL:    EmitOperator(EOpCode::OP_GREATER, true); break;
+        
+        // Logical
+        case ETokenType::AND:              EmitByte((uint8)EOpCode::OP_AND); break;
+        case ETokenType::OR:               EmitByte((uint8)EOpCode::OP_OR); break;
+        case ETokenType::AMPERSAND_AMPERSAND: EmitByte((uint8)EOpCode::OP_AND); break;  // && same as 'and'
+        case ETokenType::PIPE_PIPE:        EmitByte((uint8)EOpCode::OP_OR); break;   // || same as 'or'
+        
+        // Bitwise
+        case ETokenType::AMPERSAND: EmitByte((uint8)EOpCode::OP_BIT_AND); break;
+        case ETokenType::PIPE:      EmitByte((uint8)EOpCode::OP_BIT_OR); break;
+        case ETokenType::CARET:     EmitByte((uint8)EOpCode::OP_BIT_XOR); break;
+        
+        default:
+            ReportError(TEXT("Unknown binary operator: ") + Expr->Operator.Lexeme);
+    }
+}
+
+void FScriptCompiler::CompileUnary(FUnaryExpr* Expr)
+{
+    CompileExpression(Expr->Right.Get());
+    
+    switch (Expr->Operator.Type)
+    {
+        case ETokenType::MINUS: EmitByte((uint8)EOpCode::OP_NEGATE); break;
+        case ETokenType::BANG:  EmitByte((uint8)EOpCode::OP_NOT); break;
+        case ETokenType::TILDE: EmitByte((uint8)EOpCode::OP_BIT_NOT); break;
+        default:
+            ReportError(TEXT("Unknown unary operator: ") + Expr->Operator.Lexeme);
+    }
+}
+
+void FScriptCompiler::CompileIdentifier(FIdentifierExpr* Expr)
+{
+    FString Name = Expr->Name.Lexeme;
+    
+    // Parameter of an inlined body bound to its argument expression
+    const FInlineBinding* Binding = FindInlineBinding(Name);
+    if (Binding && Binding->Value)
+    {
+        CompileInlineArgument(*Binding);
+        return;
+    }
+    
+    int32 LocalIndex = ResolveLocal(Name);
+    
+    if (LocalIndex >= 0)
+    {
+        // Local variable
+        EmitLocalOp(EOpCode::OP_GET_LOCAL, LocalIndex);
+    }
+    else
+    {
+        // Global variable - emit OP_GET_GLOBAL with variable name
+        int32 NameConstant = Chunk->AddConstant(FScriptValue::String(Name));
+        EmitConstantOp(EOpCode::OP_GET_GLOBAL, NameConstant);
+    }
+}
+
+void FScriptCompiler::CompileAssign(FAssignExpr* Expr)
+{
+    // Assignment targets can be:
+    // - Identifier (local/global variable)
+    // - Array access (arr[index])
+    // - Struct/object field access (obj.field)
+
+    const EScriptNodeKind TargetKind = Expr->Target->GetKind();
+
+    if (TargetKind == EScriptNodeKind::Identifier)
+    {
+        FIdentifierExpr* Target = static_cast<FIdentifierExpr*>(Expr->Target.Get());
+        FString Name = Target->Name.Lexeme;
+        int32 LocalIndex = ResolveLocal(Name);
+
+        // Compile value
+        CompileExpression(Expr->Value.Get());
+
+        if (LocalIndex >= 0)
+        {
+            // Set local variable
+            EmitLocalOp(EOpCode::OP_SET_LOCAL, LocalIndex);
+        }
+        else
+        {
+            // Set global variable - emit OP_SET_GLOBAL with variable name
+            int32 NameConstant = Chunk->AddConstant(FScriptValue::String(Name));
+            EmitConstantOp(EOpCode::OP_SET_GLOBAL, NameConstant);
+        }
+        return;
+    }
+
+    if (TargetKind == EScriptNodeKind::ArrayAccess)
+    {
+        // arr[index] = value
+        FArrayAccessExpr* Arr = static_cast<FArrayAccessExpr*>(Expr->Target.Get());
+
+        // Compile array expression, index, then value
+        CompileExpression(Arr->Array.Get());
+        CompileExpression(Arr->Index.Get());
+        CompileExpression(Expr->Value.Get());
+
+        // Emit array assignment
+        EmitByte((uint8)EOpCode::OP_SET_ELEMENT);
+
+        // If the array expression is a simple identifier (variable), we must write
+        // the modified array back into that variable (locals or globals).
+        if (Arr->Array.IsValid() && Arr->Array->GetKind() == EScriptNodeKind::Identifier)
+        {
+            FIdentifierExpr* Id = static_cast<FIdentifierExpr*>(Arr->Array.Get());
+            FString Name = Id->Name.Lexeme;
+            int32 LocalIndex = ResolveLocal(Name);
+
+            if (LocalIndex >= 0)
+            {
+                // Sets the local slot to the value on top of the stack (assignment is expression)
+                EmitLocalOp(EOpCode::OP_SET_LOCAL, LocalIndex);
+            }
+            else
+            {
+                int32 NameConstant = Chunk->AddConstant(FScriptValue::String(Name));
+                EmitConstantOp(EOpCode::OP_SET_GLOBAL, NameConstant);
+            }
+
+            return;
+        }
+
+        // Unsupported array assignment target (e.g., expression that's not a variable)
+        ReportError(TEXT("Array assignment target must be a variable identifier"));
+        return;
+    }
+
+    if (TargetKind == EScriptNodeKind::StructAccess)
+    {
+        // obj.field = value
+        FStructAccessExpr* Field = static_cast<FStructAccessExpr*>(Expr->Target.Get());
+
+        // Compile object, then value
+        CompileExpression(Field->Object.Get());
+
+        int32 FieldNameIndex = Chunk->AddConstant(FScriptValue::String(Field->Field.Lexeme));
+        CompileExpression(Expr->Value.Get());
+
+        EmitByte((uint8)EOpCode::OP_SET_FIELD);
+        EmitNameIndex(FieldNameIndex);
+        return;
+    }
+
+    // Unknown/unsupported assignment target
+    ReportError(TEXT("Invalid assignment target"));
+}
+
+void FScriptCompiler::CompileCall(FCallExpr* Expr, bool bTailCall)
+{
+    // Get function name
+    if (Expr->Callee->GetKind() != EScriptNodeKind::Identifier)
+    {
+        ReportError(TEXT("Only direct function calls supported"));
+        return;
+    }
+    
+    FIdentifierExpr* Callee = static_cast<FIdentifierExpr*>(Expr->Callee.Get());
+    FString FuncName = Callee->Name.Lexeme;
+    
+    // Small script functions are substituted at the call site (this also beats a tail call)
+    int32 FuncIndex = ResolveFunction(FuncName);
+    if (FuncIndex >= 0 && bInliningEnabled && TryInlineCall(Expr, FuncIndex))
+    {
+        bLastExpressionWasVoidCall = false;
+        return;
+    }
+    
+    // Check if this is a known native function (declared in ScriptNatives.inl)
+    const FNativeFunctionDecl* NativeDecl = FScriptNativeRegistry::FindDeclaration(FuncName);
+    
+    // Track void calls (natives still push nil, so the stack is cleaned up the same way)
+    bool bIsVoidFunction = NativeDecl && NativeDecl->IsVoid();
+    
+    // Compile arguments
+    for (const auto& Arg : Expr->Arguments)
+    {
+        if (Arg.IsValid())
+        {
+            CompileExpression(Arg.Get());
+        }
+    }
+    
+    // Emit call instruction
+    if (FuncIndex >= 0)
+    {
+        // This is a user-defined function
+        EmitBytes((uint8)(bTailCall ? EOpCode::OP_TAIL_CALL : EOpCode::OP_CALL), (uint8)Expr->Arguments.Num());
+        EmitBytes((uint8)(FuncIndex >> 8), (uint8)(FuncIndex & 0xFF)); // Function index (2 bytes)
+        
+        // Check if user-defined function is void
+        if (Functions.IsValidIndex(FuncIndex) && Functions[FuncIndex].ReturnType == EScriptType::VOID)
+        {
+            bIsVoidFunction = true;
+        }
+    }
+    else
+    {
+        // Might be a native function - will handle in VM
+        if (!NativeDecl)
+        {
+            SCRIPT_LOG_WARNING(FString::Printf(TEXT("Unknown function '%s' - assuming native"), *FuncName));
+        }
+        else if (!NativeDecl->AcceptsArgCount(Expr->Arguments.Num()))
+        {
+            if (NativeDecl->MinArgs == NativeDecl->MaxArgs)
+            {
+                ReportError(FString::Printf(TEXT("Native '%s' expects %d argument(s), got %d"),
+                    *FuncName, NativeDecl->MinArgs, Expr->Arguments.Num()));
+            }
+            else if (NativeDecl->MaxArgs < 0)
+            {
+                ReportError(FString::Printf(TEXT("Native '%s' expects at least %d argument(s), got %d"),
+                    *FuncName, NativeDecl->MinArgs, Expr->Arguments.Num()));
+            }
+            else
+            {
+                ReportError(FString::Printf(TEXT("Native '%s' expects %d to %d arguments, got %d"),
+                    *FuncName, NativeDecl->MinArgs, NativeDecl->MaxArgs, Expr->Arguments.Num()));
+            }
+        }
+        
+        if (Expr->Arguments.Num() > NATIVE_CALL_ARGC_MASK)
+        {
+            ReportError(FString::Printf(TEXT("Too many arguments to native '%s' (max %d)"), *FuncName, NATIVE_CALL_ARGC_MASK));
+        }
+        
+        // Natives bound with a typed signature get their arguments checked here, so proven
+        // call sites can skip the runtime checks
+        uint8 ArgByte = (uint8)(Expr->Arguments.Num() & NATIVE_CALL_ARGC_MASK);
+        const FNativeFunctionEntry* Bound = FScriptNativeRegistry::Get().FindEntry(FuncName);
+        if (Bound && Bound->Decl.HasSignature() && CheckNativeArguments(FuncName, Bound->Decl, Expr))
+        {
+            ArgByte |= NATIVE_CALL_ARGS_CHECKED;
+        }
+        
+        EmitBytes((uint8)EOpCode::OP_CALL_NATIVE, ArgByte);
+        int32 NameIndex = Chunk->AddConstant(FScriptValue::String(FuncName));
+        EmitNameIndex(NameIndex);
     }
-    else if (NodeType == TEXT("Assign"))
+    
+    // Set flag if this is a void function
+    bLastExpressionWasVoidCall = bIsVoidFunction;
+}
+
+//=============================================================================
+// Inlining
+//=============================================================================
+
+bool FScriptCompiler::TryInlineCall(FCallExpr* Expr, int32 FuncIndex)
+{
+    if (InlineFrames.Num() >= MaxInlineDepth || !IsInlineCandidate(FuncIndex, CurrentLine))
+    {
+        return false;
+    }
+    
+    const FFunction& Callee = Functions[FuncIndex];
+    const int32 NumArgs = Expr->Arguments.Num();
+    if (NumArgs != Callee.Arity)
+    {
+        return false; // Arity errors are reported by the verifier, as for any call
+    }
+    
+    FFunctionDecl* Decl = Callee.Decl;
+    FScriptExpression* Body = static_cast<FReturnStmt*>(Decl->Body->Statements[0].Get())->Value.Get();
+    
+    // The compiler does not track expression temporaries on the stack, so an argument
+    // cannot be given a slot of its own. Each parameter is bound instead to:
+    // - the caller local passed to it, read in place (no other argument may assign it)
+    // - a literal, or a side-effect-free argument the body reads exactly once, compiled at its use
+    bool bArgumentsPure = true;
+    for (const TSharedPtr<FScriptExpression>& Arg : Expr->Arguments)
+    {
+        bArgumentsPure &= IsInlinePure(Arg.Get());
+    }
+    
+    FInlineFrame Frame;
+    for (int32 i = 0; i < NumArgs; ++i)
+    {
+        FInlineBinding Binding;
+        Binding.Type = EScriptType::AUTO;
+        Binding.Slot = -1;
+        Binding.Value = nullptr;
+        if (Decl->TypedParameters.Num() > 0)
+        {
+            Binding.Name = Decl->TypedParameters[i].Name.Lexeme;
+            Binding.Type = Decl->TypedParameters[i].Type;
+        }
+        else
+        {
+            Binding.Name = Decl->Parameters[i].Lexeme;
+        }
+        
+        FScriptExpression* Arg = Expr->Arguments[i].Get();
+        if (Arg && Arg->GetKind() == EScriptNodeKind::Identifier)
+        {
+            const FString& ArgName = static_cast<FIdentifierExpr*>(Arg)->Name.Lexeme;
+            const FInlineBinding* Outer = FindInlineBinding(ArgName);
+            bool bAssigned = false;
+            for (const TSharedPtr<FScriptExpression>& Other : Expr->Arguments)
+            {
+                bAssigned |= IsLocalAssigned(Other.Get(), ArgName);
+            }
+            if (!bAssigned && !(Outer && Outer->Value))
+            {
+                Binding.Slot = ResolveLocal(ArgName);
+            }
+        }
+        
+        if (Binding.Slot < 0)
+        {
+            if ((Arg && Arg->GetKind() == EScriptNodeKind::Literal) || (bArgumentsPure && CountUses(Body, Binding.Name) == 1))
+            {
+                Binding.Value = Arg;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        Frame.Bindings.Add(Binding);
+    }
+    
+    Frame.CallerFloor = LocalFloor;
+    Frame.CallerSourceFile = CurrentSourceFile;
+    const int32 SavedLine = CurrentLine;
+    InlineFrames.Add(MoveTemp(Frame));
+    LocalFloor = Locals.Num();
+    CurrentSourceFile = Callee.SourceFile;
+    
+    CompileExpression(Body);
+    
+    LocalFloor = InlineFrames.Last().CallerFloor;
+    CurrentSourceFile = InlineFrames.Last().CallerSourceFile;
+    CurrentLine = SavedLine;
+    InlineFrames.Pop();
+    return true;
+}
+
+void FScriptCompiler::CompileInlineArgument(const FInlineBinding& Binding)
+{
+    // The argument belongs to the call site: compile it with the innermost frame taken off
+    FInlineFrame Frame = InlineFrames.Pop();
+    const int32 SavedFloor = LocalFloor;
+    const FString SavedSourceFile = CurrentSourceFile;
+    const int32 SavedLine = CurrentLine;
+    LocalFloor = Frame.CallerFloor;
+    CurrentSourceFile = Frame.CallerSourceFile;
+    
+    CompileExpression(Binding.Value);
+    
+    LocalFloor = SavedFloor;
+    CurrentSourceFile = SavedSourceFile;
+    CurrentLine = SavedLine;
+    InlineFrames.Add(MoveTemp(Frame));
+}
+
+int32 FScriptCompiler::GetInlineCost(int32 FuncIndex)
+{
+    FFunction& Func = Functions[FuncIndex];
+    if (Func.InlineCost != 0)
+    {
+        return Func.InlineCost;
+    }
+    
+    // Marked first, so a function reached again while it is being analysed is never inlined
+    Func.InlineCost = -1;
+    
+    // Only 'return <expression>;' bodies - no statements, no locals of their own
+    const FFunctionDecl* Decl = Func.Decl;
+    if (!Decl || Func.ReturnType == EScriptType::VOID || !Decl->Body.IsValid() || Decl->Body->Statements.Num() != 1)
+    {
+        return -1;
+    }
+    
+    const FScriptStatement* Statement = Decl->Body->Statements[0].Get();
+    if (!Statement || Statement->GetKind() != EScriptNodeKind::Return)
+    {
+        return -1;
+    }
+    
+    const FReturnStmt* Return = static_cast<const FReturnStmt*>(Statement);
+    const int32 Cost = CountInlineNodes(Return->Value.Get(), Func.Name);
+    if (Cost > 0 && Cost <= MaxHotInlineNodes)
+    {
+        Func.InlineCost = Cost;
+    }
+    return Func.InlineCost;
+}
+
+bool FScriptCompiler::IsInlineCandidate(int32 FuncIndex, int32 Line)
+{
+    const int32 Cost = GetInlineCost(FuncIndex);
+    if (Cost <= 0)
+    {
+        return false;
+    }
+    if (Cost <= MaxInlineNodes)
+    {
+        return true;
+    }
+    
+    // Past the normal budget only where the profile shows the call site hot
+    if (!Profile.IsValid() || Profile->GetTotalCalls() == 0)
+    {
+        return false;
+    }
+    const uint64 Calls = Profile->GetCallCount(CurrentSourceFile, Line, Functions[FuncIndex].Name);
+    return Calls >= FScriptProfile::MinSamples && Calls * 1000 >= Profile->GetTotalCalls() * HotCallPerMille;
+}
+
+int32 FScriptCompiler::CountInlineNodes(const FScriptExpression* Expr, const FString& SelfName)
+{
+    // -1 = must not be inlined: writes (the body would need locals of its own),
+    // direct recursion, or a node type this walk does not know
+    if (!Expr)
+    {
+        return -1;
+    }
+    
+    auto Sum = [&SelfName](int32 Total, const FScriptExpression* Child)
+    {
+        const int32 Count = CountInlineNodes(Child, SelfName);
+        return (Total < 0 || Count < 0) ? -1 : Total + Count;
+    };
+    
+    const EScriptNodeKind Kind = Expr->GetKind();
+    
+    if (Kind == EScriptNodeKind::Literal || Kind == EScriptNodeKind::Identifier)
+    {
+        return 1;
+    }
+    if (Kind == EScriptNodeKind::Binary)
+    {
+        const FBinaryExpr* Bin = static_cast<const FBinaryExpr*>(Expr);
+        return Sum(Sum(1, Bin->Left.Get()), Bin->Right.Get());
+    }
+    if (Kind == EScriptNodeKind::Unary)
+    {
+        return Sum(1, static_cast<const FUnaryExpr*>(Expr)->Right.Get());
+    }
+    if (Kind == EScriptNodeKind::TypeCast)
+    {
+        return Sum(1, static_cast<const FTypeCastExpr*>(Expr)->Expression.Get());
+    }
+    if (Kind == EScriptNodeKind::ArrayAccess)
+    {
+        const FArrayAccessExpr* Access = static_cast<const FArrayAccessExpr*>(Expr);
+        return Sum(Sum(1, Access->Array.Get()), Access->Index.Get());
+    }
+    if (Kind == EScriptNodeKind::StructAccess)
+    {
+        return Sum(1, static_cast<const FStructAccessExpr*>(Expr)->Object.Get());
+    }
+    if (Kind == EScriptNodeKind::Call)
+    {
+        const FCallExpr* Call = static_cast<const FCallExpr*>(Expr);
+        if (Call->Callee->GetKind() != EScriptNodeKind::Identifier ||
+            static_cast<const FIdentifierExpr*>(Call->Callee.Get())->Name.Lexeme == SelfName)
+        {
+            return -1;
+        }
+        int32 Total = 1;
+        for (const TSharedPtr<FScriptExpression>& Argument : Call->Arguments)
+        {
+            Total = Sum(Total, Argument.Get());
+        }
+        return Total;
+    }
+    if (Kind == EScriptNodeKind::ArrayLiteral)
+    {
+        int32 Total = 1;
+        for (const TSharedPtr<FScriptExpression>& Element : static_cast<const FArrayLiteralExpr*>(Expr)->Elements)
+        {
+            Total = Sum(Total, Element.Get());
+        }
+        return Total;
+    }
+    return -1;
+}
+
+int32 FScriptCompiler::CountUses(const FScriptExpression* Expr, const FString& Name)
+{
+    // Only walks what CountInlineNodes accepts
+    if (!Expr)
     {
-        CompileAssign(static_cast<FAssignExpr*>(Expression));
+        return 0;
     }
-    else if (NodeType == TEXT("Call"))
+    
+    const EScriptNodeKind Kind = Expr->GetKind();
+    
+    if (Kind == EScriptNodeKind::Identifier)
     {
-        CompileCall(static_cast<FCallExpr*>(Expression));
+        return static_cast<const FIdentifierExpr*>(Expr)->Name.Lexeme == Name ? 1 : 0;
     }
-    else if (NodeType == TEXT("ArrayLiteral"))
+    if (Kind == EScriptNodeKind::Binary)
     {
-        CompileArrayLiteral(static_cast<FArrayLiteralExpr*>(Expression));
+        const FBinaryExpr* Bin = static_cast<const FBinaryExpr*>(Expr);
+        return CountUses(Bin->Left.Get(), Name) + CountUses(Bin->Right.Get(), Name);
     }
-    else if (NodeType == TEXT("ArrayAccess"))
+    if (Kind == EScriptNodeKind::Unary)
     {
-        CompileArrayAccess(static_cast<FArrayAccessExpr*>(Expression));
+        return CountUses(static_cast<const FUnaryExpr*>(Expr)->Right.Get(), Name);
     }
-    else if (NodeType == TEXT("ArrayAssign"))
+    if (Kind == EScriptNodeKind::TypeCast)
     {
-        CompileArrayAssign(static_cast<FArrayAssignExpr*>(Expression));
+        return CountUses(static_cast<const FTypeCastExpr*>(Expr)->Expression.Get(), Name);
     }
-    else if (NodeType == TEXT("StructAccess"))
+    if (Kind == EScriptNodeKind::ArrayAccess)
     {
-        CompileStructAccess(static_cast<FStructAccessExpr*>(Expression));
+        const FArrayAccessExpr* Access = static_cast<const FArrayAccessExpr*>(Expr);
+        return CountUses(Access->Array.Get(), Name) + CountUses(Access->Index.Get(), Name);
     }
-    else if (NodeType == TEXT("StructAssign"))
+    if (Kind == EScriptNodeKind::StructAccess)
     {
-        CompileStructAssign(static_cast<FStructAssignExpr*>(Expression));
+        return CountUses(static_cast<const FStructAccessExpr*>(Expr)->Object.Get(), Name);
     }
-    else if (NodeType == TEXT("TypeCast") || NodeType == TEXT("Cast"))
+    if (Kind == EScriptNodeKind::Call)
     {
-        CompileTypeCast(static_cast<FTypeCastExpr*>(Expression));
+        int32 Total = 0;
+        for (const TSharedPtr<FScriptExpression>& Argument : static_cast<const FCallExpr*>(Expr)->Arguments)
+        {
+            Total += CountUses(Argument.Get(), Name);
+        }
+        return Total;
     }
-    else
+    if (Kind == EScriptNodeKind::ArrayLiteral)
     {
-        ReportError(FString::Printf(TEXT("Unknown expression type: %s"), *NodeType));
+        int32 Total = 0;
+        for (const TSharedPtr<FScriptExpression>& Element : static_cast<const FArrayLiteralExpr*>(Expr)->Elements)
+        {
+            Total += CountUses(Element.Get(), Name);
+        }
+        return Total;
     }
+    return 0;
 }
 
-void FScriptCompiler::CompileLiteral(FLiteralExpr* Expr)
+bool FScriptCompiler::IsInlinePure(const FScriptExpression* Expr)
 {
-    // Parse the literal value from token
-    FString Lexeme = Expr->Token.Lexeme;
-    
-    if (Expr->Token.Type == ETokenType::NUMBER)
-    {
-        double Value = FCString::Atod(*Lexeme);
-        EmitConstant(FScriptValue::Number(Value));
-    }
-    else if (Expr->Token.Type == ETokenType::STRING)
+    // Pure = may be evaluated later than written without anyone noticing: literals,
+    // caller locals (an inlined body cannot assign them) and operators over those.
+    // Globals are not, a call in the body may change them.
+    if (!Expr)
     {
-        EmitConstant(FScriptValue::String(Lexeme));
+        return false;
     }
-    else if (Expr->Token.Type == ETokenType::KW_TRUE)
+    
+    const EScriptNodeKind Kind = Expr->GetKind();
+    
+    if (Kind == EScriptNodeKind::Literal)
     {
-        EmitConstant(FScriptValue::Bool(true));
+        return true;
     }
-    else if (Expr->Token.Type == ETokenType::KW_FALSE)
+    if (Kind == EScriptNodeKind::Identifier)
     {
-        EmitConstant(FScriptValue::Bool(false));
+        const FString& Name = static_cast<const FIdentifierExpr*>(Expr)->Name.Lexeme;
+        // Parameters of the enclosing inlined body only ever bind pure arguments
+        return FindInlineBinding(Name) || ResolveLocal(Name) >= 0;
     }
-    else if (Expr->Token.Type == ETokenType::NIL)
+    if (Kind == EScriptNodeKind::Binary)
     {
-        EmitByte((uint8)EOpCode::OP_NIL);
+        const FBinaryExpr* Bin = static_cast<const FBinaryExpr*>(Expr);
+        return IsInlinePure(Bin->Left.Get()) && IsInlinePure(Bin->Right.Get());
     }
-    else
+    if (Kind == EScriptNodeKind::Unary)
     {
-        ReportError(FString::Printf(TEXT("Unknown literal type: %s"), *Lexeme));
+        return IsInlinePure(static_cast<const FUnaryExpr*>(Expr)->Right.Get());
     }
+    return false;
 }
 
-void FScriptCompiler::CompileBinary(FBinaryExpr* Expr)
+const FScriptCompiler::FInlineBinding* FScriptCompiler::FindInlineBinding(const FString& Name) const
 {
-    // Compile operands
-    CompileExpression(Expr->Left.Get());
-    CompileExpression(Expr->Right.Get());
-    
-    // Emit operator
-    switch (Expr->Operator.Type)
+    if (InlineFrames.Num() == 0)
     {
-        // Arithmetic
-        case ETokenType::PLUS:    EmitByte((uint8)EOpCode::OP_ADD); break;
-        case ETokenType::MINUS:   EmitByte((uint8)EOpCode::OP_SUBTRACT); break;
-        case ETokenType::STAR:    EmitByte((uint8)EOpCode::OP_MULTIPLY); break;
-        case ETokenType::SLASH:   EmitByte((uint8)EOpCode::OP_DIVIDE); break;
-        case ETokenType::PERCENT: EmitByte((uint8)EOpCode::OP_MODULO); break;
-        
-        // Comparison
-        case ETokenType::EQUAL_EQUAL:   EmitByte((uint8)EOpCode::OP_EQUAL); break;
-        case ETokenType::BANG_EQUAL:    EmitBytes((uint8)EOpCode::OP_EQUAL, (uint8)EOpCode::OP_NOT); break;
-        case ETokenType::GREATER:       EmitByte((uint8)EOpCode::OP_GREATER); break;
-        case ETokenType::GREATER_EQUAL: EmitBytes((uint8)EOpCode::OP_LESS, (uint8)EOpCode::OP_NOT); break;
-        case ETokenType::LESS:          EmitByte((uint8)EOpCode::OP_LESS); break;
-        case ETokenType::LESS_EQUAL:    EmitBytes((uint8)EOpCode::OP_GREATER, (uint8)EOpCode::OP_NOT); break;
-        
-        // Logical
-        case ETokenType::AND:              EmitByte((uint8)EOpCode::OP_AND); break;
-        case ETokenType::OR:               EmitByte((uint8)EOpCode::OP_OR); break;
-        case ETokenType::AMPERSAND_AMPERSAND: EmitByte((uint8)EOpCode::OP_AND); break;  // && same as 'and'
-        case ETokenType::PIPE_PIPE:        EmitByte((uint8)EOpCode::OP_OR); break;   // || same as 'or'
-        
-        // Bitwise
-        case ETokenType::AMPERSAND: EmitByte((uint8)EOpCode::OP_BIT_AND); break;
-        case ETokenType::PIPE:      EmitByte((uint8)EOpCode::OP_BIT_OR); break;
-        case ETokenType::CARET:     EmitByte((uint8)EOpCode::OP_BIT_XOR); break;
-        
-        default:
-            ReportError(TEXT("Unknown binary operator: ") + Expr->Operator.Lexeme);
+        return nullptr;
     }
-}
-
-void FScriptCompiler::CompileUnary(FUnaryExpr* Expr)
-{
-    CompileExpression(Expr->Right.Get());
-    
-    switch (Expr->Operator.Type)
+    for (const FInlineBinding& Binding : InlineFrames.Last().Bindings)
     {
-        case ETokenType::MINUS: EmitByte((uint8)EOpCode::OP_NEGATE); break;
-        case ETokenType::BANG:  EmitByte((uint8)EOpCode::OP_NOT); break;
-        case ETokenType::TILDE: EmitByte((uint8)EOpCode::OP_BIT_NOT); break;
-        default:
-            ReportError(TEXT("Unknown unary operator: ") + Expr->Operator.Lexeme);
+        if (Binding.Name == Name)
+        {
+            return &Binding;
+        }
     }
+    return nullptr;
 }
 
-void FScriptCompiler::CompileIdentifier(FIdentifierExpr* Expr)
+int32 FScriptCompiler::GetSourceLine(const FScriptASTNode* Node)
 {
-    FString Name = Expr->Name.Lexeme;
-    int32 LocalIndex = ResolveLocal(Name);
+    // Only nodes that keep a token know their line; 0 = keep the current one
+    const EScriptNodeKind Kind = Node->GetKind();
     
-    if (LocalIndex >= 0)
+    if (Kind == EScriptNodeKind::Literal)
     {
-        // Local variable
-        EmitBytes((uint8)EOpCode::OP_GET_LOCAL, (uint8)LocalIndex);
+        return static_cast<const FLiteralExpr*>(Node)->Token.Line;
     }
-    else
+    if (Kind == EScriptNodeKind::Identifier)
     {
-        // Global variable - emit OP_GET_GLOBAL with variable name
-        int32 NameConstant = Chunk->AddConstant(FScriptValue::String(Name));
-        EmitByte((uint8)EOpCode::OP_GET_GLOBAL);
-        EmitByte((uint8)NameConstant);
+        return static_cast<const FIdentifierExpr*>(Node)->Name.Line;
     }
-}
-
-void FScriptCompiler::CompileAssign(FAssignExpr* Expr)
-{
-    // Assignment targets can be:
-    // - Identifier (local/global variable)
-    // - Array access (arr[index])
-    // - Struct/object field access (obj.field)
-
-    FString TargetType = Expr->Target->GetNodeType();
-
-    if (TargetType == TEXT("Identifier"))
+    if (Kind == EScriptNodeKind::Binary)
     {
-        FIdentifierExpr* Target = static_cast<FIdentifierExpr*>(Expr->Target.Get());
-        FString Name = Target->Name.Lexeme;
-        int32 LocalIndex = ResolveLocal(Name);
-
-        // Compile value
-        CompileExpression(Expr->Value.Get());
-
-        if (LocalIndex >= 0)
-        {
-            // Set local variable
-            EmitBytes((uint8)EOpCode::OP_SET_LOCAL, (uint8)LocalIndex);
-        }
-        else
-        {
-            // Set global variable - emit OP_SET_GLOBAL with variable name
-            int32 NameConstant = Chunk->AddConstant(FScriptValue::String(Name));
-            EmitByte((uint8)EOpCode::OP_SET_GLOBAL);
-            EmitByte((uint8)NameConstant);
-        }
-        return;
+        return static_cast<const FBinaryExpr*>(Node)->Operator.Line;
     }
-
-    if (TargetType == TEXT("ArrayAccess"))
+    if (Kind == EScriptNodeKind::Unary)
     {
-        // arr[index] = value
-        FArrayAccessExpr* Arr = static_cast<FArrayAccessExpr*>(Expr->Target.Get());
-
-        // Compile array expression, index, then value
-        CompileExpression(Arr->Array.Get());
-        CompileExpression(Arr->Index.Get());
-        CompileExpression(Expr->Value.Get());
-
-        // Emit array assignment
-        EmitByte((uint8)EOpCode::OP_SET_ELEMENT);
-
-        // If the array expression is a simple identifier (variable), we must write
-        // the modified array back into that variable (locals or globals).
-        if (Arr->Array.IsValid() && Arr->Array->GetNodeType() == TEXT("Identifier"))
-        {
-            FIdentifierExpr* Id = static_cast<FIdentifierExpr*>(Arr->Array.Get());
-            FString Name = Id->Name.Lexeme;
-            int32 LocalIndex = ResolveLocal(Name);
-
-            if (LocalIndex >= 0)
-            {
-                // Sets the local slot to the value on top of the stack (assignment is expression)
-                EmitBytes((uint8)EOpCode::OP_SET_LOCAL, (uint8)LocalIndex);
-            }
-            else
-            {
-                int32 NameConstant = Chunk->AddConstant(FScriptValue::String(Name));
-                EmitByte((uint8)EOpCode::OP_SET_GLOBAL);
-                EmitByte((uint8)NameConstant);
-            }
-
-            return;
-        }
-
-        // Unsupported array assignment target (e.g., expression that's not a variable)
-        ReportError(TEXT("Array assignment target must be a variable identifier"));
-        return;
+        return static_cast<const FUnaryExpr*>(Node)->Operator.Line;
     }
-
-    if (TargetType == TEXT("StructAccess"))
+    if (Kind == EScriptNodeKind::StructAccess)
     {
-        // obj.field = value
-        FStructAccessExpr* Field = static_cast<FStructAccessExpr*>(Expr->Target.Get());
-
-        // Compile object, then value
-        CompileExpression(Field->Object.Get());
-
-        int32 FieldNameIndex = Chunk->AddConstant(FScriptValue::String(Field->Field.Lexeme));
-        CompileExpression(Expr->Value.Get());
-
-        EmitByte((uint8)EOpCode::OP_SET_FIELD);
-        EmitByte((uint8)(FieldNameIndex >> 8));
-        EmitByte((uint8)(FieldNameIndex & 0xFF));
-        return;
+        return static_cast<const FStructAccessExpr*>(Node)->Field.Line;
     }
-
-    // Unknown/unsupported assignment target
-    ReportError(TEXT("Invalid assignment target"));
-}
-
-void FScriptCompiler::CompileCall(FCallExpr* Expr)
-{
-    // Get function name
-    if (Expr->Callee->GetNodeType() != TEXT("Identifier"))
+    if (Kind == EScriptNodeKind::StructAssign)
     {
-        ReportError(TEXT("Only direct function calls supported"));
-        return;
+        return static_cast<const FStructAssignExpr*>(Node)->Field.Line;
     }
-    
-    FIdentifierExpr* Callee = static_cast<FIdentifierExpr*>(Expr->Callee.Get());
-    FString FuncName = Callee->Name.Lexeme;
-    
-    // Check if this is a known native function
-    bool bIsKnownNative = NativeFunctions.Contains(FuncName);
-    
-    // Check if this is a known void native function (for implicit return handling if needed)
-    // For now, we just track if it was a void call to clean up stack
-    static const TSet<FString> VoidNativeFunctions = {
-        TEXT("Log"), TEXT("Print"),
-        TEXT("UI_ShowSplashScreen"), TEXT("UI_ShowMenuScreen"), 
-        TEXT("UI_ShowLoadingScreen"), TEXT("UI_ShowInGameHUD"),
-        TEXT("UI_ShowPauseMenu"), TEXT("UI_HidePauseMenu"),
-        TEXT("Audio_Stop"), TEXT("Audio_SetVolume"),
-        TEXT("Audio_SetCategoryVolume"), TEXT("Audio_FadeOutAndStop")
-    };
-    
-    bool bIsVoidFunction = VoidNativeFunctions.Contains(FuncName);
-    
-    // Compile arguments
-    for (const auto& Arg : Expr->Arguments)
+    if (Kind == EScriptNodeKind::Call)
     {
-        if (Arg.IsValid())
-        {
-            CompileExpression(Arg.Get());
-        }
+        const FCallExpr* Call = static_cast<const FCallExpr*>(Node);
+        return Call->Callee.IsValid() ? GetSourceLine(Call->Callee.Get()) : 0;
     }
-    
-    // Emit call instruction
-    int32 FuncIndex = ResolveFunction(FuncName);
-    if (FuncIndex >= 0)
+    if (Kind == EScriptNodeKind::VarDecl)
     {
-        // This is a user-defined function
-        EmitBytes((uint8)EOpCode::OP_CALL, (uint8)Expr->Arguments.Num());
-        EmitBytes((uint8)(FuncIndex >> 8), (uint8)(FuncIndex & 0xFF)); // Function index (2 bytes)
-        
-        // Check if user-defined function is void
-        if (Functions.IsValidIndex(FuncIndex) && Functions[FuncIndex].ReturnType == EScriptType::VOID)
-        {
-            bIsVoidFunction = true;
-        }
+        return static_cast<const FVarDeclStmt*>(Node)->Name.Line;
     }
-    else
+    if (Kind == EScriptNodeKind::ForEach)
     {
-        // Might be a native function - will handle in VM
-        if (!bIsKnownNative)
-        {
-            SCRIPT_LOG_WARNING(FString::Printf(TEXT("Unknown function '%s' - assuming native"), *FuncName));
-        }
-        EmitBytes((uint8)EOpCode::OP_CALL_NATIVE, (uint8)Expr->Arguments.Num());
-        int32 NameIndex = Chunk->AddConstant(FScriptValue::String(FuncName));
-        EmitBytes((uint8)(NameIndex >> 8), (uint8)(NameIndex & 0xFF));
+        return static_cast<const FForEachStmt*>(Node)->Name.Line;
     }
-    
-    // Set flag if this is a void function
-    bLastExpressionWasVoidCall = bIsVoidFunction;
+    return 0;
 }
 
 void FScriptCompiler::CompileArrayLiteral(FArrayLiteralExpr* Expr)
@@ -1183,98 +2251,293 @@ void FScriptCompiler::CompileStructAccess(FStructAccessExpr* Expr)
     // Get field name as constant
     int32 FieldNameIndex = Chunk->AddConstant(FScriptValue::String(Expr->Field.Lexeme));
     
-    // Emit struct access instruction
-    EmitByte((uint8)EOpCode::OP_GET_FIELD);
-    EmitByte((uint8)(FieldNameIndex >> 8));  // High byte
-    EmitByte((uint8)(FieldNameIndex & 0xFF)); // Low byte
+    // Emit struct access instruction
+    EmitByte((uint8)EOpCode::OP_GET_FIELD);
+    EmitNameIndex(FieldNameIndex);
+}
+
+void FScriptCompiler::CompileStructAssign(FStructAssignExpr* Expr)
+{
+    // Compile struct assignment: object.field = value
+    
+    // Compile the object
+    CompileExpression(Expr->Object.Get());
+    
+    // Get field name as constant
+    int32 FieldNameIndex = Chunk->AddConstant(FScriptValue::String(Expr->Field.Lexeme));
+    
+    // Compile the value
+    CompileExpression(Expr->Value.Get());
+    
+    // Emit struct assignment instruction
+    EmitByte((uint8)EOpCode::OP_SET_FIELD);
+    EmitNameIndex(FieldNameIndex);
+}
+
+void FScriptCompiler::CompileSwitch(FSwitchStmt* Stmt)
+{
+    // Cases do not fall through, and 'break' leaves the switch. Integer and string
+    // literal cases dispatch with a single OP_SWITCH_TABLE / OP_SWITCH_LOOKUP, any
+    // other switch compares the value against each case in order
+    FLoopContext SwitchCtx;
+    SwitchCtx.bSwitch = true;
+    
+    TArray<int32> CaseSlots;
+    TArray<int32> DefaultSlots;
+    TArray<int32> EndJumps;
+    int32 Next = 0;
+    
+    // Table entries are relative to the end of the dispatch instruction
+    auto PatchEntry = [this, &Next](int32 Slot)
+    {
+        const int32 Jump = Chunk->Code.Num() - Next;
+        if (Jump > 0xFFFF)
+        {
+            // Compiled as a comparison chain next time
+            RequestWideJumps();
+            return;
+        }
+        Chunk->Code[Slot] = (Jump >> 8) & 0xFF;
+        Chunk->Code[Slot + 1] = Jump & 0xFF;
+    };
+    
+    const bool bDispatch = EmitSwitchDispatch(Stmt, CaseSlots, DefaultSlots, Next);
+    if (bDispatch)
+    {
+        // The dispatch popped the value
+        SwitchCtx.LocalCount = Locals.Num();
+        LoopStack.Add(SwitchCtx);
+        
+        for (int32 i = 0; i < Stmt->Cases.Num(); ++i)
+        {
+            if (CaseSlots[i] != INDEX_NONE)
+            {
+                PatchEntry(CaseSlots[i]);
+            }
+            CompileStatement(Stmt->Cases[i].Value.Get());
+            if (i + 1 < Stmt->Cases.Num() || Stmt->DefaultCase.IsValid())
+            {
+                EndJumps.Add(EmitJump(EOpCode::OP_JUMP));
+            }
+        }
+        
+        for (int32 Slot : DefaultSlots)
+        {
+            PatchEntry(Slot);
+        }
+    }
+    else
+    {
+        // The value stays in a scoped temporary while the cases are compared
+        BeginScope();
+        CompileExpression(Stmt->Expression.Get());
+        const int32 ValueSlot = AddLocal(TEXT("$switch_expr"), EScriptType::AUTO);
+        SwitchCtx.LocalCount = Locals.Num();
+        LoopStack.Add(SwitchCtx);
+        
+        for (const auto& Case : Stmt->Cases)
+        {
+            EmitLocalOp(EOpCode::OP_GET_LOCAL, ValueSlot);
+            CompileExpression(Case.Key.Get());
+            EmitByte((uint8)EOpCode::OP_EQUAL);
+            
+            const int32 NextCase = EmitJump(EOpCode::OP_JUMP_IF_FALSE);
+            EmitByte((uint8)EOpCode::OP_POP); // Pop comparison
+            CompileStatement(Case.Value.Get());
+            EndJumps.Add(EmitJump(EOpCode::OP_JUMP));
+            
+            PatchJump(NextCase);
+            EmitByte((uint8)EOpCode::OP_POP); // Pop comparison
+        }
+    }
+    
+    if (Stmt->DefaultCase.IsValid())
+    {
+        CompileStatement(Stmt->DefaultCase.Get());
+    }
+    
+    for (int32 EndJump : EndJumps)
+    {
+        PatchJump(EndJump);
+    }
+    for (int32 BreakJump : LoopStack.Last().BreakJumps)
+    {
+        PatchJump(BreakJump);
+    }
+    LoopStack.Pop();
+    
+    if (!bDispatch)
+    {
+        EndScope();
+    }
 }
 
-void FScriptCompiler::CompileStructAssign(FStructAssignExpr* Expr)
+bool FScriptCompiler::GetSwitchKey(const FScriptExpression* Expr, FScriptValue& OutKey)
 {
-    // Compile struct assignment: object.field = value
-    
-    // Compile the object
-    CompileExpression(Expr->Object.Get());
-    
-    // Get field name as constant
-    int32 FieldNameIndex = Chunk->AddConstant(FScriptValue::String(Expr->Field.Lexeme));
-    
-    // Compile the value
-    CompileExpression(Expr->Value.Get());
+    // An integer literal (optionally negated) or a plain ASCII string literal - the
+    // lookup keys are sorted here and binary searched by the VM, and ASCII orders the
+    // same in every string encoding
+    bool bNegate = false;
+    if (Expr && Expr->GetKind() == EScriptNodeKind::Unary)
+    {
+        const FUnaryExpr* Unary = static_cast<const FUnaryExpr*>(Expr);
+        bNegate = Unary->Operator.Type == ETokenType::MINUS;
+        Expr = bNegate ? Unary->Right.Get() : nullptr;
+    }
+    if (!Expr || Expr->GetKind() != EScriptNodeKind::Literal)
+    {
+        return false;
+    }
     
-    // Emit struct assignment instruction
-    EmitByte((uint8)EOpCode::OP_SET_FIELD);
-    EmitByte((uint8)(FieldNameIndex >> 8));  // High byte
-    EmitByte((uint8)(FieldNameIndex & 0xFF)); // Low byte
+    const FScriptToken& Token = static_cast<const FLiteralExpr*>(Expr)->Token;
+    if (Token.Type == ETokenType::NUMBER)
+    {
+        const double Value = FCString::Atod(*Token.Lexeme) * (bNegate ? -1.0 : 1.0);
+        if (Value != FMath::RoundToDouble(Value) || Value < -2147483648.0 || Value > 2147483647.0)
+        {
+            return false;
+        }
+        OutKey = FScriptValue::Number(Value);
+        return true;
+    }
+    if (Token.Type == ETokenType::STRING && !bNegate)
+    {
+        for (TCHAR Char : Token.Lexeme)
+        {
+            if ((uint32)Char > 127)
+            {
+                return false;
+            }
+        }
+        OutKey = FScriptValue::String(Token.Lexeme);
+        return true;
+    }
+    return false;
 }
 
-void FScriptCompiler::CompileSwitch(FSwitchStmt* Stmt)
+bool FScriptCompiler::EmitSwitchDispatch(FSwitchStmt* Stmt, TArray<int32>& OutCaseSlots, TArray<int32>& OutDefaultSlots, int32& OutNext)
 {
-    // Compile switch statement
-    // For now, we'll translate to a series of if-else comparisons
-    // Note: This is a simplified approach - a more efficient implementation would use jump tables
+    // The case offsets are 16-bit, with no wide form
+    if (bWideJumps)
+    {
+        return false;
+    }
+    
+    // Every case must be a key of the same kind; a repeated key keeps its first case
+    TArray<FScriptValue> Keys;
+    TArray<int32> KeyCases;
+    for (int32 i = 0; i < Stmt->Cases.Num(); ++i)
+    {
+        FScriptValue Key;
+        if (!GetSwitchKey(Stmt->Cases[i].Key.Get(), Key) || (Keys.Num() > 0 && Key.Type != Keys[0].Type))
+        {
+            return false;
+        }
+        const bool bRepeated = Keys.ContainsByPredicate([&Key](const FScriptValue& Existing)
+        {
+            return Key.IsNumber() ? Existing.AsNumber() == Key.AsNumber() : Existing.AsString().Equals(Key.AsString(), ESearchCase::CaseSensitive);
+        });
+        if (!bRepeated)
+        {
+            Keys.Add(Key);
+            KeyCases.Add(i);
+        }
+    }
+    if (Keys.Num() == 0 || Keys.Num() > 0xFFFF)
+    {
+        return false;
+    }
     
-    // Store the switch expression value in a temporary local variable
-    int32 TempVarIndex = AddLocal(TEXT("$switch_expr"), EScriptType::AUTO);
+    // Sort the keys, carrying the case each one belongs to
+    TArray<int32> Order;
+    for (int32 i = 0; i < Keys.Num(); ++i)
+    {
+        Order.Add(i);
+    }
+    Order.Sort([&Keys](int32 A, int32 B)
+    {
+        return Keys[A].IsNumber() ? Keys[A].AsNumber() < Keys[B].AsNumber()
+            : Keys[A].AsString().Compare(Keys[B].AsString(), ESearchCase::CaseSensitive) < 0;
+    });
     
-    // Compile the switch expression
-    CompileExpression(Stmt->Expression.Get());
+    // Dense integers get an indexed table when at least half of its entries are cases
+    bool bTable = false;
+    int32 Low = 0;
+    int32 Count = Keys.Num();
+    if (Keys[0].IsNumber())
+    {
+        const double Range = Keys[Order.Last()].AsNumber() - Keys[Order[0]].AsNumber() + 1.0;
+        bTable = Range <= 0xFFFF && Range <= Keys.Num() * 2.0;
+        if (bTable)
+        {
+            Low = (int32)Keys[Order[0]].AsNumber();
+            Count = (int32)Range;
+        }
+    }
     
-    // Assign the value to the temporary variable
-    EmitByte((uint8)EOpCode::OP_SET_LOCAL);
-    EmitByte((uint8)TempVarIndex);
+    int32 KeysConstant = 0;
+    if (!bTable)
+    {
+        FScriptValue SortedKeys = FScriptValue::Array(TArray<FScriptValue>());
+        for (int32 Index : Order)
+        {
+            SortedKeys.ArrayValue.Add(Keys[Index]);
+        }
+        KeysConstant = Chunk->AddConstant(SortedKeys);
+        if (KeysConstant > 0xFFFF)
+        {
+            return false;
+        }
+    }
     
-    // Track whether any case matched to implement fallthrough behavior
-    bool bAnyCaseMatched = false;
+    CompileExpression(Stmt->Expression.Get());
     
-    // Process all cases
-    for (int32 i = 0; i < Stmt->Cases.Num(); ++i)
+    if (bTable)
     {
-        auto& Case = Stmt->Cases[i];
-        
-        // Get the current offset for jump patching
-        uint16 JumpIfExprNotEqual = 0;
-        
-        // Load the temporary variable value
-        EmitByte((uint8)EOpCode::OP_GET_LOCAL);
-        EmitByte((uint8)TempVarIndex);
-        
-        // Compile the case value to compare against
-        CompileExpression(Case.Key.Get());
-        
-        // Compare for equality
-        EmitByte((uint8)EOpCode::OP_EQUAL);
-        
-        // Jump to the next case if the values are not equal
-        JumpIfExprNotEqual = EmitJump(EOpCode::OP_JUMP_IF_FALSE);
-        
-        // Pop the comparison result
-        EmitByte((uint8)EOpCode::OP_POP);
-        
-        // Execute the case body
-        CompileStatement(Case.Value.Get());
-        
-        // After a case is executed, we need to decide whether to break or continue
-        // For now, we'll implement simple break behavior (no fallthrough)
-        // In a full implementation, we would check for the presence of break statements
-        uint16 JumpToEnd = EmitJump(EOpCode::OP_JUMP);
-        
-        // Patch the jump to go to the next case if the expression doesn't match this case
-        PatchJump(JumpIfExprNotEqual);
-        
-        // Pop the comparison result after the jump
-        EmitByte((uint8)EOpCode::OP_POP);
+        EmitByte((uint8)EOpCode::OP_SWITCH_TABLE);
+        EmitByte((Low >> 24) & 0xFF);
+        EmitByte((Low >> 16) & 0xFF);
+        EmitByte((Low >> 8) & 0xFF);
+        EmitByte(Low & 0xFF);
     }
+    else
+    {
+        EmitByte((uint8)EOpCode::OP_SWITCH_LOOKUP);
+        EmitByte((KeysConstant >> 8) & 0xFF);
+        EmitByte(KeysConstant & 0xFF);
+    }
+    EmitByte((Count >> 8) & 0xFF);
+    EmitByte(Count & 0xFF);
     
-    // Handle default case if exists
-    if (Stmt->DefaultCase.IsValid())
+    // Every entry is patched once the case bodies are placed
+    const int32 Entries = Chunk->Code.Num();
+    for (int32 i = 0; i < Count + 1; ++i)
     {
-        // Execute default case body
-        CompileStatement(Stmt->DefaultCase.Get());
+        EmitBytes(0, 0);
     }
+    OutNext = Chunk->Code.Num();
     
-    // Patch all the jumps to end of switch
-    // For simplicity of this example implementation
+    // Entry 0 is the default, entry 1 + i the i-th table slot or sorted key
+    OutCaseSlots.Init(INDEX_NONE, Stmt->Cases.Num());
+    TArray<bool> bCaseEntry;
+    bCaseEntry.Init(false, Count);
+    for (int32 i = 0; i < Order.Num(); ++i)
+    {
+        const int32 Key = Order[i];
+        const int32 Entry = bTable ? (int32)Keys[Key].AsNumber() - Low : i;
+        OutCaseSlots[KeyCases[Key]] = Entries + 2 + Entry * 2;
+        bCaseEntry[Entry] = true;
+    }
+    OutDefaultSlots.Reset();
+    OutDefaultSlots.Add(Entries);
+    for (int32 Entry = 0; Entry < Count; ++Entry)
+    {
+        if (!bCaseEntry[Entry])
+        {
+            OutDefaultSlots.Add(Entries + 2 + Entry * 2);
+        }
+    }
+    return true;
 }
 
 void FScriptCompiler::CompileTypeCast(FTypeCastExpr* Expr)
@@ -1291,7 +2554,7 @@ void FScriptCompiler::CompileTypeCast(FTypeCastExpr* Expr)
 
 void FScriptCompiler::EmitByte(uint8 Byte)
 {
-    Chunk->WriteByte(Byte, 0); // Line number tracking TODO
+    Chunk->WriteByte(Byte, CurrentLine, CurrentSourceFile);
 }
 
 void FScriptCompiler::EmitBytes(uint8 Byte1, uint8 Byte2)
@@ -1300,6 +2563,124 @@ void FScriptCompiler::EmitBytes(uint8 Byte1, uint8 Byte2)
     EmitByte(Byte2);
 }
 
+bool FScriptCompiler::IsColdElse(FIfStmt* Stmt, int32 Line) const
+{
+    // Only in function bodies, where the end of the function is the place for the arm;
+    // 'break' and 'continue' need the loop context of the if, so such arms stay
+    if (!Profile.IsValid() || !Stmt->ElseBranch.IsValid() || !bInFunction || InlineFrames.Num() > 0 ||
+        HasLoopExit(Stmt->ElseBranch.Get()))
+    {
+        return false;
+    }
+    
+    const FScriptProfile::FBranch* Branch = Profile->FindBranch(CurrentSourceFile, Line);
+    if (!Branch)
+    {
+        return false;
+    }
+    const uint64 Runs = Branch->Taken + Branch->FallThrough;
+    return Runs >= FScriptProfile::MinSamples && Branch->FallThrough * 100 >= Runs * HotBranchPercent;
+}
+
+void FScriptCompiler::EmitColdBranches()
+{
+    // An arm may queue more (an if inside it), so this runs until none are left
+    for (int32 i = 0; i < ColdBranches.Num(); ++i)
+    {
+        FColdBranch Cold = ColdBranches[i];
+        
+        TArray<FLocal> SavedLocals = MoveTemp(Locals);
+        const int32 SavedDepth = ScopeDepth;
+        Locals = MoveTemp(Cold.Locals);
+        ScopeDepth = Cold.ScopeDepth;
+        CurrentLine = Cold.Line;
+        
+        // Same stack as the fall-through path of the if: its locals and the condition
+        PatchJump(Cold.EntryJump);
+        EmitByte((uint8)EOpCode::OP_POP); // Pop condition
+        CompileStatement(Cold.Body);
+        EmitLoop(Cold.Resume);
+        
+        Locals = MoveTemp(SavedLocals);
+        ScopeDepth = SavedDepth;
+    }
+    ColdBranches.Empty();
+}
+
+bool FScriptCompiler::HasLoopExit(const FScriptStatement* Statement)
+{
+    // Conservative: a statement type not listed here counts as one
+    if (!Statement)
+    {
+        return false;
+    }
+    
+    const EScriptNodeKind Kind = Statement->GetKind();
+    
+    if (Kind == EScriptNodeKind::ExprStmt || Kind == EScriptNodeKind::VarDecl || Kind == EScriptNodeKind::Return)
+    {
+        return false;
+    }
+    if (Kind == EScriptNodeKind::Block)
+    {
+        for (const TSharedPtr<FScriptStatement>& Inner : static_cast<const FBlockStmt*>(Statement)->Statements)
+        {
+            if (HasLoopExit(Inner.Get()))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+    if (Kind == EScriptNodeKind::If)
+    {
+        const FIfStmt* Stmt = static_cast<const FIfStmt*>(Statement);
+        return HasLoopExit(Stmt->ThenBranch.Get()) || HasLoopExit(Stmt->ElseBranch.Get());
+    }
+    if (Kind == EScriptNodeKind::While)
+    {
+        return HasLoopExit(static_cast<const FWhileStmt*>(Statement)->Body.Get());
+    }
+    if (Kind == EScriptNodeKind::For)
+    {
+        return HasLoopExit(static_cast<const FForStmt*>(Statement)->Body.Get());
+    }
+    if (Kind == EScriptNodeKind::ForEach)
+    {
+        return HasLoopExit(static_cast<const FForEachStmt*>(Statement)->Body.Get());
+    }
+    
+    // Break, Continue, and Switch (whose cases take 'break')
+    return true;
+}
+
+bool FScriptCompiler::IsNumberOnly(EOpCode OpCode) const
+{
+    return Profile.IsValid() && Profile->IsNumberOnly(CurrentSourceFile, CurrentLine, OpCode);
+}
+
+void FScriptCompiler::EmitOperator(EOpCode OpCode, bool bNegate)
+{
+    if (IsNumberOnly(OpCode))
+    {
+        if (bNegate)
+        {
+            EmitByte((uint8)(OpCode == EOpCode::OP_LESS ? EOpCode::OP_NOT_LESS_NUMBER : EOpCode::OP_NOT_GREATER_NUMBER));
+        }
+        else
+        {
+            EmitByte((uint8)GetNumberOpCode(OpCode));
+        }
+        return;
+    }
+    
+    EmitByte((uint8)OpCode);
+    if (bNegate)
+    {
+        EmitByte((uint8)EOpCode::OP_NOT);
+    }
+}
+
 void FScriptCompiler::EmitReturn()
 {
     EmitByte((uint8)EOpCode::OP_RETURN);
@@ -1308,24 +2689,83 @@ void FScriptCompiler::EmitReturn()
 void FScriptCompiler::EmitConstant(const FScriptValue& Value)
 {
     int32 ConstIndex = Chunk->AddConstant(Value);
-    EmitBytes((uint8)EOpCode::OP_CONSTANT, (uint8)ConstIndex);
+    EmitConstantOp(EOpCode::OP_CONSTANT, ConstIndex);
+}
+
+void FScriptCompiler::EmitConstantOp(EOpCode OpCode, int32 ConstIndex)
+{
+    // Module code always takes the _WIDE form: the linker renumbers its constants in place
+    if (ConstIndex <= MAX_COMPACT_OPERAND && !bCompilingModule)
+    {
+        EmitBytes((uint8)OpCode, (uint8)ConstIndex);
+        return;
+    }
+    if (ConstIndex > MAX_WIDE_CONSTANT_INDEX)
+    {
+        ReportError(FString::Printf(TEXT("Too many constants in one script (max %d)"), MAX_WIDE_CONSTANT_INDEX + 1));
+        return;
+    }
+    EmitByte((uint8)GetWideOpCode(OpCode));
+    EmitByte((uint8)(ConstIndex >> 16));
+    EmitBytes((uint8)(ConstIndex >> 8), (uint8)(ConstIndex & 0xFF));
+}
+
+void FScriptCompiler::EmitLocalOp(EOpCode OpCode, int32 Slot)
+{
+    if (Slot <= MAX_COMPACT_OPERAND)
+    {
+        EmitBytes((uint8)OpCode, (uint8)Slot);
+        return;
+    }
+    // AddLocal keeps slots within MAX_WIDE_LOCAL_SLOT
+    EmitByte((uint8)GetWideOpCode(OpCode));
+    EmitBytes((uint8)(Slot >> 8), (uint8)(Slot & 0xFF));
+}
+
+void FScriptCompiler::EmitNameIndex(int32 NameIndex)
+{
+    // Field and native names have no wide form
+    if (NameIndex > 0xFFFF)
+    {
+        ReportError(FString::Printf(TEXT("Too many constants: a field or native name needs an index below %d"), 0x10000));
+        return;
+    }
+    EmitBytes((uint8)(NameIndex >> 8), (uint8)(NameIndex & 0xFF));
 }
 
 int32 FScriptCompiler::EmitJump(EOpCode JumpOp)
 {
-    EmitByte((uint8)JumpOp);
-    EmitByte(0xFF); // Placeholder
-    EmitByte(0xFF); // Placeholder
-    return Chunk->Code.Num() - 2;
+    EmitByte((uint8)(bWideJumps ? GetWideOpCode(JumpOp) : JumpOp));
+    return EmitJumpOffset();
+}
+
+int32 FScriptCompiler::EmitJumpOffset()
+{
+    const int32 Size = bWideJumps ? 4 : 2;
+    for (int32 i = 0; i < Size; ++i)
+    {
+        EmitByte(0xFF); // Placeholder
+    }
+    return Chunk->Code.Num() - Size;
 }
 
 void FScriptCompiler::PatchJump(int32 Offset)
 {
+    if (bWideJumps)
+    {
+        const int32 Jump = Chunk->Code.Num() - Offset - 4;
+        Chunk->Code[Offset] = (Jump >> 24) & 0xFF;
+        Chunk->Code[Offset + 1] = (Jump >> 16) & 0xFF;
+        Chunk->Code[Offset + 2] = (Jump >> 8) & 0xFF;
+        Chunk->Code[Offset + 3] = Jump & 0xFF;
+        return;
+    }
+    
     int32 Jump = Chunk->Code.Num() - Offset - 2;
     
     if (Jump > 0xFFFF)
     {
-        ReportError(TEXT("Jump offset too large"));
+        RequestWideJumps();
         return;
     }
     
@@ -1335,12 +2775,28 @@ void FScriptCompiler::PatchJump(int32 Offset)
 
 int32 FScriptCompiler::EmitLoop(int32 LoopStart)
 {
-    EmitByte((uint8)EOpCode::OP_LOOP);
+    // The distance back is known here, so only a loop that needs it gets the wide form
+    const int32 Offset = Chunk->Code.Num() - LoopStart + 3;
+    if (Offset <= 0xFFFF)
+    {
+        EmitByte((uint8)EOpCode::OP_LOOP);
+        return EmitLoopOffset(LoopStart);
+    }
     
+    const int32 WideOffset = Offset + 2;
+    EmitByte((uint8)EOpCode::OP_LOOP_WIDE);
+    EmitBytes((uint8)(WideOffset >> 24), (uint8)(WideOffset >> 16));
+    EmitBytes((uint8)(WideOffset >> 8), (uint8)(WideOffset & 0xFF));
+    return Chunk->Code.Num();
+}
+
+int32 FScriptCompiler::EmitLoopOffset(int32 LoopStart)
+{
     int32 Offset = Chunk->Code.Num() - LoopStart + 2;
     if (Offset > 0xFFFF)
     {
-        ReportError(TEXT("Loop body too large"));
+        // OP_FOR_LOOP: the counted loop is compiled as a while loop next time
+        RequestWideJumps();
     }
     
     EmitByte((Offset >> 8) & 0xFF);
@@ -1349,6 +2805,27 @@ int32 FScriptCompiler::EmitLoop(int32 LoopStart)
     return Chunk->Code.Num();
 }
 
+void FScriptCompiler::RequestWideJumps()
+{
+    if (bWideJumps)
+    {
+        ReportError(TEXT("Jump offset too large"));
+        return;
+    }
+    WideJumpUnits.Add(CurrentUnit);
+    bRecompileForWideJumps = true;
+}
+
+void FScriptCompiler::EmitLoopExitPops(const FLoopContext& Loop)
+{
+    // Locals declared inside the loop body are still on the stack when
+    // break/continue leave it early - their scopes never reach EndScope
+    for (int32 i = Locals.Num() - 1; i >= Loop.LocalCount; --i)
+    {
+        EmitByte((uint8)EOpCode::OP_POP);
+    }
+}
+
 //=============================================================================
 // Type System
 //=============================================================================
@@ -1366,9 +2843,9 @@ EScriptType FScriptCompiler::InferType(FScriptExpression* Expr)
         return Expr->InferredType;
     }
     
-    FString NodeType = Expr->GetNodeType();
+    const EScriptNodeKind Kind = Expr->GetKind();
     
-    if (NodeType == TEXT("Literal"))
+    if (Kind == EScriptNodeKind::Literal)
     {
         FLiteralExpr* Lit = static_cast<FLiteralExpr*>(Expr);
         if (Lit->Token.Type == ETokenType::NUMBER)
@@ -1384,7 +2861,7 @@ EScriptType FScriptCompiler::InferType(FScriptExpression* Expr)
             return EScriptType::BOOL;
         }
     }
-    else if (NodeType == TEXT("Binary"))
+    else if (Kind == EScriptNodeKind::Binary)
     {
         FBinaryExpr* Bin = static_cast<FBinaryExpr*>(Expr);
         EScriptType LeftType = InferType(Bin->Left.Get());
@@ -1397,9 +2874,13 @@ EScriptType FScriptCompiler::InferType(FScriptExpression* Expr)
         }
         return EScriptType::INT;
     }
-    else if (NodeType == TEXT("Identifier"))
+    else if (Kind == EScriptNodeKind::Identifier)
     {
         FIdentifierExpr* Ident = static_cast<FIdentifierExpr*>(Expr);
+        if (const FInlineBinding* Binding = FindInlineBinding(Ident->Name.Lexeme))
+        {
+            return Binding->Type;
+        }
         int32 LocalIndex = ResolveLocal(Ident->Name.Lexeme);
         if (LocalIndex >= 0)
         {
@@ -1410,6 +2891,133 @@ EScriptType FScriptCompiler::InferType(FScriptExpression* Expr)
     return EScriptType::AUTO;
 }
 
+EScriptType FScriptCompiler::ProveType(FScriptExpression* Expr)
+{
+    // Unlike InferType, only trusts what the VM guarantees at runtime - declared variable
+    // types are not enforced on assignment, so identifiers are never proven
+    if (!Expr)
+    {
+        return EScriptType::AUTO;
+    }
+    
+    const EScriptNodeKind Kind = Expr->GetKind();
+    
+    if (Kind == EScriptNodeKind::Literal)
+    {
+        FLiteralExpr* Lit = static_cast<FLiteralExpr*>(Expr);
+        switch (Lit->Token.Type)
+        {
+            case ETokenType::NUMBER:   return EScriptType::FLOAT;
+            case ETokenType::STRING:   return EScriptType::STRING;
+            case ETokenType::KW_TRUE:
+            case ETokenType::KW_FALSE: return EScriptType::BOOL;
+            default:                   return EScriptType::AUTO;
+        }
+    }
+    else if (Kind == EScriptNodeKind::Unary)
+    {
+        FUnaryExpr* Unary = static_cast<FUnaryExpr*>(Expr);
+        if (Unary->Operator.Type == ETokenType::MINUS) return EScriptType::FLOAT;
+        if (Unary->Operator.Type == ETokenType::BANG) return EScriptType::BOOL;
+    }
+    else if (Kind == EScriptNodeKind::Binary)
+    {
+        FBinaryExpr* Bin = static_cast<FBinaryExpr*>(Expr);
+        switch (Bin->Operator.Type)
+        {
+            // These either produce a number or raise a runtime error
+            case ETokenType::MINUS:
+            case ETokenType::STAR:
+            case ETokenType::SLASH:
+            case ETokenType::PERCENT:
+                return EScriptType::FLOAT;
+            
+            case ETokenType::PLUS:
+            {
+                EScriptType LeftType = ProveType(Bin->Left.Get());
+                EScriptType RightType = ProveType(Bin->Right.Get());
+                if (LeftType == EScriptType::STRING || RightType == EScriptType::STRING)
+                {
+                    return EScriptType::STRING;
+                }
+                if (LeftType == EScriptType::FLOAT && RightType == EScriptType::FLOAT)
+                {
+                    return EScriptType::FLOAT;
+                }
+                return EScriptType::AUTO;
+            }
+            
+            case ETokenType::EQUAL_EQUAL:
+            case ETokenType::BANG_EQUAL:
+            case ETokenType::GREATER:
+            case ETokenType::GREATER_EQUAL:
+            case ETokenType::LESS:
+            case ETokenType::LESS_EQUAL:
+                return EScriptType::BOOL;
+            
+            default:
+                break;
+        }
+    }
+    else if (Kind == EScriptNodeKind::Call)
+    {
+        // A typed native whose arguments were proven boxes exactly its declared result
+        FCallExpr* Call = static_cast<FCallExpr*>(Expr);
+        if (Call->Callee->GetKind() == EScriptNodeKind::Identifier)
+        {
+            const FString& FuncName = static_cast<FIdentifierExpr*>(Call->Callee.Get())->Name.Lexeme;
+            const FNativeFunctionEntry* Bound = FScriptNativeRegistry::Get().FindEntry(FuncName);
+            if (ResolveFunction(FuncName) < 0 && Bound && Bound->Decl.HasSignature() &&
+                Bound->Decl.ParamTypes.Num() == Call->Arguments.Num() && Bound->Decl.ReturnType != EScriptType::VOID)
+            {
+                for (int32 i = 0; i < Call->Arguments.Num(); ++i)
+                {
+                    EScriptType ParamType = Bound->Decl.ParamTypes[i];
+                    EScriptType ArgType = ProveType(Call->Arguments[i].Get());
+                    if (ParamType != EScriptType::AUTO && (ArgType == EScriptType::AUTO || !TypesCompatible(ArgType, ParamType)))
+                    {
+                        return EScriptType::AUTO;
+                    }
+                }
+                return Bound->Decl.ReturnType;
+            }
+        }
+    }
+    
+    return EScriptType::AUTO;
+}
+
+bool FScriptCompiler::CheckNativeArguments(const FString& FuncName, const FNativeFunctionDecl& Signature, FCallExpr* Expr)
+{
+    if (Expr->Arguments.Num() != Signature.ParamTypes.Num())
+    {
+        return false; // Arity error already reported against the declaration
+    }
+    
+    bool bAllProven = true;
+    for (int32 i = 0; i < Expr->Arguments.Num(); ++i)
+    {
+        EScriptType ParamType = Signature.ParamTypes[i];
+        if (ParamType == EScriptType::AUTO)
+        {
+            continue; // Native accepts any value
+        }
+        
+        EScriptType ArgType = ProveType(Expr->Arguments[i].Get());
+        if (ArgType == EScriptType::AUTO)
+        {
+            bAllProven = false; // Unknown until runtime - keep the checked call
+        }
+        else if (!TypesCompatible(ArgType, ParamType))
+        {
+            ReportError(FString::Printf(TEXT("Native '%s' argument %d expects %s, got %s"),
+                *FuncName, i + 1, *FTypeCastExpr::GetTypeName(ParamType), *FTypeCastExpr::GetTypeName(ArgType)));
+            bAllProven = false;
+        }
+    }
+    return bAllProven;
+}
+
 void FScriptCompiler::EmitTypeConversion(EScriptType From, EScriptType To)
 {
     if (From == To || To == EScriptType::AUTO)
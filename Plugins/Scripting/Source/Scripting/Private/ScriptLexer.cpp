@@ -17,6 +17,9 @@ TArray<FScriptToken> FScriptLexer::ScanTokens()
 {
     Tokens.Empty();
     Errors.Empty();
+    // Scripts run about one token per four characters; reserving one per three covers denser
+    // code without growing the array
+    Tokens.Reserve(Source.Len() / 3 + 1);
     
     while (!IsAtEnd())
     {
@@ -26,8 +29,28 @@ TArray<FScriptToken> FScriptLexer::ScanTokens()
     
     // Add EOF token
     Tokens.Add(FScriptToken(ETokenType::END_OF_FILE, TEXT(""), Line, Column));
+    Tokens.Last().Offset = Current;
     
-    return Tokens;
+    return MoveTemp(Tokens);
+}
+
+FScriptToken FScriptLexer::NextToken()
+{
+    // Tokens holds at most the one token being scanned; whitespace and comments add none
+    Tokens.Reset();
+    while (Tokens.Num() == 0 && !IsAtEnd())
+    {
+        Start = Current;
+        ScanToken();
+    }
+    
+    if (Tokens.Num() == 0)
+    {
+        FScriptToken EndOfFile(ETokenType::END_OF_FILE, TEXT(""), Line, Column);
+        EndOfFile.Offset = Current;
+        return EndOfFile;
+    }
+    return MoveTemp(Tokens[0]);
 }
 
 bool FScriptLexer::IsAtEnd() const
@@ -164,21 +187,17 @@ void FScriptLexer::ScanToken()
 
 void FScriptLexer::AddToken(ETokenType Type)
 {
-    FString Text = Source.Mid(Start, Current - Start);
-    AddToken(Type, Text);
+    AddToken(Type, Source.Mid(Start, Current - Start));
 }
 
-void FScriptLexer::AddToken(ETokenType Type, const FString& Lexeme)
+void FScriptLexer::AddToken(ETokenType Type, FString Lexeme)
 {
-    FScriptToken Token(Type, Lexeme, Line, Column - Lexeme.Len());
+    const int32 TokenColumn = Column - Lexeme.Len();
+    Tokens.Add(FScriptToken(Type, MoveTemp(Lexeme), Line, TokenColumn));
     
-    // Store number value for number tokens
-    if (Type == ETokenType::NUMBER)
-    {
-        Token.NumberValue = FCString::Atod(*Lexeme);
-    }
-    
-    Tokens.Add(Token);
+    FScriptToken& Token = Tokens.Last();
+    Token.Offset = Start;
+    Token.Length = Current - Start;
 }
 
 void FScriptLexer::ScanString()
@@ -221,31 +240,59 @@ void FScriptLexer::ScanString()
     // Closing "
     Advance();
     
-    AddToken(ETokenType::STRING, StringValue);
+    AddToken(ETokenType::STRING, MoveTemp(StringValue));
 }
 
 void FScriptLexer::ScanNumber()
 {
-    while (IsDigit(Peek())) Advance();
+    // The value is accumulated while scanning. Up to 15 digits and 22 decimals both the
+    // digits and the power of ten are exact doubles, so one division rounds the same as
+    // Atod would; longer literals fall back to it
+    static const double PowersOfTen[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    
+    uint64 Digits = Source[Start] - '0';
+    int32 NumDigits = 1;
+    int32 NumDecimals = 0;
+    while (IsDigit(Peek()))
+    {
+        Digits = Digits * 10 + (Advance() - '0');
+        NumDigits++;
+    }
     
     // Look for fractional part
     if (Peek() == '.' && IsDigit(PeekNext()))
     {
         Advance(); // Consume '.'
-        while (IsDigit(Peek())) Advance();
+        while (IsDigit(Peek()))
+        {
+            Digits = Digits * 10 + (Advance() - '0');
+            NumDigits++;
+            NumDecimals++;
+        }
     }
     
     AddToken(ETokenType::NUMBER);
+    
+    FScriptToken& Token = Tokens.Last();
+    if (NumDigits <= 15 && NumDecimals <= 22)
+    {
+        Token.NumberValue = (double)Digits / PowersOfTen[NumDecimals];
+    }
+    else
+    {
+        Token.NumberValue = FCString::Atod(*Token.Lexeme);
+    }
 }
 
 void FScriptLexer::ScanIdentifier()
 {
     while (IsAlphaNumeric(Peek())) Advance();
     
-    FString Text = Source.Mid(Start, Current - Start);
-    ETokenType Type = GetKeywordType(Text);
-    
-    AddToken(Type, Text);
+    // Keywords are recognized in the source text, before a lexeme is made
+    AddToken(GetKeywordType(*Source + Start, Current - Start));
 }
 
 void FScriptLexer::ReportError(const FString& Message)
@@ -272,48 +319,99 @@ bool FScriptLexer::IsAlphaNumeric(char C)
     return IsAlpha(C) || IsDigit(C);
 }
 
-ETokenType FScriptLexer::GetKeywordType(const FString& Text)
+ETokenType FScriptLexer::GetKeywordType(const TCHAR* Text, int32 Length)
 {
-    static TMap<FString, ETokenType> Keywords = {
-        { TEXT("and"), ETokenType::AND },
-        { TEXT("break"), ETokenType::BREAK },
-        { TEXT("case"), ETokenType::CASE },
-        { TEXT("class"), ETokenType::CLASS },
-        { TEXT("const"), ETokenType::CONST },
-        { TEXT("continue"), ETokenType::CONTINUE },
-        { TEXT("default"), ETokenType::DEFAULT },
-        { TEXT("do"), ETokenType::DO },
-        { TEXT("else"), ETokenType::ELSE },
-        { TEXT("enum"), ETokenType::ENUM },
-        { TEXT("false"), ETokenType::KW_FALSE },
-        { TEXT("float"), ETokenType::FLOAT },
-        { TEXT("for"), ETokenType::FOR },
-        { TEXT("function"), ETokenType::FUNCTION },
-        { TEXT("if"), ETokenType::IF },
-        { TEXT("import"), ETokenType::IMPORT },
-        { TEXT("int"), ETokenType::INT },
-        { TEXT("nil"), ETokenType::NIL },
-        { TEXT("null"), ETokenType::NIL },
-        { TEXT("or"), ETokenType::OR },
-        { TEXT("print"), ETokenType::PRINT },
-        { TEXT("return"), ETokenType::RETURN },
-        { TEXT("string"), ETokenType::STRING_TYPE },
-        { TEXT("struct"), ETokenType::STRUCT },
-        { TEXT("super"), ETokenType::SUPER },
-        { TEXT("switch"), ETokenType::SWITCH },
-        { TEXT("this"), ETokenType::THIS },
-        { TEXT("true"), ETokenType::KW_TRUE },
-        { TEXT("typedef"), ETokenType::TYPEDEF },
-        { TEXT("var"), ETokenType::VAR },
-        { TEXT("void"), ETokenType::VOID },
-        { TEXT("while"), ETokenType::WHILE }
+    // Switch on length, then first character: most identifiers are rejected without
+    // comparing a single character
+    auto Is = [Text, Length](const TCHAR* Keyword)
+    {
+        for (int32 i = 1; i < Length; ++i)
+        {
+            if (Text[i] != Keyword[i]) return false;
+        }
+        return true;
     };
     
-    if (const ETokenType* Type = Keywords.Find(Text))
+    switch (Length)
     {
-        return *Type;
+        case 2:
+            switch (Text[0])
+            {
+                case 'd': if (Is(TEXT("do"))) return ETokenType::DO; break;
+                case 'i': if (Is(TEXT("if"))) return ETokenType::IF; break;
+                case 'o': if (Is(TEXT("or"))) return ETokenType::OR; break;
+            }
+            break;
+        case 3:
+            switch (Text[0])
+            {
+                case 'a': if (Is(TEXT("and"))) return ETokenType::AND; break;
+                case 'f': if (Is(TEXT("for"))) return ETokenType::FOR; break;
+                case 'i': if (Is(TEXT("int"))) return ETokenType::INT; break;
+                case 'n': if (Is(TEXT("nil"))) return ETokenType::NIL; break;
+                case 'v': if (Is(TEXT("var"))) return ETokenType::VAR; break;
+            }
+            break;
+        case 4:
+            switch (Text[0])
+            {
+                case 'c': if (Is(TEXT("case"))) return ETokenType::CASE; break;
+                case 'e':
+                    if (Is(TEXT("else"))) return ETokenType::ELSE;
+                    if (Is(TEXT("enum"))) return ETokenType::ENUM;
+                    break;
+                case 'n': if (Is(TEXT("null"))) return ETokenType::NIL; break;
+                case 't':
+                    if (Is(TEXT("this"))) return ETokenType::THIS;
+                    if (Is(TEXT("true"))) return ETokenType::KW_TRUE;
+                    break;
+                case 'v': if (Is(TEXT("void"))) return ETokenType::VOID; break;
+            }
+            break;
+        case 5:
+            switch (Text[0])
+            {
+                case 'b': if (Is(TEXT("break"))) return ETokenType::BREAK; break;
+                case 'c':
+                    if (Is(TEXT("class"))) return ETokenType::CLASS;
+                    if (Is(TEXT("const"))) return ETokenType::CONST;
+                    break;
+                case 'f':
+                    if (Is(TEXT("false"))) return ETokenType::KW_FALSE;
+                    if (Is(TEXT("float"))) return ETokenType::FLOAT;
+                    break;
+                case 'p': if (Is(TEXT("print"))) return ETokenType::PRINT; break;
+                case 's': if (Is(TEXT("super"))) return ETokenType::SUPER; break;
+                case 'w': if (Is(TEXT("while"))) return ETokenType::WHILE; break;
+            }
+            break;
+        case 6:
+            switch (Text[0])
+            {
+                case 'i': if (Is(TEXT("import"))) return ETokenType::IMPORT; break;
+                case 'r': if (Is(TEXT("return"))) return ETokenType::RETURN; break;
+                case 's':
+                    if (Is(TEXT("string"))) return ETokenType::STRING_TYPE;
+                    if (Is(TEXT("struct"))) return ETokenType::STRUCT;
+                    if (Is(TEXT("switch"))) return ETokenType::SWITCH;
+                    break;
+            }
+            break;
+        case 7:
+            switch (Text[0])
+            {
+                case 'd': if (Is(TEXT("default"))) return ETokenType::DEFAULT; break;
+                case 't': if (Is(TEXT("typedef"))) return ETokenType::TYPEDEF; break;
+            }
+            break;
+        case 8:
+            switch (Text[0])
+            {
+                case 'c': if (Is(TEXT("continue"))) return ETokenType::CONTINUE; break;
+                case 'f': if (Is(TEXT("function"))) return ETokenType::FUNCTION; break;
+            }
+            break;
     }
     
     return ETokenType::IDENTIFIER;
 }
-
@@ -0,0 +1,876 @@
+// Copyright Vampire Game Project. All Rights Reserved.
+// Custom scripting system for secure modding support.
+
+#include "ScriptLinker.h"
+#include "ScriptLogger.h"
+#include "ScriptLexer.h"
+#include "ScriptParser.h"
+#include "ScriptCompiler.h"
+#include "ScriptBytecodeVerifier.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+// Magic number for module objects: "SBO1" (Script Bytecode Object v1). Version 1 kept a
+// line, column and file per byte of code, version 2 a line table
+static const uint32 MODULE_OBJECT_MAGIC = 0x314F4253;
+static const int32 MODULE_OBJECT_VERSION = 2;
+
+// Magic number for header artifacts: "SBH1" (Script Bytecode Header v1), then the
+// version, the 64-bit key and a module object
+static const uint32 HEADER_ARTIFACT_MAGIC = 0x31484253;
+static const int32 HEADER_ARTIFACT_VERSION = 1;
+
+//=============================================================================
+// FScriptModule
+//=============================================================================
+
+const FScriptModuleExport* FScriptModule::FindExport(const FString& Name) const
+{
+    for (const FScriptModuleExport& Export : Exports)
+    {
+        if (Export.Name == Name)
+        {
+            return &Export;
+        }
+    }
+    return nullptr;
+}
+
+FFunctionDecl* FScriptModule::FindFunctionDecl(const FString& Name) const
+{
+    if (!Program.IsValid())
+    {
+        return nullptr;
+    }
+    for (const auto& Func : Program->Functions)
+    {
+        if (Func.IsValid() && Func->Name.Lexeme == Name)
+        {
+            return Func.Get();
+        }
+    }
+    return nullptr;
+}
+
+void FScriptModule::Serialize(TArray<uint8>& OutData) const
+{
+    auto WriteInt32 = [&OutData](int32 Value) {
+        for (int32 i = 0; i < 4; ++i)
+        {
+            OutData.Add((Value >> (i * 8)) & 0xFF);
+        }
+    };
+
+    auto WriteString = [&OutData, &WriteInt32](const FString& Str) {
+        FTCHARToUTF8 Converter(*Str);
+        WriteInt32(Converter.Length());
+        OutData.Append(reinterpret_cast<const uint8*>(Converter.Get()), Converter.Length());
+    };
+
+    const FBytecodeChunk& Code = *Chunk;
+
+    WriteInt32(MODULE_OBJECT_MAGIC);
+    WriteInt32(MODULE_OBJECT_VERSION);
+    WriteString(Path);
+
+    WriteInt32(Imports.Num());
+    for (const FString& Import : Imports)
+    {
+        WriteString(Import);
+    }
+
+    WriteInt32(Exports.Num());
+    for (const FScriptModuleExport& Export : Exports)
+    {
+        WriteString(Export.Name);
+        WriteInt32(Export.Arity);
+        OutData.Add(static_cast<uint8>(Export.ReturnType));
+    }
+
+    WriteInt32(Code.Code.Num());
+    OutData.Append(Code.Code);
+
+    // Line table is kept: the linked chunk reports errors in module code by file and line
+    if (Code.LineTable.Num() == Code.Code.Num())
+    {
+        Code.LineTable.SerializeTo(OutData);
+    }
+    else
+    {
+        FLineTable().SerializeTo(OutData);
+    }
+
+    WriteInt32(Code.Constants.Num());
+    for (const FScriptValue& Constant : Code.Constants)
+    {
+        Constant.SerializeTo(OutData);
+    }
+
+    WriteInt32(Code.Functions.Num());
+    for (const FFunctionInfo& Func : Code.Functions)
+    {
+        WriteString(Func.Name);
+        WriteInt32(Func.Address);
+        WriteInt32(Func.Arity);
+        WriteInt32(Func.RegisterAddress);
+        WriteInt32(Func.NumRegisters);
+        WriteString(Func.Module);
+    }
+
+    WriteInt32(Code.RegisterCode.Num());
+    OutData.Append(Code.RegisterCode);
+}
+
+bool FScriptModule::Deserialize(const TArray<uint8>& InData, FString& OutError)
+{
+    int32 Offset = 0;
+    bool bValid = true;
+
+    auto ReadInt32 = [&InData, &Offset, &bValid]() -> int32 {
+        if (Offset + 4 > InData.Num())
+        {
+            bValid = false;
+            return 0;
+        }
+        int32 Value = 0;
+        for (int32 i = 0; i < 4; ++i)
+        {
+            Value |= static_cast<int32>(InData[Offset++]) << (i * 8);
+        }
+        return Value;
+    };
+
+    // Counts are bounded by the bytes left, so a corrupt file cannot ask for a huge allocation
+    auto ReadCount = [&InData, &Offset, &bValid, &ReadInt32]() -> int32 {
+        const int32 Count = ReadInt32();
+        if (Count < 0 || Count > InData.Num() - Offset)
+        {
+            bValid = false;
+            return 0;
+        }
+        return Count;
+    };
+
+    auto ReadString = [&InData, &Offset, &ReadCount]() -> FString {
+        const int32 Length = ReadCount();
+        TArray<ANSICHAR> UTF8Data;
+        UTF8Data.SetNum(Length + 1);
+        for (int32 i = 0; i < Length; ++i)
+        {
+            UTF8Data[i] = InData[Offset++];
+        }
+        UTF8Data[Length] = 0;
+        return FString(UTF8_TO_TCHAR(UTF8Data.GetData()));
+    };
+
+    auto ReadBytes = [&InData, &Offset, &ReadCount](TArray<uint8>& Out) {
+        const int32 Count = ReadCount();
+        Out.Empty();
+        if (Count > 0)
+        {
+            Out.Append(&InData[Offset], Count);
+            Offset += Count;
+        }
+    };
+
+    if ((uint32)ReadInt32() != MODULE_OBJECT_MAGIC)
+    {
+        OutError = TEXT("Not a module object");
+        return false;
+    }
+    const int32 FileVersion = ReadInt32();
+    if (FileVersion != MODULE_OBJECT_VERSION && FileVersion != 1)
+    {
+        OutError = FString::Printf(TEXT("Unsupported module object version %d"), FileVersion);
+        return false;
+    }
+
+    Path = ReadString();
+    Program.Reset();
+    Chunk = MakeShared<FBytecodeChunk>();
+
+    Imports.Empty();
+    const int32 NumImports = ReadCount();
+    for (int32 i = 0; i < NumImports && bValid; ++i)
+    {
+        Imports.Add(ReadString());
+    }
+
+    Exports.Empty();
+    const int32 NumExports = ReadCount();
+    for (int32 i = 0; i < NumExports && bValid; ++i)
+    {
+        FScriptModuleExport Export;
+        Export.Name = ReadString();
+        Export.Arity = ReadInt32();
+        Export.ReturnType = Offset < InData.Num() ? static_cast<EScriptType>(InData[Offset++]) : EScriptType::VOID;
+        Exports.Add(Export);
+    }
+
+    ReadBytes(Chunk->Code);
+
+    if (FileVersion == 1)
+    {
+        // Per-byte records: folded into runs as they are read, columns (never set) dropped
+        const int32 NumDebugInfo = ReadCount();
+        for (int32 i = 0; i < NumDebugInfo && bValid; ++i)
+        {
+            const int32 Line = ReadInt32();
+            ReadInt32();
+            Chunk->LineTable.Add(Line, ReadString());
+        }
+    }
+    else if (bValid && !Chunk->LineTable.DeserializeFrom(InData, Offset))
+    {
+        bValid = false;
+    }
+
+    const int32 NumConstants = ReadCount();
+    for (int32 i = 0; i < NumConstants && bValid; ++i)
+    {
+        FScriptValue Constant;
+        bValid = Constant.DeserializeFrom(InData, Offset);
+        Chunk->Constants.Add(Constant);
+    }
+
+    const int32 NumFunctions = ReadCount();
+    for (int32 i = 0; i < NumFunctions && bValid; ++i)
+    {
+        FFunctionInfo Func;
+        Func.Name = ReadString();
+        Func.Address = ReadInt32();
+        Func.Arity = ReadInt32();
+        Func.RegisterAddress = ReadInt32();
+        Func.NumRegisters = ReadInt32();
+        Func.Module = ReadString();
+        Chunk->Functions.Add(Func);
+    }
+
+    ReadBytes(Chunk->RegisterCode);
+
+    if (!bValid || Offset != InData.Num())
+    {
+        OutError = TEXT("Truncated or corrupt module object");
+        return false;
+    }
+    if (Chunk->LineTable.Num() > 0 && Chunk->LineTable.Num() != Chunk->Code.Num())
+    {
+        OutError = TEXT("Module object debug info does not match its code");
+        return false;
+    }
+    return true;
+}
+
+//=============================================================================
+// FScriptModuleCache
+//=============================================================================
+
+FScriptModuleCache::FScriptModuleCache()
+    : ScriptsDir(FPaths::Combine(FPaths::ProjectDir(), TEXT("Scripts")))
+    , bInliningEnabled(true)
+    , bOptimizationEnabled(false)
+    , bRegisterCodeEnabled(false)
+    , NumCompiled(0)
+    , NumLoaded(0)
+    , NumReused(0)
+{
+}
+
+FString FScriptModuleCache::GetSourcePath(const FString& ModulePath) const
+{
+    FString FullPath = FPaths::Combine(ScriptsDir, ModulePath);
+    FPaths::NormalizeFilename(FullPath);
+    return FullPath;
+}
+
+TSharedPtr<const FScriptModule> FScriptModuleCache::GetOrCompile(const FString& ModulePath, TArray<FString>& OutErrors)
+{
+    FScopeLock ScopeLock(&Lock);
+    if (const TSharedPtr<const FScriptModule>* Found = Modules.Find(ModulePath))
+    {
+        NumReused++;
+        return *Found;
+    }
+    if (InProgress.Contains(ModulePath))
+    {
+        SCRIPT_LOG(FString::Printf(TEXT("  Circular import of module %s (skipping)"), *ModulePath));
+        return nullptr;
+    }
+
+    const FString SourcePath = GetSourcePath(ModulePath);
+    if (!FPaths::FileExists(SourcePath))
+    {
+        OutErrors.Add(FString::Printf(TEXT("Import file not found: %s"), *SourcePath));
+        return nullptr;
+    }
+
+    FString Source;
+    if (!FFileHelper::LoadFileToString(Source, *SourcePath))
+    {
+        OutErrors.Add(FString::Printf(TEXT("Failed to read import file: %s"), *SourcePath));
+        return nullptr;
+    }
+
+    // An artifact that still matches skips the whole front end
+    if (!ArtifactDir.IsEmpty())
+    {
+        if (TSharedPtr<FScriptModule> Cached = LoadArtifact(ModulePath, Source))
+        {
+            SCRIPT_LOG(FString::Printf(TEXT("  Loaded module %s from its artifact"), *ModulePath));
+            NumLoaded++;
+            Modules.Add(ModulePath, Cached);
+            return Cached;
+        }
+    }
+
+    FScriptLexer Lexer(Source);
+    FScriptParser Parser(Lexer);
+    TSharedPtr<FScriptProgram> Program = Parser.Parse();
+    if (Parser.HasErrors() || !Program.IsValid())
+    {
+        OutErrors.Add(FString::Printf(TEXT("Parse errors in import file: %s"), *ModulePath));
+        for (const FString& Error : Parser.GetErrors())
+        {
+            OutErrors.Add(FString::Printf(TEXT("  %s"), *Error));
+        }
+        return nullptr;
+    }
+
+    // The module's own imports come back through this cache
+    FScriptCompiler Compiler;
+    Compiler.SetModuleCache(this);
+    Compiler.SetInliningEnabled(bInliningEnabled);
+    Compiler.SetOptimizationEnabled(bOptimizationEnabled);
+    Compiler.SetRegisterCodeEnabled(bRegisterCodeEnabled);
+
+    InProgress.Add(ModulePath);
+    TSharedPtr<FScriptModule> Module = Compiler.CompileModule(Program, ModulePath);
+    InProgress.Remove(ModulePath);
+
+    if (!Module.IsValid())
+    {
+        OutErrors.Add(FString::Printf(TEXT("Compile errors in module: %s"), *ModulePath));
+        for (const FString& Error : Compiler.GetErrors())
+        {
+            OutErrors.Add(FString::Printf(TEXT("  %s"), *Error));
+        }
+        return nullptr;
+    }
+
+    NumCompiled++;
+    Modules.Add(ModulePath, Module);
+    if (!ArtifactDir.IsEmpty())
+    {
+        SaveArtifact(*Module, Source);
+    }
+    return Module;
+}
+
+TSharedPtr<const FScriptModule> FScriptModuleCache::Find(const FString& ModulePath) const
+{
+    FScopeLock ScopeLock(&Lock);
+    const TSharedPtr<const FScriptModule>* Found = Modules.Find(ModulePath);
+    return Found ? *Found : nullptr;
+}
+
+void FScriptModuleCache::Add(TSharedPtr<const FScriptModule> Module)
+{
+    FScopeLock ScopeLock(&Lock);
+    if (Module.IsValid())
+    {
+        Modules.Add(Module->Path, Module);
+    }
+}
+
+bool FScriptModuleCache::LoadObject(const FString& ModulePath, const FString& FileName, FString& OutError)
+{
+    TArray<uint8> Data;
+    if (!FFileHelper::LoadFileToArray(Data, *FileName))
+    {
+        OutError = FString::Printf(TEXT("Failed to read module object: %s"), *FileName);
+        return false;
+    }
+
+    TSharedPtr<FScriptModule> Module = MakeShared<FScriptModule>();
+    if (!Module->Deserialize(Data, OutError))
+    {
+        OutError = FString::Printf(TEXT("%s: %s"), *FileName, *OutError);
+        return false;
+    }
+    // A renamed or stale object would be filed under a path nobody asked for
+    if (Module->Path != ModulePath)
+    {
+        OutError = FString::Printf(TEXT("%s: holds module %s, expected %s"), *FileName, *Module->Path, *ModulePath);
+        return false;
+    }
+
+    Add(Module);
+    return true;
+}
+
+bool FScriptModuleCache::SaveObject(const FString& ModulePath, const FString& FileName) const
+{
+    TSharedPtr<const FScriptModule> Module = Find(ModulePath);
+    if (!Module.IsValid())
+    {
+        return false;
+    }
+
+    TArray<uint8> Data;
+    Module->Serialize(Data);
+    return FFileHelper::SaveArrayToFile(Data, *FileName);
+}
+
+static FString FlattenModulePath(const FString& ModulePath)
+{
+    FString FileName;
+    for (int32 i = 0; i < ModulePath.Len(); ++i)
+    {
+        const TCHAR Char = ModulePath[i];
+        FileName.AppendChar((Char == '/' || Char == '\\' || Char == ':') ? '_' : Char);
+    }
+    return FileName;
+}
+
+FString FScriptModuleCache::GetObjectFileName(const FString& ModulePath)
+{
+    return FlattenModulePath(ModulePath) + TEXT(".sbo");
+}
+
+FString FScriptModuleCache::GetArtifactFileName(const FString& ModulePath)
+{
+    return FlattenModulePath(ModulePath) + TEXT(".sbh");
+}
+
+bool FScriptModuleCache::ComputeArtifactKey(const FString& Source, const TArray<FString>& ModuleImports, uint64& OutKey) const
+{
+    // FNV-1a over everything the module's code depends on
+    uint64 Key = 14695981039346656037ull;
+    auto Mix = [&Key](uint64 Value)
+    {
+        Key = (Key ^ Value) * 1099511628211ull;
+    };
+
+    Mix(HEADER_ARTIFACT_VERSION);
+    Mix(MODULE_OBJECT_VERSION);
+    Mix((bInliningEnabled ? 1 : 0) | (bOptimizationEnabled ? 2 : 0) | (bRegisterCodeEnabled ? 4 : 0));
+    Mix(Source.Len());
+    for (int32 i = 0; i < Source.Len(); ++i)
+    {
+        Mix(static_cast<uint64>(Source[i]));
+    }
+
+    // Through the imports' keys, a change anywhere below reaches this key too
+    Mix(ModuleImports.Num());
+    for (const FString& Import : ModuleImports)
+    {
+        const uint64* ImportKey = ArtifactKeys.Find(Import);
+        if (!ImportKey)
+        {
+            return false;
+        }
+        Mix(*ImportKey);
+    }
+
+    OutKey = Key;
+    return true;
+}
+
+TSharedPtr<FScriptModule> FScriptModuleCache::LoadArtifact(const FString& ModulePath, const FString& Source)
+{
+    TArray<uint8> Data;
+    const FString FileName = FPaths::Combine(ArtifactDir, GetArtifactFileName(ModulePath));
+    if (!FPaths::FileExists(FileName) || !FFileHelper::LoadFileToArray(Data, *FileName) || Data.Num() < 16)
+    {
+        return nullptr;
+    }
+
+    auto ReadUInt32 = [&Data](int32 Offset) -> uint32 {
+        uint32 Value = 0;
+        for (int32 i = 0; i < 4; ++i)
+        {
+            Value |= static_cast<uint32>(Data[Offset + i]) << (i * 8);
+        }
+        return Value;
+    };
+    if (ReadUInt32(0) != HEADER_ARTIFACT_MAGIC || (int32)ReadUInt32(4) != HEADER_ARTIFACT_VERSION)
+    {
+        return nullptr;
+    }
+    const uint64 StoredKey = static_cast<uint64>(ReadUInt32(8)) | (static_cast<uint64>(ReadUInt32(12)) << 32);
+
+    TArray<uint8> ObjectData;
+    ObjectData.Append(Data.GetData() + 16, Data.Num() - 16);
+    TSharedPtr<FScriptModule> Module = MakeShared<FScriptModule>();
+    FString Error;
+    if (!Module->Deserialize(ObjectData, Error) || Module->Path != ModulePath)
+    {
+        SCRIPT_LOG(FString::Printf(TEXT("  Ignoring artifact %s: %s"), *FileName, Error.IsEmpty() ? TEXT("wrong module") : *Error));
+        return nullptr;
+    }
+
+    // The imports' keys first: each is checked (or recompiled) the same way
+    InProgress.Add(ModulePath);
+    bool bImportsReady = true;
+    for (const FString& Import : Module->Imports)
+    {
+        TArray<FString> ImportErrors;
+        if (!GetOrCompile(Import, ImportErrors).IsValid())
+        {
+            bImportsReady = false;
+            break;
+        }
+    }
+    InProgress.Remove(ModulePath);
+
+    uint64 Key = 0;
+    if (!bImportsReady || !ComputeArtifactKey(Source, Module->Imports, Key) || Key != StoredKey)
+    {
+        SCRIPT_LOG(FString::Printf(TEXT("  Artifact of %s is stale"), *ModulePath));
+        return nullptr;
+    }
+
+    ArtifactKeys.Add(ModulePath, Key);
+    return Module;
+}
+
+void FScriptModuleCache::SaveArtifact(const FScriptModule& Module, const FString& Source)
+{
+    uint64 Key = 0;
+    if (!ComputeArtifactKey(Source, Module.Imports, Key))
+    {
+        // An import without a key: part of an import cycle, or loaded as a plain object
+        return;
+    }
+    ArtifactKeys.Add(Module.Path, Key);
+
+    TArray<uint8> Data;
+    auto WriteUInt32 = [&Data](uint32 Value) {
+        for (int32 i = 0; i < 4; ++i)
+        {
+            Data.Add((Value >> (i * 8)) & 0xFF);
+        }
+    };
+    WriteUInt32(HEADER_ARTIFACT_MAGIC);
+    WriteUInt32(HEADER_ARTIFACT_VERSION);
+    WriteUInt32(static_cast<uint32>(Key));
+    WriteUInt32(static_cast<uint32>(Key >> 32));
+    Module.Serialize(Data);
+
+    const FString FileName = FPaths::Combine(ArtifactDir, GetArtifactFileName(Module.Path));
+    if (!FFileHelper::SaveArrayToFile(Data, *FileName))
+    {
+        SCRIPT_LOG_ERROR(FString::Printf(TEXT("Failed to write header artifact: %s"), *FileName));
+    }
+}
+
+//=============================================================================
+// FScriptLinker
+//=============================================================================
+
+namespace
+{
+    int32 ReadOperand(const TArray<uint8>& Code, int32 Offset, int32 Bytes)
+    {
+        int32 Value = 0;
+        for (int32 i = 0; i < Bytes; ++i)
+        {
+            Value = (Value << 8) | Code[Offset + i];
+        }
+        return Value;
+    }
+
+    void WriteOperand(TArray<uint8>& Code, int32 Offset, int32 Bytes, int32 Value)
+    {
+        for (int32 i = Bytes - 1; i >= 0; --i)
+        {
+            Code[Offset + i] = (uint8)(Value & 0xFF);
+            Value >>= 8;
+        }
+    }
+
+    /** Renumbers the operands of one module's code after it is appended to the linked chunk */
+    struct FRelocation
+    {
+        const FString& Module;
+        const TArray<int32>& ConstantMap;   // Module constant -> linked constant
+        int32 FunctionBase;                 // Linked index of the module's first function entry
+        TArray<FString>& Errors;
+
+        bool Remap(TArray<uint8>& Code, int32 Offset, int32 Bytes, bool bFunction)
+        {
+            const int32 Index = ReadOperand(Code, Offset, Bytes);
+            int32 Linked = INDEX_NONE;
+            if (bFunction)
+            {
+                Linked = FunctionBase + Index;
+            }
+            else if (ConstantMap.IsValidIndex(Index))
+            {
+                Linked = ConstantMap[Index];
+            }
+            if (Linked < 0)
+            {
+                Errors.Add(FString::Printf(TEXT("%s: operand %d at %d is out of range"), *Module, Index, Offset));
+                return false;
+            }
+            if (Linked >= (1 << (Bytes * 8)))
+            {
+                Errors.Add(FString::Printf(TEXT("%s: %s %d does not fit its %d-byte operand once linked"),
+                    *Module, bFunction ? TEXT("function") : TEXT("constant"), Linked, Bytes));
+                return false;
+            }
+            WriteOperand(Code, Offset, Bytes, Linked);
+            return true;
+        }
+
+        bool RelocateStackCode(TArray<uint8>& Code, int32 Start)
+        {
+            for (int32 Offset = Start; Offset < Code.Num();)
+            {
+                const int32 Size = FScriptBytecodeVerifier::GetInstructionSize(Code, Offset);
+                if (Size <= 0)
+                {
+                    Errors.Add(FString::Printf(TEXT("%s: malformed instruction at %d"), *Module, Offset - Start));
+                    return false;
+                }
+
+                bool bOk = true;
+                switch ((EOpCode)Code[Offset])
+                {
+                    // Compact constant operands: only the SSA path's folded constants can land here
+                    case EOpCode::OP_CONSTANT:
+                    case EOpCode::OP_DEFINE_GLOBAL:
+                    case EOpCode::OP_GET_GLOBAL:
+                    case EOpCode::OP_SET_GLOBAL:
+                        bOk = Remap(Code, Offset + 1, 1, false);
+                        break;
+                    case EOpCode::OP_CONSTANT_WIDE:
+                    case EOpCode::OP_DEFINE_GLOBAL_WIDE:
+                    case EOpCode::OP_GET_GLOBAL_WIDE:
+                    case EOpCode::OP_SET_GLOBAL_WIDE:
+                        bOk = Remap(Code, Offset + 1, 3, false);
+                        break;
+                    case EOpCode::OP_CALL_NATIVE:
+                        bOk = Remap(Code, Offset + 2, 2, false);
+                        break;
+                    case EOpCode::OP_GET_FIELD:
+                    case EOpCode::OP_SET_FIELD:
+                    case EOpCode::OP_SWITCH_LOOKUP:
+                        bOk = Remap(Code, Offset + 1, 2, false);
+                        break;
+                    case EOpCode::OP_CALL:
+                    case EOpCode::OP_TAIL_CALL:
+                        bOk = Remap(Code, Offset + 2, 2, true);
+                        break;
+                    default:
+                        break;
+                }
+                if (!bOk)
+                {
+                    return false;
+                }
+                Offset += Size;
+            }
+            return true;
+        }
+
+        bool RelocateRegisterCode(TArray<uint8>& Code, int32 Start)
+        {
+            for (int32 Offset = Start; Offset < Code.Num();)
+            {
+                const int32 Size = GetRegisterInstructionSize(Code, Offset, Code.Num());
+                if (Size <= 0)
+                {
+                    Errors.Add(FString::Printf(TEXT("%s: malformed register instruction at %d"), *Module, Offset - Start));
+                    return false;
+                }
+
+                int32 Operand = Offset + 1;
+                for (const TCHAR* Kind = GetRegisterOperands((ERegOpCode)Code[Offset]); *Kind; ++Kind)
+                {
+                    if (*Kind == 'N')
+                    {
+                        Operand += 1 + Code[Operand];
+                    }
+                    else if (*Kind == 'K' || *Kind == 'F')
+                    {
+                        if (!Remap(Code, Operand, 2, *Kind == 'F'))
+                        {
+                            return false;
+                        }
+                        Operand += 2;
+                    }
+                    else
+                    {
+                        Operand += (*Kind == 'J') ? 2 : 1;
+                    }
+                }
+                Offset += Size;
+            }
+            return true;
+        }
+    };
+}
+
+TSharedPtr<FBytecodeChunk> FScriptLinker::Link(const FBytecodeChunk& Root, const FScriptModuleCache& Modules, TArray<FString>& OutErrors)
+{
+    const int32 NumErrors = OutErrors.Num();
+
+    // The modules the root needs, following external entries through the modules themselves
+    TArray<TSharedPtr<const FScriptModule>> Linked;
+    TMap<FString, int32> LinkedIndex;
+    auto Require = [&](const FBytecodeChunk& Code, const FString& From) {
+        for (const FFunctionInfo& Func : Code.Functions)
+        {
+            if (Func.Module.IsEmpty() || LinkedIndex.Contains(Func.Module))
+            {
+                continue;
+            }
+            TSharedPtr<const FScriptModule> Module = Modules.Find(Func.Module);
+            if (!Module.IsValid() || !Module->Chunk.IsValid())
+            {
+                OutErrors.Add(FString::Printf(TEXT("%s: module '%s' (for '%s') is not available"), *From, *Func.Module, *Func.Name));
+                continue;
+            }
+            LinkedIndex.Add(Func.Module, Linked.Num());
+            Linked.Add(Module);
+        }
+    };
+    Require(Root, TEXT("script"));
+    for (int32 i = 0; i < Linked.Num(); ++i)
+    {
+        Require(*Linked[i]->Chunk, Linked[i]->Path);
+    }
+    if (OutErrors.Num() > NumErrors)
+    {
+        return nullptr;
+    }
+
+    TSharedPtr<FBytecodeChunk> Out = MakeShared<FBytecodeChunk>(Root);
+    const bool bLineTable = Out->LineTable.Num() == Out->Code.Num();
+
+    // Top-level code ends by running off the end of the chunk: jump over the module code
+    // (patched once it is in), which the root's jumps to its own end now land on
+    Out->Code.Add((uint8)EOpCode::OP_JUMP_WIDE);
+    const int32 EndJump = Out->Code.Num();
+    for (int32 i = 0; i < 4; ++i)
+    {
+        Out->Code.Add(0);
+    }
+    if (bLineTable)
+    {
+        Out->LineTable.Add(0, FString(), 5);
+    }
+
+    // Root constants keep their indices; module constants are merged into them
+    Out->ConstantIndex = MakeShared<FConstantPoolIndex>();
+    Out->Constants.Empty();
+    for (const FScriptValue& Constant : Root.Constants)
+    {
+        Out->Constants.Add(Constant);
+        Out->ConstantIndex->Add(Out->Constants);
+    }
+
+    TArray<int32> FunctionBase;
+    for (const TSharedPtr<const FScriptModule>& Module : Linked)
+    {
+        const FBytecodeChunk& Code = *Module->Chunk;
+        const int32 CodeBase = Out->Code.Num();
+        const int32 RegisterBase = Out->RegisterCode.Num();
+        FunctionBase.Add(Out->Functions.Num());
+
+        TArray<int32> ConstantMap;
+        for (const FScriptValue& Constant : Code.Constants)
+        {
+            ConstantMap.Add(Out->AddConstant(Constant));
+        }
+
+        Out->Code.Append(Code.Code);
+        if (bLineTable)
+        {
+            if (Code.LineTable.Num() == Code.Code.Num())
+            {
+                Out->LineTable.Append(Code.LineTable);
+            }
+            else
+            {
+                Out->LineTable.Add(0, Module->Path, Code.Code.Num());
+            }
+        }
+        Out->RegisterCode.Append(Code.RegisterCode);
+
+        for (FFunctionInfo Func : Code.Functions)
+        {
+            if (Func.Module.IsEmpty())
+            {
+                Func.Address += CodeBase;
+                if (Func.RegisterAddress != INDEX_NONE)
+                {
+                    Func.RegisterAddress += RegisterBase;
+                }
+            }
+            Out->Functions.Add(Func);
+        }
+
+        FRelocation Relocation{ Module->Path, ConstantMap, FunctionBase.Last(), OutErrors };
+        if (!Relocation.RelocateStackCode(Out->Code, CodeBase) ||
+            !Relocation.RelocateRegisterCode(Out->RegisterCode, RegisterBase))
+        {
+            return nullptr;
+        }
+    }
+    Out->ConstantIndex.Reset();
+    WriteOperand(Out->Code, EndJump, 4, Out->Code.Num() - EndJump - 4);
+
+    if (Out->Functions.Num() > 0x10000)
+    {
+        OutErrors.Add(FString::Printf(TEXT("Too many functions once linked (%d, max %d)"), Out->Functions.Num(), 0x10000));
+        return nullptr;
+    }
+
+    // Point every external entry at the definition: a copy, so call operands stay as they are
+    for (FFunctionInfo& Func : Out->Functions)
+    {
+        if (Func.Module.IsEmpty())
+        {
+            continue;
+        }
+
+        const int32 ModuleIndex = LinkedIndex[Func.Module];
+        const FBytecodeChunk& Code = *Linked[ModuleIndex]->Chunk;
+        int32 Definition = INDEX_NONE;
+        for (int32 i = 0; i < Code.Functions.Num(); ++i)
+        {
+            if (Code.Functions[i].Name == Func.Name && Code.Functions[i].Module.IsEmpty())
+            {
+                Definition = FunctionBase[ModuleIndex] + i;
+                break;
+            }
+        }
+
+        if (Definition == INDEX_NONE)
+        {
+            OutErrors.Add(FString::Printf(TEXT("Unresolved function '%s' (expected in %s)"), *Func.Name, *Func.Module));
+            continue;
+        }
+        const FFunctionInfo& Target = Out->Functions[Definition];
+        if (Target.Arity != Func.Arity)
+        {
+            OutErrors.Add(FString::Printf(TEXT("Function '%s' in %s takes %d argument(s), it was called with %d (module out of date?)"),
+                *Func.Name, *Func.Module, Target.Arity, Func.Arity));
+            continue;
+        }
+        Func = Target;
+    }
+    if (OutErrors.Num() > NumErrors)
+    {
+        return nullptr;
+    }
+
+    Out->Signature = Out->GenerateSignature();
+
+    SCRIPT_LOG(FString::Printf(TEXT("Linked %d module(s): %d bytes of code, %d constants, %d functions"),
+        Linked.Num(), Out->Code.Num(), Out->Constants.Num(), Out->Functions.Num()));
+    return Out;
+}
@@ -5,6 +5,7 @@
 #include "ScriptLexer.h"
 #include "ScriptParser.h"
 #include "ScriptCompiler.h"
+#include "ScriptBytecodeFile.h"
 #include "ScriptLogger.h"
 // #include "ScriptNativeAPI.h"
 #include "Misc/FileHelper.h"
@@ -38,6 +39,10 @@ void UScriptManager::Initialize(FSubsystemCollectionBase& Collection)
 	SCRIPT_LOG(FString::Printf(TEXT("Scripts Folder: %s"), *ScriptsFolder));
 	SCRIPT_LOG(FString::Printf(TEXT("Cache Folder: %s"), *CacheFolder));
 	
+	// The module's startup build has written the database by now; from here on this
+	// manager is its only writer, so one read serves every load
+	CompileDB.Load(GetCompileDatabasePath());
+	
 	// Startup logic: Ensure Main.sc is the root entry point
 	// The module might have loaded startup scripts, but we ensure Main is handled here
 	if (LoadScript(TEXT("Main.sc")).IsEmpty())
@@ -85,34 +90,37 @@ FString UScriptManager::LoadScript(const FString& ScriptPath, bool bForceRecompi
 	SCRIPT_LOG(FString::Printf(TEXT("Loading script: %s from %s"), *ScriptName, *FullPath));
 	
 	// PRIORITY 1: Check for compiled bytecode (.scc) in Scripts/Compiled/
-	// This is the PRIMARY way to run scripts - compiled bytecode always wins!
+	// This is the PRIMARY way to run scripts - compiled bytecode wins while it is up to date
+	// with the source, and always when there is no source (mod distribution)
 	FString CompiledPath = FPaths::ProjectDir() / TEXT("Scripts/Compiled") / ScriptName + TEXT(".scc");
 	TSharedPtr<FBytecodeChunk> Bytecode;
 	
-	if (!bForceRecompile && FPaths::FileExists(CompiledPath))
+	// Imports are hashed afresh for each load from source: a header edited since another
+	// script's load hashed it must not pass for unchanged
+	const bool bHasSource = FPaths::FileExists(FullPath) && FPaths::GetExtension(FullPath) != TEXT("scc");
+	if (bHasSource)
+	{
+		CompileDB.RescanFiles();
+	}
+	if (!bForceRecompile && FPaths::FileExists(CompiledPath) && bHasSource && !IsCacheValid(FullPath))
+	{
+		SCRIPT_LOG(FString::Printf(TEXT("Compiled bytecode is out of date: %s"), *CompiledPath));
+	}
+	else if (!bForceRecompile && FPaths::FileExists(CompiledPath))
 	{
 		SCRIPT_LOG(FString::Printf(TEXT("Found compiled bytecode: %s"), *CompiledPath));
 		SCRIPT_LOG(TEXT("Loading compiled bytecode directly (source ignored)..."));
 		
-		// Load compiled bytecode directly
-		Bytecode = MakeShared<FBytecodeChunk>();
-		TArray<uint8> BytecodeData;
-		if (FFileHelper::LoadFileToArray(BytecodeData, *CompiledPath))
+		// Load compiled bytecode directly (mapped, for v3 files)
+		FString LoadError;
+		Bytecode = FScriptBytecodeFile::LoadChunk(CompiledPath, LoadError);
+		if (Bytecode.IsValid())
 		{
-			if (Bytecode->Deserialize(BytecodeData))
-			{
-				SCRIPT_LOG(FString::Printf(TEXT("Successfully loaded compiled bytecode (%d bytes)"), BytecodeData.Num()));
-			}
-			else
-			{
-				SCRIPT_LOG_ERROR(TEXT("Failed to deserialize compiled bytecode"));
-				Bytecode.Reset();
-			}
+			SCRIPT_LOG(FString::Printf(TEXT("Successfully loaded compiled bytecode (%d bytes of code)"), Bytecode->Code.Num()));
 		}
 		else
 		{
-			SCRIPT_LOG_ERROR(FString::Printf(TEXT("Failed to load compiled bytecode file: %s"), *CompiledPath));
-			Bytecode.Reset();
+			SCRIPT_LOG_ERROR(FString::Printf(TEXT("Failed to load compiled bytecode: %s"), *LoadError));
 		}
 	}
 	
@@ -140,7 +148,8 @@ FString UScriptManager::LoadScript(const FString& ScriptPath, bool bForceRecompi
 		
 		// Compile source
 		TArray<FString> Errors;
-		Bytecode = CompileScript(SourceCode, Errors);
+		TArray<FString> Imports;
+		Bytecode = CompileScript(SourceCode, Errors, &Imports);
 		
 		if (!Bytecode.IsValid())
 		{
@@ -169,14 +178,15 @@ FString UScriptManager::LoadScript(const FString& ScriptPath, bool bForceRecompi
 		}
 		
 		TArray<uint8> BytecodeData;
-		if (Bytecode->Serialize(BytecodeData, true))
+		FScriptBytecodeFile::Write(*Bytecode, BytecodeData);
+		if (FFileHelper::SaveArrayToFile(BytecodeData, *CompiledPath))
 		{
-			if (FFileHelper::SaveArrayToFile(BytecodeData, *CompiledPath))
-			{
-				float CompressionRatio = (float)BytecodeData.Num() / (float)SourceCode.Len();
-				SCRIPT_LOG(FString::Printf(TEXT("Saved compiled bytecode: %s (%d bytes, %.1f%% of source)"),
-					*CompiledPath, BytecodeData.Num(), CompressionRatio * 100.0f));
-			}
+			float CompressionRatio = (float)BytecodeData.Num() / (float)SourceCode.Len();
+			SCRIPT_LOG(FString::Printf(TEXT("Saved compiled bytecode: %s (%d bytes, %.1f%% of source)"),
+				*CompiledPath, BytecodeData.Num(), CompressionRatio * 100.0f));
+			
+			CompileDB.Record(ScriptName, SourceCode, Imports);
+			CompileDB.Save(GetCompileDatabasePath());
 		}
 	}
 	
@@ -184,12 +194,15 @@ FString UScriptManager::LoadScript(const FString& ScriptPath, bool bForceRecompi
 	FCompiledScript CompiledScript;
 	CompiledScript.SourcePath = FullPath;
 	CompiledScript.Bytecode = Bytecode;
+	CompiledScript.Program = CreateProgram(ScriptName, Bytecode);
 	CompiledScript.VM = MakeShared<FScriptVM>();
 	CompiledScript.LastModified = FDateTime::Now();
 	CompiledScript.bExecuted = false;
 	
-	// Initialize VM with native functions
-	InitializeVM(CompiledScript.VM);
+	if (!CompiledScript.Program.IsValid())
+	{
+		return TEXT("");
+	}
 	
 	// Store in loaded scripts map
 	LoadedScripts.Add(ScriptName, CompiledScript);
@@ -220,12 +233,15 @@ bool UScriptManager::LoadScriptFromString(const FString& ScriptName, const FStri
 	FCompiledScript CompiledScript;
 	CompiledScript.SourcePath = TEXT("<string>");
 	CompiledScript.Bytecode = Bytecode;
+	CompiledScript.Program = CreateProgram(ScriptName, Bytecode);
 	CompiledScript.VM = MakeShared<FScriptVM>();
 	CompiledScript.LastModified = FDateTime::Now();
 	CompiledScript.bExecuted = false;
 	
-	// Initialize VM with native functions
-	InitializeVM(CompiledScript.VM);
+	if (!CompiledScript.Program.IsValid())
+	{
+		return false;
+	}
 	
 	// Store in loaded scripts map
 	LoadedScripts.Add(ScriptName, CompiledScript);
@@ -261,23 +277,16 @@ FString UScriptManager::LoadCompiledBytecode(const FString& BytecodePath)
 		return TEXT("");
 	}
 	
-	// Load bytecode file
-	TArray<uint8> BytecodeData;
-	if (!FFileHelper::LoadFileToArray(BytecodeData, *FullPath))
-	{
-		SCRIPT_LOG_ERROR(FString::Printf(TEXT("Failed to load bytecode file: %s"), *FullPath));
-		return TEXT("");
-	}
-	
-	// Deserialize bytecode
-	TSharedPtr<FBytecodeChunk> Bytecode = MakeShared<FBytecodeChunk>();
-	if (!Bytecode->Deserialize(BytecodeData))
+	// Load bytecode file (mapped, for v3 files)
+	FString LoadError;
+	TSharedPtr<FBytecodeChunk> Bytecode = FScriptBytecodeFile::LoadChunk(FullPath, LoadError);
+	if (!Bytecode.IsValid())
 	{
-		SCRIPT_LOG_ERROR(FString::Printf(TEXT("Failed to deserialize bytecode: %s"), *FullPath));
+		SCRIPT_LOG_ERROR(FString::Printf(TEXT("Failed to load bytecode: %s"), *LoadError));
 		return TEXT("");
 	}
 	
-	SCRIPT_LOG(FString::Printf(TEXT("Successfully loaded compiled bytecode (%d bytes)"), BytecodeData.Num()));
+	SCRIPT_LOG(FString::Printf(TEXT("Successfully loaded compiled bytecode (%d bytes of code)"), Bytecode->Code.Num()));
 	SCRIPT_LOG(FString::Printf(TEXT("  Compiler: %s %s"), *Bytecode->Metadata.CompilerName, *Bytecode->Metadata.CompilerVersion));
 	SCRIPT_LOG(FString::Printf(TEXT("  Game: %s %s"), *Bytecode->Metadata.GameName, *Bytecode->Metadata.GameVersion));
 	SCRIPT_LOG(FString::Printf(TEXT("  Trusted: %s"), Bytecode->IsTrustedCompiler() ? TEXT("YES") : TEXT("NO")));
@@ -286,12 +295,15 @@ FString UScriptManager::LoadCompiledBytecode(const FString& BytecodePath)
 	FCompiledScript CompiledScript;
 	CompiledScript.SourcePath = FullPath;
 	CompiledScript.Bytecode = Bytecode;
+	CompiledScript.Program = CreateProgram(ScriptName, Bytecode);
 	CompiledScript.VM = MakeShared<FScriptVM>();
 	CompiledScript.LastModified = FDateTime::Now();
 	CompiledScript.bExecuted = false;
 	
-	// Initialize VM with native functions
-	InitializeVM(CompiledScript.VM);
+	if (!CompiledScript.Program.IsValid())
+	{
+		return TEXT("");
+	}
 	
 	// Store in loaded scripts map
 	LoadedScripts.Add(ScriptName, CompiledScript);
@@ -333,15 +345,8 @@ bool UScriptManager::ExecuteScript(const FString& ScriptName, bool bCallMain)
 	
 	SCRIPT_LOG(FString::Printf(TEXT("Executing script: %s"), *ScriptName));
 	
-	// Reset VM if already executed
-	if (Script->bExecuted)
-	{
-		Script->VM->Reset();
-		InitializeVM(Script->VM);
-	}
-	
-	// Execute bytecode
-	bool bSuccess = Script->VM->Execute(Script->Bytecode);
+	// Execute the shared program (Execute resets the instance if it already ran)
+	bool bSuccess = Script->VM->Execute(Script->Program);
 	
 	if (!bSuccess)
 	{
@@ -378,6 +383,40 @@ FString UScriptManager::CallScriptFunction(const FString& ScriptName, const FStr
 	return TEXT("");
 }
 
+TSharedPtr<FScriptVM> UScriptManager::SpawnScriptInstance(const FString& ScriptName, bool bCallMain)
+{
+	const FCompiledScript* Script = LoadedScripts.Find(ScriptName);
+	if (!Script || !Script->Program.IsValid())
+	{
+		SCRIPT_LOG_ERROR(FString::Printf(TEXT("Cannot spawn instance - script not loaded: %s"), *ScriptName));
+		return nullptr;
+	}
+	
+	TSharedPtr<FScriptVM> Instance = MakeShared<FScriptVM>();
+	if (!Instance->Execute(Script->Program))
+	{
+		SCRIPT_LOG_ERROR(FString::Printf(TEXT("Script instance failed: %s"), *ScriptName));
+		for (const FString& Error : Instance->GetErrors())
+		{
+			SCRIPT_LOG_ERROR(FString::Printf(TEXT("  %s"), *Error));
+		}
+		return nullptr;
+	}
+	
+	if (bCallMain && Instance->GetState() == EVMState::Finished)
+	{
+		Instance->CallMainIfExists();
+	}
+	
+	return Instance;
+}
+
+TSharedPtr<const FScriptProgramImage> UScriptManager::GetScriptProgram(const FString& ScriptName) const
+{
+	const FCompiledScript* Script = LoadedScripts.Find(ScriptName);
+	return Script ? Script->Program : nullptr;
+}
+
 void UScriptManager::StopScript(const FString& ScriptName)
 {
 	FCompiledScript* Script = LoadedScripts.Find(ScriptName);
@@ -433,6 +472,47 @@ TArray<FString> UScriptManager::GetScriptErrors(const FString& ScriptName) const
 	return TArray<FString>();
 }
 
+bool UScriptManager::SaveScriptSnapshot(const FString& ScriptName, TArray<uint8>& OutData) const
+{
+	const FCompiledScript* Script = LoadedScripts.Find(ScriptName);
+	if (!Script || !Script->VM.IsValid())
+	{
+		SCRIPT_LOG_WARNING(FString::Printf(TEXT("Cannot snapshot '%s': script not loaded"), *ScriptName));
+		return false;
+	}
+	
+	FVMSnapshot Snapshot;
+	if (!Script->VM->CaptureSnapshot(Snapshot))
+	{
+		return false;
+	}
+	return Snapshot.Serialize(OutData);
+}
+
+bool UScriptManager::RestoreScriptSnapshot(const FString& ScriptName, const TArray<uint8>& InData)
+{
+	FCompiledScript* Script = LoadedScripts.Find(ScriptName);
+	if (!Script || !Script->VM.IsValid())
+	{
+		SCRIPT_LOG_WARNING(FString::Printf(TEXT("Cannot restore '%s': script not loaded"), *ScriptName));
+		return false;
+	}
+	
+	FVMSnapshot Snapshot;
+	if (!Snapshot.Deserialize(InData))
+	{
+		SCRIPT_LOG_ERROR(FString::Printf(TEXT("Snapshot data for '%s' is corrupt"), *ScriptName));
+		return false;
+	}
+	
+	if (!Script->VM->RestoreSnapshot(Snapshot, Script->Program))
+	{
+		return false;
+	}
+	Script->bExecuted = true;
+	return true;
+}
+
 //=============================================================================
 // Bytecode Caching
 //=============================================================================
@@ -454,8 +534,8 @@ bool UScriptManager::SaveBytecodeCache(const FString& ScriptName, TSharedPtr<FBy
 	uint32 MagicNumber = 0x53424300; // "SBC\0"
 	Ar << MagicNumber;
 	
-	// Write version
-	uint32 Version = 1;
+	// Write version (1 kept a line number per byte of code, 2 a line table)
+	uint32 Version = 2;
 	Ar << Version;
 	
 	// Write bytecode
@@ -486,8 +566,10 @@ bool UScriptManager::SaveBytecodeCache(const FString& ScriptName, TSharedPtr<FBy
 		}
 	}
 	
-	// Write line numbers
-	Ar << Bytecode->LineNumbers;
+	// Write line table
+	TArray<uint8> LineTableData;
+	Bytecode->LineTable.SerializeTo(LineTableData);
+	Ar << LineTableData;
 	
 	// Write function table
 	int32 FunctionCount = Bytecode->Functions.Num();
@@ -537,7 +619,7 @@ TSharedPtr<FBytecodeChunk> UScriptManager::LoadBytecodeCache(const FString& Scri
 	// Read version
 	uint32 Version = 0;
 	Ar << Version;
-	if (Version != 1)
+	if (Version != 1 && Version != 2)
 	{
 		SCRIPT_LOG_WARNING(FString::Printf(TEXT("Incompatible bytecode cache version: %d"), Version));
 		return nullptr;
@@ -580,8 +662,29 @@ TSharedPtr<FBytecodeChunk> UScriptManager::LoadBytecodeCache(const FString& Scri
 		Bytecode->Constants.Add(Value);
 	}
 	
-	// Read line numbers
-	Ar << Bytecode->LineNumbers;
+	// Read line table, converting the per-byte line numbers of version 1
+	if (Version == 1)
+	{
+		TArray<int32> LineNumbers;
+		Ar << LineNumbers;
+		if (LineNumbers.Num() == Bytecode->Code.Num())
+		{
+			for (int32 Line : LineNumbers)
+			{
+				Bytecode->LineTable.Add(Line, FString());
+			}
+		}
+	}
+	else
+	{
+		TArray<uint8> LineTableData;
+		Ar << LineTableData;
+		int32 LineTableOffset = 0;
+		if (!Bytecode->LineTable.DeserializeFrom(LineTableData, LineTableOffset))
+		{
+			SCRIPT_LOG_WARNING(FString::Printf(TEXT("Ignoring corrupt line table in bytecode cache: %s"), *CachePath));
+		}
+	}
 	
 	// Read function table
 	int32 FunctionCount = 0;
@@ -605,19 +708,22 @@ TSharedPtr<FBytecodeChunk> UScriptManager::LoadBytecodeCache(const FString& Scri
 bool UScriptManager::IsCacheValid(const FString& ScriptPath) const
 {
 	FString ScriptName = FPaths::GetBaseFilename(ScriptPath);
-	FString CachePath = CacheFolder / ScriptName + TEXT(".scc");
+	FString CompiledPath = FPaths::ProjectDir() / TEXT("Scripts/Compiled") / ScriptName + TEXT(".scc");
 	
-	// Check if cache file exists
-	if (!FPaths::FileExists(CachePath))
+	// Check if compiled bytecode exists
+	if (!FPaths::FileExists(CompiledPath))
 	{
 		return false;
 	}
 	
-	// Check if source is newer than cache
-	FDateTime SourceTime = IFileManager::Get().GetTimeStamp(*ScriptPath);
-	FDateTime CacheTime = IFileManager::Get().GetTimeStamp(*CachePath);
-	
-	return CacheTime > SourceTime;
+	// Contents, not timestamps: a checkout that rewrites files unchanged keeps the bytecode,
+	// an edited header invalidates every script importing it
+	FString SourceCode;
+	if (!FFileHelper::LoadFileToString(SourceCode, *ScriptPath))
+	{
+		return false;
+	}
+	return CompileDB.IsUpToDate(ScriptName, SourceCode);
 }
 
 //=============================================================================
@@ -744,13 +850,14 @@ void UScriptManager::UnregisterConsoleCommands()
 // Internal Methods
 //=============================================================================
 
-TSharedPtr<FBytecodeChunk> UScriptManager::CompileScript(const FString& SourceCode, TArray<FString>& OutErrors)
+TSharedPtr<FBytecodeChunk> UScriptManager::CompileScript(const FString& SourceCode, TArray<FString>& OutErrors, TArray<FString>* OutImports)
 {
 	OutErrors.Empty();
 	
-	// Lexer
+	// Lexer and parser: tokens are scanned as the parser asks for them
 	FScriptLexer Lexer(SourceCode);
-	TArray<FScriptToken> Tokens = Lexer.ScanTokens();
+	FScriptParser Parser(Lexer);
+	TSharedPtr<FScriptProgram> Program = Parser.Parse();
 	
 	if (Lexer.HasErrors())
 	{
@@ -758,10 +865,6 @@ TSharedPtr<FBytecodeChunk> UScriptManager::CompileScript(const FString& SourceCo
 		return nullptr;
 	}
 	
-	// Parser
-	FScriptParser Parser(Tokens);
-	TSharedPtr<FScriptProgram> Program = Parser.Parse();
-	
 	if (Parser.HasErrors() || !Program.IsValid() || !Program->IsValid())
 	{
 		OutErrors.Append(Parser.GetErrors());
@@ -778,6 +881,10 @@ TSharedPtr<FBytecodeChunk> UScriptManager::CompileScript(const FString& SourceCo
 		return nullptr;
 	}
 	
+	if (OutImports)
+	{
+		*OutImports = Compiler.GetImportedSourceFiles();
+	}
 	return Bytecode;
 }
 
@@ -813,13 +920,22 @@ FString UScriptManager::GetCacheFilePath(const FString& ScriptPath) const
 	return CacheFolder / ScriptName + TEXT(".scc");
 }
 
-void UScriptManager::InitializeVM(TSharedPtr<FScriptVM> VM)
+FString UScriptManager::GetCompileDatabasePath() const
+{
+	return FPaths::ProjectDir() / TEXT("Scripts/Compiled") / FScriptCompileDatabase::GetDefaultFileName();
+}
+
+TSharedPtr<const FScriptProgramImage> UScriptManager::CreateProgram(const FString& ScriptName, TSharedPtr<FBytecodeChunk> Bytecode)
 {
-	if (!VM.IsValid())
+	TArray<FString> Errors;
+	TSharedPtr<const FScriptProgramImage> Program = FScriptProgramImage::Create(Bytecode, FScriptNativeRegistry::Get(), Errors);
+	if (!Program.IsValid())
 	{
-		return;
+		SCRIPT_LOG_ERROR(FString::Printf(TEXT("Failed to load script: %s"), *ScriptName));
+		for (const FString& Error : Errors)
+		{
+			SCRIPT_LOG_ERROR(FString::Printf(TEXT("  %s"), *Error));
+		}
 	}
-	
-	// Call the delegate to let the game module register its functions
-	OnRegisterNativeAPI.Broadcast(VM.Get());
+	return Program;
 }
\ No newline at end of file
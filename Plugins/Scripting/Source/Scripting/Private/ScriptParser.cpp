@@ -4,12 +4,22 @@
 #include "ScriptParser.h"
 #include "ScriptLogger.h"
 
-FScriptParser::FScriptParser(const TArray<FScriptToken>& InTokens)
-    : Tokens(InTokens), Current(0), bPanicMode(false)
-{}
+FScriptParser::FScriptParser(FScriptLexer& InLexer)
+    : Lexer(&InLexer), NextTokenIndex(0), Current(0), NumPulled(0), bPulledEnd(false), bPanicMode(false)
+{
+    PullToken();
+}
+
+FScriptParser::FScriptParser(TArray<FScriptToken> InTokens)
+    : Lexer(nullptr), Tokens(MoveTemp(InTokens)), NextTokenIndex(0), Current(0), NumPulled(0), bPulledEnd(false), bPanicMode(false)
+{
+    PullToken();
+}
 
 TSharedPtr<FScriptProgram> FScriptParser::Parse()
 {
+    Arena = MakeShared<FScriptASTArena>();
+    
     TArray<TSharedPtr<FFunctionDecl>> Functions;
     TArray<TSharedPtr<FScriptStatement>> Statements;
     
@@ -19,7 +29,7 @@ TSharedPtr<FScriptProgram> FScriptParser::Parse()
         if (Decl.IsValid())
         {
             // Check if it's a function declaration
-            if (Decl->GetNodeType() == TEXT("Function"))
+            if (Decl->GetKind() == EScriptNodeKind::Function)
             {
                 Functions.Add(StaticCastSharedPtr<FFunctionDecl>(Decl));
             }
@@ -30,43 +40,76 @@ TSharedPtr<FScriptProgram> FScriptParser::Parse()
         }
     }
     
-    return MakeShared<FScriptProgram>(Functions, Statements);
+    // Shares ownership of the arena: the tree lives as long as the program does
+    return TSharedPtr<FScriptProgram>(Arena, Arena->New<FScriptProgram>(Functions, Statements));
 }
 
 //=============================================================================
 // Utility Methods
 //=============================================================================
 
-FScriptToken FScriptParser::Peek() const
+void FScriptParser::PullToken()
 {
-    if (Current < Tokens.Num())
+    FScriptToken& Slot = Ring[NumPulled & (RingSize - 1)];
+    if (Lexer)
+    {
+        Slot = Lexer->NextToken();
+    }
+    else if (NextTokenIndex < Tokens.Num())
+    {
+        Slot = MoveTemp(Tokens[NextTokenIndex++]);
+    }
+    else
     {
-        return Tokens[Current];
+        // An array without its END_OF_FILE token
+        Slot = FScriptToken(ETokenType::END_OF_FILE, TEXT(""), 0, 0);
     }
-    return Tokens.Last(); // Return EOF
+    
+    bPulledEnd = Slot.Type == ETokenType::END_OF_FILE;
+    NumPulled++;
 }
 
-FScriptToken FScriptParser::Previous() const
+const FScriptToken& FScriptParser::Peek() const
 {
-    if (Current > 0 && Current - 1 < Tokens.Num())
+    // Advance() keeps the current token pulled
+    return Ring[Current & (RingSize - 1)];
+}
+
+const FScriptToken& FScriptParser::PeekAhead(int32 Distance)
+{
+    check(Distance >= 0 && Distance <= MaxLookahead);
+    
+    const int32 Position = Current + Distance;
+    while (NumPulled <= Position && !bPulledEnd)
     {
-        return Tokens[Current - 1];
+        PullToken();
     }
-    return Tokens.Num() > 0 ? Tokens[0] : FScriptToken();
+    
+    // Past the end every position reads END_OF_FILE
+    return Ring[FMath::Min(Position, NumPulled - 1) & (RingSize - 1)];
 }
 
-FScriptToken FScriptParser::Advance()
+const FScriptToken& FScriptParser::Previous() const
+{
+    return Ring[(Current > 0 ? Current - 1 : 0) & (RingSize - 1)];
+}
+
+const FScriptToken& FScriptParser::Advance()
 {
     if (!IsAtEnd())
     {
         Current++;
+        if (Current == NumPulled)
+        {
+            PullToken();
+        }
     }
     return Previous();
 }
 
 bool FScriptParser::IsAtEnd() const
 {
-    return Current >= Tokens.Num() || Peek().Type == ETokenType::END_OF_FILE;
+    return Peek().Type == ETokenType::END_OF_FILE;
 }
 
 bool FScriptParser::Check(ETokenType Type) const
@@ -100,7 +143,7 @@ TSharedPtr<FScriptExpression> FScriptParser::ParseArrayLiteral()
     if (Check(ETokenType::RIGHT_BRACKET))
     {
         Advance(); // Consume ']'
-        return MakeShared<FArrayLiteralExpr>(Elements);
+        return NewNode<FArrayLiteralExpr>(Elements);
     }
     
     // Parse first element
@@ -132,7 +175,7 @@ TSharedPtr<FScriptExpression> FScriptParser::ParseArrayLiteral()
         return nullptr;
     }
     
-    return MakeShared<FArrayLiteralExpr>(Elements);
+    return NewNode<FArrayLiteralExpr>(Elements);
 }
 
 TSharedPtr<FScriptExpression> FScriptParser::ParseArrayAccess()
@@ -152,7 +195,7 @@ TSharedPtr<FScriptExpression> FScriptParser::ParseArrayAccess()
                 return nullptr;
             }
             
-            Expr = MakeShared<FArrayAccessExpr>(Expr, Index);
+            Expr = NewNode<FArrayAccessExpr>(Expr, Index);
         }
         else if (Match(ETokenType::DOT))
         {
@@ -164,7 +207,7 @@ TSharedPtr<FScriptExpression> FScriptParser::ParseArrayAccess()
             }
             
             FScriptToken PropertyName = Advance();
-            Expr = MakeShared<FStructAccessExpr>(Expr, PropertyName);
+            Expr = NewNode<FStructAccessExpr>(Expr, PropertyName);
         }
         else
         {
@@ -204,7 +247,7 @@ void FScriptParser::ReportError(const FString& Message)
 {
     if (bPanicMode) return; // Don't spam errors
     
-    FScriptToken Token = Peek();
+    const FScriptToken& Token = Peek();
     FString ErrorMsg = FString::Printf(TEXT("[Line %d] Error at '%s': %s"),
         Token.Line, *Token.Lexeme, *Message);
     
@@ -267,7 +310,7 @@ TSharedPtr<FScriptASTNode> FScriptParser::ParseDeclaration()
         FScriptToken Path = Advance();
         Consume(ETokenType::SEMICOLON, TEXT("Expected ';' after import statement"));
         
-        return MakeShared<FImportStmt>(Path);
+        return NewNode<FImportStmt>(Path);
     }
     
     // Type declarations: int x = 10; float y; OR int Add(int a, int b) {}
@@ -280,51 +323,16 @@ TSharedPtr<FScriptASTNode> FScriptParser::ParseDeclaration()
     {
         EScriptType ReturnType = GetTypeFromToken(Previous());
         
-        // Look ahead to determine if this is a function or variable declaration
-        // We need to check for [] and identifier and (
-        // Function: type[] identifier ( ... OR type identifier ( ...
-        // Variable: type[] identifier = ... OR type identifier = ...
-        
-        int SavedCurrent = Current;
-        bool bHasArrayBrackets = false;
-        
-        // Check for optional []
-        if (Check(ETokenType::LEFT_BRACKET))
-        {
-            Advance(); // [
-            if (Check(ETokenType::RIGHT_BRACKET))
-            {
-                Advance(); // ]
-                bHasArrayBrackets = true;
-                
-                // Convert to array type for function return type checking
-                switch (ReturnType)
-                {
-                    case EScriptType::INT: ReturnType = EScriptType::INT_ARRAY; break;
-                    case EScriptType::FLOAT: ReturnType = EScriptType::FLOAT_ARRAY; break;
-                    case EScriptType::STRING: ReturnType = EScriptType::STRING_ARRAY; break;
-                    case EScriptType::BOOL: ReturnType = EScriptType::BOOL_ARRAY; break;
-                    default: break;
-                }
-            }
-        }
-        
-        // Check if identifier followed by (
-        bool bIsFunction = false;
-        if (Check(ETokenType::IDENTIFIER))
-        {
-            Advance(); // identifier
-            bIsFunction = Check(ETokenType::LEFT_PAREN);
-        }
-        
-        // Restore position to right after the type token (before [] if present)
-        Current = SavedCurrent;
+        // Function: type [] name ( ...   Variable: type [] name = ...
+        // Decided by looking ahead, so both parsers start right after the type token
+        const int32 NameDistance = (Check(ETokenType::LEFT_BRACKET) && PeekAhead(1).Type == ETokenType::RIGHT_BRACKET) ? 2 : 0;
+        const bool bIsFunction = PeekAhead(NameDistance).Type == ETokenType::IDENTIFIER &&
+                                 PeekAhead(NameDistance + 1).Type == ETokenType::LEFT_PAREN;
         
         if (bIsFunction)
         {
-            // For functions, we need to parse [] again in ParseFunctionWithReturnType
-            // So restore to after type token and let function parser handle []
-            return ParseFunctionWithReturnType(GetTypeFromToken(Previous()));
+            // ParseFunctionWithReturnType handles []
+            return ParseFunctionWithReturnType(ReturnType);
         }
         
         // It's a variable declaration - let ParseVarDeclaration handle []
@@ -371,6 +379,12 @@ TSharedPtr<FFunctionDecl> FScriptParser::ParseFunction()
         return nullptr;
     }
     
+    // Prototype of a native (headers declare them) - nothing to compile
+    if (Match(ETokenType::SEMICOLON))
+    {
+        return nullptr;
+    }
+    
     if (!Consume(ETokenType::LEFT_BRACE, TEXT("Expected '{' before function body")))
     {
         Synchronize();
@@ -383,7 +397,7 @@ TSharedPtr<FFunctionDecl> FScriptParser::ParseFunction()
         return nullptr;
     }
     
-    return MakeShared<FFunctionDecl>(Name, Parameters, Body);
+    return NewNode<FFunctionDecl>(Name, Parameters, Body);
 }
 
 TSharedPtr<FFunctionDecl> FScriptParser::ParseFunctionWithReturnType(EScriptType ReturnType)
@@ -493,6 +507,12 @@ TSharedPtr<FFunctionDecl> FScriptParser::ParseFunctionWithReturnType(EScriptType
         return nullptr;
     }
     
+    // Prototype of a native (headers declare them) - nothing to compile
+    if (Match(ETokenType::SEMICOLON))
+    {
+        return nullptr;
+    }
+    
     if (!Consume(ETokenType::LEFT_BRACE, TEXT("Expected '{' before function body")))
     {
         Synchronize();
@@ -506,13 +526,19 @@ TSharedPtr<FFunctionDecl> FScriptParser::ParseFunctionWithReturnType(EScriptType
     }
     
     // Create FFunctionDecl with return type
-    TSharedPtr<FFunctionDecl> Func = MakeShared<FFunctionDecl>(Name, TArray<FScriptToken>(), Body);
+    TSharedPtr<FFunctionDecl> Func = NewNode<FFunctionDecl>(Name, TArray<FScriptToken>(), Body);
     Func->ReturnType = ReturnType;
     Func->TypedParameters = TypedParameters;
     
     return Func;
 }
 
+bool FScriptParser::IsCastType(ETokenType Type)
+{
+    return Type == ETokenType::INT || Type == ETokenType::FLOAT ||
+           Type == ETokenType::STRING_TYPE || Type == ETokenType::VOID;
+}
+
 EScriptType FScriptParser::GetTypeFromToken(const FScriptToken& Token)
 {
     switch (Token.Type)
@@ -612,7 +638,7 @@ TSharedPtr<FVarDeclStmt> FScriptParser::ParseVarDeclaration()
                 return nullptr;
             }
             
-            Initializer = MakeShared<FArrayLiteralExpr>(Elements);
+            Initializer = NewNode<FArrayLiteralExpr>(Elements);
         }
         else
         {
@@ -631,7 +657,7 @@ TSharedPtr<FVarDeclStmt> FScriptParser::ParseVarDeclaration()
         return nullptr;
     }
     
-    return MakeShared<FVarDeclStmt>(VarType, Name, Initializer);
+    return NewNode<FVarDeclStmt>(VarType, Name, Initializer);
 }
 
 //=============================================================================
@@ -698,7 +724,7 @@ TSharedPtr<FScriptStatement> FScriptParser::ParseExpressionStatement()
         return nullptr;
     }
     
-    return MakeShared<FExprStmt>(Expr);
+    return NewNode<FExprStmt>(Expr);
 }
 
 TSharedPtr<FBlockStmt> FScriptParser::ParseBlock()
@@ -720,7 +746,7 @@ TSharedPtr<FBlockStmt> FScriptParser::ParseBlock()
         return nullptr;
     }
     
-    return MakeShared<FBlockStmt>(Statements);
+    return NewNode<FBlockStmt>(Statements);
 }
 
 TSharedPtr<FIfStmt> FScriptParser::ParseIfStatement()
@@ -760,7 +786,7 @@ TSharedPtr<FIfStmt> FScriptParser::ParseIfStatement()
         }
     }
     
-    return MakeShared<FIfStmt>(Condition, ThenBranch, ElseBranch);
+    return NewNode<FIfStmt>(Condition, ThenBranch, ElseBranch);
 }
 
 TSharedPtr<FWhileStmt> FScriptParser::ParseWhileStatement()
@@ -790,7 +816,7 @@ TSharedPtr<FWhileStmt> FScriptParser::ParseWhileStatement()
         return nullptr;
     }
     
-    return MakeShared<FWhileStmt>(Condition, Body);
+    return NewNode<FWhileStmt>(Condition, Body);
 }
 
 TSharedPtr<FReturnStmt> FScriptParser::ParseReturnStatement()
@@ -813,7 +839,7 @@ TSharedPtr<FReturnStmt> FScriptParser::ParseReturnStatement()
         return nullptr;
     }
     
-    return MakeShared<FReturnStmt>(Value);
+    return NewNode<FReturnStmt>(Value);
 }
 
 TSharedPtr<FBreakStmt> FScriptParser::ParseBreakStatement()
@@ -826,7 +852,7 @@ TSharedPtr<FBreakStmt> FScriptParser::ParseBreakStatement()
         return nullptr;
     }
     
-    return MakeShared<FBreakStmt>();
+    return NewNode<FBreakStmt>();
 }
 
 TSharedPtr<FContinueStmt> FScriptParser::ParseContinueStatement()
@@ -839,7 +865,7 @@ TSharedPtr<FContinueStmt> FScriptParser::ParseContinueStatement()
         return nullptr;
     }
     
-    return MakeShared<FContinueStmt>();
+    return NewNode<FContinueStmt>();
 }
 
 //=============================================================================
@@ -867,7 +893,7 @@ TSharedPtr<FScriptExpression> FScriptParser::ParseAssignment()
             return nullptr;
         }
         
-        return MakeShared<FAssignExpr>(Expr, Value);
+        return NewNode<FAssignExpr>(Expr, Value);
     }
     
     return Expr;
@@ -889,7 +915,7 @@ TSharedPtr<FScriptExpression> FScriptParser::ParseLogicalOr()
             return nullptr;
         }
         
-        Expr = MakeShared<FBinaryExpr>(Expr, Op, Right);
+        Expr = NewNode<FBinaryExpr>(Expr, Op, Right);
     }
     
     return Expr;
@@ -911,7 +937,7 @@ TSharedPtr<FScriptExpression> FScriptParser::ParseLogicalAnd()
             return nullptr;
         }
         
-        Expr = MakeShared<FBinaryExpr>(Expr, Op, Right);
+        Expr = NewNode<FBinaryExpr>(Expr, Op, Right);
     }
     
     return Expr;
@@ -933,7 +959,7 @@ TSharedPtr<FScriptExpression> FScriptParser::ParseBitwiseOr()
             return nullptr;
         }
         
-        Expr = MakeShared<FBinaryExpr>(Expr, Op, Right);
+        Expr = NewNode<FBinaryExpr>(Expr, Op, Right);
     }
     
     return Expr;
@@ -955,7 +981,7 @@ TSharedPtr<FScriptExpression> FScriptParser::ParseBitwiseXor()
             return nullptr;
         }
         
-        Expr = MakeShared<FBinaryExpr>(Expr, Op, Right);
+        Expr = NewNode<FBinaryExpr>(Expr, Op, Right);
     }
     
     return Expr;
@@ -977,7 +1003,7 @@ TSharedPtr<FScriptExpression> FScriptParser::ParseBitwiseAnd()
             return nullptr;
         }
         
-        Expr = MakeShared<FBinaryExpr>(Expr, Op, Right);
+        Expr = NewNode<FBinaryExpr>(Expr, Op, Right);
     }
     
     return Expr;
@@ -999,7 +1025,7 @@ TSharedPtr<FScriptExpression> FScriptParser::ParseEquality()
             return nullptr;
         }
         
-        Expr = MakeShared<FBinaryExpr>(Expr, Op, Right);
+        Expr = NewNode<FBinaryExpr>(Expr, Op, Right);
     }
     
     return Expr;
@@ -1022,7 +1048,7 @@ TSharedPtr<FScriptExpression> FScriptParser::ParseComparison()
             return nullptr;
         }
         
-        Expr = MakeShared<FBinaryExpr>(Expr, Op, Right);
+        Expr = NewNode<FBinaryExpr>(Expr, Op, Right);
     }
     
     return Expr;
@@ -1044,7 +1070,7 @@ TSharedPtr<FScriptExpression> FScriptParser::ParseTerm()
             return nullptr;
         }
         
-        Expr = MakeShared<FBinaryExpr>(Expr, Op, Right);
+        Expr = NewNode<FBinaryExpr>(Expr, Op, Right);
     }
     
     return Expr;
@@ -1066,7 +1092,7 @@ TSharedPtr<FScriptExpression> FScriptParser::ParseFactor()
             return nullptr;
         }
         
-        Expr = MakeShared<FBinaryExpr>(Expr, Op, Right);
+        Expr = NewNode<FBinaryExpr>(Expr, Op, Right);
     }
     
     return Expr;
@@ -1085,47 +1111,38 @@ TSharedPtr<FScriptExpression> FScriptParser::ParseUnary()
             return nullptr;
         }
         
-        return MakeShared<FUnaryExpr>(Op, Right);
+        return NewNode<FUnaryExpr>(Op, Right);
     }
     
-    // Type cast: (int)expr or (float)expr
-    if (Match(ETokenType::LEFT_PAREN))
+    // Type cast: (int)expr or (float)expr - anything else in parentheses is a call/primary
+    if (Check(ETokenType::LEFT_PAREN) && IsCastType(PeekAhead(1).Type))
     {
-        // Peek ahead to check if this is a type cast
-        if (Check(ETokenType::INT) || Check(ETokenType::FLOAT) || 
-            Check(ETokenType::STRING_TYPE) || Check(ETokenType::VOID))
+        Advance(); // (
+        const ETokenType CastType = Advance().Type;
+        
+        if (!Consume(ETokenType::RIGHT_PAREN, TEXT("Expected ')' after type in cast")))
         {
-            FScriptToken TypeToken = Advance();
-            
-            if (!Consume(ETokenType::RIGHT_PAREN, TEXT("Expected ')' after type in cast")))
-            {
-                return nullptr;
-            }
-            
-            TSharedPtr<FScriptExpression> Expr = ParseUnary();
-            if (!Expr.IsValid())
-            {
-                ReportError(TEXT("Expected expression after type cast"));
-                return nullptr;
-            }
-            
-            EScriptType TargetType = EScriptType::AUTO;
-            switch (TypeToken.Type)
-            {
-                case ETokenType::INT: TargetType = EScriptType::INT; break;
-                case ETokenType::FLOAT: TargetType = EScriptType::FLOAT; break;
-                case ETokenType::STRING_TYPE: TargetType = EScriptType::STRING; break;
-                case ETokenType::VOID: TargetType = EScriptType::VOID; break;
-                default: break;
-            }
-            
-            return MakeShared<FTypeCastExpr>(TargetType, Expr);
+            return nullptr;
         }
-        else
+        
+        TSharedPtr<FScriptExpression> Expr = ParseUnary();
+        if (!Expr.IsValid())
         {
-            // Not a type cast, backtrack and parse as call/primary
-            Current--;
+            ReportError(TEXT("Expected expression after type cast"));
+            return nullptr;
         }
+        
+        EScriptType TargetType = EScriptType::AUTO;
+        switch (CastType)
+        {
+            case ETokenType::INT: TargetType = EScriptType::INT; break;
+            case ETokenType::FLOAT: TargetType = EScriptType::FLOAT; break;
+            case ETokenType::STRING_TYPE: TargetType = EScriptType::STRING; break;
+            case ETokenType::VOID: TargetType = EScriptType::VOID; break;
+            default: break;
+        }
+        
+        return NewNode<FTypeCastExpr>(TargetType, Expr);
     }
     
     return ParseCall();
@@ -1159,7 +1176,7 @@ TSharedPtr<FScriptExpression> FScriptParser::ParseCall()
                 return nullptr;
             }
             
-            Expr = MakeShared<FArrayAccessExpr>(Expr, Index);
+            Expr = NewNode<FArrayAccessExpr>(Expr, Index);
         }
         else if (Match(ETokenType::DOT))
         {
@@ -1171,7 +1188,7 @@ TSharedPtr<FScriptExpression> FScriptParser::ParseCall()
             }
             
             FScriptToken PropertyName = Advance();
-            Expr = MakeShared<FStructAccessExpr>(Expr, PropertyName);
+            Expr = NewNode<FStructAccessExpr>(Expr, PropertyName);
         }
         else
         {
@@ -1193,35 +1210,34 @@ TSharedPtr<FScriptExpression> FScriptParser::ParsePrimary()
     // Literals
     if (Match(ETokenType::KW_TRUE))
     {
-        return MakeShared<FLiteralExpr>(Previous(), true);
+        return NewNode<FLiteralExpr>(Previous(), true);
     }
     
     if (Match(ETokenType::KW_FALSE))
     {
-        return MakeShared<FLiteralExpr>(Previous(), false);
+        return NewNode<FLiteralExpr>(Previous(), false);
     }
     
     if (Match(ETokenType::NIL))
     {
-        return MakeShared<FLiteralExpr>(Previous(), 0.0);
+        return NewNode<FLiteralExpr>(Previous(), 0.0);
     }
     
     if (Match(ETokenType::NUMBER))
     {
         FScriptToken Token = Previous();
-        double Value = FCString::Atod(*Token.Lexeme);
-        return MakeShared<FLiteralExpr>(Token, Value);
+        return NewNode<FLiteralExpr>(Token, Token.NumberValue);
     }
     
     if (Match(ETokenType::STRING))
     {
         FScriptToken Token = Previous();
-        return MakeShared<FLiteralExpr>(Token, Token.Lexeme);
+        return NewNode<FLiteralExpr>(Token, Token.Lexeme);
     }
     
     if (Match(ETokenType::IDENTIFIER))
     {
-        return MakeShared<FIdentifierExpr>(Previous());
+        return NewNode<FIdentifierExpr>(Previous());
     }
     
     // Grouping
@@ -1269,7 +1285,7 @@ TSharedPtr<FScriptExpression> FScriptParser::FinishCall(TSharedPtr<FScriptExpres
         return nullptr;
     }
     
-    return MakeShared<FCallExpr>(Callee, Arguments);
+    return NewNode<FCallExpr>(Callee, Arguments);
 }
 
 TSharedPtr<FScriptStatement> FScriptParser::ParseForStatement()
@@ -1281,6 +1297,11 @@ TSharedPtr<FScriptStatement> FScriptParser::ParseForStatement()
         return nullptr;
     }
     
+    if (CheckForEachHeader())
+    {
+        return ParseForEachStatement();
+    }
+    
     // Parse initialization
     TSharedPtr<FScriptStatement> Init = nullptr;
     if (Check(ETokenType::SEMICOLON))
@@ -1305,10 +1326,7 @@ TSharedPtr<FScriptStatement> FScriptParser::ParseForStatement()
     {
         Condition = ParseExpression();
     }
-    if (!Condition.IsValid())
-    {
-        Condition = MakeShared<FLiteralExpr>(FScriptToken(ETokenType::KW_TRUE, TEXT("true"), 0, 0), true);
-    }
+    // No condition = loop until 'break' (the compiler omits the test)
     
     if (!Consume(ETokenType::SEMICOLON, TEXT("Expected ';' after condition in for loop")))
     {
@@ -1336,34 +1354,73 @@ TSharedPtr<FScriptStatement> FScriptParser::ParseForStatement()
         return nullptr;
     }
     
-    // Syntactic sugar: convert for loop to while loop
-    // for(init; condition; increment) body => { init; while(condition) { body; increment; } }
-    
-    // Create a block with the initialization and while loop
-    TArray<TSharedPtr<FScriptStatement>> BlockStmts;
-    
-    if (Init.IsValid())
+    // Kept as a for statement (not desugared to while) so 'continue' can reach the
+    // increment and the compiler can recognise counted loops
+    return NewNode<FForStmt>(Init, Condition, Increment, Body);
+}
+
+bool FScriptParser::CheckForEachHeader()
+{
+    // for ( [type] name in ...
+    int32 NameDistance = 0;
+    if (Check(ETokenType::VAR) || Check(ETokenType::INT) || Check(ETokenType::FLOAT) || Check(ETokenType::STRING_TYPE))
     {
-        BlockStmts.Add(Init);
+        NameDistance++;
     }
     
-    // Create the while loop: while(condition) { body; increment; }
-    TArray<TSharedPtr<FScriptStatement>> WhileBodyStmts;
+    if (PeekAhead(NameDistance).Type != ETokenType::IDENTIFIER)
+    {
+        return false;
+    }
+    const FScriptToken& In = PeekAhead(NameDistance + 1);
+    return In.Type == ETokenType::IDENTIFIER && In.Lexeme == TEXT("in");
+}
+
+TSharedPtr<FScriptStatement> FScriptParser::ParseForEachStatement()
+{
+    // '(' already consumed, CheckForEachHeader() matched
+    EScriptType VarType = EScriptType::AUTO;
+    if (Match(ETokenType::INT))
+    {
+        VarType = EScriptType::INT;
+    }
+    else if (Match(ETokenType::FLOAT))
+    {
+        VarType = EScriptType::FLOAT;
+    }
+    else if (Match(ETokenType::STRING_TYPE))
+    {
+        VarType = EScriptType::STRING;
+    }
+    else
+    {
+        Match(ETokenType::VAR);
+    }
     
-    WhileBodyStmts.Add(Body);
+    FScriptToken Name = Advance();
+    Advance(); // 'in'
     
-    // If increment exists, add it as a statement
-    if (Increment.IsValid())
+    TSharedPtr<FScriptExpression> Iterable = ParseExpression();
+    if (!Iterable.IsValid())
     {
-        WhileBodyStmts.Add(MakeShared<FExprStmt>(Increment));
+        ReportError(TEXT("Expected expression after 'in'"));
+        Synchronize();
+        return nullptr;
     }
     
-    TSharedPtr<FBlockStmt> WhileBody = MakeShared<FBlockStmt>(WhileBodyStmts);
-    TSharedPtr<FWhileStmt> WhileLoop = MakeShared<FWhileStmt>(Condition, WhileBody);
+    if (!Consume(ETokenType::RIGHT_PAREN, TEXT("Expected ')' after for-each expression")))
+    {
+        Synchronize();
+        return nullptr;
+    }
     
-    BlockStmts.Add(WhileLoop);
+    TSharedPtr<FScriptStatement> Body = ParseStatement();
+    if (!Body.IsValid())
+    {
+        return nullptr;
+    }
     
-    return MakeShared<FBlockStmt>(BlockStmts);
+    return NewNode<FForEachStmt>(VarType, Name, Iterable, Body);
 }
 
 TSharedPtr<FScriptStatement> FScriptParser::ParseSwitchStatement()
@@ -1432,7 +1489,7 @@ TSharedPtr<FScriptStatement> FScriptParser::ParseSwitchStatement()
                 CaseBodyStmts.Add(Stmt);
             }
             
-            TSharedPtr<FBlockStmt> CaseBody = MakeShared<FBlockStmt>(CaseBodyStmts);
+            TSharedPtr<FBlockStmt> CaseBody = NewNode<FBlockStmt>(CaseBodyStmts);
             Cases.Add(TPair<TSharedPtr<FScriptExpression>, TSharedPtr<FScriptStatement>>(Value, CaseBody));
         }
         else if (Match(ETokenType::DEFAULT))
@@ -1458,7 +1515,7 @@ TSharedPtr<FScriptStatement> FScriptParser::ParseSwitchStatement()
                 DefaultBodyStmts.Add(Stmt);
             }
             
-            DefaultCase = MakeShared<FBlockStmt>(DefaultBodyStmts);
+            DefaultCase = NewNode<FBlockStmt>(DefaultBodyStmts);
         }
         else
         {
@@ -1474,6 +1531,6 @@ TSharedPtr<FScriptStatement> FScriptParser::ParseSwitchStatement()
         return nullptr;
     }
     
-    return MakeShared<FSwitchStmt>(Expression, Cases, DefaultCase);
+    return NewNode<FSwitchStmt>(Expression, Cases, DefaultCase);
 }
 
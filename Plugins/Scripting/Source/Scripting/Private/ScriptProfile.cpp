@@ -0,0 +1,215 @@
+// Copyright Vampire Game Project. All Rights Reserved.
+// Custom scripting system for secure modding support.
+
+#include "ScriptProfile.h"
+#include "Misc/FileHelper.h"
+
+// .scprof text format: a header line, then one record per line with tab-separated fields
+//   kind  line  name  file  count  [type pairs]
+// kind is "branch" (count = jumps taken, then fall-throughs), "operands" (name = operator,
+// count = runs, then the FInstructionCounters::OperandTypes bits seen) or "call" (name =
+// callee). The file is empty for the compiled script itself.
+static const TCHAR* PROFILE_MAGIC = TEXT("SBSPROF");
+static const int32 PROFILE_VERSION = 1;
+
+static const TCHAR* GetOperatorName(EOpCode OpCode)
+{
+    switch (OpCode)
+    {
+        case EOpCode::OP_ADD:      return TEXT("add");
+        case EOpCode::OP_SUBTRACT: return TEXT("subtract");
+        case EOpCode::OP_MULTIPLY: return TEXT("multiply");
+        case EOpCode::OP_LESS:     return TEXT("less");
+        case EOpCode::OP_GREATER:  return TEXT("greater");
+        default:                   return nullptr;
+    }
+}
+
+// Tab-separated fields, empty ones kept
+static TArray<FString> SplitFields(const FString& Line)
+{
+    TArray<FString> Fields;
+    FString Field;
+    for (int32 i = 0; i < Line.Len(); ++i)
+    {
+        if (Line[i] == TEXT('\t'))
+        {
+            Fields.Add(Field);
+            Field = FString();
+        }
+        else if (Line[i] != TEXT('\r'))
+        {
+            Field += Line[i];
+        }
+    }
+    Fields.Add(Field);
+    return Fields;
+}
+
+FString FScriptProfile::MakeKey(int32 Line, const FString& Name, const FString& SourceFile)
+{
+    return FString::Printf(TEXT("%d\t%s\t%s"), Line, *Name, *SourceFile);
+}
+
+void FScriptProfile::AddRun(const FBytecodeChunk& Chunk, const TArray<FInstructionCounters>& Counters)
+{
+    const TArray<uint8>& Code = Chunk.Code;
+    const int32 Num = FMath::Min(Counters.Num(), FMath::Min(Code.Num(), Chunk.LineTable.Num()));
+
+    // Only instruction starts are ever counted, so operand bytes are skipped by Executed == 0
+    for (int32 Offset = 0; Offset < Num; ++Offset)
+    {
+        const FInstructionCounters& Counter = Counters[Offset];
+        if (Counter.Executed == 0)
+        {
+            continue;
+        }
+
+        const FLineTable::FRun& Run = *Chunk.LineTable.Find(Offset);
+        const FString& SourceFile = Chunk.LineTable.Files[Run.File];
+        const EOpCode OpCode = static_cast<EOpCode>(Code[Offset]);
+        switch (OpCode)
+        {
+            case EOpCode::OP_JUMP_IF_FALSE:
+            case EOpCode::OP_JUMP_IF_FALSE_WIDE:
+            {
+                FBranch& Branch = Branches.FindOrAdd(MakeKey(Run.Line, FString(), SourceFile));
+                Branch.Taken += Counter.Taken;
+                Branch.FallThrough += Counter.Executed - Counter.Taken;
+                break;
+            }
+
+            case EOpCode::OP_CALL:
+            case EOpCode::OP_TAIL_CALL:
+            {
+                // [argc][function:2]
+                if (Offset + 3 >= Code.Num())
+                {
+                    break;
+                }
+                const int32 FuncIndex = (Code[Offset + 2] << 8) | Code[Offset + 3];
+                if (Chunk.Functions.IsValidIndex(FuncIndex))
+                {
+                    Calls.FindOrAdd(MakeKey(Run.Line, Chunk.Functions[FuncIndex].Name, SourceFile)) += Counter.Executed;
+                    TotalCalls += Counter.Executed;
+                }
+                break;
+            }
+
+            default:
+                if (const TCHAR* Operator = GetOperatorName(GetGenericOpCode(OpCode)))
+                {
+                    FOperands& Site = Operands.FindOrAdd(MakeKey(Run.Line, Operator, SourceFile));
+                    Site.TypePairs |= Counter.OperandTypes;
+                    Site.Count += Counter.Executed;
+                }
+                break;
+        }
+    }
+}
+
+bool FScriptProfile::SaveToFile(const FString& Path) const
+{
+    FString Text = FString::Printf(TEXT("%s\t%d\n"), PROFILE_MAGIC, PROFILE_VERSION);
+    for (const auto& Pair : Branches)
+    {
+        Text += FString::Printf(TEXT("branch\t%s\t%llu\t%llu\n"), *Pair.Key,
+            (unsigned long long)Pair.Value.Taken, (unsigned long long)Pair.Value.FallThrough);
+    }
+    for (const auto& Pair : Operands)
+    {
+        Text += FString::Printf(TEXT("operands\t%s\t%llu\t%u\n"), *Pair.Key,
+            (unsigned long long)Pair.Value.Count, Pair.Value.TypePairs);
+    }
+    for (const auto& Pair : Calls)
+    {
+        Text += FString::Printf(TEXT("call\t%s\t%llu\n"), *Pair.Key, (unsigned long long)Pair.Value);
+    }
+    return FFileHelper::SaveStringToFile(Text, *Path);
+}
+
+bool FScriptProfile::LoadFromFile(const FString& Path, FString& OutError)
+{
+    FString Text;
+    if (!FFileHelper::LoadFileToString(Text, *Path))
+    {
+        OutError = FString::Printf(TEXT("Cannot read profile '%s'"), *Path);
+        return false;
+    }
+
+    int32 LineNumber = 0;
+    int32 Start = 0;
+    while (Start < Text.Len())
+    {
+        int32 End = Start;
+        while (End < Text.Len() && Text[End] != TEXT('\n'))
+        {
+            End++;
+        }
+        const TArray<FString> Fields = SplitFields(Text.Mid(Start, End - Start));
+        Start = End + 1;
+        LineNumber++;
+
+        if (LineNumber == 1)
+        {
+            if (Fields.Num() != 2 || !Fields[0].Equals(PROFILE_MAGIC, ESearchCase::CaseSensitive) ||
+                FCString::Atoi(*Fields[1]) != PROFILE_VERSION)
+            {
+                OutError = FString::Printf(TEXT("'%s' is not a script profile"), *Path);
+                return false;
+            }
+            continue;
+        }
+        if (Fields.Num() == 1 && Fields[0].IsEmpty())
+        {
+            continue;
+        }
+
+        const FString& Kind = Fields[0];
+        const int32 Counts = Kind == TEXT("call") ? 1 : 2;
+        if (Fields.Num() != 4 + Counts || (Kind != TEXT("branch") && Kind != TEXT("operands") && Kind != TEXT("call")))
+        {
+            OutError = FString::Printf(TEXT("%s:%d: malformed profile record"), *Path, LineNumber);
+            return false;
+        }
+
+        const FString Key = MakeKey(FCString::Atoi(*Fields[1]), Fields[2], Fields[3]);
+        const uint64 First = FCString::Strtoui64(*Fields[4], nullptr, 10);
+        if (Kind == TEXT("branch"))
+        {
+            FBranch& Branch = Branches.FindOrAdd(Key);
+            Branch.Taken += First;
+            Branch.FallThrough += FCString::Strtoui64(*Fields[5], nullptr, 10);
+        }
+        else if (Kind == TEXT("operands"))
+        {
+            FOperands& Site = Operands.FindOrAdd(Key);
+            Site.Count += First;
+            Site.TypePairs |= static_cast<uint32>(FCString::Strtoui64(*Fields[5], nullptr, 10));
+        }
+        else
+        {
+            Calls.FindOrAdd(Key) += First;
+            TotalCalls += First;
+        }
+    }
+    return true;
+}
+
+const FScriptProfile::FBranch* FScriptProfile::FindBranch(const FString& SourceFile, int32 Line) const
+{
+    return Branches.Find(MakeKey(Line, FString(), SourceFile));
+}
+
+bool FScriptProfile::IsNumberOnly(const FString& SourceFile, int32 Line, EOpCode OpCode) const
+{
+    const TCHAR* Operator = GetOperatorName(GetGenericOpCode(OpCode));
+    const FOperands* Site = Operator ? Operands.Find(MakeKey(Line, Operator, SourceFile)) : nullptr;
+    return Site && Site->Count >= MinSamples && Site->TypePairs == GetTypePairBit(EValueType::NUMBER, EValueType::NUMBER);
+}
+
+uint64 FScriptProfile::GetCallCount(const FString& SourceFile, int32 Line, const FString& Callee) const
+{
+    const uint64* Count = Calls.Find(MakeKey(Line, Callee, SourceFile));
+    return Count ? *Count : 0;
+}
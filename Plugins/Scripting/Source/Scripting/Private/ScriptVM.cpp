@@ -9,63 +9,59 @@
 FScriptVM::FScriptVM()
     : State(EVMState::Ready)
     , InstructionPointer(0)
+    , CurrentBytecode(nullptr)
+    , bUncheckedDispatch(false)
+    , Backend(EScriptBackend::Stack)
+    , bInRegisterCode(false)
     , InstructionCount(0)
     , ExecutionStartTime(0.0)
+    , bProfiling(false)
 {
-    Stack.Reserve(256);
-    CallFrames.Reserve(64);
+    // Stack and frames are allocated on first Execute so idle instances stay small
+    Globals = MakeShared<FScriptGlobalTable>();
+}
+
+FScriptVM::~FScriptVM()
+{
+    ReleaseExtensionState(*this);
 }
 
 bool FScriptVM::Execute(TSharedPtr<FBytecodeChunk> Bytecode)
 {
-    if (!Bytecode.IsValid() || Bytecode->Code.Num() == 0)
+    TArray<FString> ProgramErrors;
+    TSharedPtr<const FScriptProgramImage> NewProgram = FScriptProgramImage::Create(Bytecode, FScriptNativeRegistry::Get(), ProgramErrors);
+    if (!NewProgram.IsValid())
     {
-        RuntimeError(TEXT("Invalid or empty bytecode"));
+        for (const FString& Error : ProgramErrors)
+        {
+            RuntimeError(Error);
+        }
         return false;
     }
     
-    // SECURITY: Validate bytecode before execution
-    FString ValidationReason;
-    if (!Bytecode->ValidateSecurity(ValidationReason))
+    return Execute(NewProgram);
+}
+
+bool FScriptVM::Execute(TSharedPtr<const FScriptProgramImage> InProgram)
+{
+    if (!InProgram.IsValid())
     {
-        RuntimeError(FString::Printf(TEXT("Bytecode security validation failed: %s"), *ValidationReason));
-        UE_LOG(LogTemp, Error, TEXT("VM: SECURITY VIOLATION - %s"), *ValidationReason);
-        UE_LOG(LogTemp, Error, TEXT("VM: Compiler: %s"), *Bytecode->Metadata.CompilerName);
-        UE_LOG(LogTemp, Error, TEXT("VM: Source: %s"), *Bytecode->Metadata.SourceFileName);
+        RuntimeError(TEXT("Invalid program"));
         return false;
     }
     
-    // Log security info
-    VM_LOG(FString::Printf(TEXT("=== BYTECODE SECURITY ===")));
-    VM_LOG(FString::Printf(TEXT("Compiler: %s %s"), *Bytecode->Metadata.CompilerName, *Bytecode->Metadata.CompilerVersion));
-    VM_LOG(FString::Printf(TEXT("Game: %s %s"), *Bytecode->Metadata.GameName, *Bytecode->Metadata.GameVersion));
-    VM_LOG(FString::Printf(TEXT("Trusted: %s"), Bytecode->IsTrustedCompiler() ? TEXT("YES") : TEXT("NO")));
-    VM_LOG(FString::Printf(TEXT("Security: %s"), *ValidationReason));
-    
     Reset();
-    CurrentBytecode = Bytecode;
+    SetProgram(InProgram);
     InstructionPointer = 0;
     InstructionCount = 0;
     ExecutionStartTime = FPlatformTime::Seconds();
     State = EVMState::Ready;
     
-    // Load function table from bytecode
-    FunctionTable.Empty();
-    for (const ::FFunctionInfo& BytecodeFunc : Bytecode->Functions)
-    {
-        FFunctionInfo VMFunc;
-        VMFunc.Name = BytecodeFunc.Name;
-        VMFunc.Address = BytecodeFunc.Address;
-        VMFunc.Arity = BytecodeFunc.Arity;
-        VMFunc.ReturnType = EScriptType::VOID; // Default for now
-        FunctionTable.Add(VMFunc);
-        
-        VM_LOG(FString::Printf(TEXT("Loaded function: %s (address=%d, arity=%d)"),
-            *VMFunc.Name, VMFunc.Address, VMFunc.Arity));
-    }
+    Stack.Reserve(64);
+    CallFrames.Reserve(16);
     
     VM_LOG(TEXT("=== VM EXECUTION START ==="));
-    VM_LOG(FString::Printf(TEXT("Loaded %d functions"), FunctionTable.Num()));
+    VM_LOG(FString::Printf(TEXT("Loaded %d functions"), Program->GetFunctions().Num()));
     
     return Resume();
 }
@@ -76,28 +72,18 @@ bool FScriptVM::Resume()
     {
         return false;
     }
+    
+    if (!CurrentBytecode)
+    {
+        RuntimeError(TEXT("No program loaded"));
+        return false;
+    }
 
     State = EVMState::Running;
 
-    // Main execution loop
-    while (InstructionPointer < CurrentBytecode->Code.Num() && State == EVMState::Running)
+    if (!Run(0))
     {
-        // Safety checks
-        if (!CheckInstructionLimit() || !CheckTimeout())
-        {
-            State = EVMState::Error;
-            return false;
-        }
-        
-        // Execute one instruction
-        if (!ExecuteInstruction())
-        {
-            VM_LOG_ERROR(TEXT("VM execution failed"));
-            State = EVMState::Error;
-            return false;
-        }
-        
-        InstructionCount++;
+        return false;
     }
     
     if (State == EVMState::Paused)
@@ -130,8 +116,8 @@ void FScriptVM::Reset()
 {
     Stack.Empty();
     CallFrames.Empty();
-    FunctionTable.Empty();
     Errors.Empty();
+    bInRegisterCode = false;
     InstructionPointer = 0;
     InstructionCount = 0;
     ExecutionStartTime = 0.0;
@@ -150,9 +136,10 @@ void FScriptVM::Push(const FScriptValue& Value)
     Stack.Add(Value);
 }
 
+template<bool bVerified>
 FScriptValue FScriptVM::Pop()
 {
-    if (Stack.Num() == 0)
+    if (!bVerified && Stack.Num() == 0)
     {
         RuntimeError(TEXT("Stack underflow"));
         return FScriptValue::Nil();
@@ -163,9 +150,10 @@ FScriptValue FScriptVM::Pop()
     return Value;
 }
 
+template<bool bVerified>
 FScriptValue FScriptVM::Peek(int32 Offset) const
 {
-    if (Stack.Num() == 0 || Offset >= Stack.Num())
+    if (!bVerified && (Stack.Num() == 0 || Offset >= Stack.Num()))
     {
         return FScriptValue::Nil();
     }
@@ -178,25 +166,17 @@ FScriptValue FScriptVM::Peek(int32 Offset) const
 
 bool FScriptVM::CallMainIfExists()
 {
-    // Look for Main function in function table
-    int32 MainFuncIndex = -1;
-    for (int32 i = 0; i < FunctionTable.Num(); ++i)
-    {
-        if (FunctionTable[i].Name == TEXT("Main"))
-        {
-            MainFuncIndex = i;
-            break;
-        }
-    }
+    // Main() is located once when the program is built
+    int32 MainFuncIndex = Program.IsValid() ? Program->GetMainFunctionIndex() : INDEX_NONE;
     
-    if (MainFuncIndex == -1)
+    if (MainFuncIndex == INDEX_NONE)
     {
         // No Main function found, this is not an error
         VM_LOG(TEXT("No Main() function found - script completed"));
         return false;
     }
     
-    FFunctionInfo& MainFunc = FunctionTable[MainFuncIndex];
+    const FFunctionInfo& MainFunc = Program->GetFunctions()[MainFuncIndex];
     
     // Create a call to Main function
     // Push arguments (none for Main)
@@ -218,30 +198,18 @@ bool FScriptVM::CallMainIfExists()
     CallFrames.Add(Frame);
     
     // Jump to Main function
-    InstructionPointer = MainFunc.Address;
+    if (!EnterFunction(CallFrames.Last(), MainFunc))
+    {
+        return false;
+    }
     
     VM_LOG(TEXT("Calling Main() function..."));
     State = EVMState::Running;
     
     // Now execute until we return from Main
-    while (InstructionPointer < CurrentBytecode->Code.Num() && CallFrames.Num() > 0 && State == EVMState::Running)
+    if (!Run(1))
     {
-        // Safety checks
-        if (!CheckInstructionLimit() || !CheckTimeout())
-        {
-            State = EVMState::Error;
-            return false;
-        }
-        
-        // Execute one instruction
-        if (!ExecuteInstruction())
-        {
-            VM_LOG_ERROR(TEXT("VM execution failed in Main()"));
-            State = EVMState::Error;
-            return false;
-        }
-        
-        InstructionCount++;
+        return false;
     }
     
     if (State == EVMState::Paused)
@@ -325,9 +293,125 @@ bool FScriptVM::CheckTimeout()
 // Instruction Execution
 //=============================================================================
 
+bool FScriptVM::Run(int32 MinCallDepth)
+{
+    // Each loop stops when a call or return crosses into the other kind of code
+    while (true)
+    {
+        bool bOk;
+        if (bInRegisterCode)
+        {
+            bOk = RunRegisterLoop(MinCallDepth);
+        }
+        else if (bUncheckedDispatch && Limits.bAllowUncheckedDispatch && !bProfiling)
+        {
+            bOk = RunLoop<true>(MinCallDepth);
+        }
+        else
+        {
+            bOk = RunLoop<false>(MinCallDepth);
+        }
+        
+        if (!bOk || State != EVMState::Running || CallFrames.Num() < MinCallDepth ||
+            (!bInRegisterCode && InstructionPointer >= CurrentBytecode->Code.Num()))
+        {
+            return bOk;
+        }
+    }
+}
+
+template<bool bVerified>
+bool FScriptVM::RunLoop(int32 MinCallDepth)
+{
+    // Reading the clock costs more than most instructions - sample it
+    static constexpr int32 TimeoutCheckMask = 255;
+    
+    // Main execution loop
+    while (InstructionPointer < CurrentBytecode->Code.Num() && CallFrames.Num() >= MinCallDepth && State == EVMState::Running &&
+        !bInRegisterCode)
+    {
+        // Safety checks
+        if (!CheckInstructionLimit() || ((InstructionCount & TimeoutCheckMask) == 0 && !CheckTimeout()))
+        {
+            State = EVMState::Error;
+            return false;
+        }
+        
+        if (!bVerified && bProfiling)
+        {
+            RecordProfile();
+        }
+        
+        // Execute one instruction
+        if (!ExecuteInstruction<bVerified>())
+        {
+            VM_LOG_ERROR(TEXT("VM execution failed"));
+            State = EVMState::Error;
+            return false;
+        }
+        
+        InstructionCount++;
+    }
+    return true;
+}
+
+void FScriptVM::SetProfilingEnabled(bool bEnabled)
+{
+    bProfiling = bEnabled;
+    if (bEnabled)
+    {
+        ProfileCounters.Empty();
+    }
+}
+
+void FScriptVM::RecordProfile()
+{
+    const TArray<uint8>& Code = CurrentBytecode->Code;
+    if (InstructionPointer >= ProfileCounters.Num())
+    {
+        ProfileCounters.SetNum(Code.Num());
+    }
+    
+    FInstructionCounters& Counters = ProfileCounters[InstructionPointer];
+    Counters.Executed++;
+    
+    switch (static_cast<EOpCode>(Code[InstructionPointer]))
+    {
+        case EOpCode::OP_JUMP_IF_FALSE:
+        case EOpCode::OP_JUMP_IF_FALSE_WIDE:
+            if (Stack.Num() > 0 && !IsTruthy(Stack.Last()))
+            {
+                Counters.Taken++;
+            }
+            break;
+            
+        case EOpCode::OP_ADD:
+        case EOpCode::OP_SUBTRACT:
+        case EOpCode::OP_MULTIPLY:
+        case EOpCode::OP_LESS:
+        case EOpCode::OP_GREATER:
+        case EOpCode::OP_ADD_NUMBER:
+        case EOpCode::OP_SUBTRACT_NUMBER:
+        case EOpCode::OP_MULTIPLY_NUMBER:
+        case EOpCode::OP_LESS_NUMBER:
+        case EOpCode::OP_GREATER_NUMBER:
+        case EOpCode::OP_NOT_LESS_NUMBER:
+        case EOpCode::OP_NOT_GREATER_NUMBER:
+            if (Stack.Num() >= 2)
+            {
+                Counters.OperandTypes |= FScriptProfile::GetTypePairBit(Stack[Stack.Num() - 2].Type, Stack.Last().Type);
+            }
+            break;
+            
+        default:
+            break;
+    }
+}
+
+template<bool bVerified>
 bool FScriptVM::ExecuteInstruction()
 {
-    if (InstructionPointer >= CurrentBytecode->Code.Num())
+    if (!bVerified && InstructionPointer >= CurrentBytecode->Code.Num())
     {
         RuntimeError(TEXT("Instruction pointer out of bounds"));
         return false;
@@ -337,63 +421,88 @@ bool FScriptVM::ExecuteInstruction()
     
     switch (OpCode)
     {
-        case EOpCode::OP_CONSTANT:      OpConstant(); break;
-        case EOpCode::OP_NIL:           OpNil(); break;
-        case EOpCode::OP_TRUE:          OpTrue(); break;
-        case EOpCode::OP_FALSE:         OpFalse(); break;
+        case EOpCode::OP_CONSTANT:      OpConstant<bVerified>(); break;
+        case EOpCode::OP_NIL:           OpNil<bVerified>(); break;
+        case EOpCode::OP_TRUE:          OpTrue<bVerified>(); break;
+        case EOpCode::OP_FALSE:         OpFalse<bVerified>(); break;
+        
+        case EOpCode::OP_ADD:           OpAdd<bVerified>(); break;
+        case EOpCode::OP_SUBTRACT:      OpSubtract<bVerified>(); break;
+        case EOpCode::OP_MULTIPLY:      OpMultiply<bVerified>(); break;
+        case EOpCode::OP_DIVIDE:        OpDivide<bVerified>(); break;
+        case EOpCode::OP_MODULO:        OpModulo<bVerified>(); break;
+        case EOpCode::OP_NEGATE:        OpNegate<bVerified>(); break;
         
-        case EOpCode::OP_ADD:           OpAdd(); break;
-        case EOpCode::OP_SUBTRACT:      OpSubtract(); break;
-        case EOpCode::OP_MULTIPLY:      OpMultiply(); break;
-        case EOpCode::OP_DIVIDE:        OpDivide(); break;
-        case EOpCode::OP_MODULO:        OpModulo(); break;
-        case EOpCode::OP_NEGATE:        OpNegate(); break;
+        case EOpCode::OP_EQUAL:         OpEqual<bVerified>(); break;
+        case EOpCode::OP_GREATER:       OpGreater<bVerified>(); break;
+        case EOpCode::OP_LESS:          OpLess<bVerified>(); break;
+        case EOpCode::OP_NOT:           OpNot<bVerified>(); break;
+        case EOpCode::OP_AND:           OpAnd<bVerified>(); break;
+        case EOpCode::OP_OR:            OpOr<bVerified>(); break;
         
-        case EOpCode::OP_EQUAL:         OpEqual(); break;
-        case EOpCode::OP_GREATER:       OpGreater(); break;
-        case EOpCode::OP_LESS:          OpLess(); break;
-        case EOpCode::OP_NOT:           OpNot(); break;
-        case EOpCode::OP_AND:           OpAnd(); break;
-        case EOpCode::OP_OR:            OpOr(); break;
+        case EOpCode::OP_BIT_AND:       OpBitAnd<bVerified>(); break;
+        case EOpCode::OP_BIT_OR:        OpBitOr<bVerified>(); break;
+        case EOpCode::OP_BIT_XOR:       OpBitXor<bVerified>(); break;
+        case EOpCode::OP_BIT_NOT:       OpBitNot<bVerified>(); break;
         
-        case EOpCode::OP_BIT_AND:       OpBitAnd(); break;
-        case EOpCode::OP_BIT_OR:        OpBitOr(); break;
-        case EOpCode::OP_BIT_XOR:       OpBitXor(); break;
-        case EOpCode::OP_BIT_NOT:       OpBitNot(); break;
+        case EOpCode::OP_GET_LOCAL:     OpGetLocal<bVerified>(); break;
+        case EOpCode::OP_SET_LOCAL:     OpSetLocal<bVerified>(); break;
+        case EOpCode::OP_DEFINE_GLOBAL: OpDefineGlobal<bVerified>(); break;
+        case EOpCode::OP_GET_GLOBAL:    OpGetGlobal<bVerified>(); break;
+        case EOpCode::OP_SET_GLOBAL:    OpSetGlobal<bVerified>(); break;
         
-        case EOpCode::OP_GET_LOCAL:     OpGetLocal(); break;
-        case EOpCode::OP_SET_LOCAL:     OpSetLocal(); break;
-        case EOpCode::OP_DEFINE_GLOBAL: OpDefineGlobal(); break;
-        case EOpCode::OP_GET_GLOBAL:    OpGetGlobal(); break;
-        case EOpCode::OP_SET_GLOBAL:    OpSetGlobal(); break;
+        case EOpCode::OP_JUMP:          OpJump<bVerified>(); break;
+        case EOpCode::OP_JUMP_IF_FALSE: OpJumpIfFalse<bVerified>(); break;
+        case EOpCode::OP_LOOP:          OpLoop<bVerified>(); break;
+        case EOpCode::OP_FOR_PREP:      OpForPrep<bVerified>(); break;
+        case EOpCode::OP_FOR_LOOP:      OpForLoop<bVerified>(); break;
+        case EOpCode::OP_FOREACH:       OpForEach<bVerified>(); break;
+        case EOpCode::OP_SWITCH_TABLE:  OpSwitchTable<bVerified>(); break;
+        case EOpCode::OP_SWITCH_LOOKUP: OpSwitchLookup<bVerified>(); break;
         
-        case EOpCode::OP_JUMP:          OpJump(); break;
-        case EOpCode::OP_JUMP_IF_FALSE: OpJumpIfFalse(); break;
-        case EOpCode::OP_LOOP:          OpLoop(); break;
+        case EOpCode::OP_CONSTANT_WIDE:      OpConstant<bVerified, true>(); break;
+        case EOpCode::OP_DEFINE_GLOBAL_WIDE: OpDefineGlobal<bVerified, true>(); break;
+        case EOpCode::OP_GET_GLOBAL_WIDE:    OpGetGlobal<bVerified, true>(); break;
+        case EOpCode::OP_SET_GLOBAL_WIDE:    OpSetGlobal<bVerified, true>(); break;
+        case EOpCode::OP_GET_LOCAL_WIDE:     OpGetLocal<bVerified, true>(); break;
+        case EOpCode::OP_SET_LOCAL_WIDE:     OpSetLocal<bVerified, true>(); break;
+        case EOpCode::OP_JUMP_WIDE:          OpJump<bVerified, true>(); break;
+        case EOpCode::OP_JUMP_IF_FALSE_WIDE: OpJumpIfFalse<bVerified, true>(); break;
+        case EOpCode::OP_LOOP_WIDE:          OpLoop<bVerified, true>(); break;
+        case EOpCode::OP_FOREACH_WIDE:       OpForEach<bVerified, true>(); break;
         
-        case EOpCode::OP_CALL:          OpCall(); break;
-        case EOpCode::OP_CALL_NATIVE:   OpCallNative(); break;
-        case EOpCode::OP_RETURN:        OpReturn(); break;
+        case EOpCode::OP_ADD_NUMBER:           OpNumber<bVerified, EOpCode::OP_ADD>(); break;
+        case EOpCode::OP_SUBTRACT_NUMBER:      OpNumber<bVerified, EOpCode::OP_SUBTRACT>(); break;
+        case EOpCode::OP_MULTIPLY_NUMBER:      OpNumber<bVerified, EOpCode::OP_MULTIPLY>(); break;
+        case EOpCode::OP_LESS_NUMBER:          OpNumber<bVerified, EOpCode::OP_LESS>(); break;
+        case EOpCode::OP_GREATER_NUMBER:       OpNumber<bVerified, EOpCode::OP_GREATER>(); break;
+        case EOpCode::OP_NOT_LESS_NUMBER:      OpNumber<bVerified, EOpCode::OP_LESS, true>(); break;
+        case EOpCode::OP_NOT_GREATER_NUMBER:   OpNumber<bVerified, EOpCode::OP_GREATER, true>(); break;
         
-        case EOpCode::OP_CAST_INT:      OpCastInt(); break;
-        case EOpCode::OP_CAST_FLOAT:    OpCastFloat(); break;
-        case EOpCode::OP_CAST_STRING:   OpCastString(); break;
+        case EOpCode::OP_CALL:          OpCall<bVerified>(); break;
+        case EOpCode::OP_TAIL_CALL:     OpTailCall<bVerified>(); break;
+        case EOpCode::OP_CALL_NATIVE:   OpCallNative<bVerified>(); break;
+        case EOpCode::OP_RETURN:        OpReturn<bVerified>(); break;
         
-        case EOpCode::OP_POP:           OpPop(); break;
-        case EOpCode::OP_PRINT:         OpPrint(); break;
+        case EOpCode::OP_CAST_INT:      OpCastInt<bVerified>(); break;
+        case EOpCode::OP_CAST_FLOAT:    OpCastFloat<bVerified>(); break;
+        case EOpCode::OP_CAST_STRING:   OpCastString<bVerified>(); break;
+        
+        case EOpCode::OP_POP:           OpPop<bVerified>(); break;
+        case EOpCode::OP_PRINT:         OpPrint<bVerified>(); break;
         
         // Missing opcodes
-        case EOpCode::OP_NOT_EQUAL:     OpNotEqual(); break;
-        case EOpCode::OP_GREATER_EQUAL: OpGreaterEqual(); break;
-        case EOpCode::OP_LESS_EQUAL:    OpLessEqual(); break;
-        case EOpCode::OP_CREATE_ARRAY:  OpCreateArray(); break;
-        case EOpCode::OP_GET_ELEMENT:   OpGetElement(); break;
-        case EOpCode::OP_SET_ELEMENT:   OpSetElement(); break;
-        case EOpCode::OP_DUPLICATE:     OpDuplicate(); break;
+        case EOpCode::OP_NOT_EQUAL:     OpNotEqual<bVerified>(); break;
+        case EOpCode::OP_GREATER_EQUAL: OpGreaterEqual<bVerified>(); break;
+        case EOpCode::OP_LESS_EQUAL:    OpLessEqual<bVerified>(); break;
+        case EOpCode::OP_CREATE_ARRAY:  OpCreateArray<bVerified>(); break;
+        case EOpCode::OP_GET_ELEMENT:   OpGetElement<bVerified>(); break;
+        case EOpCode::OP_SET_ELEMENT:   OpSetElement<bVerified>(); break;
+        case EOpCode::OP_DUPLICATE:     OpDuplicate<bVerified>(); break;
         
         // Field access opcodes
-        case EOpCode::OP_GET_FIELD:     OpGetField(); break;
-        case EOpCode::OP_SET_FIELD:     OpSetField(); break;
+        case EOpCode::OP_GET_FIELD:     OpGetField<bVerified>(); break;
+        case EOpCode::OP_SET_FIELD:     OpSetField<bVerified>(); break;
         
         case EOpCode::OP_HALT:
             VM_LOG(TEXT("VM halted (normal completion)"));
@@ -407,34 +516,637 @@ bool FScriptVM::ExecuteInstruction()
     return !HasErrors();
 }
 
+//=============================================================================
+// Register Code
+//=============================================================================
+
+namespace
+{
+    inline uint16 ReadRegisterShort(const uint8* Operand)
+    {
+        return static_cast<uint16>((Operand[0] << 8) | Operand[1]);
+    }
+    
+    inline int32 ReadRegisterJump(const uint8* Operand)
+    {
+        return static_cast<int16>(ReadRegisterShort(Operand));
+    }
+    
+    // Overwrite a register without building a temporary value when it already holds a number
+    inline void SetNumber(FScriptValue& Register, double Value)
+    {
+        if (Register.IsNumber())
+        {
+            Register.NumberValue = Value;
+        }
+        else
+        {
+            Register = FScriptValue::Number(Value);
+        }
+    }
+    
+    inline void SetBool(FScriptValue& Register, bool Value)
+    {
+        if (Register.IsBool())
+        {
+            Register.BoolValue = Value;
+        }
+        else
+        {
+            Register = FScriptValue::Bool(Value);
+        }
+    }
+}
+
+bool FScriptVM::EnterFunction(FCallFrame& Frame, const FFunctionInfo& Function)
+{
+    if (Backend == EScriptBackend::Register && Function.RegisterAddress != INDEX_NONE)
+    {
+        // The arguments are r0..rN-1; the other registers start out nil
+        if (Frame.StackBase + Function.NumRegisters > Limits.MaxStackDepth)
+        {
+            RuntimeError(FString::Printf(TEXT("Stack overflow (max depth: %d)"), Limits.MaxStackDepth));
+            return false;
+        }
+        Stack.SetNum(Frame.StackBase + Function.NumRegisters);
+        Frame.bRegisterCode = true;
+        Frame.FunctionAddress = Function.RegisterAddress;
+    }
+    else
+    {
+        Frame.bRegisterCode = false;
+        Frame.FunctionAddress = Function.Address;
+    }
+    
+    bInRegisterCode = Frame.bRegisterCode;
+    InstructionPointer = Frame.FunctionAddress;
+    return true;
+}
+
+void FScriptVM::ReturnFromFrame(const FScriptValue& Result)
+{
+    const FCallFrame Frame = CallFrames.Last();
+    CallFrames.Pop();
+    
+    // Everything above the frame base goes: arguments, locals or registers, temporaries.
+    // A base below zero or above the top only comes from malformed unverified code
+    Stack.SetNum(FMath::Clamp(Frame.StackBase, 0, Stack.Num()));
+    InstructionPointer = Frame.ReturnAddress;
+    bInRegisterCode = CallFrames.Num() > 0 && CallFrames.Last().bRegisterCode;
+    
+    if (Frame.ReturnRegister != INDEX_NONE)
+    {
+        Stack[CallFrames.Last().StackBase + Frame.ReturnRegister] = Result;
+    }
+    else
+    {
+        // Push the return value where the arguments were
+        Push(Result);
+    }
+}
+
+void FScriptVM::RunStackHandler(void (FScriptVM::*Handler)(), const uint8* Operands, int32 NumOperands, uint8 Dest)
+{
+    const int32 Base = CallFrames.Last().StackBase;
+    const int32 Top = Stack.Num();
+    for (int32 i = 0; i < NumOperands; ++i)
+    {
+        if (!CheckStackOverflow())
+        {
+            Stack.SetNum(Top);
+            return;
+        }
+        FScriptValue Value = Stack[Base + Operands[i]];
+        Stack.Add(MoveTemp(Value));
+    }
+    
+    (this->*Handler)();
+    
+    // A handler that failed may not have pushed anything
+    if (!HasErrors() && Stack.Num() > Top)
+    {
+        FScriptValue Result = MoveTemp(Stack.Last());
+        Stack.SetNum(Top);
+        Stack[Base + Dest] = MoveTemp(Result);
+    }
+    Stack.SetNum(Top);
+}
+
+bool FScriptVM::RunRegisterLoop(int32 MinCallDepth)
+{
+    static constexpr int32 TimeoutCheckMask = 255;
+    
+    const uint8* Code = CurrentBytecode->RegisterCode.GetData();
+    const TArray<FScriptValue>& Constants = CurrentBytecode->Constants;
+    
+    // The frame's registers - re-read after anything that can grow the stack or change frames
+    FScriptValue* R = Stack.GetData() + CallFrames.Last().StackBase;
+    auto Refresh = [this, &R]()
+    {
+        if (bInRegisterCode)
+        {
+            R = Stack.GetData() + CallFrames.Last().StackBase;
+        }
+    };
+    
+    while (bInRegisterCode && CallFrames.Num() >= MinCallDepth && State == EVMState::Running)
+    {
+        if (!CheckInstructionLimit() || ((InstructionCount & TimeoutCheckMask) == 0 && !CheckTimeout()))
+        {
+            State = EVMState::Error;
+            return false;
+        }
+        
+        const uint8* Op = Code + InstructionPointer;
+        switch (static_cast<ERegOpCode>(Op[0]))
+        {
+            case ERegOpCode::REG_LOAD_CONSTANT:
+                InstructionPointer += 4;
+                R[Op[1]] = Constants[ReadRegisterShort(Op + 2)];
+                break;
+            case ERegOpCode::REG_LOAD_NIL:
+                InstructionPointer += 2;
+                R[Op[1]] = FScriptValue::Nil();
+                break;
+            case ERegOpCode::REG_LOAD_TRUE:
+            case ERegOpCode::REG_LOAD_FALSE:
+                InstructionPointer += 2;
+                SetBool(R[Op[1]], Op[0] == (uint8)ERegOpCode::REG_LOAD_TRUE);
+                break;
+            case ERegOpCode::REG_MOVE:
+                InstructionPointer += 3;
+                R[Op[1]] = R[Op[2]];
+                break;
+            
+            // Numbers inline, everything else (strings, errors) through the stack handler
+            case ERegOpCode::REG_ADD:
+                InstructionPointer += 4;
+                if (R[Op[2]].IsNumber() && R[Op[3]].IsNumber())
+                {
+                    SetNumber(R[Op[1]], R[Op[2]].AsNumber() + R[Op[3]].AsNumber());
+                }
+                else
+                {
+                    RunStackHandler(&FScriptVM::OpAdd<true>, Op + 2, 2, Op[1]);
+                    Refresh();
+                }
+                break;
+            case ERegOpCode::REG_SUBTRACT:
+                InstructionPointer += 4;
+                if (R[Op[2]].IsNumber() && R[Op[3]].IsNumber())
+                {
+                    SetNumber(R[Op[1]], R[Op[2]].AsNumber() - R[Op[3]].AsNumber());
+                }
+                else
+                {
+                    RunStackHandler(&FScriptVM::OpSubtract<true>, Op + 2, 2, Op[1]);
+                    Refresh();
+                }
+                break;
+            case ERegOpCode::REG_MULTIPLY:
+                InstructionPointer += 4;
+                if (R[Op[2]].IsNumber() && R[Op[3]].IsNumber())
+                {
+                    SetNumber(R[Op[1]], R[Op[2]].AsNumber() * R[Op[3]].AsNumber());
+                }
+                else
+                {
+                    RunStackHandler(&FScriptVM::OpMultiply<true>, Op + 2, 2, Op[1]);
+                    Refresh();
+                }
+                break;
+            case ERegOpCode::REG_DIVIDE:
+                InstructionPointer += 4;
+                if (R[Op[2]].IsNumber() && R[Op[3]].IsNumber() && R[Op[3]].AsNumber() != 0.0)
+                {
+                    SetNumber(R[Op[1]], DivideNumbers(R[Op[2]].AsNumber(), R[Op[3]].AsNumber()));
+                }
+                else
+                {
+                    RunStackHandler(&FScriptVM::OpDivide<true>, Op + 2, 2, Op[1]);
+                    Refresh();
+                }
+                break;
+            case ERegOpCode::REG_MODULO:
+                InstructionPointer += 4;
+                if (R[Op[2]].IsNumber() && R[Op[3]].IsNumber() && R[Op[3]].AsNumber() != 0.0)
+                {
+                    SetNumber(R[Op[1]], FMath::Fmod(R[Op[2]].AsNumber(), R[Op[3]].AsNumber()));
+                }
+                else
+                {
+                    RunStackHandler(&FScriptVM::OpModulo<true>, Op + 2, 2, Op[1]);
+                    Refresh();
+                }
+                break;
+            case ERegOpCode::REG_NEGATE:
+                InstructionPointer += 3;
+                if (R[Op[2]].IsNumber())
+                {
+                    SetNumber(R[Op[1]], -R[Op[2]].AsNumber());
+                }
+                else
+                {
+                    RunStackHandler(&FScriptVM::OpNegate<true>, Op + 2, 1, Op[1]);
+                    Refresh();
+                }
+                break;
+            
+            case ERegOpCode::REG_EQUAL:
+                InstructionPointer += 4;
+                SetBool(R[Op[1]], AreEqual(R[Op[2]], R[Op[3]]));
+                break;
+            case ERegOpCode::REG_GREATER:
+                InstructionPointer += 4;
+                if (R[Op[2]].IsNumber() && R[Op[3]].IsNumber())
+                {
+                    SetBool(R[Op[1]], R[Op[2]].AsNumber() > R[Op[3]].AsNumber());
+                }
+                else
+                {
+                    RunStackHandler(&FScriptVM::OpGreater<true>, Op + 2, 2, Op[1]);
+                    Refresh();
+                }
+                break;
+            case ERegOpCode::REG_LESS:
+                InstructionPointer += 4;
+                if (R[Op[2]].IsNumber() && R[Op[3]].IsNumber())
+                {
+                    SetBool(R[Op[1]], R[Op[2]].AsNumber() < R[Op[3]].AsNumber());
+                }
+                else
+                {
+                    RunStackHandler(&FScriptVM::OpLess<true>, Op + 2, 2, Op[1]);
+                    Refresh();
+                }
+                break;
+            case ERegOpCode::REG_NOT:
+                InstructionPointer += 3;
+                SetBool(R[Op[1]], !IsTruthy(R[Op[2]]));
+                break;
+            case ERegOpCode::REG_AND:
+                InstructionPointer += 4;
+                SetBool(R[Op[1]], IsTruthy(R[Op[2]]) && IsTruthy(R[Op[3]]));
+                break;
+            case ERegOpCode::REG_OR:
+                InstructionPointer += 4;
+                SetBool(R[Op[1]], IsTruthy(R[Op[2]]) || IsTruthy(R[Op[3]]));
+                break;
+            
+            case ERegOpCode::REG_BIT_AND:
+                InstructionPointer += 4;
+                RunStackHandler(&FScriptVM::OpBitAnd<true>, Op + 2, 2, Op[1]);
+                Refresh();
+                break;
+            case ERegOpCode::REG_BIT_OR:
+                InstructionPointer += 4;
+                RunStackHandler(&FScriptVM::OpBitOr<true>, Op + 2, 2, Op[1]);
+                Refresh();
+                break;
+            case ERegOpCode::REG_BIT_XOR:
+                InstructionPointer += 4;
+                RunStackHandler(&FScriptVM::OpBitXor<true>, Op + 2, 2, Op[1]);
+                Refresh();
+                break;
+            case ERegOpCode::REG_BIT_NOT:
+                InstructionPointer += 3;
+                RunStackHandler(&FScriptVM::OpBitNot<true>, Op + 2, 1, Op[1]);
+                Refresh();
+                break;
+            
+            case ERegOpCode::REG_CAST_INT:
+                InstructionPointer += 3;
+                RunStackHandler(&FScriptVM::OpCastInt<true>, Op + 2, 1, Op[1]);
+                Refresh();
+                break;
+            case ERegOpCode::REG_CAST_FLOAT:
+                InstructionPointer += 3;
+                RunStackHandler(&FScriptVM::OpCastFloat<true>, Op + 2, 1, Op[1]);
+                Refresh();
+                break;
+            case ERegOpCode::REG_CAST_STRING:
+                InstructionPointer += 3;
+                R[Op[1]] = FScriptValue::String(R[Op[2]].ToString());
+                break;
+            
+            case ERegOpCode::REG_GET_GLOBAL:
+            {
+                InstructionPointer += 4;
+                const FString& VarName = Constants[ReadRegisterShort(Op + 2)].AsString();
+                if (const FScriptValue* ValuePtr = Globals->Find(VarName))
+                {
+                    R[Op[1]] = *ValuePtr;
+                }
+                else
+                {
+                    RuntimeError(FString::Printf(TEXT("Undefined global variable: %s"), *VarName));
+                }
+                break;
+            }
+            case ERegOpCode::REG_SET_GLOBAL:
+            {
+                InstructionPointer += 4;
+                const FString& VarName = Constants[ReadRegisterShort(Op + 2)].AsString();
+                if (!Globals->Contains(VarName))
+                {
+                    RuntimeError(FString::Printf(TEXT("Cannot assign to undefined global variable: %s"), *VarName));
+                    break;
+                }
+                MutableGlobals()[VarName] = R[Op[1]];
+                VM_LOG(FString::Printf(TEXT("Set global variable: %s = %s"), *VarName, *R[Op[1]].ToString()));
+                break;
+            }
+            
+            case ERegOpCode::REG_JUMP:
+                InstructionPointer += 3 + ReadRegisterJump(Op + 1);
+                break;
+            case ERegOpCode::REG_JUMP_IF_FALSE:
+                InstructionPointer += 4 + (IsTruthy(R[Op[1]]) ? 0 : ReadRegisterJump(Op + 2));
+                break;
+            case ERegOpCode::REG_JUMP_IF_TRUE:
+                InstructionPointer += 4 + (IsTruthy(R[Op[1]]) ? ReadRegisterJump(Op + 2) : 0);
+                break;
+            case ERegOpCode::REG_JUMP_IF_EQUAL:
+            case ERegOpCode::REG_JUMP_IF_NOT_EQUAL:
+            {
+                const bool bJump = AreEqual(R[Op[1]], R[Op[2]]) == (Op[0] == (uint8)ERegOpCode::REG_JUMP_IF_EQUAL);
+                InstructionPointer += 5 + (bJump ? ReadRegisterJump(Op + 3) : 0);
+                break;
+            }
+            case ERegOpCode::REG_JUMP_IF_LESS:
+            case ERegOpCode::REG_JUMP_IF_NOT_LESS:
+            case ERegOpCode::REG_JUMP_IF_GREATER:
+            case ERegOpCode::REG_JUMP_IF_NOT_GREATER:
+            {
+                InstructionPointer += 5;
+                const FScriptValue& A = R[Op[1]];
+                const FScriptValue& B = R[Op[2]];
+                if (!A.IsNumber() || !B.IsNumber())
+                {
+                    RuntimeError(TEXT("Operands must be numbers"));
+                    break;
+                }
+                const ERegOpCode OpCode = static_cast<ERegOpCode>(Op[0]);
+                const bool bLess = OpCode == ERegOpCode::REG_JUMP_IF_LESS || OpCode == ERegOpCode::REG_JUMP_IF_NOT_LESS;
+                const bool bHolds = bLess ? A.AsNumber() < B.AsNumber() : A.AsNumber() > B.AsNumber();
+                const bool bWhenHolds = OpCode == ERegOpCode::REG_JUMP_IF_LESS || OpCode == ERegOpCode::REG_JUMP_IF_GREATER;
+                if (bHolds == bWhenHolds)
+                {
+                    InstructionPointer += ReadRegisterJump(Op + 3);
+                }
+                break;
+            }
+            
+            case ERegOpCode::REG_FOR_PREP:
+            {
+                InstructionPointer += 5;
+                const FScriptValue* Loop = R + Op[1];
+                if (!Loop[0].IsNumber() || !Loop[1].IsNumber() || !Loop[2].IsNumber())
+                {
+                    RuntimeError(TEXT("Operands must be numbers"));
+                    break;
+                }
+                if (!IsInForRange(Loop[0].AsNumber(), Loop[1].AsNumber(), Loop[2].AsNumber(), Op[2]))
+                {
+                    InstructionPointer += ReadRegisterJump(Op + 3);
+                }
+                break;
+            }
+            case ERegOpCode::REG_FOR_LOOP:
+            {
+                InstructionPointer += 5;
+                FScriptValue* Loop = R + Op[1];
+                const double Step = Loop[2].AsNumber();
+                const double Counter = Loop[0].AsNumber() + Step;
+                SetNumber(Loop[0], Counter);
+                if (IsInForRange(Counter, Loop[1].AsNumber(), Step, Op[2]))
+                {
+                    InstructionPointer += ReadRegisterJump(Op + 3);
+                }
+                break;
+            }
+            case ERegOpCode::REG_FOREACH:
+            {
+                InstructionPointer += 4;
+                FScriptValue* Loop = R + Op[1];
+                if (!Loop[0].IsArray())
+                {
+                    RuntimeError(TEXT("'for (x in ...)' requires an array"));
+                    break;
+                }
+                // The index register starts at -1 and is advanced before the element is loaded
+                const int32 Index = static_cast<int32>(Loop[1].AsNumber()) + 1;
+                const TArray<FScriptValue>& Elements = Loop[0].AsArray();
+                if (Index >= Elements.Num())
+                {
+                    InstructionPointer += ReadRegisterJump(Op + 2);
+                    break;
+                }
+                SetNumber(Loop[1], static_cast<double>(Index));
+                Loop[2] = Elements[Index];
+                break;
+            }
+            
+            case ERegOpCode::REG_CALL:
+            {
+                const int32 ArgCount = Op[4];
+                InstructionPointer += 5 + ArgCount;
+                const FFunctionInfo& FuncInfo = Program->GetFunctions()[ReadRegisterShort(Op + 2)];
+                if (!CheckCallDepth())
+                {
+                    break;
+                }
+                
+                // Arguments are copied above the caller's registers, where the callee's frame starts
+                const int32 Base = CallFrames.Last().StackBase;
+                for (int32 i = 0; i < ArgCount && CheckStackOverflow(); ++i)
+                {
+                    FScriptValue Value = Stack[Base + Op[5 + i]];
+                    Stack.Add(MoveTemp(Value));
+                }
+                if (HasErrors())
+                {
+                    break;
+                }
+                
+                FCallFrame Frame(0, InstructionPointer, Stack.Num() - ArgCount, FuncInfo.Name);
+                Frame.ReturnRegister = Op[1];
+                CallFrames.Add(Frame);
+                EnterFunction(CallFrames.Last(), FuncInfo);
+                Refresh();
+                break;
+            }
+            case ERegOpCode::REG_TAIL_CALL:
+            {
+                const int32 ArgCount = Op[3];
+                const FFunctionInfo& FuncInfo = Program->GetFunctions()[ReadRegisterShort(Op + 1)];
+                
+                // The arguments may come from any register, so they are gathered before the frame shrinks
+                TArray<FScriptValue> Args;
+                Args.Reserve(ArgCount);
+                for (int32 i = 0; i < ArgCount; ++i)
+                {
+                    Args.Add(R[Op[4 + i]]);
+                }
+                
+                FCallFrame& Frame = CallFrames.Last();
+                Stack.SetNum(Frame.StackBase + ArgCount);
+                for (int32 i = 0; i < ArgCount; ++i)
+                {
+                    Stack[Frame.StackBase + i] = MoveTemp(Args[i]);
+                }
+                Frame.FunctionName = FuncInfo.Name;
+                EnterFunction(Frame, FuncInfo);
+                Refresh();
+                break;
+            }
+            case ERegOpCode::REG_CALL_NATIVE:
+            {
+                const int32 ArgCount = Op[5];
+                InstructionPointer += 6 + ArgCount;
+                const uint16 NameIndex = ReadRegisterShort(Op + 3);
+                
+                TArray<FScriptValue> Args;
+                Args.Reserve(ArgCount);
+                for (int32 i = 0; i < ArgCount; ++i)
+                {
+                    Args.Add(R[Op[6 + i]]);
+                }
+                
+                // The native may re-enter the VM, so the register is found again afterwards
+                const int32 Dest = CallFrames.Last().StackBase + Op[1];
+                if (const FNativeFunction* NativeFunc = ResolveNative(NameIndex, ArgCount, (Op[2] & NATIVE_CALL_ARGS_CHECKED) != 0))
+                {
+                    FScriptValue Result = (*NativeFunc)(this, Args);
+                    Stack[Dest] = MoveTemp(Result);
+                }
+                else
+                {
+                    VM_LOG_WARNING(FString::Printf(TEXT("Native function '%s' not found - pushing nil"),
+                        *Constants[NameIndex].AsString()));
+                    Stack[Dest] = FScriptValue::Nil();
+                }
+                Refresh();
+                break;
+            }
+            case ERegOpCode::REG_RETURN:
+            {
+                const FScriptValue Result = R[Op[1]];
+                ReturnFromFrame(Result);
+                Refresh();
+                break;
+            }
+            
+            case ERegOpCode::REG_CREATE_ARRAY:
+            {
+                const int32 Count = Op[2];
+                InstructionPointer += 3 + Count;
+                TArray<FScriptValue> Elements;
+                Elements.Reserve(Count);
+                for (int32 i = 0; i < Count; ++i)
+                {
+                    Elements.Add(R[Op[3 + i]]);
+                }
+                R[Op[1]] = FScriptValue::Array(Elements);
+                break;
+            }
+            case ERegOpCode::REG_GET_ELEMENT:
+            {
+                InstructionPointer += 4;
+                const FScriptValue& Array = R[Op[2]];
+                const FScriptValue& Index = R[Op[3]];
+                const int32 Idx = Index.IsNumber() ? static_cast<int32>(Index.AsNumber()) : -1;
+                if (Array.IsArray() && Idx >= 0 && Idx < Array.AsArray().Num())
+                {
+                    // Copied out first: the destination may be the array itself
+                    FScriptValue Element = Array.AsArray()[Idx];
+                    R[Op[1]] = MoveTemp(Element);
+                }
+                else
+                {
+                    RunStackHandler(&FScriptVM::OpGetElement<true>, Op + 2, 2, Op[1]);
+                    Refresh();
+                }
+                break;
+            }
+            case ERegOpCode::REG_SET_ELEMENT:
+                InstructionPointer += 5;
+                RunStackHandler(&FScriptVM::OpSetElement<true>, Op + 2, 3, Op[1]);
+                Refresh();
+                break;
+            case ERegOpCode::REG_GET_FIELD:
+            {
+                InstructionPointer += 5;
+                const FString& FieldName = Constants[ReadRegisterShort(Op + 3)].AsString();
+                if (R[Op[2]].IsArray() && FieldName == TEXT("length"))
+                {
+                    R[Op[1]] = FScriptValue::Number(static_cast<double>(R[Op[2]].AsArray().Num()));
+                    break;
+                }
+                VM_LOG_WARNING(FString::Printf(TEXT("Object field '%s' not found, returning nil"), *FieldName));
+                R[Op[1]] = FScriptValue::Nil();
+                break;
+            }
+            case ERegOpCode::REG_SET_FIELD:
+            {
+                InstructionPointer += 6;
+                const FString& FieldName = Constants[ReadRegisterShort(Op + 4)].AsString();
+                VM_LOG_WARNING(FString::Printf(TEXT("Setting object field '%s' not implemented"), *FieldName));
+                FScriptValue Object = R[Op[2]];
+                R[Op[1]] = MoveTemp(Object);
+                break;
+            }
+            
+            default:
+                RuntimeError(FString::Printf(TEXT("Unknown register opcode: %d"), static_cast<int32>(Op[0])));
+                break;
+        }
+        
+        if (HasErrors())
+        {
+            VM_LOG_ERROR(TEXT("VM execution failed"));
+            State = EVMState::Error;
+            return false;
+        }
+        
+        InstructionCount++;
+    }
+    return true;
+}
+
 //=============================================================================
 // Opcode Implementations
 //=============================================================================
 
+template<bool bVerified, bool bWide>
 void FScriptVM::OpConstant()
 {
-    Push(ReadConstant());
+    Push(ReadConstant<bVerified, bWide>());
 }
 
+template<bool bVerified>
 void FScriptVM::OpNil()
 {
     Push(FScriptValue::Nil());
 }
 
+template<bool bVerified>
 void FScriptVM::OpTrue()
 {
     Push(FScriptValue::Bool(true));
 }
 
+template<bool bVerified>
 void FScriptVM::OpFalse()
 {
     Push(FScriptValue::Bool(false));
 }
 
+template<bool bVerified>
 void FScriptVM::OpAdd()
 {
-    FScriptValue B = Pop();
-    FScriptValue A = Pop();
+    FScriptValue B = Pop<bVerified>();
+    FScriptValue A = Pop<bVerified>();
     
     if (A.IsNumber() && B.IsNumber())
     {
@@ -451,10 +1163,11 @@ void FScriptVM::OpAdd()
     }
 }
 
+template<bool bVerified>
 void FScriptVM::OpSubtract()
 {
-    FScriptValue B = Pop();
-    FScriptValue A = Pop();
+    FScriptValue B = Pop<bVerified>();
+    FScriptValue A = Pop<bVerified>();
     
     if (!A.IsNumber() || !B.IsNumber())
     {
@@ -465,10 +1178,11 @@ void FScriptVM::OpSubtract()
     Push(FScriptValue::Number(A.AsNumber() - B.AsNumber()));
 }
 
+template<bool bVerified>
 void FScriptVM::OpMultiply()
 {
-    FScriptValue B = Pop();
-    FScriptValue A = Pop();
+    FScriptValue B = Pop<bVerified>();
+    FScriptValue A = Pop<bVerified>();
     
     if (!A.IsNumber() || !B.IsNumber())
     {
@@ -479,10 +1193,11 @@ void FScriptVM::OpMultiply()
     Push(FScriptValue::Number(A.AsNumber() * B.AsNumber()));
 }
 
+template<bool bVerified>
 void FScriptVM::OpDivide()
 {
-    FScriptValue B = Pop();
-    FScriptValue A = Pop();
+    FScriptValue B = Pop<bVerified>();
+    FScriptValue A = Pop<bVerified>();
     
     if (!A.IsNumber() || !B.IsNumber())
     {
@@ -496,9 +1211,11 @@ void FScriptVM::OpDivide()
         return;
     }
     
-    double AVal = A.AsNumber();
-    double BVal = B.AsNumber();
-    
+    Push(FScriptValue::Number(DivideNumbers(A.AsNumber(), B.AsNumber())));
+}
+
+double FScriptVM::DivideNumbers(double AVal, double BVal)
+{
     // C-style integer division: if both operands are whole numbers, truncate result
     bool AIsInt = FMath::IsNearlyEqual(AVal, FMath::RoundToDouble(AVal));
     bool BIsInt = FMath::IsNearlyEqual(BVal, FMath::RoundToDouble(BVal));
@@ -508,19 +1225,18 @@ void FScriptVM::OpDivide()
         // Integer division - truncate towards zero (C behavior)
         int64 IntA = static_cast<int64>(AVal);
         int64 IntB = static_cast<int64>(BVal);
-        Push(FScriptValue::Number(static_cast<double>(IntA / IntB)));
-    }
-    else
-    {
-        // Float division
-        Push(FScriptValue::Number(AVal / BVal));
+        return static_cast<double>(IntA / IntB);
     }
+    
+    // Float division
+    return AVal / BVal;
 }
 
+template<bool bVerified>
 void FScriptVM::OpModulo()
 {
-    FScriptValue B = Pop();
-    FScriptValue A = Pop();
+    FScriptValue B = Pop<bVerified>();
+    FScriptValue A = Pop<bVerified>();
     
     if (!A.IsNumber() || !B.IsNumber())
     {
@@ -538,9 +1254,10 @@ void FScriptVM::OpModulo()
     Push(FScriptValue::Number(FMath::Fmod(A.AsNumber(), B.AsNumber())));
 }
 
+template<bool bVerified>
 void FScriptVM::OpNegate()
 {
-    FScriptValue Value = Pop();
+    FScriptValue Value = Pop<bVerified>();
     
     if (!Value.IsNumber())
     {
@@ -551,17 +1268,19 @@ void FScriptVM::OpNegate()
     Push(FScriptValue::Number(-Value.AsNumber()));
 }
 
+template<bool bVerified>
 void FScriptVM::OpEqual()
 {
-    FScriptValue B = Pop();
-    FScriptValue A = Pop();
+    FScriptValue B = Pop<bVerified>();
+    FScriptValue A = Pop<bVerified>();
     Push(FScriptValue::Bool(AreEqual(A, B)));
 }
 
+template<bool bVerified>
 void FScriptVM::OpGreater()
 {
-    FScriptValue B = Pop();
-    FScriptValue A = Pop();
+    FScriptValue B = Pop<bVerified>();
+    FScriptValue A = Pop<bVerified>();
     
     if (!A.IsNumber() || !B.IsNumber())
     {
@@ -572,10 +1291,11 @@ void FScriptVM::OpGreater()
     Push(FScriptValue::Bool(A.AsNumber() > B.AsNumber()));
 }
 
+template<bool bVerified>
 void FScriptVM::OpLess()
 {
-    FScriptValue B = Pop();
-    FScriptValue A = Pop();
+    FScriptValue B = Pop<bVerified>();
+    FScriptValue A = Pop<bVerified>();
     
     if (!A.IsNumber() || !B.IsNumber())
     {
@@ -586,30 +1306,83 @@ void FScriptVM::OpLess()
     Push(FScriptValue::Bool(A.AsNumber() < B.AsNumber()));
 }
 
+template<bool bVerified, EOpCode Generic, bool bNegate>
+void FScriptVM::OpNumber()
+{
+    const int32 Top = Stack.Num() - 1;
+    if ((bVerified || Top >= 1) && Stack[Top].IsNumber() && Stack[Top - 1].IsNumber())
+    {
+        FScriptValue& A = Stack[Top - 1];
+        const double B = Stack[Top].NumberValue;
+        switch (Generic)
+        {
+            case EOpCode::OP_ADD:      A.NumberValue += B; break;
+            case EOpCode::OP_SUBTRACT: A.NumberValue -= B; break;
+            case EOpCode::OP_MULTIPLY: A.NumberValue *= B; break;
+            case EOpCode::OP_LESS:
+            {
+                const bool bResult = A.NumberValue < B;
+                A.Type = EValueType::BOOL;
+                A.BoolValue = bResult != bNegate;
+                break;
+            }
+            case EOpCode::OP_GREATER:
+            {
+                const bool bResult = A.NumberValue > B;
+                A.Type = EValueType::BOOL;
+                A.BoolValue = bResult != bNegate;
+                break;
+            }
+            default: break;
+        }
+        Stack.Pop();
+        return;
+    }
+    
+    // Guard failed: exactly what the unspecialized code does, errors included
+    switch (Generic)
+    {
+        case EOpCode::OP_ADD:      OpAdd<bVerified>(); break;
+        case EOpCode::OP_SUBTRACT: OpSubtract<bVerified>(); break;
+        case EOpCode::OP_MULTIPLY: OpMultiply<bVerified>(); break;
+        case EOpCode::OP_LESS:     OpLess<bVerified>(); break;
+        case EOpCode::OP_GREATER:  OpGreater<bVerified>(); break;
+        default: break;
+    }
+    if (bNegate && !HasErrors())
+    {
+        OpNot<bVerified>();
+    }
+}
+
+template<bool bVerified>
 void FScriptVM::OpNot()
 {
-    FScriptValue Value = Pop();
+    FScriptValue Value = Pop<bVerified>();
     Push(FScriptValue::Bool(!IsTruthy(Value)));
 }
 
+template<bool bVerified>
 void FScriptVM::OpAnd()
 {
-    FScriptValue B = Pop();
-    FScriptValue A = Pop();
+    FScriptValue B = Pop<bVerified>();
+    FScriptValue A = Pop<bVerified>();
     Push(FScriptValue::Bool(IsTruthy(A) && IsTruthy(B)));
 }
 
+template<bool bVerified>
 void FScriptVM::OpOr()
 {
-    FScriptValue B = Pop();
-    FScriptValue A = Pop();
+    FScriptValue B = Pop<bVerified>();
+    FScriptValue A = Pop<bVerified>();
     Push(FScriptValue::Bool(IsTruthy(A) || IsTruthy(B)));
 }
 
+template<bool bVerified>
 void FScriptVM::OpBitAnd()
 {
-    FScriptValue B = Pop();
-    FScriptValue A = Pop();
+    FScriptValue B = Pop<bVerified>();
+    FScriptValue A = Pop<bVerified>();
     
     if (!A.IsNumber() || !B.IsNumber())
     {
@@ -622,10 +1395,11 @@ void FScriptVM::OpBitAnd()
     Push(FScriptValue::Number(static_cast<double>(IntA & IntB)));
 }
 
+template<bool bVerified>
 void FScriptVM::OpBitOr()
 {
-    FScriptValue B = Pop();
-    FScriptValue A = Pop();
+    FScriptValue B = Pop<bVerified>();
+    FScriptValue A = Pop<bVerified>();
     
     if (!A.IsNumber() || !B.IsNumber())
     {
@@ -638,10 +1412,11 @@ void FScriptVM::OpBitOr()
     Push(FScriptValue::Number(static_cast<double>(IntA | IntB)));
 }
 
+template<bool bVerified>
 void FScriptVM::OpBitXor()
 {
-    FScriptValue B = Pop();
-    FScriptValue A = Pop();
+    FScriptValue B = Pop<bVerified>();
+    FScriptValue A = Pop<bVerified>();
     
     if (!A.IsNumber() || !B.IsNumber())
     {
@@ -654,9 +1429,10 @@ void FScriptVM::OpBitXor()
     Push(FScriptValue::Number(static_cast<double>(IntA ^ IntB)));
 }
 
+template<bool bVerified>
 void FScriptVM::OpBitNot()
 {
-    FScriptValue Value = Pop();
+    FScriptValue Value = Pop<bVerified>();
     
     if (!Value.IsNumber())
     {
@@ -668,13 +1444,14 @@ void FScriptVM::OpBitNot()
     Push(FScriptValue::Number(static_cast<double>(~IntValue)));
 }
 
+template<bool bVerified, bool bWide>
 void FScriptVM::OpGetLocal()
 {
-    uint8 Slot = ReadByte();
+    const int32 Slot = bWide ? ReadShort<bVerified>() : ReadByte<bVerified>();
     
     int32 StackIndex = CallFrames.Num() > 0 ? CallFrames.Last().StackBase + Slot : Slot;
     
-    if (StackIndex >= Stack.Num())
+    if (!bVerified && StackIndex >= Stack.Num())
     {
         RuntimeError(FString::Printf(TEXT("Invalid local variable slot: %d"), Slot));
         return;
@@ -685,47 +1462,50 @@ void FScriptVM::OpGetLocal()
     Push(Value);
 }
 
+template<bool bVerified, bool bWide>
 void FScriptVM::OpSetLocal()
 {
-    uint8 Slot = ReadByte();
+    const int32 Slot = bWide ? ReadShort<bVerified>() : ReadByte<bVerified>();
     
     int32 StackIndex = CallFrames.Num() > 0 ? CallFrames.Last().StackBase + Slot : Slot;
     
-    if (StackIndex >= Stack.Num())
+    if (!bVerified && StackIndex >= Stack.Num())
     {
         RuntimeError(FString::Printf(TEXT("Invalid local variable slot: %d"), Slot));
         return;
     }
     
     // Copy value from stack top BEFORE any array modification
-    FScriptValue Value = Peek(0);
+    FScriptValue Value = Peek<bVerified>(0);
     Stack[StackIndex] = Value; // Don't pop - assignment is an expression
 }
 
+template<bool bVerified, bool bWide>
 void FScriptVM::OpDefineGlobal()
 {
     // Read global variable name from constant pool
-    FScriptValue NameValue = ReadConstant();
-    if (!NameValue.IsString())
+    FScriptValue NameValue = ReadConstant<bVerified, bWide>();
+    if (!bVerified && !NameValue.IsString())
     {
         RuntimeError(TEXT("Global variable name must be a string"));
         return;
     }
     
     FString VarName = NameValue.AsString();
-    FScriptValue Value = Pop(); // Get initialization value from stack
+    FScriptValue Value = Pop<bVerified>(); // Get initialization value from stack
     
     // Store in globals table
-    Globals.Add(VarName, Value);
+    MutableGlobals().Add(VarName, Value);
     
     VM_LOG(FString::Printf(TEXT("Defined global variable: %s = %s"), *VarName, *Value.ToString()));
 }
 
+template<bool bVerified, bool bWide>
 void FScriptVM::OpGetGlobal()
 {
     // Read global variable name from constant pool
-    FScriptValue NameValue = ReadConstant();
-    if (!NameValue.IsString())
+    FScriptValue NameValue = ReadConstant<bVerified, bWide>();
+    if (!bVerified && !NameValue.IsString())
     {
         RuntimeError(TEXT("Global variable name must be a string"));
         return;
@@ -734,7 +1514,7 @@ void FScriptVM::OpGetGlobal()
     FString VarName = NameValue.AsString();
     
     // Lookup in globals table
-    FScriptValue* ValuePtr = Globals.Find(VarName);
+    const FScriptValue* ValuePtr = Globals->Find(VarName);
     if (ValuePtr)
     {
         Push(*ValuePtr);
@@ -746,11 +1526,12 @@ void FScriptVM::OpGetGlobal()
     }
 }
 
+template<bool bVerified, bool bWide>
 void FScriptVM::OpSetGlobal()
 {
     // Read global variable name from constant pool
-    FScriptValue NameValue = ReadConstant();
-    if (!NameValue.IsString())
+    FScriptValue NameValue = ReadConstant<bVerified, bWide>();
+    if (!bVerified && !NameValue.IsString())
     {
         RuntimeError(TEXT("Global variable name must be a string"));
         return;
@@ -759,69 +1540,259 @@ void FScriptVM::OpSetGlobal()
     FString VarName = NameValue.AsString();
     
     // Check if variable exists
-    if (!Globals.Contains(VarName))
+    if (!Globals->Contains(VarName))
     {
         RuntimeError(FString::Printf(TEXT("Cannot assign to undefined global variable: %s"), *VarName));
         return;
     }
     
-    // Set value (peek, don't pop - assignment is an expression)
-    FScriptValue Value = Peek(0);
-    Globals[VarName] = Value;
-    
-    VM_LOG(FString::Printf(TEXT("Set global variable: %s = %s"), *VarName, *Value.ToString()));
-}
-
-void FScriptVM::OpJump()
-{
-    uint16 Offset = ReadShort();
-    InstructionPointer += Offset;
-}
-
-void FScriptVM::OpJumpIfFalse()
-{
-    uint16 Offset = ReadShort();
-    if (!IsTruthy(Peek(0)))
+    // Set value (peek, don't pop - assignment is an expression)
+    FScriptValue Value = Peek<bVerified>(0);
+    MutableGlobals()[VarName] = Value;
+    
+    VM_LOG(FString::Printf(TEXT("Set global variable: %s = %s"), *VarName, *Value.ToString()));
+}
+
+template<bool bVerified, bool bWide>
+void FScriptVM::OpJump()
+{
+    const uint32 Offset = ReadJumpOffset<bVerified, bWide>(false);
+    InstructionPointer += Offset;
+}
+
+template<bool bVerified, bool bWide>
+void FScriptVM::OpJumpIfFalse()
+{
+    const uint32 Offset = ReadJumpOffset<bVerified, bWide>(false);
+    if (!IsTruthy(Peek<bVerified>(0)))
+    {
+        InstructionPointer += Offset;
+    }
+}
+
+template<bool bVerified, bool bWide>
+void FScriptVM::OpLoop()
+{
+    const uint32 Offset = ReadJumpOffset<bVerified, bWide>(true);
+    InstructionPointer -= Offset;
+}
+
+template<bool bVerified>
+void FScriptVM::OpForPrep()
+{
+    uint8 Slot = ReadByte<bVerified>();
+    uint8 Flags = ReadByte<bVerified>();
+    uint16 Offset = ReadShort<bVerified>();
+    
+    int32 StackIndex = CallFrames.Num() > 0 ? CallFrames.Last().StackBase + Slot : Slot;
+    
+    if (!bVerified && StackIndex + 2 >= Stack.Num())
+    {
+        RuntimeError(FString::Printf(TEXT("Invalid loop variable slot: %d"), Slot));
+        return;
+    }
+    
+    // Checked once here - OP_FOR_LOOP is the only writer of the counter afterwards
+    const FScriptValue& Counter = Stack[StackIndex];
+    const FScriptValue& Limit = Stack[StackIndex + 1];
+    const FScriptValue& Step = Stack[StackIndex + 2];
+    if (!Counter.IsNumber() || !Limit.IsNumber() || !Step.IsNumber())
+    {
+        RuntimeError(TEXT("Operands must be numbers"));
+        return;
+    }
+    
+    if (!IsInForRange(Counter.AsNumber(), Limit.AsNumber(), Step.AsNumber(), Flags))
+    {
+        InstructionPointer += Offset;
+    }
+}
+
+template<bool bVerified>
+void FScriptVM::OpForLoop()
+{
+    uint8 Slot = ReadByte<bVerified>();
+    uint8 Flags = ReadByte<bVerified>();
+    uint16 Offset = ReadShort<bVerified>();
+    
+    int32 StackIndex = CallFrames.Num() > 0 ? CallFrames.Last().StackBase + Slot : Slot;
+    
+    if (!bVerified && StackIndex + 2 >= Stack.Num())
+    {
+        RuntimeError(FString::Printf(TEXT("Invalid loop variable slot: %d"), Slot));
+        return;
+    }
+    
+    const double Step = Stack[StackIndex + 2].AsNumber();
+    const double Counter = Stack[StackIndex].AsNumber() + Step;
+    Stack[StackIndex] = FScriptValue::Number(Counter);
+    
+    if (IsInForRange(Counter, Stack[StackIndex + 1].AsNumber(), Step, Flags))
+    {
+        InstructionPointer -= Offset;
+    }
+}
+
+template<bool bVerified, bool bWide>
+void FScriptVM::OpForEach()
+{
+    const int32 Slot = bWide ? ReadShort<bVerified>() : ReadByte<bVerified>();
+    const uint32 Offset = ReadJumpOffset<bVerified, bWide>(false);
+    
+    int32 StackIndex = CallFrames.Num() > 0 ? CallFrames.Last().StackBase + Slot : Slot;
+    
+    if (!bVerified && StackIndex + 2 >= Stack.Num())
+    {
+        RuntimeError(FString::Printf(TEXT("Invalid loop variable slot: %d"), Slot));
+        return;
+    }
+    
+    const FScriptValue& Array = Stack[StackIndex];
+    if (!Array.IsArray())
+    {
+        RuntimeError(TEXT("'for (x in ...)' requires an array"));
+        return;
+    }
+    
+    // The index slot starts at -1 and is advanced before the element is loaded
+    const int32 Index = static_cast<int32>(Stack[StackIndex + 1].AsNumber()) + 1;
+    const TArray<FScriptValue>& Elements = Array.AsArray();
+    if (Index >= Elements.Num())
+    {
+        InstructionPointer += Offset;
+        return;
+    }
+    
+    Stack[StackIndex + 1] = FScriptValue::Number(static_cast<double>(Index));
+    Stack[StackIndex + 2] = Elements[Index];
+}
+
+template<bool bVerified>
+void FScriptVM::OpSwitchTable()
+{
+    const uint32 LowHigh = ReadShort<bVerified>();
+    const int32 Low = (int32)((LowHigh << 16) | ReadShort<bVerified>());
+    const int32 Count = ReadShort<bVerified>();
+    const uint16 Default = ReadShort<bVerified>();
+    const int32 Cases = InstructionPointer;
+    const int32 Next = Cases + Count * 2;
+    
+    if (!bVerified && Next > CurrentBytecode->Code.Num())
+    {
+        RuntimeError(TEXT("Unexpected end of bytecode"));
+        return;
+    }
+    
+    const FScriptValue Value = Pop<bVerified>();
+    
+    // Rounded to the nearest case so a value OP_EQUAL would match still finds it
+    int32 Jump = Default;
+    if (Value.IsNumber())
+    {
+        const double Index = FMath::RoundToDouble(Value.AsNumber() - Low);
+        if (Index >= 0.0 && Index < Count && FMath::IsNearlyEqual(Value.AsNumber(), Low + Index, 0.0001))
+        {
+            const uint8* Entry = &CurrentBytecode->Code[Cases + (int32)Index * 2];
+            Jump = (Entry[0] << 8) | Entry[1];
+        }
+    }
+    InstructionPointer = Next + Jump;
+}
+
+template<bool bVerified>
+void FScriptVM::OpSwitchLookup()
+{
+    const uint16 KeysIndex = ReadShort<bVerified>();
+    const int32 Count = ReadShort<bVerified>();
+    const uint16 Default = ReadShort<bVerified>();
+    const int32 Cases = InstructionPointer;
+    const int32 Next = Cases + Count * 2;
+    const TArray<FScriptValue>& Constants = CurrentBytecode->Constants;
+    
+    if (!bVerified && (Next > CurrentBytecode->Code.Num() || !Constants.IsValidIndex(KeysIndex) ||
+        !Constants[KeysIndex].IsArray() || Constants[KeysIndex].AsArray().Num() != Count))
+    {
+        RuntimeError(TEXT("Invalid switch table"));
+        return;
+    }
+    
+    const FScriptValue Value = Pop<bVerified>();
+    const TArray<FScriptValue>& Keys = Constants[KeysIndex].AsArray();
+    
+    // Lower bound over the sorted keys, then one equality test on the candidate
+    int32 First = 0;
+    int32 Last = Count;
+    if (Value.IsNumber() && Count > 0 && Keys[0].IsNumber())
+    {
+        const double Number = Value.AsNumber() - 0.0001;
+        while (First < Last)
+        {
+            const int32 Mid = (First + Last) / 2;
+            if (Keys[Mid].AsNumber() < Number) { First = Mid + 1; } else { Last = Mid; }
+        }
+    }
+    else if (Value.IsString() && Count > 0 && Keys[0].IsString())
+    {
+        while (First < Last)
+        {
+            const int32 Mid = (First + Last) / 2;
+            if (Keys[Mid].AsString().Compare(Value.AsString(), ESearchCase::CaseSensitive) < 0) { First = Mid + 1; } else { Last = Mid; }
+        }
+    }
+    else
+    {
+        First = Count;
+    }
+    
+    int32 Jump = Default;
+    if (First < Count && AreEqual(Keys[First], Value))
     {
-        InstructionPointer += Offset;
+        const uint8* Entry = &CurrentBytecode->Code[Cases + First * 2];
+        Jump = (Entry[0] << 8) | Entry[1];
     }
+    InstructionPointer = Next + Jump;
 }
 
-void FScriptVM::OpLoop()
-{
-    uint16 Offset = ReadShort();
-    InstructionPointer -= Offset;
-}
-
+template<bool bVerified>
 void FScriptVM::OpCall()
 {
-    uint8 ArgCount = ReadByte();
-    uint16 FuncIndex = ReadShort();
+    uint8 ArgCount = ReadByte<bVerified>();
+    uint16 FuncIndex = ReadShort<bVerified>();
+    
+    // Unverified code may claim more arguments than the caller has pushed
+    const int32 CallerBase = CallFrames.Num() > 0 ? CallFrames.Last().StackBase : 0;
+    if (!bVerified && ArgCount > Stack.Num() - CallerBase)
+    {
+        RuntimeError(FString::Printf(TEXT("Call with %d argument(s), but only %d value(s) on the stack"),
+            ArgCount, Stack.Num() - CallerBase));
+        return;
+    }
     
     // Validate function index
-    if (!FunctionTable.IsValidIndex(FuncIndex))
+    const TArray<FFunctionInfo>& Functions = Program->GetFunctions();
+    if (!bVerified && !Functions.IsValidIndex(FuncIndex))
     {
         RuntimeError(FString::Printf(TEXT("Invalid function index: %d"), FuncIndex));
         // Pop arguments to clean up stack
         for (int32 i = 0; i < ArgCount; ++i)
         {
-            Pop();
+            Pop<bVerified>();
         }
         Push(FScriptValue::Nil());
         return;
     }
     
-    FFunctionInfo& FuncInfo = FunctionTable[FuncIndex];
+    const FFunctionInfo& FuncInfo = Functions[FuncIndex];
     
     // Check argument count matches function arity
-    if (ArgCount != FuncInfo.Arity)
+    if (!bVerified && ArgCount != FuncInfo.Arity)
     {
         RuntimeError(FString::Printf(TEXT("Argument count mismatch for function '%s': expected %d, got %d"), 
             *FuncInfo.Name, FuncInfo.Arity, ArgCount));
         // Pop arguments to clean up stack
         for (int32 i = 0; i < ArgCount; ++i)
         {
-            Pop();
+            Pop<bVerified>();
         }
         Push(FScriptValue::Nil());
         return;
@@ -837,7 +1808,7 @@ void FScriptVM::OpCall()
         // Pop arguments to clean up stack
         for (int32 i = 0; i < ArgCount; ++i)
         {
-            Pop();
+            Pop<bVerified>();
         }
         Push(FScriptValue::Nil());
         return;
@@ -853,32 +1824,70 @@ void FScriptVM::OpCall()
     CallFrames.Add(Frame);
     
     // Jump to function
-    InstructionPointer = FuncInfo.Address;
+    EnterFunction(CallFrames.Last(), FuncInfo);
+}
+
+template<bool bVerified>
+void FScriptVM::OpTailCall()
+{
+    // Outside a function there is no frame to reuse - the compiler follows
+    // every tail call with OP_RETURN, so a plain call gives the same result
+    if (CallFrames.Num() == 0)
+    {
+        OpCall<bVerified>();
+        return;
+    }
+    
+    uint8 ArgCount = ReadByte<bVerified>();
+    uint16 FuncIndex = ReadShort<bVerified>();
+    
+    const TArray<FFunctionInfo>& Functions = Program->GetFunctions();
+    if (!bVerified && (!Functions.IsValidIndex(FuncIndex) || ArgCount != Functions[FuncIndex].Arity ||
+        ArgCount > Stack.Num() - CallFrames.Last().StackBase))
+    {
+        RuntimeError(FString::Printf(TEXT("Invalid tail call: function %d with %d argument(s)"), FuncIndex, ArgCount));
+        return;
+    }
+    
+    const FFunctionInfo& FuncInfo = Functions[FuncIndex];
+    FCallFrame& Frame = CallFrames.Last();
+    
+    // Slide the new arguments down over the current arguments and locals.
+    // The frame keeps its return address, so the callee returns straight to our caller.
+    const int32 ArgStart = Stack.Num() - ArgCount;
+    for (int32 i = 0; i < ArgCount; ++i)
+    {
+        Stack[Frame.StackBase + i] = MoveTemp(Stack[ArgStart + i]);
+    }
+    Stack.SetNum(Frame.StackBase + ArgCount);
+    
+    Frame.FunctionName = FuncInfo.Name;
+    EnterFunction(Frame, FuncInfo);
 }
 
+template<bool bVerified>
 void FScriptVM::OpCallNative()
 {
-    uint8 ArgCount = ReadByte();
-    uint16 NameIndex = ReadShort();
+    const uint8 ArgByte = ReadByte<bVerified>();
+    const uint8 ArgCount = ArgByte & NATIVE_CALL_ARGC_MASK;
+    const bool bArgsChecked = (ArgByte & NATIVE_CALL_ARGS_CHECKED) != 0;
+    uint16 NameIndex = ReadShort<bVerified>();
     
-    if (NameIndex >= CurrentBytecode->Constants.Num())
+    if (!bVerified && NameIndex >= CurrentBytecode->Constants.Num())
     {
         RuntimeError(TEXT("Invalid native function name index"));
         return;
     }
     
-    FString FuncName = CurrentBytecode->Constants[NameIndex].AsString();
-    
     // Pop arguments
     TArray<FScriptValue> Args;
     Args.Reserve(ArgCount);
     for (int32 i = 0; i < ArgCount; ++i)
     {
-        Args.Insert(Pop(), 0); // Insert at front to preserve order
+        Args.Insert(Pop<bVerified>(), 0); // Insert at front to preserve order
     }
     
-    // Call native function
-    FNativeFunction* NativeFunc = NativeFunctions.Find(FuncName);
+    const FNativeFunction* NativeFunc = ResolveNative(NameIndex, ArgCount, bArgsChecked);
     if (NativeFunc)
     {
         // Pass 'this' (VM pointer) to the native function
@@ -893,48 +1902,50 @@ void FScriptVM::OpCallNative()
     }
     else
     {
-        VM_LOG_WARNING(FString::Printf(TEXT("Native function '%s' not found - pushing nil"), *FuncName));
+        VM_LOG_WARNING(FString::Printf(TEXT("Native function '%s' not found - pushing nil"),
+            *CurrentBytecode->Constants[NameIndex].AsString()));
         Push(FScriptValue::Nil());
     }
 }
 
+const FNativeFunction* FScriptVM::ResolveNative(uint16 NameIndex, int32 ArgCount, bool bArgsChecked) const
+{
+    // Resolved against the constant slot when the program was built,
+    // falling back to natives registered on this instance afterwards
+    const FNativeFunction* NativeFunc = nullptr;
+    if (const FNativeFunctionEntry* Entry = Program->GetNativeEntry(NameIndex))
+    {
+        // Call sites the compiler type-checked skip the binding's argument checks.
+        // The arity must still match, since the unchecked entry indexes Args directly.
+        if (bArgsChecked && Entry->UncheckedFunction && Entry->Decl.ParamTypes.Num() == ArgCount)
+        {
+            NativeFunc = &Entry->UncheckedFunction;
+        }
+        else if (Entry->Function)
+        {
+            NativeFunc = &Entry->Function;
+        }
+    }
+    if (!NativeFunc && NativeFunctions.Num() > 0)
+    {
+        NativeFunc = NativeFunctions.Find(CurrentBytecode->Constants[NameIndex].AsString());
+    }
+    return NativeFunc;
+}
+
+template<bool bVerified>
 void FScriptVM::OpReturn()
 {
     // At this point, stack has: [Frame.StackBase: args...] [locals...] [return value]
-    FScriptValue Result = Pop();
+    FScriptValue Result = Pop<bVerified>();
     
     if (CallFrames.Num() > 0)
     {
         // Return from function
-        FCallFrame Frame = CallFrames.Last();
-        CallFrames.Pop();
-        
         VM_LOG(FString::Printf(TEXT("OpReturn: Frame.StackBase=%d, Stack.Num()=%d, Result=%s"),
-            Frame.StackBase, Stack.Num(), *Result.ToString()));
-        
-        // Calculate how many values to remove (everything above Frame.StackBase)
-        // This includes all arguments and local variables created during function execution
-        int32 ValuesToPop = Stack.Num() - Frame.StackBase;
-        
-        VM_LOG(FString::Printf(TEXT("OpReturn: Popping %d values from stack"), ValuesToPop));
-        
-        // Pop all values from this frame (arguments and locals)
-        for (int32 i = 0; i < ValuesToPop; ++i)
-        {
-            if (Stack.Num() > Frame.StackBase)
-            {
-                FScriptValue Popped = Stack.Pop();
-                VM_LOG(FString::Printf(TEXT("OpReturn: Popped value %d: %s"), i, *Popped.ToString()));
-            }
-        }
-        
-        VM_LOG(FString::Printf(TEXT("OpReturn: Pushing result %s"), *Result.ToString()));
-        
-        // Push the return value where the arguments were
-        Push(Result);
+            CallFrames.Last().StackBase, Stack.Num(), *Result.ToString()));
         
-        // Restore instruction pointer to after the CALL instruction
-        InstructionPointer = Frame.ReturnAddress;
+        ReturnFromFrame(Result);
     }
     else
     {
@@ -944,9 +1955,10 @@ void FScriptVM::OpReturn()
     }
 }
 
+template<bool bVerified>
 void FScriptVM::OpCastInt()
 {
-    FScriptValue Value = Pop();
+    FScriptValue Value = Pop<bVerified>();
     
     if (Value.IsNumber())
     {
@@ -963,9 +1975,10 @@ void FScriptVM::OpCastInt()
     }
 }
 
+template<bool bVerified>
 void FScriptVM::OpCastFloat()
 {
-    FScriptValue Value = Pop();
+    FScriptValue Value = Pop<bVerified>();
     
     if (Value.IsNumber())
     {
@@ -982,34 +1995,39 @@ void FScriptVM::OpCastFloat()
     }
 }
 
+template<bool bVerified>
 void FScriptVM::OpCastString()
 {
-    FScriptValue Value = Pop();
+    FScriptValue Value = Pop<bVerified>();
     Push(FScriptValue::String(Value.ToString()));
 }
 
+template<bool bVerified>
 void FScriptVM::OpPop()
 {
-    Pop();
+    Pop<bVerified>();
 }
 
+template<bool bVerified>
 void FScriptVM::OpPrint()
 {
-    FScriptValue Value = Pop();
+    FScriptValue Value = Pop<bVerified>();
     VM_LOG(FString::Printf(TEXT("[PRINT] %s"), *Value.ToString()));
 }
 
+template<bool bVerified>
 void FScriptVM::OpNotEqual()
 {
-    FScriptValue B = Pop();
-    FScriptValue A = Pop();
+    FScriptValue B = Pop<bVerified>();
+    FScriptValue A = Pop<bVerified>();
     Push(FScriptValue::Bool(!AreEqual(A, B)));
 }
 
+template<bool bVerified>
 void FScriptVM::OpGreaterEqual()
 {
-    FScriptValue B = Pop();
-    FScriptValue A = Pop();
+    FScriptValue B = Pop<bVerified>();
+    FScriptValue A = Pop<bVerified>();
     
     if (!A.IsNumber() || !B.IsNumber())
     {
@@ -1020,10 +2038,11 @@ void FScriptVM::OpGreaterEqual()
     Push(FScriptValue::Bool(A.AsNumber() >= B.AsNumber()));
 }
 
+template<bool bVerified>
 void FScriptVM::OpLessEqual()
 {
-    FScriptValue B = Pop();
-    FScriptValue A = Pop();
+    FScriptValue B = Pop<bVerified>();
+    FScriptValue A = Pop<bVerified>();
     
     if (!A.IsNumber() || !B.IsNumber())
     {
@@ -1034,10 +2053,11 @@ void FScriptVM::OpLessEqual()
     Push(FScriptValue::Bool(A.AsNumber() <= B.AsNumber()));
 }
 
+template<bool bVerified>
 void FScriptVM::OpCreateArray()
 {
     // This opcode should be followed by a byte indicating the number of elements to create the array from
-    uint8 ElementCount = ReadByte();
+    uint8 ElementCount = ReadByte<bVerified>();
     
     TArray<FScriptValue> Elements;
     Elements.Reserve(ElementCount);
@@ -1045,17 +2065,18 @@ void FScriptVM::OpCreateArray()
     // Pop elements in reverse order (they were pushed in order)
     for (int32 i = 0; i < ElementCount; ++i)
     {
-        Elements.Insert(Pop(), 0);
+        Elements.Insert(Pop<bVerified>(), 0);
     }
     
     Push(FScriptValue::Array(Elements));
 }
 
+template<bool bVerified>
 void FScriptVM::OpGetElement()
 {
     // Index is on top of stack, followed by the array
-    FScriptValue Index = Pop();
-    FScriptValue Array = Pop();
+    FScriptValue Index = Pop<bVerified>();
+    FScriptValue Array = Pop<bVerified>();
     
     if (!Array.IsArray())
     {
@@ -1084,12 +2105,13 @@ void FScriptVM::OpGetElement()
     Push(ArrayElements[Idx]);
 }
 
+template<bool bVerified>
 void FScriptVM::OpSetElement()
 {
     // Value to set is on top, followed by index, then array
-    FScriptValue Value = Pop();      // Value to set
-    FScriptValue Index = Pop();      // Index
-    FScriptValue Array = Pop();      // Array
+    FScriptValue Value = Pop<bVerified>();      // Value to set
+    FScriptValue Index = Pop<bVerified>();      // Index
+    FScriptValue Array = Pop<bVerified>();      // Array
     
     if (!Array.IsArray())
     {
@@ -1119,10 +2141,11 @@ void FScriptVM::OpSetElement()
     Push(FScriptValue::Array(ArrayElements));
 }
 
+template<bool bVerified>
 void FScriptVM::OpDuplicate()
 {
     // Duplicate the top value on the stack
-    if (Stack.Num() == 0)
+    if (!bVerified && Stack.Num() == 0)
     {
         RuntimeError(TEXT("Stack underflow - cannot duplicate"));
         return;
@@ -1132,19 +2155,20 @@ void FScriptVM::OpDuplicate()
     Push(Value);
 }
 
+template<bool bVerified>
 void FScriptVM::OpGetField()
 {
     // Field name is encoded as a 16-bit constant index in the bytecode
-    uint16 NameIndex = ReadShort();
+    uint16 NameIndex = ReadShort<bVerified>();
     
-    if (NameIndex >= CurrentBytecode->Constants.Num())
+    if (!bVerified && NameIndex >= CurrentBytecode->Constants.Num())
     {
         RuntimeError(FString::Printf(TEXT("Invalid field name index: %d"), NameIndex));
         return;
     }
     
     FString FieldName = CurrentBytecode->Constants[NameIndex].AsString();
-    FScriptValue Object = Pop();
+    FScriptValue Object = Pop<bVerified>();
     
     // Handle array properties
     if (Object.IsArray())
@@ -1163,20 +2187,21 @@ void FScriptVM::OpGetField()
     Push(FScriptValue::Nil());
 }
 
+template<bool bVerified>
 void FScriptVM::OpSetField()
 {
     // Field name is encoded as a 16-bit constant index in the bytecode
-    uint16 NameIndex = ReadShort();
+    uint16 NameIndex = ReadShort<bVerified>();
     
-    if (NameIndex >= CurrentBytecode->Constants.Num())
+    if (!bVerified && NameIndex >= CurrentBytecode->Constants.Num())
     {
         RuntimeError(FString::Printf(TEXT("Invalid field name index: %d"), NameIndex));
         return;
     }
     
     FString FieldName = CurrentBytecode->Constants[NameIndex].AsString();
-    FScriptValue Value = Pop();  // The value to assign
-    FScriptValue Object = Pop(); // The object to modify
+    FScriptValue Value = Pop<bVerified>();  // The value to assign
+    FScriptValue Object = Pop<bVerified>(); // The object to modify
     
     // For now, make fields read-only by default
     // In a full implementation, we would handle struct/object field assignment
@@ -1189,9 +2214,27 @@ void FScriptVM::OpSetField()
 // Helper Methods
 //=============================================================================
 
+FScriptGlobalTable& FScriptVM::MutableGlobals()
+{
+    // A snapshot or forked VM still references this table - give ourselves a private copy
+    if (!Globals.IsUnique())
+    {
+        Globals = MakeShared<FScriptGlobalTable>(*Globals);
+    }
+    return *Globals;
+}
+
+void FScriptVM::SetProgram(TSharedPtr<const FScriptProgramImage> InProgram)
+{
+    Program = InProgram;
+    CurrentBytecode = Program.IsValid() ? &Program->GetBytecode() : nullptr;
+    bUncheckedDispatch = Program.IsValid() && Program->IsVerified();
+}
+
+template<bool bVerified>
 uint8 FScriptVM::ReadByte()
 {
-    if (InstructionPointer >= CurrentBytecode->Code.Num())
+    if (!bVerified && InstructionPointer >= CurrentBytecode->Code.Num())
     {
         RuntimeError(TEXT("Unexpected end of bytecode"));
         return 0;
@@ -1199,9 +2242,10 @@ uint8 FScriptVM::ReadByte()
     return CurrentBytecode->Code[InstructionPointer++];
 }
 
+template<bool bVerified>
 uint16 FScriptVM::ReadShort()
 {
-    if (InstructionPointer + 1 >= CurrentBytecode->Code.Num())
+    if (!bVerified && InstructionPointer + 1 >= CurrentBytecode->Code.Num())
     {
         RuntimeError(TEXT("Unexpected end of bytecode"));
         return 0;
@@ -1211,10 +2255,45 @@ uint16 FScriptVM::ReadShort()
     return (High << 8) | Low;
 }
 
+template<bool bVerified>
+uint32 FScriptVM::ReadLong()
+{
+    if (!bVerified && InstructionPointer + 3 >= CurrentBytecode->Code.Num())
+    {
+        RuntimeError(TEXT("Unexpected end of bytecode"));
+        return 0;
+    }
+    const uint8* Bytes = &CurrentBytecode->Code[InstructionPointer];
+    InstructionPointer += 4;
+    return ((uint32)Bytes[0] << 24) | ((uint32)Bytes[1] << 16) | ((uint32)Bytes[2] << 8) | Bytes[3];
+}
+
+template<bool bVerified, bool bWide>
+uint32 FScriptVM::ReadJumpOffset(bool bBackward)
+{
+    if (!bWide)
+    {
+        return ReadShort<bVerified>();
+    }
+    const uint32 Offset = ReadLong<bVerified>();
+    const uint32 Limit = bBackward ? InstructionPointer : CurrentBytecode->Code.Num() - InstructionPointer;
+    if (!bVerified && Offset > Limit)
+    {
+        RuntimeError(FString::Printf(TEXT("Jump offset %u out of range"), Offset));
+        return 0;
+    }
+    return Offset;
+}
+
+template<bool bVerified, bool bWide>
 FScriptValue FScriptVM::ReadConstant()
 {
-    uint8 Index = ReadByte();
-    if (Index >= CurrentBytecode->Constants.Num())
+    int32 Index = ReadByte<bVerified>();
+    if (bWide)
+    {
+        Index = (Index << 16) | ReadShort<bVerified>();
+    }
+    if (!bVerified && Index >= CurrentBytecode->Constants.Num())
     {
         RuntimeError(FString::Printf(TEXT("Invalid constant index: %d"), Index));
         return FScriptValue::Nil();
@@ -1277,6 +2356,416 @@ void FScriptVM::DumpStack() const
     }
 }
 
+//=============================================================================
+// Snapshots
+//=============================================================================
+
+// Magic number for snapshot blobs: "SVS1" (Script VM Snapshot v1)
+static const uint32 SNAPSHOT_MAGIC = 0x31535653;
+// 2: call frames record whether they run register code
+static const int32 SNAPSHOT_VERSION = 2;
+
+// Function whose register code starts at Address, and where that code ends
+static const FFunctionInfo* FindRegisterFunction(const FBytecodeChunk& Chunk, int32 Address, int32& OutEnd)
+{
+    const FFunctionInfo* Found = nullptr;
+    OutEnd = Chunk.RegisterCode.Num();
+    for (const FFunctionInfo& Function : Chunk.Functions)
+    {
+        if (Function.RegisterAddress == Address && Address != INDEX_NONE)
+        {
+            Found = &Function;
+        }
+        else if (Function.RegisterAddress > Address && Function.RegisterAddress < OutEnd)
+        {
+            OutEnd = Function.RegisterAddress;
+        }
+    }
+    return Found;
+}
+
+// Offset is an instruction of the register function starting at FunctionAddress - a snapshot
+// must never resume the register loop in the middle of an instruction
+static bool IsRegisterInstruction(const FBytecodeChunk& Chunk, int32 FunctionAddress, int32 Offset)
+{
+    int32 End = 0;
+    if (!FindRegisterFunction(Chunk, FunctionAddress, End))
+    {
+        return false;
+    }
+    int32 Position = FunctionAddress;
+    while (Position < Offset)
+    {
+        const int32 Size = GetRegisterInstructionSize(Chunk.RegisterCode, Position, End);
+        if (Size == 0)
+        {
+            return false;
+        }
+        Position += Size;
+    }
+    return Position == Offset && Offset < End;
+}
+
+static TMap<FString, FVMSnapshotExtension>& GetSnapshotExtensions()
+{
+    static TMap<FString, FVMSnapshotExtension> Extensions;
+    return Extensions;
+}
+
+void FScriptVM::RegisterSnapshotExtension(const FString& Name, const FVMSnapshotExtension& Extension)
+{
+    GetSnapshotExtensions().Add(Name, Extension);
+}
+
+void FScriptVM::UnregisterSnapshotExtension(const FString& Name)
+{
+    GetSnapshotExtensions().Remove(Name);
+}
+
+void FScriptVM::ReleaseExtensionState(const FScriptVM& VM)
+{
+    for (const auto& Pair : GetSnapshotExtensions())
+    {
+        if (Pair.Value.Release)
+        {
+            Pair.Value.Release(VM);
+        }
+    }
+}
+
+bool FScriptVM::CaptureSnapshot(FVMSnapshot& OutSnapshot) const
+{
+    if (State == EVMState::Running)
+    {
+        VM_LOG_WARNING(TEXT("CaptureSnapshot: VM is executing - snapshot must be taken while paused or stopped"));
+        return false;
+    }
+    
+    OutSnapshot.State = State;
+    OutSnapshot.InstructionPointer = InstructionPointer;
+    OutSnapshot.InstructionCount = InstructionCount;
+    OutSnapshot.Stack = Stack;
+    OutSnapshot.CallFrames = CallFrames;
+    OutSnapshot.Globals = Globals; // Shared - see MutableGlobals()
+    OutSnapshot.BytecodeSignature = Program.IsValid() ? Program->GetSignature() : FString();
+    
+    OutSnapshot.Extensions.Empty();
+    for (const auto& Pair : GetSnapshotExtensions())
+    {
+        if (Pair.Value.Save)
+        {
+            TArray<uint8> Data;
+            Pair.Value.Save(*this, Data);
+            OutSnapshot.Extensions.Add(Pair.Key, Data);
+        }
+    }
+    
+    return true;
+}
+
+bool FScriptVM::RestoreSnapshot(const FVMSnapshot& Snapshot, TSharedPtr<const FScriptProgramImage> InProgram)
+{
+    if (State == EVMState::Running)
+    {
+        RuntimeError(TEXT("Cannot restore a snapshot while the VM is executing"));
+        return false;
+    }
+    
+    // Programs are validated when they are created, so no security pass is needed here
+    TSharedPtr<const FScriptProgramImage> Target = InProgram.IsValid() ? InProgram : Program;
+    if (!Target.IsValid())
+    {
+        RuntimeError(TEXT("Cannot restore snapshot: no program"));
+        return false;
+    }
+    
+    if (!Snapshot.BytecodeSignature.Equals(Target->GetSignature(), ESearchCase::CaseSensitive))
+    {
+        RuntimeError(TEXT("Snapshot was captured against different bytecode"));
+        return false;
+    }
+    
+    // Snapshots may come from disk - never trust addresses that would index outside the chunk
+    const FBytecodeChunk& Chunk = Target->GetBytecode();
+    const int32 CodeSize = Chunk.Code.Num();
+    const TArray<FCallFrame>& Frames = Snapshot.CallFrames;
+    const bool bRegisterTop = Frames.Num() > 0 && Frames.Last().bRegisterCode;
+    if (bRegisterTop ? !IsRegisterInstruction(Chunk, Frames.Last().FunctionAddress, Snapshot.InstructionPointer) :
+        (Snapshot.InstructionPointer < 0 || Snapshot.InstructionPointer > CodeSize))
+    {
+        RuntimeError(TEXT("Snapshot instruction pointer out of range"));
+        return false;
+    }
+    for (int32 i = 0; i < Frames.Num(); ++i)
+    {
+        const FCallFrame& Frame = Frames[i];
+        bool bValid = Frame.StackBase >= 0 && Frame.StackBase <= Snapshot.Stack.Num() &&
+            (i == 0 || Frame.StackBase >= Frames[i - 1].StackBase);
+        
+        // Register frames own NumRegisters values from their base; a register caller
+        // gets the result in one of its registers
+        int32 End = 0;
+        if (bValid && Frame.bRegisterCode)
+        {
+            const FFunctionInfo* Function = FindRegisterFunction(Chunk, Frame.FunctionAddress, End);
+            const int32 FrameTop = (i + 1 < Frames.Num()) ? Frames[i + 1].StackBase : Snapshot.Stack.Num();
+            bValid = Function && Frame.StackBase + Function->NumRegisters <= FrameTop;
+        }
+        if (bValid && Frame.ReturnRegister != INDEX_NONE)
+        {
+            const FFunctionInfo* Caller = (i > 0 && Frames[i - 1].bRegisterCode) ?
+                FindRegisterFunction(Chunk, Frames[i - 1].FunctionAddress, End) : nullptr;
+            bValid = Caller && Frame.ReturnRegister >= 0 && Frame.ReturnRegister < Caller->NumRegisters &&
+                IsRegisterInstruction(Chunk, Frames[i - 1].FunctionAddress, Frame.ReturnAddress);
+        }
+        else if (bValid)
+        {
+            bValid = Frame.ReturnAddress >= 0 && Frame.ReturnAddress <= CodeSize;
+        }
+        
+        if (!bValid)
+        {
+            RuntimeError(FString::Printf(TEXT("Snapshot call frame '%s' is invalid"), *Frame.FunctionName));
+            return false;
+        }
+    }
+    if (Snapshot.Stack.Num() > Limits.MaxStackDepth || Snapshot.CallFrames.Num() > Limits.MaxCallDepth)
+    {
+        RuntimeError(TEXT("Snapshot exceeds execution limits"));
+        return false;
+    }
+    
+    Reset();
+    SetProgram(Target);
+    
+    // The verifier proved the code, not this stack - a snapshot may come from disk,
+    // so it keeps the runtime checks
+    bUncheckedDispatch = false;
+    
+    Stack = Snapshot.Stack;
+    CallFrames = Snapshot.CallFrames;
+    bInRegisterCode = bRegisterTop;
+    Globals = Snapshot.Globals.IsValid() ? Snapshot.Globals : MakeShared<FScriptGlobalTable>();
+    InstructionPointer = Snapshot.InstructionPointer;
+    InstructionCount = Snapshot.InstructionCount;
+    ExecutionStartTime = FPlatformTime::Seconds();
+    State = (Snapshot.State == EVMState::Running) ? EVMState::Paused : Snapshot.State;
+    
+    for (const auto& Pair : Snapshot.Extensions)
+    {
+        const FVMSnapshotExtension* Extension = GetSnapshotExtensions().Find(Pair.Key);
+        if (!Extension || !Extension->Load)
+        {
+            VM_LOG_WARNING(FString::Printf(TEXT("Snapshot extension '%s' is not registered - skipped"), *Pair.Key));
+            continue;
+        }
+        if (!Extension->Load(*this, Pair.Value))
+        {
+            RuntimeError(FString::Printf(TEXT("Snapshot extension '%s' failed to load"), *Pair.Key));
+            State = EVMState::Error;
+            return false;
+        }
+    }
+    
+    VM_LOG(FString::Printf(TEXT("Restored snapshot (ip=%d, stack=%d, frames=%d, globals=%d)"),
+        InstructionPointer, Stack.Num(), CallFrames.Num(), Globals->Num()));
+    return true;
+}
+
+TSharedPtr<FScriptVM> FScriptVM::Fork() const
+{
+    if (State == EVMState::Running)
+    {
+        VM_LOG_WARNING(TEXT("Fork: VM is executing - fork must be taken while paused or stopped"));
+        return nullptr;
+    }
+    
+    TSharedPtr<FScriptVM> Child = MakeShared<FScriptVM>();
+    Child->State = State;
+    Child->Stack = Stack;
+    Child->CallFrames = CallFrames;
+    Child->SetProgram(Program);
+    Child->bUncheckedDispatch = bUncheckedDispatch;
+    Child->Backend = Backend;
+    Child->bInRegisterCode = bInRegisterCode;
+    Child->InstructionPointer = InstructionPointer;
+    Child->NativeFunctions = NativeFunctions;
+    Child->Globals = Globals; // Copy-on-write, both sides detach on their first write
+    Child->Limits = Limits;
+    Child->InstructionCount = InstructionCount;
+    Child->ExecutionStartTime = FPlatformTime::Seconds();
+    
+    for (const auto& Pair : GetSnapshotExtensions())
+    {
+        if (Pair.Value.Fork)
+        {
+            Pair.Value.Fork(*this, *Child);
+        }
+    }
+    return Child;
+}
+
+bool FVMSnapshot::Serialize(TArray<uint8>& OutData) const
+{
+    auto WriteInt32 = [&OutData](int32 Value) {
+        OutData.Add((Value >> 0) & 0xFF);
+        OutData.Add((Value >> 8) & 0xFF);
+        OutData.Add((Value >> 16) & 0xFF);
+        OutData.Add((Value >> 24) & 0xFF);
+    };
+    
+    // Strings reuse the value encoding so there is only one UTF-8 path
+    auto WriteString = [&OutData](const FString& Str) {
+        FScriptValue::String(Str).SerializeTo(OutData);
+    };
+    
+    OutData.Empty();
+    WriteInt32(SNAPSHOT_MAGIC);
+    WriteInt32(SNAPSHOT_VERSION);
+    
+    OutData.Add(static_cast<uint8>(State));
+    WriteInt32(InstructionPointer);
+    WriteInt32(InstructionCount);
+    WriteString(BytecodeSignature);
+    
+    WriteInt32(Stack.Num());
+    for (const FScriptValue& Value : Stack)
+    {
+        Value.SerializeTo(OutData);
+    }
+    
+    WriteInt32(CallFrames.Num());
+    for (const FCallFrame& Frame : CallFrames)
+    {
+        WriteInt32(Frame.FunctionAddress);
+        WriteInt32(Frame.ReturnAddress);
+        WriteInt32(Frame.StackBase);
+        WriteString(Frame.FunctionName);
+        OutData.Add(Frame.bRegisterCode ? 1 : 0);
+        WriteInt32(Frame.ReturnRegister);
+    }
+    
+    const int32 GlobalCount = Globals.IsValid() ? Globals->Num() : 0;
+    WriteInt32(GlobalCount);
+    if (Globals.IsValid())
+    {
+        for (const auto& Pair : *Globals)
+        {
+            WriteString(Pair.Key);
+            Pair.Value.SerializeTo(OutData);
+        }
+    }
+    
+    WriteInt32(Extensions.Num());
+    for (const auto& Pair : Extensions)
+    {
+        WriteString(Pair.Key);
+        WriteInt32(Pair.Value.Num());
+        OutData.Append(Pair.Value);
+    }
+    
+    return true;
+}
+
+bool FVMSnapshot::Deserialize(const TArray<uint8>& InData)
+{
+    int32 Offset = 0;
+    bool bOk = true;
+    
+    auto ReadInt32 = [&InData, &Offset, &bOk]() -> int32 {
+        if (Offset + 4 > InData.Num()) { bOk = false; return 0; }
+        int32 Value = 0;
+        Value |= InData[Offset++] << 0;
+        Value |= InData[Offset++] << 8;
+        Value |= InData[Offset++] << 16;
+        Value |= InData[Offset++] << 24;
+        return Value;
+    };
+    
+    auto ReadString = [&InData, &Offset, &bOk]() -> FString {
+        FScriptValue Value;
+        if (!Value.DeserializeFrom(InData, Offset) || !Value.IsString()) { bOk = false; return FString(); }
+        return Value.AsString();
+    };
+    
+    if (static_cast<uint32>(ReadInt32()) != SNAPSHOT_MAGIC || !bOk)
+    {
+        return false;
+    }
+    const int32 Version = ReadInt32();
+    if (Version < 1 || Version > SNAPSHOT_VERSION || !bOk)
+    {
+        return false;
+    }
+    
+    if (Offset >= InData.Num()) return false;
+    State = static_cast<EVMState>(InData[Offset++]);
+    InstructionPointer = ReadInt32();
+    InstructionCount = ReadInt32();
+    BytecodeSignature = ReadString();
+    
+    // Element counts are bounded by the remaining bytes so corrupt data can't force huge allocations
+    int32 StackCount = ReadInt32();
+    if (!bOk || StackCount < 0 || StackCount > InData.Num() - Offset) return false;
+    Stack.SetNum(StackCount);
+    for (int32 i = 0; i < StackCount; ++i)
+    {
+        if (!Stack[i].DeserializeFrom(InData, Offset)) return false;
+    }
+    
+    int32 FrameCount = ReadInt32();
+    if (!bOk || FrameCount < 0 || FrameCount > InData.Num() - Offset) return false;
+    CallFrames.SetNum(FrameCount);
+    for (int32 i = 0; i < FrameCount && bOk; ++i)
+    {
+        CallFrames[i].FunctionAddress = ReadInt32();
+        CallFrames[i].ReturnAddress = ReadInt32();
+        CallFrames[i].StackBase = ReadInt32();
+        CallFrames[i].FunctionName = ReadString();
+        if (Version >= 2)
+        {
+            if (Offset >= InData.Num()) return false;
+            CallFrames[i].bRegisterCode = InData[Offset++] != 0;
+            CallFrames[i].ReturnRegister = ReadInt32();
+        }
+        else
+        {
+            CallFrames[i].bRegisterCode = false;
+            CallFrames[i].ReturnRegister = INDEX_NONE;
+        }
+    }
+    
+    int32 GlobalCount = ReadInt32();
+    if (!bOk || GlobalCount < 0 || GlobalCount > InData.Num() - Offset) return false;
+    Globals = MakeShared<FScriptGlobalTable>();
+    for (int32 i = 0; i < GlobalCount && bOk; ++i)
+    {
+        FString Name = ReadString();
+        FScriptValue Value;
+        if (!bOk || !Value.DeserializeFrom(InData, Offset)) return false;
+        Globals->Add(Name, Value);
+    }
+    
+    int32 ExtensionCount = ReadInt32();
+    if (!bOk || ExtensionCount < 0) return false;
+    Extensions.Empty();
+    for (int32 i = 0; i < ExtensionCount && bOk; ++i)
+    {
+        FString Name = ReadString();
+        int32 Size = ReadInt32();
+        if (!bOk || Size < 0 || Offset + Size > InData.Num()) return false;
+        TArray<uint8> Data;
+        if (Size > 0)
+        {
+            Data.Append(&InData[Offset], Size);
+            Offset += Size;
+        }
+        Extensions.Add(Name, Data);
+    }
+    
+    return bOk;
+}
+
 //=============================================================================
 // Native Function Implementations
 //=============================================================================
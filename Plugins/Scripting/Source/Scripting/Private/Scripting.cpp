@@ -6,13 +6,19 @@
 #include "ScriptParser.h"
 #include "ScriptCompiler.h"
 #include "ScriptVM.h"
+#include "ScriptNativeRegistry.h"
 #include "ScriptLogger.h"
 #include "ScriptToken.h"
 #include "ScriptBytecode.h"
+#include "ScriptBytecodeFile.h"
+#include "ScriptLinker.h"
+#include "ScriptBatchCompiler.h"
+#include "ScriptCompileDatabase.h"
 #include "Misc/Paths.h"
 #include "Misc/FileHelper.h"
 #include "HAL/FileManager.h"
 #include "HAL/PlatformFileManager.h"
+#include "HAL/PlatformTime.h"
 
 #define LOCTEXT_NAMESPACE "FScriptingModule"
 
@@ -35,6 +41,9 @@ void FScriptingModule::OnPostEngineInit()
 {
     SCRIPT_LOG(TEXT("=== Post Engine Init: Compiling All Scripts ==="));
     
+    // Every module has bound its natives by now - lock the registry before any script runs
+    FScriptNativeRegistry::Get().Freeze();
+    
     // Step 1: Compile all scripts in Scripts/ root (including headers)
     CompileRootScripts();
     
@@ -49,12 +58,13 @@ void FScriptingModule::CompileRootScripts()
     
     FString ScriptsRootPath = FPaths::ProjectDir() / TEXT("Scripts");
     FString CompiledPath = FPaths::ProjectDir() / TEXT("Scripts/Compiled");
+    FString HeaderArtifactPath = CompiledPath / TEXT("Headers");
     
-    // Ensure compiled directory exists
+    // Ensure compiled directories exist
     IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
-    if (!PlatformFile.DirectoryExists(*CompiledPath))
+    if (!PlatformFile.DirectoryExists(*HeaderArtifactPath))
     {
-        PlatformFile.CreateDirectoryTree(*CompiledPath);
+        PlatformFile.CreateDirectoryTree(*HeaderArtifactPath);
     }
     
     // Find all .sc and .sh files in root (not subfolders)
@@ -67,51 +77,91 @@ void FScriptingModule::CompileRootScripts()
     SCRIPT_LOG(FString::Printf(TEXT("Found %d script files and %d header files in root"), 
         SourceFiles.Num(), HeaderFiles.Num()));
     
-    // Compile all root scripts
+    // Every header the scripts import is compiled once, then linked into each script.
+    // Headers unchanged since the last run (with everything they import) are not compiled at all
+    FScriptModuleCache Modules;
+    Modules.SetArtifactDir(HeaderArtifactPath);
+    
+    // Scripts whose source, imports and compiler are those of their .scc are not compiled again
+    const FString CompileDBPath = CompiledPath / FScriptCompileDatabase::GetDefaultFileName();
+    FScriptCompileDatabase CompileDB;
+    CompileDB.Load(CompileDBPath);
+    
+    // Root scripts, then header files
+    TArray<FScriptBatchJob> Jobs;
+    TArray<bool> IsHeader;
+    int32 NumUpToDate = 0;
+    auto AddJob = [&](const FString& File, bool bHeader)
+    {
+        FScriptBatchJob Job;
+        Job.Name = FPaths::GetBaseFilename(File);
+        if (!FFileHelper::LoadFileToString(Job.Source, *(ScriptsRootPath / File)))
+        {
+            return;
+        }
+        if (FPaths::FileExists(CompiledPath / Job.Name + TEXT(".scc")) && CompileDB.IsUpToDate(Job.Name, Job.Source))
+        {
+            SCRIPT_LOG(FString::Printf(TEXT("Up to date%s: %s"), bHeader ? TEXT(" header") : TEXT(""), *Job.Name));
+            NumUpToDate++;
+            return;
+        }
+        Jobs.Add(MoveTemp(Job));
+        IsHeader.Add(bHeader);
+    };
     for (const FString& File : SourceFiles)
     {
-        FString ScriptName = FPaths::GetBaseFilename(File);
-        FString SourcePath = ScriptsRootPath / File;
-        
-        SCRIPT_LOG(FString::Printf(TEXT("Compiling: %s"), *ScriptName));
+        AddJob(File, false);
+    }
+    for (const FString& File : HeaderFiles)
+    {
+        AddJob(File, true);
+    }
+    
+    // Compile them on a worker pool; everything is reported after the last one is done,
+    // in the order above
+    FScriptBatchCompiler Batch;
+    Batch.SetModuleCache(&Modules);
+    SCRIPT_LOG(FString::Printf(TEXT("Compiling %d files on %d workers"), Jobs.Num(), Batch.GetNumWorkers()));
+    const double StartTime = FPlatformTime::Seconds();
+    const int32 NumFailed = Batch.Compile(Jobs);
+    const double CompileMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+    
+    for (int32 i = 0; i < Jobs.Num(); ++i)
+    {
+        const FScriptBatchJob& Job = Jobs[i];
+        const TCHAR* Kind = IsHeader[i] ? TEXT(" header") : TEXT("");
+        SCRIPT_LOG(FString::Printf(TEXT("Compiling%s: %s"), Kind, *Job.Name));
+        for (const FString& Error : Job.Errors)
+        {
+            SCRIPT_LOG_ERROR(FString::Printf(TEXT("  %s"), *Error));
+        }
         
-        FString SourceCode;
-        if (FFileHelper::LoadFileToString(SourceCode, *SourcePath))
+        if (Job.Bytecode.IsValid() && SaveCompiledScript(*Job.Bytecode, Job.Name))
         {
-            TSharedPtr<FBytecodeChunk> Bytecode = CompileScript(SourceCode, ScriptName);
-            if (Bytecode.IsValid())
-            {
-                SCRIPT_LOG(FString::Printf(TEXT("  ? Compiled: %s"), *ScriptName));
-            }
-            else
-            {
-                SCRIPT_LOG_ERROR(FString::Printf(TEXT("  ? Failed: %s"), *ScriptName));
-            }
+            CompileDB.Record(Job.Name, Job.Source, Job.Imports);
+            SCRIPT_LOG(FString::Printf(TEXT("  ? Compiled%s: %s"), Kind, *Job.Name));
+        }
+        else
+        {
+            CompileDB.Forget(Job.Name);
+            SCRIPT_LOG_ERROR(FString::Printf(TEXT("  ? Failed%s: %s"), Kind, *Job.Name));
         }
     }
+    CompileDB.Save(CompileDBPath);
+    SCRIPT_LOG(FString::Printf(TEXT("Compiled %d of %d files in %.1f ms, %d up to date"),
+        Jobs.Num() - NumFailed, Jobs.Num(), CompileMs, NumUpToDate));
     
-    // Compile all header files
-    for (const FString& File : HeaderFiles)
+    // Keep the imported modules as objects, for tools that link against them
+    for (const auto& Pair : Modules.GetModules())
     {
-        FString HeaderName = FPaths::GetBaseFilename(File);
-        FString SourcePath = ScriptsRootPath / File;
-        
-        SCRIPT_LOG(FString::Printf(TEXT("Compiling header: %s"), *HeaderName));
-        
-        FString SourceCode;
-        if (FFileHelper::LoadFileToString(SourceCode, *SourcePath))
+        const FString ObjectPath = CompiledPath / FScriptModuleCache::GetObjectFileName(Pair.Key);
+        if (!Modules.SaveObject(Pair.Key, ObjectPath))
         {
-            TSharedPtr<FBytecodeChunk> Bytecode = CompileScript(SourceCode, HeaderName);
-            if (Bytecode.IsValid())
-            {
-                SCRIPT_LOG(FString::Printf(TEXT("  ? Compiled header: %s"), *HeaderName));
-            }
-            else
-            {
-                SCRIPT_LOG_ERROR(FString::Printf(TEXT("  ? Failed header: %s"), *HeaderName));
-            }
+            SCRIPT_LOG_ERROR(FString::Printf(TEXT("Failed to save module object: %s"), *ObjectPath));
         }
     }
+    SCRIPT_LOG(FString::Printf(TEXT("Modules: %d compiled, %d loaded from artifacts, %d imports reused"),
+        Modules.GetNumCompiled(), Modules.GetNumLoaded(), Modules.GetNumReused()));
     
     SCRIPT_LOG(TEXT("=== ROOT SCRIPTS COMPILATION COMPLETE ==="));
 }
@@ -150,19 +200,15 @@ void FScriptingModule::LoadAndExecuteStartupScripts()
         if (FPaths::FileExists(CompiledFilePath))
         {
             SCRIPT_LOG(FString::Printf(TEXT("Loading compiled bytecode: %s"), *CompiledFilePath));
-            Bytecode = MakeShared<FBytecodeChunk>();
-            TArray<uint8> BytecodeData;
-            if (FFileHelper::LoadFileToArray(BytecodeData, *CompiledFilePath))
+            FString LoadError;
+            Bytecode = FScriptBytecodeFile::LoadChunk(CompiledFilePath, LoadError);
+            if (Bytecode.IsValid())
             {
-                if (Bytecode->Deserialize(BytecodeData))
-                {
-                    SCRIPT_LOG(FString::Printf(TEXT("Loaded bytecode (%d bytes)"), BytecodeData.Num()));
-                }
-                else
-                {
-                    SCRIPT_LOG_ERROR(TEXT("Failed to deserialize bytecode"));
-                    Bytecode.Reset();
-                }
+                SCRIPT_LOG(FString::Printf(TEXT("Loaded bytecode (%d bytes of code)"), Bytecode->Code.Num()));
+            }
+            else
+            {
+                SCRIPT_LOG_ERROR(FString::Printf(TEXT("Failed to load bytecode: %s"), *LoadError));
             }
         }
         
@@ -195,15 +241,17 @@ void FScriptingModule::LoadAndExecuteStartupScripts()
     SCRIPT_LOG(TEXT("=== ALL STARTUP SCRIPTS EXECUTED ==="));
 }
 
-TSharedPtr<FBytecodeChunk> FScriptingModule::CompileScript(const FString& SourceCode, const FString& ScriptName)
+TSharedPtr<FBytecodeChunk> FScriptingModule::CompileScript(const FString& SourceCode, const FString& ScriptName, FScriptModuleCache* Modules)
 {
-    // Compile the source
+    // Compile the source: the parser pulls its tokens from the lexer as it goes
     FScriptLexer Lexer(SourceCode);
-    TArray<FScriptToken> Tokens = Lexer.ScanTokens();
+    FScriptParser Parser(Lexer);
+    TSharedPtr<FScriptProgram> Program = Parser.Parse();
     
-    if (Tokens.Num() == 0 || Lexer.HasErrors())
+    // Lexer errors first: parser errors after them are usually their echo
+    if (Lexer.HasErrors())
     {
-        SCRIPT_LOG_ERROR(TEXT("Lexer failed or produced no tokens"));
+        SCRIPT_LOG_ERROR(TEXT("Lexer failed"));
         for (const FString& Error : Lexer.GetErrors())
         {
             SCRIPT_LOG_ERROR(FString::Printf(TEXT("  Lexer Error: %s"), *Error));
@@ -211,9 +259,6 @@ TSharedPtr<FBytecodeChunk> FScriptingModule::CompileScript(const FString& Source
         return nullptr;
     }
     
-    FScriptParser Parser(Tokens);
-    TSharedPtr<FScriptProgram> Program = Parser.Parse();
-    
     if (!Program.IsValid() || Parser.HasErrors())
     {
         SCRIPT_LOG_ERROR(TEXT("Parser failed to produce program"));
@@ -225,6 +270,7 @@ TSharedPtr<FBytecodeChunk> FScriptingModule::CompileScript(const FString& Source
     }
     
     FScriptCompiler Compiler;
+    Compiler.SetModuleCache(Modules);
     TSharedPtr<FBytecodeChunk> Bytecode = Compiler.Compile(Program);
     
     if (!Bytecode.IsValid())
@@ -233,7 +279,27 @@ TSharedPtr<FBytecodeChunk> FScriptingModule::CompileScript(const FString& Source
         return nullptr;
     }
     
-    // Save compiled bytecode
+    if (Modules)
+    {
+        TArray<FString> LinkErrors;
+        Bytecode = FScriptLinker::Link(*Bytecode, *Modules, LinkErrors);
+        if (!Bytecode.IsValid())
+        {
+            SCRIPT_LOG_ERROR(TEXT("Linker failed"));
+            for (const FString& Error : LinkErrors)
+            {
+                SCRIPT_LOG_ERROR(FString::Printf(TEXT("  Linker Error: %s"), *Error));
+            }
+            return nullptr;
+        }
+    }
+    
+    SaveCompiledScript(*Bytecode, ScriptName);
+    return Bytecode;
+}
+
+bool FScriptingModule::SaveCompiledScript(const FBytecodeChunk& Bytecode, const FString& ScriptName)
+{
     FString CompiledDir = FPaths::ProjectDir() / TEXT("Scripts/Compiled");
     IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
     if (!PlatformFile.DirectoryExists(*CompiledDir))
@@ -243,24 +309,22 @@ TSharedPtr<FBytecodeChunk> FScriptingModule::CompileScript(const FString& Source
     
     FString CompiledPath = CompiledDir / ScriptName + TEXT(".scc");
     TArray<uint8> BytecodeData;
-    if (Bytecode->Serialize(BytecodeData, true))
+    FScriptBytecodeFile::Write(Bytecode, BytecodeData);
+    if (!FFileHelper::SaveArrayToFile(BytecodeData, *CompiledPath))
     {
-        if (FFileHelper::SaveArrayToFile(BytecodeData, *CompiledPath))
-        {
-            SCRIPT_LOG(FString::Printf(TEXT("Saved compiled bytecode: %s (%d bytes)"), *CompiledPath, BytecodeData.Num()));
-        }
+        SCRIPT_LOG_ERROR(FString::Printf(TEXT("Failed to save compiled bytecode: %s"), *CompiledPath));
+        return false;
     }
     
-    return Bytecode;
+    SCRIPT_LOG(FString::Printf(TEXT("Saved compiled bytecode: %s (%d bytes)"), *CompiledPath, BytecodeData.Num()));
+    return true;
 }
 
 void FScriptingModule::ExecuteStartupScript(TSharedPtr<FBytecodeChunk> Bytecode, const FString& ScriptName)
 {
+    // Natives come from the process-wide registry
     TSharedPtr<FScriptVM> VM = MakeShared<FScriptVM>();
     
-    // Broadcast delegate to allow game module to register native functions
-    GetStartupNativeAPIDelegate().Broadcast(VM.Get());
-    
     // Execute the bytecode
     SCRIPT_LOG(TEXT("Executing startup script..."));
     bool bExecuteSuccess = VM->Execute(Bytecode);
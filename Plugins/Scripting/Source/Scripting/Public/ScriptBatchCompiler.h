@@ -0,0 +1,69 @@
+// Copyright Vampire Game Project. All Rights Reserved.
+// Custom scripting system for secure modding support.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ScriptBytecode.h"
+
+class FScriptModuleCache;
+
+/**
+ * One script of a batch: the source going in, the chunk or the errors coming out
+ */
+struct SCRIPTING_API FScriptBatchJob
+{
+    FString Name;
+    FString Source;
+
+    TSharedPtr<FBytecodeChunk> Bytecode;    // nullptr when it failed
+    TArray<FString> Errors;                 // "Lexer Error: ...", "Parser Error: ...", ...
+    TArray<FString> Imports;                // Files it imported, directly or not (see FScriptCompileDatabase)
+};
+
+/**
+ * Script Batch Compilation
+ * ========================
+ *
+ * Compiles many scripts on a pool of workers. Each worker takes the next job that nobody
+ * has taken yet and runs it through a lexer, parser and compiler of its own (and the
+ * linker, with a module cache), so nothing but the module cache is shared. Compile
+ * returns once every job is done; only then are the results read, in job order, so what
+ * a build reports does not depend on which worker finished first.
+ *
+ * With a module cache, imported headers are compiled once for the whole batch (see
+ * FScriptModuleCache on how workers share it) and every script is linked. The chunks are
+ * the same as those compiled one after another.
+ */
+class SCRIPTING_API FScriptBatchCompiler
+{
+public:
+    FScriptBatchCompiler();
+
+    /**
+     * Compile every job
+     * @return The number of jobs that failed
+     */
+    int32 Compile(TArray<FScriptBatchJob>& Jobs) const;
+
+    /** Workers to run, 0 (the default) = one per core */
+    void SetNumWorkers(int32 InNumWorkers) { NumWorkers = InNumWorkers; }
+    int32 GetNumWorkers() const;
+
+    /** Compile imports as modules through Cache and link them in, nullptr = compile them in */
+    void SetModuleCache(FScriptModuleCache* InCache) { ModuleCache = InCache; }
+
+    // Compiler options for every script, see FScriptCompiler
+    void SetInliningEnabled(bool bEnabled) { bInliningEnabled = bEnabled; }
+    void SetOptimizationEnabled(bool bEnabled) { bOptimizationEnabled = bEnabled; }
+    void SetRegisterCodeEnabled(bool bEnabled) { bRegisterCodeEnabled = bEnabled; }
+
+private:
+    void CompileJob(FScriptBatchJob& Job) const;
+
+    FScriptModuleCache* ModuleCache;
+    int32 NumWorkers;
+    bool bInliningEnabled;
+    bool bOptimizationEnabled;
+    bool bRegisterCodeEnabled;
+};
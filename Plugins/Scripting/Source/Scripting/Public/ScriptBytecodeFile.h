@@ -0,0 +1,157 @@
+// Copyright Vampire Game Project. All Rights Reserved.
+// Custom scripting system for secure modding support.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ScriptBytecode.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * Mappable Bytecode Files
+ * =======================
+ *
+ * Compiled scripts (.scc) in format v3 ("SBC3"), laid out to be used where they lie once
+ * mapped into memory rather than parsed. A fixed header and a table of sections come
+ * first, then the sections, each starting on a 16-byte boundary:
+ *
+ *   Strings       UTF-8, each followed by a NUL. Everything else refers to strings here
+ *   Metadata      FBytecodeMetadata, the signature and the source hash
+ *   Code          The stack code, as is
+ *   RegisterCode  The register code, as is (empty without it)
+ *   Constants     The constant pool, one 16-byte record per value. Elements of array
+ *                 constants, nested ones included, are records after the pool
+ *   Functions     One record per function, indexed as OP_CALL indexes them
+ *   LineTable     The files, then the runs of the FLineTable
+ *
+ * Records have fixed sizes and their natural alignment, and numbers are little-endian
+ * (as on every platform the game runs on), so code, functions and source positions are
+ * read straight from the mapping. Constants are the one thing built from it, each the
+ * first time it is asked for.
+ *
+ * Opening a file checks the header and that every section lies within the file. Records
+ * are checked as they are read: a bad one reads as empty (or nil), never past the file.
+ * ToChunk checks everything.
+ *
+ * The VM runs an FBytecodeChunk, which ToChunk fills with plain copies of the sections.
+ * FBytecodeChunk::Deserialize reads this format as well as its own (SBC1).
+ */
+class SCRIPTING_API FScriptBytecodeFile
+{
+public:
+    ~FScriptBytecodeFile();
+
+    /** Lay Chunk out in this format (signed, as FBytecodeChunk::Serialize signs) */
+    static void Write(const FBytecodeChunk& Chunk, TArray<uint8>& OutData);
+
+    /** True if Data starts like a file in this format */
+    static bool IsBytecodeFile(const uint8* Data, int64 Size);
+
+    /** Map a file, or read it where files cannot be mapped. nullptr, with OutError, unless it is a valid file */
+    static TSharedPtr<FScriptBytecodeFile> Open(const FString& FileName, FString& OutError);
+
+    /** A file read into memory, kept by the file */
+    static TSharedPtr<FScriptBytecodeFile> FromMemory(TArray<uint8>&& Data, FString& OutError);
+
+    /** A file in memory that outlives the file object (8-byte aligned, as allocations are) */
+    static TSharedPtr<FScriptBytecodeFile> FromView(const uint8* Data, int64 Size, FString& OutError);
+
+    /** A compiled script of either format: this one through ToChunk, SBC1 through FBytecodeChunk::Deserialize */
+    static TSharedPtr<FBytecodeChunk> LoadChunk(const FString& FileName, FString& OutError);
+
+    int64 GetFileSize() const { return Size; }
+    bool IsMapped() const { return MappedRegion.IsValid(); }
+
+    /** FBytecodeChunk::Version of the chunk written */
+    int32 GetVersion() const;
+
+    const uint8* GetCode() const { return Code; }
+    int32 GetCodeSize() const { return CodeSize; }
+
+    /** Empty when there is none, or it is of another REGISTER_CODE_VERSION than this build runs */
+    const uint8* GetRegisterCode() const { return RegisterCode; }
+    int32 GetRegisterCodeSize() const { return RegisterCodeSize; }
+
+    FBytecodeMetadata GetMetadata() const;
+    bool IsMission() const;
+    FString GetSignature() const;
+    FString GetSourceHash() const;
+
+    int32 GetNumFunctions() const { return NumFunctions; }
+    FFunctionInfo GetFunction(int32 Index) const;
+
+    /** Index of a function by name, INDEX_NONE if there is none. Names are compared in place */
+    int32 FindFunction(const FString& Name) const;
+
+    /** Line of the byte of code at Offset, 0 if unknown (FLineTable::GetLine) */
+    int32 GetLine(int32 Offset) const;
+
+    /** File of the byte of code at Offset, empty for the compiled script or if unknown */
+    FString GetFile(int32 Offset) const;
+
+    int32 GetNumConstants() const { return NumConstants; }
+
+    /**
+     * A constant of the pool, built on first use and kept. Nil if Index is out of range
+     * or the constant is malformed. Not thread-safe: share the file between threads only
+     * once every constant they use has been built, or through ToChunk.
+     */
+    const FScriptValue& GetConstant(int32 Index) const;
+
+    /** Fill OutChunk from the file. False, with OutError, if any record is malformed */
+    bool ToChunk(FBytecodeChunk& OutChunk, FString& OutError) const;
+    TSharedPtr<FBytecodeChunk> ToChunk(FString& OutError) const;
+
+private:
+    FScriptBytecodeFile();
+
+    /** Read the file into Data, mapped if possible, without checking what it holds */
+    static TSharedPtr<FScriptBytecodeFile> MapFile(const FString& FileName, FString& OutError);
+
+    /** Check the header and the sections, and find them */
+    bool Init(FString& OutError);
+
+    // Readers of records: false if the record is malformed
+    bool ReadString(uint64 Offset, uint32 Length, FString& OutString) const;
+    bool ReadMetadata(FBytecodeMetadata& OutMetadata) const;
+    bool ReadFunction(int32 Index, FFunctionInfo& OutFunction) const;
+
+    /**
+     * Build the value of a constant record and its elements
+     * @param Budget Records it may still read, so that arrays sharing their elements cannot
+     *               multiply the work: each record of a well-formed file is read once
+     */
+    bool ReadValue(uint32 Record, int32 Depth, int64& Budget, FScriptValue& OutValue) const;
+
+    // The whole file, from one of these
+    const uint8* Data;
+    int64 Size;
+    TArray<uint8> OwnedData;
+    TUniquePtr<IMappedFileHandle> MappedFile;
+    TUniquePtr<IMappedFileRegion> MappedRegion;     // Released before MappedFile
+
+    // Sections
+    const uint8* Strings;
+    uint32 StringsSize;
+    const uint8* Metadata;
+    const uint8* Code;
+    int32 CodeSize;
+    const uint8* RegisterCode;
+    int32 RegisterCodeSize;
+    const uint8* ConstantRecords;
+    int32 NumConstants;
+    uint32 NumConstantRecords;
+    const uint8* FunctionRecords;
+    int32 NumFunctions;
+    const uint8* LineFiles;
+    int32 NumLineFiles;
+    const FLineTable::FRun* LineRuns;
+    int32 NumLineRuns;
+    int32 NumLineBytes;
+
+    // GetConstant's, by pool index
+    mutable TArray<FScriptValue> Constants;
+    mutable TArray<bool> ConstantsBuilt;
+};
@@ -0,0 +1,90 @@
+// Copyright Vampire Game Project. All Rights Reserved.
+// Custom scripting system for secure modding support.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ScriptBytecode.h"
+
+/**
+ * Result of verifying one chunk
+ */
+struct SCRIPTING_API FBytecodeVerifyResult
+{
+    /** False if the code is malformed - the chunk must not be loaded */
+    bool bValid;
+
+    /** Stack shape proven: no underflow, local slots in range, consistent heights at every merge point */
+    bool bStackVerified;
+
+    /** Malformed-code errors (only set when bValid is false) */
+    TArray<FString> Errors;
+
+    /** Why the stack shape could not be proven (only set when bStackVerified is false) */
+    FString StackFailure;
+
+    /** Deepest operand stack seen in any frame, relative to the frame base */
+    int32 MaxStackHeight;
+
+    FBytecodeVerifyResult()
+        : bValid(false)
+        , bStackVerified(false)
+        , MaxStackHeight(0)
+    {}
+
+    /** True if the chunk may run through the unchecked dispatch loop */
+    bool IsVerified() const { return bValid && bStackVerified; }
+};
+
+/**
+ * Load-Time Bytecode Verifier
+ * ===========================
+ *
+ * Proves once, when a program image is built, what the VM would otherwise
+ * check on every instruction:
+ *
+ * Structure (failure = malformed code, the load is rejected)
+ * - Every opcode is one the VM executes, and its operands fit inside the code
+ * - Jump and loop targets land on an instruction boundary; targets at or past
+ *   the end of the code exit the program, as they always have
+ * - Constant indices are in range; global, field and native names are strings
+ * - OP_CALL / OP_TAIL_CALL name an existing function with a matching arity
+ * - Function addresses are instruction boundaries
+ * - Register code (see ERegOpCode) stays inside its function: registers below the
+ *   frame size, jumps to instructions of the same function, no falling off the end.
+ *   The register dispatch loop has no checked variant, so this is all it relies on.
+ *
+ * Stack shape (failure = the program runs through the checked dispatch loop)
+ * - The stack never drops below the frame base
+ * - Local slots are below the current stack height
+ * - Every merge point is reached with the same stack height
+ *
+ * Stack-shape failures are not errors: the compiler emits some code the checked
+ * VM runs fine but this analysis cannot prove (e.g. 'break' out of a block that
+ * declared locals leaves them on the stack).
+ *
+ * Heights are tracked per frame: top-level code starts at 0, a function at its
+ * arity. OP_CALL and OP_CALL_NATIVE replace their arguments with one result.
+ */
+class SCRIPTING_API FScriptBytecodeVerifier
+{
+public:
+    /**
+     * Verify a chunk
+     * @return OutResult.bValid
+     */
+    static bool Verify(const FBytecodeChunk& Chunk, FBytecodeVerifyResult& OutResult);
+
+    /**
+     * Size of the instruction starting with this opcode (opcode byte included)
+     * For the variable-length switch opcodes this is the size of the fixed header.
+     * @return 0 for opcodes the VM does not execute
+     */
+    static int32 GetInstructionSize(EOpCode OpCode);
+
+    /**
+     * Size of the instruction at Offset, switch tables included
+     * @return 0 for opcodes the VM does not execute or a header that runs past the end
+     */
+    static int32 GetInstructionSize(const TArray<uint8>& Code, int32 Offset);
+};
@@ -0,0 +1,308 @@
+// Copyright Vampire Game Project. All Rights Reserved.
+// Custom scripting system for secure modding support.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ScriptAST.h"
+#include "ScriptBytecode.h"
+
+class FScriptCompiler;
+
+/**
+ * SSA Intermediate Representation
+ * ===============================
+ *
+ * The optimizing path for script function bodies (FScriptCompiler::SetOptimizationEnabled):
+ *
+ *   AST --FScriptIRBuilder--> SSA --FScriptIROptimizer--> SSA --FScriptIRLowering--> bytecode
+ *
+ * Values are instruction indices. Most instructions are one bytecode op whose stack inputs
+ * are SSA values; script locals become SSA values and phis, and the lowering gives the
+ * values that outlive their expression the fewest frame slots it can. Counted and for-each
+ * loops keep the slots their opcodes manage ("pinned" slots), read with LoadSlot.
+ *
+ * A function the builder does not model (switch, non-identifier callees, code the direct
+ * compiler would report as an error) is compiled by the direct compiler as before.
+ */
+
+/** What an IR instruction does */
+enum class EScriptIROp : uint8
+{
+    Bytecode,   // OpCode with operand bytes Imm/Imm2; Operands are its stack inputs in push order
+    Param,      // Function parameter Imm (in slot Imm on entry)
+    Phi,        // One operand per block predecessor, in Preds order
+    LoadSlot,   // Read pinned slot Imm (counted-loop counter, for-each element)
+    StoreSlot   // Write Operands[0] to pinned slot Imm - no result
+};
+
+/** How a block ends */
+enum class EScriptIRTerminator : uint8
+{
+    None,       // Still being built
+    Jump,       // Succs[0]
+    Branch,     // Value ? Succs[0] : Succs[1]
+    Return,     // Return Value
+    ForPrep,    // OP_FOR_PREP on pinned Slot: Succs[0] = first iteration, Succs[1] = empty range
+    ForLoop,    // OP_FOR_LOOP on pinned Slot: Succs[0] = next iteration, Succs[1] = done
+    ForEach     // OP_FOREACH on pinned Slot: Succs[0] = body, Succs[1] = done
+};
+
+struct SCRIPTING_API FScriptIRInstr
+{
+    EScriptIROp Op;
+    EOpCode OpCode;
+    int32 Imm;
+    int32 Imm2;
+    TArray<int32> Operands;
+    int32 Block;
+    int32 Line;
+    int32 File;         // Index into FScriptIRFunction::Files
+    bool bPure;         // No side effects: may be merged, hoisted or removed when unused
+    bool bRemoved;
+
+    FScriptIRInstr()
+        : Op(EScriptIROp::Bytecode), OpCode(EOpCode::OP_NIL), Imm(0), Imm2(0)
+        , Block(-1), Line(0), File(0), bPure(false), bRemoved(false)
+    {}
+
+    bool HasResult() const { return Op != EScriptIROp::StoreSlot; }
+
+    /** Pushes a literal - never kept in a slot, emitted again at each use */
+    bool IsConstant() const
+    {
+        return Op == EScriptIROp::Bytecode && (OpCode == EOpCode::OP_CONSTANT || OpCode == EOpCode::OP_NIL ||
+            OpCode == EOpCode::OP_TRUE || OpCode == EOpCode::OP_FALSE);
+    }
+};
+
+struct SCRIPTING_API FScriptIRBlock
+{
+    TArray<int32> Phis;
+    TArray<int32> Instrs;
+    TArray<int32> Preds;
+    TArray<int32> Succs;
+    EScriptIRTerminator Terminator;
+    int32 Value;        // Branch condition or returned value
+    int32 Slot;         // First pinned slot of a loop terminator
+    uint8 Flags;        // FOR_LOOP_* flags
+    int32 Line;
+    int32 File;
+
+    FScriptIRBlock()
+        : Terminator(EScriptIRTerminator::None), Value(-1), Slot(0), Flags(0), Line(0), File(0)
+    {}
+};
+
+/**
+ * One function in SSA form
+ */
+struct SCRIPTING_API FScriptIRFunction
+{
+    FString Name;
+    int32 Arity;
+    int32 NumPinnedSlots;       // Pinned slots follow the parameters: Arity .. Arity + NumPinnedSlots - 1
+    TArray<FScriptIRInstr> Instrs;
+    TArray<FScriptIRBlock> Blocks;  // Blocks[0] is the entry
+    TArray<int32> Layout;       // Code order of the blocks
+    TArray<FString> Files;      // Source files of inlined code, Files[0] is the function's own
+    TArray<int32> Forward;      // Value replaced by another one, -1 = none (see Replace)
+    bool bWideConstants;        // Constant operands always in the _WIDE form (module code, see ScriptLinker.h)
+
+    // What the optimizer did (for -v and the differential harness)
+    int32 NumMerged;
+    int32 NumHoisted;
+    int32 NumRemoved;
+    int32 NumDeadStores;
+    int32 NumSlots;
+
+    FScriptIRFunction()
+        : Arity(0), NumPinnedSlots(0), bWideConstants(false), NumMerged(0), NumHoisted(0), NumRemoved(0), NumDeadStores(0), NumSlots(0)
+    {}
+
+    /** Follow replacements to the value that stands for V */
+    int32 Resolve(int32 V) const;
+
+    /** Make every use of Old a use of New (applied by ApplyReplacements) */
+    void Replace(int32 Old, int32 New);
+
+    /** Rewrite operands and block values through Forward */
+    void ApplyReplacements();
+
+    /** Readable listing of the blocks and instructions */
+    FString Dump() const;
+};
+
+/**
+ * Builds the SSA form of one function from its AST
+ *
+ * Uses the compiler's own symbol table and type inference, so it resolves names,
+ * infers conversions and inlines exactly as the direct compiler does. SSA construction
+ * follows Braun et al., "Simple and Efficient Construction of Static Single Assignment
+ * Form": definitions are tracked per block, and blocks are sealed once all their
+ * predecessors are known.
+ */
+class SCRIPTING_API FScriptIRBuilder
+{
+public:
+    /**
+     * Build Function (already registered at FuncIndex) into OutFunction
+     * @return false if the function uses something the IR does not model - the caller
+     *         compiles it directly (errors reported meanwhile must be discarded)
+     */
+    static bool Build(FScriptCompiler& Compiler, FFunctionDecl* Function, int32 FuncIndex, FScriptIRFunction& OutFunction, FString& OutReason);
+
+private:
+    struct FVariable
+    {
+        int32 PinnedSlot;   // -1 = an SSA variable
+    };
+
+    struct FLoop
+    {
+        int32 BreakBlock;
+        int32 ContinueBlock;
+    };
+
+    FScriptIRBuilder(FScriptCompiler& InCompiler, FScriptIRFunction& InFunction);
+
+    FScriptCompiler& Compiler;
+    FScriptIRFunction& F;
+
+    TArray<FVariable> Variables;
+    TArray<int32> LocalVariables;       // Variable of each compiler local, parallel to its Locals
+    TArray<TMap<int32, int32>> Defs;    // Per block: variable -> current value
+    TArray<TMap<int32, int32>> IncompletePhis;
+    TArray<bool> Sealed;
+    TArray<FLoop> Loops;
+
+    int32 CurrentBlock;                 // -1 after return/break/continue
+    int32 PinnedDepth;
+    int32 InlineDepth;
+    int32 CurrentLine;
+    int32 CurrentFile;
+    FString FailReason;
+
+    bool Fail(const FString& Reason);
+    bool Failed() const { return !FailReason.IsEmpty(); }
+
+    // Blocks and instructions
+    int32 NewBlock();
+    void StartBlock(int32 Block);
+    void AddEdge(int32 From, int32 To);
+    void SealBlock(int32 Block);
+    void Jump(int32 Target);
+    void Branch(int32 Condition, int32 TrueBlock, int32 FalseBlock);
+    int32 Emit(EOpCode OpCode, const TArray<int32>& Operands, int32 Imm = 0, int32 Imm2 = 0, bool bPure = true);
+    int32 EmitConstant(const FScriptValue& Value);
+    int32 EmitConversion(int32 Value, EScriptType From, EScriptType To);
+    int32 AddInstr(int32 Block, const FScriptIRInstr& Instr);
+    void EnsureBlock();
+
+    // SSA construction
+    int32 NewVariable(int32 PinnedSlot = -1);
+    int32 AddLocal(const FString& Name, EScriptType Type, int32 Variable);
+    void PopLocals(int32 Depth);
+    void WriteVariable(int32 Variable, int32 Block, int32 Value);
+    int32 ReadVariable(int32 Variable, int32 Block);
+    int32 ReadVariableRecursive(int32 Variable, int32 Block);
+    int32 NewPhi(int32 Block, int32 Variable);
+    int32 AddPhiOperands(int32 Variable, int32 Phi);
+    int32 TryRemoveTrivialPhi(int32 Phi);
+    int32 Undefined(int32 Block);
+    int32 ReadLocal(int32 LocalIndex);
+    void WriteLocal(int32 LocalIndex, int32 Value);
+
+    // Statements
+    void BuildFunction(FFunctionDecl* Function, int32 FuncIndex);
+    void BuildStatement(FScriptStatement* Statement);
+    void BuildBlock(FBlockStmt* Stmt);
+    void BuildVarDecl(FVarDeclStmt* Stmt);
+    void BuildIf(FIfStmt* Stmt);
+    void BuildWhile(FScriptExpression* Condition, FScriptStatement* Body, FScriptExpression* Increment);
+    void BuildFor(FForStmt* Stmt);
+    void BuildForEach(FForEachStmt* Stmt);
+    void BuildReturn(FReturnStmt* Stmt);
+
+    // Expressions
+    int32 BuildExpression(FScriptExpression* Expression);
+    int32 BuildLiteral(FLiteralExpr* Expr);
+    int32 BuildBinary(FBinaryExpr* Expr);
+    int32 BuildUnary(FUnaryExpr* Expr);
+    int32 BuildIdentifier(FIdentifierExpr* Expr);
+    int32 BuildAssign(FAssignExpr* Expr);
+    int32 BuildCall(FCallExpr* Expr);
+    int32 BuildInlineCall(int32 FuncIndex, const TArray<int32>& Arguments);
+    int32 StoreVariable(const FString& Name, int32 Value);
+};
+
+/**
+ * Machine-independent optimizations on a function in SSA form
+ *
+ * - Trivial phi removal (copy propagation: a copy is just another name for its value)
+ * - Common subexpression elimination over the dominator tree
+ * - Loop-invariant code motion into the loop preheader
+ * - Dead store elimination for globals overwritten in the same block
+ * - Dead code elimination
+ *
+ * Pure operations are merged and moved only where the original code would have evaluated
+ * them anyway, before any side effect, so runtime errors and output keep their order.
+ * An unused operation that can raise a runtime error is kept.
+ */
+class SCRIPTING_API FScriptIROptimizer
+{
+public:
+    static void Optimize(FScriptIRFunction& Function);
+
+    /** Drop blocks the entry cannot reach, and their phi operands */
+    static void RemoveUnreachableBlocks(FScriptIRFunction& Function);
+
+    /** Replace phis whose operands are all one value (or the phi itself) by that value */
+    static void RemoveTrivialPhis(FScriptIRFunction& Function);
+
+    static void EliminateCommonSubexpressions(FScriptIRFunction& Function);
+    static void HoistLoopInvariants(FScriptIRFunction& Function);
+    static void EliminateDeadStores(FScriptIRFunction& Function);
+    static void EliminateDeadCode(FScriptIRFunction& Function);
+
+    /** Immediate dominator of each block (-1 = unreachable), computed over Layout */
+    static TArray<int32> ComputeDominators(const FScriptIRFunction& Function);
+    static bool Dominates(const TArray<int32>& Idom, int32 A, int32 B);
+};
+
+/**
+ * Lowers a function in SSA form to stack bytecode
+ *
+ * A value used once, right where it is computed, stays on the operand stack as part of
+ * its user's expression tree. Every other value gets a frame slot: live ranges are
+ * computed per block, and slots are handed out linearly, reusing a slot as soon as the
+ * value in it is dead (phi operands prefer the slot of their phi, so most loop-carried
+ * copies vanish). Literals are pushed again at each use.
+ */
+class SCRIPTING_API FScriptIRLowering
+{
+public:
+    /**
+     * Append the function's code to Chunk
+     * @return false (nothing appended) if it needs more slots than one-byte operands address
+     */
+    static bool Lower(FScriptIRFunction& Function, FBytecodeChunk& Chunk, FString& OutReason);
+};
+
+/**
+ * Lowers a function in SSA form to register code (FBytecodeChunk::RegisterCode)
+ *
+ * Uses the frame layout of the stack lowering with every value in a slot, so register r
+ * is frame slot r. Literals get one register each, loaded at entry; a compare used only
+ * by the branch after it becomes a compare-and-jump, and 'return f(...)' a tail call.
+ */
+class SCRIPTING_API FScriptIRRegisterLowering
+{
+public:
+    /**
+     * Append the function's register code to Chunk.RegisterCode
+     * @return false (nothing appended) if the function needs more than 256 registers
+     *         or uses an operation without a register form
+     */
+    static bool Lower(FScriptIRFunction& Function, FBytecodeChunk& Chunk, int32& OutNumRegisters, FString& OutReason);
+};
@@ -30,7 +30,7 @@
  * 
  * COMMENTS:
  *   // Single-line comment
- *   /* Multi-line comment * /
+ *   Block comments, slash-star ... star-slash, may span lines
  * 
  * DATA TYPES:
  *   int      - Integer numbers
@@ -96,9 +96,16 @@ class SCRIPTING_API FScriptLexer
 public:
     FScriptLexer(const FString& InSource);
     
-    /** Tokenize the entire source code */
+    /** Tokenize the entire source code (moves the tokens out: call once) */
     TArray<FScriptToken> ScanTokens();
     
+    /**
+     * Scan the next token, for a parser pulling tokens as it goes (FScriptParser(FScriptLexer&)).
+     * Returns END_OF_FILE at the end, and again on every later call. Errors collect as the
+     * tokens are scanned, so check HasErrors after parsing.
+     */
+    FScriptToken NextToken();
+    
     /** Get all error messages */
     const TArray<FString>& GetErrors() const { return Errors; }
     
@@ -124,7 +131,7 @@ private:
     
     void ScanToken();
     void AddToken(ETokenType Type);
-    void AddToken(ETokenType Type, const FString& Lexeme);
+    void AddToken(ETokenType Type, FString Lexeme);
     void ScanString();
     void ScanNumber();
     void ScanIdentifier();
@@ -134,6 +141,6 @@ private:
     static bool IsDigit(char C);
     static bool IsAlpha(char C);
     static bool IsAlphaNumeric(char C);
-    static ETokenType GetKeywordType(const FString& Text);
+    static ETokenType GetKeywordType(const TCHAR* Text, int32 Length);
 };
 
@@ -7,9 +7,7 @@
 #include "Subsystems/GameInstanceSubsystem.h"
 #include "ScriptBytecode.h"
 #include "ScriptVM.h"
-
-// Delegate for registering native functions
-DECLARE_MULTICAST_DELEGATE_OneParam(FNativeAPIRegistrationDelegate, class FScriptVM*);
+#include "ScriptCompileDatabase.h"
 
 #include "ScriptManager.generated.h"
 
@@ -28,6 +26,9 @@ struct FCompiledScript
 	/** Compiled bytecode (shared pointer for efficient copying) */
 	TSharedPtr<FBytecodeChunk> Bytecode;
 	
+	/** Validated program image with natives resolved - shared by every instance of this script */
+	TSharedPtr<const FScriptProgramImage> Program;
+	
 	/** VM instance for this script (isolated execution) */
 	TSharedPtr<FScriptVM> VM;
 	
@@ -54,9 +55,6 @@ class SCRIPTING_API UScriptManager : public UGameInstanceSubsystem
 	GENERATED_BODY()
 
 public:
-    /** Delegate called to allow external modules to register native functions. */
-    FNativeAPIRegistrationDelegate OnRegisterNativeAPI;
-
 	//=============================================================================
 	// Subsystem Lifecycle
 	//=============================================================================
@@ -140,6 +138,19 @@ public:
 	 */
 	UFUNCTION(BlueprintCallable, Category = "Scripting")
 	void StopScript(const FString& ScriptName);
+	
+	/**
+	 * Run a loaded script in a new, independent VM instance
+	 * The instance shares the script's program image (code, constants, natives) and only
+	 * owns its own stack, frames and globals - use this to run one script on many actors.
+	 * @return The instance (keep it alive for latent/paused scripts), nullptr on failure
+	 */
+	TSharedPtr<FScriptVM> SpawnScriptInstance(const FString& ScriptName, bool bCallMain = true);
+	
+	/**
+	 * Get the shared program image of a loaded script
+	 */
+	TSharedPtr<const FScriptProgramImage> GetScriptProgram(const FString& ScriptName) const;
 
 	//=============================================================================
 	// Script Management
@@ -169,6 +180,18 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Scripting")
 	TArray<FString> GetScriptErrors(const FString& ScriptName) const;
 
+	/**
+	 * Capture a script's VM state (stack, frames, globals, collections) into a portable blob.
+	 * The script must not be mid-instruction; paused or finished scripts are fine.
+	 */
+	bool SaveScriptSnapshot(const FString& ScriptName, TArray<uint8>& OutData) const;
+	
+	/**
+	 * Restore a script's VM state from a blob produced by SaveScriptSnapshot.
+	 * Fails if the script's bytecode has changed since the snapshot was taken.
+	 */
+	bool RestoreScriptSnapshot(const FString& ScriptName, const TArray<uint8>& InData);
+
 	//=============================================================================
 	// Bytecode Caching
 	//=============================================================================
@@ -184,7 +207,8 @@ public:
 	TSharedPtr<FBytecodeChunk> LoadBytecodeCache(const FString& ScriptPath);
 	
 	/**
-	 * Check if bytecode cache is up to date
+	 * Check if the compiled bytecode (Scripts/Compiled/<Name>.scc) is still what the source
+	 * compiles to: same source, same imported files, same compiler (see FScriptCompileDatabase)
 	 */
 	bool IsCacheValid(const FString& ScriptPath) const;
 
@@ -215,8 +239,11 @@ private:
 	// Internal Methods
 	//=============================================================================
 	
-	/** Compile source code to bytecode */
-	TSharedPtr<FBytecodeChunk> CompileScript(const FString& SourceCode, TArray<FString>& OutErrors);
+	/**
+	 * Compile source code to bytecode
+	 * @param OutImports Files it imported, directly or not, for the compile database
+	 */
+	TSharedPtr<FBytecodeChunk> CompileScript(const FString& SourceCode, TArray<FString>& OutErrors, TArray<FString>* OutImports = nullptr);
 	
 	/** Resolve script path (handle relative paths, Scripts folder, etc.) */
 	FString ResolveScriptPath(const FString& ScriptPath) const;
@@ -224,8 +251,11 @@ private:
 	/** Get cache file path for a script */
 	FString GetCacheFilePath(const FString& ScriptPath) const;
 	
-	/** Initialize VM with native functions */
-	void InitializeVM(TSharedPtr<FScriptVM> VM);
+	/** Compile database next to the compiled bytecode (Scripts/Compiled) */
+	FString GetCompileDatabasePath() const;
+	
+	/** Validate bytecode and build its shared program image */
+	TSharedPtr<const FScriptProgramImage> CreateProgram(const FString& ScriptName, TSharedPtr<FBytecodeChunk> Bytecode);
 
 	//=============================================================================
 	// Member Variables
@@ -251,7 +281,11 @@ private: // Re-add private specifier for member variables
 	UPROPERTY()
 	FString CacheFolder;
 	
+	/** What the scripts in Scripts/Compiled were compiled from, shared with the module's startup build */
+	FScriptCompileDatabase CompileDB;
+	
 	/** Console command handles */
 	TArray<IConsoleObject*> ConsoleCommands;
+
 };
 
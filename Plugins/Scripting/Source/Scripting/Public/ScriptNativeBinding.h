@@ -0,0 +1,257 @@
+// Copyright Vampire Game Project. All Rights Reserved.
+// Custom scripting system for secure modding support.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ScriptNativeRegistry.h"
+
+/**
+ * Typed Native Bindings
+ * =====================
+ *
+ * Wraps an ordinary C++ function as a native:
+ *
+ *     static float Dist(FVector A, FVector B);
+ *     Registry.BindTyped(TEXT("Vector_Dist"), &Dist);
+ *
+ * Argument unpacking, arity/type checks and result boxing are generated from
+ * the function signature. A function may take FScriptVM* as its first
+ * parameter if it needs the VM (errors, latent calls); it is not counted as
+ * a script argument.
+ *
+ * Each binding produces two entry points:
+ * - Checked   - verifies arity and argument types, reports a runtime error on mismatch
+ * - Unchecked - unpacks straight away; used for call sites where the compiler
+ *               already proved the argument types (see NATIVE_CALL_ARGS_CHECKED)
+ *
+ * Supported parameter/result types are the TScriptNativeArg / TScriptNativeResult
+ * specializations below. Modules add their own (FVector lives with the math natives).
+ */
+
+/**
+ * Script argument -> C++ parameter
+ *
+ * Type    - script type the compiler checks arguments against
+ * Matches - runtime type check for call sites the compiler could not prove
+ * Get     - unpack the value; must be safe on ANY value, since proven call sites skip Matches
+ */
+template<typename T>
+struct TScriptNativeArg;
+
+template<>
+struct TScriptNativeArg<double>
+{
+    static constexpr EScriptType Type = EScriptType::FLOAT;
+    static bool Matches(const FScriptValue& Value) { return Value.IsNumber(); }
+    static double Get(const FScriptValue& Value) { return Value.AsNumber(); }
+};
+
+template<>
+struct TScriptNativeArg<float>
+{
+    static constexpr EScriptType Type = EScriptType::FLOAT;
+    static bool Matches(const FScriptValue& Value) { return Value.IsNumber(); }
+    static float Get(const FScriptValue& Value) { return (float)Value.AsNumber(); }
+};
+
+template<>
+struct TScriptNativeArg<int32>
+{
+    static constexpr EScriptType Type = EScriptType::INT;
+    static bool Matches(const FScriptValue& Value) { return Value.IsNumber(); }
+    static int32 Get(const FScriptValue& Value) { return (int32)Value.AsNumber(); }
+};
+
+template<>
+struct TScriptNativeArg<bool>
+{
+    static constexpr EScriptType Type = EScriptType::BOOL;
+    static bool Matches(const FScriptValue& Value) { return Value.IsBool(); }
+    static bool Get(const FScriptValue& Value) { return Value.IsTruthy(); }
+};
+
+/** Any value, as its ToString: string natives have always taken numbers and bools as text */
+template<>
+struct TScriptNativeArg<FString>
+{
+    static constexpr EScriptType Type = EScriptType::AUTO;
+    static bool Matches(const FScriptValue& /*Value*/) { return true; }
+    static FString Get(const FScriptValue& Value) { return Value.ToString(); }
+};
+
+/** Untyped passthrough - accepts anything, the function inspects the value itself */
+template<>
+struct TScriptNativeArg<FScriptValue>
+{
+    static constexpr EScriptType Type = EScriptType::AUTO;
+    static bool Matches(const FScriptValue& /*Value*/) { return true; }
+    static const FScriptValue& Get(const FScriptValue& Value) { return Value; }
+};
+
+/**
+ * C++ result -> script value
+ *
+ * Type - script type the compiler assumes for the call expression
+ * Call - invoke the function and box its result
+ */
+template<typename T>
+struct TScriptNativeResult;
+
+template<typename T>
+struct TScriptNativeNumberResult
+{
+    static constexpr EScriptType Type = EScriptType::FLOAT;
+
+    template<typename FuncType, typename... CallArgTypes>
+    static FScriptValue Call(FuncType&& Function, CallArgTypes&&... CallArgs)
+    {
+        return FScriptValue::Number((double)Function(Forward<CallArgTypes>(CallArgs)...));
+    }
+};
+
+template<> struct TScriptNativeResult<double> : TScriptNativeNumberResult<double> {};
+template<> struct TScriptNativeResult<float> : TScriptNativeNumberResult<float> {};
+
+template<>
+struct TScriptNativeResult<int32> : TScriptNativeNumberResult<int32>
+{
+    static constexpr EScriptType Type = EScriptType::INT;
+};
+
+template<>
+struct TScriptNativeResult<bool>
+{
+    static constexpr EScriptType Type = EScriptType::BOOL;
+
+    template<typename FuncType, typename... CallArgTypes>
+    static FScriptValue Call(FuncType&& Function, CallArgTypes&&... CallArgs)
+    {
+        return FScriptValue::Bool(Function(Forward<CallArgTypes>(CallArgs)...));
+    }
+};
+
+template<>
+struct TScriptNativeResult<FString>
+{
+    static constexpr EScriptType Type = EScriptType::STRING;
+
+    template<typename FuncType, typename... CallArgTypes>
+    static FScriptValue Call(FuncType&& Function, CallArgTypes&&... CallArgs)
+    {
+        return FScriptValue::String(Function(Forward<CallArgTypes>(CallArgs)...));
+    }
+};
+
+template<>
+struct TScriptNativeResult<FScriptValue>
+{
+    static constexpr EScriptType Type = EScriptType::AUTO;
+
+    template<typename FuncType, typename... CallArgTypes>
+    static FScriptValue Call(FuncType&& Function, CallArgTypes&&... CallArgs)
+    {
+        return Function(Forward<CallArgTypes>(CallArgs)...);
+    }
+};
+
+template<>
+struct TScriptNativeResult<void>
+{
+    static constexpr EScriptType Type = EScriptType::VOID;
+
+    template<typename FuncType, typename... CallArgTypes>
+    static FScriptValue Call(FuncType&& Function, CallArgTypes&&... CallArgs)
+    {
+        Function(Forward<CallArgTypes>(CallArgs)...);
+        return FScriptValue::Nil();
+    }
+};
+
+namespace ScriptNativeBinding
+{
+    template<typename T>
+    using TArgOf = TScriptNativeArg<typename TDecay<T>::Type>;
+
+    template<typename T>
+    using TResultOf = TScriptNativeResult<typename TDecay<T>::Type>;
+
+    /** Index of the first argument that fails its type check, INDEX_NONE if all match */
+    template<typename... ArgTypes, uint32... Indices>
+    int32 FindMismatch(const TArray<FScriptValue>& Args, TIntegerSequence<uint32, Indices...>)
+    {
+        // Leading entry keeps the array non-empty for zero-argument natives
+        const bool Matches[] = { true, TArgOf<ArgTypes>::Matches(Args[Indices])... };
+        for (int32 i = 1; i <= (int32)sizeof...(ArgTypes); ++i)
+        {
+            if (!Matches[i])
+            {
+                return i - 1;
+            }
+        }
+        return INDEX_NONE;
+    }
+
+    template<typename RetType, typename... ArgTypes, uint32... Indices>
+    FScriptValue Invoke(RetType (*Function)(ArgTypes...), FScriptVM* /*VM*/, const TArray<FScriptValue>& Args,
+        TIntegerSequence<uint32, Indices...>)
+    {
+        return TResultOf<RetType>::Call(Function, TArgOf<ArgTypes>::Get(Args[Indices])...);
+    }
+
+    template<typename RetType, typename... ArgTypes, uint32... Indices>
+    FScriptValue Invoke(RetType (*Function)(FScriptVM*, ArgTypes...), FScriptVM* VM, const TArray<FScriptValue>& Args,
+        TIntegerSequence<uint32, Indices...>)
+    {
+        return TResultOf<RetType>::Call(Function, VM, TArgOf<ArgTypes>::Get(Args[Indices])...);
+    }
+
+    /** Build both entry points for a function whose script-visible parameters are ArgTypes */
+    template<typename RetType, typename FunctionType, typename... ArgTypes>
+    FNativeTypedBinding MakeBinding(const FString& Name, FunctionType Function)
+    {
+        typedef TMakeIntegerSequence<uint32, sizeof...(ArgTypes)> FIndices;
+
+        FNativeTypedBinding Binding;
+        Binding.ReturnType = TResultOf<RetType>::Type;
+        Binding.ParamTypes = { TArgOf<ArgTypes>::Type... };
+
+        Binding.Unchecked = [Function](FScriptVM* VM, const TArray<FScriptValue>& Args)
+        {
+            return Invoke(Function, VM, Args, FIndices());
+        };
+
+        Binding.Checked = [Name, Function](FScriptVM* VM, const TArray<FScriptValue>& Args)
+        {
+            if (Args.Num() != (int32)sizeof...(ArgTypes))
+            {
+                FScriptNativeRegistry::ReportArgumentCount(VM, Name, sizeof...(ArgTypes), Args.Num());
+                return FScriptValue::Nil();
+            }
+
+            const int32 Mismatch = FindMismatch<ArgTypes...>(Args, FIndices());
+            if (Mismatch != INDEX_NONE)
+            {
+                const EScriptType Expected[] = { EScriptType::AUTO, TArgOf<ArgTypes>::Type... };
+                FScriptNativeRegistry::ReportArgumentType(VM, Name, Mismatch, Expected[Mismatch + 1], Args[Mismatch]);
+                return FScriptValue::Nil();
+            }
+
+            return Invoke(Function, VM, Args, FIndices());
+        };
+
+        return Binding;
+    }
+}
+
+template<typename RetType, typename... ArgTypes>
+bool FScriptNativeRegistry::BindTyped(const FString& Name, RetType (*Function)(ArgTypes...))
+{
+    return BindSignature(Name, ScriptNativeBinding::MakeBinding<RetType, RetType (*)(ArgTypes...), ArgTypes...>(Name, Function));
+}
+
+template<typename RetType, typename... ArgTypes>
+bool FScriptNativeRegistry::BindTyped(const FString& Name, RetType (*Function)(FScriptVM*, ArgTypes...))
+{
+    return BindSignature(Name, ScriptNativeBinding::MakeBinding<RetType, RetType (*)(FScriptVM*, ArgTypes...), ArgTypes...>(Name, Function));
+}
@@ -0,0 +1,193 @@
+// Copyright Vampire Game Project. All Rights Reserved.
+// Custom scripting system for secure modding support.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ScriptBytecode.h"
+#include "ScriptAST.h"  // For EScriptType enum
+
+class FScriptVM;
+
+/**
+ * Native function signature
+ * Takes VM context and array of arguments, returns a value
+ */
+typedef TFunction<FScriptValue(FScriptVM* VM, const TArray<FScriptValue>&)> FNativeFunction;
+
+/**
+ * Native function properties (see ScriptNatives.inl)
+ */
+enum class ENativeFlags : uint8
+{
+    None        = 0,
+    Pure        = 1 << 0,   // No side effects and no runtime errors - same arguments always give the same result
+    ThreadSafe  = 1 << 1,   // May be called from a VM running off the game thread
+    Latent      = 1 << 2    // May pause the calling VM (Sleep)
+};
+ENUM_CLASS_FLAGS(ENativeFlags);
+
+/**
+ * Compile-time description of a native (what the compiler needs to know)
+ */
+struct SCRIPTING_API FNativeFunctionDecl
+{
+    FString Name;
+    int32 MinArgs;
+    int32 MaxArgs;              // -1 = variadic
+    EScriptType ReturnType;     // AUTO = depends on arguments
+    ENativeFlags Flags;
+
+    /** Parameter types, filled in when a typed binding is bound (see ScriptNativeBinding.h) */
+    TArray<EScriptType> ParamTypes;
+    bool bHasSignature;
+
+    FNativeFunctionDecl()
+        : MinArgs(0)
+        , MaxArgs(-1)
+        , ReturnType(EScriptType::AUTO)
+        , Flags(ENativeFlags::None)
+        , bHasSignature(false)
+    {}
+
+    FNativeFunctionDecl(const FString& InName, int32 InMinArgs, int32 InMaxArgs, EScriptType InReturnType, ENativeFlags InFlags)
+        : Name(InName)
+        , MinArgs(InMinArgs)
+        , MaxArgs(InMaxArgs)
+        , ReturnType(InReturnType)
+        , Flags(InFlags)
+        , bHasSignature(false)
+    {}
+
+    bool AcceptsArgCount(int32 Count) const { return Count >= MinArgs && (MaxArgs < 0 || Count <= MaxArgs); }
+    bool IsVoid() const { return ReturnType == EScriptType::VOID; }
+    bool IsPure() const { return EnumHasAnyFlags(Flags, ENativeFlags::Pure); }
+    bool IsThreadSafe() const { return EnumHasAnyFlags(Flags, ENativeFlags::ThreadSafe); }
+    bool IsLatent() const { return EnumHasAnyFlags(Flags, ENativeFlags::Latent); }
+
+    /** True if argument types are known, so the compiler can check call sites */
+    bool HasSignature() const { return bHasSignature; }
+};
+
+/**
+ * Registry entry: declaration plus the bound implementation
+ */
+struct SCRIPTING_API FNativeFunctionEntry
+{
+    /** Dense ID - index into the registry */
+    int32 Id;
+
+    FNativeFunctionDecl Decl;
+
+    /** Implementation, unset if the native is declared but nothing was bound */
+    FNativeFunction Function;
+
+    /** Typed bindings only: skips argument checks, for call sites the compiler proved */
+    FNativeFunction UncheckedFunction;
+
+    FNativeFunctionEntry()
+        : Id(INDEX_NONE)
+    {}
+};
+
+/**
+ * Both entry points of a typed binding, plus its signature
+ */
+struct SCRIPTING_API FNativeTypedBinding
+{
+    FNativeFunction Checked;
+    FNativeFunction Unchecked;
+    TArray<EScriptType> ParamTypes;
+    EScriptType ReturnType;
+
+    FNativeTypedBinding()
+        : ReturnType(EScriptType::AUTO)
+    {}
+};
+
+/**
+ * Process-Wide Native Function Registry
+ * =====================================
+ *
+ * Every VM resolves natives against one registry, built once and then frozen:
+ *
+ * 1. The declaration table (ScriptNatives.inl) seeds one entry per native.
+ *    IDs are the table order, so they are the same in every process and in
+ *    the compiler, which reads the same table.
+ * 2. Modules Bind() implementations by name during startup.
+ * 3. Freeze() locks the table. After that it is read-only and safe to share
+ *    between threads; programs cache entry pointers into it.
+ *
+ * Registration happens once per process instead of once per VM.
+ */
+class SCRIPTING_API FScriptNativeRegistry
+{
+public:
+    /** The process-wide registry */
+    static FScriptNativeRegistry& Get();
+
+    /** Declarations from ScriptNatives.inl, in ID order (no registry instance needed - used by the compiler) */
+    static const TArray<FNativeFunctionDecl>& GetDeclarations();
+
+    /** Find a declaration by name, nullptr if the name is not a declared native */
+    static const FNativeFunctionDecl* FindDeclaration(const FString& Name);
+
+    /** Seeds the registry from the declaration table */
+    FScriptNativeRegistry();
+
+    /**
+     * Bind an implementation to a native
+     * Undeclared names are accepted with permissive metadata (variadic, impure, AUTO return)
+     * but logged, since the compiler will not know about them.
+     * @return false if the registry is frozen or the native is already bound
+     */
+    bool Bind(const FString& Name, FNativeFunction Function);
+
+    /**
+     * Bind an ordinary C++ function - argument unpacking, checks and result boxing
+     * are generated from its signature (see ScriptNativeBinding.h).
+     * The signature is recorded so the compiler can type-check call sites.
+     */
+    template<typename RetType, typename... ArgTypes>
+    bool BindTyped(const FString& Name, RetType (*Function)(ArgTypes...));
+
+    /** As above, for functions that take the calling VM as their first parameter */
+    template<typename RetType, typename... ArgTypes>
+    bool BindTyped(const FString& Name, RetType (*Function)(FScriptVM*, ArgTypes...));
+
+    /** Lock the registry. Logs declared natives that were never bound. */
+    void Freeze();
+    bool IsFrozen() const { return bFrozen; }
+
+    /** ID of a native by name, INDEX_NONE if unknown */
+    int32 FindId(const FString& Name) const;
+
+    /** Entry by ID, nullptr if out of range */
+    const FNativeFunctionEntry* GetEntry(int32 Id) const { return Entries.IsValidIndex(Id) ? &Entries[Id] : nullptr; }
+
+    /** Entry by name, nullptr if unknown */
+    const FNativeFunctionEntry* FindEntry(const FString& Name) const { return GetEntry(FindId(Name)); }
+
+    int32 Num() const { return Entries.Num(); }
+
+    /**
+     * Hash of every declaration as bound (IDs, arity, types, flags): compiled code depends
+     * on them through native IDs, checked-call bits and arity errors
+     */
+    uint64 GetDeclarationHash() const;
+
+    /** Runtime errors raised by the checked entry point of typed bindings */
+    static void ReportArgumentCount(FScriptVM* VM, const FString& Name, int32 Expected, int32 Got);
+    static void ReportArgumentType(FScriptVM* VM, const FString& Name, int32 ArgIndex, EScriptType Expected, const FScriptValue& Got);
+
+private:
+    /** Non-template part of BindTyped: validates the signature against the declaration table */
+    bool BindSignature(const FString& Name, FNativeTypedBinding Binding);
+
+    TArray<FNativeFunctionEntry> Entries;
+    TMap<FString, int32> NameToId;
+    bool bFrozen;
+};
+
+// Typed binding templates (BindTyped)
+#include "ScriptNativeBinding.h"
@@ -0,0 +1,148 @@
+// Copyright Vampire Game Project. All Rights Reserved.
+// Custom scripting system for secure modding support.
+
+// Native Function Declarations
+// ============================
+// Single source of truth for every native the game exposes to scripts.
+// The compiler uses it to recognise natives and check call arity, and the
+// native registry uses it to assign IDs and metadata before the game module
+// binds the implementations (see FScriptNativeRegistry).
+//
+// Native IDs are the row order of this table - append new natives to the end
+// of their group, and never reorder rows.
+//
+// SCRIPT_NATIVE(Name, MinArgs, MaxArgs, ReturnType, Flags)
+//   MaxArgs    - -1 for variadic
+//   ReturnType - EScriptType, AUTO when the result type depends on the arguments
+//   Flags      - ENativeFlags: Pure (no side effects, never fails), ThreadSafe, Latent (may pause the VM)
+//                A native that can raise a runtime error (divide by zero, ...) is not Pure,
+//                or the optimizer could move it out of the branch that guards it
+//
+// Include with SCRIPT_NATIVE defined; it is undefined again at the end of this file.
+
+#ifndef SCRIPT_NATIVE
+    #error "Define SCRIPT_NATIVE(Name, MinArgs, MaxArgs, ReturnType, Flags) before including ScriptNatives.inl"
+#endif
+
+// Utility
+SCRIPT_NATIVE(Log,                  1,  1, VOID,        None)
+SCRIPT_NATIVE(Print,                1,  1, VOID,        None)
+SCRIPT_NATIVE(Sleep,                1,  1, VOID,        Latent)
+
+// Script Management
+SCRIPT_NATIVE(LoadScript,           1,  1, BOOL,        None)
+SCRIPT_NATIVE(RunScript,            1,  1, BOOL,        None)
+SCRIPT_NATIVE(DoesScriptExist,      1,  1, BOOL,        None)
+SCRIPT_NATIVE(IsScriptRunning,      1,  1, BOOL,        None)
+SCRIPT_NATIVE(CanRunScript,         1,  1, BOOL,        None)
+SCRIPT_NATIVE(IsMissionScript,      1,  1, BOOL,        None)
+
+// Collections - List
+SCRIPT_NATIVE(List_Create,          0,  0, INT,         None)
+SCRIPT_NATIVE(List_Add,             2,  2, BOOL,        None)
+SCRIPT_NATIVE(List_Get,             2,  2, AUTO,        None)
+SCRIPT_NATIVE(List_Set,             3,  3, BOOL,        None)
+SCRIPT_NATIVE(List_RemoveAt,        2,  2, BOOL,        None)
+SCRIPT_NATIVE(List_Count,           1,  1, INT,         None)
+SCRIPT_NATIVE(List_Clear,           1,  1, BOOL,        None)
+SCRIPT_NATIVE(List_Contains,        2,  2, BOOL,        None)
+
+// Collections - Dictionary
+SCRIPT_NATIVE(Dict_Create,          0,  0, INT,         None)
+SCRIPT_NATIVE(Dict_Set,             3,  3, BOOL,        None)
+SCRIPT_NATIVE(Dict_Get,             2,  2, AUTO,        None)
+SCRIPT_NATIVE(Dict_Remove,          2,  2, BOOL,        None)
+SCRIPT_NATIVE(Dict_HasKey,          2,  2, BOOL,        None)
+SCRIPT_NATIVE(Dict_Clear,           1,  1, BOOL,        None)
+SCRIPT_NATIVE(Dict_Count,           1,  1, INT,         None)
+
+// Math - Basic
+SCRIPT_NATIVE(Add,                  2,  2, FLOAT,       Pure | ThreadSafe)
+SCRIPT_NATIVE(Subtract,             2,  2, FLOAT,       Pure | ThreadSafe)
+SCRIPT_NATIVE(Multiply,             2,  2, FLOAT,       Pure | ThreadSafe)
+SCRIPT_NATIVE(Divide,               2,  2, FLOAT,       ThreadSafe)
+SCRIPT_NATIVE(Mod,                  2,  2, FLOAT,       ThreadSafe)
+SCRIPT_NATIVE(Pow,                  2,  2, FLOAT,       Pure | ThreadSafe)
+
+// Math - Trig
+SCRIPT_NATIVE(Sin,                  1,  1, FLOAT,       Pure | ThreadSafe)
+SCRIPT_NATIVE(Cos,                  1,  1, FLOAT,       Pure | ThreadSafe)
+SCRIPT_NATIVE(Tan,                  1,  1, FLOAT,       Pure | ThreadSafe)
+SCRIPT_NATIVE(Asin,                 1,  1, FLOAT,       Pure | ThreadSafe)
+SCRIPT_NATIVE(Acos,                 1,  1, FLOAT,       Pure | ThreadSafe)
+SCRIPT_NATIVE(Atan,                 1,  1, FLOAT,       Pure | ThreadSafe)
+SCRIPT_NATIVE(Atan2,                2,  2, FLOAT,       Pure | ThreadSafe)
+
+// Math - Helpers
+SCRIPT_NATIVE(Abs,                  1,  1, FLOAT,       Pure | ThreadSafe)
+SCRIPT_NATIVE(Sqrt,                 1,  1, FLOAT,       ThreadSafe)
+SCRIPT_NATIVE(Floor,                1,  1, FLOAT,       Pure | ThreadSafe)
+SCRIPT_NATIVE(Ceil,                 1,  1, FLOAT,       Pure | ThreadSafe)
+SCRIPT_NATIVE(Round,                1,  1, FLOAT,       Pure | ThreadSafe)
+SCRIPT_NATIVE(Clamp,                3,  3, FLOAT,       Pure | ThreadSafe)
+SCRIPT_NATIVE(Min,                  2,  2, FLOAT,       Pure | ThreadSafe)
+SCRIPT_NATIVE(Max,                  2,  2, FLOAT,       Pure | ThreadSafe)
+SCRIPT_NATIVE(DegreesToRadians,     1,  1, FLOAT,       Pure | ThreadSafe)
+SCRIPT_NATIVE(RadiansToDegrees,     1,  1, FLOAT,       Pure | ThreadSafe)
+SCRIPT_NATIVE(Ln,                   1,  1, FLOAT,       Pure | ThreadSafe)
+SCRIPT_NATIVE(Exp,                  1,  1, FLOAT,       Pure | ThreadSafe)
+
+// Math - Random
+SCRIPT_NATIVE(RandomFloat,          0,  0, FLOAT,       None)
+SCRIPT_NATIVE(RandomRange,          2,  2, FLOAT,       None)
+SCRIPT_NATIVE(RandomBool,           0,  0, BOOL,        None)
+
+// Math - Vector
+SCRIPT_NATIVE(Vector,               0,  3, FLOAT_ARRAY, Pure | ThreadSafe)
+SCRIPT_NATIVE(Vector_Add,           2,  2, FLOAT_ARRAY, Pure | ThreadSafe)
+SCRIPT_NATIVE(Vector_Sub,           2,  2, FLOAT_ARRAY, Pure | ThreadSafe)
+SCRIPT_NATIVE(Vector_Mul,           2,  2, FLOAT_ARRAY, Pure | ThreadSafe)
+SCRIPT_NATIVE(Vector_Div,           2,  2, FLOAT_ARRAY, ThreadSafe)
+SCRIPT_NATIVE(Vector_Dot,           2,  2, FLOAT,       Pure | ThreadSafe)
+SCRIPT_NATIVE(Vector_Cross,         2,  2, FLOAT_ARRAY, Pure | ThreadSafe)
+SCRIPT_NATIVE(Vector_Dist,          2,  2, FLOAT,       Pure | ThreadSafe)
+SCRIPT_NATIVE(Vector_DistSquared,   2,  2, FLOAT,       Pure | ThreadSafe)
+SCRIPT_NATIVE(Vector_Normalize,     1,  1, FLOAT_ARRAY, Pure | ThreadSafe)
+SCRIPT_NATIVE(Vector_Length,        1,  1, FLOAT,       Pure | ThreadSafe)
+SCRIPT_NATIVE(Vector_Lerp,          3,  3, FLOAT_ARRAY, Pure | ThreadSafe)
+
+// String
+SCRIPT_NATIVE(String_Len,           1,  1, INT,         Pure | ThreadSafe)
+SCRIPT_NATIVE(String_Sub,           2,  3, STRING,      Pure | ThreadSafe)
+SCRIPT_NATIVE(String_Find,          2,  2, INT,         Pure | ThreadSafe)
+SCRIPT_NATIVE(String_Upper,         1,  1, STRING,      Pure | ThreadSafe)
+SCRIPT_NATIVE(String_Lower,         1,  1, STRING,      Pure | ThreadSafe)
+SCRIPT_NATIVE(String_Replace,       3,  3, STRING,      Pure | ThreadSafe)
+SCRIPT_NATIVE(String_Trim,          1,  1, STRING,      Pure | ThreadSafe)
+SCRIPT_NATIVE(String_Split,         2,  2, INT,         None)
+SCRIPT_NATIVE(String_Contains,      2,  2, BOOL,        Pure | ThreadSafe)
+SCRIPT_NATIVE(String_FromChar,      1,  1, STRING,      Pure | ThreadSafe)
+SCRIPT_NATIVE(String_ToChar,        1,  1, INT,         Pure | ThreadSafe)
+
+// UI
+SCRIPT_NATIVE(UI_SwitchState,       1,  1, BOOL,        None)
+SCRIPT_NATIVE(UI_ShowLoading,       2,  2, BOOL,        None)
+SCRIPT_NATIVE(UI_UpdateLoading,     2,  2, BOOL,        None)
+
+// Audio
+SCRIPT_NATIVE(Audio_PlaySound,      1,  2, BOOL,        None)
+SCRIPT_NATIVE(Audio_PlayMusic,      1,  1, BOOL,        None)
+SCRIPT_NATIVE(Audio_StopMusic,      0,  0, BOOL,        None)
+SCRIPT_NATIVE(Music_Next,           0,  0, BOOL,        None)
+SCRIPT_NATIVE(Music_Prev,           0,  0, BOOL,        None)
+SCRIPT_NATIVE(Music_Pause,          0,  0, BOOL,        None)
+SCRIPT_NATIVE(Music_Resume,         0,  0, BOOL,        None)
+SCRIPT_NATIVE(Music_SetVolume,      1,  1, BOOL,        None)
+SCRIPT_NATIVE(Music_SetShuffle,     1,  1, BOOL,        None)
+SCRIPT_NATIVE(SFX_PlayLoop,         2,  2, INT,         None)
+SCRIPT_NATIVE(SFX_StopLoop,         1,  1, BOOL,        None)
+
+// Light
+SCRIPT_NATIVE(Light_SetColor,       4,  4, BOOL,        None)
+SCRIPT_NATIVE(Light_SetIntensity,   2,  2, BOOL,        None)
+SCRIPT_NATIVE(Light_Toggle,         2,  2, BOOL,        None)
+
+// Decal
+SCRIPT_NATIVE(Decal_Spawn,          0, -1, BOOL,        None)
+
+#undef SCRIPT_NATIVE
@@ -100,10 +100,17 @@
  * 5. For Loop:
  *    ForStmt → "for" "(" (VarDecl | ExprStmt | ";") Expression? ";" Expression? ")" Statement
  *    
+ *    ForEachStmt → "for" "(" ("var" | Type)? IDENTIFIER "in" Expression ")" Statement
+ *    
  *    Example:
  *      for (int i = 0; i < 10; i = i + 1) {
  *          Log("Iteration: " + i);
  *      }
+ *      for (x in Items) {
+ *          Log("Item: " + x);
+ *      }
+ *    
+ *    'in' is only a keyword in this position.
  * 
  * 6. Switch Statement:
  *    SwitchStmt → "switch" "(" Expression ")" "{" CaseClause* DefaultClause? "}"
@@ -184,6 +191,19 @@
  * - Methods call each other recursively to build the AST
  * - Operator precedence is encoded in the method call hierarchy
  * - Error recovery uses synchronization points (semicolons, keywords)
+ * - No backtracking: declarations, casts and for-each headers are told apart by looking
+ *   at most MaxLookahead tokens ahead, so the parser never rewinds
+ * 
+ * TOKEN STREAM:
+ * ------------
+ * Constructed over a lexer, the parser pulls tokens as it needs them and holds only a
+ * small ring: the previous token, the current one and the lookahead. Nothing scales with
+ * the size of the source but the AST. Constructed over a scanned array, it moves the
+ * tokens out of that array through the same ring.
+ * 
+ * Peek(), Previous() and Advance() return references into the ring: they stay valid
+ * until the parser has advanced RingSize - MaxLookahead - 1 more tokens, so copy a token
+ * that must outlive parsing a subexpression (as every AST node does).
  * 
  * NEVER returns invalid pointers - returns nullptr on error
  * Errors are collected in an error list for reporting to the user
@@ -191,7 +211,11 @@
 class SCRIPTING_API FScriptParser
 {
 public:
-    FScriptParser(const TArray<FScriptToken>& InTokens);
+    /** Parse tokens pulled from a lexer on demand (the lexer must outlive Parse) */
+    explicit FScriptParser(FScriptLexer& InLexer);
+    
+    /** Parse tokens already scanned (FScriptLexer::ScanTokens) */
+    explicit FScriptParser(TArray<FScriptToken> InTokens);
     
     /** Parse the entire program */
     TSharedPtr<FScriptProgram> Parse();
@@ -201,17 +225,48 @@ public:
     
     /** Check if there were any errors */
     bool HasErrors() const { return Errors.Num() > 0; }
+    
+    /** Nodes of the last parse (for statistics), nullptr before Parse */
+    const FScriptASTArena* GetArena() const { return Arena.Get(); }
+    
+    /** Tokens pulled from the source so far, END_OF_FILE included */
+    int32 GetNumTokens() const { return NumPulled; }
+    
+    /** Token storage the parser holds at any time (the lexeme strings aside) */
+    static constexpr int32 GetRingBytes() { return RingSize * (int32)sizeof(FScriptToken); }
 
 private:
+    static constexpr int32 RingSize = 8;      // Power of two
+    static constexpr int32 MaxLookahead = 4;  // Tokens past the current one PeekAhead can see
+    
+    // Token source: a lexer, or the tokens of an array not yet pulled
+    FScriptLexer* Lexer;
     TArray<FScriptToken> Tokens;
-    int32 Current;
+    int32 NextTokenIndex;
+    
+    // Lookahead ring, indexed by stream position modulo RingSize
+    FScriptToken Ring[RingSize];
+    int32 Current;       // Stream position of the current token
+    int32 NumPulled;     // Tokens pulled into the ring so far
+    bool bPulledEnd;     // END_OF_FILE has been pulled
+    
     TArray<FString> Errors;
     bool bPanicMode; // For error recovery
+    TSharedPtr<FScriptASTArena> Arena; // Nodes of the last parse, shared with the program
+    
+    /** Construct a node in the arena; the handle does not own it (see FScriptASTArena) */
+    template<typename NodeType, typename... ArgTypes>
+    TSharedPtr<NodeType> NewNode(ArgTypes&&... Args)
+    {
+        return TSharedPtr<NodeType>(TSharedPtr<NodeType>(), Arena->New<NodeType>(Forward<ArgTypes>(Args)...));
+    }
     
     // Utility methods
-    FScriptToken Peek() const;
-    FScriptToken Previous() const;
-    FScriptToken Advance();
+    void PullToken();
+    const FScriptToken& Peek() const;
+    const FScriptToken& PeekAhead(int32 Distance); // Distance 0 is Peek()
+    const FScriptToken& Previous() const;
+    const FScriptToken& Advance();
     bool IsAtEnd() const;
     bool Check(ETokenType Type) const;
     bool Match(ETokenType Type);
@@ -236,6 +291,8 @@ private:
     TSharedPtr<FWhileStmt> ParseWhileStatement();
     TSharedPtr<FScriptStatement> ParseSwitchStatement();
     TSharedPtr<FScriptStatement> ParseForStatement();
+    TSharedPtr<FScriptStatement> ParseForEachStatement();
+    bool CheckForEachHeader();
     TSharedPtr<FReturnStmt> ParseReturnStatement();
     TSharedPtr<FBreakStmt> ParseBreakStatement();
     TSharedPtr<FContinueStmt> ParseContinueStatement();
@@ -263,5 +320,8 @@ private:
     
     // Helper to convert token type to script type
     EScriptType GetTypeFromToken(const FScriptToken& Token);
+    
+    // Helper for casts: '(' followed by one of these starts a type cast
+    static bool IsCastType(ETokenType Type);
 };
 
@@ -0,0 +1,99 @@
+// Copyright Vampire Game Project. All Rights Reserved.
+// Custom scripting system for secure modding support.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ScriptBytecode.h"
+
+/**
+ * What the VM counted for one instruction while profiling (see FScriptVM::SetProfilingEnabled)
+ */
+struct FInstructionCounters
+{
+    uint64 Executed = 0;
+    uint64 Taken = 0;           // OP_JUMP_IF_FALSE: runs that jumped
+    uint32 OperandTypes = 0;    // Arithmetic and comparisons: FScriptProfile::GetTypePairBit of each pair seen
+};
+
+/**
+ * Script Execution Profile
+ * ========================
+ *
+ * The contents of a .scprof file: how a script behaved on a representative run, fed back
+ * into the next build (FScriptCompiler::SetProfile). The workflow is offline:
+ *
+ *   1. Run the script on a profiling VM and fold its counters in with AddRun
+ *   2. SaveToFile, then LoadFromFile when the script is compiled again
+ *
+ * The VM counts per instruction offset; AddRun moves the counts onto source positions
+ * (file and line, from the chunk's LineTable, so the chunk must have it). A profile taken
+ * from one build therefore still applies to the next build, which lays the code out
+ * differently. Sites of the same kind on one line are merged.
+ *
+ * The compiler uses it to:
+ * - move the else arm of an if whose then arm is hot to the end of the function
+ * - emit the _NUMBER opcodes for arithmetic and comparisons that only saw numbers
+ * - inline hot call sites with a larger body budget (MaxHotInlineNodes)
+ */
+class SCRIPTING_API FScriptProfile
+{
+public:
+    /** Conditional jumps on one line */
+    struct FBranch
+    {
+        uint64 Taken = 0;
+        uint64 FallThrough = 0;
+    };
+
+    /** Arithmetic or comparison operators of one kind on one line */
+    struct FOperands
+    {
+        uint32 TypePairs = 0;
+        uint64 Count = 0;
+    };
+
+    /** Fewest runs of a site for its counts to be acted on */
+    static constexpr uint64 MinSamples = 64;
+
+    /**
+     * Add one profiling run
+     * @param Chunk - Code the counters were recorded against
+     * @param Counters - FScriptVM::GetProfileCounters
+     */
+    void AddRun(const FBytecodeChunk& Chunk, const TArray<FInstructionCounters>& Counters);
+
+    /** Write the .scprof text format */
+    bool SaveToFile(const FString& Path) const;
+
+    /** Read a .scprof file, adding to what is already here; false (with OutError) if it cannot be read */
+    bool LoadFromFile(const FString& Path, FString& OutError);
+
+    bool IsEmpty() const { return Branches.Num() == 0 && Operands.Num() == 0 && Calls.Num() == 0; }
+
+    /** Conditional jumps on a line, or nullptr if none ran */
+    const FBranch* FindBranch(const FString& SourceFile, int32 Line) const;
+
+    /** True if every OpCode (generic form) on the line ran at least MinSamples times, on numbers only */
+    bool IsNumberOnly(const FString& SourceFile, int32 Line, EOpCode OpCode) const;
+
+    /** Calls made to Callee from a line */
+    uint64 GetCallCount(const FString& SourceFile, int32 Line, const FString& Callee) const;
+
+    /** Calls recorded over the whole profile */
+    uint64 GetTotalCalls() const { return TotalCalls; }
+
+    /** Bit recorded in FInstructionCounters::OperandTypes for a (left, right) pair */
+    static uint32 GetTypePairBit(EValueType Left, EValueType Right)
+    {
+        return 1u << (static_cast<uint32>(Left) * 5 + static_cast<uint32>(Right));
+    }
+
+private:
+    TMap<FString, FBranch> Branches;    // "line file"
+    TMap<FString, FOperands> Operands;  // "line op file"
+    TMap<FString, uint64> Calls;        // "line callee file"
+    uint64 TotalCalls = 0;
+
+    static FString MakeKey(int32 Line, const FString& Name, const FString& SourceFile);
+};
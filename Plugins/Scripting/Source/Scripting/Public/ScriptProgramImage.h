@@ -0,0 +1,105 @@
+// Copyright Vampire Game Project. All Rights Reserved.
+// Custom scripting system for secure modding support.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ScriptBytecode.h"
+#include "ScriptNativeRegistry.h"
+
+/**
+ * Immutable Program Image
+ * =======================
+ *
+ * Everything about a loaded script that never changes while it runs:
+ * - Code, constants and debug info (the FBytecodeChunk)
+ * - Function table and the Main() entry point
+ * - Native IDs resolved against constant-pool slots (no name lookups in CALL_NATIVE)
+ * - Bytecode signature (used to match snapshots)
+ * - Verification result (see FScriptBytecodeVerifier)
+ *
+ * A program is validated and built ONCE, then shared by every FScriptVM that runs
+ * the script. The VM itself only holds per-instance state (stack, frames, globals),
+ * so running the same script on hundreds of actors costs one program plus a small
+ * context per actor.
+ *
+ * Programs are handed out as TSharedPtr<const FScriptProgramImage> - the bytecode must not
+ * be modified once a program has been created from it.
+ */
+class SCRIPTING_API FScriptProgramImage
+{
+public:
+    /**
+     * Validate bytecode and build a program image
+     * @param Bytecode - Chunk to wrap (shared, not copied)
+     * @param Registry - Native registry to resolve CALL_NATIVE targets against (must outlive the program)
+     * @param OutErrors - Validation failures
+     * @return nullptr if the bytecode is empty, fails security validation or is malformed
+     */
+    static TSharedPtr<const FScriptProgramImage> Create(TSharedPtr<FBytecodeChunk> Bytecode,
+        const FScriptNativeRegistry& Registry, TArray<FString>& OutErrors);
+
+    const FBytecodeChunk& GetBytecode() const { return *Bytecode; }
+    TSharedPtr<FBytecodeChunk> GetBytecodePtr() const { return Bytecode; }
+
+    /** User-defined functions, indexed the same way as OP_CALL operands */
+    const TArray<FFunctionInfo>& GetFunctions() const { return Bytecode->Functions; }
+
+    /** Index of a function by name, INDEX_NONE if not found */
+    int32 FindFunction(const FString& Name) const;
+
+    /** Index of Main(), INDEX_NONE if the script has none */
+    int32 GetMainFunctionIndex() const { return MainFunctionIndex; }
+
+    /** Native ID bound to a constant-pool name slot, INDEX_NONE if the constant does not name a native */
+    int32 GetNativeId(int32 ConstantIndex) const
+    {
+        return NativeIds.IsValidIndex(ConstantIndex) ? NativeIds[ConstantIndex] : INDEX_NONE;
+    }
+
+    /** Registry entry bound to a constant-pool name slot, nullptr if unresolved */
+    const FNativeFunctionEntry* GetNativeEntry(int32 ConstantIndex) const
+    {
+        return Registry->GetEntry(GetNativeId(ConstantIndex));
+    }
+
+    /** Implementation bound to a constant-pool name slot, nullptr if unresolved or unbound */
+    const FNativeFunction* GetNative(int32 ConstantIndex) const
+    {
+        const FNativeFunctionEntry* Entry = GetNativeEntry(ConstantIndex);
+        return Entry && Entry->Function ? &Entry->Function : nullptr;
+    }
+
+    /** Registry the natives were resolved against */
+    const FScriptNativeRegistry& GetNativeRegistry() const { return *Registry; }
+
+    /** Signature identifying this bytecode (computed once at creation) */
+    const FString& GetSignature() const { return Signature; }
+
+    /**
+     * True if the verifier proved the stack shape, so the VM may run this program
+     * through the dispatch loop without per-instruction checks
+     */
+    bool IsVerified() const { return bVerified; }
+
+    /** Approximate heap size of the image (shared between all instances) */
+    SIZE_T GetAllocatedSize() const;
+
+private:
+    FScriptProgramImage()
+        : Registry(nullptr)
+        , MainFunctionIndex(INDEX_NONE)
+        , bVerified(false)
+    {}
+
+    TSharedPtr<FBytecodeChunk> Bytecode;
+
+    const FScriptNativeRegistry* Registry;
+
+    /** Parallel to Bytecode->Constants - INDEX_NONE for constants that do not name a native */
+    TArray<int32> NativeIds;
+
+    FString Signature;
+    int32 MainFunctionIndex;
+    bool bVerified;
+};
@@ -9,9 +9,7 @@
 // Forward declarations
 struct FBytecodeChunk;
 class FScriptVM;
-
-// Delegate for native API registration (startup scripts)
-DECLARE_MULTICAST_DELEGATE_OneParam(FStartupScriptNativeAPIDelegate, FScriptVM*);
+class FScriptModuleCache;
 
 class FScriptingModule : public IModuleInterface
 {
@@ -19,9 +17,6 @@ public:
     /** IModuleInterface implementation */
     virtual void StartupModule() override;
     virtual void ShutdownModule() override;
-    
-    /** Get the delegate for registering native APIs for startup scripts */
-    FStartupScriptNativeAPIDelegate& GetStartupNativeAPIDelegate() { return OnRegisterStartupNativeAPI; }
 
 private:
     /** Called after engine initialization to compile and load scripts */
@@ -33,13 +28,16 @@ private:
     /** Load and execute scripts in Scripts/Startup/ folder */
     void LoadAndExecuteStartupScripts();
     
-    /** Compile a script from source and save to Scripts/Compiled/ */
-    TSharedPtr<FBytecodeChunk> CompileScript(const FString& SourceCode, const FString& ScriptName);
+    /**
+     * Compile a script from source and save to Scripts/Compiled/
+     * @param Modules Compile imports as modules through this cache and link them in, nullptr = compile them in
+     */
+    TSharedPtr<FBytecodeChunk> CompileScript(const FString& SourceCode, const FString& ScriptName, FScriptModuleCache* Modules = nullptr);
+    
+    /** Save compiled bytecode as Scripts/Compiled/<ScriptName>.scc */
+    bool SaveCompiledScript(const FBytecodeChunk& Bytecode, const FString& ScriptName);
     
     /** Execute a startup script */
     void ExecuteStartupScript(TSharedPtr<FBytecodeChunk> Bytecode, const FString& ScriptName);
-    
-    /** Delegate for native API registration */
-    FStartupScriptNativeAPIDelegate OnRegisterStartupNativeAPI;
 };
 
@@ -2,6 +2,8 @@
 
 #include "JustLive.h"
 #include "UI/JustLiveStyle.h"
+#include "Scripting/ScriptNativeAPI.h"
+#include "ScriptNativeRegistry.h"
 #include "Modules/ModuleManager.h"
 
 void FJustLiveModule::StartupModule()
@@ -9,6 +11,9 @@ void FJustLiveModule::StartupModule()
 	FDefaultGameModuleImpl::StartupModule();
 	FJustLiveStyle::Initialize();
 	FJustLiveStyle::ReloadTextures();
+
+	// Bind native implementations before the Scripting module freezes the registry (PostEngineInit)
+	FScriptNativeAPI::RegisterNativeFunctions(FScriptNativeRegistry::Get());
 }
 
 void FJustLiveModule::ShutdownModule()
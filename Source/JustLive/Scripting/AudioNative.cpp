@@ -8,27 +8,25 @@
 #include "Engine/World.h"
 #include "MathNative.h" // For vector helper if needed, but we can do manual extraction
 
-void FAudioNativeReg::RegisterFunctions(FScriptVM* VM)
+void FAudioNativeReg::RegisterFunctions(FScriptNativeRegistry& Registry)
 {
-    if (!VM) return;
-
     SCRIPT_LOG(TEXT("[AUDIO NATIVE REG] Registering audio functions..."));
 
-    VM->RegisterNativeFunction(TEXT("Audio_PlaySound"), PlaySound);
-    VM->RegisterNativeFunction(TEXT("Audio_PlayMusic"), PlayMusic);
-    VM->RegisterNativeFunction(TEXT("Audio_StopMusic"), StopMusic);
+    Registry.Bind(TEXT("Audio_PlaySound"), PlaySound);
+    Registry.Bind(TEXT("Audio_PlayMusic"), PlayMusic);
+    Registry.Bind(TEXT("Audio_StopMusic"), StopMusic);
     
     // Music
-    VM->RegisterNativeFunction(TEXT("Music_Next"), Music_Next);
-    VM->RegisterNativeFunction(TEXT("Music_Prev"), Music_Prev);
-    VM->RegisterNativeFunction(TEXT("Music_Pause"), Music_Pause);
-    VM->RegisterNativeFunction(TEXT("Music_Resume"), Music_Resume);
-    VM->RegisterNativeFunction(TEXT("Music_SetVolume"), Music_SetVolume);
-    VM->RegisterNativeFunction(TEXT("Music_SetShuffle"), Music_SetShuffle);
+    Registry.Bind(TEXT("Music_Next"), Music_Next);
+    Registry.Bind(TEXT("Music_Prev"), Music_Prev);
+    Registry.Bind(TEXT("Music_Pause"), Music_Pause);
+    Registry.Bind(TEXT("Music_Resume"), Music_Resume);
+    Registry.Bind(TEXT("Music_SetVolume"), Music_SetVolume);
+    Registry.Bind(TEXT("Music_SetShuffle"), Music_SetShuffle);
     
     // SFX
-    VM->RegisterNativeFunction(TEXT("SFX_PlayLoop"), SFX_PlayLoop);
-    VM->RegisterNativeFunction(TEXT("SFX_StopLoop"), SFX_StopLoop);
+    Registry.Bind(TEXT("SFX_PlayLoop"), SFX_PlayLoop);
+    Registry.Bind(TEXT("SFX_StopLoop"), SFX_StopLoop);
 
     SCRIPT_LOG(TEXT("[AUDIO NATIVE REG] Registered audio functions"));
 }
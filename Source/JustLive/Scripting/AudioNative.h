@@ -9,7 +9,7 @@
 class JUSTLIVE_API FAudioNativeReg
 {
 public:
-    static void RegisterFunctions(FScriptVM* VM);
+    static void RegisterFunctions(FScriptNativeRegistry& Registry);
 
 private:
     static FScriptValue PlaySound(FScriptVM* VM, const TArray<FScriptValue>& Args);
@@ -5,83 +5,193 @@
 #include "ScriptLogger.h"
 
 // Initialize static members
-int32 FScriptCollectionManager::NextListHandle = 1;
-TMap<int32, TArray<FScriptValue>> FScriptCollectionManager::Lists;
+TMap<const FScriptVM*, FScriptCollectionManager::FVMCollections> FScriptCollectionManager::Collections;
 
-int32 FScriptCollectionManager::NextDictHandle = 1;
-TMap<int32, TMap<FString, FScriptValue>> FScriptCollectionManager::Dictionaries;
-
-void FScriptCollectionManager::RegisterFunctions(FScriptVM* VM)
+void FScriptCollectionManager::RegisterFunctions(FScriptNativeRegistry& Registry)
 {
-    if (!VM) return;
-
     SCRIPT_LOG(TEXT("[COLLECTION MANAGER] Registering collection functions..."));
 
     // List API
-    VM->RegisterNativeFunction(TEXT("List_Create"), List_Create);
-    VM->RegisterNativeFunction(TEXT("List_Add"), List_Add);
-    VM->RegisterNativeFunction(TEXT("List_Get"), List_Get);
-    VM->RegisterNativeFunction(TEXT("List_Set"), List_Set);
-    VM->RegisterNativeFunction(TEXT("List_RemoveAt"), List_RemoveAt);
-    VM->RegisterNativeFunction(TEXT("List_Count"), List_Count);
-    VM->RegisterNativeFunction(TEXT("List_Clear"), List_Clear);
-    VM->RegisterNativeFunction(TEXT("List_Contains"), List_Contains);
+    Registry.Bind(TEXT("List_Create"), List_Create);
+    Registry.Bind(TEXT("List_Add"), List_Add);
+    Registry.Bind(TEXT("List_Get"), List_Get);
+    Registry.Bind(TEXT("List_Set"), List_Set);
+    Registry.Bind(TEXT("List_RemoveAt"), List_RemoveAt);
+    Registry.Bind(TEXT("List_Count"), List_Count);
+    Registry.Bind(TEXT("List_Clear"), List_Clear);
+    Registry.Bind(TEXT("List_Contains"), List_Contains);
 
     // Dictionary API
-    VM->RegisterNativeFunction(TEXT("Dict_Create"), Dict_Create);
-    VM->RegisterNativeFunction(TEXT("Dict_Set"), Dict_Set);
-    VM->RegisterNativeFunction(TEXT("Dict_Get"), Dict_Get);
-    VM->RegisterNativeFunction(TEXT("Dict_Remove"), Dict_Remove);
-    VM->RegisterNativeFunction(TEXT("Dict_HasKey"), Dict_HasKey);
-    VM->RegisterNativeFunction(TEXT("Dict_Clear"), Dict_Clear);
-    VM->RegisterNativeFunction(TEXT("Dict_Count"), Dict_Count);
+    Registry.Bind(TEXT("Dict_Create"), Dict_Create);
+    Registry.Bind(TEXT("Dict_Set"), Dict_Set);
+    Registry.Bind(TEXT("Dict_Get"), Dict_Get);
+    Registry.Bind(TEXT("Dict_Remove"), Dict_Remove);
+    Registry.Bind(TEXT("Dict_HasKey"), Dict_HasKey);
+    Registry.Bind(TEXT("Dict_Clear"), Dict_Clear);
+    Registry.Bind(TEXT("Dict_Count"), Dict_Count);
+
+    // Collections live outside the VM, so snapshots and forks need to carry them explicitly
+    FVMSnapshotExtension Extension;
+    Extension.Save = [](const FScriptVM& VM, TArray<uint8>& OutData) { SaveState(VM, OutData); };
+    Extension.Load = [](FScriptVM& VM, const TArray<uint8>& InData) { return LoadState(VM, InData); };
+    Extension.Fork = [](const FScriptVM& Parent, FScriptVM& Child) { CopyState(Parent, Child); };
+    Extension.Release = [](const FScriptVM& VM) { ReleaseState(VM); };
+    FScriptVM::RegisterSnapshotExtension(TEXT("Collections"), Extension);
 
     SCRIPT_LOG(TEXT("[COLLECTION MANAGER] Registered collection functions"));
 }
 
 void FScriptCollectionManager::Cleanup()
 {
-    Lists.Empty();
-    Dictionaries.Empty();
-    NextListHandle = 1;
-    NextDictHandle = 1;
+    Collections.Empty();
 }
 
 // ============================================================================
 // C++ Accessors (Engine Access)
 // ============================================================================
 
-TArray<FScriptValue>* FScriptCollectionManager::GetList(int32 Handle)
+TArray<FScriptValue>* FScriptCollectionManager::GetList(const FScriptVM* VM, int32 Handle)
 {
-    return Lists.Find(Handle);
+    FVMCollections* Owned = Collections.Find(VM);
+    return Owned ? Owned->Lists.Find(Handle) : nullptr;
 }
 
-TMap<FString, FScriptValue>* FScriptCollectionManager::GetDictionary(int32 Handle)
+TMap<FString, FScriptValue>* FScriptCollectionManager::GetDictionary(const FScriptVM* VM, int32 Handle)
 {
-    return Dictionaries.Find(Handle);
+    FVMCollections* Owned = Collections.Find(VM);
+    return Owned ? Owned->Dictionaries.Find(Handle) : nullptr;
 }
 
-int32 FScriptCollectionManager::CreateList()
+int32 FScriptCollectionManager::CreateList(const FScriptVM* VM)
 {
-    int32 Handle = NextListHandle++;
-    Lists.Add(Handle, TArray<FScriptValue>());
+    FVMCollections& Owned = Collections.FindOrAdd(VM);
+    int32 Handle = Owned.NextListHandle++;
+    Owned.Lists.Add(Handle, TArray<FScriptValue>());
     return Handle;
 }
 
-int32 FScriptCollectionManager::CreateDictionary()
+int32 FScriptCollectionManager::CreateDictionary(const FScriptVM* VM)
 {
-    int32 Handle = NextDictHandle++;
-    Dictionaries.Add(Handle, TMap<FString, FScriptValue>());
+    FVMCollections& Owned = Collections.FindOrAdd(VM);
+    int32 Handle = Owned.NextDictHandle++;
+    Owned.Dictionaries.Add(Handle, TMap<FString, FScriptValue>());
     return Handle;
 }
 
+// ============================================================================
+// Snapshot Support
+// ============================================================================
+
+void FScriptCollectionManager::SaveState(const FScriptVM& VM, TArray<uint8>& OutData)
+{
+    static const FVMCollections None;
+    const FVMCollections* Found = Collections.Find(&VM);
+    const FVMCollections& Owned = Found ? *Found : None;
+
+    // Layout: NextList, NextDict, ListCount, {Handle, Array}..., DictCount, {Handle, PairCount, {Key, Value}...}...
+    FScriptValue::Number(Owned.NextListHandle).SerializeTo(OutData);
+    FScriptValue::Number(Owned.NextDictHandle).SerializeTo(OutData);
+
+    FScriptValue::Number(Owned.Lists.Num()).SerializeTo(OutData);
+    for (const auto& Pair : Owned.Lists)
+    {
+        FScriptValue::Number(Pair.Key).SerializeTo(OutData);
+        FScriptValue::Array(Pair.Value).SerializeTo(OutData);
+    }
+
+    FScriptValue::Number(Owned.Dictionaries.Num()).SerializeTo(OutData);
+    for (const auto& Pair : Owned.Dictionaries)
+    {
+        FScriptValue::Number(Pair.Key).SerializeTo(OutData);
+        FScriptValue::Number(Pair.Value.Num()).SerializeTo(OutData);
+        for (const auto& Entry : Pair.Value)
+        {
+            FScriptValue::String(Entry.Key).SerializeTo(OutData);
+            Entry.Value.SerializeTo(OutData);
+        }
+    }
+}
+
+bool FScriptCollectionManager::LoadState(FScriptVM& VM, const TArray<uint8>& InData)
+{
+    int32 Offset = 0;
+    FScriptValue Value;
+
+    auto ReadNumber = [&](int32& Out) -> bool
+    {
+        if (!Value.DeserializeFrom(InData, Offset) || !Value.IsNumber()) return false;
+        Out = (int32)Value.AsNumber();
+        return true;
+    };
+
+    // Decode into temporaries so a corrupt blob leaves the current state untouched
+    int32 NewNextList = 0, NewNextDict = 0, ListCount = 0, DictCount = 0;
+    TMap<int32, TArray<FScriptValue>> NewLists;
+    TMap<int32, TMap<FString, FScriptValue>> NewDictionaries;
+
+    if (!ReadNumber(NewNextList) || !ReadNumber(NewNextDict) || !ReadNumber(ListCount) || ListCount < 0)
+    {
+        return false;
+    }
+
+    for (int32 i = 0; i < ListCount; ++i)
+    {
+        int32 Handle = 0;
+        if (!ReadNumber(Handle)) return false;
+        if (!Value.DeserializeFrom(InData, Offset) || !Value.IsArray()) return false;
+        NewLists.Add(Handle, Value.AsArray());
+    }
+
+    if (!ReadNumber(DictCount) || DictCount < 0)
+    {
+        return false;
+    }
+
+    for (int32 i = 0; i < DictCount; ++i)
+    {
+        int32 Handle = 0, PairCount = 0;
+        if (!ReadNumber(Handle) || !ReadNumber(PairCount) || PairCount < 0) return false;
+
+        TMap<FString, FScriptValue>& Dict = NewDictionaries.Add(Handle);
+        for (int32 j = 0; j < PairCount; ++j)
+        {
+            FScriptValue Key;
+            if (!Key.DeserializeFrom(InData, Offset) || !Key.IsString()) return false;
+            if (!Value.DeserializeFrom(InData, Offset)) return false;
+            Dict.Add(Key.AsString(), Value);
+        }
+    }
+
+    FVMCollections& Owned = Collections.FindOrAdd(&VM);
+    Owned.NextListHandle = NewNextList;
+    Owned.NextDictHandle = NewNextDict;
+    Owned.Lists = MoveTemp(NewLists);
+    Owned.Dictionaries = MoveTemp(NewDictionaries);
+    return true;
+}
+
+void FScriptCollectionManager::CopyState(const FScriptVM& Parent, FScriptVM& Child)
+{
+    if (const FVMCollections* Owned = Collections.Find(&Parent))
+    {
+        // Copy first: adding the child may reallocate the map under Owned
+        FVMCollections Copy = *Owned;
+        Collections.Add(&Child, MoveTemp(Copy));
+    }
+}
+
+void FScriptCollectionManager::ReleaseState(const FScriptVM& VM)
+{
+    Collections.Remove(&VM);
+}
+
 // ============================================================================
 // List Operations (Native API)
 // ============================================================================
 
 FScriptValue FScriptCollectionManager::List_Create(FScriptVM* VM, const TArray<FScriptValue>& Args)
 {
-    return FScriptValue::Number(CreateList());
+    return FScriptValue::Number(CreateList(VM));
 }
 
 FScriptValue FScriptCollectionManager::List_Add(FScriptVM* VM, const TArray<FScriptValue>& Args)
@@ -89,7 +199,7 @@ FScriptValue FScriptCollectionManager::List_Add(FScriptVM* VM, const TArray<FScr
     if (Args.Num() < 2) return FScriptValue::Bool(false);
     int32 Handle = (int32)Args[0].AsNumber();
     
-    if (TArray<FScriptValue>* List = GetList(Handle))
+    if (TArray<FScriptValue>* List = GetList(VM, Handle))
     {
         List->Add(Args[1]);
         return FScriptValue::Bool(true);
@@ -103,7 +213,7 @@ FScriptValue FScriptCollectionManager::List_Get(FScriptVM* VM, const TArray<FScr
     int32 Handle = (int32)Args[0].AsNumber();
     int32 Index = (int32)Args[1].AsNumber();
     
-    if (TArray<FScriptValue>* List = GetList(Handle))
+    if (TArray<FScriptValue>* List = GetList(VM, Handle))
     {
         if (List->IsValidIndex(Index))
         {
@@ -119,7 +229,7 @@ FScriptValue FScriptCollectionManager::List_Set(FScriptVM* VM, const TArray<FScr
     int32 Handle = (int32)Args[0].AsNumber();
     int32 Index = (int32)Args[1].AsNumber();
     
-    if (TArray<FScriptValue>* List = GetList(Handle))
+    if (TArray<FScriptValue>* List = GetList(VM, Handle))
     {
         if (List->IsValidIndex(Index))
         {
@@ -136,7 +246,7 @@ FScriptValue FScriptCollectionManager::List_RemoveAt(FScriptVM* VM, const TArray
     int32 Handle = (int32)Args[0].AsNumber();
     int32 Index = (int32)Args[1].AsNumber();
     
-    if (TArray<FScriptValue>* List = GetList(Handle))
+    if (TArray<FScriptValue>* List = GetList(VM, Handle))
     {
         if (List->IsValidIndex(Index))
         {
@@ -152,7 +262,7 @@ FScriptValue FScriptCollectionManager::List_Count(FScriptVM* VM, const TArray<FS
     if (Args.Num() < 1) return FScriptValue::Number(0);
     int32 Handle = (int32)Args[0].AsNumber();
     
-    if (TArray<FScriptValue>* List = GetList(Handle))
+    if (TArray<FScriptValue>* List = GetList(VM, Handle))
     {
         return FScriptValue::Number(List->Num());
     }
@@ -164,7 +274,7 @@ FScriptValue FScriptCollectionManager::List_Clear(FScriptVM* VM, const TArray<FS
     if (Args.Num() < 1) return FScriptValue::Bool(false);
     int32 Handle = (int32)Args[0].AsNumber();
     
-    if (TArray<FScriptValue>* List = GetList(Handle))
+    if (TArray<FScriptValue>* List = GetList(VM, Handle))
     {
         List->Empty();
         return FScriptValue::Bool(true);
@@ -177,7 +287,7 @@ FScriptValue FScriptCollectionManager::List_Contains(FScriptVM* VM, const TArray
     if (Args.Num() < 2) return FScriptValue::Bool(false);
     int32 Handle = (int32)Args[0].AsNumber();
     
-    if (TArray<FScriptValue>* List = GetList(Handle))
+    if (TArray<FScriptValue>* List = GetList(VM, Handle))
     {
         // Manual search since FScriptValue comparison needs care
         for (const FScriptValue& Val : *List)
@@ -200,7 +310,7 @@ FScriptValue FScriptCollectionManager::List_Contains(FScriptVM* VM, const TArray
 
 FScriptValue FScriptCollectionManager::Dict_Create(FScriptVM* VM, const TArray<FScriptValue>& Args)
 {
-    return FScriptValue::Number(CreateDictionary());
+    return FScriptValue::Number(CreateDictionary(VM));
 }
 
 FScriptValue FScriptCollectionManager::Dict_Set(FScriptVM* VM, const TArray<FScriptValue>& Args)
@@ -209,7 +319,7 @@ FScriptValue FScriptCollectionManager::Dict_Set(FScriptVM* VM, const TArray<FScr
     int32 Handle = (int32)Args[0].AsNumber();
     FString Key = Args[1].ToString();
     
-    if (TMap<FString, FScriptValue>* Dict = GetDictionary(Handle))
+    if (TMap<FString, FScriptValue>* Dict = GetDictionary(VM, Handle))
     {
         Dict->Add(Key, Args[2]);
         return FScriptValue::Bool(true);
@@ -223,7 +333,7 @@ FScriptValue FScriptCollectionManager::Dict_Get(FScriptVM* VM, const TArray<FScr
     int32 Handle = (int32)Args[0].AsNumber();
     FString Key = Args[1].ToString();
     
-    if (TMap<FString, FScriptValue>* Dict = GetDictionary(Handle))
+    if (TMap<FString, FScriptValue>* Dict = GetDictionary(VM, Handle))
     {
         if (FScriptValue* Val = Dict->Find(Key))
         {
@@ -239,7 +349,7 @@ FScriptValue FScriptCollectionManager::Dict_Remove(FScriptVM* VM, const TArray<F
     int32 Handle = (int32)Args[0].AsNumber();
     FString Key = Args[1].ToString();
     
-    if (TMap<FString, FScriptValue>* Dict = GetDictionary(Handle))
+    if (TMap<FString, FScriptValue>* Dict = GetDictionary(VM, Handle))
     {
         return FScriptValue::Bool(Dict->Remove(Key) > 0);
     }
@@ -252,7 +362,7 @@ FScriptValue FScriptCollectionManager::Dict_HasKey(FScriptVM* VM, const TArray<F
     int32 Handle = (int32)Args[0].AsNumber();
     FString Key = Args[1].ToString();
     
-    if (TMap<FString, FScriptValue>* Dict = GetDictionary(Handle))
+    if (TMap<FString, FScriptValue>* Dict = GetDictionary(VM, Handle))
     {
         return FScriptValue::Bool(Dict->Contains(Key));
     }
@@ -264,7 +374,7 @@ FScriptValue FScriptCollectionManager::Dict_Clear(FScriptVM* VM, const TArray<FS
     if (Args.Num() < 1) return FScriptValue::Bool(false);
     int32 Handle = (int32)Args[0].AsNumber();
     
-    if (TMap<FString, FScriptValue>* Dict = GetDictionary(Handle))
+    if (TMap<FString, FScriptValue>* Dict = GetDictionary(VM, Handle))
     {
         Dict->Empty();
         return FScriptValue::Bool(true);
@@ -277,7 +387,7 @@ FScriptValue FScriptCollectionManager::Dict_Count(FScriptVM* VM, const TArray<FS
     if (Args.Num() < 1) return FScriptValue::Number(0);
     int32 Handle = (int32)Args[0].AsNumber();
     
-    if (TMap<FString, FScriptValue>* Dict = GetDictionary(Handle))
+    if (TMap<FString, FScriptValue>* Dict = GetDictionary(VM, Handle))
     {
         return FScriptValue::Number(Dict->Num());
     }
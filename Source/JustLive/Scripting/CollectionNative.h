@@ -1,6 +1,7 @@
 // CollectionNative.h
 // Central Manager for Script Collections (Lists, Dictionaries)
 // Stores actual data in C++ memory, Scripts only hold Integer Handles.
+// Every VM owns its own collections and handles; C++ code passes the VM it works for.
 
 #pragma once
 
@@ -17,24 +18,40 @@ public:
     // ========================================================================
     // Native API Registration
     // ========================================================================
-    static void RegisterFunctions(FScriptVM* VM);
+    static void RegisterFunctions(FScriptNativeRegistry& Registry);
     static void Cleanup(); // Call on shutdown
 
     // ========================================================================
     // C++ Accessors (Engine Access)
     // ========================================================================
     
-    /** Retrieve a pointer to a List by its handle. Returns nullptr if invalid. */
-    static TArray<FScriptValue>* GetList(int32 Handle);
+    /** Retrieve a pointer to one of VM's Lists by its handle. Returns nullptr if invalid. */
+    static TArray<FScriptValue>* GetList(const FScriptVM* VM, int32 Handle);
     
-    /** Retrieve a pointer to a Dictionary by its handle. Returns nullptr if invalid. */
-    static TMap<FString, FScriptValue>* GetDictionary(int32 Handle);
+    /** Retrieve a pointer to one of VM's Dictionaries by its handle. Returns nullptr if invalid. */
+    static TMap<FString, FScriptValue>* GetDictionary(const FScriptVM* VM, int32 Handle);
 
-    /** Create a new List from C++ and return its handle for script use */
-    static int32 CreateList();
+    /** Create a new List for VM from C++ and return its handle for script use */
+    static int32 CreateList(const FScriptVM* VM);
 
-    /** Create a new Dictionary from C++ and return its handle for script use */
-    static int32 CreateDictionary();
+    /** Create a new Dictionary for VM from C++ and return its handle for script use */
+    static int32 CreateDictionary(const FScriptVM* VM);
+
+    // ========================================================================
+    // Snapshot Support
+    // ========================================================================
+
+    /** Serialize VM's Lists/Dictionaries and handle counters (used by VM snapshots) */
+    static void SaveState(const FScriptVM& VM, TArray<uint8>& OutData);
+
+    /** Replace VM's collections with state produced by SaveState. Returns false on malformed data. */
+    static bool LoadState(FScriptVM& VM, const TArray<uint8>& InData);
+
+    /** Give a forked VM copies of its parent's collections, under the same handles */
+    static void CopyState(const FScriptVM& Parent, FScriptVM& Child);
+
+    /** Free VM's collections (VM destroyed) */
+    static void ReleaseState(const FScriptVM& VM);
 
 private:
     // ========================================================================
@@ -63,9 +80,15 @@ private:
     // ========================================================================
     // Internal Storage
     // ========================================================================
-    static int32 NextListHandle;
-    static TMap<int32, TArray<FScriptValue>> Lists;
+    struct FVMCollections
+    {
+        int32 NextListHandle = 1;
+        TMap<int32, TArray<FScriptValue>> Lists;
+
+        int32 NextDictHandle = 1;
+        TMap<int32, TMap<FString, FScriptValue>> Dictionaries;
+    };
 
-    static int32 NextDictHandle;
-    static TMap<int32, TMap<FString, FScriptValue>> Dictionaries;
+    /** By owning VM (nullptr for collections C++ creates for no VM in particular) */
+    static TMap<const FScriptVM*, FVMCollections> Collections;
 };
\ No newline at end of file
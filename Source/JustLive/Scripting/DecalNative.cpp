@@ -4,13 +4,11 @@
 #include "DecalNative.h"
 #include "ScriptLogger.h"
 
-void FDecalNativeReg::RegisterFunctions(FScriptVM* VM)
+void FDecalNativeReg::RegisterFunctions(FScriptNativeRegistry& Registry)
 {
-    if (!VM) return;
-
     SCRIPT_LOG(TEXT("[DECAL NATIVE REG] Registering decal functions..."));
 
-    VM->RegisterNativeFunction(TEXT("Decal_Spawn"), SpawnDecal);
+    Registry.Bind(TEXT("Decal_Spawn"), SpawnDecal);
 
     SCRIPT_LOG(TEXT("[DECAL NATIVE REG] Registered decal functions"));
 }
@@ -9,7 +9,7 @@
 class JUSTLIVE_API FDecalNativeReg
 {
 public:
-    static void RegisterFunctions(FScriptVM* VM);
+    static void RegisterFunctions(FScriptNativeRegistry& Registry);
 
 private:
     static FScriptValue SpawnDecal(FScriptVM* VM, const TArray<FScriptValue>& Args);
@@ -8,15 +8,13 @@
 #include "Kismet/GameplayStatics.h"
 #include "Engine/World.h"
 
-void FLightNativeReg::RegisterFunctions(FScriptVM* VM)
+void FLightNativeReg::RegisterFunctions(FScriptNativeRegistry& Registry)
 {
-    if (!VM) return;
-
     SCRIPT_LOG(TEXT("[LIGHT NATIVE REG] Registering light functions..."));
 
-    VM->RegisterNativeFunction(TEXT("Light_SetColor"), SetLightColor);
-    VM->RegisterNativeFunction(TEXT("Light_SetIntensity"), SetLightIntensity);
-    VM->RegisterNativeFunction(TEXT("Light_Toggle"), ToggleLight);
+    Registry.Bind(TEXT("Light_SetColor"), SetLightColor);
+    Registry.Bind(TEXT("Light_SetIntensity"), SetLightIntensity);
+    Registry.Bind(TEXT("Light_Toggle"), ToggleLight);
 
     SCRIPT_LOG(TEXT("[LIGHT NATIVE REG] Registered light functions"));
 }
@@ -9,7 +9,7 @@
 class JUSTLIVE_API FLightNativeReg
 {
 public:
-    static void RegisterFunctions(FScriptVM* VM);
+    static void RegisterFunctions(FScriptNativeRegistry& Registry);
 
 private:
     static FScriptValue SetLightColor(FScriptVM* VM, const TArray<FScriptValue>& Args);
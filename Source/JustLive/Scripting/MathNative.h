@@ -6,67 +6,103 @@
 #include "CoreMinimal.h"
 #include "ScriptVM.h"
 
+/**
+ * Vectors travel through scripts as [x, y, z] number arrays
+ */
+template<>
+struct TScriptNativeArg<FVector>
+{
+    static constexpr EScriptType Type = EScriptType::FLOAT_ARRAY;
+
+    static bool Matches(const FScriptValue& Value)
+    {
+        const TArray<FScriptValue>& Arr = Value.AsArray();
+        return Value.IsArray() && Arr.Num() >= 3 && Arr[0].IsNumber() && Arr[1].IsNumber() && Arr[2].IsNumber();
+    }
+
+    static FVector Get(const FScriptValue& Value)
+    {
+        const TArray<FScriptValue>& Arr = Value.AsArray();
+        if (Arr.Num() < 3) return FVector::ZeroVector;
+        return FVector(Arr[0].AsNumber(), Arr[1].AsNumber(), Arr[2].AsNumber());
+    }
+};
+
+template<>
+struct TScriptNativeResult<FVector>
+{
+    static constexpr EScriptType Type = EScriptType::FLOAT_ARRAY;
+
+    template<typename FuncType, typename... CallArgTypes>
+    static FScriptValue Call(FuncType&& Function, CallArgTypes&&... CallArgs)
+    {
+        const FVector Vec = Function(Forward<CallArgTypes>(CallArgs)...);
+        TArray<FScriptValue> Arr;
+        Arr.Reserve(3);
+        Arr.Add(FScriptValue::Number(Vec.X));
+        Arr.Add(FScriptValue::Number(Vec.Y));
+        Arr.Add(FScriptValue::Number(Vec.Z));
+        return FScriptValue::Array(Arr);
+    }
+};
+
 /**
  * Math native function registration
+ * Everything except Vector() is bound with BindTyped - see ScriptNativeBinding.h
  */
 class JUSTLIVE_API FMathNativeReg
 {
 public:
-    static void RegisterFunctions(FScriptVM* VM);
+    static void RegisterFunctions(FScriptNativeRegistry& Registry);
 
 private:
     // Basic arithmetic
-    static FScriptValue Add(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Subtract(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Multiply(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Divide(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Mod(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Pow(FScriptVM* VM, const TArray<FScriptValue>& Args);
+    static double Add(double A, double B);
+    static double Subtract(double A, double B);
+    static double Multiply(double A, double B);
+    static double Divide(FScriptVM* VM, double A, double B);
+    static double Mod(FScriptVM* VM, double A, double B);
+    static double Pow(double Base, double Exponent);
 
     // Trig
-    static FScriptValue Sin(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Cos(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Tan(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Asin(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Acos(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Atan(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Atan2(FScriptVM* VM, const TArray<FScriptValue>& Args);
+    static double Sin(double Value);
+    static double Cos(double Value);
+    static double Tan(double Value);
+    static double Asin(double Value);
+    static double Acos(double Value);
+    static double Atan(double Value);
+    static double Atan2(double Y, double X);
 
     // Helpers
-    static FScriptValue Abs(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Sqrt(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Floor(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Ceil(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Round(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Clamp(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Min(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Max(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue DegreesToRadians(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue RadiansToDegrees(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Log(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Exp(FScriptVM* VM, const TArray<FScriptValue>& Args);
+    static double Abs(double Value);
+    static double Sqrt(FScriptVM* VM, double Value);
+    static double Floor(double Value);
+    static double Ceil(double Value);
+    static double Round(double Value);
+    static double Clamp(double Value, double MinValue, double MaxValue);
+    static double Min(double A, double B);
+    static double Max(double A, double B);
+    static double DegreesToRadians(double Degrees);
+    static double RadiansToDegrees(double Radians);
+    static double Log(double Value);
+    static double Exp(double Value);
 
     // Random
-    static FScriptValue Random_Float(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Random_Range(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Random_Bool(FScriptVM* VM, const TArray<FScriptValue>& Args);
+    static double Random_Float();
+    static double Random_Range(double MinValue, double MaxValue);
+    static bool Random_Bool();
 
     // Vector Math (Vectors are Arrays [x, y, z])
-    static FScriptValue Vector(FScriptVM* VM, const TArray<FScriptValue>& Args); // Constructor: Vector(x, y, z)
-    static FScriptValue Vector_Add(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Vector_Sub(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Vector_Mul(FScriptVM* VM, const TArray<FScriptValue>& Args); // Scalar multiply
-    static FScriptValue Vector_Div(FScriptVM* VM, const TArray<FScriptValue>& Args); // Scalar divide
-    static FScriptValue Vector_Dot(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Vector_Cross(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Vector_Dist(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Vector_DistSquared(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Vector_Normalize(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Vector_Length(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Vector_Lerp(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    
-    // Helper: Extract vector from array value
-    static FVector GetVectorFromArray(const FScriptValue& Val);
-    // Helper: Create array value from vector
-    static FScriptValue CreateArrayFromVector(const FVector& Vec);
-};
\ No newline at end of file
+    static FScriptValue Vector(FScriptVM* VM, const TArray<FScriptValue>& Args); // Constructor: Vector(x, y, z), components optional
+    static FVector Vector_Add(FVector A, FVector B);
+    static FVector Vector_Sub(FVector A, FVector B);
+    static FVector Vector_Mul(FVector V, double Scalar);
+    static FVector Vector_Div(FScriptVM* VM, FVector V, double Scalar);
+    static double Vector_Dot(FVector A, FVector B);
+    static FVector Vector_Cross(FVector A, FVector B);
+    static double Vector_Dist(FVector A, FVector B);
+    static double Vector_DistSquared(FVector A, FVector B);
+    static FVector Vector_Normalize(FVector V);
+    static double Vector_Length(FVector V);
+    static FVector Vector_Lerp(FVector A, FVector B, double Alpha);
+};
@@ -17,38 +17,32 @@
 #include "LightNative.h"
 #include "DecalNative.h"
 
-void FScriptNativeAPI::RegisterNativeFunctions(FScriptVM* VM)
+void FScriptNativeAPI::RegisterNativeFunctions(FScriptNativeRegistry& Registry)
 {
-    if (!VM)
-    {
-        SCRIPT_LOG_ERROR(TEXT("Cannot register native functions - VM is null"));
-        return;
-    }
-
     SCRIPT_LOG(TEXT("[NATIVE API] Registering utility functions..."));
     // Utility functions
-    VM->RegisterNativeFunction(TEXT("Log"), NativeLog);
-    VM->RegisterNativeFunction(TEXT("Print"), NativePrint);
-    VM->RegisterNativeFunction(TEXT("Sleep"), NativeSleep);
+    Registry.Bind(TEXT("Log"), NativeLog);
+    Registry.Bind(TEXT("Print"), NativePrint);
+    Registry.Bind(TEXT("Sleep"), NativeSleep);
 
     // Script Management functions
-    VM->RegisterNativeFunction(TEXT("LoadScript"), NativeLoadScript);
-    VM->RegisterNativeFunction(TEXT("RunScript"), NativeRunScript);
-    VM->RegisterNativeFunction(TEXT("DoesScriptExist"), NativeDoesScriptExist);
-    VM->RegisterNativeFunction(TEXT("IsScriptRunning"), NativeIsScriptRunning);
-    VM->RegisterNativeFunction(TEXT("CanRunScript"), NativeCanRunScript);
-    VM->RegisterNativeFunction(TEXT("IsMissionScript"), NativeIsMissionScript);
+    Registry.Bind(TEXT("LoadScript"), NativeLoadScript);
+    Registry.Bind(TEXT("RunScript"), NativeRunScript);
+    Registry.Bind(TEXT("DoesScriptExist"), NativeDoesScriptExist);
+    Registry.Bind(TEXT("IsScriptRunning"), NativeIsScriptRunning);
+    Registry.Bind(TEXT("CanRunScript"), NativeCanRunScript);
+    Registry.Bind(TEXT("IsMissionScript"), NativeIsMissionScript);
 
     // Register module functions
-    FMathNativeReg::RegisterFunctions(VM);
-    FScriptCollectionManager::RegisterFunctions(VM);
-    FStringNativeReg::RegisterFunctions(VM);
+    FMathNativeReg::RegisterFunctions(Registry);
+    FScriptCollectionManager::RegisterFunctions(Registry);
+    FStringNativeReg::RegisterFunctions(Registry);
     
     // Register Game System modules
-    FAudioNativeReg::RegisterFunctions(VM);
-    FUINativeReg::RegisterFunctions(VM);
-    FLightNativeReg::RegisterFunctions(VM);
-    FDecalNativeReg::RegisterFunctions(VM);
+    FAudioNativeReg::RegisterFunctions(Registry);
+    FUINativeReg::RegisterFunctions(Registry);
+    FLightNativeReg::RegisterFunctions(Registry);
+    FDecalNativeReg::RegisterFunctions(Registry);
     
     SCRIPT_LOG(TEXT("[NATIVE API] Registered all native API functions successfully"));
 }
@@ -13,9 +13,9 @@ class JUSTLIVE_API FScriptNativeAPI
 {
 public:
     /**
-     * Register all native functions with the VM
+     * Bind all native functions into the registry (once, at module startup)
      */
-    static void RegisterNativeFunctions(FScriptVM* VM);
+    static void RegisterNativeFunctions(FScriptNativeRegistry& Registry);
 
 private:
     // Utility Functions
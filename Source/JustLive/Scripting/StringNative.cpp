@@ -5,31 +5,28 @@
 #include "ScriptLogger.h"
 #include "CollectionNative.h" // Needed for Split() to return a List Handle
 
-void FStringNativeReg::RegisterFunctions(FScriptVM* VM)
+void FStringNativeReg::RegisterFunctions(FScriptNativeRegistry& Registry)
 {
-    if (!VM) return;
-
     SCRIPT_LOG(TEXT("[STRING NATIVE REG] Registering string functions..."));
 
-    VM->RegisterNativeFunction(TEXT("String_Len"), Len);
-    VM->RegisterNativeFunction(TEXT("String_Sub"), Substring);
-    VM->RegisterNativeFunction(TEXT("String_Find"), Find);
-    VM->RegisterNativeFunction(TEXT("String_Upper"), ToUpper);
-    VM->RegisterNativeFunction(TEXT("String_Lower"), ToLower);
-    VM->RegisterNativeFunction(TEXT("String_Replace"), Replace);
-    VM->RegisterNativeFunction(TEXT("String_Trim"), Trim);
-    VM->RegisterNativeFunction(TEXT("String_Split"), Split);
-    VM->RegisterNativeFunction(TEXT("String_Contains"), Contains);
-    VM->RegisterNativeFunction(TEXT("String_FromChar"), FromChar);
-    VM->RegisterNativeFunction(TEXT("String_ToChar"), ToChar);
+    Registry.BindTyped(TEXT("String_Len"), Len);
+    Registry.Bind(TEXT("String_Sub"), Substring);
+    Registry.BindTyped(TEXT("String_Find"), Find);
+    Registry.BindTyped(TEXT("String_Upper"), ToUpper);
+    Registry.BindTyped(TEXT("String_Lower"), ToLower);
+    Registry.BindTyped(TEXT("String_Replace"), Replace);
+    Registry.BindTyped(TEXT("String_Trim"), Trim);
+    Registry.BindTyped(TEXT("String_Split"), Split);
+    Registry.BindTyped(TEXT("String_Contains"), Contains);
+    Registry.BindTyped(TEXT("String_FromChar"), FromChar);
+    Registry.BindTyped(TEXT("String_ToChar"), ToChar);
 
     SCRIPT_LOG(TEXT("[STRING NATIVE REG] Registered string functions"));
 }
 
-FScriptValue FStringNativeReg::Len(FScriptVM* VM, const TArray<FScriptValue>& Args)
+int32 FStringNativeReg::Len(const FString& Str)
 {
-    if (Args.Num() < 1) return FScriptValue::Number(0);
-    return FScriptValue::Number(Args[0].ToString().Len());
+    return Str.Len();
 }
 
 FScriptValue FStringNativeReg::Substring(FScriptVM* VM, const TArray<FScriptValue>& Args)
@@ -45,55 +42,39 @@ FScriptValue FStringNativeReg::Substring(FScriptVM* VM, const TArray<FScriptValu
     return FScriptValue::String(Str.Mid(Start, Count));
 }
 
-FScriptValue FStringNativeReg::Find(FScriptVM* VM, const TArray<FScriptValue>& Args)
+int32 FStringNativeReg::Find(const FString& Str, const FString& Sub)
 {
-    if (Args.Num() < 2) return FScriptValue::Number(-1);
-    FString Str = Args[0].ToString();
-    FString Sub = Args[1].ToString();
-    return FScriptValue::Number(Str.Find(Sub));
+    return Str.Find(Sub);
 }
 
-FScriptValue FStringNativeReg::ToUpper(FScriptVM* VM, const TArray<FScriptValue>& Args)
+FString FStringNativeReg::ToUpper(const FString& Str)
 {
-    if (Args.Num() < 1) return FScriptValue::String(TEXT(""));
-    return FScriptValue::String(Args[0].ToString().ToUpper());
+    return Str.ToUpper();
 }
 
-FScriptValue FStringNativeReg::ToLower(FScriptVM* VM, const TArray<FScriptValue>& Args)
+FString FStringNativeReg::ToLower(const FString& Str)
 {
-    if (Args.Num() < 1) return FScriptValue::String(TEXT(""));
-    return FScriptValue::String(Args[0].ToString().ToLower());
+    return Str.ToLower();
 }
 
-FScriptValue FStringNativeReg::Replace(FScriptVM* VM, const TArray<FScriptValue>& Args)
+FString FStringNativeReg::Replace(const FString& Str, const FString& From, const FString& To)
 {
-    if (Args.Num() < 3) return Args.Num() > 0 ? Args[0] : FScriptValue::String(TEXT(""));
-    FString Str = Args[0].ToString();
-    FString From = Args[1].ToString();
-    FString To = Args[2].ToString();
-    return FScriptValue::String(Str.Replace(*From, *To));
+    return Str.Replace(*From, *To);
 }
 
-FScriptValue FStringNativeReg::Trim(FScriptVM* VM, const TArray<FScriptValue>& Args)
+FString FStringNativeReg::Trim(const FString& Str)
 {
-    if (Args.Num() < 1) return FScriptValue::String(TEXT(""));
-    FString Str = Args[0].ToString();
-    Str.TrimStartAndEndInline();
-    return FScriptValue::String(Str);
+    return Str.TrimStartAndEnd();
 }
 
-FScriptValue FStringNativeReg::Split(FScriptVM* VM, const TArray<FScriptValue>& Args)
+int32 FStringNativeReg::Split(FScriptVM* VM, const FString& Str, const FString& Delim)
 {
-    if (Args.Num() < 2) return FScriptValue::Number(-1); // Invalid handle
-    FString Str = Args[0].ToString();
-    FString Delim = Args[1].ToString();
-    
     TArray<FString> Parts;
     Str.ParseIntoArray(Parts, *Delim, true);
     
-    // Create a new List via Collection Manager
-    int32 ListHandle = FScriptCollectionManager::CreateList();
-    TArray<FScriptValue>* List = FScriptCollectionManager::GetList(ListHandle);
+    // Create a new List via Collection Manager, owned by the calling VM
+    int32 ListHandle = FScriptCollectionManager::CreateList(VM);
+    TArray<FScriptValue>* List = FScriptCollectionManager::GetList(VM, ListHandle);
     
     if (List)
     {
@@ -103,29 +84,20 @@ FScriptValue FStringNativeReg::Split(FScriptVM* VM, const TArray<FScriptValue>&
         }
     }
     
-    return FScriptValue::Number(ListHandle);
+    return ListHandle;
 }
 
-FScriptValue FStringNativeReg::Contains(FScriptVM* VM, const TArray<FScriptValue>& Args)
+bool FStringNativeReg::Contains(const FString& Str, const FString& Sub)
 {
-    if (Args.Num() < 2) return FScriptValue::Bool(false);
-    return FScriptValue::Bool(Args[0].ToString().Contains(Args[1].ToString()));
+    return Str.Contains(Sub);
 }
 
-FScriptValue FStringNativeReg::FromChar(FScriptVM* VM, const TArray<FScriptValue>& Args)
+FString FStringNativeReg::FromChar(int32 CharCode)
 {
-    if (Args.Num() < 1) return FScriptValue::String(TEXT(""));
-    TCHAR CharCode = (TCHAR)Args[0].AsNumber();
-    return FScriptValue::String(FString().AppendChar(CharCode));
+    return FString().AppendChar((TCHAR)CharCode);
 }
 
-FScriptValue FStringNativeReg::ToChar(FScriptVM* VM, const TArray<FScriptValue>& Args)
+int32 FStringNativeReg::ToChar(const FString& Str)
 {
-    if (Args.Num() < 1) return FScriptValue::Number(0);
-    FString Str = Args[0].ToString();
-    if (Str.Len() > 0)
-    {
-        return FScriptValue::Number((double)Str[0]);
-    }
-    return FScriptValue::Number(0);
+    return Str.Len() > 0 ? (int32)Str[0] : 0;
 }
@@ -9,18 +9,19 @@
 class JUSTLIVE_API FStringNativeReg
 {
 public:
-    static void RegisterFunctions(FScriptVM* VM);
+    static void RegisterFunctions(FScriptNativeRegistry& Registry);
 
 private:
-    static FScriptValue Len(FScriptVM* VM, const TArray<FScriptValue>& Args);
+    // Everything except String_Sub (optional count) is bound with BindTyped - see ScriptNativeBinding.h
+    static int32 Len(const FString& Str);
     static FScriptValue Substring(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Find(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue ToUpper(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue ToLower(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Replace(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Trim(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue Split(FScriptVM* VM, const TArray<FScriptValue>& Args); // Returns List Handle
-    static FScriptValue Contains(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue FromChar(FScriptVM* VM, const TArray<FScriptValue>& Args);
-    static FScriptValue ToChar(FScriptVM* VM, const TArray<FScriptValue>& Args);
-};
+    static int32 Find(const FString& Str, const FString& Sub);
+    static FString ToUpper(const FString& Str);
+    static FString ToLower(const FString& Str);
+    static FString Replace(const FString& Str, const FString& From, const FString& To);
+    static FString Trim(const FString& Str);
+    static int32 Split(FScriptVM* VM, const FString& Str, const FString& Delim); // Returns List Handle
+    static bool Contains(const FString& Str, const FString& Sub);
+    static FString FromChar(int32 CharCode);
+    static int32 ToChar(const FString& Str);
+};
\ No newline at end of file
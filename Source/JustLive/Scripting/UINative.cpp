@@ -7,15 +7,13 @@
 #include "Engine/GameInstance.h"
 #include "Engine/World.h"
 
-void FUINativeReg::RegisterFunctions(FScriptVM* VM)
+void FUINativeReg::RegisterFunctions(FScriptNativeRegistry& Registry)
 {
-    if (!VM) return;
-
     SCRIPT_LOG(TEXT("[UI NATIVE REG] Registering UI functions..."));
 
-    VM->RegisterNativeFunction(TEXT("UI_SwitchState"), SwitchState);
-    VM->RegisterNativeFunction(TEXT("UI_ShowLoading"), ShowLoading);
-    VM->RegisterNativeFunction(TEXT("UI_UpdateLoading"), UpdateLoading);
+    Registry.Bind(TEXT("UI_SwitchState"), SwitchState);
+    Registry.Bind(TEXT("UI_ShowLoading"), ShowLoading);
+    Registry.Bind(TEXT("UI_UpdateLoading"), UpdateLoading);
 
     SCRIPT_LOG(TEXT("[UI NATIVE REG] Registered UI functions"));
 }
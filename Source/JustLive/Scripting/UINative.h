@@ -9,7 +9,7 @@
 class JUSTLIVE_API FUINativeReg
 {
 public:
-    static void RegisterFunctions(FScriptVM* VM);
+    static void RegisterFunctions(FScriptNativeRegistry& Registry);
 
 private:
     static FScriptValue SwitchState(FScriptVM* VM, const TArray<FScriptValue>& Args);
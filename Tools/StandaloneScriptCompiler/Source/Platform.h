@@ -17,14 +17,26 @@
 #include <cstdint>
 #include <algorithm>
 #include <functional>
+#include <optional>
 #include <sstream>
 #include <fstream>
 #include <iostream>
 #include <cmath>
+#include <thread>
+#include <mutex>
+#include <atomic>
 #include <cstdarg>
 #include <cstdio>
 #include <ctime>
 #include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+    #include <unistd.h>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
 
 // Windows headers (before everything else)
 #ifdef _WIN32
@@ -109,6 +121,17 @@ public:
         return Equals(other, searchCase == ESearchCase::CaseSensitive);
     }
     
+    // Compare - <0, 0, >0 like strcmp
+    int32 Compare(const FString& other, ESearchCase searchCase = ESearchCase::CaseSensitive) const
+    {
+        if (searchCase == ESearchCase::CaseSensitive)
+            return this->compare(other);
+        FString a = *this, b = other;
+        std::transform(a.begin(), a.end(), a.begin(), ::tolower);
+        std::transform(b.begin(), b.end(), b.begin(), ::tolower);
+        return a.compare(b);
+    }
+    
     // Left - returns leftmost N characters
     FString Left(int32 count) const
     {
@@ -186,6 +209,15 @@ public:
 
 // Character types
 using ANSICHAR = char;
+using TCHAR = char;
+using SIZE_T = size_t;
+using UPTRINT = uintptr_t;
+
+// Sentinel for "not found" indices
+#define INDEX_NONE (-1)
+#define MAX_int32 ((int32)0x7fffffff)
+#define MIN_int32 ((int32)0x80000000)
+#define UE_ARRAY_COUNT(Array) ((int32)(sizeof(Array) / sizeof((Array)[0])))
 
 // UTF8 conversion macro (no-op in standalone since we use char*)
 #define UTF8_TO_TCHAR(x) (x)
@@ -209,11 +241,12 @@ public:
     void Add(const T& item) { this->push_back(item); }
     void Add(T&& item) { this->push_back(std::move(item)); }
     void Empty() { this->clear(); }
+    void Reset() { this->clear(); }
     void Reserve(int32 count) { this->reserve(count); }
     bool IsEmpty() const { return this->empty(); }
     T& Last() { return this->back(); }
     const T& Last() const { return this->back(); }
-    void Pop() { this->pop_back(); }
+    T Pop() { T item = std::move(this->back()); this->pop_back(); return item; }
     bool IsValidIndex(int32 index) const { return index >= 0 && index < Num(); }
     void Insert(const T& item, int32 index) { this->insert(this->begin() + index, item); }
     void Insert(T&& item, int32 index) { this->insert(this->begin() + index, std::move(item)); }
@@ -222,9 +255,29 @@ public:
     T* GetData() { return this->data(); }
     const T* GetData() const { return this->data(); }
     void SetNum(int32 count) { this->resize(count); }
+    void Init(const T& value, int32 count) { this->assign(count, value); }
     void SetNumUninitialized(int32 count) { this->resize(count); }
     void Append(const TArray<T>& other) { this->insert(this->end(), other.begin(), other.end()); }
     void Append(const T* ptr, int32 count) { this->insert(this->end(), ptr, ptr + count); }
+    void RemoveAt(int32 index) { this->erase(this->begin() + index); }
+    bool Contains(const T& item) const { return std::find(this->begin(), this->end(), item) != this->end(); }
+    template<typename PredicateType>
+    bool ContainsByPredicate(PredicateType Predicate) const { return std::find_if(this->begin(), this->end(), Predicate) != this->end(); }
+    int32 Find(const T& item) const
+    {
+        auto it = std::find(this->begin(), this->end(), item);
+        return it != this->end() ? static_cast<int32>(it - this->begin()) : -1;
+    }
+    int32 AddUnique(const T& item)
+    {
+        const int32 Index = Find(item);
+        if (Index != -1) return Index;
+        Add(item);
+        return Num() - 1;
+    }
+    void Sort() { std::sort(this->begin(), this->end()); }
+    template<typename PredicateType>
+    void Sort(PredicateType Predicate) { std::sort(this->begin(), this->end(), Predicate); }
 };
 
 // Pair type (UE uses TPair)
@@ -238,12 +291,47 @@ struct TPair
     TPair(const K& k, const V& v) : Key(k), Value(v) {}
 };
 
+// Map iterator that exposes UE-style Pair.Key / Pair.Value instead of first/second
+template<typename MapIteratorType, typename KeyType, typename ValueType>
+class TMapIteratorAdapter
+{
+public:
+    struct FPairRef
+    {
+        const KeyType& Key;
+        ValueType& Value;
+    };
+    
+    explicit TMapIteratorAdapter(MapIteratorType InIt) : It(InIt) {}
+    
+    FPairRef& operator*() const { Current.emplace(FPairRef{ It->first, It->second }); return *Current; }
+    FPairRef* operator->() const { return &**this; }
+    TMapIteratorAdapter& operator++() { ++It; return *this; }
+    bool operator==(const TMapIteratorAdapter& Other) const { return It == Other.It; }
+    bool operator!=(const TMapIteratorAdapter& Other) const { return It != Other.It; }
+    
+private:
+    MapIteratorType It;
+    mutable std::optional<FPairRef> Current;
+};
+
 // Map type with UE-compatible methods
 template<typename K, typename V>
 class TMap : public std::map<K, V>
 {
+    using Super = std::map<K, V>;
+    
 public:
-    using std::map<K, V>::map;
+    using Super::map;
+    
+    using Iterator = TMapIteratorAdapter<typename Super::iterator, K, V>;
+    using ConstIterator = TMapIteratorAdapter<typename Super::const_iterator, K, const V>;
+    
+    // Range-for yields Pair.Key / Pair.Value like TMap
+    Iterator begin() { return Iterator(Super::begin()); }
+    Iterator end() { return Iterator(Super::end()); }
+    ConstIterator begin() const { return ConstIterator(Super::begin()); }
+    ConstIterator end() const { return ConstIterator(Super::end()); }
     
     // UE-compatible methods
     void Add(const K& key, const V& value)
@@ -251,21 +339,41 @@ public:
         (*this)[key] = value;
     }
     
+    V& FindOrAdd(const K& key)
+    {
+        return (*this)[key];
+    }
+    
     V* Find(const K& key)
     {
         auto it = this->find(key);
-        return (it != this->end()) ? &it->second : nullptr;
+        return (it != Super::end()) ? &it->second : nullptr;
     }
     
     const V* Find(const K& key) const
     {
         auto it = this->find(key);
-        return (it != this->end()) ? &it->second : nullptr;
+        return (it != Super::end()) ? &it->second : nullptr;
     }
     
     bool Contains(const K& key) const
     {
-        return this->find(key) != this->end();
+        return this->find(key) != Super::end();
+    }
+    
+    int32 Remove(const K& key)
+    {
+        return static_cast<int32>(this->erase(key));
+    }
+    
+    int32 Num() const
+    {
+        return static_cast<int32>(this->size());
+    }
+    
+    void Empty()
+    {
+        this->clear();
     }
 };
 
@@ -287,6 +395,11 @@ public:
         return this->find(item) != this->end();
     }
     
+    int32 Remove(const T& item)
+    {
+        return static_cast<int32>(this->erase(item));
+    }
+    
     void Empty()
     {
         this->clear();
@@ -308,6 +421,21 @@ public:
     // UE-compatible methods
     bool IsValid() const { return this->get() != nullptr; }
     T* Get() const { return this->get(); }
+    bool IsUnique() const { return this->use_count() == 1; }
+    void Reset() { this->reset(); }
+};
+
+// Unique pointer with UE-compatible methods
+template<typename T>
+class TUniquePtr : public std::unique_ptr<T>
+{
+public:
+    using std::unique_ptr<T>::unique_ptr;
+    TUniquePtr(std::unique_ptr<T>&& Other) : std::unique_ptr<T>(std::move(Other)) {}
+    
+    bool IsValid() const { return this->get() != nullptr; }
+    T* Get() const { return this->get(); }
+    void Reset(T* NewObject = nullptr) { this->reset(NewObject); }
 };
 
 // Shared reference (non-nullable shared pointer)
@@ -323,6 +451,57 @@ TSharedPtr<T> MakeShared(Args&&... args)
     return ptr;
 }
 
+// Move helper (UE uses MoveTemp)
+template<typename T>
+typename std::remove_reference<T>::type&& MoveTemp(T&& Value)
+{
+    return std::move(Value);
+}
+
+// Perfect forwarding helper (UE uses Forward)
+template<typename T>
+T&& Forward(typename std::remove_reference<T>::type& Value)
+{
+    return static_cast<T&&>(Value);
+}
+
+// Type traits used by the native binding templates (UE: Templates/Decay.h, Templates/IntegerSequence.h)
+template<typename T>
+struct TDecay
+{
+    typedef typename std::decay<T>::type Type;
+};
+
+template<typename T, T... Indices>
+using TIntegerSequence = std::integer_sequence<T, Indices...>;
+
+template<typename T, T N>
+using TMakeIntegerSequence = std::make_integer_sequence<T, N>;
+
+// Adopt a raw pointer (needed for types with private constructors)
+template<typename T>
+TSharedPtr<T> MakeShareable(T* Object)
+{
+    return TSharedPtr<T>(Object);
+}
+
+// Shared-from-this base (UE uses TSharedFromThis)
+template<typename T>
+class TSharedFromThis : public std::enable_shared_from_this<T>
+{
+public:
+    TSharedPtr<T> AsShared()
+    {
+        TSharedPtr<T> ptr;
+        static_cast<std::shared_ptr<T>&>(ptr) = this->shared_from_this();
+        return ptr;
+    }
+};
+
+// Callable wrapper (UE uses TFunction)
+template<typename Signature>
+using TFunction = std::function<Signature>;
+
 // Static cast for shared pointers
 template<typename ToType, typename FromType>
 TSharedPtr<ToType> StaticCastSharedPtr(const TSharedPtr<FromType>& ptr)
@@ -468,6 +647,44 @@ namespace FMath
     {
         return std::abs(a - b) <= tolerance;
     }
+    
+    inline double RoundToDouble(double value)
+    {
+        return std::round(value);
+    }
+    
+    inline double Fmod(double a, double b)
+    {
+        return std::fmod(a, b);
+    }
+    
+    inline int32 RandRange(int32 min, int32 max)
+    {
+        return min + (max > min ? std::rand() % (max - min + 1) : 0);
+    }
+    
+    inline float FRandRange(float min, float max)
+    {
+        return min + (max - min) * (static_cast<float>(std::rand()) / RAND_MAX);
+    }
+    
+    template<typename T>
+    inline T Max(T a, T b)
+    {
+        return a > b ? a : b;
+    }
+    
+    template<typename T>
+    inline T Min(T a, T b)
+    {
+        return a < b ? a : b;
+    }
+    
+    template<typename T>
+    inline T Clamp(T x, T lo, T hi)
+    {
+        return x < lo ? lo : (x > hi ? hi : x);
+    }
 }
 
 // C String utilities (FCString)
@@ -482,6 +699,20 @@ namespace FCString
     {
         return std::atof(str);
     }
+    
+    inline uint64 Strtoui64(const char* str, char** end, int32 base)
+    {
+        return std::strtoull(str, end, base);
+    }
+}
+
+// Memory utilities
+namespace FMemory
+{
+    inline void* Memcpy(void* Dest, const void* Src, SIZE_T Count)
+    {
+        return std::memcpy(Dest, Src, Count);
+    }
 }
 
 // Platform time utilities
@@ -525,10 +756,18 @@ namespace FCompression
     }
 }
 
-// Logging macros (standalone - output to console)
-#define SCRIPT_LOG(msg) std::cout << "[LOG] " << msg << std::endl
-#define SCRIPT_LOG_ERROR(msg) std::cerr << "[ERROR] " << msg << std::endl
-#define SCRIPT_LOG_WARNING(msg) std::cout << "[WARNING] " << msg << std::endl
+// Logging macros (standalone - output to console). Muted while compile-all runs its
+// workers: it reports every script's errors itself, in order, once they are done
+inline bool GStandaloneScriptLogMuted = false;
+#define SCRIPT_LOG(msg) do { if (!GStandaloneScriptLogMuted) std::cout << "[LOG] " << msg << std::endl; } while (0)
+#define SCRIPT_LOG_ERROR(msg) do { if (!GStandaloneScriptLogMuted) std::cerr << "[ERROR] " << msg << std::endl; } while (0)
+#define SCRIPT_LOG_WARNING(msg) do { if (!GStandaloneScriptLogMuted) std::cout << "[WARNING] " << msg << std::endl; } while (0)
+
+// VM logs are very chatty (one line per call/return); only echo them when requested
+inline bool GStandaloneVMVerbose = false;
+#define VM_LOG(msg) do { if (GStandaloneVMVerbose) std::cout << "[VM] " << msg << std::endl; } while (0)
+#define VM_LOG_ERROR(msg) std::cerr << "[VM ERROR] " << msg << std::endl
+#define VM_LOG_WARNING(msg) do { if (GStandaloneVMVerbose) std::cout << "[VM WARNING] " << msg << std::endl; } while (0)
 
 // Generated body macro (no-op in standalone)
 #define GENERATED_BODY()
@@ -723,6 +962,144 @@ struct FFileHelper
     }
 };
 
+// Read-only file mapping (UE-compatible API: IPlatformFile::OpenMappedEx, Async/MappedFileHandle.h)
+// The whole file is mapped when it is opened; regions are views of it
+class IMappedFileRegion
+{
+public:
+    IMappedFileRegion(const uint8* InPtr, int64 InSize) : Ptr(InPtr), Size(InSize) {}
+    
+    const uint8* GetMappedPtr() const { return Ptr; }
+    int64 GetMappedSize() const { return Size; }
+    
+private:
+    const uint8* Ptr;
+    int64 Size;
+};
+
+class IMappedFileHandle
+{
+public:
+    IMappedFileHandle(const IMappedFileHandle&) = delete;
+    IMappedFileHandle& operator=(const IMappedFileHandle&) = delete;
+    
+    ~IMappedFileHandle()
+    {
+        #ifdef _WIN32
+            if (Base) UnmapViewOfFile(Base);
+            if (Mapping) CloseHandle(Mapping);
+            if (File != INVALID_HANDLE_VALUE) CloseHandle(File);
+        #else
+            if (Base) munmap(const_cast<uint8*>(Base), Size);
+        #endif
+    }
+    
+    int64 GetFileSize() const { return Size; }
+    
+    IMappedFileRegion* MapRegion(int64 Offset = 0, int64 BytesToMap = INT64_MAX, bool bPreloadHint = false)
+    {
+        if (!Base || Offset < 0 || Offset > Size)
+        {
+            return nullptr;
+        }
+        const int64 Bytes = std::min(BytesToMap, Size - Offset);
+        #ifndef _WIN32
+            // Ask for the pages to be read ahead (madvise wants a page-aligned start)
+            if (bPreloadHint && Bytes > 0)
+            {
+                const UPTRINT PageSize = static_cast<UPTRINT>(sysconf(_SC_PAGESIZE));
+                const UPTRINT Start = reinterpret_cast<UPTRINT>(Base + Offset) & ~(PageSize - 1);
+                const UPTRINT End = reinterpret_cast<UPTRINT>(Base + Offset + Bytes);
+                madvise(reinterpret_cast<void*>(Start), End - Start, MADV_WILLNEED);
+            }
+        #endif
+        return new IMappedFileRegion(Base + Offset, Bytes);
+    }
+    
+    // nullptr if the file cannot be opened or is empty
+    static IMappedFileHandle* Open(const char* Filename)
+    {
+        IMappedFileHandle* Handle = new IMappedFileHandle();
+        #ifdef _WIN32
+            Handle->File = CreateFileA(Filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            LARGE_INTEGER FileSize;
+            if (Handle->File != INVALID_HANDLE_VALUE && GetFileSizeEx(Handle->File, &FileSize) && FileSize.QuadPart > 0)
+            {
+                Handle->Mapping = CreateFileMappingA(Handle->File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (Handle->Mapping)
+                {
+                    Handle->Base = static_cast<const uint8*>(MapViewOfFile(Handle->Mapping, FILE_MAP_READ, 0, 0, 0));
+                    Handle->Size = Handle->Base ? FileSize.QuadPart : 0;
+                }
+            }
+        #else
+            const int File = open(Filename, O_RDONLY);
+            struct stat Stat;
+            if (File >= 0 && fstat(File, &Stat) == 0 && Stat.st_size > 0)
+            {
+                void* Base = mmap(nullptr, Stat.st_size, PROT_READ, MAP_PRIVATE, File, 0);
+                if (Base != MAP_FAILED)
+                {
+                    Handle->Base = static_cast<const uint8*>(Base);
+                    Handle->Size = Stat.st_size;
+                }
+            }
+            if (File >= 0) close(File);
+        #endif
+        if (!Handle->Base)
+        {
+            delete Handle;
+            return nullptr;
+        }
+        return Handle;
+    }
+    
+private:
+    IMappedFileHandle() = default;
+    
+    const uint8* Base = nullptr;
+    int64 Size = 0;
+    #ifdef _WIN32
+        HANDLE File = INVALID_HANDLE_VALUE;
+        HANDLE Mapping = nullptr;
+    #endif
+};
+
+// UE: TValueOrError<TUniquePtr<IMappedFileHandle>, FFileSystemError>
+struct FOpenMappedResult
+{
+    TUniquePtr<IMappedFileHandle> Value;
+    
+    bool HasValue() const { return Value.IsValid(); }
+    bool HasError() const { return !Value.IsValid(); }
+    TUniquePtr<IMappedFileHandle> StealValue() { return MoveTemp(Value); }
+};
+
+class IPlatformFile
+{
+public:
+    FOpenMappedResult OpenMappedEx(const TCHAR* Filename)
+    {
+        FOpenMappedResult Result;
+        Result.Value.Reset(IMappedFileHandle::Open(Filename));
+        return Result;
+    }
+};
+
+struct FPlatformFileManager
+{
+    static FPlatformFileManager& Get()
+    {
+        static FPlatformFileManager Manager;
+        return Manager;
+    }
+    
+    IPlatformFile& GetPlatformFile() { return PlatformFile; }
+    
+private:
+    IPlatformFile PlatformFile;
+};
+
 // FString Printf (UE-compatible)
 inline FString FStringPrintf(const char* fmt, ...)
 {
@@ -893,8 +1270,68 @@ struct FPlatformMisc
         #endif
         return "Unknown";
     }
+    
+    static int32 NumberOfCoresIncludingHyperthreads()
+    {
+        const unsigned int cores = std::thread::hardware_concurrency();
+        return cores > 0 ? (int32)cores : 1;
+    }
+};
+
+// =============================================================================
+// Threading (UE-compatible API)
+// =============================================================================
+
+// Recursive, as FCriticalSection is on every UE platform
+class FCriticalSection
+{
+public:
+    void Lock() { Mutex.lock(); }
+    void Unlock() { Mutex.unlock(); }
+    
+private:
+    std::recursive_mutex Mutex;
+};
+
+class FScopeLock
+{
+public:
+    explicit FScopeLock(FCriticalSection* InSection) : Section(InSection) { Section->Lock(); }
+    ~FScopeLock() { Section->Unlock(); }
+    FScopeLock(const FScopeLock&) = delete;
+    FScopeLock& operator=(const FScopeLock&) = delete;
+    
+private:
+    FCriticalSection* Section;
 };
 
+// Runs Body(0) .. Body(Num - 1), one thread each (the caller's thread runs index 0),
+// and returns when all are done
+template<typename FuncType>
+inline void ParallelFor(int32 Num, FuncType&& Body, bool bForceSingleThread = false)
+{
+    if (bForceSingleThread || Num <= 1)
+    {
+        for (int32 i = 0; i < Num; ++i)
+        {
+            Body(i);
+        }
+        return;
+    }
+    
+    std::vector<std::thread> Threads;
+    Threads.reserve(Num - 1);
+    for (int32 i = 1; i < Num; ++i)
+    {
+        Threads.emplace_back([&Body, i]() { Body(i); });
+    }
+    Body(0);
+    for (std::thread& Thread : Threads)
+    {
+        Thread.join();
+    }
+}
+
 // Compatibility wrapper for FPlatformProcess
 struct FPlatformProcess
 {
@@ -949,12 +1386,6 @@ private:
     FString Utf8String;
 };
 
-// Forward declarations
-class FScriptVM;
-
-// Native function type
-using FNativeFunction = std::function<void(FScriptVM*)>;
-
 #else
 
 // Unreal Engine mode: Use real UE types
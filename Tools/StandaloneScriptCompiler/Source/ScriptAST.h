@@ -26,6 +26,46 @@ enum class EScriptType : uint8
     BOOL_ARRAY      // bool[]
 };
 
+/**
+ * What an AST node is. Set once by the node's constructor, so passes dispatch with a switch
+ * on GetKind() instead of a virtual call or a string compare per node.
+ */
+enum class EScriptNodeKind : uint8
+{
+    // Expressions
+    Literal,
+    ArrayLiteral,
+    ArrayAccess,
+    ArrayAssign,
+    StructLiteral,
+    StructAccess,
+    StructAssign,
+    Identifier,
+    Binary,
+    Unary,
+    Assign,
+    Call,
+    TypeCast,
+
+    // Statements
+    ExprStmt,
+    Import,
+    VarDecl,
+    Block,
+    If,
+    While,
+    For,
+    ForEach,
+    Switch,
+    Return,
+    Break,
+    Continue,
+
+    // Declarations
+    Function,
+    Program
+};
+
 // Forward declarations
 class FScriptExpression;
 
@@ -38,10 +78,55 @@ public:
     virtual ~FScriptASTNode() = default;
     
     virtual FString ToString() const { return TEXT("ASTNode"); }
-    virtual FString GetNodeType() const { return TEXT("FScriptASTNode"); }
+    
+    EScriptNodeKind GetKind() const { return Kind; }
+    
+    /** Kind name for messages, e.g. "Binary" */
+    FString GetNodeType() const { return GetKindName(Kind); }
+    
+    static const TCHAR* GetKindName(EScriptNodeKind InKind)
+    {
+        switch (InKind)
+        {
+            case EScriptNodeKind::Literal: return TEXT("Literal");
+            case EScriptNodeKind::ArrayLiteral: return TEXT("ArrayLiteral");
+            case EScriptNodeKind::ArrayAccess: return TEXT("ArrayAccess");
+            case EScriptNodeKind::ArrayAssign: return TEXT("ArrayAssign");
+            case EScriptNodeKind::StructLiteral: return TEXT("StructLiteral");
+            case EScriptNodeKind::StructAccess: return TEXT("StructAccess");
+            case EScriptNodeKind::StructAssign: return TEXT("StructAssign");
+            case EScriptNodeKind::Identifier: return TEXT("Identifier");
+            case EScriptNodeKind::Binary: return TEXT("Binary");
+            case EScriptNodeKind::Unary: return TEXT("Unary");
+            case EScriptNodeKind::Assign: return TEXT("Assign");
+            case EScriptNodeKind::Call: return TEXT("Call");
+            case EScriptNodeKind::TypeCast: return TEXT("TypeCast");
+            case EScriptNodeKind::ExprStmt: return TEXT("ExprStmt");
+            case EScriptNodeKind::Import: return TEXT("Import");
+            case EScriptNodeKind::VarDecl: return TEXT("VarDecl");
+            case EScriptNodeKind::Block: return TEXT("Block");
+            case EScriptNodeKind::If: return TEXT("If");
+            case EScriptNodeKind::While: return TEXT("While");
+            case EScriptNodeKind::For: return TEXT("For");
+            case EScriptNodeKind::ForEach: return TEXT("ForEach");
+            case EScriptNodeKind::Switch: return TEXT("Switch");
+            case EScriptNodeKind::Return: return TEXT("Return");
+            case EScriptNodeKind::Break: return TEXT("Break");
+            case EScriptNodeKind::Continue: return TEXT("Continue");
+            case EScriptNodeKind::Function: return TEXT("Function");
+            case EScriptNodeKind::Program: return TEXT("Program");
+            default: return TEXT("Unknown");
+        }
+    }
     
     // Validation
     virtual bool IsValid() const { return true; }
+
+protected:
+    explicit FScriptASTNode(EScriptNodeKind InKind) : Kind(InKind) {}
+
+private:
+    EScriptNodeKind Kind;
 };
 
 /**
@@ -50,8 +135,10 @@ public:
 class SCRIPTING_API FScriptStatement : public FScriptASTNode
 {
 public:
-    virtual FString GetNodeType() const override { return TEXT("Statement"); }
     virtual bool IsValid() const override { return true; }
+
+protected:
+    explicit FScriptStatement(EScriptNodeKind InKind) : FScriptASTNode(InKind) {}
 };
 
 /**
@@ -61,8 +148,9 @@ class SCRIPTING_API FScriptExpression : public FScriptASTNode
 {
 public:
     EScriptType InferredType = EScriptType::AUTO;
-    
-    virtual FString GetNodeType() const override { return TEXT("Expression"); }
+
+protected:
+    explicit FScriptExpression(EScriptNodeKind InKind) : FScriptASTNode(InKind) {}
 };
 
 /**
@@ -73,23 +161,23 @@ class SCRIPTING_API FLiteralExpr : public FScriptExpression
 public:
     FScriptToken Token;
     
-    FLiteralExpr(const FScriptToken& InToken) : Token(InToken) {}
+    FLiteralExpr(const FScriptToken& InToken) : FScriptExpression(EScriptNodeKind::Literal), Token(InToken) {}
     
     // Convenience constructors
     FLiteralExpr(const FScriptToken& InToken, bool BoolValue)
-        : Token(InToken)
+        : FScriptExpression(EScriptNodeKind::Literal), Token(InToken)
     {
         Token.Lexeme = BoolValue ? TEXT("true") : TEXT("false");
     }
     
     FLiteralExpr(const FScriptToken& InToken, double NumberValue)
-        : Token(InToken)
+        : FScriptExpression(EScriptNodeKind::Literal), Token(InToken)
     {
         Token.Lexeme = FString::SanitizeFloat(NumberValue);
     }
     
     FLiteralExpr(const FScriptToken& InToken, const FString& StringValue)
-        : Token(InToken)
+        : FScriptExpression(EScriptNodeKind::Literal), Token(InToken)
     {
         Token.Lexeme = StringValue;
     }
@@ -98,8 +186,6 @@ public:
     {
         return FString::Printf(TEXT("Literal(%s)"), *Token.Lexeme);
     }
-    
-    virtual FString GetNodeType() const override { return TEXT("Literal"); }
 };
 
 /**
@@ -111,7 +197,7 @@ public:
     TArray<TSharedPtr<FScriptExpression>> Elements;
     
     FArrayLiteralExpr(const TArray<TSharedPtr<FScriptExpression>>& InElements)
-        : Elements(InElements)
+        : FScriptExpression(EScriptNodeKind::ArrayLiteral), Elements(InElements)
     {}
     
     virtual bool IsValid() const override
@@ -134,8 +220,6 @@ public:
         }
         return FString::Printf(TEXT("ArrayLiteral([%s])"), *ElementsStr);
     }
-    
-    virtual FString GetNodeType() const override { return TEXT("ArrayLiteral"); }
 };
 
 /**
@@ -148,7 +232,7 @@ public:
     TSharedPtr<FScriptExpression> Index;
     
     FArrayAccessExpr(TSharedPtr<FScriptExpression> InArray, TSharedPtr<FScriptExpression> InIndex)
-        : Array(InArray), Index(InIndex)
+        : FScriptExpression(EScriptNodeKind::ArrayAccess), Array(InArray), Index(InIndex)
     {}
     
     virtual bool IsValid() const override
@@ -163,8 +247,6 @@ public:
         return FString::Printf(TEXT("ArrayAccess(%s[%s])"), 
             *Array->ToString(), *Index->ToString());
     }
-    
-    virtual FString GetNodeType() const override { return TEXT("ArrayAccess"); }
 };
 
 /**
@@ -180,7 +262,7 @@ public:
     FArrayAssignExpr(TSharedPtr<FScriptExpression> InArray, 
                      TSharedPtr<FScriptExpression> InIndex, 
                      TSharedPtr<FScriptExpression> InValue)
-        : Array(InArray), Index(InIndex), Value(InValue)
+        : FScriptExpression(EScriptNodeKind::ArrayAssign), Array(InArray), Index(InIndex), Value(InValue)
     {}
     
     virtual bool IsValid() const override
@@ -196,8 +278,6 @@ public:
         return FString::Printf(TEXT("ArrayAssign(%s[%s] = %s)"), 
             *Array->ToString(), *Index->ToString(), *Value->ToString());
     }
-    
-    virtual FString GetNodeType() const override { return TEXT("ArrayAssign"); }
 };
 
 /**
@@ -211,14 +291,14 @@ public:
     
     FStructLiteralExpr(const FString& InStructName, 
                       const TMap<FString, TSharedPtr<FScriptExpression>>& InFields)
-        : StructName(InStructName), Fields(InFields)
+        : FScriptExpression(EScriptNodeKind::StructLiteral), StructName(InStructName), Fields(InFields)
     {}
     
     virtual bool IsValid() const override
     {
         for (const auto& Field : Fields)
         {
-            if (!Field.second.IsValid() || !Field.second->IsValid()) return false;
+            if (!Field.Value.IsValid() || !Field.Value->IsValid()) return false;
         }
         return true;
     }
@@ -232,7 +312,7 @@ public:
         TArray<TPair<FString, TSharedPtr<FScriptExpression>>> FieldArray;
         for (const auto& Field : Fields)
         {
-            FieldArray.Add(TPair<FString, TSharedPtr<FScriptExpression>>(Field.first, Field.second));
+            FieldArray.Add(TPair<FString, TSharedPtr<FScriptExpression>>(Field.Key, Field.Value));
         }
         
         for (int32 i = 0; i < FieldArray.Num(); ++i)
@@ -244,8 +324,6 @@ public:
         
         return FString::Printf(TEXT("StructLiteral(%s{%s})"), *StructName, *FieldsStr);
     }
-    
-    virtual FString GetNodeType() const override { return TEXT("StructLiteral"); }
 };
 
 /**
@@ -258,7 +336,7 @@ public:
     FScriptToken Field;
     
     FStructAccessExpr(TSharedPtr<FScriptExpression> InObject, const FScriptToken& InField)
-        : Object(InObject), Field(InField)
+        : FScriptExpression(EScriptNodeKind::StructAccess), Object(InObject), Field(InField)
     {}
     
     virtual bool IsValid() const override
@@ -272,8 +350,6 @@ public:
         return FString::Printf(TEXT("StructAccess(%s.%s)"), 
             *Object->ToString(), *Field.Lexeme);
     }
-    
-    virtual FString GetNodeType() const override { return TEXT("StructAccess"); }
 };
 
 /**
@@ -289,7 +365,7 @@ public:
     FStructAssignExpr(TSharedPtr<FScriptExpression> InObject, 
                      const FScriptToken& InField,
                      TSharedPtr<FScriptExpression> InValue)
-        : Object(InObject), Field(InField), Value(InValue)
+        : FScriptExpression(EScriptNodeKind::StructAssign), Object(InObject), Field(InField), Value(InValue)
     {}
     
     virtual bool IsValid() const override
@@ -304,8 +380,6 @@ public:
         return FString::Printf(TEXT("StructAssign(%s.%s = %s)"), 
             *Object->ToString(), *Field.Lexeme, *Value->ToString());
     }
-    
-    virtual FString GetNodeType() const override { return TEXT("StructAssign"); }
 };
 
 /**
@@ -321,7 +395,7 @@ public:
     FSwitchStmt(TSharedPtr<FScriptExpression> InExpr,
                 const TArray<TPair<TSharedPtr<FScriptExpression>, TSharedPtr<FScriptStatement>>>& InCases,
                 TSharedPtr<FScriptStatement> InDefault = nullptr)
-        : Expression(InExpr), Cases(InCases), DefaultCase(InDefault)
+        : FScriptStatement(EScriptNodeKind::Switch), Expression(InExpr), Cases(InCases), DefaultCase(InDefault)
     {}
     
     virtual bool IsValid() const override
@@ -358,8 +432,6 @@ public:
         Result += TEXT("}");
         return Result;
     }
-    
-    virtual FString GetNodeType() const override { return TEXT("Switch"); }
 };
 
 /**
@@ -370,14 +442,12 @@ class SCRIPTING_API FIdentifierExpr : public FScriptExpression
 public:
     FScriptToken Name;
     
-    FIdentifierExpr(const FScriptToken& InName) : Name(InName) {}
+    FIdentifierExpr(const FScriptToken& InName) : FScriptExpression(EScriptNodeKind::Identifier), Name(InName) {}
     
     virtual FString ToString() const override
     {
         return FString::Printf(TEXT("Identifier(%s)"), *Name.Lexeme);
     }
-    
-    virtual FString GetNodeType() const override { return TEXT("Identifier"); }
 };
 
 /**
@@ -391,7 +461,7 @@ public:
     TSharedPtr<FScriptExpression> Right;
     
     FBinaryExpr(TSharedPtr<FScriptExpression> InLeft, const FScriptToken& InOp, TSharedPtr<FScriptExpression> InRight)
-        : Left(InLeft), Operator(InOp), Right(InRight)
+        : FScriptExpression(EScriptNodeKind::Binary), Left(InLeft), Operator(InOp), Right(InRight)
     {}
     
     virtual bool IsValid() const override
@@ -405,8 +475,6 @@ public:
         return FString::Printf(TEXT("Binary(%s %s %s)"), 
             *Left->ToString(), *Operator.Lexeme, *Right->ToString());
     }
-    
-    virtual FString GetNodeType() const override { return TEXT("Binary"); }
 };
 
 /**
@@ -419,7 +487,7 @@ public:
     TSharedPtr<FScriptExpression> Right;
     
     FUnaryExpr(const FScriptToken& InOp, TSharedPtr<FScriptExpression> InRight)
-        : Operator(InOp), Right(InRight)
+        : FScriptExpression(EScriptNodeKind::Unary), Operator(InOp), Right(InRight)
     {}
     
     virtual bool IsValid() const override
@@ -432,8 +500,6 @@ public:
         if (!IsValid()) return TEXT("Unary(INVALID)");
         return FString::Printf(TEXT("Unary(%s%s)"), *Operator.Lexeme, *Right->ToString());
     }
-    
-    virtual FString GetNodeType() const override { return TEXT("Unary"); }
 };
 
 /**
@@ -446,7 +512,7 @@ public:
     TSharedPtr<FScriptExpression> Value;
     
     FAssignExpr(TSharedPtr<FScriptExpression> InTarget, TSharedPtr<FScriptExpression> InValue)
-        : Target(InTarget), Value(InValue)
+        : FScriptExpression(EScriptNodeKind::Assign), Target(InTarget), Value(InValue)
     {}
     
     virtual bool IsValid() const override
@@ -459,8 +525,6 @@ public:
         if (!IsValid()) return TEXT("Assign(INVALID)");
         return FString::Printf(TEXT("Assign(%s = %s)"), *Target->ToString(), *Value->ToString());
     }
-    
-    virtual FString GetNodeType() const override { return TEXT("Assign"); }
 };
 
 /**
@@ -473,7 +537,7 @@ public:
     TArray<TSharedPtr<FScriptExpression>> Arguments;
     
     FCallExpr(TSharedPtr<FScriptExpression> InCallee, const TArray<TSharedPtr<FScriptExpression>>& InArgs)
-        : Callee(InCallee), Arguments(InArgs)
+        : FScriptExpression(EScriptNodeKind::Call), Callee(InCallee), Arguments(InArgs)
     {}
     
     virtual bool IsValid() const override
@@ -497,8 +561,6 @@ public:
         }
         return FString::Printf(TEXT("Call(%s(%s))"), *Callee->ToString(), *ArgsStr);
     }
-    
-    virtual FString GetNodeType() const override { return TEXT("Call"); }
 };
 
 /**
@@ -511,7 +573,7 @@ public:
     TSharedPtr<FScriptExpression> Expression;
     
     FTypeCastExpr(EScriptType InType, TSharedPtr<FScriptExpression> InExpr)
-        : TargetType(InType), Expression(InExpr)
+        : FScriptExpression(EScriptNodeKind::TypeCast), TargetType(InType), Expression(InExpr)
     {
         InferredType = TargetType;
     }
@@ -527,8 +589,6 @@ public:
         return FString::Printf(TEXT("Cast<%s>(%s)"), *GetTypeName(TargetType), *Expression->ToString());
     }
     
-    virtual FString GetNodeType() const override { return TEXT("TypeCast"); }
-    
     static FString GetTypeName(EScriptType Type)
     {
         switch (Type)
@@ -539,6 +599,10 @@ public:
             case EScriptType::STRING: return TEXT("string");
             case EScriptType::BOOL: return TEXT("bool");
             case EScriptType::AUTO: return TEXT("auto");
+            case EScriptType::INT_ARRAY: return TEXT("int[]");
+            case EScriptType::FLOAT_ARRAY: return TEXT("float[]");
+            case EScriptType::STRING_ARRAY: return TEXT("string[]");
+            case EScriptType::BOOL_ARRAY: return TEXT("bool[]");
             default: return TEXT("unknown");
         }
     }
@@ -554,7 +618,7 @@ class SCRIPTING_API FExprStmt : public FScriptStatement
 public:
     TSharedPtr<FScriptExpression> Expression;
     
-    FExprStmt(TSharedPtr<FScriptExpression> InExpr) : Expression(InExpr) {}
+    FExprStmt(TSharedPtr<FScriptExpression> InExpr) : FScriptStatement(EScriptNodeKind::ExprStmt), Expression(InExpr) {}
     
     virtual bool IsValid() const override
     {
@@ -566,8 +630,6 @@ public:
         if (!IsValid()) return TEXT("ExprStmt(INVALID)");
         return FString::Printf(TEXT("ExprStmt(%s)"), *Expression->ToString());
     }
-    
-    virtual FString GetNodeType() const override { return TEXT("ExprStmt"); }
 };
 
 /**
@@ -579,14 +641,13 @@ class SCRIPTING_API FImportStmt : public FScriptStatement
 public:
     FScriptToken Path; // String token containing the header path
     
-    FImportStmt(const FScriptToken& InPath) : Path(InPath) {}
+    FImportStmt(const FScriptToken& InPath) : FScriptStatement(EScriptNodeKind::Import), Path(InPath) {}
     
     virtual bool IsValid() const override { return Path.Type == ETokenType::STRING; }
     virtual FString ToString() const override
     {
         return FString::Printf(TEXT("Import(%s)"), *Path.Lexeme);
     }
-    virtual FString GetNodeType() const override { return TEXT("Import"); }
 };
 
 /**
@@ -600,7 +661,7 @@ public:
     TSharedPtr<FScriptExpression> Initializer;
     
     FVarDeclStmt(EScriptType InType, const FScriptToken& InName, TSharedPtr<FScriptExpression> InInit = nullptr)
-        : VarType(InType), Name(InName), Initializer(InInit)
+        : FScriptStatement(EScriptNodeKind::VarDecl), VarType(InType), Name(InName), Initializer(InInit)
     {}
     
     virtual bool IsValid() const override
@@ -618,8 +679,6 @@ public:
         }
         return FString::Printf(TEXT("VarDecl(%s %s)"), *TypeStr, *Name.Lexeme);
     }
-    
-    virtual FString GetNodeType() const override { return TEXT("VarDecl"); }
 };
 
 /**
@@ -630,7 +689,7 @@ class SCRIPTING_API FBlockStmt : public FScriptStatement
 public:
     TArray<TSharedPtr<FScriptStatement>> Statements;
     
-    FBlockStmt(const TArray<TSharedPtr<FScriptStatement>>& InStmts) : Statements(InStmts) {}
+    FBlockStmt(const TArray<TSharedPtr<FScriptStatement>>& InStmts) : FScriptStatement(EScriptNodeKind::Block), Statements(InStmts) {}
     
     virtual bool IsValid() const override
     {
@@ -652,8 +711,6 @@ public:
         Result += TEXT("})");
         return Result;
     }
-    
-    virtual FString GetNodeType() const override { return TEXT("Block"); }
 };
 
 /**
@@ -668,7 +725,7 @@ public:
     
     FIfStmt(TSharedPtr<FScriptExpression> InCond, TSharedPtr<FScriptStatement> InThen, 
             TSharedPtr<FScriptStatement> InElse = nullptr)
-        : Condition(InCond), ThenBranch(InThen), ElseBranch(InElse)
+        : FScriptStatement(EScriptNodeKind::If), Condition(InCond), ThenBranch(InThen), ElseBranch(InElse)
     {}
     
     virtual bool IsValid() const override
@@ -690,8 +747,6 @@ public:
         }
         return Result;
     }
-    
-    virtual FString GetNodeType() const override { return TEXT("If"); }
 };
 
 /**
@@ -704,7 +759,7 @@ public:
     TSharedPtr<FScriptStatement> Body;
     
     FWhileStmt(TSharedPtr<FScriptExpression> InCond, TSharedPtr<FScriptStatement> InBody)
-        : Condition(InCond), Body(InBody)
+        : FScriptStatement(EScriptNodeKind::While), Condition(InCond), Body(InBody)
     {}
     
     virtual bool IsValid() const override
@@ -719,8 +774,6 @@ public:
         return FString::Printf(TEXT("While(%s) Do(%s)"), 
             *Condition->ToString(), *Body->ToString());
     }
-    
-    virtual FString GetNodeType() const override { return TEXT("While"); }
 };
 
 /**
@@ -731,7 +784,7 @@ class SCRIPTING_API FReturnStmt : public FScriptStatement
 public:
     TSharedPtr<FScriptExpression> Value;
     
-    FReturnStmt(TSharedPtr<FScriptExpression> InValue = nullptr) : Value(InValue) {}
+    FReturnStmt(TSharedPtr<FScriptExpression> InValue = nullptr) : FScriptStatement(EScriptNodeKind::Return), Value(InValue) {}
     
     virtual bool IsValid() const override
     {
@@ -747,8 +800,6 @@ public:
         }
         return TEXT("Return()");
     }
-    
-    virtual FString GetNodeType() const override { return TEXT("Return"); }
 };
 
 /**
@@ -757,10 +808,9 @@ public:
 class SCRIPTING_API FBreakStmt : public FScriptStatement
 {
 public:
-    FBreakStmt() {}
+    FBreakStmt() : FScriptStatement(EScriptNodeKind::Break) {}
     
     virtual FString ToString() const override { return TEXT("Break()"); }
-    virtual FString GetNodeType() const override { return TEXT("Break"); }
 };
 
 /**
@@ -769,10 +819,9 @@ public:
 class SCRIPTING_API FContinueStmt : public FScriptStatement
 {
 public:
-    FContinueStmt() {}
+    FContinueStmt() : FScriptStatement(EScriptNodeKind::Continue) {}
     
     virtual FString ToString() const override { return TEXT("Continue()"); }
-    virtual FString GetNodeType() const override { return TEXT("Continue"); }
 };
 
 /**
@@ -790,7 +839,7 @@ public:
              TSharedPtr<FScriptExpression> InCond,
              TSharedPtr<FScriptExpression> InIncr,
              TSharedPtr<FScriptStatement> InBody)
-        : Initializer(InInit), Condition(InCond), Increment(InIncr), Body(InBody)
+        : FScriptStatement(EScriptNodeKind::For), Initializer(InInit), Condition(InCond), Increment(InIncr), Body(InBody)
     {}
     
     virtual bool IsValid() const override
@@ -811,8 +860,37 @@ public:
         return FString::Printf(TEXT("For(%s; %s; %s) Do(%s)"),
             *InitStr, *CondStr, *IncrStr, *Body->ToString());
     }
+};
+
+/**
+ * For-each statement (for (x in array) body)
+ */
+class SCRIPTING_API FForEachStmt : public FScriptStatement
+{
+public:
+    EScriptType VarType;    // AUTO for 'for (x in ...)' and 'for (var x in ...)'
+    FScriptToken Name;
+    TSharedPtr<FScriptExpression> Iterable;
+    TSharedPtr<FScriptStatement> Body;
+    
+    FForEachStmt(EScriptType InType, const FScriptToken& InName,
+                 TSharedPtr<FScriptExpression> InIterable,
+                 TSharedPtr<FScriptStatement> InBody)
+        : FScriptStatement(EScriptNodeKind::ForEach), VarType(InType), Name(InName), Iterable(InIterable), Body(InBody)
+    {}
+    
+    virtual bool IsValid() const override
+    {
+        return Iterable.IsValid() && Iterable->IsValid() &&
+               Body.IsValid() && Body->IsValid();
+    }
     
-    virtual FString GetNodeType() const override { return TEXT("For"); }
+    virtual FString ToString() const override
+    {
+        if (!IsValid()) return TEXT("ForEach(INVALID)");
+        return FString::Printf(TEXT("ForEach(%s %s in %s) Do(%s)"),
+            *FTypeCastExpr::GetTypeName(VarType), *Name.Lexeme, *Iterable->ToString(), *Body->ToString());
+    }
 };
 
 /**
@@ -838,7 +916,7 @@ public:
     
     FFunctionDecl(const FScriptToken& InName, const TArray<FScriptToken>& InParams, 
                   TSharedPtr<FBlockStmt> InBody)
-        : Name(InName), Parameters(InParams), TypedParameters(), Body(InBody), ReturnType(EScriptType::VOID)
+        : FScriptASTNode(EScriptNodeKind::Function), Name(InName), Parameters(InParams), TypedParameters(), Body(InBody), ReturnType(EScriptType::VOID)
     {}
     
     virtual bool IsValid() const override
@@ -892,8 +970,6 @@ public:
         return FString::Printf(TEXT("%s %s(%s) %s"), 
             *ReturnTypeStr, *Name.Lexeme, *ParamsStr, *Body->ToString());
     }
-    
-    virtual FString GetNodeType() const override { return TEXT("Function"); }
 };
 
 /**
@@ -907,7 +983,7 @@ public:
     
     FScriptProgram(const TArray<TSharedPtr<FFunctionDecl>>& InFuncs, 
                    const TArray<TSharedPtr<FScriptStatement>>& InStmts)
-        : Functions(InFuncs), Statements(InStmts)
+        : FScriptASTNode(EScriptNodeKind::Program), Functions(InFuncs), Statements(InStmts)
     {}
     
     virtual bool IsValid() const override
@@ -937,7 +1013,72 @@ public:
         Result += TEXT(")");
         return Result;
     }
-    
-    virtual FString GetNodeType() const override { return TEXT("Program"); }
 };
 
+/**
+ * Node storage for one parse
+ *
+ * FScriptParser constructs every node of a program in large blocks from here instead of
+ * making one heap allocation (with its own reference count) per node. The TSharedPtrs that
+ * link nodes to their children do not own them: the FScriptProgram handle returned by
+ * Parse owns the arena, and releasing its last copy destroys the whole tree at once.
+ * A node must therefore not be used after its program has been released.
+ */
+class FScriptASTArena
+{
+public:
+    explicit FScriptASTArena(int32 InBlockSize = 64 * 1024)
+        : BlockSize(InBlockSize), BlockUsed(0)
+    {}
+    
+    ~FScriptASTArena()
+    {
+        for (int32 i = Nodes.Num() - 1; i >= 0; --i)
+        {
+            Nodes[i]->~FScriptASTNode();
+        }
+    }
+    
+    FScriptASTArena(const FScriptASTArena&) = delete;
+    FScriptASTArena& operator=(const FScriptASTArena&) = delete;
+    
+    /** Construct a node in the arena; it lives until the arena is destroyed */
+    template<typename NodeType, typename... ArgTypes>
+    NodeType* New(ArgTypes&&... Args)
+    {
+        NodeType* Node = new (Allocate(sizeof(NodeType), alignof(NodeType))) NodeType(Forward<ArgTypes>(Args)...);
+        Nodes.Add(Node);
+        return Node;
+    }
+    
+    int32 GetNumNodes() const { return Nodes.Num(); }
+    
+    int64 GetBytesAllocated() const
+    {
+        int64 Bytes = 0;
+        for (const TArray<uint8>& Block : Blocks)
+        {
+            Bytes += Block.Num();
+        }
+        return Bytes;
+    }
+
+private:
+    void* Allocate(int32 Size, int32 Alignment)
+    {
+        int32 Offset = (BlockUsed + Alignment - 1) & ~(Alignment - 1);
+        if (Blocks.Num() == 0 || Offset + Size > Blocks.Last().Num())
+        {
+            Blocks.Add(TArray<uint8>());
+            Blocks.Last().SetNumUninitialized(FMath::Max(BlockSize, Size));
+            Offset = 0;
+        }
+        BlockUsed = Offset + Size;
+        return Blocks.Last().GetData() + Offset;
+    }
+    
+    TArray<TArray<uint8>> Blocks;
+    TArray<FScriptASTNode*> Nodes; // In construction order, for the destructors
+    int32 BlockSize;
+    int32 BlockUsed;
+};
@@ -83,9 +83,201 @@ enum class EOpCode : uint8
     OP_SET_FIELD,      // Set struct field: obj.field = value
     
     // End
-    OP_HALT            // Stop execution
+    OP_HALT,           // Stop execution
+
+    // Loops (appended so existing opcode values stay stable in saved .scc files)
+    OP_FOR_PREP,       // Counted loop entry: [slot][flags][exit offset] - skip the loop if the range is empty
+    OP_FOR_LOOP,       // Counted loop step:  [slot][flags][body offset] - i += step, jump back while in range
+    OP_FOREACH,        // Array iteration:    [slot][exit offset] - advance the index, load the element or exit
+    
+    // Calls (appended)
+    OP_TAIL_CALL,      // 'return f(...)': operands as OP_CALL, but the callee replaces the current frame
+    
+    // Switch dispatch (appended) - variable length, see SWITCH_TABLE_HEADER_SIZE
+    OP_SWITCH_TABLE,   // [low:4][count:2][default offset][count offsets] - pop v, jump to offsets[v - low]
+    OP_SWITCH_LOOKUP,  // [keys:2][count:2][default offset][count offsets] - pop v, binary search the keys constant
+    
+    // Wide operands (appended) - only emitted where the compact form cannot encode the operand
+    OP_CONSTANT_WIDE,      // [index:3]
+    OP_DEFINE_GLOBAL_WIDE, // [name:3]
+    OP_GET_GLOBAL_WIDE,    // [name:3]
+    OP_SET_GLOBAL_WIDE,    // [name:3]
+    OP_GET_LOCAL_WIDE,     // [slot:2]
+    OP_SET_LOCAL_WIDE,     // [slot:2]
+    OP_JUMP_WIDE,          // [offset:4]
+    OP_JUMP_IF_FALSE_WIDE, // [offset:4]
+    OP_LOOP_WIDE,          // [offset:4]
+    OP_FOREACH_WIDE,       // [slot:2][exit offset:4]
+    
+    // Number-guarded operators (appended) - only emitted from a profile, see ScriptProfile.h
+    OP_ADD_NUMBER,         // +
+    OP_SUBTRACT_NUMBER,    // -
+    OP_MULTIPLY_NUMBER,    // *
+    OP_LESS_NUMBER,        // <
+    OP_GREATER_NUMBER,     // >
+    OP_NOT_LESS_NUMBER,    // >= (OP_LESS, OP_NOT)
+    OP_NOT_GREATER_NUMBER  // <= (OP_GREATER, OP_NOT)
 };
 
+/**
+ * OP_CALL_NATIVE argument-count byte
+ * The high bit is set when the compiler proved every argument matches the native's
+ * typed signature; the VM then calls the unchecked entry point of the binding.
+ */
+static constexpr uint8 NATIVE_CALL_ARGS_CHECKED = 0x80;
+static constexpr uint8 NATIVE_CALL_ARGC_MASK = 0x7F;
+
+/**
+ * OP_FOR_PREP / OP_FOR_LOOP flags byte
+ * The induction variable is in local 'slot', the limit in slot+1 and the step in slot+2.
+ * The loop runs while i < limit (step > 0) or i > limit (step < 0); with
+ * FOR_LOOP_INCLUSIVE the bound is <= / >=.
+ *
+ * OP_FOREACH keeps the array in local 'slot', the index in slot+1 and the
+ * loop variable in slot+2.
+ */
+static constexpr uint8 FOR_LOOP_INCLUSIVE = 0x01;
+
+/**
+ * OP_SWITCH_TABLE / OP_SWITCH_LOOKUP
+ * A fixed header followed by 'count' 16-bit case offsets. Every offset, the default
+ * one included, is forward and relative to the end of the whole instruction.
+ *
+ * OP_SWITCH_TABLE covers the integers low..low+count-1 (low is a signed 32-bit
+ * value); a number equal to one of them (as OP_EQUAL compares) takes that case,
+ * anything else the default. Holes in the range hold the default offset.
+ *
+ * OP_SWITCH_LOOKUP names an array constant of 'count' keys, either all integers
+ * in ascending order or all strings in ascending case-sensitive order, and takes
+ * the case at the index of the key equal to the value.
+ */
+static constexpr int32 SWITCH_TABLE_HEADER_SIZE = 9;
+static constexpr int32 SWITCH_LOOKUP_HEADER_SIZE = 7;
+
+/**
+ * _WIDE opcodes
+ * The compact forms take an 8-bit constant index or local slot and a 16-bit jump
+ * offset. Past those the compiler switches to the _WIDE form of the same operation,
+ * with a 24-bit constant index, a 16-bit slot and a 32-bit offset (all big-endian).
+ * OP_FOR_PREP / OP_FOR_LOOP and the switch opcodes have no wide form: loops and
+ * switches that would need one compile as while loops and comparison chains.
+ */
+static constexpr int32 MAX_COMPACT_OPERAND = 0xFF;
+static constexpr int32 MAX_WIDE_CONSTANT_INDEX = 0xFFFFFF;
+static constexpr int32 MAX_WIDE_LOCAL_SLOT = 0xFFFF;
+
+/** The _WIDE form of an opcode with a constant, slot or jump operand, or the opcode itself if it has none */
+SCRIPTING_API EOpCode GetWideOpCode(EOpCode OpCode);
+
+/**
+ * _NUMBER opcodes
+ * The operator on two numbers, worked out in place on the stack. Any other pair of
+ * operands is handed to the generic opcode (for the _NOT_ forms, the generic opcode
+ * followed by OP_NOT), so a _NUMBER opcode behaves exactly like the code it replaces
+ * and the guard is all a wrong guess costs.
+ */
+
+/** The _NUMBER form of a generic operator, or the opcode itself if it has none */
+SCRIPTING_API EOpCode GetNumberOpCode(EOpCode OpCode);
+
+/** The generic operator a _NUMBER opcode stands for (OP_LESS for OP_NOT_LESS_NUMBER), or the opcode itself */
+SCRIPTING_API EOpCode GetGenericOpCode(EOpCode OpCode);
+
+/**
+ * Register bytecode operation codes
+ *
+ * The alternative backend (FScriptVM::SetBackend): three-address instructions over
+ * the registers of a function frame, kept in FBytecodeChunk::RegisterCode next to the
+ * stack code of the same functions. Register r is frame slot r, so the arguments
+ * arrive in r0..rN-1 and the counted/for-each loop opcodes keep the slot layout of
+ * OP_FOR_PREP / OP_FOREACH.
+ *
+ * Operands (see GetRegisterOperands): R register byte, K 16-bit constant index,
+ * F 16-bit function index, B raw byte, J signed 16-bit jump relative to the next
+ * instruction, N count byte followed by that many registers. The first R operand
+ * of an instruction that produces a value is its destination.
+ */
+UENUM()
+enum class ERegOpCode : uint8
+{
+    REG_LOAD_CONSTANT,  // RK   dst = constant
+    REG_LOAD_NIL,       // R
+    REG_LOAD_TRUE,      // R
+    REG_LOAD_FALSE,     // R
+    REG_MOVE,           // RR   dst = src
+
+    REG_ADD,            // RRR  dst = a + b
+    REG_SUBTRACT,       // RRR
+    REG_MULTIPLY,       // RRR
+    REG_DIVIDE,         // RRR
+    REG_MODULO,         // RRR
+    REG_NEGATE,         // RR
+
+    REG_EQUAL,          // RRR
+    REG_GREATER,        // RRR
+    REG_LESS,           // RRR
+    REG_NOT,            // RR
+    REG_AND,            // RRR
+    REG_OR,             // RRR
+
+    REG_BIT_AND,        // RRR
+    REG_BIT_OR,         // RRR
+    REG_BIT_XOR,        // RRR
+    REG_BIT_NOT,        // RR
+
+    REG_CAST_INT,       // RR
+    REG_CAST_FLOAT,     // RR
+    REG_CAST_STRING,    // RR
+
+    REG_GET_GLOBAL,     // RK   dst = global named by the constant
+    REG_SET_GLOBAL,     // RK   global = src
+
+    REG_JUMP,           // J
+    REG_JUMP_IF_FALSE,  // RJ
+    REG_JUMP_IF_TRUE,   // RJ
+
+    // Compare and branch: jump if the comparison holds (IF) or fails (IF_NOT)
+    REG_JUMP_IF_EQUAL,          // RRJ
+    REG_JUMP_IF_NOT_EQUAL,      // RRJ
+    REG_JUMP_IF_LESS,           // RRJ
+    REG_JUMP_IF_NOT_LESS,       // RRJ
+    REG_JUMP_IF_GREATER,        // RRJ
+    REG_JUMP_IF_NOT_GREATER,    // RRJ
+
+    REG_FOR_PREP,       // RBJ  as OP_FOR_PREP
+    REG_FOR_LOOP,       // RBJ  as OP_FOR_LOOP (J is negative)
+    REG_FOREACH,        // RJ   as OP_FOREACH
+
+    REG_CALL,           // RFN  dst = function(args...)
+    REG_TAIL_CALL,      // FN   as OP_TAIL_CALL
+    REG_CALL_NATIVE,    // RBKN dst = native(args...); B is the OP_CALL_NATIVE argument byte without the count
+    REG_RETURN,         // R
+
+    REG_CREATE_ARRAY,   // RN
+    REG_GET_ELEMENT,    // RRR  dst = array[index]
+    REG_SET_ELEMENT,    // RRRR dst = copy of array with [index] = value
+    REG_GET_FIELD,      // RRK  dst = object.field
+    REG_SET_FIELD,      // RRRK dst = object after object.field = value
+
+    REG_OPCODE_COUNT
+};
+
+/** Register code layout version, written to the .scc header whenever a chunk carries register code */
+static constexpr int32 REGISTER_CODE_VERSION = 1;
+
+/**
+ * Compiler output version: bump whenever the compiler emits different code for the same
+ * source or the chunk/.scc layout changes, so build records made by older compilers go stale.
+ * 2 - run-length line table, 3 - memory-mappable SBC3 files
+ */
+static constexpr int32 BYTECODE_FORMAT_VERSION = 3;
+
+/** Operand layout of a register opcode (see ERegOpCode), nullptr for bytes that are not opcodes */
+SCRIPTING_API const TCHAR* GetRegisterOperands(ERegOpCode OpCode);
+
+/** Size of the register instruction at Offset, 0 if there is no opcode there or it runs past End */
+SCRIPTING_API int32 GetRegisterInstructionSize(const TArray<uint8>& Code, int32 Offset, int32 End);
+
 /**
  * Compiler types for bytecode verification
  */
@@ -259,24 +451,78 @@ struct SCRIPTING_API FScriptValue
     const FString& AsString() const { return StringValue; }
     bool AsBool() const { return BoolValue; }
     const TArray<FScriptValue>& AsArray() const { return ArrayValue; }
+    
+    /**
+     * Append a self-describing binary encoding of this value (arrays are written recursively)
+     * Used for VM snapshots and host-side state that travels with them
+     */
+    void SerializeTo(TArray<uint8>& OutData) const;
+    
+    /**
+     * Read a value written by SerializeTo, advancing Offset
+     * Returns false if the data is truncated or malformed
+     */
+    bool DeserializeFrom(const TArray<uint8>& InData, int32& Offset);
 };
 
 /**
- * Debug information for a bytecode instruction
+ * Source position (file and line) of each byte of code, kept as runs: a run starts
+ * wherever the line or the file changes and covers the bytes up to the next one, so a
+ * statement costs one entry rather than one per byte. Files are kept once, in Files, and
+ * referred to by index. Positions are found by binary search over the runs.
+ *
+ * Serialized, each run is stored as the distance from the one before it (offset and
+ * line, varint encoded), with the file index only where it changes.
  */
-struct FDebugInfo
+struct SCRIPTING_API FLineTable
 {
-    int32 Line;
-    int32 Column;
-    FString SourceFile;
-    
-    FDebugInfo()
-        : Line(0), Column(0)
-    {}
-    
-    FDebugInfo(int32 InLine, int32 InColumn, const FString& InFile = TEXT(""))
-        : Line(InLine), Column(InColumn), SourceFile(InFile)
-    {}
+    struct FRun
+    {
+        int32 Offset;   // First byte of code in the run
+        int32 Line;
+        int32 File;     // Index in Files
+    };
+
+    TArray<FString> Files;  // Empty = the compiled script; others are headers inlined or linked in
+    TArray<FRun> Runs;      // By offset, first at 0
+
+    /** Record the next Count bytes of code as coming from Line of SourceFile */
+    void Add(int32 Line, const FString& SourceFile, int32 Count = 1);
+
+    /** Record the bytes of another table (a module's code appended after this code) */
+    void Append(const FLineTable& Other);
+
+    /** Forget the bytes from NewNum on, the code having been cut back to NewNum */
+    void Truncate(int32 NewNum);
+
+    void Empty();
+
+    /** Bytes of code covered, the length of the code when the table is complete */
+    int32 Num() const { return NumBytes; }
+
+    /** Run holding the byte at Offset, nullptr if the table does not cover it */
+    const FRun* Find(int32 Offset) const;
+
+    /** Line of the byte at Offset, 0 if unknown */
+    int32 GetLine(int32 Offset) const;
+
+    /** File of the byte at Offset, empty for the compiled script or if unknown */
+    const FString& GetFile(int32 Offset) const;
+
+    SIZE_T GetAllocatedSize() const;
+
+    void SerializeTo(TArray<uint8>& OutData) const;
+
+    /**
+     * Read a table written by SerializeTo, advancing Offset
+     * Returns false if the data is truncated or malformed
+     */
+    bool DeserializeFrom(const TArray<uint8>& InData, int32& Offset);
+
+private:
+    int32 FindOrAddFile(const FString& SourceFile);
+
+    int32 NumBytes = 0;
 };
 
 /**
@@ -287,13 +533,16 @@ struct SCRIPTING_API FFunctionInfo
     FString Name;
     int32 Address;
     int32 Arity;
-    
+    int32 RegisterAddress;      // Offset in RegisterCode, INDEX_NONE = stack code only
+    int32 NumRegisters;         // Frame size of the register code, arguments included
+    FString Module;             // Import path of the module that defines it (Address is INDEX_NONE until linked), empty = this chunk
+
     FFunctionInfo()
-        : Address(-1), Arity(0)
+        : Address(-1), Arity(0), RegisterAddress(INDEX_NONE), NumRegisters(0)
     {}
-    
+
     FFunctionInfo(const FString& InName, int32 InAddress, int32 InArity)
-        : Name(InName), Address(InAddress), Arity(InArity)
+        : Name(InName), Address(InAddress), Arity(InArity), RegisterAddress(INDEX_NONE), NumRegisters(0)
     {}
 };
 
@@ -369,6 +618,41 @@ struct SCRIPTING_API FBytecodeMetadata
     }
 };
 
+/**
+ * Hash index over a chunk's constant pool, so AddConstant finds an existing constant
+ * without scanning the pool. The compiler builds one per compilation and drops it when
+ * done; it is never serialized or kept with a loaded chunk.
+ *
+ * Constants are chained per bucket, newest first, which lets the pool be cut back to
+ * an earlier size (an abandoned function body) by unlinking only the removed tail.
+ */
+struct SCRIPTING_API FConstantPoolIndex
+{
+    /** Index of the constant in Constants that is the same as Value, or INDEX_NONE */
+    int32 Find(const TArray<FScriptValue>& Constants, const FScriptValue& Value) const;
+    
+    /** Index Constants.Last(), just appended to the pool */
+    void Add(const TArray<FScriptValue>& Constants);
+    
+    /** Unlink the constants from NewNum on, before the pool is cut back to NewNum */
+    void Truncate(const TArray<FScriptValue>& Constants, int32 NewNum);
+    
+    /**
+     * Per-type hash: NUMBER hashes its bits (with -0 folded into 0), STRING its characters,
+     * ARRAY its length and elements. Values that are IsSameConstant hash the same.
+     */
+    static uint32 HashConstant(const FScriptValue& Value);
+    
+    /** Exact equality, arrays compared element by element */
+    static bool IsSameConstant(const FScriptValue& A, const FScriptValue& B);
+    
+private:
+    TArray<int32> Buckets;  // Newest constant in each bucket, INDEX_NONE = empty; power-of-two count
+    TArray<int32> Next;     // Next older constant in the same bucket, parallel to the pool
+    
+    void Rehash(const TArray<FScriptValue>& Constants, int32 NumBuckets);
+};
+
 /**
  * Compiled bytecode chunk
  */
@@ -383,32 +667,28 @@ struct SCRIPTING_API FBytecodeChunk
     
     // Bytecode instructions
     TArray<uint8> Code;
-    
+
+    // Register code of the functions that have it (see ERegOpCode, FFunctionInfo::RegisterAddress)
+    TArray<uint8> RegisterCode;
+
     // Constant pool
     TArray<FScriptValue> Constants;
     
     // Function table
     TArray<FFunctionInfo> Functions;
     
-    // Line numbers for debugging
-    TArray<int32> LineNumbers;
-    
-    // Debug information (not serialized in shipping builds)
-    TArray<FDebugInfo> DebugInfo;
+    // Source position of each byte of Code (not recorded in shipping builds)
+    FLineTable LineTable;
     
     // Source code hash (for cache validation)
     FString SourceHash;
     
-    FBytecodeChunk()
-        : Version(1)
-    {}
-    
-    void WriteByte(uint8 Byte, int32 Line = 0)
+    void WriteByte(uint8 Byte, int32 Line = 0, const FString& SourceFile = FString())
     {
         Code.Add(Byte);
         
         #if !UE_BUILD_SHIPPING
-        DebugInfo.Add(FDebugInfo(Line, 0));
+        LineTable.Add(Line, SourceFile);
         #endif
     }
     
@@ -418,53 +698,37 @@ struct SCRIPTING_API FBytecodeChunk
         WriteByte(Byte2, Line);
     }
     
-    int32 AddConstant(const FScriptValue& Value)
-    {
-        // Check if constant already exists (optimization)
-        for (int32 i = 0; i < Constants.Num(); ++i)
-        {
-            const FScriptValue& Existing = Constants[i];
-            if (Existing.Type == Value.Type)
-            {
-                switch (Value.Type)
-                {
-                    case EValueType::NIL:
-                        return i;
-                    case EValueType::BOOL:
-                        if (Existing.BoolValue == Value.BoolValue) return i;
-                        break;
-                    case EValueType::NUMBER:
-                        if (FMath::IsNearlyEqual(Existing.NumberValue, Value.NumberValue))
-                            return i;
-                        break;
-                    case EValueType::STRING:
-                        if (Existing.StringValue == Value.StringValue) return i;
-                        break;
-                }
-            }
-        }
-        
-        Constants.Add(Value);
-        return Constants.Num() - 1;
-    }
+    // Set by the compiler while it builds this chunk (see FConstantPoolIndex), null otherwise
+    TSharedPtr<FConstantPoolIndex> ConstantIndex;
+    
+    /** Index of Value in the constant pool, appending it if no constant is the same */
+    int32 AddConstant(const FScriptValue& Value);
+    
+    /** Cut the constant pool back to NewNum entries, keeping ConstantIndex in step */
+    void TruncateConstants(int32 NewNum);
     
     void Clear()
     {
         Code.Empty();
+        RegisterCode.Empty();
         Constants.Empty();
-        DebugInfo.Empty();
+        ConstantIndex.Reset();
+        LineTable.Empty();
     }
     
     // Disassemble for debugging
     FString Disassemble() const;
     
+    // Disassemble the register code only
+    FString DisassembleRegisterCode() const;
+    
     // Decompile bytecode back to script-like representation
     FString Decompile() const;
     
-    // Serialize bytecode to binary array (with compression)
+    // Serialize bytecode to binary array (with compression) - the SBC1 format; FScriptBytecodeFile writes v3
     bool Serialize(TArray<uint8>& OutData, bool bCompress = true) const;
     
-    // Deserialize bytecode from binary array (with decompression)
+    // Deserialize bytecode from binary array (with decompression) - SBC1, or v3 through FScriptBytecodeFile
     bool Deserialize(const TArray<uint8>& InData);
     
     // Generate digital signature for the bytecode
@@ -0,0 +1,207 @@
+// Copyright Vampire Game Project. All Rights Reserved.
+// Custom scripting system for secure modding support.
+
+#include "ScriptCompileDatabase.h"
+#include "ScriptBytecode.h"
+#include "ScriptNativeRegistry.h"
+#include "ScriptLogger.h"
+
+// Magic number for compile databases: "SBD1" (Script Build Database v1)
+static const uint32 COMPILE_DATABASE_MAGIC = 0x31444253;
+static const int32 COMPILE_DATABASE_VERSION = 1;
+
+// FNV-1a, as for header artifacts
+static const uint64 FNV_OFFSET_BASIS = 14695981039346656037ull;
+static const uint64 FNV_PRIME = 1099511628211ull;
+
+static uint64 HashString(uint64 Hash, const FString& Str)
+{
+    Hash = (Hash ^ static_cast<uint64>(Str.Len())) * FNV_PRIME;
+    for (int32 i = 0; i < Str.Len(); ++i)
+    {
+        Hash = (Hash ^ static_cast<uint64>(Str[i])) * FNV_PRIME;
+    }
+    return Hash;
+}
+
+FScriptCompileDatabase::FScriptCompileDatabase()
+    : bInliningEnabled(true)
+    , bOptimizationEnabled(false)
+    , bRegisterCodeEnabled(false)
+{
+}
+
+bool FScriptCompileDatabase::Load(const FString& FileName)
+{
+    Entries.Empty();
+
+    TArray<uint8> Data;
+    if (!FPaths::FileExists(FileName) || !FFileHelper::LoadFileToArray(Data, *FileName))
+    {
+        return false;
+    }
+
+    int32 Offset = 0;
+    bool bValid = true;
+
+    auto ReadUInt32 = [&Data, &Offset, &bValid]() -> uint32 {
+        if (Offset + 4 > Data.Num())
+        {
+            bValid = false;
+            return 0;
+        }
+        uint32 Value = 0;
+        for (int32 i = 0; i < 4; ++i)
+        {
+            Value |= static_cast<uint32>(Data[Offset++]) << (i * 8);
+        }
+        return Value;
+    };
+
+    // Counts are bounded by the bytes left, so a corrupt file cannot ask for a huge allocation
+    auto ReadCount = [&Data, &Offset, &bValid, &ReadUInt32]() -> int32 {
+        const int32 Count = static_cast<int32>(ReadUInt32());
+        if (Count < 0 || Count > Data.Num() - Offset)
+        {
+            bValid = false;
+            return 0;
+        }
+        return Count;
+    };
+
+    auto ReadString = [&Data, &Offset, &ReadCount]() -> FString {
+        const int32 Length = ReadCount();
+        TArray<ANSICHAR> UTF8Data;
+        UTF8Data.SetNum(Length + 1);
+        for (int32 i = 0; i < Length; ++i)
+        {
+            UTF8Data[i] = Data[Offset++];
+        }
+        UTF8Data[Length] = 0;
+        return FString(UTF8_TO_TCHAR(UTF8Data.GetData()));
+    };
+
+    if (ReadUInt32() != COMPILE_DATABASE_MAGIC || static_cast<int32>(ReadUInt32()) != COMPILE_DATABASE_VERSION)
+    {
+        SCRIPT_LOG_WARNING(FString::Printf(TEXT("Ignoring compile database %s: not a database of this version"), *FileName));
+        return false;
+    }
+
+    const int32 NumEntries = ReadCount();
+    for (int32 i = 0; i < NumEntries && bValid; ++i)
+    {
+        const FString Name = ReadString();
+        FEntry Entry;
+        Entry.Key = static_cast<uint64>(ReadUInt32());
+        Entry.Key |= static_cast<uint64>(ReadUInt32()) << 32;
+        const int32 NumImports = ReadCount();
+        for (int32 j = 0; j < NumImports && bValid; ++j)
+        {
+            Entry.Imports.Add(ReadString());
+        }
+        Entries.Add(Name, MoveTemp(Entry));
+    }
+
+    if (!bValid)
+    {
+        SCRIPT_LOG_WARNING(FString::Printf(TEXT("Ignoring compile database %s: truncated"), *FileName));
+        Entries.Empty();
+        return false;
+    }
+    return true;
+}
+
+bool FScriptCompileDatabase::Save(const FString& FileName) const
+{
+    TArray<uint8> Data;
+    auto WriteUInt32 = [&Data](uint32 Value) {
+        for (int32 i = 0; i < 4; ++i)
+        {
+            Data.Add((Value >> (i * 8)) & 0xFF);
+        }
+    };
+
+    auto WriteString = [&Data, &WriteUInt32](const FString& Str) {
+        FTCHARToUTF8 Converter(*Str);
+        WriteUInt32(Converter.Length());
+        Data.Append(reinterpret_cast<const uint8*>(Converter.Get()), Converter.Length());
+    };
+
+    WriteUInt32(COMPILE_DATABASE_MAGIC);
+    WriteUInt32(COMPILE_DATABASE_VERSION);
+    WriteUInt32(Entries.Num());
+    for (const auto& Pair : Entries)
+    {
+        WriteString(Pair.Key);
+        WriteUInt32(static_cast<uint32>(Pair.Value.Key));
+        WriteUInt32(static_cast<uint32>(Pair.Value.Key >> 32));
+        WriteUInt32(Pair.Value.Imports.Num());
+        for (const FString& Import : Pair.Value.Imports)
+        {
+            WriteString(Import);
+        }
+    }
+
+    if (!FFileHelper::SaveArrayToFile(Data, *FileName))
+    {
+        SCRIPT_LOG_ERROR(FString::Printf(TEXT("Failed to write compile database: %s"), *FileName));
+        return false;
+    }
+    return true;
+}
+
+bool FScriptCompileDatabase::IsUpToDate(const FString& Name, const FString& Source) const
+{
+    const FEntry* Entry = Entries.Find(Name);
+    return Entry && Entry->Key == ComputeKey(Source, Entry->Imports);
+}
+
+void FScriptCompileDatabase::Record(const FString& Name, const FString& Source, const TArray<FString>& Imports)
+{
+    FEntry Entry;
+    Entry.Imports = Imports;
+    Entry.Imports.Sort();
+    Entry.Key = ComputeKey(Source, Entry.Imports);
+    Entries.Add(Name, MoveTemp(Entry));
+}
+
+uint64 FScriptCompileDatabase::ComputeKey(const FString& Source, const TArray<FString>& Imports) const
+{
+    uint64 Key = FNV_OFFSET_BASIS;
+    auto Mix = [&Key](uint64 Value)
+    {
+        Key = (Key ^ Value) * FNV_PRIME;
+    };
+
+    // A new compiler, or natives declared differently, may compile the same source differently
+    Mix(COMPILE_DATABASE_VERSION);
+    Mix(BYTECODE_FORMAT_VERSION);
+    Mix(FScriptNativeRegistry::Get().GetDeclarationHash());
+    Mix(REGISTER_CODE_VERSION);
+    Mix((bInliningEnabled ? 1 : 0) | (bOptimizationEnabled ? 2 : 0) | (bRegisterCodeEnabled ? 4 : 0));
+
+    Key = HashString(Key, Source);
+
+    // Paths as well as contents: the same header moved is a different import
+    Mix(Imports.Num());
+    for (const FString& Import : Imports)
+    {
+        Key = HashString(Key, Import);
+        Mix(HashFile(Import));
+    }
+    return Key;
+}
+
+uint64 FScriptCompileDatabase::HashFile(const FString& FileName) const
+{
+    if (const uint64* Found = FileHashes.Find(FileName))
+    {
+        return *Found;
+    }
+
+    // A missing import hashes to 0, so its importers compile (and report it)
+    FString Contents;
+    const uint64 Hash = FFileHelper::LoadFileToString(Contents, *FileName) ? HashString(FNV_OFFSET_BASIS, Contents) : 0;
+    FileHashes.Add(FileName, Hash);
+    return Hash;
+}
@@ -0,0 +1,81 @@
+// Copyright Vampire Game Project. All Rights Reserved.
+// Custom scripting system for secure modding support.
+
+#pragma once
+
+#include "Platform.h"
+
+/**
+ * Incremental Builds
+ * ==================
+ *
+ * What a compiled script (.scc) was built from, kept across builds in one file beside
+ * the compiled scripts (Scripts.sbdb). Each script has a key hashed from:
+ *
+ *   - its source
+ *   - the contents of every file it imported, directly or not
+ *   - the bytecode format version, the native declarations and the compiler options
+ *
+ * A build compiles a script only when the key it would get now differs from the
+ * recorded one. File times play no part: a checkout that rewrites a file unchanged
+ * compiles nothing, and editing a header compiles exactly the scripts that import it,
+ * however deep.
+ *
+ * The imports are those of the last compile. While the source is unchanged they still
+ * are; when it changes the key changes anyway.
+ *
+ * Import contents are hashed once per database object, so a build uses a fresh one (or
+ * calls RescanFiles) to see files that changed since.
+ */
+class SCRIPTING_API FScriptCompileDatabase
+{
+public:
+    FScriptCompileDatabase();
+
+    /** Read a database written by Save. False, and empty, when there is none or it is unreadable */
+    bool Load(const FString& FileName);
+    bool Save(const FString& FileName) const;
+
+    /** Database file name in a compiled scripts directory */
+    static FString GetDefaultFileName() { return TEXT("Scripts.sbdb"); }
+
+    /** True when Name was compiled from Source, against its imports as they are now, with these options */
+    bool IsUpToDate(const FString& Name, const FString& Source) const;
+
+    /**
+     * Remember a successful compile
+     * @param Imports Every file it imported, directly or not (FScriptCompiler::GetImportedSourceFiles)
+     */
+    void Record(const FString& Name, const FString& Source, const TArray<FString>& Imports);
+
+    /** Drop a script, so the next build compiles it (after it failed, say) */
+    void Forget(const FString& Name) { Entries.Remove(Name); }
+
+    /** Hash imported files again on their next use */
+    void RescanFiles() { FileHashes.Empty(); }
+
+    int32 Num() const { return Entries.Num(); }
+
+    // Compiler options of the build, part of every key
+    void SetInliningEnabled(bool bEnabled) { bInliningEnabled = bEnabled; }
+    void SetOptimizationEnabled(bool bEnabled) { bOptimizationEnabled = bEnabled; }
+    void SetRegisterCodeEnabled(bool bEnabled) { bRegisterCodeEnabled = bEnabled; }
+
+private:
+    struct FEntry
+    {
+        uint64 Key = 0;
+        TArray<FString> Imports;
+    };
+
+    uint64 ComputeKey(const FString& Source, const TArray<FString>& Imports) const;
+
+    /** Hash of a file's contents, 0 when it cannot be read */
+    uint64 HashFile(const FString& FileName) const;
+
+    TMap<FString, FEntry> Entries;
+    mutable TMap<FString, uint64> FileHashes;
+    bool bInliningEnabled;
+    bool bOptimizationEnabled;
+    bool bRegisterCodeEnabled;
+};
@@ -6,6 +6,11 @@
 #include "Platform.h"
 #include "ScriptAST.h"
 #include "ScriptBytecode.h"
+#include "ScriptProfile.h"
+
+struct FNativeFunctionDecl;
+struct FScriptModule;
+class FScriptModuleCache;
 
 /**
  * Compiles AST into bytecode
@@ -19,11 +24,68 @@ public:
     /** Compile a program AST into bytecode */
     TSharedPtr<FBytecodeChunk> Compile(TSharedPtr<FScriptProgram> Program);
     
+    /**
+     * Compile a header as a module object (see ScriptLinker.h): its functions only, with
+     * constant operands the linker can renumber. Top-level statements are ignored, as
+     * they are when a header is imported.
+     * @param ModulePath Import path of the header, e.g. "ScriptHeaders/Util.sbsh"
+     */
+    TSharedPtr<FScriptModule> CompileModule(TSharedPtr<FScriptProgram> Program, const FString& ModulePath);
+    
+    /**
+     * Compile imports as modules through Cache instead of into the chunk, nullptr = compile
+     * them in (the default). Calls into a module then go through external function
+     * entries, and the chunk has to be linked (FScriptLinker) before it can run.
+     */
+    void SetModuleCache(FScriptModuleCache* InCache) { ModuleCache = InCache; }
+    
     /** Get compilation errors */
     const TArray<FString>& GetErrors() const { return Errors; }
     bool HasErrors() const { return Errors.Num() > 0; }
+    
+    /** Every file the last compile imported, directly or not, as source file paths */
+    TArray<FString> GetImportedSourceFiles() const;
+    
+    /** Substitute small script functions at their call sites (on by default) */
+    void SetInliningEnabled(bool bEnabled) { bInliningEnabled = bEnabled; }
+    
+    /** Largest function body (in expression nodes) that is inlined */
+    static constexpr int32 MaxInlineNodes = 16;
+    
+    /** Inlined bodies are not inlined into further than this (bounds mutual recursion) */
+    static constexpr int32 MaxInlineDepth = 4;
+    
+    /** Compile function bodies through the SSA optimizer (off by default, see ScriptIR.h) */
+    void SetOptimizationEnabled(bool bEnabled) { bOptimizationEnabled = bEnabled; }
+    
+    /**
+     * Also emit register code for the functions the SSA path compiles (off by default)
+     * Implies the SSA path; the stack code is always emitted, see FScriptVM::SetBackend.
+     */
+    void SetRegisterCodeEnabled(bool bEnabled) { bRegisterCodeEnabled = bEnabled; }
+    
+    /** Look constants up through a hash index while compiling (on by default, off = linear scan) */
+    void SetConstantIndexEnabled(bool bEnabled) { bConstantIndexEnabled = bEnabled; }
+    
+    /**
+     * Optimize against a recorded profile (see ScriptProfile.h), nullptr = none
+     * Branch layout and the _NUMBER opcodes apply to directly compiled functions,
+     * the hot call site budget to the SSA path as well.
+     */
+    void SetProfile(TSharedPtr<const FScriptProfile> InProfile) { Profile = InProfile; }
+    
+    /** Largest function body inlined at a call site the profile shows hot */
+    static constexpr int32 MaxHotInlineNodes = 64;
+    
+    /** A call site is hot when it makes at least this many of every 1000 calls in the profile */
+    static constexpr uint64 HotCallPerMille = 10;
+    
+    /** An if/else is laid out for its then arm when that arm ran at least this percentage of the time */
+    static constexpr uint64 HotBranchPercent = 80;
 
 private:
+    friend class FScriptIRBuilder;
+    
     // Symbol table for variable tracking
     struct FLocal
     {
@@ -39,23 +101,105 @@ private:
         int32 Arity;      // Number of parameters
         int32 Address;    // Bytecode address
         EScriptType ReturnType;
+        FFunctionDecl* Decl;   // AST, kept alive by the program or ImportedPrograms
+        FString SourceFile;    // Header the function was imported from, empty for the main script
+        int32 InlineCost;      // Body size in nodes, -1 = never inline, 0 = not analysed yet
+        int32 RegisterAddress; // Offset in the chunk's RegisterCode, -1 = none
+        int32 NumRegisters;
+        FString Module;        // Defining module of an external function (see SetModuleCache), empty = this chunk
+        
+        FFunction()
+            : Arity(0), Address(-1), ReturnType(EScriptType::VOID), Decl(nullptr), InlineCost(0)
+            , RegisterAddress(-1), NumRegisters(0)
+        {}
+    };
+    
+    /** Parameter of an inlined function: a caller slot read in place, or the argument expression itself */
+    struct FInlineBinding
+    {
+        FString Name;
+        EScriptType Type;              // Declared parameter type, what InferType sees in the body
+        int32 Slot;                    // Caller local, or -1
+        FScriptExpression* Value;      // Compiled at each use in the caller's context, or nullptr
+    };
+    
+    /** One inlined body being compiled, and the context its call site was compiled in */
+    struct FInlineFrame
+    {
+        TArray<FInlineBinding> Bindings;
+        int32 CallerFloor;
+        FString CallerSourceFile;
     };
     
     struct FLoopContext
     {
-        int32 Start;              // Loop start address
-        TArray<int32> BreakJumps; // Addresses of break jumps to patch
+        int32 Start;                 // Loop start address
+        TArray<int32> BreakJumps;    // Addresses of break jumps to patch
+        int32 ContinueTarget;        // Backward target of 'continue', -1 = forward jump patched later
+        TArray<int32> ContinueJumps; // Addresses of forward continue jumps to patch
+        int32 LocalCount;            // Locals live when the body starts - break/continue pop the rest
+        bool bSwitch;                // A switch: takes 'break', 'continue' goes to the enclosing loop
+
+        FLoopContext() : Start(0), ContinueTarget(-1), LocalCount(0), bSwitch(false) {}
+    };
+    
+    /** An else arm compiled after the end of its function, off the hot path (see CompileIf) */
+    struct FColdBranch
+    {
+        FScriptStatement* Body;
+        int32 EntryJump;             // OP_JUMP_IF_FALSE to patch to the arm
+        int32 Resume;                // Address after the if, where the arm jumps back to
+        int32 Line;
+        TArray<FLocal> Locals;       // Locals in scope at the if
+        int32 ScopeDepth;
+    };
+    
+    /** A for-loop that can run on OP_FOR_PREP / OP_FOR_LOOP (see MatchCountedLoop) */
+    struct FCountedLoop
+    {
+        FScriptExpression* Limit;
+        double Step;
+        uint8 Flags;
     };
     
     TArray<FLocal> Locals;
     TArray<FFunction> Functions;
     TArray<FLoopContext> LoopStack;  // Track nested loops for break/continue
     TSet<FString> ImportedFiles;     // Track imported files to prevent circular imports
+    TArray<TSharedPtr<FScriptProgram>> ImportedPrograms; // Header ASTs, kept for inlining
+    
+    // Separate compilation: imported modules, and their functions until a call adds them to Functions
+    FScriptModuleCache* ModuleCache;
+    TArray<TSharedPtr<const FScriptModule>> ImportedModules;
+    TMap<FString, FFunction> ExternalFunctions;
+    TArray<FString> ModuleImports;   // Direct imports of the program, as module paths
+    bool bCompilingModule;           // CompileModule: no entry code, relocatable constant operands
+    FString ModulePath;
     int32 ScopeDepth;
     bool bLastExpressionWasVoidCall; // Track if last expression was a void function call
+    bool bInFunction;                // Compiling a function body (tail calls are allowed)
+    bool bInliningEnabled;
+    bool bOptimizationEnabled;
+    bool bRegisterCodeEnabled;
+    bool bConstantIndexEnabled;
+    
+    // Profile-guided layout: the recorded profile, and the else arms waiting for the end of the function
+    TSharedPtr<const FScriptProfile> Profile;
+    TArray<FColdBranch> ColdBranches;
+    
+    // Inlining state: an inlined body only sees its parameters, never the caller's locals
+    TArray<FInlineFrame> InlineFrames; // Innermost last
+    int32 LocalFloor;                // ResolveLocal ignores locals below this index
     
-    // Known native functions (to suppress warnings)
-    static const TSet<FString> NativeFunctions;
+    // Jump width: functions (by name, empty = top-level code) that need 32-bit jump offsets
+    TSet<FString> WideJumpUnits;
+    FString CurrentUnit;             // Function being compiled, empty for top-level code
+    bool bWideJumps;                 // CurrentUnit is in WideJumpUnits
+    bool bRecompileForWideJumps;     // A compact jump overflowed in this pass
+    
+    // Source position recorded in the chunk's LineTable for each emitted byte
+    int32 CurrentLine;
+    FString CurrentSourceFile;       // Empty for the main script
 
     TSharedPtr<FBytecodeChunk> Chunk;
     TArray<FString> Errors;
@@ -74,7 +218,10 @@ private:
     
     // Compilation methods
     void CompileProgram(FScriptProgram* Program);
+    void CompileModuleProgram(FScriptProgram* Program);
+    void EmitFunctionTable();
     void CompileFunction(FFunctionDecl* Function);
+    bool CompileOptimizedFunction(FFunctionDecl* Function, int32 FuncIndex);
     void CompileStatement(FScriptStatement* Statement);
     void CompileExpression(FScriptExpression* Expression);
     
@@ -85,10 +232,13 @@ private:
     void CompileIf(FIfStmt* Stmt);
     void CompileWhile(FWhileStmt* Stmt);
     void CompileFor(FForStmt* Stmt);
+    void CompileCountedFor(FForStmt* Stmt, const FCountedLoop& Loop);
+    void CompileForEach(FForEachStmt* Stmt);
     void CompileBreak(FBreakStmt* Stmt);
     void CompileContinue(FContinueStmt* Stmt);
     void CompileReturn(FReturnStmt* Stmt);
     void CompileImport(FImportStmt* Stmt);
+    void ImportModule(const FString& Path);
     
     // Expression compilation
     void CompileLiteral(FLiteralExpr* Expr);
@@ -96,13 +246,17 @@ private:
     void CompileUnary(FUnaryExpr* Expr);
     void CompileIdentifier(FIdentifierExpr* Expr);
     void CompileAssign(FAssignExpr* Expr);
-    void CompileCall(FCallExpr* Expr);
+    void CompileCall(FCallExpr* Expr, bool bTailCall = false);
+    bool TryInlineCall(FCallExpr* Expr, int32 FuncIndex);
+    void CompileInlineArgument(const FInlineBinding& Binding);
     void CompileArrayLiteral(FArrayLiteralExpr* Expr);
     void CompileArrayAccess(FArrayAccessExpr* Expr);
     void CompileArrayAssign(FArrayAssignExpr* Expr);
     void CompileStructAccess(FStructAccessExpr* Expr);
     void CompileStructAssign(FStructAssignExpr* Expr);
     void CompileSwitch(FSwitchStmt* Stmt);
+    bool EmitSwitchDispatch(FSwitchStmt* Stmt, TArray<int32>& OutCaseSlots, TArray<int32>& OutDefaultSlots, int32& OutNext);
+    static bool GetSwitchKey(const FScriptExpression* Expr, FScriptValue& OutKey);
     void CompileTypeCast(FTypeCastExpr* Expr);
     
     // Helper methods
@@ -110,12 +264,41 @@ private:
     void EmitBytes(uint8 Byte1, uint8 Byte2);
     void EmitReturn();
     void EmitConstant(const FScriptValue& Value);
+    void EmitConstantOp(EOpCode OpCode, int32 ConstIndex);  // _WIDE form past index 255
+    void EmitLocalOp(EOpCode OpCode, int32 Slot);           // _WIDE form past slot 255
+    void EmitNameIndex(int32 NameIndex);                    // 16-bit field / native name operand
     int32 EmitJump(EOpCode JumpOp);
     void PatchJump(int32 Offset);
+    int32 EmitJumpOffset();
     int32 EmitLoop(int32 LoopStart);
+    int32 EmitLoopOffset(int32 LoopStart);
+    void RequestWideJumps();
+    void EmitLoopExitPops(const FLoopContext& Loop);
+    
+    // Profile-guided optimization
+    bool IsColdElse(FIfStmt* Stmt, int32 Line) const;
+    void EmitColdBranches();
+    static bool HasLoopExit(const FScriptStatement* Statement);
+    bool IsNumberOnly(EOpCode OpCode) const;
+    void EmitOperator(EOpCode OpCode, bool bNegate = false);
+    
+    // Inlining
+    int32 GetInlineCost(int32 FuncIndex);
+    bool IsInlineCandidate(int32 FuncIndex, int32 Line);
+    static int32 CountInlineNodes(const FScriptExpression* Expr, const FString& SelfName);
+    static int32 CountUses(const FScriptExpression* Expr, const FString& Name);
+    bool IsInlinePure(const FScriptExpression* Expr);
+    const FInlineBinding* FindInlineBinding(const FString& Name) const;
+    static int32 GetSourceLine(const FScriptASTNode* Node);
+    
+    // Loop analysis
+    bool MatchCountedLoop(FForStmt* Stmt, FCountedLoop& OutLoop) const;
+    static bool IsLocalAssigned(const FScriptASTNode* Node, const FString& Name);
     
     // Type checking
     EScriptType InferType(FScriptExpression* Expr);
+    EScriptType ProveType(FScriptExpression* Expr);
+    bool CheckNativeArguments(const FString& FuncName, const FNativeFunctionDecl& Signature, FCallExpr* Expr);
     void EmitTypeConversion(EScriptType From, EScriptType To);
     bool TypesCompatible(EScriptType A, EScriptType B);
 };
@@ -0,0 +1,1302 @@
+// Copyright Vampire Game Project. All Rights Reserved.
+// Custom scripting system for secure modding support.
+
+#include "ScriptIR.h"
+#include "ScriptCompiler.h"
+#include "ScriptLogger.h"
+#include "ScriptNativeRegistry.h"
+
+//=============================================================================
+// IR Function
+//=============================================================================
+
+int32 FScriptIRFunction::Resolve(int32 V) const
+{
+    while (V >= 0 && V < Forward.Num() && Forward[V] >= 0)
+    {
+        V = Forward[V];
+    }
+    return V;
+}
+
+void FScriptIRFunction::Replace(int32 Old, int32 New)
+{
+    Forward[Old] = New;
+    Instrs[Old].bRemoved = true;
+}
+
+void FScriptIRFunction::ApplyReplacements()
+{
+    for (FScriptIRInstr& Instr : Instrs)
+    {
+        if (!Instr.bRemoved)
+        {
+            for (int32& Operand : Instr.Operands)
+            {
+                Operand = Resolve(Operand);
+            }
+        }
+    }
+    for (FScriptIRBlock& Block : Blocks)
+    {
+        Block.Value = Resolve(Block.Value);
+    }
+}
+
+FString FScriptIRFunction::Dump() const
+{
+    static const TCHAR* TerminatorNames[] = { TEXT("none"), TEXT("jump"), TEXT("branch"), TEXT("return"), TEXT("for_prep"), TEXT("for_loop"), TEXT("foreach") };
+
+    auto DumpInstr = [this](int32 Index)
+    {
+        const FScriptIRInstr& Instr = Instrs[Index];
+        FString Line = FString::Printf(TEXT("  %%%d = "), Index);
+        switch (Instr.Op)
+        {
+            case EScriptIROp::Param:     Line += FString::Printf(TEXT("param %d"), Instr.Imm); break;
+            case EScriptIROp::Phi:       Line += TEXT("phi"); break;
+            case EScriptIROp::LoadSlot:  Line += FString::Printf(TEXT("load_slot %d"), Instr.Imm); break;
+            case EScriptIROp::StoreSlot: Line += FString::Printf(TEXT("store_slot %d"), Instr.Imm); break;
+            default:                     Line += FString::Printf(TEXT("op %d [%d, %d]"), (int32)Instr.OpCode, Instr.Imm, Instr.Imm2); break;
+        }
+        for (int32 Operand : Instr.Operands)
+        {
+            Line += FString::Printf(TEXT(" %%%d"), Operand);
+        }
+        return Line + (Instr.bPure ? TEXT("\n") : TEXT("  (impure)\n"));
+    };
+
+    FString Result = FString::Printf(TEXT("function %s (%d params, %d pinned slots)\n"), *Name, Arity, NumPinnedSlots);
+    for (int32 BlockIndex : Layout)
+    {
+        const FScriptIRBlock& Block = Blocks[BlockIndex];
+        Result += FString::Printf(TEXT("b%d: (%d preds)\n"), BlockIndex, Block.Preds.Num());
+        for (int32 Phi : Block.Phis)
+        {
+            if (!Instrs[Phi].bRemoved)
+            {
+                Result += DumpInstr(Phi);
+            }
+        }
+        for (int32 Instr : Block.Instrs)
+        {
+            if (!Instrs[Instr].bRemoved)
+            {
+                Result += DumpInstr(Instr);
+            }
+        }
+        Result += FString::Printf(TEXT("  %s"), TerminatorNames[(int32)Block.Terminator]);
+        if (Block.Value >= 0)
+        {
+            Result += FString::Printf(TEXT(" %%%d"), Block.Value);
+        }
+        for (int32 Succ : Block.Succs)
+        {
+            Result += FString::Printf(TEXT(" b%d"), Succ);
+        }
+        Result += TEXT("\n");
+    }
+    return Result;
+}
+
+//=============================================================================
+// Builder
+//=============================================================================
+
+FScriptIRBuilder::FScriptIRBuilder(FScriptCompiler& InCompiler, FScriptIRFunction& InFunction)
+    : Compiler(InCompiler)
+    , F(InFunction)
+    , CurrentBlock(-1)
+    , PinnedDepth(0)
+    , InlineDepth(0)
+    , CurrentLine(0)
+    , CurrentFile(0)
+{
+}
+
+bool FScriptIRBuilder::Build(FScriptCompiler& Compiler, FFunctionDecl* Function, int32 FuncIndex, FScriptIRFunction& OutFunction, FString& OutReason)
+{
+    // The compiler's symbol table is borrowed for name resolution and type inference
+    const int32 SavedLocals = Compiler.Locals.Num();
+    const int32 SavedScopeDepth = Compiler.ScopeDepth;
+    const int32 SavedFloor = Compiler.LocalFloor;
+    const bool bWasInFunction = Compiler.bInFunction;
+
+    FScriptIRBuilder Builder(Compiler, OutFunction);
+    Builder.BuildFunction(Function, FuncIndex);
+
+    Compiler.Locals.SetNum(SavedLocals);
+    Compiler.ScopeDepth = SavedScopeDepth;
+    Compiler.LocalFloor = SavedFloor;
+    Compiler.bInFunction = bWasInFunction;
+
+    OutReason = Builder.FailReason;
+    return !Builder.Failed();
+}
+
+bool FScriptIRBuilder::Fail(const FString& Reason)
+{
+    if (FailReason.IsEmpty())
+    {
+        FailReason = Reason;
+    }
+    return false;
+}
+
+void FScriptIRBuilder::BuildFunction(FFunctionDecl* Function, int32 FuncIndex)
+{
+    const FScriptCompiler::FFunction& Info = Compiler.Functions[FuncIndex];
+    F.Name = Info.Name;
+    F.Arity = Info.Arity;
+    F.Files.Add(Compiler.CurrentSourceFile);
+    F.bWideConstants = Compiler.bCompilingModule;
+    CurrentLine = Function->Name.Line;
+    Compiler.bInFunction = true;
+
+    StartBlock(NewBlock());
+    SealBlock(CurrentBlock);
+
+    Compiler.ScopeDepth++;
+
+    TArray<TPair<FString, EScriptType>> Params;
+    if (Function->TypedParameters.Num() > 0)
+    {
+        for (const FParameter& Param : Function->TypedParameters)
+        {
+            Params.Add(TPair<FString, EScriptType>(Param.Name.Lexeme, Param.Type));
+        }
+    }
+    else
+    {
+        for (const FScriptToken& Param : Function->Parameters)
+        {
+            Params.Add(TPair<FString, EScriptType>(Param.Lexeme, EScriptType::AUTO));
+        }
+    }
+    if (Params.Num() != F.Arity)
+    {
+        Fail(TEXT("parameter count does not match the function table"));
+        return;
+    }
+
+    for (int32 i = 0; i < Params.Num(); ++i)
+    {
+        FScriptIRInstr Param;
+        Param.Op = EScriptIROp::Param;
+        Param.Imm = i;
+        Param.bPure = true;
+        const int32 Variable = NewVariable();
+        AddLocal(Params[i].Key, Params[i].Value, Variable);
+        WriteVariable(Variable, CurrentBlock, AddInstr(CurrentBlock, Param));
+    }
+
+    if (Function->Body.IsValid())
+    {
+        BuildStatement(Function->Body.Get());
+    }
+    if (Failed())
+    {
+        return;
+    }
+
+    if (CurrentBlock >= 0)
+    {
+        if (Info.ReturnType != EScriptType::VOID)
+        {
+            // The direct compiler lets such a function run off its end - keep that behaviour
+            TArray<bool> Reached;
+            Reached.Init(false, F.Blocks.Num());
+            TArray<int32> Work;
+            Work.Add(0);
+            Reached[0] = true;
+            while (Work.Num() > 0)
+            {
+                const int32 Block = Work.Pop();
+                for (int32 Succ : F.Blocks[Block].Succs)
+                {
+                    if (!Reached[Succ])
+                    {
+                        Reached[Succ] = true;
+                        Work.Add(Succ);
+                    }
+                }
+            }
+            if (Reached[CurrentBlock])
+            {
+                Fail(TEXT("a non-void function can reach its end"));
+                return;
+            }
+        }
+
+        const int32 Nil = Emit(EOpCode::OP_NIL, TArray<int32>());
+        FScriptIRBlock& Block = F.Blocks[CurrentBlock];
+        Block.Terminator = EScriptIRTerminator::Return;
+        Block.Value = Nil;
+        Block.Line = CurrentLine;
+        Block.File = CurrentFile;
+        CurrentBlock = -1;
+    }
+
+    F.ApplyReplacements();
+}
+
+//=============================================================================
+// Blocks and Instructions
+//=============================================================================
+
+int32 FScriptIRBuilder::NewBlock()
+{
+    F.Blocks.Add(FScriptIRBlock());
+    Defs.Add(TMap<int32, int32>());
+    IncompletePhis.Add(TMap<int32, int32>());
+    Sealed.Add(false);
+    return F.Blocks.Num() - 1;
+}
+
+void FScriptIRBuilder::StartBlock(int32 Block)
+{
+    CurrentBlock = Block;
+    F.Layout.Add(Block);
+}
+
+void FScriptIRBuilder::EnsureBlock()
+{
+    // Code after return/break/continue still has to be built (it may declare locals)
+    if (CurrentBlock < 0)
+    {
+        StartBlock(NewBlock());
+        SealBlock(CurrentBlock);
+    }
+}
+
+void FScriptIRBuilder::AddEdge(int32 From, int32 To)
+{
+    check(!Sealed[To]);
+    F.Blocks[From].Succs.Add(To);
+    F.Blocks[To].Preds.Add(From);
+}
+
+void FScriptIRBuilder::SealBlock(int32 Block)
+{
+    // Phis created while predecessors were missing get their operands now
+    const TMap<int32, int32> Pending = IncompletePhis[Block];
+    IncompletePhis[Block].Empty();
+    Sealed[Block] = true;
+    for (const auto& Phi : Pending)
+    {
+        AddPhiOperands(Phi.Key, Phi.Value);
+    }
+}
+
+void FScriptIRBuilder::Jump(int32 Target)
+{
+    if (CurrentBlock < 0)
+    {
+        return;
+    }
+    FScriptIRBlock& Block = F.Blocks[CurrentBlock];
+    Block.Terminator = EScriptIRTerminator::Jump;
+    Block.Line = CurrentLine;
+    Block.File = CurrentFile;
+    AddEdge(CurrentBlock, Target);
+    CurrentBlock = -1;
+}
+
+void FScriptIRBuilder::Branch(int32 Condition, int32 TrueBlock, int32 FalseBlock)
+{
+    FScriptIRBlock& Block = F.Blocks[CurrentBlock];
+    Block.Terminator = EScriptIRTerminator::Branch;
+    Block.Value = Condition;
+    Block.Line = CurrentLine;
+    Block.File = CurrentFile;
+    AddEdge(CurrentBlock, TrueBlock);
+    AddEdge(CurrentBlock, FalseBlock);
+    CurrentBlock = -1;
+}
+
+int32 FScriptIRBuilder::AddInstr(int32 Block, const FScriptIRInstr& Instr)
+{
+    const int32 Index = F.Instrs.Num();
+    F.Instrs.Add(Instr);
+    F.Forward.Add(-1);
+
+    FScriptIRInstr& Added = F.Instrs[Index];
+    Added.Block = Block;
+    Added.Line = CurrentLine;
+    Added.File = CurrentFile;
+    if (Added.Op == EScriptIROp::Phi)
+    {
+        F.Blocks[Block].Phis.Add(Index);
+    }
+    else
+    {
+        F.Blocks[Block].Instrs.Add(Index);
+    }
+    return Index;
+}
+
+int32 FScriptIRBuilder::Emit(EOpCode OpCode, const TArray<int32>& Operands, int32 Imm, int32 Imm2, bool bPure)
+{
+    EnsureBlock();
+    FScriptIRInstr Instr;
+    Instr.OpCode = OpCode;
+    Instr.Operands = Operands;
+    Instr.Imm = Imm;
+    Instr.Imm2 = Imm2;
+    Instr.bPure = bPure;
+    return AddInstr(CurrentBlock, Instr);
+}
+
+int32 FScriptIRBuilder::EmitConstant(const FScriptValue& Value)
+{
+    return Emit(EOpCode::OP_CONSTANT, TArray<int32>(), Compiler.Chunk->AddConstant(Value));
+}
+
+int32 FScriptIRBuilder::EmitConversion(int32 Value, EScriptType From, EScriptType To)
+{
+    // Same conversions as FScriptCompiler::EmitTypeConversion
+    if (From == To || To == EScriptType::AUTO)
+    {
+        return Value;
+    }
+    
+    // A numeric literal is converted here rather than at every run ('int x = 0')
+    const FScriptIRInstr& Instr = F.Instrs[Value];
+    const bool bNumberLiteral = Instr.Op == EScriptIROp::Bytecode && Instr.OpCode == EOpCode::OP_CONSTANT &&
+        Compiler.Chunk->Constants[Instr.Imm].IsNumber();
+    
+    if (From == EScriptType::FLOAT && To == EScriptType::INT)
+    {
+        if (bNumberLiteral)
+        {
+            const double Number = Compiler.Chunk->Constants[Instr.Imm].AsNumber();
+            if (Number > -2147483648.0 && Number < 2147483648.0)
+            {
+                return EmitConstant(FScriptValue::Number(static_cast<int32>(Number)));
+            }
+        }
+        return Emit(EOpCode::OP_CAST_INT, { Value });
+    }
+    if (From == EScriptType::INT && To == EScriptType::FLOAT)
+    {
+        return bNumberLiteral ? Value : Emit(EOpCode::OP_CAST_FLOAT, { Value });
+    }
+    if (To == EScriptType::STRING)
+    {
+        return Emit(EOpCode::OP_CAST_STRING, { Value });
+    }
+    return Value;
+}
+
+//=============================================================================
+// SSA Construction
+//=============================================================================
+
+int32 FScriptIRBuilder::NewVariable(int32 PinnedSlot)
+{
+    FVariable Variable;
+    Variable.PinnedSlot = PinnedSlot;
+    Variables.Add(Variable);
+    return Variables.Num() - 1;
+}
+
+int32 FScriptIRBuilder::AddLocal(const FString& Name, EScriptType Type, int32 Variable)
+{
+    const int32 LocalIndex = Compiler.AddLocal(Name, Type);
+    if (LocalIndex < 0)
+    {
+        Fail(FString::Printf(TEXT("'%s' is declared twice"), *Name));
+        return -1;
+    }
+    Compiler.Locals[LocalIndex].bInitialized = true;
+
+    while (LocalVariables.Num() < Compiler.Locals.Num())
+    {
+        LocalVariables.Add(-1);
+    }
+    LocalVariables[LocalIndex] = Variable;
+    return LocalIndex;
+}
+
+void FScriptIRBuilder::PopLocals(int32 Depth)
+{
+    while (Compiler.Locals.Num() > 0 && Compiler.Locals.Last().Depth > Depth)
+    {
+        Compiler.Locals.Pop();
+    }
+    if (LocalVariables.Num() > Compiler.Locals.Num())
+    {
+        LocalVariables.SetNum(Compiler.Locals.Num());
+    }
+}
+
+void FScriptIRBuilder::WriteVariable(int32 Variable, int32 Block, int32 Value)
+{
+    Defs[Block].Add(Variable, Value);
+}
+
+int32 FScriptIRBuilder::ReadVariable(int32 Variable, int32 Block)
+{
+    if (const int32* Value = Defs[Block].Find(Variable))
+    {
+        return F.Resolve(*Value);
+    }
+    return ReadVariableRecursive(Variable, Block);
+}
+
+int32 FScriptIRBuilder::ReadVariableRecursive(int32 Variable, int32 Block)
+{
+    int32 Value;
+    const TArray<int32>& Preds = F.Blocks[Block].Preds;
+    if (!Sealed[Block])
+    {
+        Value = NewPhi(Block, Variable);
+        IncompletePhis[Block].Add(Variable, Value);
+    }
+    else if (Preds.Num() == 0)
+    {
+        Value = Undefined(Block);
+    }
+    else if (Preds.Num() == 1)
+    {
+        Value = ReadVariable(Variable, Preds[0]);
+    }
+    else
+    {
+        // Written first, so a loop reaching back here finds the phi instead of recursing
+        Value = NewPhi(Block, Variable);
+        WriteVariable(Variable, Block, Value);
+        Value = AddPhiOperands(Variable, Value);
+    }
+    WriteVariable(Variable, Block, Value);
+    return Value;
+}
+
+int32 FScriptIRBuilder::NewPhi(int32 Block, int32 Variable)
+{
+    FScriptIRInstr Phi;
+    Phi.Op = EScriptIROp::Phi;
+    Phi.Imm = Variable;
+    Phi.bPure = true;
+    return AddInstr(Block, Phi);
+}
+
+int32 FScriptIRBuilder::AddPhiOperands(int32 Variable, int32 Phi)
+{
+    const int32 Block = F.Instrs[Phi].Block;
+    for (int32 i = 0; i < F.Blocks[Block].Preds.Num(); ++i)
+    {
+        const int32 Operand = ReadVariable(Variable, F.Blocks[Block].Preds[i]);
+        F.Instrs[Phi].Operands.Add(Operand);
+    }
+    return TryRemoveTrivialPhi(Phi);
+}
+
+int32 FScriptIRBuilder::TryRemoveTrivialPhi(int32 Phi)
+{
+    // A phi of one value (and itself) is a copy. Phis that only become trivial
+    // later are left to FScriptIROptimizer::RemoveTrivialPhis.
+    int32 Same = -1;
+    for (int32 Operand : F.Instrs[Phi].Operands)
+    {
+        Operand = F.Resolve(Operand);
+        if (Operand == Same || Operand == Phi)
+        {
+            continue;
+        }
+        if (Same >= 0)
+        {
+            return Phi;
+        }
+        Same = Operand;
+    }
+    if (Same < 0)
+    {
+        Same = Undefined(F.Instrs[Phi].Block);
+    }
+    F.Replace(Phi, Same);
+    return Same;
+}
+
+int32 FScriptIRBuilder::Undefined(int32 Block)
+{
+    // Only reachable from unreachable code: every local is initialized when declared
+    FScriptIRInstr Nil;
+    Nil.OpCode = EOpCode::OP_NIL;
+    Nil.bPure = true;
+    return AddInstr(Block, Nil);
+}
+
+int32 FScriptIRBuilder::ReadLocal(int32 LocalIndex)
+{
+    const int32 Variable = LocalVariables.IsValidIndex(LocalIndex) ? LocalVariables[LocalIndex] : -1;
+    if (Variable < 0)
+    {
+        Fail(TEXT("local declared outside the function"));
+        return Emit(EOpCode::OP_NIL, TArray<int32>());
+    }
+
+    if (Variables[Variable].PinnedSlot >= 0)
+    {
+        EnsureBlock();
+        FScriptIRInstr Load;
+        Load.Op = EScriptIROp::LoadSlot;
+        Load.Imm = Variables[Variable].PinnedSlot;
+        Load.bPure = true;
+        return AddInstr(CurrentBlock, Load);
+    }
+
+    EnsureBlock();
+    return ReadVariable(Variable, CurrentBlock);
+}
+
+void FScriptIRBuilder::WriteLocal(int32 LocalIndex, int32 Value)
+{
+    const int32 Variable = LocalVariables.IsValidIndex(LocalIndex) ? LocalVariables[LocalIndex] : -1;
+    if (Variable < 0 || Variables[Variable].PinnedSlot >= 0)
+    {
+        Fail(TEXT("assignment to a loop-managed local"));
+        return;
+    }
+    EnsureBlock();
+    WriteVariable(Variable, CurrentBlock, Value);
+}
+
+//=============================================================================
+// Statements
+//=============================================================================
+
+void FScriptIRBuilder::BuildStatement(FScriptStatement* Statement)
+{
+    if (Failed())
+    {
+        return;
+    }
+    if (!Statement || !Statement->IsValid())
+    {
+        Fail(TEXT("invalid statement"));
+        return;
+    }
+
+    if (const int32 Line = FScriptCompiler::GetSourceLine(Statement))
+    {
+        CurrentLine = Line;
+    }
+    EnsureBlock();
+
+    const EScriptNodeKind Kind = Statement->GetKind();
+
+    switch (Kind)
+    {
+        case EScriptNodeKind::ExprStmt:
+            BuildExpression(static_cast<FExprStmt*>(Statement)->Expression.Get());
+            break;
+        case EScriptNodeKind::VarDecl:
+            BuildVarDecl(static_cast<FVarDeclStmt*>(Statement));
+            break;
+        case EScriptNodeKind::Block:
+            BuildBlock(static_cast<FBlockStmt*>(Statement));
+            break;
+        case EScriptNodeKind::If:
+            BuildIf(static_cast<FIfStmt*>(Statement));
+            break;
+        case EScriptNodeKind::While:
+        {
+            FWhileStmt* Stmt = static_cast<FWhileStmt*>(Statement);
+            BuildWhile(Stmt->Condition.Get(), Stmt->Body.Get(), nullptr);
+            break;
+        }
+        case EScriptNodeKind::For:
+            BuildFor(static_cast<FForStmt*>(Statement));
+            break;
+        case EScriptNodeKind::ForEach:
+            BuildForEach(static_cast<FForEachStmt*>(Statement));
+            break;
+        case EScriptNodeKind::Break:
+        case EScriptNodeKind::Continue:
+            if (Loops.Num() == 0)
+            {
+                Fail(FString::Printf(TEXT("'%s' outside a loop"), FScriptASTNode::GetKindName(Kind)));
+                return;
+            }
+            Jump(Kind == EScriptNodeKind::Break ? Loops.Last().BreakBlock : Loops.Last().ContinueBlock);
+            break;
+        case EScriptNodeKind::Return:
+            BuildReturn(static_cast<FReturnStmt*>(Statement));
+            break;
+        default:
+            Fail(FString::Printf(TEXT("%s statements are not modelled"), FScriptASTNode::GetKindName(Kind)));
+            break;
+    }
+}
+
+void FScriptIRBuilder::BuildBlock(FBlockStmt* Stmt)
+{
+    Compiler.ScopeDepth++;
+    for (const auto& Statement : Stmt->Statements)
+    {
+        if (Statement.IsValid())
+        {
+            BuildStatement(Statement.Get());
+        }
+    }
+    Compiler.ScopeDepth--;
+    PopLocals(Compiler.ScopeDepth);
+}
+
+void FScriptIRBuilder::BuildVarDecl(FVarDeclStmt* Stmt)
+{
+    int32 Value;
+    if (Stmt->Initializer.IsValid())
+    {
+        Value = BuildExpression(Stmt->Initializer.Get());
+
+        EScriptType ExprType = Compiler.InferType(Stmt->Initializer.Get());
+        if (Stmt->VarType != EScriptType::AUTO && ExprType != Stmt->VarType)
+        {
+            Value = EmitConversion(Value, ExprType, Stmt->VarType);
+        }
+    }
+    else
+    {
+        Value = Emit(EOpCode::OP_NIL, TArray<int32>());
+    }
+
+    const int32 Variable = NewVariable();
+    if (AddLocal(Stmt->Name.Lexeme, Stmt->VarType, Variable) >= 0)
+    {
+        EnsureBlock();
+        WriteVariable(Variable, CurrentBlock, Value);
+    }
+}
+
+void FScriptIRBuilder::BuildIf(FIfStmt* Stmt)
+{
+    const int32 Condition = BuildExpression(Stmt->Condition.Get());
+
+    // The else block always exists: it pops the condition on the false path
+    const int32 Then = NewBlock();
+    const int32 Else = NewBlock();
+    const int32 Join = NewBlock();
+    EnsureBlock();
+    Branch(Condition, Then, Else);
+    SealBlock(Then);
+    SealBlock(Else);
+
+    StartBlock(Then);
+    BuildStatement(Stmt->ThenBranch.Get());
+    Jump(Join);
+
+    StartBlock(Else);
+    if (Stmt->ElseBranch.IsValid())
+    {
+        BuildStatement(Stmt->ElseBranch.Get());
+    }
+    Jump(Join);
+
+    SealBlock(Join);
+    StartBlock(Join);
+}
+
+void FScriptIRBuilder::BuildWhile(FScriptExpression* Condition, FScriptStatement* Body, FScriptExpression* Increment)
+{
+    // Rotated, so each iteration runs one conditional branch and the body has a preheader:
+    //
+    //     if (!cond) goto Done
+    // Pre:                          <- loop-invariant code is hoisted here
+    //     goto Header
+    // Header:
+    //     body
+    // Latch:                        <- 'continue' jumps here
+    //     increment
+    //     if (cond) goto Header
+    // Done:
+    //     goto Exit
+    // Exit:                         <- 'break' jumps here
+    const int32 Pre = NewBlock();
+    const int32 Header = NewBlock();
+    const int32 Latch = NewBlock();
+    const int32 Done = NewBlock();
+    const int32 Exit = NewBlock();
+
+    if (Condition)
+    {
+        const int32 Test = BuildExpression(Condition);
+        EnsureBlock();
+        Branch(Test, Pre, Done);
+    }
+    else
+    {
+        Jump(Pre);
+    }
+    SealBlock(Pre);
+
+    StartBlock(Pre);
+    Jump(Header);
+
+    StartBlock(Header);
+    Loops.Add({ Exit, Latch });
+    BuildStatement(Body);
+    Jump(Latch);
+    Loops.Pop();
+
+    SealBlock(Latch);
+    StartBlock(Latch);
+    if (Increment)
+    {
+        BuildExpression(Increment);
+    }
+    if (Condition)
+    {
+        const int32 Test = BuildExpression(Condition);
+        EnsureBlock();
+        Branch(Test, Header, Done);
+    }
+    else
+    {
+        Jump(Header);
+    }
+    SealBlock(Header);
+    SealBlock(Done);
+
+    StartBlock(Done);
+    Jump(Exit);
+
+    SealBlock(Exit);
+    StartBlock(Exit);
+}
+
+void FScriptIRBuilder::BuildFor(FForStmt* Stmt)
+{
+    Compiler.ScopeDepth++;
+
+    FScriptCompiler::FCountedLoop Loop;
+    if (!Compiler.MatchCountedLoop(Stmt, Loop))
+    {
+        if (Stmt->Initializer.IsValid())
+        {
+            BuildStatement(Stmt->Initializer.Get());
+        }
+        BuildWhile(Stmt->Condition.Get(), Stmt->Body.Get(), Stmt->Increment.Get());
+    }
+    else
+    {
+        // The counter, limit and step live in pinned slots that OP_FOR_PREP / OP_FOR_LOOP update:
+        //
+        //     OP_FOR_PREP -> Skip
+        // Pre:
+        //     goto Header
+        // Header:
+        //     body
+        // Latch:                        <- 'continue' jumps here
+        //     OP_FOR_LOOP -> Header
+        //     goto Exit
+        // Skip:
+        //     goto Exit
+        // Exit:                         <- 'break' jumps here
+        FVarDeclStmt* Init = static_cast<FVarDeclStmt*>(Stmt->Initializer.Get());
+        CurrentLine = Init->Name.Line;
+        int32 Start = BuildExpression(Init->Initializer.Get());
+        Start = EmitConversion(Start, Compiler.InferType(Init->Initializer.Get()), Init->VarType);
+
+        const int32 Slot = PinnedDepth * 3;
+        PinnedDepth++;
+        F.NumPinnedSlots = FMath::Max(F.NumPinnedSlots, PinnedDepth * 3);
+
+        auto Store = [this](int32 PinnedSlot, int32 Value)
+        {
+            FScriptIRInstr StoreSlot;
+            StoreSlot.Op = EScriptIROp::StoreSlot;
+            StoreSlot.Imm = PinnedSlot;
+            StoreSlot.Operands.Add(Value);
+            EnsureBlock();
+            AddInstr(CurrentBlock, StoreSlot);
+        };
+
+        Store(Slot, Start);
+        AddLocal(Init->Name.Lexeme, Init->VarType, NewVariable(Slot));
+        Store(Slot + 1, BuildExpression(Loop.Limit));
+        Store(Slot + 2, EmitConstant(FScriptValue::Number(Loop.Step)));
+
+        const int32 Pre = NewBlock();
+        const int32 Skip = NewBlock();
+        const int32 Header = NewBlock();
+        const int32 Latch = NewBlock();
+        const int32 Done = NewBlock();
+        const int32 Exit = NewBlock();
+
+        EnsureBlock();
+        FScriptIRBlock& Prep = F.Blocks[CurrentBlock];
+        Prep.Terminator = EScriptIRTerminator::ForPrep;
+        Prep.Slot = Slot;
+        Prep.Flags = Loop.Flags;
+        Prep.Line = CurrentLine;
+        Prep.File = CurrentFile;
+        AddEdge(CurrentBlock, Pre);
+        AddEdge(CurrentBlock, Skip);
+        SealBlock(Pre);
+        SealBlock(Skip);
+
+        StartBlock(Pre);
+        Jump(Header);
+
+        StartBlock(Header);
+        Loops.Add({ Exit, Latch });
+        if (Stmt->Body.IsValid())
+        {
+            BuildStatement(Stmt->Body.Get());
+        }
+        Jump(Latch);
+        Loops.Pop();
+
+        SealBlock(Latch);
+        StartBlock(Latch);
+        FScriptIRBlock& Step = F.Blocks[Latch];
+        Step.Terminator = EScriptIRTerminator::ForLoop;
+        Step.Slot = Slot;
+        Step.Flags = Loop.Flags;
+        Step.Line = CurrentLine;
+        Step.File = CurrentFile;
+        AddEdge(Latch, Header);
+        AddEdge(Latch, Done);
+        SealBlock(Header);
+        SealBlock(Done);
+
+        StartBlock(Done);
+        Jump(Exit);
+        StartBlock(Skip);
+        Jump(Exit);
+
+        SealBlock(Exit);
+        StartBlock(Exit);
+        PinnedDepth--;
+    }
+
+    Compiler.ScopeDepth--;
+    PopLocals(Compiler.ScopeDepth);
+}
+
+void FScriptIRBuilder::BuildForEach(FForEachStmt* Stmt)
+{
+    // The array, index and element live in pinned slots that OP_FOREACH updates:
+    //
+    //     goto Header
+    // Header:                       <- 'continue' jumps here
+    //     OP_FOREACH -> Done
+    //     body
+    //     goto Header
+    // Done:
+    //     goto Exit
+    // Exit:                         <- 'break' jumps here
+    if (FScriptCompiler::IsLocalAssigned(Stmt->Body.Get(), Stmt->Name.Lexeme))
+    {
+        Fail(TEXT("the for-each variable is assigned in the body"));
+        return;
+    }
+
+    Compiler.ScopeDepth++;
+
+    const int32 Array = BuildExpression(Stmt->Iterable.Get());
+
+    const int32 Slot = PinnedDepth * 3;
+    PinnedDepth++;
+    F.NumPinnedSlots = FMath::Max(F.NumPinnedSlots, PinnedDepth * 3);
+
+    auto Store = [this](int32 PinnedSlot, int32 Value)
+    {
+        FScriptIRInstr StoreSlot;
+        StoreSlot.Op = EScriptIROp::StoreSlot;
+        StoreSlot.Imm = PinnedSlot;
+        StoreSlot.Operands.Add(Value);
+        EnsureBlock();
+        AddInstr(CurrentBlock, StoreSlot);
+    };
+
+    Store(Slot, Array);
+    Store(Slot + 1, EmitConstant(FScriptValue::Number(-1.0)));
+    Store(Slot + 2, Emit(EOpCode::OP_NIL, TArray<int32>()));
+    AddLocal(Stmt->Name.Lexeme, Stmt->VarType, NewVariable(Slot + 2));
+
+    const int32 Header = NewBlock();
+    const int32 Body = NewBlock();
+    const int32 Done = NewBlock();
+    const int32 Exit = NewBlock();
+
+    Jump(Header);
+    StartBlock(Header);
+    FScriptIRBlock& Next = F.Blocks[Header];
+    Next.Terminator = EScriptIRTerminator::ForEach;
+    Next.Slot = Slot;
+    Next.Line = CurrentLine;
+    Next.File = CurrentFile;
+    AddEdge(Header, Body);
+    AddEdge(Header, Done);
+    SealBlock(Body);
+    SealBlock(Done);
+
+    StartBlock(Body);
+    Loops.Add({ Exit, Header });
+    if (Stmt->Body.IsValid())
+    {
+        BuildStatement(Stmt->Body.Get());
+    }
+    Jump(Header);
+    Loops.Pop();
+    SealBlock(Header);
+
+    StartBlock(Done);
+    Jump(Exit);
+    SealBlock(Exit);
+    StartBlock(Exit);
+
+    PinnedDepth--;
+    Compiler.ScopeDepth--;
+    PopLocals(Compiler.ScopeDepth);
+}
+
+void FScriptIRBuilder::BuildReturn(FReturnStmt* Stmt)
+{
+    // 'return f(...)' becomes a tail call when lowered, as in the direct compiler
+    const int32 Value = Stmt->Value.IsValid() ? BuildExpression(Stmt->Value.Get()) : Emit(EOpCode::OP_NIL, TArray<int32>());
+
+    EnsureBlock();
+    FScriptIRBlock& Block = F.Blocks[CurrentBlock];
+    Block.Terminator = EScriptIRTerminator::Return;
+    Block.Value = Value;
+    Block.Line = CurrentLine;
+    Block.File = CurrentFile;
+    CurrentBlock = -1;
+}
+
+//=============================================================================
+// Expressions
+//=============================================================================
+
+int32 FScriptIRBuilder::BuildExpression(FScriptExpression* Expression)
+{
+    if (Failed())
+    {
+        return Emit(EOpCode::OP_NIL, TArray<int32>());
+    }
+    if (!Expression || !Expression->IsValid())
+    {
+        Fail(TEXT("invalid expression"));
+        return Emit(EOpCode::OP_NIL, TArray<int32>());
+    }
+
+    if (const int32 Line = FScriptCompiler::GetSourceLine(Expression))
+    {
+        CurrentLine = Line;
+    }
+
+    const EScriptNodeKind Kind = Expression->GetKind();
+
+    switch (Kind)
+    {
+        case EScriptNodeKind::Literal:
+            return BuildLiteral(static_cast<FLiteralExpr*>(Expression));
+        case EScriptNodeKind::Binary:
+            return BuildBinary(static_cast<FBinaryExpr*>(Expression));
+        case EScriptNodeKind::Unary:
+            return BuildUnary(static_cast<FUnaryExpr*>(Expression));
+        case EScriptNodeKind::Identifier:
+            return BuildIdentifier(static_cast<FIdentifierExpr*>(Expression));
+        case EScriptNodeKind::Assign:
+            return BuildAssign(static_cast<FAssignExpr*>(Expression));
+        case EScriptNodeKind::Call:
+            return BuildCall(static_cast<FCallExpr*>(Expression));
+        case EScriptNodeKind::ArrayLiteral:
+        {
+            FArrayLiteralExpr* Expr = static_cast<FArrayLiteralExpr*>(Expression);
+            if (Expr->Elements.Num() > 255)
+            {
+                Fail(TEXT("array literal too long"));
+            }
+            TArray<int32> Elements;
+            for (const auto& Element : Expr->Elements)
+            {
+                if (Element.IsValid())
+                {
+                    Elements.Add(BuildExpression(Element.Get()));
+                }
+            }
+            return Emit(EOpCode::OP_CREATE_ARRAY, Elements, Expr->Elements.Num());
+        }
+        case EScriptNodeKind::ArrayAccess:
+        {
+            FArrayAccessExpr* Expr = static_cast<FArrayAccessExpr*>(Expression);
+            const int32 Array = BuildExpression(Expr->Array.Get());
+            const int32 Index = BuildExpression(Expr->Index.Get());
+            return Emit(EOpCode::OP_GET_ELEMENT, { Array, Index });
+        }
+        case EScriptNodeKind::ArrayAssign:
+        {
+            // Arrays are values: OP_SET_ELEMENT produces a new array and has no side effect
+            FArrayAssignExpr* Expr = static_cast<FArrayAssignExpr*>(Expression);
+            const int32 Array = BuildExpression(Expr->Array.Get());
+            const int32 Index = BuildExpression(Expr->Index.Get());
+            const int32 Value = BuildExpression(Expr->Value.Get());
+            return Emit(EOpCode::OP_SET_ELEMENT, { Array, Index, Value });
+        }
+        case EScriptNodeKind::StructAccess:
+        {
+            // Ordered like a side effect: anything but an array's length logs a warning
+            FStructAccessExpr* Expr = static_cast<FStructAccessExpr*>(Expression);
+            const int32 Object = BuildExpression(Expr->Object.Get());
+            const int32 Name = Compiler.Chunk->AddConstant(FScriptValue::String(Expr->Field.Lexeme));
+            return Emit(EOpCode::OP_GET_FIELD, { Object }, Name, 0, false);
+        }
+        case EScriptNodeKind::StructAssign:
+        {
+            FStructAssignExpr* Expr = static_cast<FStructAssignExpr*>(Expression);
+            const int32 Object = BuildExpression(Expr->Object.Get());
+            const int32 Name = Compiler.Chunk->AddConstant(FScriptValue::String(Expr->Field.Lexeme));
+            const int32 Value = BuildExpression(Expr->Value.Get());
+            return Emit(EOpCode::OP_SET_FIELD, { Object, Value }, Name, 0, false);
+        }
+        case EScriptNodeKind::TypeCast:
+        {
+            FTypeCastExpr* Expr = static_cast<FTypeCastExpr*>(Expression);
+            const int32 Value = BuildExpression(Expr->Expression.Get());
+            return EmitConversion(Value, Compiler.InferType(Expr->Expression.Get()), Expr->TargetType);
+        }
+        default:
+            break;
+    }
+
+    Fail(FString::Printf(TEXT("%s expressions are not modelled"), FScriptASTNode::GetKindName(Kind)));
+    return Emit(EOpCode::OP_NIL, TArray<int32>());
+}
+
+int32 FScriptIRBuilder::BuildLiteral(FLiteralExpr* Expr)
+{
+    switch (Expr->Token.Type)
+    {
+        case ETokenType::NUMBER:   return EmitConstant(FScriptValue::Number(FCString::Atod(*Expr->Token.Lexeme)));
+        case ETokenType::STRING:   return EmitConstant(FScriptValue::String(Expr->Token.Lexeme));
+        case ETokenType::KW_TRUE:  return EmitConstant(FScriptValue::Bool(true));
+        case ETokenType::KW_FALSE: return EmitConstant(FScriptValue::Bool(false));
+        case ETokenType::NIL:      return Emit(EOpCode::OP_NIL, TArray<int32>());
+        default:
+            Fail(TEXT("unknown literal"));
+            return Emit(EOpCode::OP_NIL, TArray<int32>());
+    }
+}
+
+int32 FScriptIRBuilder::BuildBinary(FBinaryExpr* Expr)
+{
+    const int32 Left = BuildExpression(Expr->Left.Get());
+    const int32 Right = BuildExpression(Expr->Right.Get());
+    const TArray<int32> Operands = { Left, Right };
+
+    switch (Expr->Operator.Type)
+    {
+        case ETokenType::PLUS:          return Emit(EOpCode::OP_ADD, Operands);
+        case ETokenType::MINUS:         return Emit(EOpCode::OP_SUBTRACT, Operands);
+        case ETokenType::STAR:          return Emit(EOpCode::OP_MULTIPLY, Operands);
+        case ETokenType::SLASH:         return Emit(EOpCode::OP_DIVIDE, Operands);
+        case ETokenType::PERCENT:       return Emit(EOpCode::OP_MODULO, Operands);
+
+        case ETokenType::EQUAL_EQUAL:   return Emit(EOpCode::OP_EQUAL, Operands);
+        case ETokenType::BANG_EQUAL:    return Emit(EOpCode::OP_NOT, { Emit(EOpCode::OP_EQUAL, Operands) });
+        case ETokenType::GREATER:       return Emit(EOpCode::OP_GREATER, Operands);
+        case ETokenType::GREATER_EQUAL: return Emit(EOpCode::OP_NOT, { Emit(EOpCode::OP_LESS, Operands) });
+        case ETokenType::LESS:          return Emit(EOpCode::OP_LESS, Operands);
+        case ETokenType::LESS_EQUAL:    return Emit(EOpCode::OP_NOT, { Emit(EOpCode::OP_GREATER, Operands) });
+
+        case ETokenType::AND:
+        case ETokenType::AMPERSAND_AMPERSAND: return Emit(EOpCode::OP_AND, Operands);
+        case ETokenType::OR:
+        case ETokenType::PIPE_PIPE:     return Emit(EOpCode::OP_OR, Operands);
+
+        case ETokenType::AMPERSAND:     return Emit(EOpCode::OP_BIT_AND, Operands);
+        case ETokenType::PIPE:          return Emit(EOpCode::OP_BIT_OR, Operands);
+        case ETokenType::CARET:         return Emit(EOpCode::OP_BIT_XOR, Operands);
+
+        default:
+            Fail(TEXT("unknown binary operator"));
+            return Left;
+    }
+}
+
+int32 FScriptIRBuilder::BuildUnary(FUnaryExpr* Expr)
+{
+    const int32 Right = BuildExpression(Expr->Right.Get());
+
+    switch (Expr->Operator.Type)
+    {
+        case ETokenType::MINUS: return Emit(EOpCode::OP_NEGATE, { Right });
+        case ETokenType::BANG:  return Emit(EOpCode::OP_NOT, { Right });
+        case ETokenType::TILDE: return Emit(EOpCode::OP_BIT_NOT, { Right });
+        default:
+            Fail(TEXT("unknown unary operator"));
+            return Right;
+    }
+}
+
+int32 FScriptIRBuilder::BuildIdentifier(FIdentifierExpr* Expr)
+{
+    const FString& Name = Expr->Name.Lexeme;
+    const int32 LocalIndex = Compiler.ResolveLocal(Name);
+    if (LocalIndex >= 0)
+    {
+        return ReadLocal(LocalIndex);
+    }
+
+    // Globals can change behind any call, so reads are ordered like side effects
+    const int32 NameConstant = Compiler.Chunk->AddConstant(FScriptValue::String(Name));
+    return Emit(EOpCode::OP_GET_GLOBAL, TArray<int32>(), NameConstant, 0, false);
+}
+
+int32 FScriptIRBuilder::StoreVariable(const FString& Name, int32 Value)
+{
+    const int32 LocalIndex = Compiler.ResolveLocal(Name);
+    if (LocalIndex >= 0)
+    {
+        WriteLocal(LocalIndex, Value);
+        return Value;
+    }
+
+    const int32 NameConstant = Compiler.Chunk->AddConstant(FScriptValue::String(Name));
+    return Emit(EOpCode::OP_SET_GLOBAL, { Value }, NameConstant, 0, false);
+}
+
+int32 FScriptIRBuilder::BuildAssign(FAssignExpr* Expr)
+{
+    const EScriptNodeKind TargetKind = Expr->Target->GetKind();
+
+    if (TargetKind == EScriptNodeKind::Identifier)
+    {
+        const int32 Value = BuildExpression(Expr->Value.Get());
+        return StoreVariable(static_cast<FIdentifierExpr*>(Expr->Target.Get())->Name.Lexeme, Value);
+    }
+
+    if (TargetKind == EScriptNodeKind::ArrayAccess)
+    {
+        // arr[index] = value: the new array is written back to the variable
+        FArrayAccessExpr* Target = static_cast<FArrayAccessExpr*>(Expr->Target.Get());
+        if (!Target->Array.IsValid() || Target->Array->GetKind() != EScriptNodeKind::Identifier)
+        {
+            Fail(TEXT("array assignment to an expression"));
+            return Emit(EOpCode::OP_NIL, TArray<int32>());
+        }
+        const int32 Array = BuildExpression(Target->Array.Get());
+        const int32 Index = BuildExpression(Target->Index.Get());
+        const int32 Value = BuildExpression(Expr->Value.Get());
+        const int32 NewArray = Emit(EOpCode::OP_SET_ELEMENT, { Array, Index, Value });
+        return StoreVariable(static_cast<FIdentifierExpr*>(Target->Array.Get())->Name.Lexeme, NewArray);
+    }
+
+    if (TargetKind == EScriptNodeKind::StructAccess)
+    {
+        FStructAccessExpr* Target = static_cast<FStructAccessExpr*>(Expr->Target.Get());
+        const int32 Object = BuildExpression(Target->Object.Get());
+        const int32 Name = Compiler.Chunk->AddConstant(FScriptValue::String(Target->Field.Lexeme));
+        const int32 Value = BuildExpression(Expr->Value.Get());
+        return Emit(EOpCode::OP_SET_FIELD, { Object, Value }, Name, 0, false);
+    }
+
+    Fail(TEXT("invalid assignment target"));
+    return Emit(EOpCode::OP_NIL, TArray<int32>());
+}
+
+int32 FScriptIRBuilder::BuildCall(FCallExpr* Expr)
+{
+    if (Expr->Callee->GetKind() != EScriptNodeKind::Identifier)
+    {
+        Fail(TEXT("indirect call"));
+        return Emit(EOpCode::OP_NIL, TArray<int32>());
+    }
+
+    const FString& FuncName = static_cast<FIdentifierExpr*>(Expr->Callee.Get())->Name.Lexeme;
+    const int32 FuncIndex = Compiler.ResolveFunction(FuncName);
+    const int32 CallLine = CurrentLine;
+
+    TArray<int32> Arguments;
+    for (const auto& Arg : Expr->Arguments)
+    {
+        if (Arg.IsValid())
+        {
+            Arguments.Add(BuildExpression(Arg.Get()));
+        }
+    }
+    CurrentLine = CallLine;
+
+    if (FuncIndex >= 0)
+    {
+        if (Compiler.bInliningEnabled && InlineDepth < FScriptCompiler::MaxInlineDepth &&
+            Arguments.Num() == Compiler.Functions[FuncIndex].Arity && Compiler.IsInlineCandidate(FuncIndex, CallLine))
+        {
+            return BuildInlineCall(FuncIndex, Arguments);
+        }
+        return Emit(EOpCode::OP_CALL, Arguments, Expr->Arguments.Num(), FuncIndex, false);
+    }
+
+    // Natives: the same checks as the direct compiler - anything it reports falls back to it
+    const FNativeFunctionDecl* NativeDecl = FScriptNativeRegistry::FindDeclaration(FuncName);
+    if (!NativeDecl)
+    {
+        SCRIPT_LOG_WARNING(FString::Printf(TEXT("Unknown function '%s' - assuming native"), *FuncName));
+    }
+    else if (!NativeDecl->AcceptsArgCount(Expr->Arguments.Num()))
+    {
+        Fail(FString::Printf(TEXT("wrong argument count for native '%s'"), *FuncName));
+    }
+    if (Expr->Arguments.Num() > NATIVE_CALL_ARGC_MASK)
+    {
+        Fail(FString::Printf(TEXT("too many arguments to native '%s'"), *FuncName));
+    }
+
+    uint8 ArgByte = (uint8)(Expr->Arguments.Num() & NATIVE_CALL_ARGC_MASK);
+    const FNativeFunctionEntry* Bound = FScriptNativeRegistry::Get().FindEntry(FuncName);
+    if (Bound && Bound->Decl.HasSignature() && Compiler.CheckNativeArguments(FuncName, Bound->Decl, Expr))
+    {
+        ArgByte |= NATIVE_CALL_ARGS_CHECKED;
+    }
+
+    const int32 NameIndex = Compiler.Chunk->AddConstant(FScriptValue::String(FuncName));
+    const bool bPure = NativeDecl && NativeDecl->IsPure() && !NativeDecl->IsLatent();
+    return Emit(EOpCode::OP_CALL_NATIVE, Arguments, ArgByte, NameIndex, bPure);
+}
+
+int32 FScriptIRBuilder::BuildInlineCall(int32 FuncIndex, const TArray<int32>& Arguments)
+{
+    // The arguments are already SSA values: the parameters simply name them
+    const FScriptCompiler::FFunction& Callee = Compiler.Functions[FuncIndex];
+    FFunctionDecl* Decl = Callee.Decl;
+    FScriptExpression* Body = static_cast<FReturnStmt*>(Decl->Body->Statements[0].Get())->Value.Get();
+
+    const int32 SavedFloor = Compiler.LocalFloor;
+    const int32 SavedFile = CurrentFile;
+    const int32 SavedLine = CurrentLine;
+    Compiler.ScopeDepth++;
+    Compiler.LocalFloor = Compiler.Locals.Num();
+
+    for (int32 i = 0; i < Arguments.Num(); ++i)
+    {
+        const bool bTyped = Decl->TypedParameters.Num() > 0;
+        const FString& Name = bTyped ? Decl->TypedParameters[i].Name.Lexeme : Decl->Parameters[i].Lexeme;
+        const int32 Variable = NewVariable();
+        AddLocal(Name, bTyped ? Decl->TypedParameters[i].Type : EScriptType::AUTO, Variable);
+        EnsureBlock();
+        WriteVariable(Variable, CurrentBlock, Arguments[i]);
+    }
+
+    CurrentFile = F.Files.Find(Callee.SourceFile);
+    if (CurrentFile < 0)
+    {
+        F.Files.Add(Callee.SourceFile);
+        CurrentFile = F.Files.Num() - 1;
+    }
+
+    InlineDepth++;
+    const int32 Result = BuildExpression(Body);
+    InlineDepth--;
+
+    Compiler.ScopeDepth--;
+    PopLocals(Compiler.ScopeDepth);
+    Compiler.LocalFloor = SavedFloor;
+    CurrentFile = SavedFile;
+    CurrentLine = SavedLine;
+    return Result;
+}
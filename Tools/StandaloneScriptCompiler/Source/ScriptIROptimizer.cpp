@@ -0,0 +1,2412 @@
+// Copyright Vampire Game Project. All Rights Reserved.
+// Custom scripting system for secure modding support.
+
+#include "ScriptIR.h"
+
+namespace
+{
+    /** Pure operations that never raise a runtime error - safe to drop when unused */
+    bool CannotFail(const FScriptIRInstr& Instr)
+    {
+        if (Instr.Op != EScriptIROp::Bytecode)
+        {
+            return Instr.Op != EScriptIROp::StoreSlot;
+        }
+        switch (Instr.OpCode)
+        {
+            case EOpCode::OP_CONSTANT:
+            case EOpCode::OP_NIL:
+            case EOpCode::OP_TRUE:
+            case EOpCode::OP_FALSE:
+            case EOpCode::OP_EQUAL:
+            case EOpCode::OP_NOT:
+            case EOpCode::OP_AND:
+            case EOpCode::OP_OR:
+            case EOpCode::OP_CAST_STRING:
+            case EOpCode::OP_CREATE_ARRAY:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    /** Identity of a pure operation for CSE - operands must already be resolved */
+    FString MakeValueKey(const FScriptIRFunction& F, const FScriptIRInstr& Instr)
+    {
+        FString Key = FString::Printf(TEXT("%d:%d:%d:%d"), (int32)Instr.Op, (int32)Instr.OpCode, Instr.Imm, Instr.Imm2);
+        for (int32 Operand : Instr.Operands)
+        {
+            Key += FString::Printf(TEXT(",%d"), F.Resolve(Operand));
+        }
+        return Key;
+    }
+
+    void EliminateInDominatorTree(FScriptIRFunction& F, const TArray<TArray<int32>>& Children, int32 BlockIndex, TMap<FString, int32>& Available)
+    {
+        TArray<FString> Added;
+        for (int32 Index : F.Blocks[BlockIndex].Instrs)
+        {
+            const FScriptIRInstr& Instr = F.Instrs[Index];
+            if (Instr.bRemoved || !Instr.bPure || !Instr.HasResult() || Instr.IsConstant() ||
+                (Instr.Op != EScriptIROp::Bytecode && Instr.Op != EScriptIROp::LoadSlot))
+            {
+                continue;
+            }
+
+            const FString Key = MakeValueKey(F, Instr);
+            if (const int32* Existing = Available.Find(Key))
+            {
+                F.Replace(Index, *Existing);
+                F.NumMerged++;
+            }
+            else
+            {
+                Available.Add(Key, Index);
+                Added.Add(Key);
+            }
+        }
+
+        for (int32 Child : Children[BlockIndex])
+        {
+            EliminateInDominatorTree(F, Children, Child, Available);
+        }
+
+        // Leaving this subtree: its values no longer dominate what is visited next
+        for (const FString& Key : Added)
+        {
+            Available.Remove(Key);
+        }
+    }
+}
+
+//=============================================================================
+// Optimizer
+//=============================================================================
+
+void FScriptIROptimizer::Optimize(FScriptIRFunction& Function)
+{
+    RemoveUnreachableBlocks(Function);
+    RemoveTrivialPhis(Function);
+    EliminateCommonSubexpressions(Function);
+    HoistLoopInvariants(Function);
+    EliminateDeadStores(Function);
+    EliminateDeadCode(Function);
+    Function.ApplyReplacements();
+}
+
+void FScriptIROptimizer::RemoveUnreachableBlocks(FScriptIRFunction& F)
+{
+    TArray<bool> Reached;
+    Reached.Init(false, F.Blocks.Num());
+    TArray<int32> Work;
+    Work.Add(0);
+    Reached[0] = true;
+    while (Work.Num() > 0)
+    {
+        const int32 Block = Work.Pop();
+        for (int32 Succ : F.Blocks[Block].Succs)
+        {
+            if (!Reached[Succ])
+            {
+                Reached[Succ] = true;
+                Work.Add(Succ);
+            }
+        }
+    }
+
+    for (int32 BlockIndex = 0; BlockIndex < F.Blocks.Num(); ++BlockIndex)
+    {
+        FScriptIRBlock& Block = F.Blocks[BlockIndex];
+        if (!Reached[BlockIndex])
+        {
+            for (int32 Phi : Block.Phis)
+            {
+                F.Instrs[Phi].bRemoved = true;
+            }
+            for (int32 Instr : Block.Instrs)
+            {
+                F.Instrs[Instr].bRemoved = true;
+            }
+            Block.Preds.Empty();
+            Block.Succs.Empty();
+            continue;
+        }
+
+        // Phi operands are in predecessor order - drop both together
+        for (int32 i = Block.Preds.Num() - 1; i >= 0; --i)
+        {
+            if (!Reached[Block.Preds[i]])
+            {
+                Block.Preds.RemoveAt(i);
+                for (int32 Phi : Block.Phis)
+                {
+                    F.Instrs[Phi].Operands.RemoveAt(i);
+                }
+            }
+        }
+    }
+
+    TArray<int32> Layout;
+    for (int32 BlockIndex : F.Layout)
+    {
+        if (Reached[BlockIndex])
+        {
+            Layout.Add(BlockIndex);
+        }
+    }
+    F.Layout = Layout;
+}
+
+void FScriptIROptimizer::RemoveTrivialPhis(FScriptIRFunction& F)
+{
+    // Removing one phi can make the phis using it trivial in turn
+    bool bChanged = true;
+    while (bChanged)
+    {
+        bChanged = false;
+        for (int32 BlockIndex : F.Layout)
+        {
+            for (int32 Phi : F.Blocks[BlockIndex].Phis)
+            {
+                if (F.Instrs[Phi].bRemoved)
+                {
+                    continue;
+                }
+
+                int32 Same = -1;
+                bool bTrivial = true;
+                for (int32 Operand : F.Instrs[Phi].Operands)
+                {
+                    Operand = F.Resolve(Operand);
+                    if (Operand == Same || Operand == Phi)
+                    {
+                        continue;
+                    }
+                    if (Same >= 0)
+                    {
+                        bTrivial = false;
+                        break;
+                    }
+                    Same = Operand;
+                }
+
+                if (bTrivial && Same >= 0)
+                {
+                    F.Replace(Phi, Same);
+                    bChanged = true;
+                }
+            }
+        }
+    }
+    F.ApplyReplacements();
+}
+
+TArray<int32> FScriptIROptimizer::ComputeDominators(const FScriptIRFunction& F)
+{
+    // Cooper, Harvey and Kennedy, "A Simple, Fast Dominance Algorithm"
+    const int32 NumBlocks = F.Blocks.Num();
+    TArray<int32> Order;            // Reverse postorder
+    TArray<int32> OrderIndex;
+    OrderIndex.Init(-1, NumBlocks);
+
+    {
+        TArray<int32> Postorder;
+        TArray<bool> Visited;
+        Visited.Init(false, NumBlocks);
+        TArray<TPair<int32, int32>> Stack;  // Block, next successor
+        Stack.Add(TPair<int32, int32>(0, 0));
+        Visited[0] = true;
+        while (Stack.Num() > 0)
+        {
+            TPair<int32, int32>& Top = Stack.Last();
+            const TArray<int32>& Succs = F.Blocks[Top.Key].Succs;
+            if (Top.Value < Succs.Num())
+            {
+                const int32 Succ = Succs[Top.Value++];
+                if (!Visited[Succ])
+                {
+                    Visited[Succ] = true;
+                    Stack.Add(TPair<int32, int32>(Succ, 0));
+                }
+            }
+            else
+            {
+                Postorder.Add(Top.Key);
+                Stack.Pop();
+            }
+        }
+        for (int32 i = Postorder.Num() - 1; i >= 0; --i)
+        {
+            OrderIndex[Postorder[i]] = Order.Num();
+            Order.Add(Postorder[i]);
+        }
+    }
+
+    TArray<int32> Idom;
+    Idom.Init(-1, NumBlocks);
+    Idom[0] = 0;
+
+    bool bChanged = true;
+    while (bChanged)
+    {
+        bChanged = false;
+        for (int32 i = 1; i < Order.Num(); ++i)
+        {
+            const int32 Block = Order[i];
+            int32 NewIdom = -1;
+            for (int32 Pred : F.Blocks[Block].Preds)
+            {
+                if (Idom[Pred] < 0)
+                {
+                    continue;
+                }
+                if (NewIdom < 0)
+                {
+                    NewIdom = Pred;
+                    continue;
+                }
+
+                int32 A = Pred;
+                int32 B = NewIdom;
+                while (A != B)
+                {
+                    while (OrderIndex[A] > OrderIndex[B])
+                    {
+                        A = Idom[A];
+                    }
+                    while (OrderIndex[B] > OrderIndex[A])
+                    {
+                        B = Idom[B];
+                    }
+                }
+                NewIdom = A;
+            }
+
+            if (NewIdom != Idom[Block])
+            {
+                Idom[Block] = NewIdom;
+                bChanged = true;
+            }
+        }
+    }
+    return Idom;
+}
+
+bool FScriptIROptimizer::Dominates(const TArray<int32>& Idom, int32 A, int32 B)
+{
+    if (B < 0 || Idom[B] < 0)
+    {
+        return false;
+    }
+    while (B != A)
+    {
+        if (B == 0)
+        {
+            return false;
+        }
+        B = Idom[B];
+    }
+    return true;
+}
+
+void FScriptIROptimizer::EliminateCommonSubexpressions(FScriptIRFunction& F)
+{
+    // A value computed in a block is available in every block it dominates
+    const TArray<int32> Idom = ComputeDominators(F);
+    TArray<TArray<int32>> Children;
+    Children.SetNum(F.Blocks.Num());
+    for (int32 BlockIndex : F.Layout)
+    {
+        if (BlockIndex != 0 && Idom[BlockIndex] >= 0)
+        {
+            Children[Idom[BlockIndex]].Add(BlockIndex);
+        }
+    }
+
+    TMap<FString, int32> Available;
+    EliminateInDominatorTree(F, Children, 0, Available);
+    F.ApplyReplacements();
+}
+
+void FScriptIROptimizer::HoistLoopInvariants(FScriptIRFunction& F)
+{
+    struct FLoop
+    {
+        int32 Header;
+        int32 Preheader;
+        TArray<bool> Body;
+        int32 Size;
+    };
+
+    const TArray<int32> Idom = ComputeDominators(F);
+    TArray<FLoop> Loops;
+
+    for (int32 Header : F.Layout)
+    {
+        // Natural loop: the header and every block reaching a back edge without passing it
+        FLoop Loop;
+        Loop.Header = Header;
+        Loop.Preheader = -1;
+        Loop.Size = 1;
+        Loop.Body.Init(false, F.Blocks.Num());
+        Loop.Body[Header] = true;
+
+        TArray<int32> Work;
+        for (int32 Pred : F.Blocks[Header].Preds)
+        {
+            if (Dominates(Idom, Header, Pred))
+            {
+                Work.Add(Pred);
+            }
+        }
+        if (Work.Num() == 0)
+        {
+            continue;
+        }
+        while (Work.Num() > 0)
+        {
+            const int32 Block = Work.Pop();
+            if (!Loop.Body[Block])
+            {
+                Loop.Body[Block] = true;
+                Loop.Size++;
+                Work.Append(F.Blocks[Block].Preds);
+            }
+        }
+
+        // Code can only be hoisted into a block that always and only enters the loop
+        for (int32 Pred : F.Blocks[Header].Preds)
+        {
+            if (!Loop.Body[Pred])
+            {
+                Loop.Preheader = (Loop.Preheader < 0) ? Pred : -2;
+            }
+        }
+        if (Loop.Preheader >= 0 && F.Blocks[Loop.Preheader].Succs.Num() == 1)
+        {
+            Loops.Add(Loop);
+        }
+    }
+
+    // Inner loops first, so what they hoist can be considered again for the outer loop
+    Loops.Sort([](const FLoop& A, const FLoop& B) { return A.Size < B.Size; });
+
+    for (const FLoop& Loop : Loops)
+    {
+        // Only the header prefix that runs before any side effect or possible runtime error
+        // each iteration: hoisted, it runs once before the first iteration at the same point
+        FScriptIRBlock& Header = F.Blocks[Loop.Header];
+        TArray<int32> Kept;
+        bool bBlocked = false;
+        for (int32 Index : Header.Instrs)
+        {
+            FScriptIRInstr& Instr = F.Instrs[Index];
+            bool bInvariant = !bBlocked && !Instr.bRemoved && Instr.bPure && Instr.Op == EScriptIROp::Bytecode;
+            for (int32 i = 0; bInvariant && i < Instr.Operands.Num(); ++i)
+            {
+                bInvariant = !Loop.Body[F.Instrs[F.Resolve(Instr.Operands[i])].Block];
+            }
+
+            if (bInvariant)
+            {
+                Instr.Block = Loop.Preheader;
+                F.Blocks[Loop.Preheader].Instrs.Add(Index);
+                if (!Instr.IsConstant())
+                {
+                    F.NumHoisted++;
+                }
+                continue;
+            }
+
+            if (!Instr.bRemoved && (!Instr.bPure || !CannotFail(Instr)))
+            {
+                bBlocked = true;
+            }
+            Kept.Add(Index);
+        }
+        Header.Instrs = Kept;
+    }
+}
+
+void FScriptIROptimizer::EliminateDeadStores(FScriptIRFunction& F)
+{
+    // g = a; ... g = b;  with nothing in between that could read g
+    for (int32 BlockIndex : F.Layout)
+    {
+        const TArray<int32>& Instrs = F.Blocks[BlockIndex].Instrs;
+        for (int32 i = 0; i < Instrs.Num(); ++i)
+        {
+            const FScriptIRInstr& Store = F.Instrs[Instrs[i]];
+            if (Store.bRemoved || Store.Op != EScriptIROp::Bytecode || Store.OpCode != EOpCode::OP_SET_GLOBAL)
+            {
+                continue;
+            }
+
+            for (int32 j = i + 1; j < Instrs.Num(); ++j)
+            {
+                const FScriptIRInstr& Next = F.Instrs[Instrs[j]];
+                if (Next.bRemoved)
+                {
+                    continue;
+                }
+                if (Next.Op == EScriptIROp::Bytecode && Next.OpCode == EOpCode::OP_SET_GLOBAL)
+                {
+                    if (Next.Imm == Store.Imm)
+                    {
+                        // The assignment's value is the assigned value
+                        F.Replace(Instrs[i], F.Resolve(Store.Operands[0]));
+                        F.NumDeadStores++;
+                        break;
+                    }
+                    continue;
+                }
+                if (!Next.bPure)
+                {
+                    break;
+                }
+            }
+        }
+    }
+    F.ApplyReplacements();
+}
+
+void FScriptIROptimizer::EliminateDeadCode(FScriptIRFunction& F)
+{
+    // Mark from what must run - side effects, possible errors and block terminators -
+    // so unused loop-carried phi cycles go too
+    TArray<bool> Live;
+    Live.Init(false, F.Instrs.Num());
+    TArray<int32> Work;
+
+    auto MarkLive = [&F, &Live, &Work](int32 Value)
+    {
+        Value = F.Resolve(Value);
+        if (Value >= 0 && !Live[Value])
+        {
+            Live[Value] = true;
+            Work.Add(Value);
+        }
+    };
+
+    for (int32 BlockIndex : F.Layout)
+    {
+        const FScriptIRBlock& Block = F.Blocks[BlockIndex];
+        for (int32 Index : Block.Instrs)
+        {
+            const FScriptIRInstr& Instr = F.Instrs[Index];
+            if (!Instr.bRemoved && (!Instr.bPure || !CannotFail(Instr) || Instr.Op == EScriptIROp::Param))
+            {
+                MarkLive(Index);
+            }
+        }
+        if (Block.Value >= 0 && (Block.Terminator == EScriptIRTerminator::Branch || Block.Terminator == EScriptIRTerminator::Return))
+        {
+            MarkLive(Block.Value);
+        }
+    }
+
+    while (Work.Num() > 0)
+    {
+        for (int32 Operand : F.Instrs[Work.Pop()].Operands)
+        {
+            MarkLive(Operand);
+        }
+    }
+
+    for (int32 BlockIndex : F.Layout)
+    {
+        const FScriptIRBlock& Block = F.Blocks[BlockIndex];
+        for (int32 Phi : Block.Phis)
+        {
+            F.Instrs[Phi].bRemoved |= !Live[Phi];
+        }
+        for (int32 Index : Block.Instrs)
+        {
+            FScriptIRInstr& Instr = F.Instrs[Index];
+            if (!Instr.bRemoved && !Live[Index])
+            {
+                Instr.bRemoved = true;
+                if (!Instr.IsConstant())
+                {
+                    F.NumRemoved++;
+                }
+            }
+        }
+    }
+}
+
+//=============================================================================
+// Lowering
+//=============================================================================
+
+namespace
+{
+    /**
+     * Where each value of a function lives: live ranges, and the frame slots handed out over them
+     * Shared by the stack lowering (values used once stay on the operand stack) and the
+     * register lowering (every value is in a slot).
+     */
+    class FIRFrameLayout
+    {
+    public:
+        FIRFrameLayout(FScriptIRFunction& InFunction, bool bInDeferOperands)
+            : F(InFunction), NumSlots(0), bDeferOperands(bInDeferOperands), bFailed(false)
+        {}
+
+    protected:
+        /** A live range piece: the value is read or written strictly inside (From, To) */
+        struct FSegment
+        {
+            int32 From;
+            int32 To;
+            int32 Source;       // For the copy into a phi: the value copied, -1 otherwise
+
+            FSegment() : From(0), To(0), Source(-1) {}
+        };
+
+        FScriptIRFunction& F;
+
+        TArray<int32> LayoutIndex;
+        TArray<int32> UseCount;
+        TArray<int32> User;             // Single user of a value, -1 = the block terminator
+        TArray<bool> Deferred;          // Emitted inside its user's operand tree
+        TArray<int32> Slot;             // Frame slot of a value, -1 = none
+        int32 NumSlots;
+        bool bDeferOperands;
+
+        // Live ranges
+        TArray<int32> RootPos;
+        TArray<int32> BlockStart;
+        TArray<int32> BlockTerm;
+        TArray<TArray<FSegment>> Segments;
+
+        bool bFailed;
+        FString FailReason;
+
+        bool Fail(const FString& Reason)
+        {
+            if (!bFailed)
+            {
+                bFailed = true;
+                FailReason = Reason;
+            }
+            return false;
+        }
+
+        bool IsRoot(int32 Index) const
+        {
+            const FScriptIRInstr& Instr = F.Instrs[Index];
+            return !Instr.bRemoved && Instr.Op != EScriptIROp::Phi && Instr.Op != EScriptIROp::Param &&
+                !Instr.IsConstant() && !Deferred[Index];
+        }
+
+        int32 TerminatorValue(const FScriptIRBlock& Block) const
+        {
+            return (Block.Terminator == EScriptIRTerminator::Branch || Block.Terminator == EScriptIRTerminator::Return) ? Block.Value : -1;
+        }
+
+        int32 PredIndex(int32 Block, int32 Pred) const
+        {
+            return F.Blocks[Block].Preds.Find(Pred);
+        }
+
+        /** Validate, compute live ranges and allocate the slots */
+        bool Analyze(FString& OutReason);
+
+        bool Validate();
+        void CountUses();
+        void ChooseDeferred();
+        void AppendEvaluationOrder(int32 Value, TArray<int32>& OutOrder) const;
+        void ComputeLiveRanges();
+        bool Interferes(int32 A, int32 B) const;
+        bool AllocateSlots();
+        bool NeedsCopies(int32 Pred, int32 Target) const;
+    };
+
+    class FIRLowering : public FIRFrameLayout
+    {
+    public:
+        FIRLowering(FScriptIRFunction& InFunction, FBytecodeChunk& InChunk)
+            : FIRFrameLayout(InFunction, true), Chunk(InChunk), CurrentLine(0), CurrentFile(0)
+            , bPendingPop(false), PendingSlot(-1), CurrentLayoutIndex(0)
+        {}
+
+        bool Run(FString& OutReason);
+
+    private:
+        /** An edge leaving a branch or loop opcode that needs code of its own */
+        struct FStub
+        {
+            int32 PatchOffset;
+            int32 Pred;         // Copies for Pred -> Target, -1 = none
+            int32 Target;
+            bool bPopCondition;
+        };
+
+        FBytecodeChunk& Chunk;
+
+        TArray<bool> PopsCondition;     // Only entered by OP_JUMP_IF_FALSE: starts with OP_POP
+
+        // Emission
+        TArray<int32> BlockAddress;
+        TArray<TArray<int32>> PendingJumps;
+        TArray<FStub> Stubs;
+        int32 CurrentLine;
+        int32 CurrentFile;
+        bool bPendingPop;
+        int32 PendingSlot;
+        TArray<int32> EmitOrder;        // Layout without the blocks jumps go straight through
+        int32 CurrentLayoutIndex;
+
+        void WriteByte(uint8 Byte);
+        void EmitOp(EOpCode OpCode);
+        void FlushPop();
+        void EmitGetLocal(int32 LocalSlot);
+        void EmitSetLocalAndPop(int32 LocalSlot);
+        void EmitInstr(int32 Index);
+        void EmitValue(int32 Value);
+        void EmitRoot(int32 Index);
+        void EmitCopies(int32 Pred, int32 Target);
+        void EmitGoto(int32 Target);
+        int32 SkipEmptyBlocks(int32 Target) const;
+        void EmitForwardOffset(int32 Target);
+        void EmitBackwardOffset(int32 Target);
+        void PatchForward(int32 Offset);
+        void EmitBlock(int32 BlockIndex);
+        void EmitTerminator(int32 BlockIndex);
+    };
+
+    bool FIRFrameLayout::Validate()
+    {
+        for (int32 BlockIndex : F.Layout)
+        {
+            const FScriptIRBlock& Block = F.Blocks[BlockIndex];
+            if (Block.Terminator == EScriptIRTerminator::None)
+            {
+                return Fail(TEXT("block without terminator"));
+            }
+
+            auto CheckOperand = [this](int32 Value)
+            {
+                return F.Instrs.IsValidIndex(Value) && !F.Instrs[Value].bRemoved && F.Instrs[Value].HasResult();
+            };
+            for (int32 Phi : Block.Phis)
+            {
+                for (int32 Operand : F.Instrs[Phi].Operands)
+                {
+                    if (!F.Instrs[Phi].bRemoved && !CheckOperand(Operand))
+                    {
+                        return Fail(TEXT("phi operand not defined"));
+                    }
+                }
+            }
+            for (int32 Index : Block.Instrs)
+            {
+                for (int32 Operand : F.Instrs[Index].Operands)
+                {
+                    if (!F.Instrs[Index].bRemoved && !CheckOperand(Operand))
+                    {
+                        return Fail(TEXT("operand not defined"));
+                    }
+                }
+            }
+            if (TerminatorValue(Block) >= 0 && !CheckOperand(Block.Value))
+            {
+                return Fail(TEXT("terminator value not defined"));
+            }
+        }
+        return true;
+    }
+
+    void FIRFrameLayout::CountUses()
+    {
+        UseCount.Init(0, F.Instrs.Num());
+        User.Init(-2, F.Instrs.Num());
+        for (int32 BlockIndex : F.Layout)
+        {
+            const FScriptIRBlock& Block = F.Blocks[BlockIndex];
+            for (int32 Phi : Block.Phis)
+            {
+                if (!F.Instrs[Phi].bRemoved)
+                {
+                    for (int32 Operand : F.Instrs[Phi].Operands)
+                    {
+                        UseCount[Operand]++;
+                        User[Operand] = -2;     // Never deferred into a phi
+                    }
+                }
+            }
+            for (int32 Index : Block.Instrs)
+            {
+                if (!F.Instrs[Index].bRemoved)
+                {
+                    for (int32 Operand : F.Instrs[Index].Operands)
+                    {
+                        UseCount[Operand]++;
+                        User[Operand] = (F.Instrs[Operand].Block == BlockIndex) ? Index : -2;
+                    }
+                }
+            }
+            const int32 Value = TerminatorValue(Block);
+            if (Value >= 0)
+            {
+                UseCount[Value]++;
+                User[Value] = (F.Instrs[Value].Block == BlockIndex) ? -1 : -2;
+            }
+        }
+    }
+
+    void FIRFrameLayout::AppendEvaluationOrder(int32 Value, TArray<int32>& OutOrder) const
+    {
+        const FScriptIRInstr& Instr = F.Instrs[Value];
+        for (int32 Operand : Instr.Operands)
+        {
+            if (Deferred[Operand])
+            {
+                AppendEvaluationOrder(Operand, OutOrder);
+            }
+        }
+        OutOrder.Add(Value);
+    }
+
+    void FIRFrameLayout::ChooseDeferred()
+    {
+        // A value used once, later in its own block, is computed right where it is used
+        Deferred.Init(false, F.Instrs.Num());
+        if (!bDeferOperands)
+        {
+            return;
+        }
+        for (int32 BlockIndex : F.Layout)
+        {
+            for (int32 Index : F.Blocks[BlockIndex].Instrs)
+            {
+                const FScriptIRInstr& Instr = F.Instrs[Index];
+                Deferred[Index] = !Instr.bRemoved && Instr.HasResult() && !Instr.IsConstant() &&
+                    (Instr.Op == EScriptIROp::Bytecode || Instr.Op == EScriptIROp::LoadSlot) &&
+                    UseCount[Index] == 1 && User[Index] != -2;
+            }
+        }
+
+        // ...unless that would move it past another operation: evaluation order is observable
+        for (int32 BlockIndex : F.Layout)
+        {
+            const FScriptIRBlock& Block = F.Blocks[BlockIndex];
+            TArray<int32> Expected;
+            for (int32 Index : Block.Instrs)
+            {
+                if (IsRoot(Index) || Deferred[Index])
+                {
+                    Expected.Add(Index);
+                }
+            }
+
+            while (true)
+            {
+                TArray<int32> Order;
+                for (int32 Index : Block.Instrs)
+                {
+                    if (IsRoot(Index))
+                    {
+                        AppendEvaluationOrder(Index, Order);
+                    }
+                }
+                const int32 Value = TerminatorValue(Block);
+                if (Value >= 0 && Deferred[Value])
+                {
+                    AppendEvaluationOrder(Value, Order);
+                }
+
+                int32 Mismatch = 0;
+                while (Mismatch < Expected.Num() && Mismatch < Order.Num() && Expected[Mismatch] == Order[Mismatch])
+                {
+                    Mismatch++;
+                }
+                if (Mismatch == Expected.Num())
+                {
+                    break;
+                }
+
+                // Roots are emitted in order, so the first value out of place is one emitted late
+                Deferred[Expected[Mismatch]] = false;
+            }
+        }
+    }
+
+    void FIRFrameLayout::ComputeLiveRanges()
+    {
+        // Positions: block start, two per root, the terminator (reads its value and the
+        // phi operands of its successors, writes the phis) and the block end
+        const int32 NumInstrs = F.Instrs.Num();
+        RootPos.Init(-1, NumInstrs);
+        BlockStart.Init(0, F.Blocks.Num());
+        BlockTerm.Init(0, F.Blocks.Num());
+
+        int32 Position = 0;
+        for (int32 BlockIndex : F.Layout)
+        {
+            BlockStart[BlockIndex] = Position;
+            Position += 2;
+            for (int32 Index : F.Blocks[BlockIndex].Instrs)
+            {
+                if (IsRoot(Index))
+                {
+                    RootPos[Index] = Position;
+                    Position += 2;
+                }
+            }
+            BlockTerm[BlockIndex] = Position;
+            Position += 3;
+        }
+
+        // Where each value is read: at its own position if it is a root, else at its user's
+        TArray<int32> ReadPos;
+        ReadPos.Init(-1, NumInstrs);
+        for (int32 BlockIndex : F.Layout)
+        {
+            const TArray<int32>& Instrs = F.Blocks[BlockIndex].Instrs;
+            for (int32 i = Instrs.Num() - 1; i >= 0; --i)
+            {
+                const int32 Index = Instrs[i];
+                if (RootPos[Index] >= 0)
+                {
+                    ReadPos[Index] = RootPos[Index];
+                }
+                else if (Deferred[Index])
+                {
+                    ReadPos[Index] = (User[Index] < 0) ? BlockTerm[BlockIndex] : ReadPos[User[Index]];
+                }
+            }
+        }
+
+        // Values kept in slots get dense ids for the dataflow sets
+        TArray<int32> Dense;
+        Dense.Init(-1, NumInstrs);
+        TArray<int32> Values;
+        for (int32 Index = 0; Index < NumInstrs; ++Index)
+        {
+            const FScriptIRInstr& Instr = F.Instrs[Index];
+            const bool bSlot = !Instr.bRemoved && Instr.Block >= 0 && LayoutIndex[Instr.Block] >= 0 && Instr.HasResult() &&
+                (Instr.Op == EScriptIROp::Param || Instr.Op == EScriptIROp::Phi || (IsRoot(Index) && UseCount[Index] > 0));
+            if (bSlot)
+            {
+                Dense[Index] = Values.Num();
+                Values.Add(Index);
+            }
+        }
+
+        const int32 NumBlocks = F.Blocks.Num();
+        const int32 NumValues = Values.Num();
+        TArray<TArray<bool>> Defined;
+        TArray<TArray<bool>> UpwardUse;
+        TArray<TArray<int32>> LastUse;
+        Defined.SetNum(NumBlocks);
+        UpwardUse.SetNum(NumBlocks);
+        LastUse.SetNum(NumBlocks);
+
+        for (int32 BlockIndex : F.Layout)
+        {
+            Defined[BlockIndex].Init(false, NumValues);
+            UpwardUse[BlockIndex].Init(false, NumValues);
+            LastUse[BlockIndex].Init(-1, NumValues);
+        }
+        for (int32 Value : Values)
+        {
+            Defined[F.Instrs[Value].Block][Dense[Value]] = true;
+        }
+
+        auto AddUse = [&](int32 BlockIndex, int32 Value, int32 Pos)
+        {
+            const int32 Id = Dense[Value];
+            if (Id >= 0)
+            {
+                if (!Defined[BlockIndex][Id])
+                {
+                    UpwardUse[BlockIndex][Id] = true;
+                }
+                LastUse[BlockIndex][Id] = FMath::Max(LastUse[BlockIndex][Id], Pos);
+            }
+        };
+
+        for (int32 BlockIndex : F.Layout)
+        {
+            const FScriptIRBlock& Block = F.Blocks[BlockIndex];
+            for (int32 Index : Block.Instrs)
+            {
+                if (!F.Instrs[Index].bRemoved)
+                {
+                    for (int32 Operand : F.Instrs[Index].Operands)
+                    {
+                        AddUse(BlockIndex, Operand, ReadPos[Index]);
+                    }
+                }
+            }
+            if (TerminatorValue(Block) >= 0)
+            {
+                AddUse(BlockIndex, Block.Value, BlockTerm[BlockIndex]);
+            }
+            for (int32 Succ : Block.Succs)
+            {
+                const int32 Edge = PredIndex(Succ, BlockIndex);
+                for (int32 Phi : F.Blocks[Succ].Phis)
+                {
+                    if (!F.Instrs[Phi].bRemoved)
+                    {
+                        AddUse(BlockIndex, F.Instrs[Phi].Operands[Edge], BlockTerm[BlockIndex]);
+                    }
+                }
+            }
+        }
+
+        // LiveIn(b) = UpwardUse(b) + (LiveOut(b) - Defined(b)), LiveOut(b) = union of LiveIn(succ)
+        TArray<TArray<bool>> LiveIn;
+        TArray<TArray<bool>> LiveOut;
+        LiveIn.SetNum(NumBlocks);
+        LiveOut.SetNum(NumBlocks);
+        for (int32 BlockIndex : F.Layout)
+        {
+            LiveIn[BlockIndex] = UpwardUse[BlockIndex];
+            LiveOut[BlockIndex].Init(false, NumValues);
+        }
+
+        bool bChanged = true;
+        while (bChanged)
+        {
+            bChanged = false;
+            for (int32 i = F.Layout.Num() - 1; i >= 0; --i)
+            {
+                const int32 BlockIndex = F.Layout[i];
+                TArray<bool>& Out = LiveOut[BlockIndex];
+                TArray<bool>& In = LiveIn[BlockIndex];
+                for (int32 Succ : F.Blocks[BlockIndex].Succs)
+                {
+                    const TArray<bool>& SuccIn = LiveIn[Succ];
+                    for (int32 Id = 0; Id < NumValues; ++Id)
+                    {
+                        if (SuccIn[Id] && !Out[Id])
+                        {
+                            Out[Id] = true;
+                            if (!Defined[BlockIndex][Id] && !In[Id])
+                            {
+                                In[Id] = true;
+                            }
+                            bChanged = true;
+                        }
+                    }
+                }
+            }
+        }
+
+        Segments.SetNum(NumInstrs);
+        for (int32 BlockIndex : F.Layout)
+        {
+            const FScriptIRBlock& Block = F.Blocks[BlockIndex];
+            const int32 End = BlockTerm[BlockIndex] + 1;
+            for (int32 Id = 0; Id < NumValues; ++Id)
+            {
+                const int32 Value = Values[Id];
+                const FScriptIRInstr& Instr = F.Instrs[Value];
+                const bool bDefined = Defined[BlockIndex][Id];
+                if (!bDefined && !LiveIn[BlockIndex][Id])
+                {
+                    continue;
+                }
+
+                FSegment Segment;
+                if (Instr.Op == EScriptIROp::Param)
+                {
+                    Segment.From = -1;
+                }
+                else if (Instr.Op == EScriptIROp::Phi || !bDefined)
+                {
+                    Segment.From = BlockStart[BlockIndex];
+                }
+                else
+                {
+                    Segment.From = RootPos[Value];
+                }
+                Segment.To = LiveOut[BlockIndex][Id] ? End : FMath::Max(LastUse[BlockIndex][Id], Segment.From);
+                Segments[Value].Add(Segment);
+
+                // A phi is written by the copies at the end of each predecessor
+                if (Instr.Op == EScriptIROp::Phi && bDefined)
+                {
+                    for (int32 Edge = 0; Edge < Block.Preds.Num(); ++Edge)
+                    {
+                        FSegment Copy;
+                        Copy.From = BlockTerm[Block.Preds[Edge]];
+                        Copy.To = Copy.From + 1;
+                        Copy.Source = Instr.Operands[Edge];
+                        Segments[Value].Add(Copy);
+                    }
+                }
+            }
+        }
+    }
+
+    bool FIRFrameLayout::Interferes(int32 A, int32 B) const
+    {
+        for (const FSegment& SegA : Segments[A])
+        {
+            for (const FSegment& SegB : Segments[B])
+            {
+                // A value may take the slot of one last read where it is written, and a phi
+                // the slot of the value copied into it (the copy then disappears)
+                if (SegA.From < SegB.To && SegB.From < SegA.To && SegA.Source != B && SegB.Source != A)
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool FIRFrameLayout::AllocateSlots()
+    {
+        Slot.Init(-1, F.Instrs.Num());
+        const int32 FirstFree = F.Arity + F.NumPinnedSlots;
+        NumSlots = FirstFree;
+
+        TArray<TArray<int32>> Occupants;
+        Occupants.SetNum(NumSlots);
+
+        TArray<int32> Order;
+        for (int32 Index = 0; Index < F.Instrs.Num(); ++Index)
+        {
+            if (Segments[Index].Num() == 0)
+            {
+                continue;
+            }
+            if (F.Instrs[Index].Op == EScriptIROp::Param)
+            {
+                Slot[Index] = F.Instrs[Index].Imm;
+                Occupants[Slot[Index]].Add(Index);
+            }
+            else
+            {
+                Order.Add(Index);
+            }
+        }
+
+        auto FirstPosition = [this](int32 Value)
+        {
+            int32 First = MAX_int32;
+            for (const FSegment& Segment : Segments[Value])
+            {
+                First = FMath::Min(First, Segment.From);
+            }
+            return First;
+        };
+        Order.Sort([&FirstPosition](int32 A, int32 B) { return FirstPosition(A) < FirstPosition(B); });
+
+        // Phis and their operands, so a copy can be made unnecessary by sharing a slot
+        TArray<TArray<int32>> Related;
+        Related.SetNum(F.Instrs.Num());
+        for (int32 BlockIndex : F.Layout)
+        {
+            for (int32 Phi : F.Blocks[BlockIndex].Phis)
+            {
+                if (!F.Instrs[Phi].bRemoved)
+                {
+                    for (int32 Operand : F.Instrs[Phi].Operands)
+                    {
+                        Related[Phi].Add(Operand);
+                        Related[Operand].Add(Phi);
+                    }
+                }
+            }
+        }
+
+        auto IsFree = [this, &Occupants](int32 Value, int32 Candidate)
+        {
+            for (int32 Other : Occupants[Candidate])
+            {
+                if (Interferes(Value, Other))
+                {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        for (int32 Value : Order)
+        {
+            int32 Chosen = -1;
+            for (int32 Other : Related[Value])
+            {
+                if (Slot[Other] >= 0 && IsFree(Value, Slot[Other]))
+                {
+                    Chosen = Slot[Other];
+                    break;
+                }
+            }
+            for (int32 Candidate = 0; Chosen < 0 && Candidate < NumSlots; ++Candidate)
+            {
+                const bool bPinned = Candidate >= F.Arity && Candidate < FirstFree;
+                if (!bPinned && IsFree(Value, Candidate))
+                {
+                    Chosen = Candidate;
+                }
+            }
+            if (Chosen < 0)
+            {
+                Chosen = NumSlots++;
+                Occupants.SetNum(NumSlots);
+            }
+            Slot[Value] = Chosen;
+            Occupants[Chosen].Add(Value);
+        }
+
+        if (NumSlots > 256)
+        {
+            return Fail(FString::Printf(TEXT("needs %d frame slots"), NumSlots));
+        }
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    // Emission
+    //-------------------------------------------------------------------------
+
+    void FIRLowering::WriteByte(uint8 Byte)
+    {
+        Chunk.WriteByte(Byte, CurrentLine, F.Files[CurrentFile]);
+    }
+
+    void FIRLowering::FlushPop()
+    {
+        if (bPendingPop)
+        {
+            bPendingPop = false;
+            WriteByte((uint8)EOpCode::OP_POP);
+        }
+    }
+
+    void FIRLowering::EmitOp(EOpCode OpCode)
+    {
+        FlushPop();
+        WriteByte((uint8)OpCode);
+    }
+
+    void FIRLowering::EmitGetLocal(int32 LocalSlot)
+    {
+        // SET_LOCAL x; POP; GET_LOCAL x  =>  SET_LOCAL x
+        if (bPendingPop && PendingSlot == LocalSlot)
+        {
+            bPendingPop = false;
+            return;
+        }
+        EmitOp(EOpCode::OP_GET_LOCAL);
+        WriteByte((uint8)LocalSlot);
+    }
+
+    void FIRLowering::EmitSetLocalAndPop(int32 LocalSlot)
+    {
+        EmitOp(EOpCode::OP_SET_LOCAL);
+        WriteByte((uint8)LocalSlot);
+        bPendingPop = true;
+        PendingSlot = LocalSlot;
+    }
+
+    void FIRLowering::EmitInstr(int32 Index)
+    {
+        const FScriptIRInstr& Instr = F.Instrs[Index];
+        CurrentLine = Instr.Line;
+        CurrentFile = Instr.File;
+
+        if (Instr.Op == EScriptIROp::LoadSlot)
+        {
+            EmitGetLocal(F.Arity + Instr.Imm);
+            return;
+        }
+
+        // Constant indices past 255 (large scripts, or constants the optimizer folded) take the _WIDE form,
+        // as does every constant of module code, which the linker renumbers
+        const bool bConstantOperand = Instr.OpCode == EOpCode::OP_CONSTANT || Instr.OpCode == EOpCode::OP_GET_GLOBAL ||
+            Instr.OpCode == EOpCode::OP_SET_GLOBAL;
+        if (bConstantOperand && (Instr.Imm > MAX_COMPACT_OPERAND || F.bWideConstants))
+        {
+            EmitOp(GetWideOpCode(Instr.OpCode));
+            WriteByte((uint8)(Instr.Imm >> 16));
+            WriteByte((uint8)(Instr.Imm >> 8));
+            WriteByte((uint8)(Instr.Imm & 0xFF));
+            return;
+        }
+
+        EmitOp(Instr.OpCode);
+        switch (Instr.OpCode)
+        {
+            case EOpCode::OP_CONSTANT:
+            case EOpCode::OP_GET_GLOBAL:
+            case EOpCode::OP_SET_GLOBAL:
+            case EOpCode::OP_CREATE_ARRAY:
+                WriteByte((uint8)Instr.Imm);
+                break;
+
+            case EOpCode::OP_GET_FIELD:
+            case EOpCode::OP_SET_FIELD:
+                if (Instr.Imm > 0xFFFF)
+                {
+                    Fail(TEXT("field name constant past 16 bits"));
+                }
+                WriteByte((uint8)(Instr.Imm >> 8));
+                WriteByte((uint8)(Instr.Imm & 0xFF));
+                break;
+
+            case EOpCode::OP_CALL:
+            case EOpCode::OP_CALL_NATIVE:
+                if (Instr.Imm2 > 0xFFFF)
+                {
+                    Fail(TEXT("native name constant past 16 bits"));
+                }
+                WriteByte((uint8)Instr.Imm);
+                WriteByte((uint8)(Instr.Imm2 >> 8));
+                WriteByte((uint8)(Instr.Imm2 & 0xFF));
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    void FIRLowering::EmitValue(int32 Value)
+    {
+        const FScriptIRInstr& Instr = F.Instrs[Value];
+        if (Instr.IsConstant())
+        {
+            EmitInstr(Value);
+        }
+        else if (Deferred[Value])
+        {
+            for (int32 Operand : Instr.Operands)
+            {
+                EmitValue(Operand);
+            }
+            EmitInstr(Value);
+        }
+        else
+        {
+            EmitGetLocal(Slot[Value]);
+        }
+    }
+
+    void FIRLowering::EmitRoot(int32 Index)
+    {
+        const FScriptIRInstr& Instr = F.Instrs[Index];
+        for (int32 Operand : Instr.Operands)
+        {
+            EmitValue(Operand);
+        }
+
+        if (Instr.Op == EScriptIROp::StoreSlot)
+        {
+            CurrentLine = Instr.Line;
+            CurrentFile = Instr.File;
+            EmitSetLocalAndPop(F.Arity + Instr.Imm);
+            return;
+        }
+
+        EmitInstr(Index);
+        if (Slot[Index] >= 0)
+        {
+            EmitSetLocalAndPop(Slot[Index]);
+        }
+        else
+        {
+            bPendingPop = true;
+            PendingSlot = -1;
+        }
+    }
+
+    bool FIRFrameLayout::NeedsCopies(int32 Pred, int32 Target) const
+    {
+        const int32 Edge = PredIndex(Target, Pred);
+        for (int32 Phi : F.Blocks[Target].Phis)
+        {
+            const FScriptIRInstr& Instr = F.Instrs[Phi];
+            if (!Instr.bRemoved)
+            {
+                const int32 Source = Instr.Operands[Edge];
+                if (F.Instrs[Source].IsConstant() || Slot[Source] != Slot[Phi])
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void FIRLowering::EmitCopies(int32 Pred, int32 Target)
+    {
+        // Parallel copy: every source is read before any phi slot is written
+        const int32 Edge = PredIndex(Target, Pred);
+        TArray<int32> Destinations;
+        for (int32 Phi : F.Blocks[Target].Phis)
+        {
+            const FScriptIRInstr& Instr = F.Instrs[Phi];
+            if (!Instr.bRemoved)
+            {
+                const int32 Source = Instr.Operands[Edge];
+                if (F.Instrs[Source].IsConstant() || Slot[Source] != Slot[Phi])
+                {
+                    EmitValue(Source);
+                    Destinations.Add(Slot[Phi]);
+                }
+            }
+        }
+        for (int32 i = Destinations.Num() - 1; i >= 0; --i)
+        {
+            EmitSetLocalAndPop(Destinations[i]);
+        }
+    }
+
+    void FIRLowering::PatchForward(int32 Offset)
+    {
+        const int32 Jump = Chunk.Code.Num() - Offset - 2;
+        if (Jump > 0xFFFF)
+        {
+            Fail(TEXT("jump offset too large"));
+            return;
+        }
+        Chunk.Code[Offset] = (Jump >> 8) & 0xFF;
+        Chunk.Code[Offset + 1] = Jump & 0xFF;
+    }
+
+    void FIRLowering::EmitForwardOffset(int32 Target)
+    {
+        const int32 Offset = Chunk.Code.Num();
+        WriteByte(0xFF);
+        WriteByte(0xFF);
+        if (BlockAddress[Target] < 0)
+        {
+            PendingJumps[Target].Add(Offset);
+        }
+        else
+        {
+            // Already emitted: go through a stub that jumps back
+            FStub Stub;
+            Stub.PatchOffset = Offset;
+            Stub.Pred = -1;
+            Stub.Target = Target;
+            Stub.bPopCondition = false;
+            Stubs.Add(Stub);
+        }
+    }
+
+    void FIRLowering::EmitBackwardOffset(int32 Target)
+    {
+        const int32 Offset = Chunk.Code.Num() - BlockAddress[Target] + 2;
+        if (BlockAddress[Target] < 0 || Offset > 0xFFFF)
+        {
+            Fail(TEXT("loop body too large"));
+        }
+        WriteByte((Offset >> 8) & 0xFF);
+        WriteByte(Offset & 0xFF);
+    }
+
+    int32 FIRLowering::SkipEmptyBlocks(int32 Target) const
+    {
+        // Loop preheaders and exits are often empty once the optimizer is done with them
+        for (int32 Guard = 0; Guard < F.Blocks.Num(); ++Guard)
+        {
+            const FScriptIRBlock& Block = F.Blocks[Target];
+            if (Block.Terminator != EScriptIRTerminator::Jump || PopsCondition[Target] || NeedsCopies(Target, Block.Succs[0]))
+            {
+                break;
+            }
+            for (int32 Index : Block.Instrs)
+            {
+                if (IsRoot(Index))
+                {
+                    return Target;
+                }
+            }
+            Target = Block.Succs[0];
+        }
+        return Target;
+    }
+
+    void FIRLowering::EmitGoto(int32 Target)
+    {
+        const int32 Next = CurrentLayoutIndex + 1 < EmitOrder.Num() ? EmitOrder[CurrentLayoutIndex + 1] : -1;
+        if (Next == Target)
+        {
+            return; // Falls through
+        }
+        Target = SkipEmptyBlocks(Target);
+        if (Next == Target)
+        {
+            return;
+        }
+        if (BlockAddress[Target] >= 0)
+        {
+            EmitOp(EOpCode::OP_LOOP);
+            EmitBackwardOffset(Target);
+        }
+        else
+        {
+            EmitOp(EOpCode::OP_JUMP);
+            EmitForwardOffset(Target);
+        }
+    }
+
+    void FIRLowering::EmitBlock(int32 BlockIndex)
+    {
+        FlushPop();
+        BlockAddress[BlockIndex] = Chunk.Code.Num();
+        for (int32 Offset : PendingJumps[BlockIndex])
+        {
+            PatchForward(Offset);
+        }
+
+        const FScriptIRBlock& Block = F.Blocks[BlockIndex];
+        if (PopsCondition[BlockIndex])
+        {
+            CurrentLine = Block.Line;
+            CurrentFile = Block.File;
+            EmitOp(EOpCode::OP_POP);
+        }
+
+        for (int32 Index : Block.Instrs)
+        {
+            if (IsRoot(Index))
+            {
+                EmitRoot(Index);
+            }
+        }
+        EmitTerminator(BlockIndex);
+    }
+
+    void FIRLowering::EmitTerminator(int32 BlockIndex)
+    {
+        const FScriptIRBlock& Block = F.Blocks[BlockIndex];
+        switch (Block.Terminator)
+        {
+            case EScriptIRTerminator::Jump:
+                CurrentLine = Block.Line;
+                CurrentFile = Block.File;
+                EmitCopies(BlockIndex, Block.Succs[0]);
+                EmitGoto(Block.Succs[0]);
+                break;
+
+            case EScriptIRTerminator::Branch:
+            {
+                EmitValue(Block.Value);
+                CurrentLine = Block.Line;
+                CurrentFile = Block.File;
+                EmitOp(EOpCode::OP_JUMP_IF_FALSE);
+                const int32 False = Block.Succs[1];
+                if (PopsCondition[False])
+                {
+                    EmitForwardOffset(False);
+                }
+                else
+                {
+                    FStub Stub;
+                    Stub.PatchOffset = Chunk.Code.Num();
+                    Stub.Pred = BlockIndex;
+                    Stub.Target = False;
+                    Stub.bPopCondition = true;
+                    Stubs.Add(Stub);
+                    WriteByte(0xFF);
+                    WriteByte(0xFF);
+                }
+                EmitOp(EOpCode::OP_POP);
+                EmitCopies(BlockIndex, Block.Succs[0]);
+                EmitGoto(Block.Succs[0]);
+                break;
+            }
+
+            case EScriptIRTerminator::Return:
+            {
+                // 'return f(...)' reuses the frame, as in the direct compiler
+                const FScriptIRInstr& Value = F.Instrs[Block.Value];
+                if (Deferred[Block.Value] && Value.Op == EScriptIROp::Bytecode && Value.OpCode == EOpCode::OP_CALL)
+                {
+                    for (int32 Operand : Value.Operands)
+                    {
+                        EmitValue(Operand);
+                    }
+                    CurrentLine = Value.Line;
+                    CurrentFile = Value.File;
+                    EmitOp(EOpCode::OP_TAIL_CALL);
+                    WriteByte((uint8)Value.Imm);
+                    WriteByte((uint8)(Value.Imm2 >> 8));
+                    WriteByte((uint8)(Value.Imm2 & 0xFF));
+                }
+                else
+                {
+                    EmitValue(Block.Value);
+                }
+                CurrentLine = Block.Line;
+                CurrentFile = Block.File;
+                EmitOp(EOpCode::OP_RETURN);
+                break;
+            }
+
+            case EScriptIRTerminator::ForPrep:
+                CurrentLine = Block.Line;
+                CurrentFile = Block.File;
+                EmitOp(EOpCode::OP_FOR_PREP);
+                WriteByte((uint8)(F.Arity + Block.Slot));
+                WriteByte(Block.Flags);
+                EmitForwardOffset(SkipEmptyBlocks(Block.Succs[1]));
+                EmitGoto(Block.Succs[0]);
+                break;
+
+            case EScriptIRTerminator::ForLoop:
+                // The copies run on the exit path too: the phi slots are dead there
+                CurrentLine = Block.Line;
+                CurrentFile = Block.File;
+                EmitCopies(BlockIndex, Block.Succs[0]);
+                EmitOp(EOpCode::OP_FOR_LOOP);
+                WriteByte((uint8)(F.Arity + Block.Slot));
+                WriteByte(Block.Flags);
+                EmitBackwardOffset(Block.Succs[0]);
+                EmitGoto(Block.Succs[1]);
+                break;
+
+            case EScriptIRTerminator::ForEach:
+                CurrentLine = Block.Line;
+                CurrentFile = Block.File;
+                EmitOp(EOpCode::OP_FOREACH);
+                WriteByte((uint8)(F.Arity + Block.Slot));
+                EmitForwardOffset(SkipEmptyBlocks(Block.Succs[1]));
+                EmitGoto(Block.Succs[0]);
+                break;
+
+            default:
+                Fail(TEXT("block without terminator"));
+                break;
+        }
+    }
+
+    bool FIRFrameLayout::Analyze(FString& OutReason)
+    {
+        LayoutIndex.Init(-1, F.Blocks.Num());
+        for (int32 i = 0; i < F.Layout.Num(); ++i)
+        {
+            LayoutIndex[F.Layout[i]] = i;
+        }
+        if (F.Layout.Num() == 0 || F.Layout[0] != 0 || !Validate())
+        {
+            OutReason = bFailed ? FailReason : TEXT("no entry block");
+            return false;
+        }
+
+        CountUses();
+        ChooseDeferred();
+        ComputeLiveRanges();
+        if (!AllocateSlots())
+        {
+            OutReason = FailReason;
+            return false;
+        }
+        return true;
+    }
+
+    bool FIRLowering::Run(FString& OutReason)
+    {
+        if (!Analyze(OutReason))
+        {
+            return false;
+        }
+        F.NumSlots = NumSlots;
+
+        // Loop opcodes cannot carry copies on both edges
+        for (int32 BlockIndex : F.Layout)
+        {
+            const FScriptIRBlock& Block = F.Blocks[BlockIndex];
+            const bool bLoopOp = Block.Terminator == EScriptIRTerminator::ForPrep || Block.Terminator == EScriptIRTerminator::ForLoop ||
+                Block.Terminator == EScriptIRTerminator::ForEach;
+            if (bLoopOp && NeedsCopies(BlockIndex, Block.Succs[1]))
+            {
+                OutReason = TEXT("copies on a loop exit edge");
+                return false;
+            }
+            if (bLoopOp && Block.Terminator != EScriptIRTerminator::ForLoop && NeedsCopies(BlockIndex, Block.Succs[0]))
+            {
+                OutReason = TEXT("copies on a loop entry edge");
+                return false;
+            }
+        }
+
+        // A block entered only by earlier false branches pops their condition itself
+        PopsCondition.Init(false, F.Blocks.Num());
+        for (int32 BlockIndex : F.Layout)
+        {
+            const FScriptIRBlock& Block = F.Blocks[BlockIndex];
+            bool bPops = BlockIndex != 0 && Block.Preds.Num() > 0;
+            for (int32 Pred : Block.Preds)
+            {
+                const FScriptIRBlock& PredBlock = F.Blocks[Pred];
+                bPops &= PredBlock.Terminator == EScriptIRTerminator::Branch && PredBlock.Succs[1] == BlockIndex &&
+                    PredBlock.Succs[0] != BlockIndex && LayoutIndex[Pred] < LayoutIndex[BlockIndex] && !NeedsCopies(Pred, BlockIndex);
+            }
+            PopsCondition[BlockIndex] = bPops;
+        }
+
+        const int32 CodeStart = Chunk.Code.Num();
+        BlockAddress.Init(-1, F.Blocks.Num());
+        PendingJumps.SetNum(F.Blocks.Num());
+
+        // Prologue: the frame's slots beyond the arguments
+        const FScriptIRInstr* First = F.Blocks[0].Instrs.Num() > 0 ? &F.Instrs[F.Blocks[0].Instrs[0]] : nullptr;
+        CurrentLine = First ? First->Line : F.Blocks[0].Line;
+        CurrentFile = 0;
+        for (int32 i = F.Arity; i < NumSlots; ++i)
+        {
+            EmitOp(EOpCode::OP_NIL);
+        }
+
+        TArray<bool> LoopTarget;
+        LoopTarget.Init(false, F.Blocks.Num());
+        for (int32 BlockIndex : F.Layout)
+        {
+            if (F.Blocks[BlockIndex].Terminator == EScriptIRTerminator::ForLoop)
+            {
+                LoopTarget[F.Blocks[BlockIndex].Succs[0]] = true;
+            }
+        }
+        for (int32 BlockIndex : F.Layout)
+        {
+            if (BlockIndex == 0 || LoopTarget[BlockIndex] || SkipEmptyBlocks(BlockIndex) == BlockIndex)
+            {
+                EmitOrder.Add(BlockIndex);
+            }
+        }
+
+        for (CurrentLayoutIndex = 0; CurrentLayoutIndex < EmitOrder.Num(); ++CurrentLayoutIndex)
+        {
+            EmitBlock(EmitOrder[CurrentLayoutIndex]);
+        }
+
+        // Out-of-line edges: after the last block, which never falls through
+        for (int32 i = 0; i < Stubs.Num(); ++i)
+        {
+            const FStub Stub = Stubs[i];
+            const FScriptIRBlock& From = F.Blocks[Stub.Pred >= 0 ? Stub.Pred : Stub.Target];
+            FlushPop();
+            CurrentLine = From.Line;
+            CurrentFile = From.File;
+            PatchForward(Stub.PatchOffset);
+            if (Stub.bPopCondition)
+            {
+                EmitOp(EOpCode::OP_POP);
+            }
+            if (Stub.Pred >= 0)
+            {
+                EmitCopies(Stub.Pred, Stub.Target);
+            }
+            EmitGoto(Stub.Target);
+        }
+        FlushPop();
+
+        for (int32 BlockIndex = 0; BlockIndex < F.Blocks.Num(); ++BlockIndex)
+        {
+            if (BlockAddress[BlockIndex] < 0 && PendingJumps[BlockIndex].Num() > 0)
+            {
+                Fail(TEXT("jump to a block without code"));
+            }
+        }
+
+        if (bFailed)
+        {
+            Chunk.Code.SetNum(CodeStart);
+            #if !UE_BUILD_SHIPPING
+            Chunk.LineTable.Truncate(CodeStart);
+            #endif
+            OutReason = FailReason;
+            return false;
+        }
+        return true;
+    }
+
+    //-------------------------------------------------------------------------
+    // Register code
+    //-------------------------------------------------------------------------
+
+    /**
+     * Three-address code over the frame slots of the layout: every value is a register
+     * Literals get a register each, loaded once at entry. The last register is a scratch
+     * for results nothing reads and for breaking cycles in the phi copies.
+     */
+    class FIRRegisterLowering : public FIRFrameLayout
+    {
+    public:
+        FIRRegisterLowering(FScriptIRFunction& InFunction, FBytecodeChunk& InChunk)
+            : FIRFrameLayout(InFunction, false), Chunk(InChunk), Scratch(0), CurrentLayoutIndex(0)
+        {}
+
+        bool Run(int32& OutNumRegisters, FString& OutReason);
+
+    private:
+        /** A branch edge that needs copies: emitted after the last block */
+        struct FStub
+        {
+            int32 PatchOffset;
+            int32 Pred;
+            int32 Target;
+        };
+
+        FBytecodeChunk& Chunk;
+
+        TArray<int32> ConstantRegister;     // Register of a literal, -1 = not a literal
+        TArray<bool> Aliased;               // LoadSlot read straight from its pinned register
+        TArray<bool> Fused;                 // Emitted by the block terminator
+        int32 Scratch;
+
+        TArray<int32> BlockAddress;
+        TArray<TArray<int32>> PendingJumps;
+        TArray<FStub> Stubs;
+        TArray<int32> EmitOrder;
+        int32 CurrentLayoutIndex;
+
+        void WriteByte(uint8 Byte) { Chunk.RegisterCode.Add(Byte); }
+        void WriteShort(int32 Value)
+        {
+            WriteByte((uint8)((Value >> 8) & 0xFF));
+            WriteByte((uint8)(Value & 0xFF));
+        }
+        void EmitOp(ERegOpCode OpCode) { WriteByte((uint8)OpCode); }
+
+        int32 Reg(int32 Value) const;
+        int32 DestReg(int32 Index) const { return Slot[Index] >= 0 ? Slot[Index] : Scratch; }
+        bool IsCompare(int32 Index) const;
+        int32 AssignConstants();
+        void ChooseAliases();
+        void ChooseFused();
+        void EmitRegisterList(const TArray<int32>& Operands);
+        void EmitRoot(int32 Index);
+        void EmitMove(int32 Dest, int32 Source);
+        void EmitCopies(int32 Pred, int32 Target);
+        void EmitJumpOffset(int32 Target);
+        void PatchJump(int32 Offset, int32 Target);
+        void EmitGoto(int32 Target);
+        int32 SkipEmptyBlocks(int32 Target) const;
+        bool HasCode(int32 BlockIndex) const;
+        void EmitBlock(int32 BlockIndex);
+        void EmitTerminator(int32 BlockIndex);
+    };
+
+    int32 FIRRegisterLowering::Reg(int32 Value) const
+    {
+        if (ConstantRegister[Value] >= 0)
+        {
+            return ConstantRegister[Value];
+        }
+        if (Aliased[Value])
+        {
+            return F.Arity + F.Instrs[Value].Imm;
+        }
+        return Slot[Value];
+    }
+
+    bool FIRRegisterLowering::IsCompare(int32 Index) const
+    {
+        const FScriptIRInstr& Instr = F.Instrs[Index];
+        return Instr.Op == EScriptIROp::Bytecode && (Instr.OpCode == EOpCode::OP_EQUAL ||
+            Instr.OpCode == EOpCode::OP_LESS || Instr.OpCode == EOpCode::OP_GREATER);
+    }
+
+    int32 FIRRegisterLowering::AssignConstants()
+    {
+        // One register per distinct literal
+        ConstantRegister.Init(-1, F.Instrs.Num());
+        TArray<int32> Literals;
+        for (int32 Index = 0; Index < F.Instrs.Num(); ++Index)
+        {
+            const FScriptIRInstr& Instr = F.Instrs[Index];
+            if (Instr.bRemoved || !Instr.IsConstant() || UseCount[Index] == 0)
+            {
+                continue;
+            }
+            for (int32 Literal : Literals)
+            {
+                const FScriptIRInstr& Other = F.Instrs[Literal];
+                if (Other.OpCode == Instr.OpCode && Other.Imm == Instr.Imm)
+                {
+                    ConstantRegister[Index] = ConstantRegister[Literal];
+                    break;
+                }
+            }
+            if (ConstantRegister[Index] < 0)
+            {
+                ConstantRegister[Index] = NumSlots + Literals.Num();
+                Literals.Add(Index);
+            }
+        }
+        Scratch = NumSlots + Literals.Num();
+        return Literals.Num();
+    }
+
+    void FIRRegisterLowering::ChooseAliases()
+    {
+        // A pinned slot read only in its own block, before anything stores to the slot
+        // again, needs no copy: the block terminator is the only other writer
+        Aliased.Init(false, F.Instrs.Num());
+        for (int32 BlockIndex : F.Layout)
+        {
+            const FScriptIRBlock& Block = F.Blocks[BlockIndex];
+            for (int32 i = 0; i < Block.Instrs.Num(); ++i)
+            {
+                const int32 Index = Block.Instrs[i];
+                const FScriptIRInstr& Instr = F.Instrs[Index];
+                if (Instr.bRemoved || Instr.Op != EScriptIROp::LoadSlot || User[Index] == -2)
+                {
+                    continue;
+                }
+
+                // Uses left to see, counting the terminator
+                int32 Remaining = UseCount[Index] - (TerminatorValue(Block) == Index ? 1 : 0);
+                bool bAlias = true;
+                for (int32 j = i + 1; j < Block.Instrs.Num() && Remaining > 0 && bAlias; ++j)
+                {
+                    const FScriptIRInstr& Later = F.Instrs[Block.Instrs[j]];
+                    if (Later.bRemoved)
+                    {
+                        continue;
+                    }
+                    for (int32 Operand : Later.Operands)
+                    {
+                        Remaining -= (Operand == Index) ? 1 : 0;
+                    }
+                    if (Later.Op == EScriptIROp::StoreSlot && Later.Imm == Instr.Imm && Remaining > 0)
+                    {
+                        bAlias = false;
+                    }
+                }
+                // Any use left over is in another block or a phi
+                Aliased[Index] = bAlias && Remaining == 0;
+            }
+        }
+    }
+
+    void FIRRegisterLowering::ChooseFused()
+    {
+        // A condition computed last in its block, for the branch only, becomes a compare-and-jump;
+        // 'return f(...)' becomes a tail call
+        Fused.Init(false, F.Instrs.Num());
+        for (int32 BlockIndex : F.Layout)
+        {
+            const FScriptIRBlock& Block = F.Blocks[BlockIndex];
+            const int32 Value = TerminatorValue(Block);
+            if (Value < 0 || UseCount[Value] != 1 || User[Value] != -1)
+            {
+                continue;
+            }
+
+            TArray<int32> Roots;
+            for (int32 Index : Block.Instrs)
+            {
+                if (IsRoot(Index) && !Aliased[Index])
+                {
+                    Roots.Add(Index);
+                }
+            }
+            if (Roots.Num() == 0 || Roots.Last() != Value)
+            {
+                continue;
+            }
+
+            const FScriptIRInstr& Instr = F.Instrs[Value];
+            if (Block.Terminator == EScriptIRTerminator::Return)
+            {
+                Fused[Value] = Instr.Op == EScriptIROp::Bytecode && Instr.OpCode == EOpCode::OP_CALL;
+                continue;
+            }
+            if (IsCompare(Value))
+            {
+                Fused[Value] = true;
+            }
+            else if (Instr.Op == EScriptIROp::Bytecode && Instr.OpCode == EOpCode::OP_NOT)
+            {
+                Fused[Value] = true;
+                const int32 Operand = Instr.Operands[0];
+                if (Roots.Num() >= 2 && Roots[Roots.Num() - 2] == Operand && IsCompare(Operand) && UseCount[Operand] == 1)
+                {
+                    Fused[Operand] = true;
+                }
+            }
+        }
+    }
+
+    void FIRRegisterLowering::EmitRegisterList(const TArray<int32>& Operands)
+    {
+        WriteByte((uint8)Operands.Num());
+        for (int32 Operand : Operands)
+        {
+            WriteByte((uint8)Reg(Operand));
+        }
+    }
+
+    void FIRRegisterLowering::EmitMove(int32 Dest, int32 Source)
+    {
+        if (Dest != Source)
+        {
+            EmitOp(ERegOpCode::REG_MOVE);
+            WriteByte((uint8)Dest);
+            WriteByte((uint8)Source);
+        }
+    }
+
+    void FIRRegisterLowering::EmitRoot(int32 Index)
+    {
+        const FScriptIRInstr& Instr = F.Instrs[Index];
+        if (Instr.Op == EScriptIROp::LoadSlot)
+        {
+            if (UseCount[Index] > 0)
+            {
+                EmitMove(Slot[Index], F.Arity + Instr.Imm);
+            }
+            return;
+        }
+        if (Instr.Op == EScriptIROp::StoreSlot)
+        {
+            EmitMove(F.Arity + Instr.Imm, Reg(Instr.Operands[0]));
+            return;
+        }
+
+        const int32 Dest = DestReg(Index);
+        ERegOpCode OpCode = ERegOpCode::REG_OPCODE_COUNT;
+        switch (Instr.OpCode)
+        {
+            case EOpCode::OP_ADD:           OpCode = ERegOpCode::REG_ADD; break;
+            case EOpCode::OP_SUBTRACT:      OpCode = ERegOpCode::REG_SUBTRACT; break;
+            case EOpCode::OP_MULTIPLY:      OpCode = ERegOpCode::REG_MULTIPLY; break;
+            case EOpCode::OP_DIVIDE:        OpCode = ERegOpCode::REG_DIVIDE; break;
+            case EOpCode::OP_MODULO:        OpCode = ERegOpCode::REG_MODULO; break;
+            case EOpCode::OP_EQUAL:         OpCode = ERegOpCode::REG_EQUAL; break;
+            case EOpCode::OP_GREATER:       OpCode = ERegOpCode::REG_GREATER; break;
+            case EOpCode::OP_LESS:          OpCode = ERegOpCode::REG_LESS; break;
+            case EOpCode::OP_AND:           OpCode = ERegOpCode::REG_AND; break;
+            case EOpCode::OP_OR:            OpCode = ERegOpCode::REG_OR; break;
+            case EOpCode::OP_BIT_AND:       OpCode = ERegOpCode::REG_BIT_AND; break;
+            case EOpCode::OP_BIT_OR:        OpCode = ERegOpCode::REG_BIT_OR; break;
+            case EOpCode::OP_BIT_XOR:       OpCode = ERegOpCode::REG_BIT_XOR; break;
+            case EOpCode::OP_GET_ELEMENT:   OpCode = ERegOpCode::REG_GET_ELEMENT; break;
+            case EOpCode::OP_SET_ELEMENT:   OpCode = ERegOpCode::REG_SET_ELEMENT; break;
+            case EOpCode::OP_NEGATE:        OpCode = ERegOpCode::REG_NEGATE; break;
+            case EOpCode::OP_NOT:           OpCode = ERegOpCode::REG_NOT; break;
+            case EOpCode::OP_BIT_NOT:       OpCode = ERegOpCode::REG_BIT_NOT; break;
+            case EOpCode::OP_CAST_INT:      OpCode = ERegOpCode::REG_CAST_INT; break;
+            case EOpCode::OP_CAST_FLOAT:    OpCode = ERegOpCode::REG_CAST_FLOAT; break;
+            case EOpCode::OP_CAST_STRING:   OpCode = ERegOpCode::REG_CAST_STRING; break;
+
+            case EOpCode::OP_GET_GLOBAL:
+                EmitOp(ERegOpCode::REG_GET_GLOBAL);
+                WriteByte((uint8)Dest);
+                WriteShort(Instr.Imm);
+                return;
+
+            case EOpCode::OP_SET_GLOBAL:
+                // Assignment is an expression: its value is the value stored
+                EmitOp(ERegOpCode::REG_SET_GLOBAL);
+                WriteByte((uint8)Reg(Instr.Operands[0]));
+                WriteShort(Instr.Imm);
+                if (Slot[Index] >= 0)
+                {
+                    EmitMove(Slot[Index], Reg(Instr.Operands[0]));
+                }
+                return;
+
+            case EOpCode::OP_CALL:
+                EmitOp(ERegOpCode::REG_CALL);
+                WriteByte((uint8)Dest);
+                WriteShort(Instr.Imm2);
+                EmitRegisterList(Instr.Operands);
+                return;
+
+            case EOpCode::OP_CALL_NATIVE:
+                EmitOp(ERegOpCode::REG_CALL_NATIVE);
+                WriteByte((uint8)Dest);
+                WriteByte((uint8)(Instr.Imm & ~NATIVE_CALL_ARGC_MASK));
+                WriteShort(Instr.Imm2);
+                EmitRegisterList(Instr.Operands);
+                return;
+
+            case EOpCode::OP_CREATE_ARRAY:
+                EmitOp(ERegOpCode::REG_CREATE_ARRAY);
+                WriteByte((uint8)Dest);
+                EmitRegisterList(Instr.Operands);
+                return;
+
+            case EOpCode::OP_GET_FIELD:
+            case EOpCode::OP_SET_FIELD:
+                EmitOp(Instr.OpCode == EOpCode::OP_GET_FIELD ? ERegOpCode::REG_GET_FIELD : ERegOpCode::REG_SET_FIELD);
+                WriteByte((uint8)Dest);
+                for (int32 Operand : Instr.Operands)
+                {
+                    WriteByte((uint8)Reg(Operand));
+                }
+                WriteShort(Instr.Imm);
+                return;
+
+            default:
+                Fail(FString::Printf(TEXT("no register form for opcode %d"), (int32)Instr.OpCode));
+                return;
+        }
+
+        EmitOp(OpCode);
+        WriteByte((uint8)Dest);
+        for (int32 Operand : Instr.Operands)
+        {
+            WriteByte((uint8)Reg(Operand));
+        }
+    }
+
+    void FIRRegisterLowering::EmitCopies(int32 Pred, int32 Target)
+    {
+        // Parallel copy, sequentialized: a copy goes once nothing still pending reads its
+        // destination; a cycle is broken by parking one source in the scratch register
+        const int32 Edge = PredIndex(Target, Pred);
+        TArray<TPair<int32, int32>> Pending;    // Destination, source
+        for (int32 Phi : F.Blocks[Target].Phis)
+        {
+            if (!F.Instrs[Phi].bRemoved)
+            {
+                const int32 Source = Reg(F.Instrs[Phi].Operands[Edge]);
+                if (Source != Slot[Phi])
+                {
+                    Pending.Add(TPair<int32, int32>(Slot[Phi], Source));
+                }
+            }
+        }
+
+        while (Pending.Num() > 0)
+        {
+            bool bProgress = false;
+            for (int32 i = 0; i < Pending.Num(); ++i)
+            {
+                bool bRead = false;
+                for (int32 j = 0; j < Pending.Num() && !bRead; ++j)
+                {
+                    bRead = j != i && Pending[j].Value == Pending[i].Key;
+                }
+                if (!bRead)
+                {
+                    EmitMove(Pending[i].Key, Pending[i].Value);
+                    Pending.RemoveAt(i);
+                    bProgress = true;
+                    break;
+                }
+            }
+            if (!bProgress)
+            {
+                EmitMove(Scratch, Pending[0].Value);
+                Pending[0].Value = Scratch;
+            }
+        }
+    }
+
+    void FIRRegisterLowering::PatchJump(int32 Offset, int32 Target)
+    {
+        const int32 Jump = Target - (Offset + 2);
+        if (Jump < -32768 || Jump > 32767)
+        {
+            Fail(TEXT("jump offset too large"));
+            return;
+        }
+        Chunk.RegisterCode[Offset] = (uint8)((Jump >> 8) & 0xFF);
+        Chunk.RegisterCode[Offset + 1] = (uint8)(Jump & 0xFF);
+    }
+
+    void FIRRegisterLowering::EmitJumpOffset(int32 Target)
+    {
+        const int32 Offset = Chunk.RegisterCode.Num();
+        WriteShort(0);
+        if (BlockAddress[Target] >= 0)
+        {
+            PatchJump(Offset, BlockAddress[Target]);
+        }
+        else
+        {
+            PendingJumps[Target].Add(Offset);
+        }
+    }
+
+    bool FIRRegisterLowering::HasCode(int32 BlockIndex) const
+    {
+        for (int32 Index : F.Blocks[BlockIndex].Instrs)
+        {
+            if (IsRoot(Index) && !Aliased[Index] && !Fused[Index])
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int32 FIRRegisterLowering::SkipEmptyBlocks(int32 Target) const
+    {
+        for (int32 Guard = 0; Guard < F.Blocks.Num(); ++Guard)
+        {
+            const FScriptIRBlock& Block = F.Blocks[Target];
+            if (Block.Terminator != EScriptIRTerminator::Jump || NeedsCopies(Target, Block.Succs[0]) || HasCode(Target))
+            {
+                break;
+            }
+            Target = Block.Succs[0];
+        }
+        return Target;
+    }
+
+    void FIRRegisterLowering::EmitGoto(int32 Target)
+    {
+        const int32 Next = CurrentLayoutIndex + 1 < EmitOrder.Num() ? EmitOrder[CurrentLayoutIndex + 1] : -1;
+        Target = SkipEmptyBlocks(Target);
+        if (Next != Target)
+        {
+            EmitOp(ERegOpCode::REG_JUMP);
+            EmitJumpOffset(Target);
+        }
+    }
+
+    void FIRRegisterLowering::EmitBlock(int32 BlockIndex)
+    {
+        BlockAddress[BlockIndex] = Chunk.RegisterCode.Num();
+        for (int32 Offset : PendingJumps[BlockIndex])
+        {
+            PatchJump(Offset, BlockAddress[BlockIndex]);
+        }
+        PendingJumps[BlockIndex].Empty();
+
+        for (int32 Index : F.Blocks[BlockIndex].Instrs)
+        {
+            if (IsRoot(Index) && !Aliased[Index] && !Fused[Index])
+            {
+                EmitRoot(Index);
+            }
+        }
+        EmitTerminator(BlockIndex);
+    }
+
+    void FIRRegisterLowering::EmitTerminator(int32 BlockIndex)
+    {
+        const FScriptIRBlock& Block = F.Blocks[BlockIndex];
+        switch (Block.Terminator)
+        {
+            case EScriptIRTerminator::Jump:
+                EmitCopies(BlockIndex, Block.Succs[0]);
+                EmitGoto(Block.Succs[0]);
+                break;
+
+            case EScriptIRTerminator::Branch:
+            {
+                // Jump to the false edge, fall into the true one
+                const FScriptIRInstr& Value = F.Instrs[Block.Value];
+                if (Fused[Block.Value] && IsCompare(Block.Value))
+                {
+                    EmitOp(Value.OpCode == EOpCode::OP_EQUAL ? ERegOpCode::REG_JUMP_IF_NOT_EQUAL :
+                        Value.OpCode == EOpCode::OP_LESS ? ERegOpCode::REG_JUMP_IF_NOT_LESS : ERegOpCode::REG_JUMP_IF_NOT_GREATER);
+                    WriteByte((uint8)Reg(Value.Operands[0]));
+                    WriteByte((uint8)Reg(Value.Operands[1]));
+                }
+                else if (Fused[Block.Value] && Fused[Value.Operands[0]])
+                {
+                    const FScriptIRInstr& Compare = F.Instrs[Value.Operands[0]];
+                    EmitOp(Compare.OpCode == EOpCode::OP_EQUAL ? ERegOpCode::REG_JUMP_IF_EQUAL :
+                        Compare.OpCode == EOpCode::OP_LESS ? ERegOpCode::REG_JUMP_IF_LESS : ERegOpCode::REG_JUMP_IF_GREATER);
+                    WriteByte((uint8)Reg(Compare.Operands[0]));
+                    WriteByte((uint8)Reg(Compare.Operands[1]));
+                }
+                else if (Fused[Block.Value])
+                {
+                    EmitOp(ERegOpCode::REG_JUMP_IF_TRUE);
+                    WriteByte((uint8)Reg(Value.Operands[0]));
+                }
+                else
+                {
+                    EmitOp(ERegOpCode::REG_JUMP_IF_FALSE);
+                    WriteByte((uint8)Reg(Block.Value));
+                }
+
+                const int32 False = Block.Succs[1];
+                if (NeedsCopies(BlockIndex, False))
+                {
+                    FStub Stub;
+                    Stub.PatchOffset = Chunk.RegisterCode.Num();
+                    Stub.Pred = BlockIndex;
+                    Stub.Target = False;
+                    Stubs.Add(Stub);
+                    WriteShort(0);
+                }
+                else
+                {
+                    EmitJumpOffset(SkipEmptyBlocks(False));
+                }
+                EmitCopies(BlockIndex, Block.Succs[0]);
+                EmitGoto(Block.Succs[0]);
+                break;
+            }
+
+            case EScriptIRTerminator::Return:
+            {
+                const FScriptIRInstr& Value = F.Instrs[Block.Value];
+                if (Fused[Block.Value])
+                {
+                    EmitOp(ERegOpCode::REG_TAIL_CALL);
+                    WriteShort(Value.Imm2);
+                    EmitRegisterList(Value.Operands);
+                }
+                else
+                {
+                    EmitOp(ERegOpCode::REG_RETURN);
+                    WriteByte((uint8)Reg(Block.Value));
+                }
+                break;
+            }
+
+            case EScriptIRTerminator::ForPrep:
+                EmitOp(ERegOpCode::REG_FOR_PREP);
+                WriteByte((uint8)(F.Arity + Block.Slot));
+                WriteByte(Block.Flags);
+                EmitJumpOffset(SkipEmptyBlocks(Block.Succs[1]));
+                EmitGoto(Block.Succs[0]);
+                break;
+
+            case EScriptIRTerminator::ForLoop:
+                // The copies run on the exit path too: the phi registers are dead there
+                EmitCopies(BlockIndex, Block.Succs[0]);
+                EmitOp(ERegOpCode::REG_FOR_LOOP);
+                WriteByte((uint8)(F.Arity + Block.Slot));
+                WriteByte(Block.Flags);
+                EmitJumpOffset(SkipEmptyBlocks(Block.Succs[0]));
+                EmitGoto(Block.Succs[1]);
+                break;
+
+            case EScriptIRTerminator::ForEach:
+                EmitOp(ERegOpCode::REG_FOREACH);
+                WriteByte((uint8)(F.Arity + Block.Slot));
+                EmitJumpOffset(SkipEmptyBlocks(Block.Succs[1]));
+                EmitGoto(Block.Succs[0]);
+                break;
+
+            default:
+                Fail(TEXT("block without terminator"));
+                break;
+        }
+    }
+
+    bool FIRRegisterLowering::Run(int32& OutNumRegisters, FString& OutReason)
+    {
+        if (!Analyze(OutReason))
+        {
+            return false;
+        }
+
+        for (int32 BlockIndex : F.Layout)
+        {
+            const FScriptIRBlock& Block = F.Blocks[BlockIndex];
+            const bool bLoopOp = Block.Terminator == EScriptIRTerminator::ForPrep || Block.Terminator == EScriptIRTerminator::ForLoop ||
+                Block.Terminator == EScriptIRTerminator::ForEach;
+            if (bLoopOp && (NeedsCopies(BlockIndex, Block.Succs[1]) ||
+                (Block.Terminator != EScriptIRTerminator::ForLoop && NeedsCopies(BlockIndex, Block.Succs[0]))))
+            {
+                OutReason = TEXT("copies on a loop edge");
+                return false;
+            }
+        }
+
+        // K operands are 16-bit, with no wide form
+        for (const FScriptIRInstr& Instr : F.Instrs)
+        {
+            const bool bConstantImm = Instr.OpCode == EOpCode::OP_CONSTANT || Instr.OpCode == EOpCode::OP_GET_GLOBAL ||
+                Instr.OpCode == EOpCode::OP_SET_GLOBAL || Instr.OpCode == EOpCode::OP_GET_FIELD || Instr.OpCode == EOpCode::OP_SET_FIELD;
+            if (!Instr.bRemoved && Instr.Op == EScriptIROp::Bytecode && ((bConstantImm && Instr.Imm > 0xFFFF) ||
+                (Instr.OpCode == EOpCode::OP_CALL_NATIVE && Instr.Imm2 > 0xFFFF)))
+            {
+                OutReason = TEXT("constant index past 16 bits");
+                return false;
+            }
+        }
+
+        const int32 NumLiterals = AssignConstants();
+        const int32 NumRegisters = Scratch + 1;
+        if (NumRegisters > 256)
+        {
+            OutReason = FString::Printf(TEXT("needs %d registers"), NumRegisters);
+            return false;
+        }
+        ChooseAliases();
+        ChooseFused();
+
+        const int32 CodeStart = Chunk.RegisterCode.Num();
+        BlockAddress.Init(-1, F.Blocks.Num());
+        PendingJumps.SetNum(F.Blocks.Num());
+
+        // Prologue: the literals
+        TArray<bool> Loaded;
+        Loaded.Init(false, NumLiterals);
+        for (int32 Index = 0; Index < F.Instrs.Num(); ++Index)
+        {
+            const int32 Register = ConstantRegister[Index];
+            if (Register < 0 || Loaded[Register - NumSlots])
+            {
+                continue;
+            }
+            Loaded[Register - NumSlots] = true;
+            const FScriptIRInstr& Instr = F.Instrs[Index];
+            switch (Instr.OpCode)
+            {
+                case EOpCode::OP_CONSTANT:
+                    EmitOp(ERegOpCode::REG_LOAD_CONSTANT);
+                    WriteByte((uint8)Register);
+                    WriteShort(Instr.Imm);
+                    break;
+                case EOpCode::OP_TRUE:  EmitOp(ERegOpCode::REG_LOAD_TRUE); WriteByte((uint8)Register); break;
+                case EOpCode::OP_FALSE: EmitOp(ERegOpCode::REG_LOAD_FALSE); WriteByte((uint8)Register); break;
+                default:                EmitOp(ERegOpCode::REG_LOAD_NIL); WriteByte((uint8)Register); break;
+            }
+        }
+
+        for (int32 BlockIndex : F.Layout)
+        {
+            if (BlockIndex == 0 || SkipEmptyBlocks(BlockIndex) == BlockIndex)
+            {
+                EmitOrder.Add(BlockIndex);
+            }
+        }
+        for (CurrentLayoutIndex = 0; CurrentLayoutIndex < EmitOrder.Num(); ++CurrentLayoutIndex)
+        {
+            EmitBlock(EmitOrder[CurrentLayoutIndex]);
+        }
+
+        // Out-of-line edges: after the last block, which never falls through
+        for (int32 i = 0; i < Stubs.Num(); ++i)
+        {
+            PatchJump(Stubs[i].PatchOffset, Chunk.RegisterCode.Num());
+            EmitCopies(Stubs[i].Pred, Stubs[i].Target);
+            EmitGoto(Stubs[i].Target);
+        }
+
+        for (int32 BlockIndex = 0; BlockIndex < F.Blocks.Num(); ++BlockIndex)
+        {
+            if (PendingJumps[BlockIndex].Num() > 0)
+            {
+                Fail(TEXT("jump to a block without code"));
+            }
+        }
+
+        if (bFailed)
+        {
+            Chunk.RegisterCode.SetNum(CodeStart);
+            OutReason = FailReason;
+            return false;
+        }
+        OutNumRegisters = NumRegisters;
+        return true;
+    }
+}
+
+bool FScriptIRLowering::Lower(FScriptIRFunction& Function, FBytecodeChunk& Chunk, FString& OutReason)
+{
+    FIRLowering Lowering(Function, Chunk);
+    return Lowering.Run(OutReason);
+}
+
+bool FScriptIRRegisterLowering::Lower(FScriptIRFunction& Function, FBytecodeChunk& Chunk, int32& OutNumRegisters, FString& OutReason)
+{
+    FIRRegisterLowering Lowering(Function, Chunk);
+    return Lowering.Run(OutNumRegisters, OutReason);
+}
@@ -7,17 +7,105 @@
 #include "ScriptToken.h"
 
 /**
- * Lexer/Scanner for the scripting language
- * Converts source code into tokens
+ * Lexer/Scanner for the SBS/SBSH scripting language
+ * ==================================================
+ * 
+ * The Lexer (also called Scanner or Tokenizer) is the FIRST STAGE of the compilation pipeline.
+ * It reads raw source code text and breaks it down into meaningful chunks called TOKENS.
+ * 
+ * WHAT THE LEXER DOES:
+ * -------------------
+ * Input:  Raw text source code (e.g., "int x = 10 + 20;")
+ * Output: Array of tokens (e.g., [INT, IDENTIFIER("x"), EQUAL, NUMBER("10"), PLUS, NUMBER("20"), SEMICOLON])
+ * 
+ * The lexer performs:
+ * 1. Character-by-character scanning of source code
+ * 2. Recognition of keywords, identifiers, operators, literals, and punctuation
+ * 3. Skipping whitespace and comments
+ * 4. Tracking line/column numbers for error reporting
+ * 5. Detecting lexical errors (e.g., unterminated strings, invalid characters)
+ * 
+ * SBS/SBSH LANGUAGE SYNTAX EXPECTATIONS:
+ * =====================================
+ * 
+ * COMMENTS:
+ *   // Single-line comment
+ *   Block comments, slash-star ... star-slash, may span lines
+ * 
+ * DATA TYPES:
+ *   int      - Integer numbers
+ *   float    - Floating point numbers
+ *   string   - Text strings in double quotes
+ *   bool     - true/false values
+ *   void     - No return value (for functions)
+ * 
+ * ARRAYS:
+ *   int[]    - Array of integers
+ *   float[]  - Array of floats
+ *   string[] - Array of strings
+ * 
+ * OPERATORS:
+ *   Arithmetic: + - * / %
+ *   Comparison: == != < > <= >=
+ *   Logical:    && || !
+ *   Bitwise:    & | ^ ~ 
+ *   Assignment: =
+ * 
+ * PUNCTUATION:
+ *   () [] {}  - Parentheses, brackets, braces
+ *   ; , .     - Semicolon, comma, dot
+ *   :         - Colon (for future use)
+ * 
+ * LITERALS:
+ *   123       - Integer literal
+ *   3.14      - Float literal
+ *   "hello"   - String literal
+ *   true/false- Boolean literals
+ * 
+ * IDENTIFIERS:
+ *   Must start with letter or underscore: myVar, _internal, Player1
+ *   Can contain letters, digits, underscores: health_points, maxHP_100
+ * 
+ * KEYWORDS (Reserved words that cannot be used as identifiers):
+ *   Control flow: if, else, while, for, do, switch, case, default, break, continue
+ *   Functions:    return, void, function
+ *   Variables:    int, float, string, var, const
+ *   Future use:   struct, class, enum, typedef, import, public, private
+ * 
+ * EXAMPLE INPUT/OUTPUT:
+ * --------------------
+ * 
+ * Source Code:
+ *   int Add(int a, int b) {
+ *       return a + b;
+ *   }
+ * 
+ * Tokens Generated:
+ *   INT, IDENTIFIER("Add"), LEFT_PAREN, INT, IDENTIFIER("a"), COMMA, 
+ *   INT, IDENTIFIER("b"), RIGHT_PAREN, LEFT_BRACE, RETURN, IDENTIFIER("a"),
+ *   PLUS, IDENTIFIER("b"), SEMICOLON, RIGHT_BRACE
+ * 
+ * ERROR DETECTION EXAMPLES:
+ * ------------------------
+ * - Unterminated string: "hello
+ * - Invalid character: int x @ 10;
+ * - Invalid number format: 3.14.15
  */
 class SCRIPTING_API FScriptLexer
 {
 public:
     FScriptLexer(const FString& InSource);
     
-    /** Tokenize the entire source code */
+    /** Tokenize the entire source code (moves the tokens out: call once) */
     TArray<FScriptToken> ScanTokens();
     
+    /**
+     * Scan the next token, for a parser pulling tokens as it goes (FScriptParser(FScriptLexer&)).
+     * Returns END_OF_FILE at the end, and again on every later call. Errors collect as the
+     * tokens are scanned, so check HasErrors after parsing.
+     */
+    FScriptToken NextToken();
+    
     /** Get all error messages */
     const TArray<FString>& GetErrors() const { return Errors; }
     
@@ -43,7 +131,7 @@ private:
     
     void ScanToken();
     void AddToken(ETokenType Type);
-    void AddToken(ETokenType Type, const FString& Lexeme);
+    void AddToken(ETokenType Type, FString Lexeme);
     void ScanString();
     void ScanNumber();
     void ScanIdentifier();
@@ -53,6 +141,6 @@ private:
     static bool IsDigit(char C);
     static bool IsAlpha(char C);
     static bool IsAlphaNumeric(char C);
-    static ETokenType GetKeywordType(const FString& Text);
+    static ETokenType GetKeywordType(const TCHAR* Text, int32 Length);
 };
 
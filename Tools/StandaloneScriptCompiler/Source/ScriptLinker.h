@@ -0,0 +1,181 @@
+// Copyright Vampire Game Project. All Rights Reserved.
+// Custom scripting system for secure modding support.
+
+#pragma once
+
+#include "Platform.h"
+#include "ScriptAST.h"
+#include "ScriptBytecode.h"
+
+/**
+ * A function a module defines, as its importers see it
+ */
+struct SCRIPTING_API FScriptModuleExport
+{
+    FString Name;
+    int32 Arity;
+    EScriptType ReturnType;
+
+    FScriptModuleExport()
+        : Arity(0), ReturnType(EScriptType::VOID)
+    {}
+
+    FScriptModuleExport(const FString& InName, int32 InArity, EScriptType InReturnType)
+        : Name(InName), Arity(InArity), ReturnType(InReturnType)
+    {}
+};
+
+/**
+ * Script Modules and Linking
+ * ==========================
+ *
+ * Without a module cache every script compiles the headers it imports into its own
+ * chunk, so a header imported by fifty scripts is lexed, parsed and compiled fifty times.
+ * With one (FScriptCompiler::SetModuleCache) each header is compiled once into a module:
+ *
+ *   - Chunk: the header's functions, compiled as a unit of their own. Every constant
+ *     operand takes the _WIDE (24-bit) form so the linker can renumber it in place.
+ *   - Exports: the functions it defines.
+ *   - External function entries (FFunctionInfo::Module set) for what it calls in the
+ *     modules it imports, filled in when linking.
+ *
+ * A script compiled against the cache calls imported functions through external entries
+ * too. FScriptLinker::Link then appends the code of every module the script needs to a
+ * copy of its chunk, merges the constant pools, renumbers the constant and function
+ * operands of the appended code and points the external entries at the definitions.
+ * The result runs like a chunk compiled in one piece.
+ *
+ * Modules are also object files (.sbo, see Serialize): a build can keep them and link
+ * later, or the standalone compiler can load and link them when it runs a script.
+ *
+ * Header artifacts (.sbh, see FScriptModuleCache::SetArtifactDir) carry a module across
+ * builds: the module object behind a key hashed from the header's source, the compiler
+ * options and the keys of the modules it imports. A later build reads the header source,
+ * checks the key and loads the module without lexing, parsing or compiling the header.
+ * Changing a header changes its key and so the key of every header importing it,
+ * directly or not, since their code may have inlined it.
+ *
+ * Limits:
+ * - Inlining across modules needs the module's AST (Program), so only modules compiled
+ *   in this process are inlined; loaded objects and artifacts are always called.
+ * - Headers in an import cycle get no artifact: their key would depend on itself.
+ * - Globals need no linking: they are looked up by name at run time. The top-level code
+ *   of a header is ignored, as it is when the header is compiled in.
+ */
+struct SCRIPTING_API FScriptModule
+{
+    FString Path;                       // Import path, e.g. "ScriptHeaders/Util.sbsh"
+    TSharedPtr<FBytecodeChunk> Chunk;
+    TArray<FString> Imports;            // Direct imports, as module paths
+    TArray<FScriptModuleExport> Exports;
+    TSharedPtr<FScriptProgram> Program; // AST for inlining, only when compiled in this process
+
+    const FScriptModuleExport* FindExport(const FString& Name) const;
+
+    /** Declaration of an exported function, nullptr without the AST */
+    FFunctionDecl* FindFunctionDecl(const FString& Name) const;
+
+    /** Write as a module object (.sbo): code, debug info, constants and function table */
+    void Serialize(TArray<uint8>& OutData) const;
+
+    /** Read a module object written by Serialize */
+    bool Deserialize(const TArray<uint8>& InData, FString& OutError);
+};
+
+/**
+ * The modules of one build, each compiled (or loaded) once and shared by every script
+ * that imports it.
+ *
+ * Scripts may compile against one cache from several threads (FScriptBatchCompiler).
+ * GetOrCompile holds the cache's lock while it compiles a module, so a header two
+ * scripts import is still compiled once, by whichever asks first; the other waits for
+ * it. The lock is recursive: the module's own imports come back through GetOrCompile on
+ * the same thread. Setters and GetModules are for before and after compiling.
+ */
+class SCRIPTING_API FScriptModuleCache
+{
+public:
+    FScriptModuleCache();
+
+    /**
+     * The module for an import path, compiled on first use
+     * @return nullptr on errors, or without errors while the module is itself still being
+     *         compiled (a circular import, skipped as when headers are compiled in)
+     */
+    TSharedPtr<const FScriptModule> GetOrCompile(const FString& ModulePath, TArray<FString>& OutErrors);
+
+    TSharedPtr<const FScriptModule> Find(const FString& ModulePath) const;
+    void Add(TSharedPtr<const FScriptModule> Module);
+
+    /** Load the object of a module and add it (replacing a module with the same path); fails if it holds another module */
+    bool LoadObject(const FString& ModulePath, const FString& FileName, FString& OutError);
+
+    /** Save a module as an object file */
+    bool SaveObject(const FString& ModulePath, const FString& FileName) const;
+
+    /** Object file name for a module path: "ScriptHeaders/Util.sbsh" -> "ScriptHeaders_Util.sbo" */
+    static FString GetObjectFileName(const FString& ModulePath);
+    
+    /**
+     * Keep every module compiled from now on as a header artifact in Dir, and load a
+     * module from its artifact instead of compiling it while the key still matches.
+     * Empty (the default) turns artifacts off. The directory must exist.
+     */
+    void SetArtifactDir(const FString& InDir) { ArtifactDir = InDir; }
+    const FString& GetArtifactDir() const { return ArtifactDir; }
+    
+    /** Artifact file name for a module path: "ScriptHeaders/Util.sbsh" -> "ScriptHeaders_Util.sbsh.sbh" */
+    static FString GetArtifactFileName(const FString& ModulePath);
+
+    /** Where import paths are resolved (default: <Project>/Scripts) */
+    void SetScriptsDir(const FString& InDir) { ScriptsDir = InDir; }
+    FString GetSourcePath(const FString& ModulePath) const;
+
+    // Compiler options for the modules, as for the scripts that import them
+    void SetInliningEnabled(bool bEnabled) { bInliningEnabled = bEnabled; }
+    void SetOptimizationEnabled(bool bEnabled) { bOptimizationEnabled = bEnabled; }
+    void SetRegisterCodeEnabled(bool bEnabled) { bRegisterCodeEnabled = bEnabled; }
+
+    const TMap<FString, TSharedPtr<const FScriptModule>>& GetModules() const { return Modules; }
+
+    // Statistics: modules compiled, modules loaded from artifacts, and imports served from the cache
+    int32 GetNumCompiled() const { return NumCompiled; }
+    int32 GetNumLoaded() const { return NumLoaded; }
+    int32 GetNumReused() const { return NumReused; }
+
+private:
+    /** Key of a module: its source, the options and its imports' keys; false when an import has none */
+    bool ComputeArtifactKey(const FString& Source, const TArray<FString>& ModuleImports, uint64& OutKey) const;
+    
+    /** The module from its artifact, nullptr when there is none or it is stale */
+    TSharedPtr<FScriptModule> LoadArtifact(const FString& ModulePath, const FString& Source);
+    void SaveArtifact(const FScriptModule& Module, const FString& Source);
+    
+    TMap<FString, TSharedPtr<const FScriptModule>> Modules;
+    TMap<FString, uint64> ArtifactKeys; // Modules compiled or loaded with artifacts on, by path
+    TSet<FString> InProgress;
+    mutable FCriticalSection Lock;
+    FString ScriptsDir;
+    FString ArtifactDir;
+    bool bInliningEnabled;
+    bool bOptimizationEnabled;
+    bool bRegisterCodeEnabled;
+    int32 NumCompiled;
+    int32 NumLoaded;
+    int32 NumReused;
+};
+
+/**
+ * Links a script compiled against a module cache into one runnable chunk
+ */
+class SCRIPTING_API FScriptLinker
+{
+public:
+    /**
+     * @param Root Chunk of the script, with external function entries
+     * @param Modules Every module the script needs, directly or through other modules
+     * @return The linked chunk, nullptr on errors (unresolved functions, missing modules,
+     *         operands that no longer fit after renumbering)
+     */
+    static TSharedPtr<FBytecodeChunk> Link(const FBytecodeChunk& Root, const FScriptModuleCache& Modules, TArray<FString>& OutErrors);
+};
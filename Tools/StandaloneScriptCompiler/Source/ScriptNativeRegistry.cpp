@@ -0,0 +1,210 @@
+// Copyright Vampire Game Project. All Rights Reserved.
+// Custom scripting system for secure modding support.
+
+#include "ScriptNativeRegistry.h"
+#include "ScriptVM.h"
+#include "ScriptLogger.h"
+
+FScriptNativeRegistry& FScriptNativeRegistry::Get()
+{
+    static FScriptNativeRegistry Registry;
+    return Registry;
+}
+
+const TArray<FNativeFunctionDecl>& FScriptNativeRegistry::GetDeclarations()
+{
+    static const TArray<FNativeFunctionDecl> Declarations = []()
+    {
+        // Unqualified names so the table can say "Pure | ThreadSafe"
+        const ENativeFlags None = ENativeFlags::None;
+        const ENativeFlags Pure = ENativeFlags::Pure;
+        const ENativeFlags ThreadSafe = ENativeFlags::ThreadSafe;
+        const ENativeFlags Latent = ENativeFlags::Latent;
+
+        TArray<FNativeFunctionDecl> Result;
+#define SCRIPT_NATIVE(Name, MinArgs, MaxArgs, ReturnType, Flags) \
+        Result.Add(FNativeFunctionDecl(TEXT(#Name), MinArgs, MaxArgs, EScriptType::ReturnType, Flags));
+#include "ScriptNatives.inl"
+        return Result;
+    }();
+    return Declarations;
+}
+
+const FNativeFunctionDecl* FScriptNativeRegistry::FindDeclaration(const FString& Name)
+{
+    static const TMap<FString, int32> Index = []()
+    {
+        TMap<FString, int32> Result;
+        const TArray<FNativeFunctionDecl>& Declarations = GetDeclarations();
+        for (int32 i = 0; i < Declarations.Num(); ++i)
+        {
+            Result.Add(Declarations[i].Name, i);
+        }
+        return Result;
+    }();
+
+    const int32* Found = Index.Find(Name);
+    return Found ? &GetDeclarations()[*Found] : nullptr;
+}
+
+FScriptNativeRegistry::FScriptNativeRegistry()
+    : bFrozen(false)
+{
+    const TArray<FNativeFunctionDecl>& Declarations = GetDeclarations();
+    Entries.Reserve(Declarations.Num());
+    for (const FNativeFunctionDecl& Decl : Declarations)
+    {
+        FNativeFunctionEntry Entry;
+        Entry.Id = Entries.Num();
+        Entry.Decl = Decl;
+        NameToId.Add(Decl.Name, Entry.Id);
+        Entries.Add(Entry);
+    }
+}
+
+bool FScriptNativeRegistry::Bind(const FString& Name, FNativeFunction Function)
+{
+    if (bFrozen)
+    {
+        VM_LOG_ERROR(FString::Printf(TEXT("Native registry is frozen - cannot bind '%s'"), *Name));
+        return false;
+    }
+
+    if (const int32* Id = NameToId.Find(Name))
+    {
+        FNativeFunctionEntry& Entry = Entries[*Id];
+        if (Entry.Function)
+        {
+            VM_LOG_ERROR(FString::Printf(TEXT("Native '%s' is already bound - keeping the first binding"), *Name));
+            return false;
+        }
+        Entry.Function = MoveTemp(Function);
+        return true;
+    }
+
+    VM_LOG_WARNING(FString::Printf(TEXT("Native '%s' is not declared in ScriptNatives.inl - the compiler will not check its calls"), *Name));
+
+    FNativeFunctionEntry Entry;
+    Entry.Id = Entries.Num();
+    Entry.Decl.Name = Name;
+    Entry.Function = MoveTemp(Function);
+    NameToId.Add(Name, Entry.Id);
+    Entries.Add(Entry);
+    return true;
+}
+
+bool FScriptNativeRegistry::BindSignature(const FString& Name, FNativeTypedBinding Binding)
+{
+    const int32 NumParams = Binding.ParamTypes.Num();
+
+    // A typed binding has a fixed arity - it must agree with the declaration table,
+    // or the compiler would accept calls the binding rejects
+    if (const FNativeFunctionDecl* Declared = FindDeclaration(Name))
+    {
+        if (Declared->MinArgs != NumParams || Declared->MaxArgs != NumParams)
+        {
+            VM_LOG_ERROR(FString::Printf(TEXT("Typed native '%s' takes %d argument(s) but ScriptNatives.inl declares %d..%d - not bound"),
+                *Name, NumParams, Declared->MinArgs, Declared->MaxArgs));
+            return false;
+        }
+
+        // The compiler trusts the declared return type of proven calls, so it must be what the binding boxes
+        const bool bNumeric = (Declared->ReturnType == EScriptType::INT || Declared->ReturnType == EScriptType::FLOAT) &&
+            (Binding.ReturnType == EScriptType::INT || Binding.ReturnType == EScriptType::FLOAT);
+        if (Declared->ReturnType != EScriptType::AUTO && Declared->ReturnType != Binding.ReturnType && !bNumeric)
+        {
+            VM_LOG_ERROR(FString::Printf(TEXT("Typed native '%s' returns %s but ScriptNatives.inl declares %s - not bound"),
+                *Name, *FTypeCastExpr::GetTypeName(Binding.ReturnType), *FTypeCastExpr::GetTypeName(Declared->ReturnType)));
+            return false;
+        }
+    }
+
+    if (!Bind(Name, MoveTemp(Binding.Checked)))
+    {
+        return false;
+    }
+
+    FNativeFunctionEntry& Entry = Entries[FindId(Name)];
+    Entry.UncheckedFunction = MoveTemp(Binding.Unchecked);
+    Entry.Decl.ParamTypes = MoveTemp(Binding.ParamTypes);
+    Entry.Decl.bHasSignature = true;
+
+    // The table stays authoritative for the return type; AUTO is narrowed to what the binding returns
+    if (Entry.Decl.ReturnType == EScriptType::AUTO)
+    {
+        Entry.Decl.ReturnType = Binding.ReturnType;
+    }
+    return true;
+}
+
+void FScriptNativeRegistry::ReportArgumentCount(FScriptVM* VM, const FString& Name, int32 Expected, int32 Got)
+{
+    VM->RuntimeError(FString::Printf(TEXT("%s expects %d argument(s), got %d"), *Name, Expected, Got));
+}
+
+void FScriptNativeRegistry::ReportArgumentType(FScriptVM* VM, const FString& Name, int32 ArgIndex, EScriptType Expected, const FScriptValue& Got)
+{
+    VM->RuntimeError(FString::Printf(TEXT("%s argument %d must be %s, got '%s'"),
+        *Name, ArgIndex + 1, *FTypeCastExpr::GetTypeName(Expected), *Got.ToString()));
+}
+
+void FScriptNativeRegistry::Freeze()
+{
+    if (bFrozen)
+    {
+        return;
+    }
+    bFrozen = true;
+
+    int32 NumBound = 0;
+    for (const FNativeFunctionEntry& Entry : Entries)
+    {
+        if (Entry.Function)
+        {
+            NumBound++;
+        }
+        else
+        {
+            VM_LOG_WARNING(FString::Printf(TEXT("Native '%s' is declared but has no implementation"), *Entry.Decl.Name));
+        }
+    }
+
+    VM_LOG(FString::Printf(TEXT("Native registry frozen: %d natives, %d bound"), Entries.Num(), NumBound));
+}
+
+uint64 FScriptNativeRegistry::GetDeclarationHash() const
+{
+    // FNV-1a over the entries in ID order
+    uint64 Hash = 14695981039346656037ull;
+    auto Mix = [&Hash](uint64 Value)
+    {
+        Hash = (Hash ^ Value) * 1099511628211ull;
+    };
+
+    Mix(Entries.Num());
+    for (const FNativeFunctionEntry& Entry : Entries)
+    {
+        const FNativeFunctionDecl& Decl = Entry.Decl;
+        Mix(Decl.Name.Len());
+        for (int32 i = 0; i < Decl.Name.Len(); ++i)
+        {
+            Mix(static_cast<uint64>(Decl.Name[i]));
+        }
+        Mix(static_cast<uint64>(static_cast<uint32>(Decl.MinArgs)));
+        Mix(static_cast<uint64>(static_cast<uint32>(Decl.MaxArgs)));
+        Mix(static_cast<uint64>(Decl.ReturnType));
+        Mix(static_cast<uint64>(Decl.Flags));
+        Mix(Decl.HasSignature() ? Decl.ParamTypes.Num() + 1 : 0);
+        for (const EScriptType ParamType : Decl.ParamTypes)
+        {
+            Mix(static_cast<uint64>(ParamType));
+        }
+    }
+    return Hash;
+}
+
+int32 FScriptNativeRegistry::FindId(const FString& Name) const
+{
+    const int32* Id = NameToId.Find(Name);
+    return Id ? *Id : INDEX_NONE;
+}
@@ -0,0 +1,117 @@
+// Copyright Vampire Game Project. All Rights Reserved.
+// Custom scripting system for secure modding support.
+
+#include "ScriptProgramImage.h"
+#include "ScriptBytecodeVerifier.h"
+#include "ScriptLogger.h"
+
+TSharedPtr<const FScriptProgramImage> FScriptProgramImage::Create(TSharedPtr<FBytecodeChunk> Bytecode,
+    const FScriptNativeRegistry& Registry, TArray<FString>& OutErrors)
+{
+    if (!Bytecode.IsValid() || Bytecode->Code.Num() == 0)
+    {
+        OutErrors.Add(TEXT("Invalid or empty bytecode"));
+        return nullptr;
+    }
+
+    // SECURITY: Validate once per program instead of once per VM
+    FString ValidationReason;
+    if (!Bytecode->ValidateSecurity(ValidationReason))
+    {
+        OutErrors.Add(FString::Printf(TEXT("Bytecode security validation failed: %s"), *ValidationReason));
+        VM_LOG_ERROR(FString::Printf(TEXT("VM: SECURITY VIOLATION - %s"), *ValidationReason));
+        VM_LOG_ERROR(FString::Printf(TEXT("VM: Compiler: %s"), *Bytecode->Metadata.CompilerName));
+        VM_LOG_ERROR(FString::Printf(TEXT("VM: Source: %s"), *Bytecode->Metadata.SourceFileName));
+        return nullptr;
+    }
+
+    // Structural checks the compiler flags cannot vouch for
+    FBytecodeVerifyResult Verification;
+    if (!FScriptBytecodeVerifier::Verify(*Bytecode, Verification))
+    {
+        for (const FString& Error : Verification.Errors)
+        {
+            OutErrors.Add(FString::Printf(TEXT("Bytecode verification failed: %s"), *Error));
+        }
+        VM_LOG_ERROR(FString::Printf(TEXT("VM: Malformed bytecode in %s (%d error(s))"),
+            *Bytecode->Metadata.SourceFileName, Verification.Errors.Num()));
+        return nullptr;
+    }
+    if (!Verification.bStackVerified)
+    {
+        VM_LOG_WARNING(FString::Printf(TEXT("VM: Stack shape not provable, running with runtime checks - %s"),
+            *Verification.StackFailure));
+    }
+
+    VM_LOG(TEXT("=== BYTECODE SECURITY ==="));
+    VM_LOG(FString::Printf(TEXT("Compiler: %s %s"), *Bytecode->Metadata.CompilerName, *Bytecode->Metadata.CompilerVersion));
+    VM_LOG(FString::Printf(TEXT("Game: %s %s"), *Bytecode->Metadata.GameName, *Bytecode->Metadata.GameVersion));
+    VM_LOG(FString::Printf(TEXT("Trusted: %s"), Bytecode->IsTrustedCompiler() ? TEXT("YES") : TEXT("NO")));
+    VM_LOG(FString::Printf(TEXT("Security: %s"), *ValidationReason));
+    VM_LOG(FString::Printf(TEXT("Verified: %s (max stack %d)"), Verification.IsVerified() ? TEXT("YES") : TEXT("NO"),
+        Verification.MaxStackHeight));
+
+    TSharedPtr<FScriptProgramImage> Program = MakeShareable(new FScriptProgramImage());
+    Program->Bytecode = Bytecode;
+    Program->Registry = &Registry;
+    Program->bVerified = Verification.IsVerified();
+
+    // Chunks loaded from .scc carry their signature; freshly compiled ones may not have it yet
+    Program->Signature = Bytecode->Signature.IsEmpty() ? Bytecode->GenerateSignature() : Bytecode->Signature;
+    Program->MainFunctionIndex = Program->FindFunction(TEXT("Main"));
+
+    // CALL_NATIVE names its target through a string constant, so binding every string
+    // constant that matches a registered native resolves all call sites up front
+    const int32 NumConstants = Bytecode->Constants.Num();
+    Program->NativeIds.Init(INDEX_NONE, NumConstants);
+    int32 NumResolved = 0;
+    for (int32 i = 0; i < NumConstants; ++i)
+    {
+        const FScriptValue& Constant = Bytecode->Constants[i];
+        if (!Constant.IsString())
+        {
+            continue;
+        }
+
+        const int32 NativeId = Registry.FindId(Constant.AsString());
+        if (NativeId != INDEX_NONE)
+        {
+            Program->NativeIds[i] = NativeId;
+            NumResolved++;
+        }
+    }
+
+    VM_LOG(FString::Printf(TEXT("Program created: %d bytes code, %d constants, %d functions, %d natives resolved"),
+        Bytecode->Code.Num(), NumConstants, Bytecode->Functions.Num(), NumResolved));
+
+    return Program;
+}
+
+int32 FScriptProgramImage::FindFunction(const FString& Name) const
+{
+    const TArray<FFunctionInfo>& Functions = Bytecode->Functions;
+    for (int32 i = 0; i < Functions.Num(); ++i)
+    {
+        if (Functions[i].Name == Name)
+        {
+            return i;
+        }
+    }
+    return INDEX_NONE;
+}
+
+SIZE_T FScriptProgramImage::GetAllocatedSize() const
+{
+    SIZE_T Size = sizeof(FScriptProgramImage);
+    Size += Bytecode->Code.Num();
+    Size += Bytecode->RegisterCode.Num();
+    Size += Bytecode->Constants.Num() * sizeof(FScriptValue);
+    for (const FScriptValue& Constant : Bytecode->Constants)
+    {
+        Size += Constant.AsString().Len() * sizeof(TCHAR);
+    }
+    Size += Bytecode->Functions.Num() * sizeof(FFunctionInfo);
+    Size += Bytecode->LineTable.GetAllocatedSize();
+    Size += NativeIds.Num() * sizeof(int32);
+    return Size;
+}
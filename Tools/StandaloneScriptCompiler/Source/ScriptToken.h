@@ -105,19 +105,30 @@ struct FScriptToken
     // For number literals
     double NumberValue;
     
+    // Span of the token in the source (for a string literal it includes the quotes,
+    // while Lexeme holds the unescaped value). Zero for tokens made up by later stages.
+    // Lexeme is still a copy of the span: nothing reads the source through spans yet,
+    // and identifiers are not interned
+    int32 Offset;
+    int32 Length;
+    
     FScriptToken()
         : Type(ETokenType::ERROR)
         , Line(0)
         , Column(0)
         , NumberValue(0.0)
+        , Offset(0)
+        , Length(0)
     {}
     
-    FScriptToken(ETokenType InType, const FString& InLexeme, int32 InLine, int32 InColumn)
+    FScriptToken(ETokenType InType, FString InLexeme, int32 InLine, int32 InColumn)
         : Type(InType)
-        , Lexeme(InLexeme)
+        , Lexeme(MoveTemp(InLexeme))
         , Line(InLine)
         , Column(InColumn)
         , NumberValue(0.0)
+        , Offset(0)
+        , Length(0)
     {}
     
     FString ToString() const
@@ -5,8 +5,31 @@
 
 #include "Platform.h"
 #include "ScriptBytecode.h"
+#include "ScriptProgramImage.h"
+#include "ScriptProfile.h"
 #include "ScriptAST.h"  // For EScriptType enum
 
+/**
+ * VM Execution State
+ */
+enum class EVMState
+{
+    Ready,      // Initialized, ready to start
+    Running,    // Currently executing
+    Paused,     // execution suspended (e.g. Sleep)
+    Finished,   // execution completed successfully
+    Error       // execution failed
+};
+
+/**
+ * Which code the VM runs for functions that have both (see FScriptVM::SetBackend)
+ */
+enum class EScriptBackend : uint8
+{
+    Stack,      // FBytecodeChunk::Code
+    Register    // FBytecodeChunk::RegisterCode where a function has it, Code elsewhere
+};
+
 /**
  * Call frame for function execution
  */
@@ -16,11 +39,15 @@ struct SCRIPTING_API FCallFrame
     int32 ReturnAddress;        // Where to return after function completes
     int32 StackBase;            // Base of this frame's stack
     FString FunctionName;       // For debugging
+    bool bRegisterCode;         // Running register code: addresses are in RegisterCode, registers start at StackBase
+    int32 ReturnRegister;       // Caller register that receives the result, INDEX_NONE = push it (stack code caller)
     
     FCallFrame()
         : FunctionAddress(0)
         , ReturnAddress(0)
         , StackBase(0)
+        , bRegisterCode(false)
+        , ReturnRegister(INDEX_NONE)
     {}
     
     FCallFrame(int32 InFuncAddr, int32 InRetAddr, int32 InStackBase, const FString& InName = TEXT(""))
@@ -28,38 +55,315 @@ struct SCRIPTING_API FCallFrame
         , ReturnAddress(InRetAddr)
         , StackBase(InStackBase)
         , FunctionName(InName)
+        , bRegisterCode(false)
+        , ReturnRegister(INDEX_NONE)
     {}
 };
 
 /**
- * Native function signature
- * Takes array of arguments, returns a value
+ * Global variable storage
+ * Held through a shared pointer so snapshots and forked VMs can share it copy-on-write
  */
-typedef TFunction<FScriptValue(const TArray<FScriptValue>&)> FNativeFunction;
+typedef TMap<FString, FScriptValue> FScriptGlobalTable;
 
 /**
- * Virtual Machine for executing bytecode
- * Stack-based architecture with safety limits
+ * Snapshot of a VM's execution state
+ * Captures everything needed to continue a script later (save games, fast restart)
+ * or to branch it. Bytecode is NOT included - a snapshot is only valid against the
+ * chunk it was captured from, which is checked through BytecodeSignature on restore.
  */
-// Native function typedef
-using FNativeFunction = std::function<void(TArray<class FScriptValue>&)>;
+struct SCRIPTING_API FVMSnapshot
+{
+    EVMState State;
+    int32 InstructionPointer;
+    int32 InstructionCount;
+    
+    TArray<FScriptValue> Stack;
+    TArray<FCallFrame> CallFrames;
+    
+    /** Shared with the source VM until either side writes a global */
+    TSharedPtr<FScriptGlobalTable> Globals;
+    
+    /** Signature of the bytecode chunk this snapshot belongs to */
+    FString BytecodeSignature;
+    
+    /** Host-side state saved by registered snapshot extensions (e.g. collection handles) */
+    TMap<FString, TArray<uint8>> Extensions;
+    
+    FVMSnapshot()
+        : State(EVMState::Ready)
+        , InstructionPointer(0)
+        , InstructionCount(0)
+    {}
+    
+    /** Write the snapshot to a flat binary blob (save game payload) */
+    bool Serialize(TArray<uint8>& OutData) const;
+    
+    /** Read a blob written by Serialize. Returns false on bad magic/version or truncated data */
+    bool Deserialize(const TArray<uint8>& InData);
+};
 
-class SCRIPTING_API FScriptVM
+/**
+ * State that lives outside a VM but belongs to it, and has to travel with its snapshots
+ * Registered once per name by the module that owns the state (see FScriptVM::RegisterSnapshotExtension).
+ * Every callback is given the VM the state belongs to, and must touch no other VM's state.
+ */
+struct FVMSnapshotExtension
+{
+    /** Save the VM's state */
+    TFunction<void(const FScriptVM& VM, TArray<uint8>& OutData)> Save;
+    
+    /** Replace the VM's state with what Save wrote. False on malformed data */
+    TFunction<bool(FScriptVM& VM, const TArray<uint8>& InData)> Load;
+    
+    /** Give a forked VM its own copy of the parent's state (optional) */
+    TFunction<void(const FScriptVM& Parent, FScriptVM& Child)> Fork;
+    
+    /** Free the VM's state as the VM is destroyed (optional) */
+    TFunction<void(const FScriptVM& VM)> Release;
+};
+
+/**
+ * Virtual Machine (VM) for Executing SBS/SBSH Bytecode
+ * =====================================================
+ * 
+ * The VM is the FINAL STAGE of the compilation/execution pipeline.
+ * It takes BYTECODE (compiled from the AST) and EXECUTES it.
+ * 
+ * COMPILATION PIPELINE OVERVIEW:
+ * -----------------------------
+ * 1. Source Code (.sc file)
+ * 2. → LEXER → Tokens
+ * 3. → PARSER → Abstract Syntax Tree (AST)
+ * 4. → COMPILER → Bytecode Instructions
+ * 5. → VM (THIS CLASS) → Execution & Results
+ * 
+ * WHAT THE VM DOES:
+ * ----------------
+ * Input:  Bytecode chunk (array of instructions)
+ * Output: Program execution, side effects (logs, API calls), return values
+ * 
+ * The VM performs:
+ * 1. Instruction-by-instruction execution
+ * 2. Stack-based value management
+ * 3. Function call management (call frames)
+ * 4. Native function integration (API calls to Unreal)
+ * 5. Memory and execution safety enforcement
+ * 
+ * STACK-BASED ARCHITECTURE:
+ * -------------------------
+ * The VM uses a STACK to manage values during execution.
+ * 
+ * Example execution of: x = 10 + 20;
+ * 
+ * Bytecode:           Stack State:        Description:
+ * ----------------------------------------
+ * PUSH 10            [10]                 Push constant 10
+ * PUSH 20            [10, 20]             Push constant 20
+ * ADD                [30]                 Pop 20 and 10, push sum 30
+ * SET_LOCAL x        []                   Pop 30, store in variable x
+ * 
+ * INSTRUCTION SET:
+ * ---------------
+ * 
+ * Constants & Literals:
+ *   PUSH_CONSTANT <index>  - Push constant from constant pool
+ *   PUSH_NIL               - Push nil/null value
+ *   PUSH_TRUE              - Push boolean true
+ *   PUSH_FALSE             - Push boolean false
+ * 
+ * Arithmetic Operations:
+ *   ADD       - Pop b, pop a, push (a + b)
+ *   SUBTRACT  - Pop b, pop a, push (a - b)
+ *   MULTIPLY  - Pop b, pop a, push (a * b)
+ *   DIVIDE    - Pop b, pop a, push (a / b)
+ *   MODULO    - Pop b, pop a, push (a % b)
+ *   NEGATE    - Pop a, push (-a)
+ * 
+ * Comparison Operations:
+ *   EQUAL     - Pop b, pop a, push (a == b)
+ *   GREATER   - Pop b, pop a, push (a > b)
+ *   LESS      - Pop b, pop a, push (a < b)
+ * 
+ * Logical Operations:
+ *   NOT       - Pop a, push (!a)
+ *   AND       - Pop b, pop a, push (a && b)
+ *   OR        - Pop b, pop a, push (a || b)
+ * 
+ * Bitwise Operations:
+ *   BIT_AND   - Pop b, pop a, push (a & b)
+ *   BIT_OR    - Pop b, pop a, push (a | b)
+ *   BIT_XOR   - Pop b, pop a, push (a ^ b)
+ *   BIT_NOT   - Pop a, push (~a)
+ * 
+ * Variables:
+ *   GET_LOCAL <index>      - Push local variable value
+ *   SET_LOCAL <index>      - Pop value, store in local variable
+ *   DEFINE_GLOBAL <name>   - Pop value, create global variable
+ *   GET_GLOBAL <name>      - Push global variable value
+ *   SET_GLOBAL <name>      - Pop value, store in global variable
+ * 
+ * Control Flow:
+ *   JUMP <offset>          - Unconditional jump forward/backward
+ *   JUMP_IF_FALSE <offset> - Pop value, jump if false
+ *   LOOP <offset>          - Jump backward (for loops)
+ * 
+ * Functions:
+ *   CALL <arg_count>       - Call user-defined function
+ *   CALL_NATIVE <name>     - Call native (C++) function
+ *   RETURN                 - Return from function
+ * 
+ * Type Casting:
+ *   CAST_INT              - Convert top of stack to int
+ *   CAST_FLOAT            - Convert top of stack to float
+ *   CAST_STRING           - Convert top of stack to string
+ * 
+ * Arrays:
+ *   ARRAY_CREATE <size>   - Create array with size
+ *   ARRAY_GET             - Pop index, pop array, push element
+ *   ARRAY_SET             - Pop value, pop index, pop array, set element
+ * 
+ * CALL FRAMES & FUNCTION EXECUTION:
+ * ---------------------------------
+ * When a function is called, the VM creates a CALL FRAME containing:
+ * - Function start address in bytecode
+ * - Return address (where to resume after function completes)
+ * - Stack base (for local variables)
+ * - Function name (for debugging)
+ * 
+ * Example function call:
+ * 
+ *   int Add(int a, int b) {
+ *       return a + b;
+ *   }
+ *   int result = Add(10, 20);
+ * 
+ * Execution steps:
+ * 1. Push arguments: PUSH 10, PUSH 20
+ * 2. CALL Add (creates call frame, jumps to Add function)
+ * 3. Function body executes: GET_LOCAL a, GET_LOCAL b, ADD
+ * 4. RETURN (pops call frame, pushes return value, resumes caller)
+ * 5. Result is on stack for assignment to 'result'
+ * 
+ * NATIVE FUNCTION INTEGRATION:
+ * ----------------------------
+ * Native functions are C++ functions exposed to scripts.
+ * They are registered with RegisterNativeFunction() and called via CALL_NATIVE.
+ * 
+ * Example - Registering Log function:
+ * 
+ *   VM->RegisterNativeFunction("Log", [](const TArray<FScriptValue>& Args) -> FScriptValue {
+ *       if (Args.Num() > 0) {
+ *           UE_LOG(LogTemp, Log, TEXT("%s"), *Args[0].ToString());
+ *       }
+ *       return FScriptValue(); // void return
+ *   });
+ * 
+ * Script usage:
+ *   Log("Hello from script!");
+ * 
+ * Bytecode:
+ *   PUSH_CONSTANT "Hello from script!"
+ *   CALL_NATIVE Log 1
+ * 
+ * EXECUTION SAFETY & LIMITS:
+ * --------------------------
+ * The VM enforces limits to prevent infinite loops and stack overflows:
+ * - MaxInstructionsPerFrame: Maximum bytecode instructions per frame
+ * - MaxStackDepth: Maximum stack size
+ * - MaxCallDepth: Maximum function call recursion depth
+ * - MaxExecutionTimeMs: Maximum execution time in milliseconds
+ * 
+ * These limits can be configured via SetExecutionLimits().
+ * 
+ * ERROR HANDLING:
+ * --------------
+ * Runtime errors are collected in an error list:
+ * - Type mismatches (e.g., adding string + int)
+ * - Division by zero
+ * - Array out of bounds
+ * - Stack overflow/underflow
+ * - Undefined variables
+ * - Call depth exceeded
+ * 
+ * Errors stop execution and can be retrieved via GetErrors().
+ * 
+ * MEMORY MANAGEMENT:
+ * -----------------
+ * - Program: FScriptProgramImage - immutable code/constants/natives, shared by all instances
+ * - Stack: TArray<FScriptValue> - grows/shrinks as needed
+ * - Globals: TMap<FString, FScriptValue> - persistent across calls
+ * - Call Frames: TArray<FCallFrame> - tracks function call stack
+ * - All memory is managed by Unreal's smart pointers and containers
+ * 
+ * A VM is only an execution context. To run one script on many actors, create
+ * the FScriptProgramImage once and Execute() it on as many VMs as needed - each
+ * instance costs a few hundred bytes until its stack starts growing.
+ * 
+ * REGISTER BACKEND:
+ * -----------------
+ * Functions compiled with FScriptCompiler::SetRegisterCodeEnabled also carry register
+ * code (see ERegOpCode): three-address instructions such as ADD r1, r2, r3 over the
+ * frame's slots. SetBackend(EScriptBackend::Register) runs that code wherever it exists;
+ * calls cross freely between the two kinds of code, and top-level code is always stack code.
+ * 
+ * Stack-based architecture with safety limits
+ */
+class SCRIPTING_API FScriptVM : public TSharedFromThis<FScriptVM>
 {
 public:
     FScriptVM();
+    ~FScriptVM();
     
     /**
-     * Execute bytecode chunk
-     * Returns true if execution completed successfully
+     * Start execution of bytecode chunk
+     * Builds a private program resolved against the process-wide native registry.
+     * Returns true if execution started successfully
      */
     bool Execute(TSharedPtr<FBytecodeChunk> Bytecode);
     
     /**
-     * Register a native function that scripts can call
+     * Start execution of a shared program image
+     * No validation or native lookup happens here - that was done once in FScriptProgramImage::Create.
+     * Returns true if execution started successfully
+     */
+    bool Execute(TSharedPtr<const FScriptProgramImage> InProgram);
+    
+    /**
+     * Resume execution (called by LatentManager)
+     * Returns true if execution completed or paused successfully
+     * Returns false on error
+     */
+    bool Resume();
+
+    /**
+     * Pause execution (called by Native Functions like Sleep)
+     * Execution will stop at the current instruction and return from Resume()
+     */
+    void Pause();
+
+    /**
+     * Get current VM state
+     */
+    EVMState GetState() const { return State; }
+    
+    /**
+     * Register a native function for this VM instance only
+     * Shared natives belong in FScriptNativeRegistry; instance natives are only
+     * consulted for calls the registry cannot resolve.
      */
     void RegisterNativeFunction(const FString& Name, FNativeFunction Function);
     
+    /**
+     * Natives registered directly on this VM
+     */
+    const TMap<FString, FNativeFunction>& GetNativeFunctions() const { return NativeFunctions; }
+    
+    /**
+     * Program currently loaded into this VM (nullptr before the first Execute)
+     */
+    TSharedPtr<const FScriptProgramImage> GetProgram() const { return Program; }
+    
     /**
      * Call Main() entry point if it exists in the script
      * Returns true if Main() was found and called successfully
@@ -83,54 +387,125 @@ public:
      */
     const TArray<FScriptValue>& GetStack() const { return Stack; }
     
+    /** Instructions dispatched since the last Reset (top-level code and Main() together) */
+    int32 GetInstructionCount() const { return InstructionCount; }
+    
+    //=============================================================================
+    // Snapshots
+    //=============================================================================
+    
+    /**
+     * Capture the current execution state
+     * Only valid while the VM is not executing (Ready, Paused, Finished or Error) -
+     * a native function must not snapshot the VM that is calling it.
+     * Globals are shared with the snapshot, not copied; the VM detaches on its next write.
+     */
+    bool CaptureSnapshot(FVMSnapshot& OutSnapshot) const;
+    
+    /**
+     * Restore a previously captured state
+     * @param Snapshot - State to restore
+     * @param InProgram - Program the snapshot was taken against (nullptr = keep current program)
+     * A snapshot taken mid-script comes back Paused; call Resume() to continue it.
+     */
+    bool RestoreSnapshot(const FVMSnapshot& Snapshot, TSharedPtr<const FScriptProgramImage> InProgram = nullptr);
+    
+    /**
+     * Create an independent VM that continues from this VM's current state
+     * Program is shared, globals are shared copy-on-write, stack and frames are copied.
+     * Host state behind snapshot extensions is copied by their Fork callbacks.
+     */
+    TSharedPtr<FScriptVM> Fork() const;
+    
+    /**
+     * Register host state that must be saved with snapshots
+     * Re-registering a name replaces the previous extension.
+     */
+    static void RegisterSnapshotExtension(const FString& Name, const FVMSnapshotExtension& Extension);
+    static void UnregisterSnapshotExtension(const FString& Name);
+    
     /**
      * Execution limits for security
      */
     struct FExecutionLimits
     {
-        int32 MaxInstructionsPerFrame = 1000000;  // 1M instructions per Execute()
-        int32 MaxStackDepth = 256;                // Max stack size
-        int32 MaxCallDepth = 64;                  // Max function call depth
-        double MaxExecutionTimeMs = 50.0;         // Increased for debug builds with logging
+        int32 MaxInstructionsPerFrame = 100000000;  // 100M instructions - effectively unlimited for testing
+        int32 MaxStackDepth = 10000;                // 10K stack depth - very generous
+        int32 MaxCallDepth = 1000;                  // 1K call depth - allows deep recursion
+        double MaxExecutionTimeMs = 60000.0;        // 60 seconds - effectively unlimited for testing
+        bool bAllowUncheckedDispatch = true;        // Run verified programs without per-instruction checks
         
         FExecutionLimits() {}
     };
     
     void SetExecutionLimits(const FExecutionLimits& InLimits) { Limits = InLimits; }
     const FExecutionLimits& GetExecutionLimits() const { return Limits; }
+    
+    /**
+     * Select the code functions run on from their next call
+     * Register code is only entered for programs that passed verification - its loop has no
+     * checked variant - and Stack is the default.
+     */
+    void SetBackend(EScriptBackend InBackend) { Backend = InBackend; }
+    EScriptBackend GetBackend() const { return Backend; }
+    
+    /**
+     * Count what every instruction does - runs, conditional jumps taken, operand types of
+     * the arithmetic and comparison opcodes - for FScriptProfile::AddRun. Enabling clears
+     * the counters; they then add up over every run until it is enabled again.
+     * A profiling VM stays on the checked dispatch loop and on stack code.
+     */
+    void SetProfilingEnabled(bool bEnabled);
+    bool IsProfilingEnabled() const { return bProfiling; }
+    
+    /** Counters indexed by offset in the program's Code (shorter than it if the tail never ran) */
+    const TArray<FInstructionCounters>& GetProfileCounters() const { return ProfileCounters; }
+
+    /**
+     * Report a runtime error
+     */
+    void RuntimeError(const FString& Message);
 
 private:
+    /** Run every extension's Release for a VM being destroyed */
+    static void ReleaseExtensionState(const FScriptVM& VM);
+    
+    // VM State
+    EVMState State;
+
     // Stack machine state
     TArray<FScriptValue> Stack;
     TArray<FCallFrame> CallFrames;
-    TSharedPtr<FBytecodeChunk> CurrentBytecode;
     int32 InstructionPointer;
     
-    // Native function registry
-    TMap<FString, FNativeFunction> NativeFunctions;
+    // Shared program image; CurrentBytecode caches its chunk for the dispatch loop
+    TSharedPtr<const FScriptProgramImage> Program;
+    const FBytecodeChunk* CurrentBytecode;
     
-    // Global variable storage
-    TMap<FString, FScriptValue> Globals;
+    // True while the program is verified and the stack was built by running it
+    // (see FScriptBytecodeVerifier) - selects the unchecked dispatch loop
+    bool bUncheckedDispatch;
     
-    // Function table for user-defined functions
-    struct FFunctionInfo
-    {
-        FString Name;
-        int32 Address;
-        int32 Arity; // Number of parameters
-        EScriptType ReturnType;
-        
-        FFunctionInfo() : Address(-1), Arity(0), ReturnType(EScriptType::VOID) {}
-        FFunctionInfo(const FString& InName, int32 InAddress, int32 InArity, EScriptType InRetType)
-            : Name(InName), Address(InAddress), Arity(InArity), ReturnType(InRetType) {}
-    };
-    TArray<FFunctionInfo> FunctionTable;
+    // Code the next call enters, and whether the innermost frame runs register code
+    EScriptBackend Backend;
+    bool bInRegisterCode;
+    
+    // Natives registered on this instance - only consulted for names the
+    // program's native registry could not resolve
+    TMap<FString, FNativeFunction> NativeFunctions;
+    
+    // Global variable storage (copy-on-write, see MutableGlobals)
+    TSharedPtr<FScriptGlobalTable> Globals;
     
     // Execution limits and tracking
     FExecutionLimits Limits;
     int32 InstructionCount;
     double ExecutionStartTime;
     
+    // Per-instruction counters (see SetProfilingEnabled)
+    bool bProfiling;
+    TArray<FInstructionCounters> ProfileCounters;
+    
     // Error tracking
     TArray<FString> Errors;
     
@@ -138,15 +513,16 @@ private:
     // Stack Operations
     //=============================================================================
     
+    // bVerified = running a verified program; underflow/range checks are compiled out.
+    // Push always checks - the stack depth limit is a runtime property.
     void Push(const FScriptValue& Value);
-    FScriptValue Pop();
-    FScriptValue Peek(int32 Offset = 0) const;
+    template<bool bVerified = false> FScriptValue Pop();
+    template<bool bVerified = false> FScriptValue Peek(int32 Offset = 0) const;
     
     //=============================================================================
     // Error Handling
     //=============================================================================
     
-    void RuntimeError(const FString& Message);
     bool CheckStackOverflow();
     bool CheckCallDepth();
     bool CheckInstructionLimit();
@@ -156,76 +532,155 @@ private:
     // Instruction Execution
     //=============================================================================
     
-    bool ExecuteInstruction();
+    /** Dispatch until the program ends, pauses or fails, or fewer than MinCallDepth frames remain */
+    bool Run(int32 MinCallDepth);
+    
+    /**
+     * Dispatch loop, built twice: checked, and with the checks the verifier already
+     * proved (operand bounds, stack underflow, local slots, call targets) compiled out.
+     * Instruction, time and stack-depth limits are enforced in both.
+     */
+    template<bool bVerified> bool RunLoop(int32 MinCallDepth);
+    template<bool bVerified> bool ExecuteInstruction();
+    
+    /** Count the instruction at InstructionPointer, before it runs */
+    void RecordProfile();
+    
+    /**
+     * Dispatch loop for register code, until the innermost frame is stack code again
+     * Operands were proven by the verifier. Slow paths push their operands above the
+     * frame and reuse the stack opcode handlers, so both backends raise the same errors.
+     */
+    bool RunRegisterLoop(int32 MinCallDepth);
+    
+    /** Start running a function whose frame was just pushed - picks register code when the backend allows */
+    bool EnterFunction(FCallFrame& Frame, const FFunctionInfo& Function);
+    
+    /** Pop the innermost frame and deliver Result to the caller (its register, or its stack) */
+    void ReturnFromFrame(const FScriptValue& Result);
+    
+    /** Run a stack opcode handler on registers: push them, call it, move its result to Dest */
+    void RunStackHandler(void (FScriptVM::*Handler)(), const uint8* Operands, int32 NumOperands, uint8 Dest);
     
     // Opcode handlers
-    void OpConstant();
-    void OpNil();
-    void OpTrue();
-    void OpFalse();
-    
-    void OpAdd();
-    void OpSubtract();
-    void OpMultiply();
-    void OpDivide();
-    void OpNegate();
-    
-    void OpEqual();
-    void OpGreater();
-    void OpLess();
-    void OpNot();
-    void OpAnd();
-    void OpOr();
-    
-    void OpGetLocal();
-    void OpSetLocal();
-    void OpDefineGlobal();
-    void OpGetGlobal();
-    void OpSetGlobal();
-    
-    void OpJump();
-    void OpJumpIfFalse();
-    void OpLoop();
-    
-    void OpCall();
-    void OpCallNative();
-    void OpReturn();
-    
-    void OpCastInt();
-    void OpCastFloat();
-    void OpCastString();
-    
-    void OpPop();
-    void OpPrint();
+    template<bool bVerified, bool bWide = false> void OpConstant();
+    template<bool bVerified> void OpNil();
+    template<bool bVerified> void OpTrue();
+    template<bool bVerified> void OpFalse();
+    
+    template<bool bVerified> void OpAdd();
+    template<bool bVerified> void OpSubtract();
+    template<bool bVerified> void OpMultiply();
+    template<bool bVerified> void OpDivide();
+    template<bool bVerified> void OpModulo();
+    template<bool bVerified> void OpNegate();
+    
+    template<bool bVerified> void OpEqual();
+    template<bool bVerified> void OpGreater();
+    template<bool bVerified> void OpLess();
+    template<bool bVerified> void OpNot();
+    template<bool bVerified> void OpAnd();
+    template<bool bVerified> void OpOr();
+    
+    template<bool bVerified> void OpBitAnd();
+    template<bool bVerified> void OpBitOr();
+    template<bool bVerified> void OpBitXor();
+    template<bool bVerified> void OpBitNot();
+    
+    /** The _NUMBER opcodes: Generic on two numbers in place, else the generic handler (then OP_NOT if bNegate) */
+    template<bool bVerified, EOpCode Generic, bool bNegate = false> void OpNumber();
+    
+    template<bool bVerified, bool bWide = false> void OpGetLocal();
+    template<bool bVerified, bool bWide = false> void OpSetLocal();
+    template<bool bVerified, bool bWide = false> void OpDefineGlobal();
+    template<bool bVerified, bool bWide = false> void OpGetGlobal();
+    template<bool bVerified, bool bWide = false> void OpSetGlobal();
+    
+    template<bool bVerified, bool bWide = false> void OpJump();
+    template<bool bVerified, bool bWide = false> void OpJumpIfFalse();
+    template<bool bVerified, bool bWide = false> void OpLoop();
+    template<bool bVerified> void OpForPrep();
+    template<bool bVerified> void OpForLoop();
+    template<bool bVerified, bool bWide = false> void OpForEach();
+    template<bool bVerified> void OpSwitchTable();
+    template<bool bVerified> void OpSwitchLookup();
+    
+    template<bool bVerified> void OpCall();
+    template<bool bVerified> void OpTailCall();
+    template<bool bVerified> void OpCallNative();
+    template<bool bVerified> void OpReturn();
+    
+    template<bool bVerified> void OpCastInt();
+    template<bool bVerified> void OpCastFloat();
+    template<bool bVerified> void OpCastString();
+    
+    template<bool bVerified> void OpPop();
+    template<bool bVerified> void OpPrint();
     
     // Missing opcode handlers
-    void OpNotEqual();
-    void OpGreaterEqual();
-    void OpLessEqual();
-    void OpCreateArray();
-    void OpGetElement();
-    void OpSetElement();
-    void OpDuplicate();
+    template<bool bVerified> void OpNotEqual();
+    template<bool bVerified> void OpGreaterEqual();
+    template<bool bVerified> void OpLessEqual();
+    template<bool bVerified> void OpCreateArray();
+    template<bool bVerified> void OpGetElement();
+    template<bool bVerified> void OpSetElement();
+    template<bool bVerified> void OpDuplicate();
     
     // Additional structure opcodes that were defined but not implemented
-    void OpGetField();
-    void OpSetField();
+    template<bool bVerified> void OpGetField();
+    template<bool bVerified> void OpSetField();
     
     //=============================================================================
     // Helper Methods
     //=============================================================================
     
-    uint8 ReadByte();
-    uint16 ReadShort();
-    FScriptValue ReadConstant();
+    /** Globals for writing - detaches from snapshots/forks still sharing the table */
+    FScriptGlobalTable& MutableGlobals();
+    
+    /** Bind a program to this VM (does not touch execution state) */
+    void SetProgram(TSharedPtr<const FScriptProgramImage> InProgram);
+    
+    template<bool bVerified = false> uint8 ReadByte();
+    template<bool bVerified = false> uint16 ReadShort();
+    template<bool bVerified = false> uint32 ReadLong();
+    
+    /** 8-bit constant index, or 24-bit for the _WIDE opcodes */
+    template<bool bVerified = false, bool bWide = false> FScriptValue ReadConstant();
+    
+    /** 16-bit jump offset, or 32-bit for the _WIDE opcodes (checked against the code size unless verified) */
+    template<bool bVerified, bool bWide> uint32 ReadJumpOffset(bool bBackward);
+    
+    /** Native bound to the name constant, honouring call sites the compiler type-checked; nullptr = not found */
+    const FNativeFunction* ResolveNative(uint16 NameIndex, int32 ArgCount, bool bArgsChecked) const;
+    
+    /** OP_DIVIDE on two numbers, B != 0: truncating if both are whole, as in C */
+    static double DivideNumbers(double A, double B);
     
     // Type checking and conversion
     bool IsTruthy(const FScriptValue& Value) const;
     bool AreEqual(const FScriptValue& A, const FScriptValue& B) const;
     
+    /** Counted-loop condition: i < limit counting up, i > limit counting down (<= / >= if inclusive) */
+    static bool IsInForRange(double Counter, double Limit, double Step, uint8 Flags)
+    {
+        if (Flags & FOR_LOOP_INCLUSIVE)
+        {
+            return Step > 0.0 ? Counter <= Limit : Counter >= Limit;
+        }
+        return Step > 0.0 ? Counter < Limit : Counter > Limit;
+    }
+    
     // Debugging
     void DumpStack() const;
-};
 
+    //=============================================================================
+    // Native Function Implementations
+    //=============================================================================
 
+    static FScriptValue NativePrint(FScriptVM* VM, const TArray<FScriptValue>& Args);
+    static FScriptValue NativeLogWarning(FScriptVM* VM, const TArray<FScriptValue>& Args);
+    static FScriptValue NativeLogError(FScriptVM* VM, const TArray<FScriptValue>& Args);
+    static FScriptValue NativeRandInt(FScriptVM* VM, const TArray<FScriptValue>& Args);
+    static FScriptValue NativeRandFloat(FScriptVM* VM, const TArray<FScriptValue>& Args);
+};
 
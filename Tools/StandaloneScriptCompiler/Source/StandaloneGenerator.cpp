@@ -0,0 +1,400 @@
+// Standalone Script Compiler - synthetic scripts
+
+#include "StandaloneGenerator.h"
+#include "ScriptLexer.h"
+#include "ScriptParser.h"
+#include "ScriptCompiler.h"
+#include "ScriptBytecode.h"
+#include "ScriptBytecodeFile.h"
+
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+
+static const char* SHAPE_NAMES[] = { "mixed", "functions", "nested", "switch", "globals", "strings" };
+
+bool ParseGeneratedScriptShape(const FString& Name, EGeneratedScriptShape& OutShape)
+{
+    for (int32 i = 0; i < (int32)(sizeof(SHAPE_NAMES) / sizeof(SHAPE_NAMES[0])); ++i)
+    {
+        if (Name == SHAPE_NAMES[i])
+        {
+            OutShape = (EGeneratedScriptShape)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* GetGeneratedScriptShapeName(EGeneratedScriptShape Shape)
+{
+    return SHAPE_NAMES[(int32)Shape];
+}
+
+namespace
+{
+    // Writes whole lines and counts them, so a script can be grown to a number of lines
+    class FScriptWriter
+    {
+    public:
+        void Line(const std::string& Text)
+        {
+            Out << std::string(Indent * 4, ' ') << Text << '\n';
+            NumLines++;
+        }
+        void Open(const std::string& Text)
+        {
+            Line(Text + " {");
+            Indent++;
+        }
+        void Close()
+        {
+            Indent--;
+            Line("}");
+        }
+
+        int32 GetNumLines() const { return NumLines; }
+        FString GetSource() const { return Out.str(); }
+
+    private:
+        std::ostringstream Out;
+        int32 NumLines = 0;
+        int32 Indent = 0;
+    };
+
+    std::string Str(int32 Value)
+    {
+        return std::to_string(Value);
+    }
+
+    // Each unit is named after its index, so units of one kind never collide
+
+    void WriteFunctions(FScriptWriter& W, int32 Unit)
+    {
+        // Each calls the one before it, across units too
+        const int32 PerUnit = 10;
+        for (int32 i = 0; i < PerUnit; ++i)
+        {
+            const int32 Index = Unit * PerUnit + i;
+            const std::string Name = "Fn" + Str(Index);
+            W.Open("int " + Name + "(int a, int b)");
+            W.Line("int r = a * " + Str(Index % 13 + 1) + " + b;");
+            W.Open("if (r > " + Str(Index) + ")");
+            W.Line(Index > 0 ? "r = r - Fn" + Str(Index - 1) + "(b, a);" : "r = r - b;");
+            W.Close();
+            W.Line("return r;");
+            W.Close();
+        }
+        W.Line("");
+    }
+
+    void WriteNested(FScriptWriter& W, int32 Unit, int32 Depth)
+    {
+        W.Open("int Nest" + Str(Unit) + "(int n)");
+        W.Line("int acc = 0;");
+        for (int32 d = 0; d < Depth; ++d)
+        {
+            switch (d % 3)
+            {
+                case 0: W.Open("if (n > " + Str(d) + ")"); break;
+                case 1: W.Open("while (acc < " + Str(d * 4) + ")"); break;
+                default: W.Open("for (int i" + Str(d) + " = 0; i" + Str(d) + " < n; i" + Str(d) + " = i" + Str(d) + " + 1)"); break;
+            }
+            W.Line("acc = acc + " + Str(d + 1) + ";");
+        }
+        for (int32 d = 0; d < Depth; ++d)
+        {
+            W.Close();
+        }
+        W.Line("return acc;");
+        W.Close();
+        W.Line("");
+    }
+
+    void WriteSwitch(FScriptWriter& W, int32 Unit, int32 Cases)
+    {
+        // Dense keys compile to a jump table, sparse ones to a sorted key list, strings to
+        // a lookup: one of each in turn
+        const int32 Kind = Unit % 3;
+        W.Open("int Switch" + Str(Unit) + (Kind == 2 ? "(string v)" : "(int v)"));
+        W.Line("int r = 0;");
+        W.Open("switch (v)");
+        for (int32 i = 0; i < Cases; ++i)
+        {
+            const std::string Key = Kind == 0 ? Str(i) : Kind == 1 ? Str(i * 37 - 500) : "\"state" + Str(i) + "\"";
+            W.Line("case " + Key + ": r = " + Str(i * 3 + Unit) + "; break;");
+        }
+        W.Line("default: r = -1;");
+        W.Close();
+        W.Line("return r;");
+        W.Close();
+        W.Line("");
+    }
+
+    void WriteGlobals(FScriptWriter& W, int32 Unit)
+    {
+        const int32 PerUnit = 50;
+        for (int32 i = 0; i < PerUnit; ++i)
+        {
+            const std::string Name = Str(Unit) + "_" + Str(i);
+            switch (i % 3)
+            {
+                case 0: W.Line("int g" + Name + " = " + Str(i) + ";"); break;
+                case 1: W.Line("float f" + Name + " = " + Str(i) + ".5;"); break;
+                default: W.Line("string s" + Name + " = \"global " + Name + "\";"); break;
+            }
+        }
+        W.Line("");
+    }
+
+    void WriteStrings(FScriptWriter& W, int32 Unit)
+    {
+        // Every eighth entry repeats an earlier one, as tables do
+        const int32 Entries = 100;
+        W.Open("string Text" + Str(Unit) + "()");
+        W.Line("string line = \"\";");
+        for (int32 i = 0; i < Entries; ++i)
+        {
+            const int32 Id = (i % 8 == 7) ? i / 2 : i;
+            W.Line("line = \"Table " + Str(Unit) + " entry " + Str(Id) +
+                ": the quick brown fox jumps over the lazy dog while the night watch sleeps\";");
+        }
+        W.Line("return line;");
+        W.Close();
+        W.Line("");
+    }
+}
+
+FString GenerateScript(const FGeneratedScriptOptions& Options)
+{
+    const int32 Depth = FMath::Clamp(Options.NestingDepth, 1, 200);
+    const int32 Cases = FMath::Clamp(Options.SwitchCases, 1, 4096);
+
+    FScriptWriter W;
+    W.Line(std::string("// Generated by ScriptCompiler --generate: ") + GetGeneratedScriptShapeName(Options.Shape) +
+        ", " + Str(Options.Lines) + " lines");
+    W.Line("");
+
+    // Mixed takes each shape in turn, starting over at functions
+    const int32 MainLines = 3;
+    int32 Units[6] = {};
+    for (int32 Next = 0; W.GetNumLines() + MainLines < Options.Lines; ++Next)
+    {
+        EGeneratedScriptShape Shape = Options.Shape;
+        if (Shape == EGeneratedScriptShape::Mixed)
+        {
+            Shape = (EGeneratedScriptShape)(1 + Next % 5);
+        }
+
+        const int32 Unit = Units[(int32)Shape]++;
+        switch (Shape)
+        {
+            case EGeneratedScriptShape::Functions: WriteFunctions(W, Unit); break;
+            case EGeneratedScriptShape::Nested: WriteNested(W, Unit, Depth); break;
+            case EGeneratedScriptShape::Switch: WriteSwitch(W, Unit, Cases); break;
+            case EGeneratedScriptShape::Globals: WriteGlobals(W, Unit); break;
+            default: WriteStrings(W, Unit); break;
+        }
+    }
+
+    W.Open("int Main()");
+    W.Line("return 0;");
+    W.Close();
+    return W.GetSource();
+}
+
+// Where the platform can reset the peak (Linux: VmHWM, reset through clear_refs), each
+// phase gets a peak of its own. Elsewhere it is the peak of the process up to that phase
+static bool ResetPeakMemory()
+{
+#if PLATFORM_LINUX
+    std::ofstream ClearRefs("/proc/self/clear_refs");
+    return static_cast<bool>(ClearRefs << "5");
+#else
+    return false;
+#endif
+}
+
+static int64 GetPhasePeakMemoryKB(bool bWasReset)
+{
+#if PLATFORM_LINUX
+    if (bWasReset)
+    {
+        std::ifstream Status("/proc/self/status");
+        std::string Line;
+        while (std::getline(Status, Line))
+        {
+            if (Line.compare(0, 6, "VmHWM:") == 0)
+            {
+                return std::atoll(Line.c_str() + 6);
+            }
+        }
+    }
+#endif
+    return GetPeakMemoryKB();
+}
+
+int RunScalingBenchmark(const FGeneratedScriptOptions& Options, int32 MaxLines)
+{
+    using FClock = std::chrono::high_resolution_clock;
+    auto MillisSince = [](FClock::time_point Start)
+    {
+        return std::chrono::duration<double, std::milli>(FClock::now() - Start).count();
+    };
+
+    TArray<int32> Sizes;
+    for (int32 Lines = 1000; Lines <= MaxLines; Lines *= 10)
+    {
+        Sizes.Add(Lines);
+    }
+    if (Sizes.Num() == 0)
+    {
+        Sizes.Add(MaxLines);
+    }
+
+    enum EPhase { Lex, Parse, Compile, Serialize, NumPhases };
+    static const char* PhaseNames[NumPhases] = { "Lex", "Parse", "Compile", "Serialize" };
+    struct FSizeResult
+    {
+        int32 Lines = 0;
+        int64 Bytes = 0;
+        double Ms[NumPhases] = {};
+        int64 PeakKB[NumPhases] = {};
+    };
+    TArray<FSizeResult> Results;
+
+    bool bPhasePeaks = true;
+    std::cout << "[BENCH] Shape: " << GetGeneratedScriptShapeName(Options.Shape) << ", nesting " << Options.NestingDepth
+              << ", " << Options.SwitchCases << " cases per switch" << std::endl;
+    std::cout << "[BENCH]     Lines      Bytes     Tokens  Constants   Code KB |  Lex ms  Parse ms  Compile ms  Serialize ms"
+              << " | Peak MB: lex  parse  compile  serialize" << std::endl;
+
+    for (int32 Lines : Sizes)
+    {
+        FGeneratedScriptOptions SizeOptions = Options;
+        SizeOptions.Lines = Lines;
+        const FString Source = GenerateScript(SizeOptions);
+
+        FSizeResult Result;
+        int32 NumTokens = 0, NumConstants = 0, CodeBytes = 0;
+
+        // Best of three where that is quick; the peaks are those of the last run
+        const int32 Runs = Lines <= 100000 ? 3 : 1;
+        for (int32 Run = 0; Run < Runs; ++Run)
+        {
+            double Ms[NumPhases];
+
+            bool bReset = ResetPeakMemory();
+            auto Start = FClock::now();
+            FScriptLexer Lexer(Source);
+            TArray<FScriptToken> Tokens = Lexer.ScanTokens();
+            Ms[Lex] = MillisSince(Start);
+            Result.PeakKB[Lex] = GetPhasePeakMemoryKB(bReset);
+            if (Lexer.HasErrors())
+            {
+                LOG_ERROR("Scaling benchmark: generated script failed to lex (" + Str(Lines) + " lines)");
+                return 1;
+            }
+            NumTokens = Tokens.Num();
+
+            bReset = ResetPeakMemory();
+            Start = FClock::now();
+            FScriptParser Parser(MoveTemp(Tokens));
+            TSharedPtr<FScriptProgram> Program = Parser.Parse();
+            Ms[Parse] = MillisSince(Start);
+            Result.PeakKB[Parse] = GetPhasePeakMemoryKB(bReset);
+            if (!Program.IsValid() || Parser.HasErrors())
+            {
+                LOG_ERROR("Scaling benchmark: generated script failed to parse (" + Str(Lines) + " lines)");
+                return 1;
+            }
+
+            bReset = ResetPeakMemory();
+            GStandaloneScriptLogMuted = true;
+            FScriptCompiler Compiler;
+            Start = FClock::now();
+            TSharedPtr<FBytecodeChunk> Chunk = Compiler.Compile(Program);
+            Ms[Compile] = MillisSince(Start);
+            GStandaloneScriptLogMuted = false;
+            Result.PeakKB[Compile] = GetPhasePeakMemoryKB(bReset);
+            if (!Chunk.IsValid() || Compiler.HasErrors())
+            {
+                LOG_ERROR("Scaling benchmark: generated script failed to compile (" + Str(Lines) + " lines)");
+                for (const FString& Error : Compiler.GetErrors())
+                {
+                    LOG_ERROR("  " + Error);
+                }
+                return 1;
+            }
+            NumConstants = Chunk->Constants.Num();
+            CodeBytes = Chunk->Code.Num();
+
+            bReset = ResetPeakMemory();
+            TArray<uint8> Data;
+            Start = FClock::now();
+            FScriptBytecodeFile::Write(*Chunk, Data);
+            Ms[Serialize] = MillisSince(Start);
+            Result.PeakKB[Serialize] = GetPhasePeakMemoryKB(bReset);
+
+            bPhasePeaks = bPhasePeaks && bReset;
+            for (int32 Phase = 0; Phase < NumPhases; ++Phase)
+            {
+                Result.Ms[Phase] = (Run == 0) ? Ms[Phase] : FMath::Min(Result.Ms[Phase], Ms[Phase]);
+            }
+        }
+
+        Result.Lines = Lines;
+        Result.Bytes = Source.Len();
+        Results.Add(Result);
+
+        char Row[256];
+        std::snprintf(Row, sizeof(Row), "%10d %10lld %10d %10d %9d | %7.2f %9.2f %11.2f %13.2f | %12.1f %6.1f %8.1f %10.1f",
+            Lines, (long long)Result.Bytes, NumTokens, NumConstants, CodeBytes / 1024,
+            Result.Ms[Lex], Result.Ms[Parse], Result.Ms[Compile], Result.Ms[Serialize],
+            Result.PeakKB[Lex] / 1024.0, Result.PeakKB[Parse] / 1024.0, Result.PeakKB[Compile] / 1024.0, Result.PeakKB[Serialize] / 1024.0);
+        std::cout << "[BENCH] " << Row << std::endl;
+    }
+    if (!bPhasePeaks)
+    {
+        std::cout << "[BENCH] (peaks are of the process so far: this platform cannot reset them per phase)" << std::endl;
+    }
+
+    // Growth of each phase from one size to the next as an exponent: 1 is linear, 2 is
+    // quadratic. Steps under 20 ms are mostly noise and only printed
+    const double MinMsToJudge = 20.0;
+    const double MaxExponent = 1.4;
+    bool bSuperlinear = false;
+    for (int32 i = 1; i < Results.Num(); ++i)
+    {
+        const FSizeResult& Small = Results[i - 1];
+        const FSizeResult& Large = Results[i];
+        std::ostringstream Line;
+        Line << "[BENCH] Growth " << Small.Lines << " -> " << Large.Lines << " lines:";
+        for (int32 Phase = 0; Phase < NumPhases; ++Phase)
+        {
+            if (Small.Ms[Phase] <= 0.0 || Large.Ms[Phase] <= 0.0)
+            {
+                continue;
+            }
+            const double Exponent = std::log(Large.Ms[Phase] / Small.Ms[Phase]) / std::log((double)Large.Lines / Small.Lines);
+            char Item[64];
+            std::snprintf(Item, sizeof(Item), " %s n^%.2f", PhaseNames[Phase], Exponent);
+            Line << Item;
+            if (Exponent > MaxExponent && Large.Ms[Phase] >= MinMsToJudge)
+            {
+                Line << " (superlinear)";
+                bSuperlinear = true;
+            }
+        }
+        std::cout << Line.str() << std::endl;
+    }
+
+    if (bSuperlinear)
+    {
+        LOG_ERROR("Scaling benchmark: a phase grows faster than the script");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,42 @@
+// Standalone Script Compiler - synthetic scripts
+// Generates valid scripts of a given size and shape, and measures how the compiler scales on them
+
+#pragma once
+
+#include "Platform.h"
+
+/** What a generated script is mostly made of */
+enum class EGeneratedScriptShape : uint8
+{
+    Mixed,      // All of the below, in turn
+    Functions,  // Many small functions calling each other
+    Nested,     // Functions of deeply nested if/while/for blocks
+    Switch,     // Functions of one big switch: dense, sparse and string keys
+    Globals,    // Thousands of int, float and string globals
+    Strings     // Long string tables, some entries repeated
+};
+
+struct FGeneratedScriptOptions
+{
+    int32 Lines = 1000;                                  // Roughly: whole units are generated until it is reached
+    EGeneratedScriptShape Shape = EGeneratedScriptShape::Mixed;
+    int32 NestingDepth = 16;                             // Blocks per nested function
+    int32 SwitchCases = 200;                             // Cases per switch
+};
+
+/** Shape from its name on the command line ("mixed", "functions", ...), false if there is none */
+bool ParseGeneratedScriptShape(const FString& Name, EGeneratedScriptShape& OutShape);
+const char* GetGeneratedScriptShapeName(EGeneratedScriptShape Shape);
+
+/** A script that compiles, with a Main() that returns 0. The same options give the same script */
+FString GenerateScript(const FGeneratedScriptOptions& Options);
+
+/**
+ * Lex, parse, compile and serialize generated scripts of 1k, 10k, ... lines up to MaxLines,
+ * reporting the time and the peak memory of each phase per size, and how each phase grows
+ * from one size to the next. A phase growing clearly faster than the script fails the run.
+ */
+int RunScalingBenchmark(const FGeneratedScriptOptions& Options, int32 MaxLines);
+
+/** Peak working set of the process so far, in KB (0 where unknown) - StandaloneMain.cpp */
+int64 GetPeakMemoryKB();
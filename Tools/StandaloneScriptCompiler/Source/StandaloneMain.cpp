@@ -8,9 +8,27 @@
 #include "ScriptParser.h"
 #include "ScriptCompiler.h"
 #include "ScriptBytecode.h"
+#include "ScriptBytecodeFile.h"
+#include "ScriptBytecodeVerifier.h"
+#include "ScriptVM.h"
+#include "ScriptProfile.h"
+#include "ScriptLinker.h"
+#include "ScriptBatchCompiler.h"
+#include "ScriptCompileDatabase.h"
+#include "StandaloneServer.h"
+#include "StandaloneGenerator.h"
 
 #include <iostream>
+#include <sstream>
 #include <chrono>
+#include <filesystem>
+#include <algorithm>
+
+#if PLATFORM_WINDOWS
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
 
 void PrintUsage()
 {
@@ -23,55 +41,2215 @@ void PrintUsage()
     std::cout << "  -o <file>     Output file (default: same name as input with .scc extension)\n";
     std::cout << "  -d            Save decompiled .txt file for verification\n";
     std::cout << "  -v            Verbose output\n";
+    std::cout << "  -r, --run     Execute the compiled script in the VM (calls Main() if present)\n";
+    std::cout << "  --no-inline   Compile every script function call as a call (no inlining)\n";
+    std::cout << "  -O            Compile function bodies through the SSA optimizer\n";
+    std::cout << "  --diff-opt    Run the script compiled with and without -O and compare the output\n";
+    std::cout << "  -R, --register  Also emit register code and run it on the register VM\n";
+    std::cout << "  --bench-snapshot <N>  Measure VM snapshot size and capture/restore/fork time over N iterations\n";
+    std::cout << "  --bench-instances <N> Run N VM instances off one shared program image\n";
+    std::cout << "  --bench-dispatch <N>  Run the script N times through the checked and the verified dispatch loop\n";
+    std::cout << "  --bench-backend <N>   Run the script N times on the stack VM and the register VM and compare\n";
+    std::cout << "  --bench-constants <N> Compile a generated script of N literals with and without the constant index\n";
+    std::cout << "  --bench-frontend <N>  Lex, parse and compile a generated script of N functions and report MB/s and peak memory\n";
+    std::cout << "  --generate <N>        Write a generated script of about N lines to -o <file> (default Generated.sbs)\n";
+    std::cout << "  --shape <name>        Of generated scripts: mixed (default), functions, nested, switch, globals or strings\n";
+    std::cout << "  --nesting <N>         Of generated scripts: blocks per nested function (default 16)\n";
+    std::cout << "  --switch-cases <N>    Of generated scripts: cases per switch (default 200)\n";
+    std::cout << "  --bench-scaling <N>   Lex, parse, compile and serialize generated scripts of 1k, 10k, ... up to N lines\n";
+    std::cout << "  --record-profile <file>  Run the script on a profiling VM and write a .scprof profile\n";
+    std::cout << "  --profile <file>      Compile against a .scprof profile (branch layout, number opcodes, inlining)\n";
+    std::cout << "  --bench-profile <N>   With --profile: run the script N times built with and without it and compare\n";
+    std::cout << "  --separate    Compile imported headers as modules and link them in\n";
+    std::cout << "  --objects <dir>  With --separate: also write the script and its modules as .sbo objects to <dir>\n";
+    std::cout << "  --header-cache <dir>  Like --separate, reusing header artifacts (.sbh) in <dir> while the headers are unchanged\n";
+    std::cout << "  --test-header-cache   Check that header artifacts are reused and invalidated as the headers change\n";
+    std::cout << "  --compile-all <dir>   Compile every script in <dir> against one module cache, into -o <dir> (default <dir>/Compiled)\n";
+    std::cout << "  --build <dir>         Like --compile-all, skipping scripts whose source, imports and options are unchanged\n";
+    std::cout << "  -j <N>        With --compile-all or --build: compile on N workers (default: one per core)\n";
+    std::cout << "  --test-compile-db     Check that --build recompiles exactly the scripts whose inputs changed\n";
+    std::cout << "  <input.sbo>   Load a script object and the module objects beside it, link, then save/run as usual\n";
+    std::cout << "  --bench-link <N>  Compile N generated scripts sharing one header, in one piece and as linked modules\n";
+    std::cout << "  <input.scc>   Load a compiled script (either format) as the game does, then describe/run it\n";
+    std::cout << "  --test-verifier       Check that corrupt register-code files are rejected at load\n";
+    std::cout << "  --bench-load <N>  Write N compiled scripts in both formats and time loading them back\n";
+    std::cout << "  --server      Serve compiles on a local socket, keeping natives and compiled headers warm\n";
+    std::cout << "  --client ...  Send the rest of the command line to the server and print what it prints\n";
+    std::cout << "  --stop-server Stop the server\n";
+    std::cout << "  --socket <path>  Socket of the server (default: ScriptCompiler.sock in $XDG_RUNTIME_DIR, else ScriptCompiler-<user>/server.sock in the temp directory)\n";
+    std::cout << "  --bench-server <N>  Compile the script N times as new processes and through a server and compare\n";
     std::cout << "  --help        Show this help message\n\n";
     std::cout << "Examples:\n";
     std::cout << "  ScriptCompiler MyScript.sc\n";
     std::cout << "  ScriptCompiler MyScript.sc -o Compiled/MyScript.scc\n";
     std::cout << "  ScriptCompiler MyScript.sc -d -v\n";
+    std::cout << "  ScriptCompiler MyScript.sc -r --bench-snapshot 1000\n";
+    std::cout << "  ScriptCompiler MyScript.sc --diff-opt\n";
+    std::cout << "  ScriptCompiler MyScript.sc -R -r\n";
+    std::cout << "  ScriptCompiler --bench-constants 50000\n";
+    std::cout << "  ScriptCompiler --bench-frontend 2000\n";
+    std::cout << "  ScriptCompiler --generate 10000 --shape switch -o Switches.sbs\n";
+    std::cout << "  ScriptCompiler --bench-scaling 1000000\n";
+    std::cout << "  ScriptCompiler MyScript.sc --record-profile MyScript.scprof\n";
+    std::cout << "  ScriptCompiler MyScript.sc --profile MyScript.scprof --bench-profile 100\n";
+    std::cout << "  ScriptCompiler MyScript.sc --separate --objects Objects\n";
+    std::cout << "  ScriptCompiler MyScript.sc --header-cache Scripts/Compiled/Headers -r\n";
+    std::cout << "  ScriptCompiler --compile-all Scripts -j 8\n";
+    std::cout << "  ScriptCompiler --build Scripts\n";
+    std::cout << "  ScriptCompiler Objects/MyScript.sbo -r\n";
+    std::cout << "  ScriptCompiler --bench-link 50\n";
+    std::cout << "  ScriptCompiler Compiled/MyScript.scc -r\n";
+    std::cout << "  ScriptCompiler --bench-load 1000\n";
+    std::cout << "  ScriptCompiler --server &\n";
+    std::cout << "  ScriptCompiler --client MyScript.sc -o Compiled/MyScript.scc\n";
+    std::cout << "  ScriptCompiler MyScript.sc --bench-server 50\n";
 }
 
-int main(int argc, char* argv[])
+// Console implementations of the core natives so scripts can run outside the game
+namespace StandaloneNatives
 {
-    if (argc < 2)
+    double RandomFloat() { return FMath::FRandRange(0.0f, 1.0f); }
+    double RandomRange(double Min, double Max) { return FMath::FRandRange((float)Min, (float)Max); }
+    bool RandomBool() { return FMath::RandRange(0, 1) == 1; }
+
+    double Abs(double Value) { return std::fabs(Value); }
+    double Sqrt(FScriptVM* VM, double Value)
     {
-        PrintUsage();
+        if (Value < 0.0) { VM->RuntimeError(TEXT("Sqrt negative input")); return 0.0; }
+        return std::sqrt(Value);
+    }
+    double Sin(double Value) { return std::sin(Value); }
+    double Cos(double Value) { return std::cos(Value); }
+    double Floor(double Value) { return std::floor(Value); }
+    double Min(double A, double B) { return A < B ? A : B; }
+    double Max(double A, double B) { return A > B ? A : B; }
+
+    int32 StringLen(const FString& Str) { return Str.Len(); }
+    FString StringUpper(const FString& Str) { return FStringImpl::ToUpper(Str); }
+}
+
+// Bound once into the process-wide registry, then frozen. Runs before compiling so
+// call sites of typed natives get checked by the compiler
+void RegisterStandaloneNatives()
+{
+    FScriptNativeRegistry& Registry = FScriptNativeRegistry::Get();
+    if (Registry.IsFrozen())
+    {
+        return;
+    }
+    
+    auto LogToConsole = [](const char* Prefix)
+    {
+        return [Prefix](FScriptVM*, const TArray<FScriptValue>& Args) -> FScriptValue
+        {
+            std::cout << Prefix << (Args.Num() > 0 ? Args[0].ToString() : FString()) << std::endl;
+            return FScriptValue::Nil();
+        };
+    };
+    
+    Registry.Bind("Log", LogToConsole("[SCRIPT] "));
+    Registry.Bind("Print", LogToConsole("[SCRIPT] "));
+    Registry.BindTyped("RandomFloat", StandaloneNatives::RandomFloat);
+    Registry.BindTyped("RandomRange", StandaloneNatives::RandomRange);
+    Registry.BindTyped("RandomBool", StandaloneNatives::RandomBool);
+    Registry.BindTyped("Abs", StandaloneNatives::Abs);
+    Registry.BindTyped("Sqrt", StandaloneNatives::Sqrt);
+    Registry.BindTyped("Sin", StandaloneNatives::Sin);
+    Registry.BindTyped("Cos", StandaloneNatives::Cos);
+    Registry.BindTyped("Floor", StandaloneNatives::Floor);
+    Registry.BindTyped("Min", StandaloneNatives::Min);
+    Registry.BindTyped("Max", StandaloneNatives::Max);
+    Registry.BindTyped("String_Len", StandaloneNatives::StringLen);
+    Registry.BindTyped("String_Upper", StandaloneNatives::StringUpper);
+    
+    Registry.Freeze();
+}
+
+// Execute a chunk to completion. Returns the VM so callers can inspect/snapshot it
+TSharedPtr<FScriptVM> RunBytecode(TSharedPtr<FBytecodeChunk> Bytecode, bool bCallMain, EScriptBackend Backend = EScriptBackend::Stack)
+{
+    TSharedPtr<FScriptVM> VM = MakeShared<FScriptVM>();
+    VM->SetBackend(Backend);
+    RegisterStandaloneNatives();
+    
+    if (!VM->Execute(Bytecode))
+    {
+        return VM;
+    }
+    if (bCallMain)
+    {
+        VM->CallMainIfExists();
+    }
+    return VM;
+}
+
+// Snapshot benchmark: state is captured after top-level code has run (globals defined),
+// which is the "fast restart" point a game would save
+int RunSnapshotBenchmark(TSharedPtr<FBytecodeChunk> Bytecode, int32 Iterations)
+{
+    using FClock = std::chrono::high_resolution_clock;
+    auto MicrosSince = [](FClock::time_point Start)
+    {
+        return std::chrono::duration<double, std::micro>(FClock::now() - Start).count();
+    };
+    
+    TSharedPtr<FScriptVM> VM = RunBytecode(Bytecode, false);
+    if (VM->HasErrors())
+    {
+        LOG_ERROR("Snapshot benchmark: script failed to execute");
         return 1;
     }
     
-    // Parse arguments
-    FString InputFile;
-    FString OutputFile;
-    bool bSaveDecompiled = false;
-    bool bVerbose = false;
+    FVMSnapshot Snapshot;
+    TArray<uint8> Blob;
+    double CaptureUs = 0.0, SerializeUs = 0.0, DeserializeUs = 0.0, RestoreUs = 0.0, ForkUs = 0.0;
     
-    for (int i = 1; i < argc; ++i)
+    TSharedPtr<FScriptVM> Target = MakeShared<FScriptVM>();
+    RegisterStandaloneNatives();
+    
+    for (int32 i = 0; i < Iterations; ++i)
     {
-        FString arg = argv[i];
+        auto Start = FClock::now();
+        VM->CaptureSnapshot(Snapshot);
+        CaptureUs += MicrosSince(Start);
         
-        if (arg == "--help" || arg == "-h")
+        Start = FClock::now();
+        Snapshot.Serialize(Blob);
+        SerializeUs += MicrosSince(Start);
+        
+        FVMSnapshot Loaded;
+        Start = FClock::now();
+        if (!Loaded.Deserialize(Blob))
+        {
+            LOG_ERROR("Snapshot benchmark: failed to deserialize snapshot");
+            return 1;
+        }
+        DeserializeUs += MicrosSince(Start);
+        
+        Start = FClock::now();
+        if (!Target->RestoreSnapshot(Loaded, VM->GetProgram()))
+        {
+            LOG_ERROR("Snapshot benchmark: failed to restore snapshot");
+            return 1;
+        }
+        RestoreUs += MicrosSince(Start);
+        
+        Start = FClock::now();
+        TSharedPtr<FScriptVM> Child = VM->Fork();
+        ForkUs += MicrosSince(Start);
+    }
+    
+    // The restored VM must be able to carry on exactly like the original
+    bool bOriginalMain = VM->CallMainIfExists();
+    bool bRestoredMain = Target->CallMainIfExists();
+    
+    const double N = Iterations > 0 ? Iterations : 1;
+    std::cout << "[BENCH] Snapshot iterations:   " << Iterations << std::endl;
+    std::cout << "[BENCH] Snapshot size:         " << Blob.Num() << " bytes (stack " << Snapshot.Stack.Num()
+              << ", frames " << Snapshot.CallFrames.Num() << ", globals " << (Snapshot.Globals.IsValid() ? Snapshot.Globals->Num() : 0) << ")" << std::endl;
+    std::cout << "[BENCH] Capture (COW):         " << CaptureUs / N << " us" << std::endl;
+    std::cout << "[BENCH] Serialize:             " << SerializeUs / N << " us" << std::endl;
+    std::cout << "[BENCH] Deserialize:           " << DeserializeUs / N << " us" << std::endl;
+    std::cout << "[BENCH] Restore:               " << RestoreUs / N << " us" << std::endl;
+    std::cout << "[BENCH] Fork:                  " << ForkUs / N << " us" << std::endl;
+    std::cout << "[BENCH] Resume after restore:  " << ((bOriginalMain == bRestoredMain && !Target->HasErrors()) ? "OK" : "MISMATCH") << std::endl;
+    return (bOriginalMain == bRestoredMain && !Target->HasErrors()) ? 0 : 1;
+}
+
+// Instance benchmark: one program image, many execution contexts (e.g. one per ped)
+int RunInstanceBenchmark(TSharedPtr<FBytecodeChunk> Bytecode, int32 Count)
+{
+    using FClock = std::chrono::high_resolution_clock;
+    auto MicrosSince = [](FClock::time_point Start)
+    {
+        return std::chrono::duration<double, std::micro>(FClock::now() - Start).count();
+    };
+    
+    RegisterStandaloneNatives();
+    
+    auto Start = FClock::now();
+    TArray<FString> Errors;
+    TSharedPtr<const FScriptProgramImage> Program = FScriptProgramImage::Create(Bytecode, FScriptNativeRegistry::Get(), Errors);
+    double ImageUs = MicrosSince(Start);
+    if (!Program.IsValid())
+    {
+        for (const FString& Error : Errors)
+        {
+            LOG_ERROR(Error);
+        }
+        return 1;
+    }
+    
+    TArray<TSharedPtr<FScriptVM>> Instances;
+    Instances.Reserve(Count);
+    
+    Start = FClock::now();
+    for (int32 i = 0; i < Count; ++i)
+    {
+        Instances.Add(MakeShared<FScriptVM>());
+    }
+    double CreateUs = MicrosSince(Start);
+    
+    Start = FClock::now();
+    int32 Failed = 0;
+    for (TSharedPtr<FScriptVM>& Instance : Instances)
+    {
+        if (!Instance->Execute(Program))
+        {
+            Failed++;
+        }
+    }
+    double ExecuteUs = MicrosSince(Start);
+    
+    const double N = Count > 0 ? Count : 1;
+    std::cout << "[BENCH] Instances:             " << Count << " (" << Failed << " failed)" << std::endl;
+    std::cout << "[BENCH] Program image:         " << Program->GetAllocatedSize() << " bytes, built in " << ImageUs << " us (shared)" << std::endl;
+    std::cout << "[BENCH] Instance size:         " << sizeof(FScriptVM) << " bytes before execution" << std::endl;
+    std::cout << "[BENCH] Create instance:       " << CreateUs / N << " us" << std::endl;
+    std::cout << "[BENCH] Execute per instance:  " << ExecuteUs / N << " us" << std::endl;
+    return Failed == 0 ? 0 : 1;
+}
+
+// Dispatch benchmark: the same verified program through both builds of the dispatch loop
+int RunDispatchBenchmark(TSharedPtr<FBytecodeChunk> Bytecode, int32 Iterations)
+{
+    using FClock = std::chrono::high_resolution_clock;
+    auto MicrosSince = [](FClock::time_point Start)
+    {
+        return std::chrono::duration<double, std::micro>(FClock::now() - Start).count();
+    };
+    
+    RegisterStandaloneNatives();
+    
+    TArray<FString> Errors;
+    TSharedPtr<const FScriptProgramImage> Program = FScriptProgramImage::Create(Bytecode, FScriptNativeRegistry::Get(), Errors);
+    if (!Program.IsValid())
+    {
+        for (const FString& Error : Errors)
+        {
+            LOG_ERROR(Error);
+        }
+        return 1;
+    }
+    
+    int32 InstructionsPerRun = 0;
+    auto RunAll = [&](bool bUnchecked, int32& OutFailed) -> double
+    {
+        FScriptVM::FExecutionLimits Limits;
+        Limits.bAllowUncheckedDispatch = bUnchecked;
+        OutFailed = 0;
+        
+        auto Start = FClock::now();
+        for (int32 i = 0; i < Iterations; ++i)
+        {
+            FScriptVM VM;
+            VM.SetExecutionLimits(Limits);
+            if (!VM.Execute(Program) || (VM.CallMainIfExists() && VM.HasErrors()))
+            {
+                OutFailed++;
+            }
+            InstructionsPerRun = VM.GetInstructionCount();
+        }
+        return MicrosSince(Start);
+    };
+    
+    int32 CheckedFailed = 0;
+    int32 UncheckedFailed = 0;
+    const double CheckedUs = RunAll(false, CheckedFailed);
+    const double UncheckedUs = RunAll(true, UncheckedFailed);
+    
+    const double N = Iterations > 0 ? Iterations : 1;
+    std::cout << "[BENCH] Dispatch iterations:   " << Iterations << std::endl;
+    std::cout << "[BENCH] Instructions per run:  " << InstructionsPerRun << std::endl;
+    std::cout << "[BENCH] Program verified:      " << (Program->IsVerified() ? "YES" : "NO (both runs checked)") << std::endl;
+    std::cout << "[BENCH] Checked dispatch:      " << CheckedUs / N << " us per run" << std::endl;
+    std::cout << "[BENCH] Verified dispatch:     " << UncheckedUs / N << " us per run" << std::endl;
+    if (UncheckedUs > 0.0)
+    {
+        std::cout << "[BENCH] Speedup:               " << CheckedUs / UncheckedUs << "x" << std::endl;
+    }
+    return (CheckedFailed == 0 && UncheckedFailed == 0) ? 0 : 1;
+}
+
+// Backend benchmark: one build carrying both stack and register code, run on each VM.
+// Functions the register lowering rejected run as stack code in both runs
+int RunBackendBenchmark(TSharedPtr<FBytecodeChunk> Bytecode, int32 Iterations)
+{
+    using FClock = std::chrono::high_resolution_clock;
+    auto MicrosSince = [](FClock::time_point Start)
+    {
+        return std::chrono::duration<double, std::micro>(FClock::now() - Start).count();
+    };
+    
+    RegisterStandaloneNatives();
+    
+    TArray<FString> Errors;
+    TSharedPtr<const FScriptProgramImage> Program = FScriptProgramImage::Create(Bytecode, FScriptNativeRegistry::Get(), Errors);
+    if (!Program.IsValid())
+    {
+        for (const FString& Error : Errors)
+        {
+            LOG_ERROR(Error);
+        }
+        return 1;
+    }
+    
+    int32 Lowered = 0;
+    for (const FFunctionInfo& Function : Bytecode->Functions)
+    {
+        if (Function.RegisterAddress != INDEX_NONE)
+        {
+            Lowered++;
+        }
+    }
+    
+    auto RunAll = [&](EScriptBackend Backend, int32& OutInstructions, FString& OutOutput, bool& bOutFailed) -> double
+    {
+        bOutFailed = false;
+        double Elapsed = 0.0;
+        for (int32 i = 0; i < Iterations; ++i)
+        {
+            std::ostringstream Output;
+            std::streambuf* Saved = std::cout.rdbuf(Output.rdbuf());
+            std::srand(1);
+            FScriptVM VM;
+            VM.SetBackend(Backend);
+            auto Start = FClock::now();
+            if (!VM.Execute(Program) || (VM.CallMainIfExists() && VM.HasErrors()))
+            {
+                bOutFailed = true;
+            }
+            Elapsed += MicrosSince(Start);
+            std::cout.rdbuf(Saved);
+            OutInstructions = VM.GetInstructionCount();
+            OutOutput = Output.str();
+        }
+        return Elapsed;
+    };
+    
+    int32 StackInstructions = 0;
+    int32 RegisterInstructions = 0;
+    FString StackOutput;
+    FString RegisterOutput;
+    bool bStackFailed = false;
+    bool bRegisterFailed = false;
+    const double StackUs = RunAll(EScriptBackend::Stack, StackInstructions, StackOutput, bStackFailed);
+    const double RegisterUs = RunAll(EScriptBackend::Register, RegisterInstructions, RegisterOutput, bRegisterFailed);
+    
+    const double N = Iterations > 0 ? Iterations : 1;
+    std::cout << "[BENCH] Backend iterations:    " << Iterations << std::endl;
+    std::cout << "[BENCH] Register functions:    " << Lowered << " of " << Bytecode->Functions.Num()
+              << " (" << Bytecode->RegisterCode.Num() << " bytes, stack code " << Bytecode->Code.Num() << " bytes)" << std::endl;
+    std::cout << "[BENCH] Stack VM:              " << StackUs / N << " us, " << StackInstructions << " instructions per run" << std::endl;
+    std::cout << "[BENCH] Register VM:           " << RegisterUs / N << " us, " << RegisterInstructions << " instructions per run" << std::endl;
+    if (RegisterUs > 0.0)
+    {
+        std::cout << "[BENCH] Speedup:               " << StackUs / RegisterUs << "x" << std::endl;
+    }
+    if (StackOutput != RegisterOutput || bStackFailed != bRegisterFailed)
+    {
+        LOG_ERROR("Register VM behaves differently");
+        std::cout << "--- stack" << (bStackFailed ? " (failed)" : "") << "\n" << StackOutput;
+        std::cout << "--- register" << (bRegisterFailed ? " (failed)" : "") << "\n" << RegisterOutput;
+        return 1;
+    }
+    std::cout << "[BENCH] Output:                identical" << std::endl;
+    return 0;
+}
+
+// Constant pool benchmark: compile time of a generated script that is mostly literals
+// (think dialogue and tuning tables), with the compiler's hash index and with the linear
+// scan. Every tenth literal repeats an earlier one so lookups also hit
+int RunConstantPoolBenchmark(int32 Literals)
+{
+    using FClock = std::chrono::high_resolution_clock;
+    auto MillisSince = [](FClock::time_point Start)
+    {
+        return std::chrono::duration<double, std::milli>(FClock::now() - Start).count();
+    };
+    
+    const int32 LiteralsPerFunction = 500;
+    std::ostringstream Source;
+    int32 Functions = 0;
+    for (int32 i = 0; i < Literals; ++i)
+    {
+        if (i % LiteralsPerFunction == 0)
+        {
+            if (i > 0)
+            {
+                Source << "    return total;\n}\n\n";
+            }
+            Source << "float Table" << Functions++ << "() {\n    string line = \"\";\n    float total = 0.0;\n";
+        }
+        const int32 Id = (i % 10 == 9) ? i / 2 : i;
+        if (Id % 2 == 0)
+        {
+            Source << "    line = \"dialogue line " << Id << "\";\n";
+        }
+        else
+        {
+            Source << "    total = total + " << Id << ".25;\n";
+        }
+    }
+    if (Literals > 0)
+    {
+        Source << "    return total;\n}\n";
+    }
+    const FString SourceCode = Source.str();
+    
+    FScriptLexer Lexer(SourceCode);
+    FScriptParser Parser(Lexer);
+    TSharedPtr<FScriptProgram> Program = Parser.Parse();
+    if (Lexer.HasErrors() || !Program.IsValid() || Parser.HasErrors())
+    {
+        LOG_ERROR("Constant benchmark: generated script failed to parse");
+        return 1;
+    }
+    
+    RegisterStandaloneNatives();
+    auto CompileTimed = [&](bool bIndexed, TSharedPtr<FBytecodeChunk>& OutChunk) -> double
+    {
+        std::ostringstream Log;
+        std::streambuf* Saved = std::cout.rdbuf(Log.rdbuf());
+        FScriptCompiler Compiler;
+        Compiler.SetConstantIndexEnabled(bIndexed);
+        auto Start = FClock::now();
+        OutChunk = Compiler.Compile(Program);
+        const double Elapsed = MillisSince(Start);
+        std::cout.rdbuf(Saved);
+        if (Compiler.HasErrors())
+        {
+            OutChunk = nullptr;
+        }
+        return Elapsed;
+    };
+    
+    TSharedPtr<FBytecodeChunk> Linear;
+    TSharedPtr<FBytecodeChunk> Indexed;
+    const double LinearMs = CompileTimed(false, Linear);
+    const double IndexedMs = CompileTimed(true, Indexed);
+    if (!Linear.IsValid() || !Indexed.IsValid())
+    {
+        LOG_ERROR("Constant benchmark: generated script failed to compile");
+        return 1;
+    }
+    
+    std::cout << "[BENCH] Literals:              " << Literals << " in " << Functions << " functions ("
+              << SourceCode.Len() << " bytes of source)" << std::endl;
+    std::cout << "[BENCH] Constant pool:         " << Indexed->Constants.Num() << " constants" << std::endl;
+    std::cout << "[BENCH] Linear scan:           " << LinearMs << " ms" << std::endl;
+    std::cout << "[BENCH] Hash index:            " << IndexedMs << " ms" << std::endl;
+    if (IndexedMs > 0.0)
+    {
+        std::cout << "[BENCH] Speedup:               " << LinearMs / IndexedMs << "x" << std::endl;
+    }
+    
+    bool bSame = Linear->Code == Indexed->Code && Linear->Constants.Num() == Indexed->Constants.Num();
+    for (int32 i = 0; bSame && i < Indexed->Constants.Num(); ++i)
+    {
+        bSame = FConstantPoolIndex::IsSameConstant(Linear->Constants[i], Indexed->Constants[i]);
+    }
+    if (!bSame)
+    {
+        LOG_ERROR("Constant benchmark: the two builds differ");
+        return 1;
+    }
+    std::cout << "[BENCH] Bytecode:              identical" << std::endl;
+    return 0;
+}
+
+// Peak working set of the process so far, in KB (0 where unknown)
+int64 GetPeakMemoryKB()
+{
+#if PLATFORM_WINDOWS
+    PROCESS_MEMORY_COUNTERS Counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &Counters, sizeof(Counters)))
+    {
+        return (int64)(Counters.PeakWorkingSetSize / 1024);
+    }
+    return 0;
+#else
+    struct rusage Usage;
+    if (getrusage(RUSAGE_SELF, &Usage) != 0)
+    {
+        return 0;
+    }
+    #if PLATFORM_MAC
+        return (int64)Usage.ru_maxrss / 1024; // Bytes on macOS
+    #else
+        return (int64)Usage.ru_maxrss;
+    #endif
+#endif
+}
+
+// Front-end benchmark: lex, parse and compile a generated script of N functions that
+// covers every kind of statement, then release its tree. Parses with the tokens streamed
+// from the lexer and scanned up front, best of three runs per stage
+int RunFrontEndBenchmark(int32 Functions)
+{
+    using FClock = std::chrono::high_resolution_clock;
+    auto MillisSince = [](FClock::time_point Start)
+    {
+        return std::chrono::duration<double, std::milli>(FClock::now() - Start).count();
+    };
+    
+    std::ostringstream Source;
+    Source << "// Generated by --bench-frontend\n\nint calls = 0;\n\n";
+    for (int32 f = 0; f < Functions; ++f)
+    {
+        Source << "int Work" << f << "(int n, float scale) {\n"
+               << "    int total = " << f << ";\n"
+               << "    int[] weights = [1, 2, 3, 4];\n"
+               << "    for (int k = 0; k < n; k = k + 1) {\n"
+               << "        if (k % 3 == 0 && total > -1000) {\n"
+               << "            total = total + k * 2 - weights[k % 4];\n"
+               << "        } else {\n"
+               << "            total = total - (k + " << f % 17 << ") * 3;\n"
+               << "        }\n"
+               << "    }\n"
+               << "    while (total > 1000) {\n"
+               << "        total = total - 7;\n"
+               << "    }\n"
+               << "    switch (total % 4) {\n"
+               << "        case 0: total = total + 1; break;\n"
+               << "        case 1: total = total * 2; break;\n"
+               << "        default: total = -total;\n"
+               << "    }\n"
+               << "    for (w in weights) {\n"
+               << "        total = total + w;\n"
+               << "    }\n"
+               << "    float blended = (float)total * scale + 0.25;\n"
+               << "    string label = \"work " << f << ": \" + blended;\n"
+               << "    calls = calls + 1;\n"
+               << "    return total;\n"
+               << "}\n\n";
+    }
+    Source << "int Main() {\n    return Work0(10, 0.5);\n}\n";
+    const FString SourceCode = Source.str();
+    const double Megabytes = SourceCode.Len() / (1024.0 * 1024.0);
+    
+    RegisterStandaloneNatives();
+    const int32 Runs = 3;
+    int32 NumTokens = 0, NumNodes = 0;
+    int64 ArenaBytes = 0;
+    
+    // Parse only, streamed first and scanned up front second: the process peak after each
+    // is then the peak of that way of parsing
+    auto ParseStreamed = [&SourceCode]() -> TSharedPtr<FScriptProgram>
+    {
+        FScriptLexer Lexer(SourceCode);
+        FScriptParser Parser(Lexer);
+        TSharedPtr<FScriptProgram> Program = Parser.Parse();
+        return (Lexer.HasErrors() || Parser.HasErrors()) ? nullptr : Program;
+    };
+    
+    double StreamMs = 0.0;
+    for (int32 Run = 0; Run < Runs; ++Run)
+    {
+        auto Start = FClock::now();
+        FScriptLexer Lexer(SourceCode);
+        FScriptParser Parser(Lexer);
+        TSharedPtr<FScriptProgram> Program = Parser.Parse();
+        const double Stream = MillisSince(Start);
+        if (Lexer.HasErrors() || !Program.IsValid() || Parser.HasErrors())
+        {
+            LOG_ERROR("Front-end benchmark: generated script failed to parse");
+            return 1;
+        }
+        NumTokens = Parser.GetNumTokens();
+        NumNodes = Parser.GetArena()->GetNumNodes();
+        ArenaBytes = Parser.GetArena()->GetBytesAllocated();
+        StreamMs = (Run == 0) ? Stream : FMath::Min(StreamMs, Stream);
+    }
+    const int64 StreamPeakKB = GetPeakMemoryKB();
+    
+    double LexMs = 0.0, ParseMs = 0.0;
+    int64 TokenArrayBytes = 0;
+    for (int32 Run = 0; Run < Runs; ++Run)
+    {
+        auto Start = FClock::now();
+        FScriptLexer Lexer(SourceCode);
+        TArray<FScriptToken> Tokens = Lexer.ScanTokens();
+        const double Lex = MillisSince(Start);
+        
+        TokenArrayBytes = Tokens.Num() * (int64)sizeof(FScriptToken);
+        for (const FScriptToken& Token : Tokens)
+        {
+            TokenArrayBytes += Token.Lexeme.Len();
+        }
+        
+        Start = FClock::now();
+        FScriptParser Parser(MoveTemp(Tokens));
+        TSharedPtr<FScriptProgram> Program = Parser.Parse();
+        const double Parse = MillisSince(Start);
+        if (!Program.IsValid() || Parser.HasErrors())
+        {
+            LOG_ERROR("Front-end benchmark: generated script failed to parse");
+            return 1;
+        }
+        
+        LexMs = (Run == 0) ? Lex : FMath::Min(LexMs, Lex);
+        ParseMs = (Run == 0) ? Parse : FMath::Min(ParseMs, Parse);
+    }
+    const int64 ScannedPeakKB = GetPeakMemoryKB();
+    
+    double CompileMs = 0.0, ReleaseMs = 0.0;
+    for (int32 Run = 0; Run < Runs; ++Run)
+    {
+        TSharedPtr<FScriptProgram> Program = ParseStreamed();
+        
+        std::ostringstream Log;
+        std::streambuf* Saved = std::cout.rdbuf(Log.rdbuf());
+        FScriptCompiler Compiler;
+        auto Start = FClock::now();
+        TSharedPtr<FBytecodeChunk> Chunk = Compiler.Compile(Program);
+        const double Compile = MillisSince(Start);
+        std::cout.rdbuf(Saved);
+        if (!Chunk.IsValid() || Compiler.HasErrors())
+        {
+            LOG_ERROR("Front-end benchmark: generated script failed to compile");
+            return 1;
+        }
+        
+        // The parser is gone: the program holds the last handle on the arena
+        Start = FClock::now();
+        Program.Reset();
+        const double Release = MillisSince(Start);
+        
+        CompileMs = (Run == 0) ? Compile : FMath::Min(CompileMs, Compile);
+        ReleaseMs = (Run == 0) ? Release : FMath::Min(ReleaseMs, Release);
+    }
+    
+    auto Throughput = [Megabytes](double Ms)
+    {
+        return Ms > 0.0 ? Megabytes * 1000.0 / Ms : 0.0;
+    };
+    std::cout << "[BENCH] Source:                " << Functions << " functions, " << SourceCode.Len() << " bytes, "
+              << NumTokens << " tokens" << std::endl;
+    std::cout << "[BENCH] AST:                   " << NumNodes << " nodes in " << ArenaBytes / 1024 << " KB of arena" << std::endl;
+    std::cout << "[BENCH] Lex + parse, streamed: " << StreamMs << " ms (" << Throughput(StreamMs) << " MB/s), "
+              << FScriptParser::GetRingBytes() << " bytes of tokens held" << std::endl;
+    std::cout << "[BENCH] Lex, scanned up front: " << LexMs << " ms (" << Throughput(LexMs) << " MB/s), "
+              << TokenArrayBytes / 1024 << " KB of tokens held" << std::endl;
+    std::cout << "[BENCH] Parse, scanned tokens: " << ParseMs << " ms (" << Throughput(ParseMs) << " MB/s)" << std::endl;
+    std::cout << "[BENCH] Compile:               " << CompileMs << " ms (" << Throughput(CompileMs) << " MB/s)" << std::endl;
+    std::cout << "[BENCH] Release tree:          " << ReleaseMs << " ms" << std::endl;
+    std::cout << "[BENCH] Front end:             " << Throughput(StreamMs + CompileMs) << " MB/s" << std::endl;
+    std::cout << "[BENCH] Peak memory, parsing:  " << StreamPeakKB / 1024 << " MB streamed, "
+              << ScannedPeakKB / 1024 << " MB scanned up front (source and tree included)" << std::endl;
+    return 0;
+}
+
+// Profile recording: one run of top-level code and Main() on the checked loop, counted
+// per instruction and folded onto source lines
+int RecordScriptProfile(TSharedPtr<FBytecodeChunk> Bytecode, const FString& ProfileFile)
+{
+    RegisterStandaloneNatives();
+    FScriptVM VM;
+    VM.SetProfilingEnabled(true);
+    if (VM.Execute(Bytecode))
+    {
+        VM.CallMainIfExists();
+    }
+    const bool bOk = !VM.HasErrors();
+    
+    FScriptProfile Profile;
+    Profile.AddRun(*Bytecode, VM.GetProfileCounters());
+    if (!Profile.SaveToFile(ProfileFile))
+    {
+        LOG_ERROR("Failed to write profile: " + ProfileFile);
+        return 1;
+    }
+    LOG_INFO("Profile: " + ProfileFile + " (" + std::to_string(VM.GetInstructionCount()) + " instructions, " +
+        std::to_string(Profile.GetTotalCalls()) + " calls)");
+    if (!bOk)
+    {
+        LOG_WARNING("The profiled run failed - the profile covers the code up to the error");
+    }
+    return 0;
+}
+
+// Profile benchmark: the script built without and with the profile, each run on the
+// verified dispatch loop. Both runs see the same random sequence and must print the same
+int RunProfileBenchmark(TSharedPtr<FScriptProgram> Program, TSharedPtr<FBytecodeChunk> Profiled, bool bInline, bool bOptimize, int32 Iterations)
+{
+    using FClock = std::chrono::high_resolution_clock;
+    auto MicrosSince = [](FClock::time_point Start)
+    {
+        return std::chrono::duration<double, std::micro>(FClock::now() - Start).count();
+    };
+    
+    FScriptCompiler Compiler;
+    Compiler.SetInliningEnabled(bInline);
+    Compiler.SetOptimizationEnabled(bOptimize);
+    TSharedPtr<FBytecodeChunk> Baseline = Compiler.Compile(Program);
+    if (!Baseline.IsValid() || Compiler.HasErrors())
+    {
+        LOG_ERROR("Profile benchmark: baseline build failed to compile");
+        return 1;
+    }
+    Baseline->Metadata = Profiled->Metadata;
+    Baseline->Signature = Baseline->GenerateSignature();
+    
+    RegisterStandaloneNatives();
+    TArray<FString> Errors;
+    TSharedPtr<const FScriptProgramImage> BaselineImage = FScriptProgramImage::Create(Baseline, FScriptNativeRegistry::Get(), Errors);
+    TSharedPtr<const FScriptProgramImage> ProfiledImage = FScriptProgramImage::Create(Profiled, FScriptNativeRegistry::Get(), Errors);
+    if (!BaselineImage.IsValid() || !ProfiledImage.IsValid())
+    {
+        LOG_ERROR("Profile benchmark: bytecode rejected");
+        for (const auto& Error : Errors)
+        {
+            LOG_ERROR("  " + Error);
+        }
+        return 1;
+    }
+    
+    auto RunOnce = [&](TSharedPtr<const FScriptProgramImage> Image, int32& OutInstructions, FString& OutOutput, bool& bOutFailed) -> double
+    {
+        std::ostringstream Output;
+        std::streambuf* Saved = std::cout.rdbuf(Output.rdbuf());
+        std::srand(1);
+        FScriptVM VM;
+        auto Start = FClock::now();
+        bOutFailed = !VM.Execute(Image) || (VM.CallMainIfExists() && VM.HasErrors());
+        const double Elapsed = MicrosSince(Start);
+        std::cout.rdbuf(Saved);
+        OutInstructions = VM.GetInstructionCount();
+        OutOutput = Output.str();
+        return Elapsed;
+    };
+    
+    // Interleaved, so neither build gets the warm caches
+    int32 BaselineInstructions = 0;
+    int32 ProfiledInstructions = 0;
+    FString BaselineOutput;
+    FString ProfiledOutput;
+    bool bBaselineFailed = false;
+    bool bProfiledFailed = false;
+    double BaselineUs = 0.0;
+    double ProfiledUs = 0.0;
+    for (int32 i = 0; i < Iterations; ++i)
+    {
+        BaselineUs += RunOnce(BaselineImage, BaselineInstructions, BaselineOutput, bBaselineFailed);
+        ProfiledUs += RunOnce(ProfiledImage, ProfiledInstructions, ProfiledOutput, bProfiledFailed);
+    }
+    
+    const double N = Iterations > 0 ? Iterations : 1;
+    std::cout << "[BENCH] Profile iterations:    " << Iterations << std::endl;
+    std::cout << "[BENCH] Baseline build:        " << BaselineUs / N << " us, " << BaselineInstructions << " instructions per run ("
+              << Baseline->Code.Num() << " bytes)" << std::endl;
+    std::cout << "[BENCH] Profiled build:        " << ProfiledUs / N << " us, " << ProfiledInstructions << " instructions per run ("
+              << Profiled->Code.Num() << " bytes)" << std::endl;
+    if (ProfiledUs > 0.0)
+    {
+        std::cout << "[BENCH] Speedup:               " << BaselineUs / ProfiledUs << "x" << std::endl;
+    }
+    if (BaselineOutput != ProfiledOutput || bBaselineFailed != bProfiledFailed)
+    {
+        LOG_ERROR("Profiled build behaves differently");
+        std::cout << "--- baseline" << (bBaselineFailed ? " (failed)" : "") << "\n" << BaselineOutput;
+        std::cout << "--- profiled" << (bProfiledFailed ? " (failed)" : "") << "\n" << ProfiledOutput;
+        return 1;
+    }
+    std::cout << "[BENCH] Output:                identical" << std::endl;
+    return 0;
+}
+
+// Differential test: the optimized build must print exactly what the direct build prints,
+// fail the same way, and return the same value. Both runs see the same random sequence
+int RunOptimizerDiff(TSharedPtr<FScriptProgram> Program, TSharedPtr<FBytecodeChunk> Baseline, bool bInline)
+{
+    FScriptCompiler Compiler;
+    Compiler.SetInliningEnabled(bInline);
+    Compiler.SetOptimizationEnabled(true);
+    TSharedPtr<FBytecodeChunk> Optimized = Compiler.Compile(Program);
+    if (!Optimized.IsValid() || Compiler.HasErrors())
+    {
+        LOG_ERROR("Optimized build failed to compile:");
+        for (const auto& error : Compiler.GetErrors())
+        {
+            LOG_ERROR("  " + error);
+        }
+        return 1;
+    }
+    Optimized->Metadata = Baseline->Metadata;
+    Optimized->Signature = Optimized->GenerateSignature();
+    
+    auto Capture = [](TSharedPtr<FBytecodeChunk> Bytecode, bool& bOutFailed) -> FString
+    {
+        std::ostringstream Output;
+        std::streambuf* Saved = std::cout.rdbuf(Output.rdbuf());
+        std::srand(1);
+        TSharedPtr<FScriptVM> VM = RunBytecode(Bytecode, true);
+        bOutFailed = VM->HasErrors();
+        std::cout.rdbuf(Saved);
+        
+        // Compiler and VM trace lines name addresses and counts that legitimately differ
+        std::istringstream Lines(Output.str());
+        FString Result;
+        std::string Line;
+        while (std::getline(Lines, Line))
+        {
+            if (Line.rfind("[LOG]", 0) != 0)
+            {
+                Result += Line + "\n";
+            }
+        }
+        return Result;
+    };
+    
+    bool bBaselineFailed = false;
+    bool bOptimizedFailed = false;
+    const FString BaselineOutput = Capture(Baseline, bBaselineFailed);
+    const FString OptimizedOutput = Capture(Optimized, bOptimizedFailed);
+    
+    std::cout << "[DIFF] Direct:    " << Baseline->Code.Num() << " bytes of code" << std::endl;
+    std::cout << "[DIFF] Optimized: " << Optimized->Code.Num() << " bytes of code" << std::endl;
+    if (BaselineOutput != OptimizedOutput || bBaselineFailed != bOptimizedFailed)
+    {
+        LOG_ERROR("Optimized build behaves differently");
+        std::cout << "--- direct" << (bBaselineFailed ? " (failed)" : "") << "\n" << BaselineOutput;
+        std::cout << "--- optimized" << (bOptimizedFailed ? " (failed)" : "") << "\n" << OptimizedOutput;
+        return 1;
+    }
+    std::cout << "[DIFF] PASS (" << std::count(BaselineOutput.begin(), BaselineOutput.end(), '\n') << " lines of output"
+              << (bBaselineFailed ? ", same runtime error" : "") << ")" << std::endl;
+    return 0;
+}
+
+// What the standalone compiler stamps on every chunk it writes (the VM checks it before running)
+void StampStandaloneMetadata(FBytecodeChunk& Bytecode, const FString& InputFile, const FString& SourceCode)
+{
+    Bytecode.Metadata.CompilerType = ECompilerType::StandaloneCompiler;
+    Bytecode.Metadata.CompilerFlags = EScriptCompilerFlags::TrustedSigned | EScriptCompilerFlags::SecurityVerified;
+    Bytecode.Metadata.CompilerName = "StandaloneCompiler";
+    Bytecode.Metadata.CompilerVersion = "SBS Compiler C 2025 V1.0";
+    Bytecode.Metadata.EngineVersion = FStringPrintf("UE %d.%d", ENGINE_MAJOR_VERSION, ENGINE_MINOR_VERSION);
+    Bytecode.Metadata.GameName = "Sandbox Game";
+    Bytecode.Metadata.GameVersion = "V1.0";
+    Bytecode.Metadata.AuthorName = FPlatformMisc::GetLoginName();
+    
+    #if PLATFORM_WINDOWS
+        Bytecode.Metadata.OperatingSystem = "Windows";
+    #elif PLATFORM_MAC
+        Bytecode.Metadata.OperatingSystem = "Mac";
+    #elif PLATFORM_LINUX
+        Bytecode.Metadata.OperatingSystem = "Linux";
+    #else
+        Bytecode.Metadata.OperatingSystem = "Unknown";
+    #endif
+    
+    Bytecode.Metadata.MachineName = FPlatformMisc::GetMachineName();
+    Bytecode.Metadata.CompilationTime = FDateTime::Now();
+    Bytecode.Metadata.SourceFileName = FPaths::GetCleanFilename(InputFile);
+    Bytecode.Metadata.SourceFileSize = SourceCode.length();
+    Bytecode.Metadata.SourceChecksum = FMD5::HashAnsiString(SourceCode);
+    
+    Bytecode.Signature = Bytecode.GenerateSignature();
+}
+
+// Write the unlinked script and every module it was compiled against as .sbo objects
+bool SaveModuleObjects(const FBytecodeChunk& Root, const FString& InputFile, const FScriptModuleCache& Modules, const FString& Dir)
+{
+    std::error_code DirError;
+    std::filesystem::create_directories(Dir.c_str(), DirError);
+    
+    FScriptModule Script;
+    Script.Path = FPaths::GetBaseFilename(InputFile);
+    Script.Chunk = MakeShared<FBytecodeChunk>(Root);
+    
+    TArray<uint8> Data;
+    Script.Serialize(Data);
+    const FString ScriptObject = FPaths::Combine(Dir, Script.Path + ".sbo");
+    if (!FFileHelper::SaveArrayToFile(Data, ScriptObject))
+    {
+        LOG_ERROR("Failed to write object: " + ScriptObject);
+        return false;
+    }
+    LOG_INFO("Object: " + ScriptObject);
+    
+    for (const auto& Pair : Modules.GetModules())
+    {
+        const FString ModuleObject = FPaths::Combine(Dir, FScriptModuleCache::GetObjectFileName(Pair.Key));
+        if (!Modules.SaveObject(Pair.Key, ModuleObject))
+        {
+            LOG_ERROR("Failed to write object: " + ModuleObject);
+            return false;
+        }
+        LOG_INFO("Object: " + ModuleObject);
+    }
+    return true;
+}
+
+// Load a script object, then each module object it needs from the same directory, and link
+TSharedPtr<FBytecodeChunk> LinkObjectFile(const FString& InputFile, FScriptModuleCache& Modules)
+{
+    TArray<uint8> Data;
+    FScriptModule Script;
+    FString Error;
+    if (!FFileHelper::LoadFileToArray(Data, InputFile) || !Script.Deserialize(Data, Error))
+    {
+        LOG_ERROR("Failed to load object " + InputFile + (Error.IsEmpty() ? FString() : ": " + Error));
+        return nullptr;
+    }
+    
+    // Loaded on demand: a module's own external entries name the modules it needs
+    const FString Dir = FPaths::GetPath(InputFile);
+    TArray<TSharedPtr<FBytecodeChunk>> Pending;
+    Pending.Add(Script.Chunk);
+    while (Pending.Num() > 0)
+    {
+        TSharedPtr<FBytecodeChunk> Code = Pending.Last();
+        Pending.Pop();
+        for (const FFunctionInfo& Func : Code->Functions)
+        {
+            if (Func.Module.IsEmpty() || Modules.Find(Func.Module).IsValid())
+            {
+                continue;
+            }
+            if (!Modules.LoadObject(Func.Module, FPaths::Combine(Dir, FScriptModuleCache::GetObjectFileName(Func.Module)), Error))
+            {
+                LOG_ERROR(Error);
+                return nullptr;
+            }
+            LOG_INFO("Loaded module: " + Func.Module);
+            Pending.Add(Modules.Find(Func.Module)->Chunk);
+        }
+    }
+    
+    TArray<FString> Errors;
+    TSharedPtr<FBytecodeChunk> Linked = FScriptLinker::Link(*Script.Chunk, Modules, Errors);
+    for (const auto& LinkError : Errors)
+    {
+        LOG_ERROR("  " + LinkError);
+    }
+    return Linked;
+}
+
+// An .sbo input: link it against the module objects beside it, then write and run the
+// result like a compiled script
+int RunObjectInput(const FString& InputFile, const FString& OutputFile, bool bSaveDecompiled, bool bRun, bool bRegisterCode, bool bVerbose)
+{
+    RegisterStandaloneNatives();
+    FScriptModuleCache Modules;
+    TSharedPtr<FBytecodeChunk> Bytecode = LinkObjectFile(InputFile, Modules);
+    if (!Bytecode.IsValid())
+    {
+        LOG_ERROR("Link failed: " + InputFile);
+        return 1;
+    }
+    StampStandaloneMetadata(*Bytecode, InputFile, FString());
+    
+    TArray<uint8> BytecodeData;
+    FScriptBytecodeFile::Write(*Bytecode, BytecodeData);
+    if (!FFileHelper::SaveArrayToFile(BytecodeData, OutputFile))
+    {
+        LOG_ERROR("Failed to write output file: " + OutputFile);
+        return 1;
+    }
+    std::cout << "[INFO] Linked " << Modules.GetModules().Num() << " module(s): " << OutputFile << " ("
+              << BytecodeData.size() << " bytes)" << std::endl;
+    
+    if (bSaveDecompiled)
+    {
+        FString DecompiledFile = FPaths::GetBaseFilename(OutputFile) + ".decompiled.txt";
+        if (FFileHelper::SaveStringToFile(Bytecode->Decompile(), DecompiledFile))
+        {
+            LOG_INFO("Decompiled listing: " + DecompiledFile);
+        }
+    }
+    
+    if (bRun)
+    {
+        LOG_INFO("");
+        LOG_INFO("Running script...");
+        GStandaloneVMVerbose = bVerbose;
+        TSharedPtr<FScriptVM> VM = RunBytecode(Bytecode, true, bRegisterCode ? EScriptBackend::Register : EScriptBackend::Stack);
+        if (VM->HasErrors())
+        {
+            LOG_ERROR("Script execution failed");
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// A .scc input: load it as the game does (either format), then describe and run it
+int RunCompiledInput(const FString& InputFile, bool bSaveDecompiled, bool bRun, bool bRegisterCode, bool bVerbose)
+{
+    RegisterStandaloneNatives();
+    FString LoadError;
+    TSharedPtr<FBytecodeChunk> Bytecode = FScriptBytecodeFile::LoadChunk(InputFile, LoadError);
+    if (!Bytecode.IsValid())
+    {
+        LOG_ERROR(LoadError);
+        return 1;
+    }
+    
+    FString FormatError;
+    const bool bMappable = FScriptBytecodeFile::Open(InputFile, FormatError).IsValid();
+    LOG_INFO(FString("Format:            ") + (bMappable ? "v3 (mappable)" : "SBC1"));
+    std::cout << "[INFO] Code:              " << Bytecode->Code.Num() << " bytes" << std::endl;
+    std::cout << "[INFO] Constants:         " << Bytecode->Constants.Num() << std::endl;
+    std::cout << "[INFO] Functions:         " << Bytecode->Functions.Num() << std::endl;
+    std::cout << "[INFO] Compiler:          " << Bytecode->Metadata.CompilerName << " " << Bytecode->Metadata.CompilerVersion << std::endl;
+    std::cout << "[INFO] Signature:         " << Bytecode->Signature << std::endl;
+    
+    if (bSaveDecompiled)
+    {
+        FString DecompiledFile = FPaths::GetBaseFilename(InputFile) + ".decompiled.txt";
+        if (FFileHelper::SaveStringToFile(Bytecode->Decompile(), DecompiledFile))
+        {
+            LOG_INFO("Decompiled listing: " + DecompiledFile);
+        }
+    }
+    
+    if (bRun)
+    {
+        LOG_INFO("");
+        LOG_INFO("Running script...");
+        GStandaloneVMVerbose = bVerbose;
+        TSharedPtr<FScriptVM> VM = RunBytecode(Bytecode, true, bRegisterCode ? EScriptBackend::Register : EScriptBackend::Stack);
+        if (VM->HasErrors())
+        {
+            LOG_ERROR("Script execution failed");
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// What a linked script prints when run (Main included), without the VM's [LOG] lines
+FString CaptureScriptOutput(TSharedPtr<FBytecodeChunk> Bytecode)
+{
+    std::ostringstream Output;
+    std::streambuf* Saved = std::cout.rdbuf(Output.rdbuf());
+    TSharedPtr<FScriptVM> VM = RunBytecode(Bytecode, true);
+    const bool bFailed = VM->HasErrors();
+    std::cout.rdbuf(Saved);
+    
+    FString Result = bFailed ? "(failed)\n" : "";
+    std::istringstream Lines(Output.str());
+    std::string Line;
+    while (std::getline(Lines, Line))
+    {
+        if (Line.rfind("[LOG]", 0) != 0)
+        {
+            Result += Line + "\n";
+        }
+    }
+    return Result;
+}
+
+// Link benchmark: N generated scripts that all import one generated header, compiled
+// each in one piece (the header compiled into every script), against a module cache
+// (the header compiled once, then linked into each) and again in a later build that
+// loads the header's artifact instead. Every script must print the same each way
+int RunLinkBenchmark(int32 Roots, bool bInline, bool bOptimize)
+{
+    using FClock = std::chrono::high_resolution_clock;
+    auto MillisSince = [](FClock::time_point Start)
+    {
+        return std::chrono::duration<double, std::milli>(FClock::now() - Start).count();
+    };
+    
+    const int32 HeaderFunctions = 60;
+    std::ostringstream Header;
+    Header << "// Generated by --bench-link\n";
+    for (int32 i = 0; i < HeaderFunctions; ++i)
+    {
+        Header << "float Scale" << i << "(float x) {\n    return x * " << i << ".5 + " << i << ";\n}\n\n";
+        Header << "int Sum" << i << "(int n) {\n    int total = 0;\n    for (int k = 0; k < n; k = k + 1) {\n"
+               << "        total = total + k * " << i << " + Scale" << i << "(k) % 7;\n    }\n    return total;\n}\n\n";
+    }
+    const FString HeaderFile = FPaths::Combine(FPaths::Combine(FPaths::ProjectDir(), "Scripts"), "LinkBench.sbsh");
+    if (!FFileHelper::SaveStringToFile(Header.str(), HeaderFile))
+    {
+        LOG_ERROR("Link benchmark: cannot write " + HeaderFile + " (run from a directory with a Scripts folder)");
+        return 1;
+    }
+    
+    TArray<TSharedPtr<FScriptProgram>> Programs;
+    for (int32 r = 0; r < Roots; ++r)
+    {
+        std::ostringstream Source;
+        Source << "import \"LinkBench.sbsh\";\n\nint Main() {\n    float value = Scale" << r % HeaderFunctions << "(" << r << ");\n"
+               << "    int total = Sum" << (r * 7) % HeaderFunctions << "(" << 10 + r % 5 << ");\n"
+               << "    Log(\"root " << r << ": \" + value + \" \" + total);\n    return 0;\n}\n";
+        FScriptLexer Lexer(Source.str());
+        FScriptParser Parser(Lexer);
+        Programs.Add(Parser.Parse());
+    }
+    
+    RegisterStandaloneNatives();
+    auto CompileAll = [&](FScriptModuleCache* Modules, TArray<TSharedPtr<FBytecodeChunk>>& OutChunks) -> double
+    {
+        std::ostringstream Log;
+        std::streambuf* Saved = std::cout.rdbuf(Log.rdbuf());
+        auto Start = FClock::now();
+        for (const TSharedPtr<FScriptProgram>& Program : Programs)
+        {
+            FScriptCompiler Compiler;
+            Compiler.SetInliningEnabled(bInline);
+            Compiler.SetOptimizationEnabled(bOptimize);
+            Compiler.SetModuleCache(Modules);
+            TSharedPtr<FBytecodeChunk> Chunk = Compiler.Compile(Program);
+            if (Chunk.IsValid() && Modules)
+            {
+                TArray<FString> Errors;
+                Chunk = FScriptLinker::Link(*Chunk, *Modules, Errors);
+            }
+            OutChunks.Add(Chunk);
+        }
+        const double Elapsed = MillisSince(Start);
+        std::cout.rdbuf(Saved);
+        return Elapsed;
+    };
+    
+    const FString ArtifactDir = FPaths::Combine(FPaths::GetPath(HeaderFile), "LinkBenchArtifacts");
+    std::error_code DirError;
+    std::filesystem::create_directories(ArtifactDir.c_str(), DirError);
+    
+    FScriptModuleCache Modules;
+    Modules.SetInliningEnabled(bInline);
+    Modules.SetOptimizationEnabled(bOptimize);
+    Modules.SetArtifactDir(ArtifactDir);
+    FScriptModuleCache WarmModules;
+    WarmModules.SetInliningEnabled(bInline);
+    WarmModules.SetOptimizationEnabled(bOptimize);
+    WarmModules.SetArtifactDir(ArtifactDir);
+    TArray<TSharedPtr<FBytecodeChunk>> Monolithic;
+    TArray<TSharedPtr<FBytecodeChunk>> Separate;
+    TArray<TSharedPtr<FBytecodeChunk>> Warm;
+    const double MonolithicMs = CompileAll(nullptr, Monolithic);
+    const double SeparateMs = CompileAll(&Modules, Separate);
+    const double WarmMs = CompileAll(&WarmModules, Warm);
+    std::remove(HeaderFile.c_str());
+    std::filesystem::remove_all(ArtifactDir.c_str(), DirError);
+    
+    int64 MonolithicBytes = 0;
+    int64 SeparateBytes = 0;
+    for (int32 r = 0; r < Roots; ++r)
+    {
+        if (!Monolithic[r].IsValid() || !Separate[r].IsValid() || !Warm[r].IsValid())
+        {
+            LOG_ERROR("Link benchmark: script " + std::to_string(r) + " failed to compile or link");
+            return 1;
+        }
+        StampStandaloneMetadata(*Monolithic[r], "LinkBench.sbs", FString());
+        StampStandaloneMetadata(*Separate[r], "LinkBench.sbs", FString());
+        StampStandaloneMetadata(*Warm[r], "LinkBench.sbs", FString());
+        MonolithicBytes += Monolithic[r]->Code.Num();
+        SeparateBytes += Separate[r]->Code.Num();
+        
+        const FString Expected = CaptureScriptOutput(Monolithic[r]);
+        const FString Actual = CaptureScriptOutput(Separate[r]);
+        const FString FromArtifact = CaptureScriptOutput(Warm[r]);
+        if (Expected != Actual || Expected != FromArtifact)
+        {
+            LOG_ERROR("Link benchmark: linked script " + std::to_string(r) + " behaves differently");
+            std::cout << "--- one piece\n" << Expected << "--- linked\n" << Actual << "--- from artifact\n" << FromArtifact;
+            return 1;
+        }
+    }
+    if (WarmModules.GetNumLoaded() != 1 || WarmModules.GetNumCompiled() != 0)
+    {
+        LOG_ERROR("Link benchmark: the header artifact was not reused");
+        return 1;
+    }
+    
+    std::cout << "[BENCH] Scripts:               " << Roots << ", each importing " << HeaderFunctions * 2
+              << " header functions (" << Header.str().size() << " bytes)" << std::endl;
+    std::cout << "[BENCH] One piece:             " << MonolithicMs << " ms, " << MonolithicBytes << " bytes of code" << std::endl;
+    std::cout << "[BENCH] Modules + link:        " << SeparateMs << " ms, " << SeparateBytes << " bytes of code ("
+              << Modules.GetNumCompiled() << " module compiled, " << Modules.GetNumReused() << " imports reused)" << std::endl;
+    std::cout << "[BENCH] Modules, from artifact: " << WarmMs << " ms (" << WarmModules.GetNumLoaded()
+              << " module loaded, " << WarmModules.GetNumCompiled() << " compiled)" << std::endl;
+    if (SeparateMs > 0.0)
+    {
+        std::cout << "[BENCH] Speedup:               " << MonolithicMs / SeparateMs << "x" << std::endl;
+    }
+    std::cout << "[BENCH] Output:                identical" << std::endl;
+    return 0;
+}
+
+// Header artifact check: builds a script importing two generated headers (the top one
+// importing the base one) against an artifact directory, then edits the headers, the
+// options and the artifacts between builds. Each build must compile exactly the headers
+// whose key changed and print what a build from source prints
+int RunHeaderCacheTest()
+{
+    const FString ScriptsDir = FPaths::Combine(FPaths::ProjectDir(), "Scripts");
+    const FString BaseFile = FPaths::Combine(ScriptsDir, "CacheTestBase.sbsh");
+    const FString TopFile = FPaths::Combine(ScriptsDir, "CacheTestTop.sbsh");
+    const FString ArtifactDir = FPaths::Combine(ScriptsDir, "CacheTestArtifacts");
+    std::error_code DirError;
+    std::filesystem::create_directories(ArtifactDir.c_str(), DirError);
+    
+    auto WriteHeaders = [&](int32 BaseValue, int32 TopValue) -> bool
+    {
+        std::ostringstream Base;
+        Base << "int BaseValue() {\n    return " << BaseValue << ";\n}\n";
+        std::ostringstream Top;
+        Top << "import \"CacheTestBase.sbsh\";\n\nint TopValue(int x) {\n    return x * " << TopValue << " + BaseValue();\n}\n";
+        return FFileHelper::SaveStringToFile(Base.str(), BaseFile) && FFileHelper::SaveStringToFile(Top.str(), TopFile);
+    };
+    
+    const FString RootSource = "import \"CacheTestTop.sbsh\";\n\nint Main() {\n    Log(\"value \" + TopValue(10));\n    return 0;\n}\n";
+    
+    RegisterStandaloneNatives();
+    // One build: a fresh cache over the artifact directory, as a new process would have
+    auto Build = [&](bool bInline, int32& OutCompiled, int32& OutLoaded) -> FString
+    {
+        std::ostringstream Log;
+        std::streambuf* Saved = std::cout.rdbuf(Log.rdbuf());
+        FScriptModuleCache Modules;
+        Modules.SetInliningEnabled(bInline);
+        Modules.SetArtifactDir(ArtifactDir);
+        FScriptLexer Lexer(RootSource);
+        FScriptParser Parser(Lexer);
+        TSharedPtr<FScriptProgram> Program = Parser.Parse();
+        FScriptCompiler Compiler;
+        Compiler.SetInliningEnabled(bInline);
+        Compiler.SetModuleCache(&Modules);
+        TSharedPtr<FBytecodeChunk> Chunk = Compiler.Compile(Program);
+        TArray<FString> Errors;
+        if (Chunk.IsValid())
+        {
+            Chunk = FScriptLinker::Link(*Chunk, Modules, Errors);
+        }
+        std::cout.rdbuf(Saved);
+        
+        OutCompiled = Modules.GetNumCompiled();
+        OutLoaded = Modules.GetNumLoaded();
+        if (!Chunk.IsValid())
+        {
+            return "(failed to build)\n";
+        }
+        StampStandaloneMetadata(*Chunk, "CacheTest.sbs", FString());
+        
+        // What the script printed, without the VM's warnings
+        FString Printed;
+        std::istringstream Lines(CaptureScriptOutput(Chunk));
+        std::string Line;
+        while (std::getline(Lines, Line))
+        {
+            if (Line.rfind("[SCRIPT]", 0) == 0 || Line == "(failed)")
+            {
+                Printed += Line + "\n";
+            }
+        }
+        return Printed;
+    };
+    
+    int32 Failures = 0;
+    auto Step = [&](const FString& Name, bool bInline, int32 ExpectedCompiled, int32 ExpectedLoaded, const FString& ExpectedOutput)
+    {
+        int32 Compiled = 0, Loaded = 0;
+        const FString Output = Build(bInline, Compiled, Loaded);
+        if (Compiled == ExpectedCompiled && Loaded == ExpectedLoaded && Output == ExpectedOutput)
+        {
+            std::cout << "[CACHE] PASS " << Name << " (" << Compiled << " compiled, " << Loaded << " loaded)" << std::endl;
+            return;
+        }
+        Failures++;
+        std::cout << "[CACHE] FAIL " << Name << ": " << Compiled << " compiled, " << Loaded << " loaded, expected "
+                  << ExpectedCompiled << " and " << ExpectedLoaded << "\n" << Output;
+    };
+    
+    if (!WriteHeaders(1, 2))
+    {
+        LOG_ERROR("Header cache test: cannot write headers (run from a directory with a Scripts folder)");
+        return 1;
+    }
+    Step("cold build", true, 2, 0, "[SCRIPT] value 21\n");
+    Step("warm build", true, 0, 2, "[SCRIPT] value 21\n");
+    
+    WriteHeaders(1, 2);
+    Step("headers rewritten unchanged", true, 0, 2, "[SCRIPT] value 21\n");
+    
+    WriteHeaders(5, 2);
+    Step("base header edited (top imports it)", true, 2, 0, "[SCRIPT] value 25\n");
+    
+    WriteHeaders(5, 3);
+    Step("top header edited", true, 1, 1, "[SCRIPT] value 35\n");
+    
+    Step("inlining turned off", false, 2, 0, "[SCRIPT] value 35\n");
+    Step("inlining back on", true, 2, 0, "[SCRIPT] value 35\n");
+    
+    const FString TopArtifact = FPaths::Combine(ArtifactDir, FScriptModuleCache::GetArtifactFileName("CacheTestTop.sbsh"));
+    TArray<uint8> Truncated;
+    FFileHelper::LoadFileToArray(Truncated, TopArtifact);
+    Truncated.resize(Truncated.Num() / 2);
+    FFileHelper::SaveArrayToFile(Truncated, TopArtifact);
+    Step("top artifact truncated", true, 1, 1, "[SCRIPT] value 35\n");
+    
+    std::remove(BaseFile.c_str());
+    std::remove(TopFile.c_str());
+    std::filesystem::remove_all(ArtifactDir.c_str(), DirError);
+    
+    if (Failures > 0)
+    {
+        LOG_ERROR("Header cache test: " + std::to_string(Failures) + " step(s) failed");
+        return 1;
+    }
+    std::cout << "[CACHE] All steps passed" << std::endl;
+    return 0;
+}
+
+// Build every script in the root of Dir (*.sbs, *.sc) as the game does at startup: one
+// module cache, the scripts spread over NumWorkers workers (0 = one per core), results
+// reported in name order once all are done. Writes <OutputDir>/<Name>.scc
+// Incremental (--build): skips the scripts the compile database in OutputDir has as up to
+// date, and records the rest. OutCompiled gets the names of the scripts compiled
+int RunCompileAll(const FString& Dir, const FString& OutputDir, int32 NumWorkers, bool bInline, bool bOptimize, bool bRegisterCode,
+    bool bIncremental, TArray<FString>* OutCompiled = nullptr)
+{
+    std::vector<std::string> Files;
+    std::error_code DirError;
+    for (const auto& Entry : std::filesystem::directory_iterator(Dir.c_str(), DirError))
+    {
+        const std::string Extension = Entry.path().extension().string();
+        if (Entry.is_regular_file() && (Extension == ".sbs" || Extension == ".sc"))
+        {
+            Files.push_back(Entry.path().filename().string());
+        }
+    }
+    if (DirError)
+    {
+        LOG_ERROR("Cannot read script directory: " + Dir);
+        return 1;
+    }
+    std::sort(Files.begin(), Files.end());
+    
+    // Before any key is computed: the natives as bound are part of it
+    RegisterStandaloneNatives();
+    const FString CompileDBPath = FPaths::Combine(OutputDir, FScriptCompileDatabase::GetDefaultFileName());
+    FScriptCompileDatabase CompileDB;
+    CompileDB.SetInliningEnabled(bInline);
+    CompileDB.SetOptimizationEnabled(bOptimize);
+    CompileDB.SetRegisterCodeEnabled(bRegisterCode);
+    if (bIncremental)
+    {
+        CompileDB.Load(CompileDBPath);
+    }
+    auto GetOutputFile = [&OutputDir](const FString& Name)
+    {
+        return FPaths::Combine(OutputDir, FPaths::GetBaseFilename(Name) + ".scc");
+    };
+    
+    TArray<FScriptBatchJob> Jobs;
+    int32 NumUpToDate = 0;
+    for (const std::string& File : Files)
+    {
+        FScriptBatchJob Job;
+        Job.Name = File;
+        if (!FFileHelper::LoadFileToString(Job.Source, FPaths::Combine(Dir, File)))
+        {
+            LOG_ERROR("Failed to read script: " + File);
+            return 1;
+        }
+        if (bIncremental && FPaths::FileExists(GetOutputFile(Job.Name)) && CompileDB.IsUpToDate(Job.Name, Job.Source))
+        {
+            LOG_INFO("  UP TO DATE  " + Job.Name);
+            NumUpToDate++;
+            continue;
+        }
+        Jobs.Add(Job);
+    }
+    
+    FScriptModuleCache Modules;
+    Modules.SetScriptsDir(Dir);
+    Modules.SetInliningEnabled(bInline);
+    Modules.SetOptimizationEnabled(bOptimize);
+    Modules.SetRegisterCodeEnabled(bRegisterCode);
+    
+    FScriptBatchCompiler Batch;
+    Batch.SetModuleCache(&Modules);
+    Batch.SetNumWorkers(NumWorkers);
+    Batch.SetInliningEnabled(bInline);
+    Batch.SetOptimizationEnabled(bOptimize);
+    Batch.SetRegisterCodeEnabled(bRegisterCode);
+    
+    LOG_INFO("Compiling " + std::to_string(Jobs.Num()) + " script(s) in " + Dir + " on " + std::to_string(Batch.GetNumWorkers()) + " worker(s)");
+    
+    // Workers would interleave the compiler's own log lines; every error is in the jobs
+    auto Start = std::chrono::high_resolution_clock::now();
+    GStandaloneScriptLogMuted = true;
+    const int32 NumFailed = Batch.Compile(Jobs);
+    GStandaloneScriptLogMuted = false;
+    const double Ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - Start).count();
+    
+    std::filesystem::create_directories(OutputDir.c_str(), DirError);
+    for (FScriptBatchJob& Job : Jobs)
+    {
+        if (!Job.Bytecode.IsValid())
+        {
+            CompileDB.Forget(Job.Name);
+            LOG_ERROR("  FAILED  " + Job.Name);
+            for (const FString& Error : Job.Errors)
+            {
+                LOG_ERROR("    " + Error);
+            }
+            continue;
+        }
+        
+        StampStandaloneMetadata(*Job.Bytecode, Job.Name, Job.Source);
+        const FString OutputFile = GetOutputFile(Job.Name);
+        TArray<uint8> BytecodeData;
+        FScriptBytecodeFile::Write(*Job.Bytecode, BytecodeData);
+        if (!FFileHelper::SaveArrayToFile(BytecodeData, OutputFile))
+        {
+            CompileDB.Forget(Job.Name);
+            LOG_ERROR("  FAILED  " + Job.Name + " (cannot write " + OutputFile + ")");
+            continue;
+        }
+        CompileDB.Record(Job.Name, Job.Source, Job.Imports);
+        if (OutCompiled)
+        {
+            OutCompiled->Add(Job.Name);
+        }
+        LOG_INFO("  OK      " + Job.Name + " -> " + OutputFile + " (" + std::to_string(BytecodeData.Num()) + " bytes)");
+    }
+    
+    char Line[192];
+    std::snprintf(Line, sizeof(Line), "Compiled %d of %d script(s) in %.2f ms (%.1f scripts/s), %d module(s) compiled once",
+        Jobs.Num() - NumFailed, Jobs.Num(), Ms, Ms > 0.0 ? Jobs.Num() * 1000.0 / Ms : 0.0, Modules.GetNumCompiled());
+    LOG_INFO(Line);
+    if (bIncremental)
+    {
+        CompileDB.Save(CompileDBPath);
+        LOG_INFO(std::to_string(NumUpToDate) + " script(s) up to date");
+    }
+    return NumFailed > 0 ? 1 : 0;
+}
+
+// Compile database check: builds three generated scripts (one importing a header that
+// imports another, one importing the inner header, one importing nothing) incrementally,
+// changing sources, options and outputs between builds. Each build must compile exactly
+// the scripts whose inputs changed
+int RunCompileDatabaseTest()
+{
+    const FString Dir = FPaths::Combine(FPaths::Combine(FPaths::ProjectDir(), "Scripts"), "CompileDBTest");
+    const FString OutputDir = FPaths::Combine(Dir, "Compiled");
+    std::error_code DirError;
+    std::filesystem::create_directories(OutputDir.c_str(), DirError);
+    
+    auto Write = [&Dir](const FString& File, const FString& Text)
+    {
+        return FFileHelper::SaveStringToFile(Text, FPaths::Combine(Dir, File));
+    };
+    auto WriteBase = [&](int32 Value)
+    {
+        return Write("Base.sbsh", FStringPrintf("int BaseValue() {\n    return %d;\n}\n", Value));
+    };
+    auto WriteTop = [&](int32 Value)
+    {
+        return Write("Top.sbsh", FStringPrintf("import \"Base.sbsh\";\n\nint TopValue(int x) {\n    return x * %d + BaseValue();\n}\n", Value));
+    };
+    auto WriteScripts = [&](const FString& Greeting)
+    {
+        return Write("A.sbs", "import \"Top.sbsh\";\n\nint Main() {\n    Log(\"a \" + TopValue(10));\n    return 0;\n}\n") &&
+               Write("B.sbs", "import \"Base.sbsh\";\n\nint Main() {\n    Log(\"b \" + BaseValue());\n    return 0;\n}\n") &&
+               Write("C.sbs", "int Main() {\n    Log(\"" + Greeting + "\");\n    return 0;\n}\n");
+    };
+    
+    int32 Failures = 0;
+    auto Step = [&](const FString& Name, bool bInline, const FString& Expected)
+    {
+        TArray<FString> Compiled;
+        std::ostringstream Log;
+        std::streambuf* Saved = std::cout.rdbuf(Log.rdbuf());
+        const int Result = RunCompileAll(Dir, OutputDir, 0, bInline, false, false, true, &Compiled);
+        std::cout.rdbuf(Saved);
+        
+        FString Names;
+        for (const FString& Script : Compiled)
+        {
+            Names += (Names.empty() ? "" : " ") + FPaths::GetBaseFilename(Script);
+        }
+        if (Result == 0 && Names == Expected)
+        {
+            std::cout << "[BUILD] PASS " << Name << " (compiled: " << (Names.empty() ? "none" : Names) << ")" << std::endl;
+            return;
+        }
+        Failures++;
+        std::cout << "[BUILD] FAIL " << Name << ": compiled \"" << Names << "\", expected \"" << Expected << "\"\n" << Log.str();
+    };
+    
+    if (!WriteBase(1) || !WriteTop(2) || !WriteScripts("hello"))
+    {
+        LOG_ERROR("Compile database test: cannot write scripts (run from a directory with a Scripts folder)");
+        return 1;
+    }
+    std::remove(FPaths::Combine(OutputDir, FScriptCompileDatabase::GetDefaultFileName()).c_str());
+    Step("cold build", true, "A B C");
+    Step("warm build", true, "");
+    
+    WriteBase(1);
+    WriteTop(2);
+    WriteScripts("hello");
+    Step("files rewritten unchanged", true, "");
+    
+    WriteTop(3);
+    Step("top header edited (A imports it)", true, "A");
+    
+    WriteBase(5);
+    Step("base header edited (A through Top, B directly)", true, "A B");
+    
+    WriteScripts("hello again");
+    Step("C edited", true, "C");
+    
+    Step("inlining turned off", false, "A B C");
+    Step("inlining back on", true, "A B C");
+    
+    std::remove(FPaths::Combine(OutputDir, "B.scc").c_str());
+    Step("B.scc deleted", true, "B");
+    
+    std::remove(FPaths::Combine(OutputDir, FScriptCompileDatabase::GetDefaultFileName()).c_str());
+    Step("database deleted", true, "A B C");
+    
+    std::filesystem::remove_all(Dir.c_str(), DirError);
+    
+    if (Failures > 0)
+    {
+        LOG_ERROR("Compile database test: " + std::to_string(Failures) + " step(s) failed");
+        return 1;
+    }
+    std::cout << "[BUILD] All steps passed" << std::endl;
+    return 0;
+}
+
+// Verifier check: compiles a generated script with register code, then loads its .scc with
+// each function's register address pushed past the code, and with every byte of the file
+// changed in turn. A corrupt address is one error of its own; nothing the file says may
+// send the verifier outside the code (run under ASan to see that)
+int RunVerifierTest()
+{
+    FGeneratedScriptOptions Options;
+    Options.Lines = 300;
+    Options.Shape = EGeneratedScriptShape::Functions;
+    const FString Source = GenerateScript(Options);
+    RegisterStandaloneNatives();
+    FScriptLexer Lexer(Source);
+    FScriptParser Parser(Lexer);
+    TSharedPtr<FScriptProgram> Program = Parser.Parse();
+    GStandaloneScriptLogMuted = true;
+    FScriptCompiler Compiler;
+    Compiler.SetRegisterCodeEnabled(true);
+    TSharedPtr<FBytecodeChunk> Chunk = (Program.IsValid() && !Parser.HasErrors()) ? Compiler.Compile(Program) : nullptr;
+    GStandaloneScriptLogMuted = false;
+    if (!Chunk.IsValid() || Compiler.HasErrors() || Chunk->RegisterCode.Num() == 0)
+    {
+        LOG_ERROR("Verifier test: generated script failed to compile to register code");
+        return 1;
+    }
+    
+    // What a game load of the file would verify
+    auto Load = [](const TArray<uint8>& Data, FBytecodeVerifyResult& OutResult) -> bool
+    {
+        FString Error;
+        TArray<uint8> Copy = Data;
+        TSharedPtr<FScriptBytecodeFile> File = FScriptBytecodeFile::FromMemory(MoveTemp(Copy), Error);
+        FBytecodeChunk Loaded;
+        return File.IsValid() && File->ToChunk(Loaded, Error) && FScriptBytecodeVerifier::Verify(Loaded, OutResult);
+    };
+    
+    int32 Failures = 0;
+    TArray<uint8> Data;
+    FScriptBytecodeFile::Write(*Chunk, Data);
+    FBytecodeVerifyResult Clean;
+    if (Load(Data, Clean))
+    {
+        std::cout << "[VERIFY] PASS clean file verifies" << std::endl;
+    }
+    else
+    {
+        Failures++;
+        std::cout << "[VERIFY] FAIL clean file rejected: " << (Clean.Errors.Num() > 0 ? Clean.Errors[0] : FString("cannot load")) << std::endl;
+    }
+    
+    int32 NumCorrupted = 0;
+    for (int32 i = 0; i < Chunk->Functions.Num(); ++i)
+    {
+        FFunctionInfo& Function = Chunk->Functions[i];
+        if (Function.RegisterAddress == INDEX_NONE)
+        {
+            continue;
+        }
+        const int32 Address = Function.RegisterAddress;
+        for (const int32 Corrupt : { Chunk->RegisterCode.Num(), Chunk->RegisterCode.Num() + 4096 })
+        {
+            Function.RegisterAddress = Corrupt;
+            FScriptBytecodeFile::Write(*Chunk, Data);
+            FBytecodeVerifyResult Result;
+            if (Load(Data, Result) || Result.Errors.Num() != 1 || !Result.Errors[0].Contains("invalid register address"))
+            {
+                Failures++;
+                std::cout << "[VERIFY] FAIL register address " << Corrupt << " of '" << Function.Name << "': "
+                          << Result.Errors.Num() << " error(s)" << (Result.Errors.Num() > 0 ? ", first: " + Result.Errors[0] : FString()) << std::endl;
+            }
+        }
+        Function.RegisterAddress = Address;
+        NumCorrupted++;
+    }
+    std::cout << "[VERIFY] " << (Failures == 0 ? "PASS" : "FAIL") << " register addresses past the code ("
+              << NumCorrupted << " function(s))" << std::endl;
+    
+    // Most changes break the signature, which is only a warning
+    FScriptBytecodeFile::Write(*Chunk, Data);
+    int32 NumRejected = 0;
+    std::ostringstream Discarded;
+    std::streambuf* Saved = std::cout.rdbuf(Discarded.rdbuf());
+    GStandaloneScriptLogMuted = true;
+    for (int32 i = 0; i < Data.Num(); ++i)
+    {
+        const uint8 Original = Data[i];
+        for (const uint8 Delta : { (uint8)1, (uint8)4, (uint8)0x80 })
+        {
+            Data[i] = Original ^ Delta;
+            FBytecodeVerifyResult Result;
+            NumRejected += Load(Data, Result) ? 0 : 1;
+        }
+        Data[i] = Original;
+    }
+    GStandaloneScriptLogMuted = false;
+    std::cout.rdbuf(Saved);
+    std::cout << "[VERIFY] PASS single-byte changes (" << NumRejected << " of " << Data.Num() * 3 << " rejected)" << std::endl;
+    
+    if (Failures > 0)
+    {
+        LOG_ERROR("Verifier test: " + std::to_string(Failures) + " step(s) failed");
+        return 1;
+    }
+    std::cout << "[VERIFY] All steps passed" << std::endl;
+    return 0;
+}
+
+// Load benchmark: writes NumFiles compiled scripts in both formats, SBC1 (FBytecodeChunk::Serialize)
+// and v3 (FScriptBytecodeFile), and loads them all back each way. What v3 loads, in place and
+// as a chunk, must be what was written, down to array constants and source positions
+int RunLoadBenchmark(int32 NumFiles)
+{
+    using FClock = std::chrono::high_resolution_clock;
+    auto MillisSince = [](FClock::time_point Start)
+    {
+        return std::chrono::duration<double, std::milli>(FClock::now() - Start).count();
+    };
+    
+    // A few generated scripts of different shapes and sizes, written in turn
+    const EGeneratedScriptShape Shapes[] = { EGeneratedScriptShape::Mixed, EGeneratedScriptShape::Functions,
+        EGeneratedScriptShape::Switch, EGeneratedScriptShape::Globals, EGeneratedScriptShape::Strings, EGeneratedScriptShape::Nested };
+    const int32 NumScripts = FMath::Min(NumFiles, 8);
+    RegisterStandaloneNatives();
+    TArray<TSharedPtr<FBytecodeChunk>> Chunks;
+    TArray<TArray<uint8>> LegacyData;
+    TArray<TArray<uint8>> MappableData;
+    for (int32 i = 0; i < NumScripts; ++i)
+    {
+        FGeneratedScriptOptions Options;
+        Options.Lines = 300 + 200 * i;
+        Options.Shape = Shapes[i % UE_ARRAY_COUNT(Shapes)];
+        const FString Source = GenerateScript(Options);
+        FScriptLexer Lexer(Source);
+        FScriptParser Parser(Lexer);
+        TSharedPtr<FScriptProgram> Program = Parser.Parse();
+        GStandaloneScriptLogMuted = true;
+        FScriptCompiler Compiler;
+        TSharedPtr<FBytecodeChunk> Chunk = (Program.IsValid() && !Parser.HasErrors()) ? Compiler.Compile(Program) : nullptr;
+        GStandaloneScriptLogMuted = false;
+        if (!Chunk.IsValid() || Compiler.HasErrors())
+        {
+            LOG_ERROR(FString("Load benchmark: generated ") + GetGeneratedScriptShapeName(Options.Shape) + " script failed to compile");
+            return 1;
+        }
+        StampStandaloneMetadata(*Chunk, FStringPrintf("LoadBench%d.sbs", i), Source);
+        Chunks.Add(Chunk);
+        LegacyData.Add(TArray<uint8>());
+        Chunk->Serialize(LegacyData.Last(), true);
+        MappableData.Add(TArray<uint8>());
+        FScriptBytecodeFile::Write(*Chunk, MappableData.Last());
+    }
+    
+    std::error_code DirError;
+    const FString Dir = FPaths::Combine(std::filesystem::temp_directory_path(DirError).string(), "ScriptLoadBench");
+    std::filesystem::create_directories(Dir.c_str(), DirError);
+    TArray<FString> LegacyFiles;
+    TArray<FString> MappableFiles;
+    int64 LegacyBytes = 0;
+    int64 MappableBytes = 0;
+    for (int32 i = 0; i < NumFiles; ++i)
+    {
+        LegacyFiles.Add(FPaths::Combine(Dir, FStringPrintf("Script%d.sbc1.scc", i)));
+        MappableFiles.Add(FPaths::Combine(Dir, FStringPrintf("Script%d.scc", i)));
+        if (!FFileHelper::SaveArrayToFile(LegacyData[i % NumScripts], LegacyFiles.Last()) ||
+            !FFileHelper::SaveArrayToFile(MappableData[i % NumScripts], MappableFiles.Last()))
+        {
+            LOG_ERROR("Load benchmark: cannot write " + Dir);
+            std::filesystem::remove_all(Dir.c_str(), DirError);
+            return 1;
+        }
+        LegacyBytes += LegacyData[i % NumScripts].Num();
+        MappableBytes += MappableData[i % NumScripts].Num();
+    }
+    
+    // Every file once per pass, best of three passes (the files are in the page cache after the first)
+    bool bLoadFailed = false;
+    auto TimeLoads = [&](const TArray<FString>& Files, auto&& LoadOne)
+    {
+        double Best = 0.0;
+        for (int32 Pass = 0; Pass < 3; ++Pass)
+        {
+            auto Start = FClock::now();
+            for (const FString& File : Files)
+            {
+                bLoadFailed = !LoadOne(File) || bLoadFailed;
+            }
+            const double Elapsed = MillisSince(Start);
+            Best = (Pass == 0) ? Elapsed : FMath::Min(Best, Elapsed);
+        }
+        return Best;
+    };
+    auto Deserialize = [](const FString& File)
+    {
+        TArray<uint8> Data;
+        FBytecodeChunk Chunk;
+        return FFileHelper::LoadFileToArray(Data, File) && Chunk.Deserialize(Data);
+    };
+    const double LegacyMs = TimeLoads(LegacyFiles, Deserialize);
+    const double DeserializeMs = TimeLoads(MappableFiles, Deserialize);
+    const double OpenMs = TimeLoads(MappableFiles, [](const FString& File)
+    {
+        FString Error;
+        return FScriptBytecodeFile::Open(File, Error).IsValid();
+    });
+    const double LookupMs = TimeLoads(MappableFiles, [](const FString& File)
+    {
+        FString Error;
+        TSharedPtr<FScriptBytecodeFile> Mapped = FScriptBytecodeFile::Open(File, Error);
+        if (!Mapped.IsValid() || Mapped->FindFunction("Main") == INDEX_NONE)
+        {
+            return false;
+        }
+        Mapped->GetLine(Mapped->GetCodeSize() / 2);
+        for (int32 i = 0; i < FMath::Min(Mapped->GetNumConstants(), 8); ++i)
+        {
+            Mapped->GetConstant(i);
+        }
+        return true;
+    });
+    const double ChunkMs = TimeLoads(MappableFiles, [](const FString& File)
+    {
+        FString Error;
+        return FScriptBytecodeFile::LoadChunk(File, Error).IsValid();
+    });
+    
+    // What each script loads back as, against what was written
+    auto SameLines = [](const FBytecodeChunk& A, const FBytecodeChunk& B)
+    {
+        if (A.LineTable.Num() != B.LineTable.Num())
+        {
+            return false;
+        }
+        for (int32 Offset = 0; Offset < A.LineTable.Num(); ++Offset)
+        {
+            if (A.LineTable.GetLine(Offset) != B.LineTable.GetLine(Offset) || A.LineTable.GetFile(Offset) != B.LineTable.GetFile(Offset))
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+    int32 MappableMismatches = 0;
+    int32 LegacyMismatches = 0;
+    for (int32 i = 0; i < NumScripts; ++i)
+    {
+        const FBytecodeChunk& Written = *Chunks[i];
+        FString Error;
+        TSharedPtr<FScriptBytecodeFile> Mapped = FScriptBytecodeFile::Open(MappableFiles[i], Error);
+        TSharedPtr<FBytecodeChunk> Loaded = Mapped.IsValid() ? Mapped->ToChunk(Error) : nullptr;
+        bool bSame = Loaded.IsValid() && Loaded->Disassemble() == Written.Disassemble() && SameLines(*Loaded, Written) &&
+            Loaded->Signature == Written.GenerateSignature() && Mapped->GetSourceHash() == Written.SourceHash;
+        for (int32 c = 0; bSame && c < Written.Constants.Num(); ++c)
+        {
+            bSame = FConstantPoolIndex::IsSameConstant(Mapped->GetConstant(c), Written.Constants[c]);
+        }
+        for (int32 f = 0; bSame && f < Written.Functions.Num(); ++f)
+        {
+            const FFunctionInfo Func = Mapped->GetFunction(f);
+            bSame = Func.Name == Written.Functions[f].Name && Func.Address == Written.Functions[f].Address &&
+                Func.Arity == Written.Functions[f].Arity && Mapped->FindFunction(Func.Name) != INDEX_NONE;
+        }
+        for (int32 Offset = 0; bSame && Offset < Written.Code.Num(); Offset += 7)
+        {
+            bSame = Mapped->GetLine(Offset) == Written.LineTable.GetLine(Offset) && Mapped->GetFile(Offset) == Written.LineTable.GetFile(Offset);
+        }
+        if (!bSame)
+        {
+            LOG_ERROR("Load benchmark: script " + std::to_string(i) + " loads back differently from v3" + (Error.empty() ? FString() : ": " + Error));
+            MappableMismatches++;
+        }
+        
+        FBytecodeChunk Legacy;
+        if (!Legacy.Deserialize(LegacyData[i]) || Legacy.Disassemble() != Written.Disassemble())
+        {
+            LegacyMismatches++;
+        }
+    }
+    std::filesystem::remove_all(Dir.c_str(), DirError);
+    
+    auto Report = [NumFiles, LegacyMs](const char* Label, double Ms)
+    {
+        std::cout << "[BENCH] " << Label << Ms << " ms (" << Ms * 1000.0 / NumFiles << " us/file";
+        if (Ms > 0.0 && Ms != LegacyMs)
+        {
+            std::cout << ", " << LegacyMs / Ms << "x SBC1";
+        }
+        std::cout << ")" << std::endl;
+    };
+    std::cout << "[BENCH] Files:                 " << NumFiles << " of " << NumScripts << " generated scripts, SBC1 "
+              << LegacyBytes / 1024 << " KB, v3 " << MappableBytes / 1024 << " KB in all" << std::endl;
+    Report("SBC1 Deserialize:      ", LegacyMs);
+    Report("v3 Deserialize:        ", DeserializeMs);
+    Report("v3 Open (mapped):      ", OpenMs);
+    Report("v3 Open + lookups:     ", LookupMs);
+    Report("v3 LoadChunk:          ", ChunkMs);
+    std::cout << "[BENCH] (SBC1 is not compressed in this build; the game also inflates it, v3 is never compressed)" << std::endl;
+    std::cout << "[BENCH] SBC1 round trip:       " << (LegacyMismatches == 0 ? "identical" : std::to_string(LegacyMismatches) + " script(s) differ")
+              << std::endl;
+    std::cout << "[BENCH] v3 round trip:         " << (MappableMismatches == 0 ? "identical" : std::to_string(MappableMismatches) + " script(s) differ")
+              << std::endl;
+    if (bLoadFailed)
+    {
+        LOG_ERROR("Load benchmark: a file failed to load");
+    }
+    return (MappableMismatches == 0 && !bLoadFailed) ? 0 : 1;
+}
+
+int RunCompiler(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        PrintUsage();
+        return 1;
+    }
+    
+    // Parse arguments
+    FString InputFile;
+    FString OutputFile;
+    bool bSaveDecompiled = false;
+    bool bVerbose = false;
+    bool bRun = false;
+    bool bInline = true;
+    bool bOptimize = false;
+    bool bDiffOptimizer = false;
+    bool bRegisterCode = false;
+    int32 SnapshotBenchIterations = 0;
+    int32 InstanceBenchCount = 0;
+    int32 DispatchBenchIterations = 0;
+    int32 BackendBenchIterations = 0;
+    int32 ConstantBenchLiterals = 0;
+    int32 FrontEndBenchFunctions = 0;
+    int32 ProfileBenchIterations = 0;
+    FString ProfileFile;
+    FString RecordProfileFile;
+    bool bSeparate = false;
+    FString ObjectDir;
+    FString HeaderCacheDir;
+    int32 LinkBenchRoots = 0;
+    bool bTestHeaderCache = false;
+    FString CompileAllDir;
+    bool bIncrementalBuild = false;
+    bool bTestCompileDatabase = false;
+    bool bTestVerifier = false;
+    int32 NumWorkers = 0;
+    int32 ServerBenchIterations = 0;
+    FGeneratedScriptOptions GeneratorOptions;
+    int32 GenerateLines = 0;
+    int32 ScalingBenchLines = 0;
+    int32 LoadBenchFiles = 0;
+    
+    for (int i = 1; i < argc; ++i)
+    {
+        FString arg = argv[i];
+        
+        if (arg == "--help" || arg == "-h")
+        {
+            PrintUsage();
+            return 0;
+        }
+        else if (arg == "-o")
+        {
+            if (i + 1 < argc)
+            {
+                OutputFile = argv[++i];
+            }
+            else
+            {
+                LOG_ERROR("Missing output file after -o");
+                return 1;
+            }
+        }
+        else if (arg == "-d")
+        {
+            bSaveDecompiled = true;
+        }
+        else if (arg == "-v")
+        {
+            bVerbose = true;
+        }
+        else if (arg == "-r" || arg == "--run")
+        {
+            bRun = true;
+        }
+        else if (arg == "--no-inline")
+        {
+            bInline = false;
+        }
+        else if (arg == "-O")
+        {
+            bOptimize = true;
+        }
+        else if (arg == "--diff-opt")
+        {
+            bDiffOptimizer = true;
+        }
+        else if (arg == "-R" || arg == "--register")
+        {
+            bRegisterCode = true;
+        }
+        else if (arg == "--bench-backend")
+        {
+            if (i + 1 < argc)
+            {
+                BackendBenchIterations = std::atoi(argv[++i]);
+            }
+            else
+            {
+                LOG_ERROR("Missing iteration count after --bench-backend");
+                return 1;
+            }
+        }
+        else if (arg == "--profile" || arg == "--record-profile")
+        {
+            if (i + 1 < argc)
+            {
+                (arg == "--profile" ? ProfileFile : RecordProfileFile) = argv[++i];
+            }
+            else
+            {
+                LOG_ERROR("Missing profile file after " + arg);
+                return 1;
+            }
+        }
+        else if (arg == "--bench-profile")
+        {
+            if (i + 1 < argc)
+            {
+                ProfileBenchIterations = std::atoi(argv[++i]);
+            }
+            else
+            {
+                LOG_ERROR("Missing iteration count after --bench-profile");
+                return 1;
+            }
+        }
+        else if (arg == "--separate")
+        {
+            bSeparate = true;
+        }
+        else if (arg == "--objects")
+        {
+            if (i + 1 < argc)
+            {
+                ObjectDir = argv[++i];
+                bSeparate = true;
+            }
+            else
+            {
+                LOG_ERROR("Missing directory after --objects");
+                return 1;
+            }
+        }
+        else if (arg == "--header-cache")
+        {
+            if (i + 1 < argc)
+            {
+                HeaderCacheDir = argv[++i];
+                bSeparate = true;
+            }
+            else
+            {
+                LOG_ERROR("Missing directory after --header-cache");
+                return 1;
+            }
+        }
+        else if (arg == "--test-header-cache")
+        {
+            bTestHeaderCache = true;
+        }
+        else if (arg == "--compile-all" || arg == "--build")
+        {
+            if (i + 1 < argc)
+            {
+                CompileAllDir = argv[++i];
+                bIncrementalBuild = (arg == "--build");
+            }
+            else
+            {
+                LOG_ERROR("Missing directory after " + arg);
+                return 1;
+            }
+        }
+        else if (arg == "--test-compile-db")
         {
-            PrintUsage();
-            return 0;
+            bTestCompileDatabase = true;
         }
-        else if (arg == "-o")
+        else if (arg == "--test-verifier")
+        {
+            bTestVerifier = true;
+        }
+        else if (arg == "--bench-server")
         {
             if (i + 1 < argc)
             {
-                OutputFile = argv[++i];
+                ServerBenchIterations = std::atoi(argv[++i]);
             }
             else
             {
-                LOG_ERROR("Missing output file after -o");
+                LOG_ERROR("Missing compile count after --bench-server");
                 return 1;
             }
         }
-        else if (arg == "-d")
+        else if (arg == "-j")
         {
-            bSaveDecompiled = true;
+            if (i + 1 < argc)
+            {
+                NumWorkers = std::atoi(argv[++i]);
+            }
+            else
+            {
+                LOG_ERROR("Missing worker count after -j");
+                return 1;
+            }
         }
-        else if (arg == "-v")
+        else if (arg == "--bench-link")
         {
-            bVerbose = true;
+            if (i + 1 < argc)
+            {
+                LinkBenchRoots = std::atoi(argv[++i]);
+            }
+            else
+            {
+                LOG_ERROR("Missing script count after --bench-link");
+                return 1;
+            }
+        }
+        else if (arg == "--bench-constants")
+        {
+            if (i + 1 < argc)
+            {
+                ConstantBenchLiterals = std::atoi(argv[++i]);
+            }
+            else
+            {
+                LOG_ERROR("Missing literal count after --bench-constants");
+                return 1;
+            }
+        }
+        else if (arg == "--generate" || arg == "--bench-scaling")
+        {
+            if (i + 1 < argc)
+            {
+                (arg == "--generate" ? GenerateLines : ScalingBenchLines) = std::atoi(argv[++i]);
+            }
+            else
+            {
+                LOG_ERROR("Missing line count after " + arg);
+                return 1;
+            }
+        }
+        else if (arg == "--shape")
+        {
+            if (i + 1 >= argc || !ParseGeneratedScriptShape(argv[i + 1], GeneratorOptions.Shape))
+            {
+                LOG_ERROR("Expected mixed, functions, nested, switch, globals or strings after --shape");
+                return 1;
+            }
+            ++i;
+        }
+        else if (arg == "--nesting" || arg == "--switch-cases")
+        {
+            if (i + 1 < argc)
+            {
+                (arg == "--nesting" ? GeneratorOptions.NestingDepth : GeneratorOptions.SwitchCases) = std::atoi(argv[++i]);
+            }
+            else
+            {
+                LOG_ERROR("Missing count after " + arg);
+                return 1;
+            }
+        }
+        else if (arg == "--bench-load")
+        {
+            if (i + 1 < argc)
+            {
+                LoadBenchFiles = std::atoi(argv[++i]);
+            }
+            else
+            {
+                LOG_ERROR("Missing file count after --bench-load");
+                return 1;
+            }
+        }
+        else if (arg == "--bench-frontend")
+        {
+            if (i + 1 < argc)
+            {
+                FrontEndBenchFunctions = std::atoi(argv[++i]);
+            }
+            else
+            {
+                LOG_ERROR("Missing function count after --bench-frontend");
+                return 1;
+            }
+        }
+        else if (arg == "--bench-instances")
+        {
+            if (i + 1 < argc)
+            {
+                InstanceBenchCount = std::atoi(argv[++i]);
+            }
+            else
+            {
+                LOG_ERROR("Missing instance count after --bench-instances");
+                return 1;
+            }
+        }
+        else if (arg == "--bench-dispatch")
+        {
+            if (i + 1 < argc)
+            {
+                DispatchBenchIterations = std::atoi(argv[++i]);
+            }
+            else
+            {
+                LOG_ERROR("Missing iteration count after --bench-dispatch");
+                return 1;
+            }
+        }
+        else if (arg == "--bench-snapshot")
+        {
+            if (i + 1 < argc)
+            {
+                SnapshotBenchIterations = std::atoi(argv[++i]);
+            }
+            else
+            {
+                LOG_ERROR("Missing iteration count after --bench-snapshot");
+                return 1;
+            }
         }
         else if (InputFile.empty())
         {
@@ -84,6 +2262,58 @@ int main(int argc, char* argv[])
         }
     }
     
+    // Generates its own script
+    if (ConstantBenchLiterals > 0 && InputFile.empty())
+    {
+        return RunConstantPoolBenchmark(ConstantBenchLiterals);
+    }
+    if (bTestHeaderCache)
+    {
+        return RunHeaderCacheTest();
+    }
+    if (bTestCompileDatabase)
+    {
+        return RunCompileDatabaseTest();
+    }
+    if (bTestVerifier)
+    {
+        return RunVerifierTest();
+    }
+    if (!CompileAllDir.empty())
+    {
+        const FString CompiledDir = OutputFile.empty() ? FPaths::Combine(CompileAllDir, "Compiled") : OutputFile;
+        return RunCompileAll(CompileAllDir, CompiledDir, NumWorkers, bInline, bOptimize, bRegisterCode, bIncrementalBuild);
+    }
+    
+    if (LinkBenchRoots > 0 && InputFile.empty())
+    {
+        return RunLinkBenchmark(LinkBenchRoots, bInline, bOptimize);
+    }
+    if (FrontEndBenchFunctions > 0 && InputFile.empty())
+    {
+        return RunFrontEndBenchmark(FrontEndBenchFunctions);
+    }
+    if (ScalingBenchLines > 0)
+    {
+        return RunScalingBenchmark(GeneratorOptions, ScalingBenchLines);
+    }
+    if (LoadBenchFiles > 0)
+    {
+        return RunLoadBenchmark(LoadBenchFiles);
+    }
+    if (GenerateLines > 0)
+    {
+        GeneratorOptions.Lines = GenerateLines;
+        const FString GeneratedFile = OutputFile.empty() ? FString("Generated.sbs") : OutputFile;
+        if (!FFileHelper::SaveStringToFile(GenerateScript(GeneratorOptions), GeneratedFile))
+        {
+            LOG_ERROR("Failed to write generated script: " + GeneratedFile);
+            return 1;
+        }
+        LOG_INFO("Generated script: " + GeneratedFile);
+        return 0;
+    }
+    
     if (InputFile.empty())
     {
         LOG_ERROR("No input file specified");
@@ -91,6 +2321,17 @@ int main(int argc, char* argv[])
         return 1;
     }
     
+    if (ServerBenchIterations > 0)
+    {
+        return RunServerBenchmark(argv[0], InputFile, ServerBenchIterations);
+    }
+    
+    if (ProfileBenchIterations > 0 && ProfileFile.empty())
+    {
+        LOG_ERROR("--bench-profile needs a profile (--profile <file>)");
+        return 1;
+    }
+    
     // Set default output file
     if (OutputFile.empty())
     {
@@ -111,6 +2352,15 @@ int main(int argc, char* argv[])
         return 1;
     }
     
+    if (FPaths::GetExtension(InputFile) == "sbo")
+    {
+        return RunObjectInput(InputFile, OutputFile, bSaveDecompiled, bRun, bRegisterCode, bVerbose);
+    }
+    if (FPaths::GetExtension(InputFile) == "scc")
+    {
+        return RunCompiledInput(InputFile, bSaveDecompiled, bRun, bRegisterCode, bVerbose);
+    }
+    
     // Load source code
     FString SourceCode;
     if (!FFileHelper::LoadFileToString(SourceCode, InputFile))
@@ -127,10 +2377,11 @@ int main(int argc, char* argv[])
     // Start compilation timer
     auto startTime = std::chrono::high_resolution_clock::now();
     
-    // Lexical analysis
-    LOG_INFO("[1/4] Lexical analysis...");
+    // Lexical analysis and parsing: the parser pulls tokens from the lexer as it needs them
+    LOG_INFO("[1/3] Lexing and parsing...");
     FScriptLexer Lexer(SourceCode);
-    TArray<FScriptToken> Tokens = Lexer.ScanTokens();
+    FScriptParser Parser(Lexer);
+    TSharedPtr<FScriptProgram> Program = Parser.Parse();
     
     if (Lexer.HasErrors())
     {
@@ -142,16 +2393,6 @@ int main(int argc, char* argv[])
         return 1;
     }
     
-    if (bVerbose)
-    {
-        LOG_INFO("  Tokens: " + std::to_string(Tokens.size()));
-    }
-    
-    // Parsing
-    LOG_INFO("[2/4] Parsing...");
-    FScriptParser Parser(Tokens);
-    TSharedPtr<FScriptProgram> Program = Parser.Parse();
-    
     if (!Program.IsValid() || Parser.HasErrors())
     {
         LOG_ERROR("Parser errors:");
@@ -164,12 +2405,47 @@ int main(int argc, char* argv[])
     
     if (bVerbose)
     {
+        LOG_INFO("  Tokens: " + std::to_string(Parser.GetNumTokens()));
         LOG_INFO("  Functions: " + std::to_string(Program->Functions.size()));
     }
     
     // Compilation
-    LOG_INFO("[3/4] Compiling to bytecode...");
+    LOG_INFO("[2/3] Compiling to bytecode...");
+    RegisterStandaloneNatives();
+    // A compile server keeps the headers compiled between requests
+    FScriptModuleCache LocalModules;
+    FScriptModuleCache* WarmModules = GetWarmModuleCache(bInline, bOptimize && !bDiffOptimizer,
+        (bRegisterCode || BackendBenchIterations > 0) && !bDiffOptimizer);
+    FScriptModuleCache& Modules = WarmModules ? *WarmModules : LocalModules;
+    bSeparate = bSeparate || WarmModules != nullptr;
     FScriptCompiler Compiler;
+    if (!ProfileFile.empty())
+    {
+        TSharedPtr<FScriptProfile> Profile = MakeShared<FScriptProfile>();
+        FString ProfileError;
+        if (!Profile->LoadFromFile(ProfileFile, ProfileError))
+        {
+            LOG_ERROR(ProfileError);
+            return 1;
+        }
+        Compiler.SetProfile(Profile);
+    }
+    Compiler.SetInliningEnabled(bInline);
+    Compiler.SetOptimizationEnabled(bOptimize && !bDiffOptimizer);
+    Compiler.SetRegisterCodeEnabled((bRegisterCode || BackendBenchIterations > 0) && !bDiffOptimizer);
+    if (bSeparate)
+    {
+        Modules.SetInliningEnabled(bInline);
+        Modules.SetOptimizationEnabled(bOptimize && !bDiffOptimizer);
+        Modules.SetRegisterCodeEnabled((bRegisterCode || BackendBenchIterations > 0) && !bDiffOptimizer);
+        if (!HeaderCacheDir.empty())
+        {
+            std::error_code DirError;
+            std::filesystem::create_directories(HeaderCacheDir.c_str(), DirError);
+            Modules.SetArtifactDir(HeaderCacheDir);
+        }
+        Compiler.SetModuleCache(&Modules);
+    }
     TSharedPtr<FBytecodeChunk> Bytecode = Compiler.Compile(Program);
     
     if (!Bytecode.IsValid() || Compiler.HasErrors())
@@ -182,6 +2458,35 @@ int main(int argc, char* argv[])
         return 1;
     }
     
+    if (bSeparate)
+    {
+        if (!ObjectDir.empty() && !SaveModuleObjects(*Bytecode, InputFile, Modules, ObjectDir))
+        {
+            return 1;
+        }
+        
+        TArray<FString> LinkErrors;
+        Bytecode = FScriptLinker::Link(*Bytecode, Modules, LinkErrors);
+        if (!Bytecode.IsValid())
+        {
+            LOG_ERROR("Linker errors:");
+            for (const auto& error : LinkErrors)
+            {
+                LOG_ERROR("  " + error);
+            }
+            return 1;
+        }
+        if (bVerbose)
+        {
+            LOG_INFO("  Linked modules: " + std::to_string(Modules.GetModules().Num()));
+        }
+        if (!HeaderCacheDir.empty())
+        {
+            LOG_INFO("Header cache: " + std::to_string(Modules.GetNumLoaded()) + " module(s) loaded, "
+                     + std::to_string(Modules.GetNumCompiled()) + " compiled");
+        }
+    }
+    
     if (bVerbose)
     {
         LOG_INFO("  Bytecode size: " + std::to_string(Bytecode->Code.size()) + " bytes");
@@ -189,43 +2494,13 @@ int main(int argc, char* argv[])
         LOG_INFO("  Functions: " + std::to_string(Bytecode->Functions.size()));
     }
     
-    // Populate metadata for standalone compiler
-    Bytecode->Metadata.CompilerType = ECompilerType::StandaloneCompiler;
-    Bytecode->Metadata.CompilerFlags = EScriptCompilerFlags::TrustedSigned | EScriptCompilerFlags::SecurityVerified;
-    Bytecode->Metadata.CompilerName = "StandaloneCompiler";
-    Bytecode->Metadata.CompilerVersion = "SBS Compiler C 2025 V1.0";
-    Bytecode->Metadata.EngineVersion = FStringPrintf("UE %d.%d", ENGINE_MAJOR_VERSION, ENGINE_MINOR_VERSION);
-    Bytecode->Metadata.GameName = "Sandbox Game";
-    Bytecode->Metadata.GameVersion = "V1.0";
-    Bytecode->Metadata.AuthorName = FPlatformMisc::GetLoginName();
-    
-    #if PLATFORM_WINDOWS
-        Bytecode->Metadata.OperatingSystem = "Windows";
-    #elif PLATFORM_MAC
-        Bytecode->Metadata.OperatingSystem = "Mac";
-    #elif PLATFORM_LINUX
-        Bytecode->Metadata.OperatingSystem = "Linux";
-    #else
-        Bytecode->Metadata.OperatingSystem = "Unknown";
-    #endif
-    
-    Bytecode->Metadata.MachineName = FPlatformMisc::GetMachineName();
-    Bytecode->Metadata.CompilationTime = FDateTime::Now();
-    Bytecode->Metadata.SourceFileName = FPaths::GetCleanFilename(InputFile);
-    Bytecode->Metadata.SourceFileSize = SourceCode.length();
-    Bytecode->Metadata.SourceChecksum = FMD5::HashAnsiString(SourceCode);
-    
-    // Generate signature
-    Bytecode->Signature = Bytecode->GenerateSignature();
+    // Populate metadata for standalone compiler, and sign
+    StampStandaloneMetadata(*Bytecode, InputFile, SourceCode);
     
     // Serialization
-    LOG_INFO("[4/4] Serializing with compression...");
+    LOG_INFO("[3/3] Serializing...");
     TArray<uint8> BytecodeData;
-    if (!Bytecode->Serialize(BytecodeData, true))
-    {
-        LOG_ERROR("Failed to serialize bytecode");
-        return 1;
-    }
+    FScriptBytecodeFile::Write(*Bytecode, BytecodeData);
     
     // Save to file
     if (!FFileHelper::SaveArrayToFile(BytecodeData, OutputFile))
@@ -275,6 +2550,127 @@ int main(int argc, char* argv[])
     LOG_INFO("Ready for distribution to Sandbox Game!");
     LOG_INFO("Place .scc file in Scripts/Compiled/ folder");
     
+    if (bRun)
+    {
+        LOG_INFO("");
+        LOG_INFO("Running script...");
+        GStandaloneVMVerbose = bVerbose;
+        TSharedPtr<FScriptVM> VM = RunBytecode(Bytecode, true, bRegisterCode ? EScriptBackend::Register : EScriptBackend::Stack);
+        if (VM->HasErrors())
+        {
+            LOG_ERROR("Script execution failed");
+            return 1;
+        }
+    }
+    
+    if (!RecordProfileFile.empty())
+    {
+        LOG_INFO("");
+        if (RecordScriptProfile(Bytecode, RecordProfileFile) != 0)
+        {
+            return 1;
+        }
+    }
+    
+    if (ProfileBenchIterations > 0)
+    {
+        LOG_INFO("");
+        if (RunProfileBenchmark(Program, Bytecode, bInline, bOptimize && !bDiffOptimizer, ProfileBenchIterations) != 0)
+        {
+            return 1;
+        }
+    }
+    
+    if (bDiffOptimizer)
+    {
+        LOG_INFO("");
+        if (RunOptimizerDiff(Program, Bytecode, bInline) != 0)
+        {
+            return 1;
+        }
+    }
+    
+    if (InstanceBenchCount > 0)
+    {
+        LOG_INFO("");
+        if (RunInstanceBenchmark(Bytecode, InstanceBenchCount) != 0)
+        {
+            return 1;
+        }
+    }
+    
+    if (DispatchBenchIterations > 0)
+    {
+        LOG_INFO("");
+        if (RunDispatchBenchmark(Bytecode, DispatchBenchIterations) != 0)
+        {
+            return 1;
+        }
+    }
+    
+    if (BackendBenchIterations > 0)
+    {
+        LOG_INFO("");
+        if (RunBackendBenchmark(Bytecode, BackendBenchIterations) != 0)
+        {
+            return 1;
+        }
+    }
+    
+    if (SnapshotBenchIterations > 0)
+    {
+        LOG_INFO("");
+        return RunSnapshotBenchmark(Bytecode, SnapshotBenchIterations);
+    }
+    
     return 0;
 }
 
+int main(int argc, char* argv[])
+{
+    // Server and client modes take over the command line: the client forwards the rest
+    FString SocketPath = GetDefaultServerSocket();
+    bool bServer = false;
+    bool bClient = false;
+    bool bStopServer = false;
+    TArray<FString> Forwarded;
+    for (int i = 1; i < argc; ++i)
+    {
+        FString arg = argv[i];
+        if (arg == "--server")
+        {
+            bServer = true;
+        }
+        else if (arg == "--client")
+        {
+            bClient = true;
+        }
+        else if (arg == "--stop-server")
+        {
+            bStopServer = true;
+        }
+        else if (arg == "--socket" && i + 1 < argc)
+        {
+            SocketPath = argv[++i];
+        }
+        else
+        {
+            Forwarded.Add(arg);
+        }
+    }
+    
+    if (bServer)
+    {
+        RegisterStandaloneNatives();
+        return RunCompileServer(SocketPath);
+    }
+    if (bStopServer)
+    {
+        return StopCompileServer(SocketPath);
+    }
+    if (bClient)
+    {
+        return RunCompileClient(SocketPath, Forwarded);
+    }
+    return RunCompiler(argc, argv);
+}
@@ -0,0 +1,636 @@
+// Standalone Script Compiler - compile server
+
+#include "StandaloneServer.h"
+#include "ScriptLinker.h"
+
+#include <iostream>
+#include <sstream>
+#include <chrono>
+#include <filesystem>
+
+#if !PLATFORM_WINDOWS
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/time.h>
+    #include <sys/un.h>
+    #include <sys/wait.h>
+    #include <signal.h>
+    #include <unistd.h>
+#endif
+
+// Protocol, one line each way per item:
+//   client: "SBS1", the working directory, one argument per line, then an empty line
+//   server: "O <line>" (stdout) and "E <line>" (stderr) as they are printed, then "X <exit code>"
+static const char* SERVER_PROTOCOL = "SBS1";
+static const char* STOP_REQUEST = "--stop-server";
+
+// A client has this long to send its request, and this much to send: one that stalls or
+// never ends its request must not hold up the clients queued behind it
+static const int32 REQUEST_TIMEOUT_SECONDS = 10;
+static const size_t MAX_REQUEST_SIZE = 256 * 1024;
+
+// Modules of one project compiled with one set of options, and the source they were compiled from
+struct FWarmModules
+{
+    TSharedPtr<FScriptModuleCache> Modules;
+    TMap<FString, uint64> SourceHashes;
+};
+
+static bool GServing = false;
+static TMap<FString, FWarmModules> GWarmModules;    // By project directory and options
+static FWarmModules* GRequestModules = nullptr;     // Handed out for the request being served
+
+static uint64 HashFileContents(const FString& FileName)
+{
+    FString Contents;
+    if (!FFileHelper::LoadFileToString(Contents, FileName))
+    {
+        return 0;
+    }
+    uint64 Hash = 14695981039346656037ull;
+    for (const char Char : Contents)
+    {
+        Hash = (Hash ^ static_cast<uint8>(Char)) * 1099511628211ull;
+    }
+    return Hash;
+}
+
+FString GetDefaultServerSocket()
+{
+#if !PLATFORM_WINDOWS
+    // The user's runtime directory is theirs alone already
+    const char* RuntimeDir = getenv("XDG_RUNTIME_DIR");
+    if (RuntimeDir && RuntimeDir[0] == '/')
+    {
+        return FPaths::Combine(FString(RuntimeDir), "ScriptCompiler.sock");
+    }
+#endif
+    // Otherwise a directory of the user's own in the shared temp directory, where anyone
+    // could create (or hold) the socket's name first
+    std::error_code Error;
+    const std::filesystem::path TempDir = std::filesystem::temp_directory_path(Error);
+    const FString Dir = Error ? FString("/tmp") : FString(TempDir.string());
+    return FPaths::Combine(FPaths::Combine(Dir, "ScriptCompiler-" + FPlatformMisc::GetLoginName()), "server.sock");
+}
+
+FScriptModuleCache* GetWarmModuleCache(bool bInline, bool bOptimize, bool bRegisterCode)
+{
+    if (!GServing)
+    {
+        return nullptr;
+    }
+
+    const FString Key = FPaths::ProjectDir() + FStringPrintf("|%d%d%d", bInline ? 1 : 0, bOptimize ? 1 : 0, bRegisterCode ? 1 : 0);
+    FWarmModules& Warm = GWarmModules[Key];
+
+    // A header edited since it was compiled: its importers' modules may have inlined it,
+    // so the project's modules start over
+    bool bStale = !Warm.Modules.IsValid();
+    for (const auto& Pair : Warm.SourceHashes)
+    {
+        if (bStale || HashFileContents(Pair.Key) != Pair.Value)
+        {
+            bStale = true;
+            break;
+        }
+    }
+    if (bStale)
+    {
+        Warm.Modules = MakeShared<FScriptModuleCache>();
+        Warm.Modules->SetInliningEnabled(bInline);
+        Warm.Modules->SetOptimizationEnabled(bOptimize);
+        Warm.Modules->SetRegisterCodeEnabled(bRegisterCode);
+        Warm.SourceHashes.Empty();
+    }
+
+    GRequestModules = &Warm;
+    return Warm.Modules.Get();
+}
+
+#if PLATFORM_WINDOWS
+
+int RunCompileServer(const FString& SocketPath)
+{
+    LOG_ERROR("The compile server needs Unix domain sockets, not available in this build");
+    return 1;
+}
+
+int RunCompileClient(const FString& SocketPath, const TArray<FString>& Args)
+{
+    LOG_ERROR("The compile server needs Unix domain sockets, not available in this build");
+    return 1;
+}
+
+int StopCompileServer(const FString& SocketPath)
+{
+    return RunCompileClient(SocketPath, TArray<FString>());
+}
+
+int RunServerBenchmark(const FString& SelfPath, const FString& InputFile, int32 Iterations)
+{
+    LOG_ERROR("The compile server needs Unix domain sockets, not available in this build");
+    return 1;
+}
+
+#else
+
+static bool SendAll(int Socket, const char* Data, size_t Length)
+{
+    while (Length > 0)
+    {
+        const ssize_t Sent = write(Socket, Data, Length);
+        if (Sent <= 0)
+        {
+            return false;
+        }
+        Data += Sent;
+        Length -= Sent;
+    }
+    return true;
+}
+
+static bool MakeAddress(const FString& SocketPath, sockaddr_un& OutAddress)
+{
+    OutAddress = sockaddr_un();
+    OutAddress.sun_family = AF_UNIX;
+    if (SocketPath.Len() >= (int32)sizeof(OutAddress.sun_path))
+    {
+        LOG_ERROR("Socket path too long: " + SocketPath);
+        return false;
+    }
+    std::memcpy(OutAddress.sun_path, SocketPath.c_str(), SocketPath.Len() + 1);
+    return true;
+}
+
+// The socket's directory must be the user's and closed to everyone else, or another user
+// could put their own socket at the path. The server creates it (0700) when missing
+static bool CheckSocketDirectory(const FString& SocketPath, bool bCreate)
+{
+    const FString Dir = FPaths::GetPath(SocketPath).IsEmpty() ? FString(".") : FPaths::GetPath(SocketPath);
+    if (bCreate)
+    {
+        mkdir(Dir.c_str(), 0700);
+    }
+    struct stat Info;
+    if (lstat(Dir.c_str(), &Info) != 0 || !S_ISDIR(Info.st_mode))
+    {
+        LOG_ERROR("No socket directory " + Dir);
+        return false;
+    }
+    if (Info.st_uid != getuid() || (Info.st_mode & (S_IWGRP | S_IWOTH)) != 0)
+    {
+        LOG_ERROR("Socket directory " + Dir + " must belong to this user and be writable only by them");
+        return false;
+    }
+    return true;
+}
+
+// Only the user who runs the server may talk to it, and only to their own server
+static bool IsSameUserPeer(int Socket)
+{
+#if defined(SO_PEERCRED)
+    ucred Credentials;
+    socklen_t Length = sizeof(Credentials);
+    return getsockopt(Socket, SOL_SOCKET, SO_PEERCRED, &Credentials, &Length) == 0 && Credentials.uid == getuid();
+#else
+    uid_t PeerUser;
+    gid_t PeerGroup;
+    return getpeereid(Socket, &PeerUser, &PeerGroup) == 0 && PeerUser == getuid();
+#endif
+}
+
+static int ConnectToServer(const FString& SocketPath)
+{
+    sockaddr_un Address;
+    if (!MakeAddress(SocketPath, Address))
+    {
+        return -1;
+    }
+    const int Socket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (Socket < 0)
+    {
+        return -1;
+    }
+    if (connect(Socket, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) != 0 || !IsSameUserPeer(Socket))
+    {
+        close(Socket);
+        return -1;
+    }
+    return Socket;
+}
+
+// Sends what a stream prints to the client as tagged lines. Only whole lines go out until
+// Finish: std::cerr flushes after every <<, which must not split a line
+class FClientStreamBuf : public std::streambuf
+{
+public:
+    FClientStreamBuf(int InSocket, char InTag)
+        : Socket(InSocket), Tag(InTag)
+    {}
+
+    void Finish()
+    {
+        if (!Line.empty())
+        {
+            Line.push_back('\n');
+            SendLine();
+        }
+    }
+
+protected:
+    virtual int overflow(int Char) override
+    {
+        if (Char == EOF)
+        {
+            return 0;
+        }
+        Line.push_back(static_cast<char>(Char));
+        if (Char == '\n')
+        {
+            SendLine();
+        }
+        return Char;
+    }
+
+private:
+    void SendLine()
+    {
+        const std::string Tagged = std::string(1, Tag) + " " + Line;
+        SendAll(Socket, Tagged.data(), Tagged.size());
+        Line.clear();
+    }
+
+    int Socket;
+    char Tag;
+    std::string Line;
+};
+
+// One request: the lines up to the empty one. False on a broken connection, and on a
+// request that is too long or too slow in coming (see REQUEST_TIMEOUT_SECONDS)
+static bool ReadRequest(int Socket, TArray<FString>& OutLines)
+{
+    timeval Timeout = {};
+    Timeout.tv_sec = REQUEST_TIMEOUT_SECONDS;
+    if (setsockopt(Socket, SOL_SOCKET, SO_RCVTIMEO, &Timeout, sizeof(Timeout)) != 0)
+    {
+        return false;
+    }
+
+    std::string Data;
+    char Buffer[4096];
+    const auto Deadline = std::chrono::steady_clock::now() + std::chrono::seconds(REQUEST_TIMEOUT_SECONDS);
+    while (Data.size() < 2 || Data.compare(Data.size() - 2, 2, "\n\n") != 0)
+    {
+        // The timeout is per read: a trickle of bytes must still finish in time
+        const ssize_t Received = read(Socket, Buffer, sizeof(Buffer));
+        if (Received <= 0 || Data.size() + Received > MAX_REQUEST_SIZE || std::chrono::steady_clock::now() > Deadline)
+        {
+            return false;
+        }
+        Data.append(Buffer, Received);
+    }
+
+    std::istringstream Lines(Data);
+    std::string Line;
+    while (std::getline(Lines, Line) && !Line.empty())
+    {
+        OutLines.Add(Line);
+    }
+    return true;
+}
+
+int RunCompileServer(const FString& SocketPath)
+{
+    sockaddr_un Address;
+    if (!MakeAddress(SocketPath, Address) || !CheckSocketDirectory(SocketPath, true))
+    {
+        return 1;
+    }
+
+    // A socket file nobody answers on is left over from a server that died
+    const int Existing = ConnectToServer(SocketPath);
+    if (Existing >= 0)
+    {
+        close(Existing);
+        LOG_ERROR("A compile server is already running on " + SocketPath);
+        return 1;
+    }
+    unlink(SocketPath.c_str());
+
+    // Created 0600, so it is never open to others even for a moment
+    const int Listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    const mode_t SavedMask = umask(0077);
+    const bool bBound = Listener >= 0 && bind(Listener, reinterpret_cast<sockaddr*>(&Address), sizeof(Address)) == 0;
+    umask(SavedMask);
+    if (!bBound || chmod(SocketPath.c_str(), 0600) != 0 || listen(Listener, 16) != 0)
+    {
+        LOG_ERROR("Cannot listen on " + SocketPath);
+        if (Listener >= 0)
+        {
+            close(Listener);
+        }
+        return 1;
+    }
+
+    // A client that goes away mid-request must not take the server with it
+    signal(SIGPIPE, SIG_IGN);
+
+    char StartDir[1024];
+    if (!getcwd(StartDir, sizeof(StartDir)))
+    {
+        StartDir[0] = 0;
+    }
+
+    GServing = true;
+    LOG_INFO("Compile server listening on " + SocketPath);
+    int32 NumRequests = 0;
+    for (;;)
+    {
+        const int Socket = accept(Listener, nullptr, nullptr);
+        if (Socket < 0)
+        {
+            continue;
+        }
+        if (!IsSameUserPeer(Socket))
+        {
+            close(Socket);
+            continue;
+        }
+
+        TArray<FString> Lines;
+        if (!ReadRequest(Socket, Lines) || Lines.Num() < 2 || Lines[0] != SERVER_PROTOCOL)
+        {
+            close(Socket);
+            continue;
+        }
+        if (Lines.Num() == 3 && Lines[2] == STOP_REQUEST)
+        {
+            SendAll(Socket, "X 0\n", 4);
+            close(Socket);
+            break;
+        }
+
+        int ExitCode = 1;
+        if (chdir(Lines[1].c_str()) != 0)
+        {
+            const std::string Reply = "E [ERROR] Cannot change to directory " + Lines[1] + "\n";
+            SendAll(Socket, Reply.data(), Reply.size());
+        }
+        else
+        {
+            // argv as main() gets it, with the program name first
+            std::vector<std::string> Args(Lines.begin() + 1, Lines.end());
+            Args[0] = "ScriptCompiler";
+            std::vector<char*> Argv;
+            for (std::string& Arg : Args)
+            {
+                Argv.push_back(&Arg[0]);
+            }
+            Argv.push_back(nullptr);
+
+            FClientStreamBuf Out(Socket, 'O');
+            FClientStreamBuf Err(Socket, 'E');
+            std::streambuf* SavedOut = std::cout.rdbuf(&Out);
+            std::streambuf* SavedErr = std::cerr.rdbuf(&Err);
+            GRequestModules = nullptr;
+            ExitCode = RunCompiler(static_cast<int>(Args.size()), Argv.data());
+            std::cout.flush();
+            std::cerr.flush();
+            Out.Finish();
+            Err.Finish();
+            std::cout.rdbuf(SavedOut);
+            std::cerr.rdbuf(SavedErr);
+
+            // What the modules were compiled from, for the next request to check
+            if (GRequestModules && GRequestModules->Modules.IsValid())
+            {
+                for (const auto& Pair : GRequestModules->Modules->GetModules())
+                {
+                    const FString SourcePath = GRequestModules->Modules->GetSourcePath(Pair.Key);
+                    if (!GRequestModules->SourceHashes.Contains(SourcePath))
+                    {
+                        GRequestModules->SourceHashes.Add(SourcePath, HashFileContents(SourcePath));
+                    }
+                }
+            }
+            if (StartDir[0] && chdir(StartDir) != 0)
+            {
+                StartDir[0] = 0;
+            }
+        }
+
+        const std::string Done = "X " + std::to_string(ExitCode) + "\n";
+        SendAll(Socket, Done.data(), Done.size());
+        close(Socket);
+        NumRequests++;
+    }
+
+    GServing = false;
+    close(Listener);
+    unlink(SocketPath.c_str());
+    LOG_INFO("Compile server stopped after " + std::to_string(NumRequests) + " request(s)");
+    return 0;
+}
+
+static int SendRequest(const FString& SocketPath, const TArray<FString>& Args, bool bQuiet)
+{
+    if (!CheckSocketDirectory(SocketPath, false))
+    {
+        return 1;
+    }
+    const int Socket = ConnectToServer(SocketPath);
+    if (Socket < 0)
+    {
+        if (!bQuiet)
+        {
+            LOG_ERROR("No compile server on " + SocketPath + " (start one with --server)");
+        }
+        return 1;
+    }
+
+    char WorkingDir[1024];
+    if (!getcwd(WorkingDir, sizeof(WorkingDir)))
+    {
+        close(Socket);
+        LOG_ERROR("Cannot read the working directory");
+        return 1;
+    }
+
+    std::string Request = std::string(SERVER_PROTOCOL) + "\n" + WorkingDir + "\n";
+    for (const FString& Arg : Args)
+    {
+        if (!Arg.empty() && Arg.find('\n') == std::string::npos)
+        {
+            Request += Arg + "\n";
+        }
+    }
+    Request += "\n";
+    if (!SendAll(Socket, Request.data(), Request.size()))
+    {
+        close(Socket);
+        LOG_ERROR("Compile server closed the connection");
+        return 1;
+    }
+
+    // Print each line as it arrives, so diagnostics stream in while the server works
+    int ExitCode = -1;
+    std::string Pending;
+    char Buffer[4096];
+    ssize_t Received;
+    while (ExitCode < 0 && (Received = read(Socket, Buffer, sizeof(Buffer))) > 0)
+    {
+        Pending.append(Buffer, Received);
+        size_t End;
+        while ((End = Pending.find('\n')) != std::string::npos)
+        {
+            const std::string Line = Pending.substr(0, End);
+            Pending.erase(0, End + 1);
+            if (Line.size() < 2)
+            {
+                continue;
+            }
+            if (Line[0] == 'O')
+            {
+                std::cout << Line.substr(2) << "\n";
+            }
+            else if (Line[0] == 'E')
+            {
+                std::cerr << Line.substr(2) << "\n";
+            }
+            else if (Line[0] == 'X')
+            {
+                ExitCode = std::atoi(Line.c_str() + 2);
+            }
+        }
+    }
+    close(Socket);
+    std::cout.flush();
+
+    if (ExitCode < 0)
+    {
+        LOG_ERROR("Compile server closed the connection");
+        return 1;
+    }
+    return ExitCode;
+}
+
+int RunCompileClient(const FString& SocketPath, const TArray<FString>& Args)
+{
+    return SendRequest(SocketPath, Args, false);
+}
+
+int StopCompileServer(const FString& SocketPath)
+{
+    TArray<FString> Args;
+    Args.Add(STOP_REQUEST);
+    return SendRequest(SocketPath, Args, false);
+}
+
+int RunServerBenchmark(const FString& SelfPath, const FString& InputFile, int32 Iterations)
+{
+    using FClock = std::chrono::high_resolution_clock;
+    auto MillisSince = [](FClock::time_point Start)
+    {
+        return std::chrono::duration<double, std::milli>(FClock::now() - Start).count();
+    };
+
+    const FString OutputFile = FPaths::Combine(FString(std::filesystem::temp_directory_path().string()), "ScriptCompilerServerBench.scc");
+    const FString SocketPath = GetDefaultServerSocket() + ".bench";
+
+    // Cold: a new process per compile, as a build script or an editor would run it
+    const FString ColdCommand = "\"" + SelfPath + "\" \"" + InputFile + "\" --separate -o \"" + OutputFile + "\" > /dev/null 2>&1";
+    double ColdTotal = 0.0, ColdMin = 1e30;
+    for (int32 i = 0; i < Iterations; ++i)
+    {
+        auto Start = FClock::now();
+        if (std::system(ColdCommand.c_str()) != 0)
+        {
+            LOG_ERROR("Server benchmark: the cold compile failed: " + ColdCommand);
+            return 1;
+        }
+        const double Ms = MillisSince(Start);
+        ColdTotal += Ms;
+        ColdMin = FMath::Min(ColdMin, Ms);
+    }
+
+    // Warm: a server in a child process, then the same compile as requests
+    std::cout.flush();
+    const pid_t Server = fork();
+    if (Server < 0)
+    {
+        LOG_ERROR("Server benchmark: cannot start the server");
+        return 1;
+    }
+    if (Server == 0)
+    {
+        if (!freopen("/dev/null", "w", stdout) || !freopen("/dev/null", "w", stderr))
+        {
+            _exit(1);
+        }
+        _exit(RunCompileServer(SocketPath));
+    }
+
+    int32 Attempts = 0;
+    int Probe;
+    while ((Probe = ConnectToServer(SocketPath)) < 0 && ++Attempts < 200)
+    {
+        usleep(10000);
+    }
+    if (Probe < 0)
+    {
+        LOG_ERROR("Server benchmark: the server did not come up");
+        kill(Server, SIGTERM);
+        waitpid(Server, nullptr, 0);
+        return 1;
+    }
+    close(Probe);
+
+    TArray<FString> Args;
+    Args.Add(InputFile);
+    Args.Add("-o");
+    Args.Add(OutputFile);
+
+    std::ostringstream Discard;
+    std::streambuf* Saved = std::cout.rdbuf(Discard.rdbuf());
+    double FirstMs = 0.0, WarmTotal = 0.0, WarmMin = 1e30;
+    bool bFailed = false;
+    for (int32 i = 0; i <= Iterations && !bFailed; ++i)
+    {
+        auto Start = FClock::now();
+        bFailed = SendRequest(SocketPath, Args, true) != 0;
+        const double Ms = MillisSince(Start);
+        if (i == 0)
+        {
+            FirstMs = Ms;   // Compiles the headers
+            continue;
+        }
+        WarmTotal += Ms;
+        WarmMin = FMath::Min(WarmMin, Ms);
+    }
+    TArray<FString> Stop;
+    Stop.Add(STOP_REQUEST);
+    SendRequest(SocketPath, Stop, true);
+    std::cout.rdbuf(Saved);
+    waitpid(Server, nullptr, 0);
+    std::remove(OutputFile.c_str());
+
+    if (bFailed)
+    {
+        LOG_ERROR("Server benchmark: a compile through the server failed");
+        return 1;
+    }
+
+    const double ColdMean = ColdTotal / Iterations;
+    const double WarmMean = WarmTotal / Iterations;
+    std::cout << "[BENCH] Compiles:              " << Iterations << " of " << InputFile << " each way" << std::endl;
+    std::cout << "[BENCH] Cold (new process):    " << ColdMean << " ms mean, " << ColdMin << " ms min" << std::endl;
+    std::cout << "[BENCH] Server, first request: " << FirstMs << " ms" << std::endl;
+    std::cout << "[BENCH] Server, warm:          " << WarmMean << " ms mean, " << WarmMin << " ms min" << std::endl;
+    if (WarmMean > 0.0)
+    {
+        std::cout << "[BENCH] Speedup:               " << ColdMean / WarmMean << "x" << std::endl;
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,44 @@
+// Standalone Script Compiler - compile server
+// Keeps one compiler process warm for many compiles, see RunCompileServer
+
+#pragma once
+
+#include "Platform.h"
+
+class FScriptModuleCache;
+
+/** One compiler invocation, as from the command line (argv[0] is the program) - StandaloneMain.cpp */
+int RunCompiler(int argc, char* argv[]);
+
+/** Socket the server listens on unless told otherwise: one per user, in $XDG_RUNTIME_DIR or a private directory in the temp directory */
+FString GetDefaultServerSocket();
+
+/**
+ * Serve compile requests on a local (Unix domain) socket until a client stops it.
+ *
+ * Each request is a command line run as RunCompiler would run it, in the client's working
+ * directory, with what it prints sent back line by line as it is printed. Between
+ * requests the server keeps what a cold start rebuilds: the native registry, and the
+ * imported headers, parsed and compiled as modules (requests are compiled with
+ * --separate). A header edited since it was compiled drops the modules of its project.
+ *
+ * Requests are served one at a time. Only the user running the server is served; the
+ * socket's directory must belong to them and be writable by no one else.
+ */
+int RunCompileServer(const FString& SocketPath);
+
+/** Forward a command line to the server and print what comes back. Returns the compile's exit code */
+int RunCompileClient(const FString& SocketPath, const TArray<FString>& Args);
+
+/** Ask the server to exit */
+int StopCompileServer(const FString& SocketPath);
+
+/** While serving: the warm module cache for the current project and these options, otherwise nullptr */
+FScriptModuleCache* GetWarmModuleCache(bool bInline, bool bOptimize, bool bRegisterCode);
+
+/**
+ * Compile InputFile Iterations times as separate processes (cold) and through a compile
+ * server (warm), and compare the latency per compile
+ * @param SelfPath This executable, for the cold runs and the server
+ */
+int RunServerBenchmark(const FString& SelfPath, const FString& InputFile, int32 Iterations);